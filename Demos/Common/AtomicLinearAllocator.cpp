@@ -0,0 +1,106 @@
+//
+// AtomicLinearAllocator.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "AtomicLinearAllocator.hpp"
+
+#include <cassert>
+
+
+//---------------------------------------------------------------------------------------
+static size_t alignOffset (
+	size_t offset,
+	size_t alignment
+) {
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	return (offset + (alignment - 1)) & ~(alignment - 1);
+}
+
+//---------------------------------------------------------------------------------------
+// Hands out generations shared by every allocator in the process, starting after the
+// generation of a default constructed Chunk.
+static uint64 nextGeneration()
+{
+	static std::atomic<uint64> s_generation(0);
+	return s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+//---------------------------------------------------------------------------------------
+AtomicLinearAllocator::AtomicLinearAllocator (
+	size_t capacityInBytes
+)
+	: m_capacity(capacityInBytes),
+	  m_offset(0),
+	  m_generation(nextGeneration())
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+size_t AtomicLinearAllocator::allocate (
+	size_t sizeInBytes,
+	size_t alignment
+) {
+	// Reserve enough bytes to align the allocation wherever the offset happens to be,
+	// so that a single fetch-add is all that is needed.
+	const size_t paddedSize = sizeInBytes + (alignment - 1);
+
+	const size_t begin = m_offset.fetch_add(paddedSize, std::memory_order_relaxed);
+	if (begin + paddedSize > m_capacity) {
+		return InvalidOffset;
+	}
+
+	return alignOffset(begin, alignment);
+}
+
+//---------------------------------------------------------------------------------------
+size_t AtomicLinearAllocator::allocate (
+	Chunk & chunk,
+	size_t chunkSize,
+	size_t sizeInBytes,
+	size_t alignment
+) {
+	if (chunk.generation != m_generation) {
+		// Filled by another allocator, or before a reset.
+		chunk = Chunk();
+		chunk.generation = m_generation;
+	}
+
+	size_t offset = alignOffset(chunk.cur, alignment);
+	if (chunk.end != 0 && offset + sizeInBytes <= chunk.end) {
+		chunk.cur = offset + sizeInBytes;
+		return offset;
+	}
+
+	if (sizeInBytes * 2 > chunkSize) {
+		return allocate(sizeInBytes, alignment);
+	}
+
+	// Chunk exhausted, refill it.  Chunk start keeps the request's alignment so the
+	// first allocation never needs padding.
+	const size_t chunkBegin = allocate(chunkSize, alignment);
+	if (chunkBegin == InvalidOffset) {
+		return InvalidOffset;
+	}
+	chunk.cur = chunkBegin + sizeInBytes;
+	chunk.end = chunkBegin + chunkSize;
+
+	return chunkBegin;
+}
+
+//---------------------------------------------------------------------------------------
+void AtomicLinearAllocator::reset()
+{
+	m_offset.store(0, std::memory_order_relaxed);
+	m_generation = nextGeneration();
+}
+
+//---------------------------------------------------------------------------------------
+size_t AtomicLinearAllocator::usedBytes() const
+{
+	const size_t offset = m_offset.load(std::memory_order_relaxed);
+
+	// Failed allocations can push the offset past the end.
+	return offset < m_capacity ? offset : m_capacity;
+}
@@ -0,0 +1,77 @@
+//
+// AtomicLinearAllocator.hpp
+//
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+
+/**
+* Lock-free linear allocator over a fixed range of byte offsets.  Any number of
+* threads may call allocate() concurrently; each call is a single atomic fetch-add.
+*
+* To keep contention on the shared offset low, threads can sub-allocate through a
+* Chunk, which grabs a larger block from the allocator and then serves small
+* requests from it without touching any shared state.  A Chunk remembers which
+* allocator, and which generation of it, filled it, so a long-lived Chunk such as a
+* thread_local one is refilled rather than reused once the allocator is reset or
+* destroyed.
+*/
+class AtomicLinearAllocator {
+public:
+	/// Returned when the allocator has run out of space.
+	static const size_t InvalidOffset = ~size_t(0);
+
+	/// Per-thread block of space carved out of the allocator.
+	struct Chunk {
+		size_t cur = 0;
+		size_t end = 0;
+
+		// generation() of the allocator when the chunk was filled.
+		uint64 generation = 0;
+	};
+
+	explicit AtomicLinearAllocator (
+		size_t capacityInBytes
+	);
+
+	/// Thread-safe.  Allocates 'sizeInBytes' aligned to 'alignment' (power of 2).
+	/// @return byte offset of allocation, or InvalidOffset if out of space.
+	size_t allocate (
+		size_t sizeInBytes,
+		size_t alignment
+	);
+
+	/// Thread-safe as long as each Chunk is only used by one thread.  Serves the
+	/// request from 'chunk', refilling it with 'chunkSize' bytes when exhausted.
+	/// Requests larger than half a chunk bypass the chunk.
+	size_t allocate (
+		Chunk & chunk,
+		size_t chunkSize,
+		size_t sizeInBytes,
+		size_t alignment
+	);
+
+	/// Frees all allocations.  Must not be called concurrently with allocate().
+	/// Chunks filled before the reset are refilled on their next use.
+	void reset();
+
+	size_t capacity() const { return m_capacity; }
+
+	/// Identifies the allocator and the number of resets it has had, unique within
+	/// the process, so that it never matches a Chunk filled by another allocator that
+	/// happened to live at the same address.
+	uint64 generation() const { return m_generation; }
+
+	/// Bytes handed out so far, including alignment padding and unused chunk space.
+	size_t usedBytes() const;
+
+private:
+	size_t m_capacity;
+
+	std::atomic<size_t> m_offset;
+
+	uint64 m_generation;
+};
@@ -0,0 +1,740 @@
+//
+// BlockCompression.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include "JobSystem.hpp"
+
+
+namespace {
+
+	const uint NumBlockPixels = 16;
+
+	// Least squares refinements tried after the principal axis fit.
+	const uint NumRefinements = 2;
+
+	// Power iterations finding the principal axis of a block's colors.
+	const uint NumPowerIterations = 8;
+
+	// Blocks encoded per job, rounded to whole rows of blocks.
+	const uint BlocksPerJob = 512;
+
+	// BC7 interpolation weights for 4-bit indices, out of 64.
+	const int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	/// Pixels of one block as floats, only the first 'numChannels' of which are fitted.
+	struct BlockPixels {
+		float values[NumBlockPixels][4];
+	};
+
+	/// Accumulates a block's bits, least significant first.
+	class BitWriter {
+	public:
+		BitWriter()
+			: m_position(0)
+		{
+			m_words[0] = 0;
+			m_words[1] = 0;
+		}
+
+		void write (
+			uint64 value,
+			uint numBits
+		) {
+			assert(m_position + numBits <= 128);
+			for (uint i = 0; i < numBits; ++i, ++m_position) {
+				m_words[m_position / 64] |= ((value >> i) & 1) << (m_position % 64);
+			}
+		}
+
+		void store (
+			byte * dst
+		) const {
+			for (uint i = 0; i < 16; ++i) {
+				dst[i] = byte(m_words[i / 8] >> ((i % 8) * 8));
+			}
+		}
+
+	private:
+		uint64 m_words[2];
+		uint m_position;
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static inline float squaredDistance (
+	const float * a,
+	const float * b,
+	uint numChannels
+) {
+	float sum = 0.0f;
+	for (uint c = 0; c < numChannels; ++c) {
+		sum += (a[c] - b[c]) * (a[c] - b[c]);
+	}
+	return sum;
+}
+
+//---------------------------------------------------------------------------------------
+// Reads the 4x4 block at block coordinates (blockX, blockY), repeating the last row
+// and column past the image edge.
+static void loadBlock (
+	const ImageView & source,
+	uint blockX,
+	uint blockY,
+	byte rgba[NumBlockPixels][4]
+) {
+	for (uint y = 0; y < 4; ++y) {
+		const uint sourceY = std::min(blockY * 4 + y, source.height - 1);
+		const byte * row = source.data + sourceY * source.rowPitch;
+		for (uint x = 0; x < 4; ++x) {
+			const uint sourceX = std::min(blockX * 4 + x, source.width - 1);
+			memcpy(rgba[y * 4 + x], row + sourceX * 4, 4);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Initial endpoints: the extent of the pixels flagged in 'isFitted' along their
+// principal axis.
+static void fitPrincipalAxis (
+	const BlockPixels & pixels,
+	const bool * isFitted,
+	uint numChannels,
+	float e0[4],
+	float e1[4]
+) {
+	float mean[4] = {};
+	uint count = 0;
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		if (isFitted[i]) {
+			for (uint c = 0; c < numChannels; ++c) {
+				mean[c] += pixels.values[i][c];
+			}
+			++count;
+		}
+	}
+	for (uint c = 0; c < numChannels; ++c) {
+		mean[c] /= float(count);
+	}
+
+	float covariance[4][4] = {};
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		if (!isFitted[i]) {
+			continue;
+		}
+		float d[4];
+		for (uint c = 0; c < numChannels; ++c) {
+			d[c] = pixels.values[i][c] - mean[c];
+		}
+		for (uint r = 0; r < numChannels; ++r) {
+			for (uint c = 0; c < numChannels; ++c) {
+				covariance[r][c] += d[r] * d[c];
+			}
+		}
+	}
+
+	// Power iteration, starting from the channel with the largest variance.
+	float axis[4] = {};
+	uint largest = 0;
+	for (uint c = 1; c < numChannels; ++c) {
+		if (covariance[c][c] > covariance[largest][largest]) {
+			largest = c;
+		}
+	}
+	for (uint c = 0; c < numChannels; ++c) {
+		axis[c] = covariance[largest][c];
+	}
+	for (uint iteration = 0; iteration < NumPowerIterations; ++iteration) {
+		float next[4] = {};
+		float length = 0.0f;
+		for (uint r = 0; r < numChannels; ++r) {
+			for (uint c = 0; c < numChannels; ++c) {
+				next[r] += covariance[r][c] * axis[c];
+			}
+			length = std::max(length, std::fabs(next[r]));
+		}
+		if (length == 0.0f) {
+			break;
+		}
+		for (uint c = 0; c < numChannels; ++c) {
+			axis[c] = next[c] / length;
+		}
+	}
+
+	float axisLengthSquared = 0.0f;
+	for (uint c = 0; c < numChannels; ++c) {
+		axisLengthSquared += axis[c] * axis[c];
+	}
+
+	float minT = 0.0f;
+	float maxT = 0.0f;
+	if (axisLengthSquared > 0.0f) {
+		minT = FLT_MAX;
+		maxT = -FLT_MAX;
+		for (uint i = 0; i < NumBlockPixels; ++i) {
+			if (!isFitted[i]) {
+				continue;
+			}
+			float t = 0.0f;
+			for (uint c = 0; c < numChannels; ++c) {
+				t += (pixels.values[i][c] - mean[c]) * axis[c];
+			}
+			t /= axisLengthSquared;
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+	}
+
+	for (uint c = 0; c < numChannels; ++c) {
+		e0[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+		e1[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Endpoints minimizing the squared error of the fitted pixels, given each pixel's
+// position 't' between e0 (0) and e1 (1).
+// @return false if the positions do not determine two endpoints.
+static bool fitLeastSquares (
+	const BlockPixels & pixels,
+	const bool * isFitted,
+	const float * t,
+	uint numChannels,
+	float e0[4],
+	float e1[4]
+) {
+	float a = 0.0f;
+	float b = 0.0f;
+	float c = 0.0f;
+	float rhs0[4] = {};
+	float rhs1[4] = {};
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		if (!isFitted[i]) {
+			continue;
+		}
+		const float s = 1.0f - t[i];
+		a += s * s;
+		b += s * t[i];
+		c += t[i] * t[i];
+		for (uint ch = 0; ch < numChannels; ++ch) {
+			rhs0[ch] += s * pixels.values[i][ch];
+			rhs1[ch] += t[i] * pixels.values[i][ch];
+		}
+	}
+
+	const float determinant = a * c - b * b;
+	if (std::fabs(determinant) < 1e-6f) {
+		return false;
+	}
+
+	const float inverse = 1.0f / determinant;
+	for (uint ch = 0; ch < numChannels; ++ch) {
+		e0[ch] = std::min(std::max((c * rhs0[ch] - b * rhs1[ch]) * inverse, 0.0f), 255.0f);
+		e1[ch] = std::min(std::max((a * rhs1[ch] - b * rhs0[ch]) * inverse, 0.0f), 255.0f);
+	}
+	return true;
+}
+
+
+
+//---------------------------------------------------------------------------------------
+// BC1 color block
+//---------------------------------------------------------------------------------------
+namespace {
+
+	struct Bc1Block {
+		uint16 color0;
+		uint16 color1;
+		uint32 indices;
+		float error;
+		float t[NumBlockPixels];
+	};
+}
+
+//---------------------------------------------------------------------------------------
+// Closest 'numBits' value to the 8-bit 'value', comparing expanded values as the
+// decoder produces them.
+static inline uint quantizeChannel (
+	float value,
+	uint numBits
+) {
+	const uint maxValue = (1u << numBits) - 1;
+	const int guess = int(value * maxValue / 255.0f + 0.5f);
+
+	uint best = 0;
+	float bestError = FLT_MAX;
+	for (int q = std::max(guess - 1, 0); q <= std::min(guess + 1, int(maxValue)); ++q) {
+		const uint expanded = (uint(q) << (8 - numBits)) | (uint(q) >> (2 * numBits - 8));
+		const float error = std::fabs(float(expanded) - value);
+		if (error < bestError) {
+			bestError = error;
+			best = uint(q);
+		}
+	}
+	return best;
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint16 quantizeRgb565 (
+	const float * rgb
+) {
+	return uint16 (
+		(quantizeChannel(rgb[0], 5) << 11) | (quantizeChannel(rgb[1], 6) << 5) |
+		quantizeChannel(rgb[2], 5)
+	);
+}
+
+//---------------------------------------------------------------------------------------
+static inline void expandRgb565 (
+	uint16 color,
+	float * rgb
+) {
+	const uint r = (color >> 11) & 31;
+	const uint g = (color >> 5) & 63;
+	const uint b = color & 31;
+	rgb[0] = float((r << 3) | (r >> 2));
+	rgb[1] = float((g << 2) | (g >> 4));
+	rgb[2] = float((b << 3) | (b >> 2));
+}
+
+//---------------------------------------------------------------------------------------
+// Quantizes endpoints e0 and e1, orders them for the 4 or 3 color mode, and picks the
+// closest palette entry for each pixel.  Pixels not in 'isOpaque' take the
+// transparent index of the 3 color mode.
+static void evaluateBc1 (
+	const BlockPixels & pixels,
+	const bool * isOpaque,
+	bool isThreeColor,
+	const float e0[4],
+	const float e1[4],
+	Bc1Block & block
+) {
+	uint16 color0 = quantizeRgb565(e0);
+	uint16 color1 = quantizeRgb565(e1);
+
+	// color0 > color1 selects the 4 color mode.
+	if ((color0 < color1) != isThreeColor && color0 != color1) {
+		std::swap(color0, color1);
+	}
+	block.color0 = color0;
+	block.color1 = color1;
+
+	float palette[4][4];
+	expandRgb565(color0, palette[0]);
+	expandRgb565(color1, palette[1]);
+	float paletteT[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+	uint numColors = 3;
+	if (isThreeColor || color0 == color1) {
+		for (uint c = 0; c < 3; ++c) {
+			palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+		}
+	} else {
+		for (uint c = 0; c < 3; ++c) {
+			palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+			palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+		}
+		paletteT[2] = 1.0f / 3.0f;
+		paletteT[3] = 2.0f / 3.0f;
+		numColors = 4;
+	}
+
+	block.indices = 0;
+	block.error = 0.0f;
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		uint index = 3;
+		if (isOpaque[i]) {
+			float bestError = FLT_MAX;
+			for (uint p = 0; p < numColors; ++p) {
+				const float error = squaredDistance(pixels.values[i], palette[p], 3);
+				if (error < bestError) {
+					bestError = error;
+					index = p;
+				}
+			}
+			block.error += bestError;
+			block.t[i] = paletteT[index];
+		}
+		block.indices |= uint32(index) << (i * 2);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Encodes the color of a block.  With 'hasPunchThrough', pixels below half alpha are
+// encoded as transparent, as BC1 allows.
+static void encodeBc1 (
+	const byte rgba[NumBlockPixels][4],
+	bool hasPunchThrough,
+	byte * dst
+) {
+	BlockPixels pixels;
+	bool isOpaque[NumBlockPixels];
+	bool hasTransparency = false;
+	bool hasOpaque = false;
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		for (uint c = 0; c < 4; ++c) {
+			pixels.values[i][c] = float(rgba[i][c]);
+		}
+		isOpaque[i] = !hasPunchThrough || rgba[i][3] >= 128;
+		hasTransparency |= !isOpaque[i];
+		hasOpaque |= isOpaque[i];
+	}
+
+	Bc1Block best;
+	if (!hasOpaque) {
+		best.color0 = 0;
+		best.color1 = 0;
+		best.indices = 0xFFFFFFFF;
+	} else {
+		float e0[4];
+		float e1[4];
+		fitPrincipalAxis(pixels, isOpaque, 3, e0, e1);
+		evaluateBc1(pixels, isOpaque, hasTransparency, e0, e1, best);
+
+		for (uint iteration = 0; iteration < NumRefinements && best.error > 0.0f; ++iteration) {
+			if (!fitLeastSquares(pixels, isOpaque, best.t, 3, e0, e1)) {
+				break;
+			}
+			Bc1Block refined;
+			evaluateBc1(pixels, isOpaque, hasTransparency, e0, e1, refined);
+			if (refined.error >= best.error) {
+				break;
+			}
+			best = refined;
+		}
+	}
+
+	dst[0] = byte(best.color0);
+	dst[1] = byte(best.color0 >> 8);
+	dst[2] = byte(best.color1);
+	dst[3] = byte(best.color1 >> 8);
+	for (uint i = 0; i < 4; ++i) {
+		dst[4 + i] = byte(best.indices >> (i * 8));
+	}
+}
+
+
+
+//---------------------------------------------------------------------------------------
+// BC3 alpha block
+//---------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------------------
+// Picks the closest of the 8 palette entries for each alpha value.
+// @return squared error.
+static uint evaluateAlpha (
+	const byte alpha[NumBlockPixels],
+	const int palette[8],
+	uint64 & indices
+) {
+	uint totalError = 0;
+	indices = 0;
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		uint bestIndex = 0;
+		int bestError = INT_MAX;
+		for (uint p = 0; p < 8; ++p) {
+			const int error = (alpha[i] - palette[p]) * (alpha[i] - palette[p]);
+			if (error < bestError) {
+				bestError = error;
+				bestIndex = p;
+			}
+		}
+		totalError += uint(bestError);
+		indices |= uint64(bestIndex) << (i * 3);
+	}
+	return totalError;
+}
+
+//---------------------------------------------------------------------------------------
+// Encodes alpha with the 8 value mode spanning the block's range, or the 6 value mode
+// with explicit 0 and 255 when that fits better.
+static void encodeAlpha (
+	const byte rgba[NumBlockPixels][4],
+	byte * dst
+) {
+	byte alpha[NumBlockPixels];
+	int minAlpha = 255;
+	int maxAlpha = 0;
+	int minInner = 255;
+	int maxInner = 0;
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		alpha[i] = rgba[i][3];
+		minAlpha = std::min(minAlpha, int(alpha[i]));
+		maxAlpha = std::max(maxAlpha, int(alpha[i]));
+		if (alpha[i] != 0 && alpha[i] != 255) {
+			minInner = std::min(minInner, int(alpha[i]));
+			maxInner = std::max(maxInner, int(alpha[i]));
+		}
+	}
+
+	// alpha0 > alpha1 selects 6 interpolated values.
+	int palette[8];
+	palette[0] = maxAlpha;
+	palette[1] = minAlpha;
+	for (int i = 1; i < 7; ++i) {
+		palette[i + 1] = ((7 - i) * maxAlpha + i * minAlpha) / 7;
+	}
+	uint64 indices;
+	uint error = evaluateAlpha(alpha, palette, indices);
+	int alpha0 = maxAlpha;
+	int alpha1 = minAlpha;
+
+	// alpha0 <= alpha1 selects 4 interpolated values plus 0 and 255.
+	if (error > 0 && minInner <= maxInner) {
+		int innerPalette[8];
+		innerPalette[0] = minInner;
+		innerPalette[1] = maxInner;
+		for (int i = 1; i < 5; ++i) {
+			innerPalette[i + 1] = ((5 - i) * minInner + i * maxInner) / 5;
+		}
+		innerPalette[6] = 0;
+		innerPalette[7] = 255;
+
+		uint64 innerIndices;
+		const uint innerError = evaluateAlpha(alpha, innerPalette, innerIndices);
+		if (innerError < error) {
+			error = innerError;
+			indices = innerIndices;
+			alpha0 = minInner;
+			alpha1 = maxInner;
+		}
+	}
+
+	dst[0] = byte(alpha0);
+	dst[1] = byte(alpha1);
+	for (uint i = 0; i < 6; ++i) {
+		dst[2 + i] = byte(indices >> (i * 8));
+	}
+}
+
+
+
+//---------------------------------------------------------------------------------------
+// BC7 mode 6 block
+//---------------------------------------------------------------------------------------
+namespace {
+
+	struct Bc7Block {
+		int endpoints[2][4];
+		uint pBits[2];
+		byte indices[NumBlockPixels];
+		float error;
+		float t[NumBlockPixels];
+	};
+}
+
+//---------------------------------------------------------------------------------------
+// Quantizes an endpoint to 7 bits per channel plus a shared p-bit, as an 8-bit value.
+static void quantizeBc7Endpoint (
+	const float value[4],
+	int endpoint[4],
+	uint & pBit
+) {
+	float bestError = FLT_MAX;
+	for (uint p = 0; p < 2; ++p) {
+		int candidate[4];
+		float error = 0.0f;
+		for (uint c = 0; c < 4; ++c) {
+			const int q = std::min(std::max(int((value[c] - p) / 2.0f + 0.5f), 0), 127);
+			candidate[c] = q * 2 + int(p);
+			error += (candidate[c] - value[c]) * (candidate[c] - value[c]);
+		}
+		if (error < bestError) {
+			bestError = error;
+			pBit = p;
+			memcpy(endpoint, candidate, sizeof(candidate));
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static void evaluateBc7 (
+	const BlockPixels & pixels,
+	const float e0[4],
+	const float e1[4],
+	Bc7Block & block
+) {
+	quantizeBc7Endpoint(e0, block.endpoints[0], block.pBits[0]);
+	quantizeBc7Endpoint(e1, block.endpoints[1], block.pBits[1]);
+
+	float palette[16][4];
+	float direction[4];
+	float directionLengthSquared = 0.0f;
+	for (uint c = 0; c < 4; ++c) {
+		for (uint i = 0; i < 16; ++i) {
+			palette[i][c] = float (
+				((64 - Bc7Weights[i]) * block.endpoints[0][c] +
+				Bc7Weights[i] * block.endpoints[1][c] + 32) >> 6
+			);
+		}
+		direction[c] = float(block.endpoints[1][c] - block.endpoints[0][c]);
+		directionLengthSquared += direction[c] * direction[c];
+	}
+
+	// The palette lies on the line between the endpoints, so the projection of each
+	// pixel selects a candidate, refined against its neighbors to absorb rounding.
+	block.error = 0.0f;
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		int guess = 0;
+		if (directionLengthSquared > 0.0f) {
+			float t = 0.0f;
+			for (uint c = 0; c < 4; ++c) {
+				t += (pixels.values[i][c] - float(block.endpoints[0][c])) * direction[c];
+			}
+			t = std::min(std::max(t / directionLengthSquared, 0.0f), 1.0f);
+			guess = int(t * 15.0f + 0.5f);
+		}
+
+		uint bestIndex = 0;
+		float bestError = FLT_MAX;
+		for (int index = std::max(guess - 1, 0); index <= std::min(guess + 1, 15); ++index) {
+			const float error = squaredDistance(pixels.values[i], palette[index], 4);
+			if (error < bestError) {
+				bestError = error;
+				bestIndex = uint(index);
+			}
+		}
+		block.indices[i] = byte(bestIndex);
+		block.t[i] = Bc7Weights[bestIndex] / 64.0f;
+		block.error += bestError;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static void encodeBc7 (
+	const byte rgba[NumBlockPixels][4],
+	byte * dst
+) {
+	BlockPixels pixels;
+	bool isFitted[NumBlockPixels];
+	for (uint i = 0; i < NumBlockPixels; ++i) {
+		for (uint c = 0; c < 4; ++c) {
+			pixels.values[i][c] = float(rgba[i][c]);
+		}
+		isFitted[i] = true;
+	}
+
+	float e0[4];
+	float e1[4];
+	fitPrincipalAxis(pixels, isFitted, 4, e0, e1);
+
+	Bc7Block best;
+	evaluateBc7(pixels, e0, e1, best);
+	for (uint iteration = 0; iteration < NumRefinements && best.error > 0.0f; ++iteration) {
+		if (!fitLeastSquares(pixels, isFitted, best.t, 4, e0, e1)) {
+			break;
+		}
+		Bc7Block refined;
+		evaluateBc7(pixels, e0, e1, refined);
+		if (refined.error >= best.error) {
+			break;
+		}
+		best = refined;
+	}
+
+	// The first index is stored without its top bit, which must be 0.
+	if (best.indices[0] >= 8) {
+		std::swap(best.endpoints[0], best.endpoints[1]);
+		std::swap(best.pBits[0], best.pBits[1]);
+		for (uint i = 0; i < NumBlockPixels; ++i) {
+			best.indices[i] = byte(15 - best.indices[i]);
+		}
+	}
+
+	BitWriter bits;
+	bits.write(1 << 6, 7);
+	for (uint c = 0; c < 4; ++c) {
+		bits.write(uint64(best.endpoints[0][c] >> 1), 7);
+		bits.write(uint64(best.endpoints[1][c] >> 1), 7);
+	}
+	bits.write(best.pBits[0], 1);
+	bits.write(best.pBits[1], 1);
+	bits.write(best.indices[0], 3);
+	for (uint i = 1; i < NumBlockPixels; ++i) {
+		bits.write(best.indices[i], 4);
+	}
+	bits.store(dst);
+}
+
+
+
+//---------------------------------------------------------------------------------------
+// Encodes rows of blocks [firstRow, endRow).
+static void compressRows (
+	const ImageView & source,
+	BlockCompression::Format format,
+	const ImageDestination & destination,
+	uint firstRow,
+	uint endRow
+) {
+	const uint numBlocksX = BlockCompression::numBlocks(source.width);
+	const uint blockBytes = BlockCompression::blockBytes(format);
+
+	byte rgba[NumBlockPixels][4];
+	byte block[16];
+	for (uint blockY = firstRow; blockY < endRow; ++blockY) {
+		byte * dstRow = destination.data + blockY * destination.rowPitch;
+		for (uint blockX = 0; blockX < numBlocksX; ++blockX) {
+			loadBlock(source, blockX, blockY, rgba);
+
+			switch (format) {
+				case BlockCompression::Format::BC1:
+					encodeBc1(rgba, true, block);
+					break;
+				case BlockCompression::Format::BC3:
+					encodeAlpha(rgba, block);
+					encodeBc1(rgba, false, block + 8);
+					break;
+				case BlockCompression::Format::BC7:
+					encodeBc7(rgba, block);
+					break;
+			}
+			memcpy(dstRow + blockX * blockBytes, block, blockBytes);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+uint BlockCompression::blockBytes (
+	Format format
+) {
+	return format == Format::BC1 ? 8 : 16;
+}
+
+//---------------------------------------------------------------------------------------
+void BlockCompression::compress (
+	const ImageView & source,
+	Format format,
+	const ImageDestination & destination,
+	JobSystem * jobSystem
+) {
+	const uint numBlocksX = numBlocks(source.width);
+	const uint numBlocksY = numBlocks(source.height);
+	assert(source.data && destination.data);
+	assert(destination.rowPitch >= size_t(numBlocksX) * blockBytes(format));
+	assert(destination.size >= destination.rowPitch * (numBlocksY - 1) +
+		size_t(numBlocksX) * blockBytes(format));
+
+	const uint rowsPerJob = std::max(BlocksPerJob / numBlocksX, 1u);
+	if (!jobSystem || numBlocksY <= rowsPerJob) {
+		compressRows(source, format, destination, 0, numBlocksY);
+		return;
+	}
+
+	JobSystem::Handle handle;
+	for (uint firstRow = 0; firstRow < numBlocksY; firstRow += rowsPerJob) {
+		const uint endRow = std::min(firstRow + rowsPerJob, numBlocksY);
+		jobSystem->submit([&, firstRow, endRow]() {
+			compressRows(source, format, destination, firstRow, endRow);
+		}, handle);
+	}
+	jobSystem->wait(handle);
+}
@@ -0,0 +1,65 @@
+//
+// BlockCompression.hpp
+//
+#pragma once
+
+#include "Common/BasicTypes.hpp"
+#include "Common/ImageTypes.hpp"
+
+class JobSystem;
+
+
+/**
+* Encoders for the BC1, BC3 and BC7 block compressed texture formats, turning 8-bit
+* RGBA images into 4x4 pixel blocks.
+*
+* - BC1 (8 bytes per block, 8:1): RGB565 endpoints with 2-bit indices.  Blocks with
+*   pixels below half alpha use the 3 color mode, where those pixels become
+*   transparent black.
+* - BC3 (16 bytes per block, 4:1): a BC1 color block plus interpolated 8-bit alpha
+*   endpoints with 3-bit indices.
+* - BC7 (16 bytes per block, 4:1): mode 6 only, one RGBA line per block with 7-bit
+*   endpoints, per-endpoint p-bits and 4-bit indices.  It is the best quality
+*   single-subset mode, but has no partitions, so blocks with several distinct colors
+*   are approximated on a single line.
+*
+* Endpoints are fitted along the principal axis of the block's colors, then refined
+* by least squares on the selected indices, keeping the lowest error fit.  Error is
+* measured on the stored values, so sRGB textures are fitted in sRGB space.
+*
+* Rows of blocks are encoded in parallel as JobSystem jobs.  Edge blocks of images
+* that are not a multiple of 4 pixels repeat the last row and column.
+*
+* Has no Windows dependencies.
+*/
+namespace BlockCompression {
+
+	enum class Format {
+		BC1,
+		BC3,
+		BC7
+	};
+
+	/// Bytes per 4x4 block.
+	uint blockBytes (
+		Format format
+	);
+
+	/// Blocks covering 'size' pixels.
+	inline uint numBlocks (
+		uint size
+	) {
+		return (size + 3) / 4;
+	}
+
+	/// Encodes 'source' into 'destination', where row of blocks y starts at
+	/// destination.data + y * destination.rowPitch.  The destination is only written.
+	/// @param jobSystem - encodes rows of blocks in parallel, nullptr encodes them on
+	/// the calling thread.
+	void compress (
+		const ImageView & source,
+		Format format,
+		const ImageDestination & destination,
+		JobSystem * jobSystem
+	);
+};
@@ -0,0 +1,69 @@
+//
+// CommandListPool.cpp
+//
+#include "pch.h"
+
+#include "CommandListPool.hpp"
+
+
+//---------------------------------------------------------------------------------------
+CommandListPool::CommandListPool (
+	ID3D12Device * device
+)
+	: m_device(device),
+	  m_releasedLists(NumTypes)
+{
+	assert(device);
+}
+
+//---------------------------------------------------------------------------------------
+CommandListPool::CommandList CommandListPool::acquire (
+	D3D12_COMMAND_LIST_TYPE type
+) {
+	assert(uint(type) < NumTypes);
+
+	CommandList commandList;
+	if (m_releasedLists.tryAcquire(uint(type), commandList)) {
+		CHECK_D3D_RESULT (
+			commandList.cmdAllocator->Reset()
+		);
+		CHECK_D3D_RESULT (
+			commandList.cmdList->Reset(commandList.cmdAllocator.Get(), nullptr)
+		);
+		return commandList;
+	}
+
+	CHECK_D3D_RESULT (
+		m_device->CreateCommandAllocator (
+			type,
+			IID_PPV_ARGS(&commandList.cmdAllocator)
+		)
+	);
+	D3D12_SET_NAME(commandList.cmdAllocator, L"CommandListPool Allocator");
+
+	// Created lists are open for recording.
+	CHECK_D3D_RESULT (
+		m_device->CreateCommandList (
+			0,
+			type,
+			commandList.cmdAllocator.Get(),
+			nullptr,
+			IID_PPV_ARGS(&commandList.cmdList)
+		)
+	);
+	D3D12_SET_NAME(commandList.cmdList, L"CommandListPool List");
+
+	return commandList;
+}
+
+//---------------------------------------------------------------------------------------
+void CommandListPool::release (
+	CommandList && commandList,
+	Timeline & timeline,
+	Timeline::Value retireValue
+) {
+	const D3D12_COMMAND_LIST_TYPE type = commandList.cmdList->GetType();
+	assert(uint(type) < NumTypes);
+
+	m_releasedLists.release(uint(type), std::move(commandList), timeline, retireValue);
+}
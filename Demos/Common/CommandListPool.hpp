@@ -0,0 +1,70 @@
+//
+// CommandListPool.hpp
+//
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/Timeline.hpp"
+#include "Common/TimelinePool.hpp"
+
+/**
+* Hands out command allocator and list pairs of any queue type, recycling them once
+* the GPU has finished executing their commands.
+*
+* acquire() returns a pair that is reset and ready to record.  Once submitted, the
+* pair is given back with release() along with the Timeline value the submission
+* retires on.  Later acquire() calls reuse the oldest pair released on any timeline
+* whose value has completed, without blocking, and only create a new pair if none
+* has.  Once the number of pairs in flight stops growing, no more D3D objects are
+* created.
+*
+* Fence bookkeeping is done by a TimelinePool, which is tested without a GPU; this
+* class only creates and resets the D3D objects.
+*
+* Timelines given to release() must outlive any later call to acquire().
+* Not thread-safe.
+*/
+class CommandListPool {
+public:
+	template <typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	struct CommandList {
+		ComPtr<ID3D12CommandAllocator> cmdAllocator;
+		ComPtr<ID3D12GraphicsCommandList> cmdList;
+	};
+
+	/// numHits counts calls to acquire() that recycled a pair, numMisses those that
+	/// created one.
+	typedef TimelinePool<CommandList>::Statistics Statistics;
+
+	explicit CommandListPool (
+		ID3D12Device * device
+	);
+
+	/// Returns a pair of 'type' whose list is open for recording.
+	CommandList acquire (
+		D3D12_COMMAND_LIST_TYPE type
+	);
+
+	/// Recycles 'commandList', whose list must be closed, once 'timeline' reaches
+	/// 'retireValue'.
+	void release (
+		CommandList && commandList,
+		Timeline & timeline,
+		Timeline::Value retireValue
+	);
+
+	const Statistics & statistics() const { return m_releasedLists.statistics(); }
+
+private:
+	static const uint NumTypes = D3D12_COMMAND_LIST_TYPE_COPY + 1;
+
+	ID3D12Device * m_device;
+
+	// Released pairs, of each command list type.
+	TimelinePool<CommandList> m_releasedLists;
+};
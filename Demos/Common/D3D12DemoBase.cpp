@@ -47,11 +47,13 @@ static void CreateSwapChain(
 	IDXGISwapChain3** swapChain,  
 	uint width, 
 	uint height, 
+	uint bufferCount,
+	uint maxFrameLatency,
 	IDXGIFactory2* dxgiFactory,
 	ID3D12CommandQueue* commandQueue )
 {
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-	swapChainDesc.BufferCount = NUM_BUFFERED_FRAMES;
+	swapChainDesc.BufferCount = bufferCount;
 	swapChainDesc.Width = width;
 	swapChainDesc.Height = height;
 	swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -76,7 +78,7 @@ static void CreateSwapChain(
 	CHECK_D3D_RESULT (
 		swapChain1->QueryInterface( __uuidof( IDXGISwapChain2 ), (void**)(&swapChain2) ) // Refcount++
 	);
-	swapChain2->SetMaximumFrameLatency(NUM_BUFFERED_FRAMES);
+	swapChain2->SetMaximumFrameLatency(maxFrameLatency);
 
 	// Assign interface object to m_swapChain so it persists past current scope.
 	CHECK_D3D_RESULT(
@@ -86,21 +88,6 @@ static void CreateSwapChain(
 	RELEASE_UNTIL_REFCOUNT( swapChain1, 1 );
 }
 
-//---------------------------------------------------------------------------------------
-void WaitForGpuFence (
-	ID3D12Fence * fence,
-	uint64 completionValue,
-	HANDLE fenceEvent
-) {
-	if (fence->GetCompletedValue() < completionValue) {
-		CHECK_D3D_RESULT (
-			fence->SetEventOnCompletion(completionValue, fenceEvent)
-		);
-		// fenceEvent will be signaled once GPU updates fence object to completionValue.
-		WaitForSingleObject(fenceEvent, INFINITE);
-	}
-}
-
 
 //---------------------------------------------------------------------------------------
 D3D12DemoBase::D3D12DemoBase (
@@ -108,11 +95,25 @@ D3D12DemoBase::D3D12DemoBase (
 	uint windowHeight,
 	std::string windowTitle
 ) :
+	m_latencyMode(LatencyMode::Throughput),
+	m_numBufferedFrames(3),
 	m_frameIndex(0),
 	m_windowWidth(windowWidth),
 	m_windowHeight(windowHeight),
 	m_windowTitle(windowTitle),
-	m_fenceValue{0}
+	m_windowText(windowTitle),
+	m_frameZone(0),
+	m_prepareRenderZone(0),
+	m_renderZone(0),
+	m_finalizeRenderZone(0),
+	m_gpuTimingTextFrame(0),
+	m_numBackBuffers(0),
+	m_backBufferIndex(0),
+	m_requiredUploadTicket(UploadQueue::NullTicket),
+	m_numLatencySamples(0),
+	m_latencySumMs(0.0),
+	m_latencyMinMs(0.0),
+	m_latencyMaxMs(0.0)
 {
 	// Default viewport to size of full window.
 	m_viewport.Width = static_cast<float>(windowWidth);
@@ -156,18 +157,34 @@ void D3D12DemoBase::CreateDirectCommandQueue ()
 //---------------------------------------------------------------------------------------
 D3D12DemoBase::~D3D12DemoBase()
 {
-	// Clean up event handles
-	for (auto event : m_frameFenceEvent) {
-		CloseHandle(event);
-	}
-
 	RELEASE_NULLIFY( m_device );
 	RELEASE_NULLIFY( m_swapChain );
 
+	// Join the workers before the rest of the demo is torn down.
+	m_parallelRecorder.reset();
+	m_jobSystem.reset();
+
 	// Uninitialize COM library.
 	CoUninitialize();
 }
 
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::SetLatencyMode (
+	LatencyMode mode,
+	uint numBufferedFrames
+) {
+	if (numBufferedFrames == 0) {
+		numBufferedFrames = (mode == LatencyMode::LowLatency) ? 1 : 3;
+	}
+	if (numBufferedFrames < MIN_BUFFERED_FRAMES || numBufferedFrames > MAX_BUFFERED_FRAMES) {
+		ForceBreak("Number of buffered frames must be within [%u, %u], was %u.",
+			MIN_BUFFERED_FRAMES, MAX_BUFFERED_FRAMES, numBufferedFrames);
+	}
+
+	m_latencyMode = mode;
+	m_numBufferedFrames = numBufferedFrames;
+}
+
 //---------------------------------------------------------------------------------------
 void D3D12DemoBase::Initialize()
 {
@@ -208,10 +225,13 @@ void D3D12DemoBase::Initialize()
 		dxgiFactory->MakeWindowAssociation( Win32Application::GetHwnd(), DXGI_MWA_NO_ALT_ENTER )
 	);
 
-	// Create the Swap Chain
+	// Create the Swap Chain.  Flip model swap chains need at least two buffers, even
+	// with a single frame in flight.
+	m_numBackBuffers = max(m_numBufferedFrames, 2u);
 	IDXGIFactory2* dxgiFactory2 = nullptr;
 	dxgiFactory->QueryInterface( __uuidof(IDXGIFactory2), (void**)(&dxgiFactory2) ); // RefCount++
-	CreateSwapChain( &m_swapChain, m_windowWidth, m_windowHeight, dxgiFactory2, m_directCmdQueue.Get() );
+	CreateSwapChain( &m_swapChain, m_windowWidth, m_windowHeight, m_numBackBuffers,
+		m_numBufferedFrames, dxgiFactory2, m_directCmdQueue.Get() );
 
 	RELEASE_NULLIFY( dxgiFactory );
 	RELEASE_NULLIFY( dxgiFactory2 );
@@ -220,8 +240,13 @@ void D3D12DemoBase::Initialize()
 	// Acquire handle to frame latency waitable object.
 	m_frameLatencyWaitableObject = m_swapChain->GetFrameLatencyWaitableObject();
 
-	// Set the current frame index to correspond with the current back buffer index.
-	m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+	// Frame slots are independent of back buffers, whose count may differ.
+	m_frameIndex = 0;
+	m_backBufferIndex = m_swapChain->GetCurrentBackBufferIndex();
+
+	LOG_INFO("%s mode, %u buffered frames, %u back buffers",
+		(m_latencyMode == LatencyMode::LowLatency) ? "Low-latency" : "Throughput",
+		m_numBufferedFrames, m_numBackBuffers);
 
 
 #ifdef _DEBUG
@@ -258,45 +283,74 @@ void D3D12DemoBase::Initialize()
 
 	CreateFenceObjects();
 
-	ComPtr<ID3D12CommandAllocator> cmdAllocator;
-	ComPtr<ID3D12GraphicsCommandList> uploadCmdList;
-	GenerateCommandList(uploadCmdList, cmdAllocator);
+	m_memoryAdapter.reset(new DxgiMemoryAdapter(m_device));
+	m_memoryBudget.reset(new MemoryBudget(m_memoryAdapter.get(), MemoryBudget::Settings()));
+
+	m_commandListPool.reset(new CommandListPool(m_device));
+
+	// Timestamps of a frame slot are read back once its fence is next waited on.
+	{
+		GpuProfiler::Settings profilerSettings;
+		profilerSettings.numFrameSlots = m_numBufferedFrames;
+		m_gpuProfiler.reset (
+			new D3D12GpuProfiler(m_device, m_directCmdQueue.Get(), profilerSettings)
+		);
+
+		GpuProfiler & profiler = m_gpuProfiler->getProfiler();
+		m_frameZone = profiler.registerZone("Frame");
+		m_prepareRenderZone = profiler.registerZone("PrepareRender");
+		m_renderZone = profiler.registerZone("Render");
+		m_finalizeRenderZone = profiler.registerZone("FinalizeRender");
+	}
+
+	m_uploadQueue.reset (
+		new UploadQueue (
+			m_device, m_commandListPool.get(), m_timelineScheduler.get(), m_memoryBudget.get()
+		)
+	);
+
+	m_jobSystem.reset(new JobSystem(JobSystem::defaultNumWorkerThreads()));
+
+	m_parallelRecorder.reset (
+		new ParallelCommandRecorder(m_commandListPool.get(), m_jobSystem.get())
+	);
+
+	CommandListPool::CommandList uploadCmdList =
+		m_commandListPool->acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
 
 	// Setup derived demo.
-	InitializeDemo(uploadCmdList.Get());
+	InitializeDemo(uploadCmdList.cmdList.Get());
 
 	// Close command list and execute it on the direct command queue. 
 	CHECK_D3D_RESULT (
-		uploadCmdList->Close()
+		uploadCmdList.cmdList->Close()
 	);
-	ID3D12CommandList * commandLists[] = { uploadCmdList.Get() };
+	ID3D12CommandList * commandLists[] = { uploadCmdList.cmdList.Get() };
 	m_directCmdQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
 
-	WaitForGpuCompletion(m_directCmdQueue.Get());
+	// Only wait on the direct queue.  Copies submitted to m_uploadQueue are waited on
+	// by the GPU once the resources are first used.
+	WaitForGpuCompletion();
+	m_commandListPool->release (
+		std::move(uploadCmdList), *m_frameTimeline, m_frameTimeline->lastSignaledValue()
+	);
 }
 
 
 //---------------------------------------------------------------------------------------
 void D3D12DemoBase::CreateFenceObjects()
 {
-	// Create synchronization primitives.
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
-		CHECK_D3D_RESULT(
-			m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_frameFence[i]))
-		);
-		m_fenceValue[i] = 0;
-
-		// Create an event handle to use for frame synchronization.
-		m_frameFenceEvent[i] = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-		if (m_frameFenceEvent[i] == nullptr) {
-			CHECK_D3D_RESULT(
-				HRESULT_FROM_WIN32(GetLastError())
-			);
-		}
-	}
+	// Create synchronization primitives.  A single fence on the direct queue tracks
+	// every frame, frame slots only remember the value they retire on.
+	m_timelineScheduler.reset(new D3D12TimelineScheduler());
+	m_frameTimeline.reset (
+		new Timeline (
+			std::make_unique<D3D12Fence>(m_device, m_directCmdQueue.Get()),
+			m_timelineScheduler.get()
+		)
+	);
 
-	// Initialize incremental fence value.
-	m_currentFenceValue = 1;
+	m_fenceValue.assign(m_numBufferedFrames, Timeline::NullValue);
 }
 
 
@@ -308,7 +362,7 @@ void D3D12DemoBase::CreateRenderTargetViews()
 		D3D12_DESCRIPTOR_HEAP_DESC rtvDescHeapDescriptor = {};
 
 		// The RTV Descriptor Heap will hold a RTV Descriptor for each swap chain buffer.
-		rtvDescHeapDescriptor.NumDescriptors = NUM_BUFFERED_FRAMES;
+		rtvDescHeapDescriptor.NumDescriptors = m_numBackBuffers;
 		rtvDescHeapDescriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
 		rtvDescHeapDescriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 		CHECK_D3D_RESULT (
@@ -326,8 +380,9 @@ void D3D12DemoBase::CreateRenderTargetViews()
 		// Get increment size between descriptors in RTV Descriptor Heap.
 		uint handleIncrementSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
-		// Create a render target view for each frame.
-		for (uint n(0); n < NUM_BUFFERED_FRAMES; ++n) {
+		// Create a render target view for each swap chain buffer.
+		m_renderTarget.reset(new HandledResource[m_numBackBuffers]);
+		for (uint n(0); n < m_numBackBuffers; ++n) {
 			CHECK_D3D_RESULT (
 				m_swapChain->GetBuffer(n, IID_PPV_ARGS(&m_renderTarget[n].resource))
 			);
@@ -395,7 +450,8 @@ void D3D12DemoBase::CreateDepthStencilBuffer()
 void D3D12DemoBase::CreateDrawCommandLists()
 {
 	//-- Create command allocator for managing command list memory.
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
+	m_directCmdAllocator.resize(m_numBufferedFrames);
+	for (uint i(0); i < m_numBufferedFrames; ++i) {
 		CHECK_D3D_RESULT(
 			m_device->CreateCommandAllocator (
 				D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -403,13 +459,14 @@ void D3D12DemoBase::CreateDrawCommandLists()
 			)
 		);
 	}
-	NAME_D3D12_OBJECT_ARRAY(m_directCmdAllocator, NUM_BUFFERED_FRAMES);
+	NAME_D3D12_OBJECT_ARRAY(m_directCmdAllocator, m_numBufferedFrames);
 
 
 	//-- Create the direct command lists which will hold our rendering commands:
 	{
-		// Create one command list for each swap chain buffer.
-		for (uint i(0); i < NUM_BUFFERED_FRAMES; ++i) {
+		// Create one command list for each frame slot.
+		m_drawCmdList.resize(m_numBufferedFrames);
+		for (uint i(0); i < m_numBufferedFrames; ++i) {
 			CHECK_D3D_RESULT(
 				m_device->CreateCommandList (
 					0,
@@ -422,53 +479,61 @@ void D3D12DemoBase::CreateDrawCommandLists()
 			// Stop recording, will reset this later before issuing drawing commands.
 			m_drawCmdList[i]->Close();
 		}
-		NAME_D3D12_OBJECT_ARRAY(m_drawCmdList, NUM_BUFFERED_FRAMES);
+		NAME_D3D12_OBJECT_ARRAY(m_drawCmdList, m_numBufferedFrames);
+	}
+
+	//-- Create the lists that close frames recorded in parallel, which share the
+	// frame's allocator once m_drawCmdList is closed:
+	{
+		m_finalizeCmdList.resize(m_numBufferedFrames);
+		for (uint i(0); i < m_numBufferedFrames; ++i) {
+			CHECK_D3D_RESULT(
+				m_device->CreateCommandList (
+					0,
+					D3D12_COMMAND_LIST_TYPE_DIRECT,
+					m_directCmdAllocator[i].Get(),
+					nullptr,
+					IID_PPV_ARGS(&m_finalizeCmdList[i])
+				)
+			);
+			m_finalizeCmdList[i]->Close();
+		}
+		NAME_D3D12_OBJECT_ARRAY(m_finalizeCmdList, m_numBufferedFrames);
 	}
 
 }
 
 //---------------------------------------------------------------------------------------
-void D3D12DemoBase::GenerateCommandList(
-	ComPtr<ID3D12GraphicsCommandList> & commandList,
-	ComPtr<ID3D12CommandAllocator> & cmdAllocator
-) {
-	// Create command allocator.
-	CHECK_D3D_RESULT(
-		m_device->CreateCommandAllocator (
-			D3D12_COMMAND_LIST_TYPE_DIRECT,
-			IID_PPV_ARGS(&cmdAllocator)
-		)
-	);
-	SET_D3D12_DEBUG_NAME(cmdAllocator);
+void D3D12DemoBase::WaitForNextFrame()
+{
+	// Wait until GPU has processed the previous indexed frame before building new one.
+	// Only blocks if the cached completed value is behind.
+	m_frameTimeline->waitOnCpu(m_fenceValue[m_frameIndex]);
 
+	if (m_latencyMode == LatencyMode::LowLatency) {
+		// Wait until the swap chain can queue another present, so that the input
+		// processed next is as recent as possible once the frame is displayed.
+		WaitForSingleObject(m_frameLatencyWaitableObject, INFINITE);
+	}
 
-	// Create command list.
-	CHECK_D3D_RESULT(
-		m_device->CreateCommandList (
-			0,
-			D3D12_COMMAND_LIST_TYPE_DIRECT,
-			cmdAllocator.Get(),
-			nullptr,
-			IID_PPV_ARGS(&commandList)
-		)
-	);
-	SET_D3D12_DEBUG_NAME(commandList);
+	QueryPerformanceCounter(&m_inputTime);
 }
 
-
 //---------------------------------------------------------------------------------------
 void D3D12DemoBase::BuildNextFrame()
 {
-	// Wait until GPU has processed the previous indexed frame before building new one.
-	::WaitForGpuFence (
-		m_frameFence[m_frameIndex].Get(),
-		m_fenceValue[m_frameIndex],
-		m_frameFenceEvent[m_frameIndex]
-	);
+	m_uploadQueue->retireCompletedBatches();
+
+	// The frame slot's previous frame has completed, so its timestamps are ready.
+	m_gpuProfiler->beginFrame(m_frameIndex);
+	UpdateGpuTimingText();
+
+	// Evict before Update(), so that demos see the latest headroom.
+	m_memoryBudget->update();
 
 	Update();
 
-	if (m_vsyncEnabled) {
+	if (m_vsyncEnabled && m_latencyMode == LatencyMode::Throughput) {
 		// Wait until swap chain has finished presenting all queued frames before building
 		// command lists and rendering next frame.  This will reduce latency for the next
 		// rendered frame.
@@ -480,6 +545,9 @@ void D3D12DemoBase::BuildNextFrame()
 
 	PrepareRender(m_directCmdAllocator[m_frameIndex].Get(), drawCmdList);
 
+	// Ended by FinalizeRender(), after any lists recorded in parallel.
+	m_gpuProfiler->beginZone(drawCmdList, m_renderZone);
+
 	Render(drawCmdList);
 
 	FinalizeRender(drawCmdList, m_directCmdQueue.Get());
@@ -488,7 +556,8 @@ void D3D12DemoBase::BuildNextFrame()
 //---------------------------------------------------------------------------------------
 void D3D12DemoBase::PresentNextFrame()
 {
-	if (m_vsyncEnabled) {
+	if (m_vsyncEnabled || m_latencyMode == LatencyMode::LowLatency) {
+		// Already waited on the swap chain before building the frame.
 		Present();
 
 	} else if (SwapChainWaitableObjectIsSignaled()) {
@@ -497,9 +566,7 @@ void D3D12DemoBase::PresentNextFrame()
 	}
 	else { 
 		// Start over and rebuild the frame again, rendering to the same indexed back buffer.
-		m_directCmdQueue->Signal(m_frameFence[m_frameIndex].Get(), m_currentFenceValue);
-		m_fenceValue[m_frameIndex] = m_currentFenceValue;
-		++m_currentFenceValue;
+		m_fenceValue[m_frameIndex] = m_frameTimeline->signal();
 	}
 }
 
@@ -513,11 +580,75 @@ void D3D12DemoBase::Present()
 		m_swapChain->Present(syncInterval, 0)
 	);
 
-	m_directCmdQueue->Signal(m_frameFence[m_frameIndex].Get(), m_currentFenceValue);
-	m_fenceValue[m_frameIndex] = m_currentFenceValue;
-	++m_currentFenceValue;
+	m_fenceValue[m_frameIndex] = m_frameTimeline->signal();
+
+	PendingPresent present;
+	CHECK_D3D_RESULT (
+		m_swapChain->GetLastPresentCount(&present.presentCount)
+	);
+	present.fenceValue = m_fenceValue[m_frameIndex];
+	present.inputTime = m_inputTime;
+	m_pendingPresents.push_back(present);
+
+	MeasurePresentLatency();
+
+	m_frameIndex = (m_frameIndex + 1) % m_numBufferedFrames;
+}
 
-	m_frameIndex = (m_frameIndex + 1) % NUM_BUFFERED_FRAMES;
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::MeasurePresentLatency()
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	const double msPerTick = 1000.0 / double(frequency.QuadPart);
+
+	// Frame statistics give the time the latest displayed present was scanned out.
+	// When unavailable, e.g. while the window is occluded, fall back to the time at
+	// which the GPU is first seen to have completed the frame.
+	DXGI_FRAME_STATISTICS frameStatistics = {};
+	const bool hasFrameStatistics = SUCCEEDED(m_swapChain->GetFrameStatistics(&frameStatistics));
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+
+	while (!m_pendingPresents.empty()) {
+		const PendingPresent & present = m_pendingPresents.front();
+		LONGLONG presentTime;
+		if (hasFrameStatistics && present.presentCount <= frameStatistics.PresentCount) {
+			// Earlier presents were displayed before the statistics were last queried.
+			if (present.presentCount < frameStatistics.PresentCount) {
+				m_pendingPresents.pop_front();
+				continue;
+			}
+			presentTime = frameStatistics.SyncQPCTime.QuadPart;
+
+		} else if (!hasFrameStatistics && m_frameTimeline->isComplete(present.fenceValue)) {
+			presentTime = now.QuadPart;
+
+		} else {
+			break;
+		}
+
+		const double latencyMs = double(presentTime - present.inputTime.QuadPart) * msPerTick;
+		m_pendingPresents.pop_front();
+
+		m_latencyMinMs = m_numLatencySamples ? min(m_latencyMinMs, latencyMs) : latencyMs;
+		m_latencyMaxMs = m_numLatencySamples ? max(m_latencyMaxMs, latencyMs) : latencyMs;
+		m_latencySumMs += latencyMs;
+		++m_numLatencySamples;
+	}
+
+	const uint numSamplesPerLog = 240;
+	if (m_numLatencySamples >= numSamplesPerLog) {
+		LOG_INFO("%s mode, %u buffered frames: input-to-present latency "
+			"%.2f min, %.2f avg, %.2f max ms",
+			(m_latencyMode == LatencyMode::LowLatency) ? "Low-latency" : "Throughput",
+			m_numBufferedFrames, m_latencyMinMs, m_latencySumMs / m_numLatencySamples,
+			m_latencyMaxMs);
+
+		m_numLatencySamples = 0;
+		m_latencySumMs = 0.0;
+	}
 }
 
 //---------------------------------------------------------------------------------------
@@ -527,17 +658,29 @@ __forceinline bool D3D12DemoBase::SwapChainWaitableObjectIsSignaled()
 }
 
 //---------------------------------------------------------------------------------------
-void D3D12DemoBase::WaitForGpuCompletion (
-	ID3D12CommandQueue * commandQueue
+void D3D12DemoBase::WaitForGpuCompletion()
+{
+	m_fenceValue[m_frameIndex] = m_frameTimeline->signal();
+	m_frameTimeline->waitOnCpu(m_fenceValue[m_frameIndex]);
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::RequireUploadCompletion (
+	UploadQueue::Ticket ticket
 ) {
-	CHECK_D3D_RESULT (
-		commandQueue->Signal(m_frameFence[m_frameIndex].Get(), m_currentFenceValue)
-	);
-	m_fenceValue[m_frameIndex] = m_currentFenceValue;
-	++m_currentFenceValue;
+	m_requiredUploadTicket = max(m_requiredUploadTicket, ticket);
+}
+
+//---------------------------------------------------------------------------------------
+uint64 D3D12DemoBase::GetCompletedFenceValue() const
+{
+	return m_frameTimeline->completedValue();
+}
 
-	::WaitForGpuFence(m_frameFence[m_frameIndex].Get(),
-		m_fenceValue[m_frameIndex], m_frameFenceEvent[m_frameIndex]);
+//---------------------------------------------------------------------------------------
+uint64 D3D12DemoBase::GetLastSubmittedFenceValue() const
+{
+	return m_frameTimeline->lastSignaledValue();
 }
 
 //---------------------------------------------------------------------------------------
@@ -603,25 +746,27 @@ void D3D12DemoBase::PrepareRender (
 		drawCmdList->Reset(commandAllocator, nullptr)
 	);
 
-	drawCmdList->RSSetViewports(1, &m_viewport);
-	drawCmdList->RSSetScissorRects(1, &m_scissorRect);
+	// Ended by FinalizeRender().
+	m_gpuProfiler->beginZone(drawCmdList, m_frameZone);
+
+	D3D12GpuProfiler::Scope profilerScope(*m_gpuProfiler, drawCmdList, m_prepareRenderZone);
+
+	// The back buffer is not tied to the frame slot, their counts may differ.
+	m_backBufferIndex = m_swapChain->GetCurrentBackBufferIndex();
 
 	// Indicate that the back buffer for the current frame will be used as a render target.
 	drawCmdList->ResourceBarrier (1,
 		&CD3DX12_RESOURCE_BARRIER::Transition (
-			m_renderTarget[m_frameIndex].resource,
+			m_renderTarget[m_backBufferIndex].resource,
 			D3D12_RESOURCE_STATE_PRESENT,
 			D3D12_RESOURCE_STATE_RENDER_TARGET
 		)
 	);
 
-	// Acquire handle to Depth-Stencil View.
-	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle (m_dsvDescHeap->GetCPUDescriptorHandleForHeapStart());
-
-	// Acquire handle to Render Target View.
-	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle (m_renderTarget[m_frameIndex].rtvHandle);
+	SetRenderTargets(drawCmdList);
 
-	drawCmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle (m_dsvDescHeap->GetCPUDescriptorHandleForHeapStart());
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle (m_renderTarget[m_backBufferIndex].rtvHandle);
 
 	// Clear render target.
 	const float clearColor[] = {0.0f, 0.2f, 0.4f, 1.0f};
@@ -633,41 +778,114 @@ void D3D12DemoBase::PrepareRender (
 	);
 }
 
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::SetRenderTargets (
+	ID3D12GraphicsCommandList * drawCmdList
+) {
+	drawCmdList->RSSetViewports(1, &m_viewport);
+	drawCmdList->RSSetScissorRects(1, &m_scissorRect);
+
+	// Acquire handle to Depth-Stencil View.
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle (m_dsvDescHeap->GetCPUDescriptorHandleForHeapStart());
+
+	// Acquire handle to Render Target View.
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle (m_renderTarget[m_backBufferIndex].rtvHandle);
+
+	drawCmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::RecordParallel (
+	uint numChunks,
+	const ParallelCommandRecorder::RecordChunk & recordChunk
+) {
+	m_parallelRecorder->record (numChunks,
+		[this, &recordChunk](ID3D12GraphicsCommandList * commandList, uint chunkIndex) {
+			SetRenderTargets(commandList);
+			recordChunk(commandList, chunkIndex);
+		}
+	);
+}
+
+//---------------------------------------------------------------------------------------
+uint D3D12DemoBase::GetMaxParallelChunks() const
+{
+	return m_parallelRecorder->maxConcurrentChunks();
+}
+
 //---------------------------------------------------------------------------------------
 void D3D12DemoBase::FinalizeRender (
 	ID3D12GraphicsCommandList * drawCmdList,
 	ID3D12CommandQueue * commandQueue
 ) {
-	// Indicate that the back buffer will now be used to present.
-	drawCmdList->ResourceBarrier (1,
-		&CD3DX12_RESOURCE_BARRIER::Transition (
-			m_renderTarget[m_frameIndex].resource,
-			D3D12_RESOURCE_STATE_RENDER_TARGET,
-			D3D12_RESOURCE_STATE_PRESENT
-		)
-	);
+	const uint numParallelLists = m_parallelRecorder->numCommandLists();
+
+	// Indicate that the back buffer will now be used to present, after any lists
+	// recorded in parallel.
+	ID3D12GraphicsCommandList * finalCmdList = drawCmdList;
+	if (numParallelLists > 0) {
+		CHECK_D3D_RESULT (
+			drawCmdList->Close()
+		);
+		finalCmdList = m_finalizeCmdList[m_frameIndex].Get();
+		CHECK_D3D_RESULT (
+			finalCmdList->Reset(m_directCmdAllocator[m_frameIndex].Get(), nullptr)
+		);
+	}
+
+	m_gpuProfiler->endZone(finalCmdList, m_renderZone);
+
+	{
+		D3D12GpuProfiler::Scope profilerScope(*m_gpuProfiler, finalCmdList, m_finalizeRenderZone);
+
+		finalCmdList->ResourceBarrier (1,
+			&CD3DX12_RESOURCE_BARRIER::Transition (
+				m_renderTarget[m_backBufferIndex].resource,
+				D3D12_RESOURCE_STATE_RENDER_TARGET,
+				D3D12_RESOURCE_STATE_PRESENT
+			)
+		);
+	}
+
+	// Resolve the frame's timestamps, which are read back once its slot is reused.
+	m_gpuProfiler->endZone(finalCmdList, m_frameZone);
+	m_gpuProfiler->endFrame(finalCmdList);
 
 	CHECK_D3D_RESULT (
-		drawCmdList->Close()
+		finalCmdList->Close()
 	);
 
-	// Execute the command list.
-	ID3D12CommandList* commandLists[] = {drawCmdList};
-	commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+	if (m_requiredUploadTicket != UploadQueue::NullTicket) {
+		m_uploadQueue->waitOnGpu(*m_frameTimeline, m_requiredUploadTicket);
+		m_requiredUploadTicket = UploadQueue::NullTicket;
+	}
+
+	// Execute the frame's command lists in recording order, with a single submission.
+	std::vector<ID3D12CommandList *> & commandLists = m_submittedCmdLists;
+	commandLists.assign(1, drawCmdList);
+	if (numParallelLists > 0) {
+		ID3D12CommandList * const * parallelLists = m_parallelRecorder->commandLists();
+		commandLists.insert(commandLists.end(), parallelLists, parallelLists + numParallelLists);
+		commandLists.push_back(finalCmdList);
+	}
+	commandQueue->ExecuteCommandLists(uint(commandLists.size()), commandLists.data());
+
+	// Recycled once the frame's signal completes.
+	m_parallelRecorder->endFrame(*m_frameTimeline, m_frameTimeline->nextSignaledValue());
 }
 
 //---------------------------------------------------------------------------------------
 void D3D12DemoBase::PrepareCleanup()
 {
-	// Signal command-queue 
-	m_directCmdQueue->Signal(m_frameFence[m_frameIndex].Get(), m_currentFenceValue);
-	m_fenceValue[m_frameIndex] = m_currentFenceValue;
-	++m_currentFenceValue;
-
-	// Wait for command queue to finish processing all buffered frames.
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
-		WaitForGpuFence(m_frameFence[i].Get(), m_fenceValue[i], m_frameFenceEvent[i]);
-	}
+	// Wait for command queue to finish processing all buffered frames, which complete
+	// before a final signal.
+	WaitForGpuCompletion();
+
+	m_uploadQueue->waitForIdle();
+
+	const CommandListPool::Statistics & poolStats = m_commandListPool->statistics();
+	LOG_INFO("Command list pool: %llu hits, %llu misses",
+		poolStats.numHits, poolStats.numMisses);
 
 	// Now it is safe to Release() D3D resources.
 }
@@ -688,7 +906,7 @@ uint D3D12DemoBase::GetWindowHeight() const {
 
 //---------------------------------------------------------------------------------------
 const char * D3D12DemoBase::GetWindowTitle() const {
-	return m_windowTitle.c_str();
+	return m_windowText.c_str();
 }
 
 
@@ -721,6 +939,38 @@ std::string D3D12DemoBase::GetAssetPath (
 void D3D12DemoBase::SetCustomWindowText (
 	LPCSTR text
 ) {
-	std::string windowText = m_windowTitle + ": " + text;
-	SetWindowText(Win32Application::GetHwnd(), windowText.c_str());
+	m_customWindowText = text;
+	RefreshWindowText();
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::RefreshWindowText()
+{
+	// Kept so that the frame rate display, which rewrites the title, preserves it.
+	m_windowText = m_windowTitle;
+	if (!m_customWindowText.empty()) {
+		m_windowText += ": " + m_customWindowText;
+	}
+	if (!m_gpuTimingText.empty()) {
+		m_windowText += " | " + m_gpuTimingText;
+	}
+	SetWindowText(Win32Application::GetHwnd(), m_windowText.c_str());
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12DemoBase::UpdateGpuTimingText()
+{
+	// Often enough to follow, rarely enough to read.
+	const uint64 framesPerUpdate = 30;
+	const uint64 numResolvedFrames = m_gpuProfiler->getProfiler().numResolvedFrames();
+	if (numResolvedFrames < m_gpuTimingTextFrame + framesPerUpdate) {
+		return;
+	}
+	m_gpuTimingTextFrame = numResolvedFrames;
+
+	// Keeps the window title readable however many zones are registered.
+	const size_t maxLength = 160;
+	m_gpuTimingText = "GPU ms min/avg/max: ";
+	m_gpuProfiler->getProfiler().formatStatistics(m_gpuTimingText, maxLength);
+	RefreshWindowText();
 }
@@ -1,16 +1,30 @@
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <vector>
+
 #include <wrl.h>
 #include <d3d12.h>
 #include <dxgi1_4.h>
 
 #include "Common/BasicTypes.hpp"
+#include "Common/CommandListPool.hpp"
+#include "Common/D3D12GpuProfiler.hpp"
+#include "Common/D3D12Timeline.hpp"
 #include "Common/DemoUtils.hpp"
+#include "Common/DxgiMemoryAdapter.hpp"
+#include "Common/JobSystem.hpp"
+#include "Common/MemoryBudget.hpp"
+#include "Common/ParallelCommandRecorder.hpp"
+#include "Common/UploadQueue.hpp"
 #include "Common/Win32Application.hpp"
 
 
-// Number of rendered frames to pre-flight for execution on the GPU.
-#define NUM_BUFFERED_FRAMES  3
+// Bounds of the number of rendered frames that may be pre-flighted for execution on
+// the GPU, see D3D12DemoBase::SetLatencyMode().
+#define MIN_BUFFERED_FRAMES  1
+#define MAX_BUFFERED_FRAMES  4
 
 
 struct ScreenPosition {
@@ -19,6 +33,19 @@ struct ScreenPosition {
 };
 
 
+// Trade-off between input latency and throughput made when pacing frames.
+enum class LatencyMode {
+	// A single frame in flight by default.  Each frame waits on the swap chain's
+	// waitable object before input is processed, so that input is sampled as late as
+	// possible before the frame is displayed.
+	LowLatency,
+
+	// Three frames in flight by default, letting the CPU build frames ahead of the GPU
+	// so that neither waits on the other.
+	Throughput
+};
+
+
 
 // Base class for all D3D12 demos.
 class D3D12DemoBase
@@ -60,8 +87,19 @@ public:
 
 	void MouseLButtonUp();
 
+	// Selects how frames are paced, and how many frames may be in flight, from
+	// MIN_BUFFERED_FRAMES to MAX_BUFFERED_FRAMES, with 0 selecting the default of
+	// 'mode'.  Must be called before Initialize().
+	void SetLatencyMode (
+		LatencyMode mode,
+		uint numBufferedFrames = 0
+	);
+
 	void Initialize();
 
+	// Waits until the next frame can be built, call before processing input.
+	void WaitForNextFrame();
+
 	void BuildNextFrame();
 
 	void PresentNextFrame();
@@ -83,6 +121,12 @@ protected:
 
 	bool m_vsyncEnabled = true;
 
+	LatencyMode m_latencyMode;
+
+	// Number of frames that may be in flight, fixed once initialized.  Per-frame
+	// resources are sized by it and indexed by m_frameIndex.
+	uint m_numBufferedFrames;
+
 	uint m_frameIndex;
 
 	// Window and viewport dimensions.
@@ -99,8 +143,30 @@ protected:
 
 	// Direct Command Queue Related
 	ComPtr<ID3D12CommandQueue> m_directCmdQueue;
-	ComPtr<ID3D12CommandAllocator> m_directCmdAllocator[NUM_BUFFERED_FRAMES];
-	ComPtr<ID3D12GraphicsCommandList> m_drawCmdList[NUM_BUFFERED_FRAMES];
+	std::vector<ComPtr<ID3D12CommandAllocator>> m_directCmdAllocator;
+	std::vector<ComPtr<ID3D12GraphicsCommandList>> m_drawCmdList;
+
+	// Closes each frame when lists recorded in parallel follow m_drawCmdList.
+	std::vector<ComPtr<ID3D12GraphicsCommandList>> m_finalizeCmdList;
+
+	// Budget and usage of GPU memory, polled every frame before Update().
+	std::unique_ptr<DxgiMemoryAdapter> m_memoryAdapter;
+	std::unique_ptr<MemoryBudget> m_memoryBudget;
+
+	// Command lists for transient work, recycled once the GPU is done with them.
+	std::unique_ptr<CommandListPool> m_commandListPool;
+
+	// Asynchronous resource uploads on a dedicated copy queue.
+	std::unique_ptr<UploadQueue> m_uploadQueue;
+
+	// Worker threads for loading assets in parallel, available from InitializeDemo().
+	std::unique_ptr<JobSystem> m_jobSystem;
+
+	// Records draws on m_jobSystem's workers, see RecordParallel().
+	std::unique_ptr<ParallelCommandRecorder> m_parallelRecorder;
+
+	// GPU time of each frame and of its passes, shown in the window text.
+	std::unique_ptr<D3D12GpuProfiler> m_gpuProfiler;
 
 
 	IDXGISwapChain3* m_swapChain;
@@ -114,25 +180,30 @@ protected:
 			D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle;
 		};
 
-		ID3D12Resource * resource;
+		ID3D12Resource * resource = nullptr;
 
-		~HandledResource() { resource->Release(); }
+		~HandledResource() { RELEASE_NULLIFY(resource); }
 	};
 
 	// Depth-Stencil Resource 
 	ComPtr<ID3D12DescriptorHeap> m_dsvDescHeap;
 	HandledResource m_depthStencilBuffer;
 
-	// Render Target Resources
+	// Render Target Resources, one per swap chain buffer, indexed by m_backBufferIndex.
 	ComPtr<ID3D12DescriptorHeap> m_rtvDescHeap;
-	HandledResource m_renderTarget[NUM_BUFFERED_FRAMES];
+	std::unique_ptr<HandledResource[]> m_renderTarget;
+	uint m_numBackBuffers;
+	uint m_backBufferIndex;
+
 
+	// Synchronization objects.  Every queue's Timeline shares m_timelineScheduler.
+	std::unique_ptr<D3D12TimelineScheduler> m_timelineScheduler;
 
-	// Synchronization objects.
-	HANDLE m_frameFenceEvent[NUM_BUFFERED_FRAMES];
-	ComPtr<ID3D12Fence> m_frameFence[NUM_BUFFERED_FRAMES];
-	uint64 m_currentFenceValue;
-	uint64 m_fenceValue[NUM_BUFFERED_FRAMES];
+	// Signaled by the direct queue after each frame.
+	std::unique_ptr<Timeline> m_frameTimeline;
+
+	// Value of m_frameTimeline on which each frame slot's resources can be reused.
+	std::vector<Timeline::Value> m_fenceValue;
 
 
 	virtual void InitializeDemo (
@@ -157,14 +228,39 @@ protected:
 
 	void Present();
 
+	// Records 'numChunks' chunks of draws in parallel from Render(), each into its own
+	// command list with the viewport and render targets of the frame already set.
+	// The chunks execute in order after everything recorded into Render()'s
+	// 'drawCmdList', so record into it only beforehand.
+	void RecordParallel (
+		uint numChunks,
+		const ParallelCommandRecorder::RecordChunk & recordChunk
+	);
+
+	// Number of chunks RecordParallel() can record concurrently.
+	uint GetMaxParallelChunks() const;
+
 	__forceinline bool SwapChainWaitableObjectIsSignaled();
 
-	// Issues a Signal from 'commanQueue', and causes current thread to block
-	// until GPU completes the Signal.
-	void WaitForGpuCompletion (
-		ID3D12CommandQueue * commandQueue
+	// Makes the direct queue wait on the GPU for 'ticket' before executing the frame
+	// currently being built.  Call from Render() for any resource uploaded through
+	// m_uploadQueue, the wait is dropped once the upload has completed.
+	void RequireUploadCompletion (
+		UploadQueue::Ticket ticket
 	);
 
+	// Returns the largest frame fence value known to be completed by the GPU, without
+	// querying the fence.  Once the current frame slot has been waited on, this is at
+	// least the value that frame slot was last signaled with.
+	uint64 GetCompletedFenceValue() const;
+
+	// Returns the frame fence value signaled by the last frame submitted.
+	uint64 GetLastSubmittedFenceValue() const;
+
+	// Signals the direct queue's timeline, and causes current thread to block
+	// until GPU completes the Signal.
+	void WaitForGpuCompletion();
+
 	/// Helper function for resolving the full path of assets.
 	std::string GetAssetPath (
 		const char * assetName
@@ -184,15 +280,47 @@ private:
 	// Window title.
 	std::string m_windowTitle;
 
+	// Window title followed by any text given to SetCustomWindowText(), and GPU timings.
+	std::string m_windowText;
+	std::string m_customWindowText;
+	std::string m_gpuTimingText;
+
+	// Zones timed by m_gpuProfiler around each pass of the frame.
+	GpuProfiler::ZoneId m_frameZone;
+	GpuProfiler::ZoneId m_prepareRenderZone;
+	GpuProfiler::ZoneId m_renderZone;
+	GpuProfiler::ZoneId m_finalizeRenderZone;
+
+	// Resolved frame count when m_gpuTimingText was last formatted.
+	uint64 m_gpuTimingTextFrame;
+
+	// Upload ticket the current frame must wait on, see RequireUploadCompletion().
+	UploadQueue::Ticket m_requiredUploadTicket;
+
+	// Command lists of the frame being submitted, reused across frames.
+	std::vector<ID3D12CommandList *> m_submittedCmdLists;
+
+	// Presented frame whose input-to-present latency is yet to be measured.
+	struct PendingPresent {
+		uint presentCount;
+		Timeline::Value fenceValue;
+		LARGE_INTEGER inputTime;
+	};
+
+	// Time at which the frame being built started processing input.
+	LARGE_INTEGER m_inputTime;
+	std::deque<PendingPresent> m_pendingPresents;
+
+	// Input-to-present latencies measured since the last log.
+	uint m_numLatencySamples;
+	double m_latencySumMs;
+	double m_latencyMinMs;
+	double m_latencyMaxMs;
+
 	void CreateDirectCommandQueue ();
 
 	void CreateDrawCommandLists ();
 
-	void GenerateCommandList (
-		ComPtr<ID3D12GraphicsCommandList> & commandList,
-		ComPtr<ID3D12CommandAllocator> & cmdAllocator
-	);
-
 	void CreateDepthStencilBuffer();
 
 	void CreateHardwareDevice (
@@ -205,12 +333,20 @@ private:
 
 	void CreateRenderTargetViews();
 
+	// Sets the viewport and render targets of the current frame on 'drawCmdList'.
+	void SetRenderTargets (
+		ID3D12GraphicsCommandList * drawCmdList
+	);
+
+	// Rebuilds the window text from the title, custom text and GPU timings.
+	void RefreshWindowText();
+
+	// Reformats m_gpuTimingText every few resolved frames.
+	void UpdateGpuTimingText();
+
+	// Measures the latency of presented frames once they are displayed, periodically
+	// logging it.
+	void MeasurePresentLatency();
+
 };
 
-// Causes current thread to wait on 'fenceEvent' until GPU fence value
-// is equal to 'completionValue'.
-void WaitForGpuFence (
-	ID3D12Fence * fence,
-	uint64 completionValue,
-	HANDLE fenceEvent
-);
@@ -0,0 +1,117 @@
+//
+// D3D12GpuProfiler.cpp
+//
+#include "pch.h"
+
+#include "D3D12GpuProfiler.hpp"
+
+
+//---------------------------------------------------------------------------------------
+D3D12GpuProfiler::D3D12GpuProfiler (
+	ID3D12Device * device,
+	ID3D12CommandQueue * commandQueue,
+	const GpuProfiler::Settings & settings
+)
+	: m_profiler(settings),
+	  m_frequency(0)
+{
+	assert(device && commandQueue);
+
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = m_profiler.numQueries();
+	CHECK_D3D_RESULT (
+		device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_queryHeap))
+	);
+	SET_D3D12_DEBUG_NAME(m_queryHeap);
+
+	const auto readbackHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+	const auto readbackBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (
+		m_profiler.numQueries() * sizeof(uint64)
+	);
+	CHECK_D3D_RESULT (
+		device->CreateCommittedResource (
+			&readbackHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&readbackBufferDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(&m_readbackBuffer)
+		)
+	);
+	SET_D3D12_DEBUG_NAME(m_readbackBuffer);
+
+	CHECK_D3D_RESULT (
+		commandQueue->GetTimestampFrequency(&m_frequency)
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12GpuProfiler::beginFrame (
+	uint frameSlot
+) {
+	if (m_profiler.isPending(frameSlot)) {
+		const size_t firstByte = frameSlot * m_profiler.maxQueriesPerFrame() * sizeof(uint64);
+		const D3D12_RANGE readRange = {
+			firstByte, firstByte + m_profiler.maxQueriesPerFrame() * sizeof(uint64)
+		};
+
+		void * data;
+		CHECK_D3D_RESULT (
+			m_readbackBuffer->Map(0, &readRange, &data)
+		);
+		m_profiler.resolveFrame (
+			frameSlot,
+			reinterpret_cast<const uint64 *>(static_cast<const uint8 *>(data) + firstByte),
+			m_frequency
+		);
+
+		// Nothing was written.
+		const D3D12_RANGE writtenRange = { 0, 0 };
+		m_readbackBuffer->Unmap(0, &writtenRange);
+	}
+
+	m_profiler.beginFrame(frameSlot);
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12GpuProfiler::beginZone (
+	ID3D12GraphicsCommandList * commandList,
+	GpuProfiler::ZoneId zone
+) {
+	const uint query = m_profiler.beginZone(zone);
+	if (query != GpuProfiler::InvalidQuery) {
+		commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12GpuProfiler::endZone (
+	ID3D12GraphicsCommandList * commandList,
+	GpuProfiler::ZoneId zone
+) {
+	const uint query = m_profiler.endZone(zone);
+	if (query != GpuProfiler::InvalidQuery) {
+		commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12GpuProfiler::endFrame (
+	ID3D12GraphicsCommandList * commandList
+) {
+	uint firstQuery;
+	uint numQueries;
+	m_profiler.endFrame(&firstQuery, &numQueries);
+
+	if (numQueries > 0) {
+		commandList->ResolveQueryData (
+			m_queryHeap.Get(),
+			D3D12_QUERY_TYPE_TIMESTAMP,
+			firstQuery,
+			numQueries,
+			m_readbackBuffer.Get(),
+			firstQuery * sizeof(uint64)
+		);
+	}
+}
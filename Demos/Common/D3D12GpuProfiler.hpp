@@ -0,0 +1,86 @@
+//
+// D3D12GpuProfiler.hpp
+//
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/GpuProfiler.hpp"
+
+
+/// Issues the timestamp queries of a GpuProfiler on a D3D12 command queue.
+///
+/// Every frame slot resolves its queries into its own region of a readback buffer
+/// at the end of the frame.  The region is read when the frame slot is next begun,
+/// after the CPU has waited on the slot's fence anyway, so reading never stalls.
+class D3D12GpuProfiler {
+public:
+	D3D12GpuProfiler (
+		_In_ ID3D12Device * device,
+		_In_ ID3D12CommandQueue * commandQueue,
+		const GpuProfiler::Settings & settings
+	);
+
+	/// Resolves the frame last recorded in 'frameSlot', then starts recording a new
+	/// one.  The GPU must have completed the slot's previous frame.
+	void beginFrame (
+		uint frameSlot
+	);
+
+	void beginZone (
+		_In_ ID3D12GraphicsCommandList * commandList,
+		GpuProfiler::ZoneId zone
+	);
+
+	void endZone (
+		_In_ ID3D12GraphicsCommandList * commandList,
+		GpuProfiler::ZoneId zone
+	);
+
+	/// Records the resolve of the frame's queries into 'commandList', which must be
+	/// executed after every list the frame's zones were recorded into.
+	void endFrame (
+		_In_ ID3D12GraphicsCommandList * commandList
+	);
+
+	GpuProfiler & getProfiler() { return m_profiler; }
+
+	/// Times the commands recorded into a command list during its lifetime.
+	class Scope {
+	public:
+		Scope (
+			D3D12GpuProfiler & profiler,
+			_In_ ID3D12GraphicsCommandList * commandList,
+			GpuProfiler::ZoneId zone
+		)
+			: m_profiler(profiler),
+			  m_commandList(commandList),
+			  m_zone(zone)
+		{
+			m_profiler.beginZone(m_commandList, m_zone);
+		}
+
+		~Scope()
+		{
+			m_profiler.endZone(m_commandList, m_zone);
+		}
+
+	private:
+		D3D12GpuProfiler & m_profiler;
+		ID3D12GraphicsCommandList * m_commandList;
+		GpuProfiler::ZoneId m_zone;
+
+		Scope(const Scope &) = delete;
+		Scope & operator = (const Scope &) = delete;
+	};
+
+private:
+	GpuProfiler m_profiler;
+
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_queryHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_readbackBuffer;
+
+	// Timestamp ticks per second of the command queue.
+	uint64 m_frequency;
+};
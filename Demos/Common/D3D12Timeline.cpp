@@ -0,0 +1,84 @@
+#include "pch.h"
+
+#include "D3D12Timeline.hpp"
+
+
+//---------------------------------------------------------------------------------------
+D3D12Fence::D3D12Fence (
+	_In_ ID3D12Device * device,
+	_In_ ID3D12CommandQueue * commandQueue
+)
+	: m_commandQueue(commandQueue)
+{
+	assert(device && commandQueue);
+
+	CHECK_D3D_RESULT (
+		device->CreateFence (
+			Timeline::NullValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)
+		)
+	);
+	SET_D3D12_DEBUG_NAME(m_fence);
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12Fence::signal (
+	Timeline::Value value
+) {
+	CHECK_D3D_RESULT (
+		m_commandQueue->Signal(m_fence.Get(), value)
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12Fence::queueWait (
+	Timeline::Fence * fence,
+	Timeline::Value value
+) {
+	CHECK_D3D_RESULT (
+		m_commandQueue->Wait(static_cast<D3D12Fence *>(fence)->getFence(), value)
+	);
+}
+
+//---------------------------------------------------------------------------------------
+Timeline::Value D3D12Fence::queryCompletedValue()
+{
+	return m_fence->GetCompletedValue();
+}
+
+//---------------------------------------------------------------------------------------
+D3D12TimelineScheduler::~D3D12TimelineScheduler()
+{
+	for (HANDLE event : m_events) {
+		CloseHandle(event);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void D3D12TimelineScheduler::waitForAny (
+	Timeline::Fence * const * fences,
+	const Timeline::Value * values,
+	uint count
+) {
+	assert(count <= MAXIMUM_WAIT_OBJECTS);
+
+	while (m_events.size() < count) {
+		HANDLE event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		if (event == nullptr) {
+			CHECK_WIN_RESULT (
+				HRESULT_FROM_WIN32(GetLastError())
+			);
+		}
+		m_events.push_back(event);
+	}
+
+	// Events of fences that completed during an earlier wait may still be set, which
+	// only returns early.
+	for (uint i = 0; i < count; ++i) {
+		CHECK_D3D_RESULT (
+			static_cast<D3D12Fence *>(fences[i])->getFence()->SetEventOnCompletion (
+				values[i], m_events[i]
+			)
+		);
+	}
+	WaitForMultipleObjects(count, m_events.data(), FALSE, INFINITE);
+}
@@ -0,0 +1,57 @@
+//
+// D3D12Timeline.hpp
+//
+#pragma once
+
+#include <vector>
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/Timeline.hpp"
+
+
+/// Timeline::Fence signaled by a D3D12 command queue.
+class D3D12Fence : public Timeline::Fence {
+public:
+	D3D12Fence (
+		_In_ ID3D12Device * device,
+		_In_ ID3D12CommandQueue * commandQueue
+	);
+
+	void signal (
+		Timeline::Value value
+	) override;
+
+	/// 'fence' must be a D3D12Fence.
+	void queueWait (
+		Timeline::Fence * fence,
+		Timeline::Value value
+	) override;
+
+	Timeline::Value queryCompletedValue() override;
+
+	ID3D12Fence * getFence() const { return m_fence.Get(); }
+
+private:
+	ID3D12CommandQueue * m_commandQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
+};
+
+
+/// Timeline::Scheduler blocking on D3D12Fences through Win32 events, one per fence
+/// waited on at once.
+class D3D12TimelineScheduler : public Timeline::Scheduler {
+public:
+	~D3D12TimelineScheduler();
+
+	/// 'fences' must be D3D12Fences.
+	void waitForAny (
+		Timeline::Fence * const * fences,
+		const Timeline::Value * values,
+		uint count
+	) override;
+
+private:
+	std::vector<HANDLE> m_events;
+};
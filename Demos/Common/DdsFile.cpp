@@ -0,0 +1,518 @@
+//
+// DdsFile.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#ifdef _WIN32
+	// Allow use of fopen() without SDL check errors, as pch.h does.
+	#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "DdsFile.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+namespace {
+
+	const uint32 Magic = 0x20534444; // "DDS "
+
+	/// Marks headers written by TextureBaker, "TXBK".
+	const uint32 BakeMagic = 0x4B425854;
+
+	/// Increment whenever BakeRecord changes, or the baker's output for the same
+	/// settings does.
+	const uint32 BakeVersion = 1;
+
+	// D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION and D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION.
+	const uint MaxDimension = 16384;
+	const uint MaxArraySize = 2048;
+
+	// DDS_HEADER flags.
+	const uint32 FlagCaps = 0x1;
+	const uint32 FlagHeight = 0x2;
+	const uint32 FlagWidth = 0x4;
+	const uint32 FlagPitch = 0x8;
+	const uint32 FlagPixelFormat = 0x1000;
+	const uint32 FlagMipMapCount = 0x20000;
+	const uint32 FlagLinearSize = 0x80000;
+	const uint32 FlagDepth = 0x800000;
+
+	// DDS_PIXELFORMAT flags.
+	const uint32 PixelFormatAlphaPixels = 0x1;
+	const uint32 PixelFormatFourCC = 0x4;
+	const uint32 PixelFormatRgb = 0x40;
+	const uint32 PixelFormatLuminance = 0x20000;
+
+	const uint32 CapsComplex = 0x8;
+	const uint32 CapsTexture = 0x1000;
+	const uint32 CapsMipMap = 0x400000;
+	const uint32 Caps2Cubemap = 0x200;
+	const uint32 Caps2AllCubeFaces = 0xFC00;
+	const uint32 Caps2Volume = 0x200000;
+
+	// DDS_HEADER_DXT10 values.
+	const uint32 ResourceDimensionTexture1D = 2;
+	const uint32 ResourceDimensionTexture2D = 3;
+	const uint32 ResourceDimensionTexture3D = 4;
+	const uint32 MiscFlagTextureCube = 0x4;
+
+	struct PixelFormat {
+		uint32 size;
+		uint32 flags;
+		uint32 fourCC;
+		uint32 rgbBitCount;
+		uint32 rBitMask;
+		uint32 gBitMask;
+		uint32 bBitMask;
+		uint32 aBitMask;
+	};
+
+	struct Header {
+		uint32 size;
+		uint32 flags;
+		uint32 height;
+		uint32 width;
+		uint32 pitchOrLinearSize;
+		uint32 depth;
+		uint32 mipMapCount;
+		uint32 reserved1[11];
+		PixelFormat pixelFormat;
+		uint32 caps;
+		uint32 caps2;
+		uint32 caps3;
+		uint32 caps4;
+		uint32 reserved2;
+	};
+
+	struct HeaderDx10 {
+		uint32 dxgiFormat;
+		uint32 resourceDimension;
+		uint32 miscFlag;
+		uint32 arraySize;
+		uint32 miscFlags2;
+	};
+
+	/// Layout of TextureBaker's record within Header::reserved1.
+	struct BakeRecord {
+		uint32 magic;
+		uint32 version;
+		uint32 words[8];
+	};
+
+	static_assert(sizeof(Header) == 124, "DDS_HEADER must be 124 bytes.");
+	static_assert(sizeof(HeaderDx10) == 20, "DDS_HEADER_DXT10 must be 20 bytes.");
+	static_assert(sizeof(BakeRecord) <= sizeof(Header::reserved1),
+		"BakeRecord must fit in DDS_HEADER::reserved1.");
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint32 makeFourCC (
+	char a,
+	char b,
+	char c,
+	char d
+) {
+	return uint32(byte(a)) | (uint32(byte(b)) << 8) | (uint32(byte(c)) << 16) |
+		(uint32(byte(d)) << 24);
+}
+
+//---------------------------------------------------------------------------------------
+// DXGI format of a legacy DDS_PIXELFORMAT, or 0 if there is none.
+static uint32 legacyDxgiFormat (
+	const PixelFormat & pixelFormat
+) {
+	using namespace DdsFile;
+
+	if (pixelFormat.flags & PixelFormatFourCC) {
+		const uint32 fourCC = pixelFormat.fourCC;
+		if (fourCC == makeFourCC('D', 'X', 'T', '1')) return DxgiFormat::BC1_UNORM;
+		if (fourCC == makeFourCC('D', 'X', 'T', '2')) return DxgiFormat::BC2_UNORM;
+		if (fourCC == makeFourCC('D', 'X', 'T', '3')) return DxgiFormat::BC2_UNORM;
+		if (fourCC == makeFourCC('D', 'X', 'T', '4')) return DxgiFormat::BC3_UNORM;
+		if (fourCC == makeFourCC('D', 'X', 'T', '5')) return DxgiFormat::BC3_UNORM;
+		if (fourCC == makeFourCC('A', 'T', 'I', '1')) return DxgiFormat::BC4_UNORM;
+		if (fourCC == makeFourCC('B', 'C', '4', 'U')) return DxgiFormat::BC4_UNORM;
+		if (fourCC == makeFourCC('A', 'T', 'I', '2')) return DxgiFormat::BC5_UNORM;
+		if (fourCC == makeFourCC('B', 'C', '5', 'U')) return DxgiFormat::BC5_UNORM;
+
+		// D3DFORMAT values stored as FourCCs.
+		if (fourCC == 113) return DxgiFormat::R16G16B16A16_FLOAT;
+		if (fourCC == 116) return DxgiFormat::R32G32B32A32_FLOAT;
+		return 0;
+	}
+
+	const uint32 bitCount = pixelFormat.rgbBitCount;
+	if ((pixelFormat.flags & PixelFormatRgb) && bitCount == 32) {
+		const uint32 aBitMask = (pixelFormat.flags & PixelFormatAlphaPixels) ?
+			pixelFormat.aBitMask : 0xFF000000;
+		if (pixelFormat.rBitMask == 0x000000FF && pixelFormat.gBitMask == 0x0000FF00 &&
+			pixelFormat.bBitMask == 0x00FF0000 && aBitMask == 0xFF000000)
+		{
+			return DxgiFormat::R8G8B8A8_UNORM;
+		}
+		if (pixelFormat.rBitMask == 0x00FF0000 && pixelFormat.gBitMask == 0x0000FF00 &&
+			pixelFormat.bBitMask == 0x000000FF && aBitMask == 0xFF000000)
+		{
+			return DxgiFormat::B8G8R8A8_UNORM;
+		}
+	}
+	if ((pixelFormat.flags & (PixelFormatRgb | PixelFormatLuminance)) && bitCount == 8 &&
+		pixelFormat.rBitMask == 0xFF)
+	{
+		return DxgiFormat::R8_UNORM;
+	}
+	return 0;
+}
+
+//---------------------------------------------------------------------------------------
+bool DdsFile::getFormatInfo (
+	uint32 dxgiFormat,
+	FormatInfo & info
+) {
+	switch (dxgiFormat) {
+		case DxgiFormat::R32G32B32A32_FLOAT:
+			info = { 1, 16 };
+			return true;
+		case DxgiFormat::R16G16B16A16_FLOAT:
+			info = { 1, 8 };
+			return true;
+		case DxgiFormat::R8G8B8A8_UNORM:
+		case DxgiFormat::R8G8B8A8_UNORM_SRGB:
+		case DxgiFormat::B8G8R8A8_UNORM:
+		case DxgiFormat::B8G8R8A8_UNORM_SRGB:
+			info = { 1, 4 };
+			return true;
+		case DxgiFormat::R8G8_UNORM:
+			info = { 1, 2 };
+			return true;
+		case DxgiFormat::R8_UNORM:
+			info = { 1, 1 };
+			return true;
+		case DxgiFormat::BC1_UNORM:
+		case DxgiFormat::BC1_UNORM_SRGB:
+		case DxgiFormat::BC4_UNORM:
+			info = { 4, 8 };
+			return true;
+		case DxgiFormat::BC2_UNORM:
+		case DxgiFormat::BC2_UNORM_SRGB:
+		case DxgiFormat::BC3_UNORM:
+		case DxgiFormat::BC3_UNORM_SRGB:
+		case DxgiFormat::BC5_UNORM:
+		case DxgiFormat::BC7_UNORM:
+		case DxgiFormat::BC7_UNORM_SRGB:
+			info = { 4, 16 };
+			return true;
+		default:
+			return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+DdsFile::Subresource DdsFile::subresourceLayout (
+	const Description & description,
+	uint mipLevel
+) {
+	FormatInfo formatInfo;
+	if (!getFormatInfo(description.dxgiFormat, formatInfo)) {
+		throw std::runtime_error("Unsupported DDS format " +
+			std::to_string(description.dxgiFormat));
+	}
+
+	Subresource layout;
+	layout.data = nullptr;
+	layout.width = (description.width >> mipLevel) > 0 ? (description.width >> mipLevel) : 1;
+	layout.height = (description.height >> mipLevel) > 0 ? (description.height >> mipLevel) : 1;
+	layout.rowBytes = size_t((layout.width + formatInfo.blockSize - 1) / formatInfo.blockSize) *
+		formatInfo.blockBytes;
+	layout.rowPitch = layout.rowBytes;
+	layout.numRows = (layout.height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+	return layout;
+}
+
+//---------------------------------------------------------------------------------------
+static void writeBytes (
+	FILE * file,
+	const void * data,
+	size_t numBytes
+) {
+	if (numBytes > 0 && fwrite(data, 1, numBytes, file) != numBytes) {
+		throw std::runtime_error("Failed writing DDS file.");
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void DdsFile::write (
+	const char * path,
+	const Description & description,
+	const Subresource * subresources,
+	const BakeInfo * bakeInfo
+) {
+	FormatInfo formatInfo;
+	if (!getFormatInfo(description.dxgiFormat, formatInfo)) {
+		throw std::runtime_error("Unsupported DDS format " +
+			std::to_string(description.dxgiFormat));
+	}
+	if (description.isCubemap && description.arraySize % 6 != 0) {
+		throw std::runtime_error("Cubemap array size must be a multiple of 6.");
+	}
+	if (description.isCubemap && description.width != description.height) {
+		throw std::runtime_error("Cubemap faces must be square.");
+	}
+
+	const bool isBlockCompressed = formatInfo.blockSize > 1;
+	const Subresource topLevel = subresourceLayout(description, 0);
+
+	Header header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(Header);
+	header.flags = FlagCaps | FlagHeight | FlagWidth | FlagPixelFormat | FlagMipMapCount |
+		(isBlockCompressed ? FlagLinearSize : FlagPitch);
+	header.height = description.height;
+	header.width = description.width;
+	header.pitchOrLinearSize = uint32(isBlockCompressed ?
+		topLevel.rowBytes * topLevel.numRows : topLevel.rowBytes);
+	header.mipMapCount = description.numMipLevels;
+	header.pixelFormat.size = sizeof(PixelFormat);
+	header.pixelFormat.flags = PixelFormatFourCC;
+	header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+	header.caps = CapsTexture;
+	if (description.numMipLevels > 1) {
+		header.caps |= CapsComplex | CapsMipMap;
+	}
+	if (description.arraySize > 1) {
+		header.caps |= CapsComplex;
+	}
+	if (description.isCubemap) {
+		header.caps2 = Caps2Cubemap | Caps2AllCubeFaces;
+	}
+
+	if (bakeInfo) {
+		BakeRecord record;
+		record.magic = BakeMagic;
+		record.version = BakeVersion;
+		memcpy(record.words, bakeInfo, sizeof(record.words));
+		memcpy(header.reserved1, &record, sizeof(record));
+	}
+
+	HeaderDx10 headerDx10;
+	headerDx10.dxgiFormat = description.dxgiFormat;
+	headerDx10.resourceDimension = ResourceDimensionTexture2D;
+	headerDx10.miscFlag = description.isCubemap ? MiscFlagTextureCube : 0;
+	headerDx10.arraySize = description.isCubemap ?
+		description.arraySize / 6 : description.arraySize;
+	headerDx10.miscFlags2 = 0;
+
+	// Write to a temporary file first so that an interrupted write never leaves a
+	// truncated texture behind.
+	const std::string tempPath = std::string(path) + ".tmp";
+	FILE * file = fopen(tempPath.c_str(), "wb");
+	if (!file) {
+		throw std::runtime_error("Unable to create DDS file: " + tempPath);
+	}
+
+	try {
+		writeBytes(file, &Magic, sizeof(Magic));
+		writeBytes(file, &header, sizeof(header));
+		writeBytes(file, &headerDx10, sizeof(headerDx10));
+
+		for (uint slice = 0; slice < description.arraySize; ++slice) {
+			for (uint level = 0; level < description.numMipLevels; ++level) {
+				const Subresource & subresource =
+					subresources[slice * description.numMipLevels + level];
+				const Subresource layout = subresourceLayout(description, level);
+				if (subresource.rowBytes != layout.rowBytes ||
+					subresource.numRows != layout.numRows)
+				{
+					throw std::runtime_error("DDS subresource does not match its format.");
+				}
+				for (uint row = 0; row < layout.numRows; ++row) {
+					writeBytes(file, subresource.data + row * subresource.rowPitch,
+						layout.rowBytes);
+				}
+			}
+		}
+	}
+	catch (...) {
+		fclose(file);
+		remove(tempPath.c_str());
+		throw;
+	}
+
+	if (fclose(file) != 0) {
+		remove(tempPath.c_str());
+		throw std::runtime_error("Failed writing DDS file.");
+	}
+
+	// rename() does not replace existing files on Windows.
+	remove(path);
+	if (rename(tempPath.c_str(), path) != 0) {
+		remove(tempPath.c_str());
+		throw std::runtime_error(std::string("Unable to replace DDS file: ") + path);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+MappedDds::MappedDds()
+	: m_description(),
+	  m_bakeInfo(),
+	  m_hasBakeInfo(false),
+	  m_dataSize(0)
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+bool MappedDds::open (
+	const char * path
+) {
+	close();
+
+	if (!m_file.open(path)) {
+		return false;
+	}
+
+	try {
+		parse();
+	}
+	catch (...) {
+		close();
+		throw;
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+void MappedDds::close()
+{
+	m_file.close();
+	m_description = DdsFile::Description();
+	m_hasBakeInfo = false;
+	m_dataSize = 0;
+	m_subresources.clear();
+}
+
+//---------------------------------------------------------------------------------------
+void MappedDds::parse()
+{
+	const byte * data = m_file.data();
+	const size_t size = m_file.size();
+
+	uint32 magic;
+	Header header;
+	if (size < sizeof(magic) + sizeof(header)) {
+		throw std::runtime_error("Not a DDS file.");
+	}
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+	if (magic != Magic || header.size != sizeof(Header) ||
+		header.pixelFormat.size != sizeof(PixelFormat))
+	{
+		throw std::runtime_error("Not a DDS file.");
+	}
+	size_t dataOffset = sizeof(magic) + sizeof(header);
+
+	DdsFile::Description & description = m_description;
+	description.width = header.width;
+	description.height = header.height;
+	description.numMipLevels = (header.flags & FlagMipMapCount) && header.mipMapCount > 0 ?
+		header.mipMapCount : 1;
+	description.arraySize = 1;
+	description.isCubemap = false;
+
+	if ((header.pixelFormat.flags & PixelFormatFourCC) &&
+		header.pixelFormat.fourCC == makeFourCC('D', 'X', '1', '0'))
+	{
+		HeaderDx10 headerDx10;
+		if (size < dataOffset + sizeof(headerDx10)) {
+			throw std::runtime_error("Truncated DDS file.");
+		}
+		memcpy(&headerDx10, data + dataOffset, sizeof(headerDx10));
+		dataOffset += sizeof(headerDx10);
+
+		if (headerDx10.resourceDimension == ResourceDimensionTexture1D) {
+			description.height = 1;
+		} else if (headerDx10.resourceDimension == ResourceDimensionTexture3D) {
+			throw std::runtime_error("Volume textures are not supported.");
+		} else if (headerDx10.resourceDimension != ResourceDimensionTexture2D) {
+			throw std::runtime_error("Invalid DDS resource dimension.");
+		}
+		description.dxgiFormat = headerDx10.dxgiFormat;
+		description.arraySize = headerDx10.arraySize;
+		if (headerDx10.miscFlag & MiscFlagTextureCube) {
+			// Checked before scaling, which could otherwise wrap around.
+			if (headerDx10.arraySize > MaxArraySize / 6) {
+				throw std::runtime_error("Invalid DDS dimensions.");
+			}
+			description.isCubemap = true;
+			description.arraySize *= 6;
+		}
+	} else {
+		if ((header.flags & FlagDepth) || (header.caps2 & Caps2Volume)) {
+			throw std::runtime_error("Volume textures are not supported.");
+		}
+		description.dxgiFormat = legacyDxgiFormat(header.pixelFormat);
+		if (header.caps2 & Caps2Cubemap) {
+			if ((header.caps2 & Caps2AllCubeFaces) != Caps2AllCubeFaces) {
+				throw std::runtime_error("Cubemaps with missing faces are not supported.");
+			}
+			description.isCubemap = true;
+			description.arraySize = 6;
+		}
+	}
+
+	DdsFile::FormatInfo formatInfo;
+	if (!DdsFile::getFormatInfo(description.dxgiFormat, formatInfo)) {
+		throw std::runtime_error("Unsupported DDS pixel format.");
+	}
+
+	// Limits of D3D12 2D textures, which also keep the size computations below from
+	// overflowing.  A chain never has more levels than halvings of its larger side.
+	const uint largestSide = std::max(description.width, description.height);
+	if (description.width == 0 || description.height == 0 || largestSide > MaxDimension ||
+		description.arraySize == 0 || description.arraySize > MaxArraySize ||
+		description.numMipLevels > 32 || (largestSide >> (description.numMipLevels - 1)) == 0)
+	{
+		throw std::runtime_error("Invalid DDS dimensions.");
+	}
+	if (description.isCubemap && description.width != description.height) {
+		throw std::runtime_error("Cubemap faces must be square.");
+	}
+
+	m_subresources.resize(size_t(description.arraySize) * description.numMipLevels);
+	size_t offset = dataOffset;
+	for (uint slice = 0; slice < description.arraySize; ++slice) {
+		for (uint level = 0; level < description.numMipLevels; ++level) {
+			DdsFile::Subresource layout = DdsFile::subresourceLayout(description, level);
+			const size_t subresourceBytes = layout.rowBytes * layout.numRows;
+			if (subresourceBytes > size - offset) {
+				throw std::runtime_error("Truncated DDS file.");
+			}
+			layout.data = data + offset;
+			m_subresources[slice * description.numMipLevels + level] = layout;
+			offset += subresourceBytes;
+		}
+	}
+	m_dataSize = offset - dataOffset;
+
+	BakeRecord record;
+	memcpy(&record, header.reserved1, sizeof(record));
+	m_hasBakeInfo = record.magic == BakeMagic && record.version == BakeVersion;
+	if (m_hasBakeInfo) {
+		memcpy(&m_bakeInfo, record.words, sizeof(m_bakeInfo));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+const DdsFile::Subresource & MappedDds::subresource (
+	uint mipLevel,
+	uint arraySlice
+) const {
+	assert(mipLevel < m_description.numMipLevels && arraySlice < m_description.arraySize);
+	return m_subresources[arraySlice * m_description.numMipLevels + mipLevel];
+}
@@ -0,0 +1,179 @@
+//
+// DdsFile.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/MappedFile.hpp"
+
+
+/**
+* Reading and writing of DirectDraw Surface (.dds) texture containers.
+*
+* A DDS file is a header followed by every subresource in D3D12 subresource order:
+* all mip levels of array slice 0, then of slice 1, and so on.  Rows are tightly
+* packed, and rows of block compressed formats are rows of 4x4 blocks, so each
+* subresource can be copied row by row into an upload buffer without any decoding.
+*
+* Both the DX10 extended header, with its DXGI format and array size, and the legacy
+* header's DXTn/ATIn FourCCs and 32-bit RGBA masks are read.  Legacy cubemaps are
+* read as 6 slice arrays.  Volume textures are not supported.  Files are always
+* written with the DX10 header.
+*
+* Files written by TextureBaker record the source asset they were built from in
+* the header's reserved words, which other readers ignore.
+*
+* Has no Windows dependencies, errors throw std::runtime_error.
+*/
+namespace DdsFile {
+
+	/// DXGI_FORMAT values of the formats with known layouts, matching dxgiformat.h.
+	namespace DxgiFormat {
+		const uint32 R32G32B32A32_FLOAT = 2;
+		const uint32 R16G16B16A16_FLOAT = 10;
+		const uint32 R8G8B8A8_UNORM = 28;
+		const uint32 R8G8B8A8_UNORM_SRGB = 29;
+		const uint32 R8G8_UNORM = 49;
+		const uint32 R8_UNORM = 61;
+		const uint32 BC1_UNORM = 71;
+		const uint32 BC1_UNORM_SRGB = 72;
+		const uint32 BC2_UNORM = 74;
+		const uint32 BC2_UNORM_SRGB = 75;
+		const uint32 BC3_UNORM = 77;
+		const uint32 BC3_UNORM_SRGB = 78;
+		const uint32 BC4_UNORM = 80;
+		const uint32 BC5_UNORM = 83;
+		const uint32 B8G8R8A8_UNORM = 87;
+		const uint32 B8G8R8A8_UNORM_SRGB = 91;
+		const uint32 BC7_UNORM = 98;
+		const uint32 BC7_UNORM_SRGB = 99;
+	};
+
+	struct FormatInfo {
+		/// 4 for block compressed formats, 1 otherwise.
+		uint blockSize;
+
+		/// Bytes per block, or per pixel for formats that are not block compressed.
+		uint blockBytes;
+	};
+
+	/// @return false if the layout of 'dxgiFormat' is unknown.
+	bool getFormatInfo (
+		uint32 dxgiFormat,
+		FormatInfo & info
+	);
+
+	struct Description {
+		uint width;
+		uint height;
+
+		/// Array slices, 6 per cube for cubemaps.
+		uint arraySize;
+
+		uint numMipLevels;
+		uint32 dxgiFormat;
+		bool isCubemap;
+	};
+
+	/// The source asset a baked file was built from, used to detect stale files.
+	struct BakeInfo {
+		uint64 sourceTimestamp;
+		uint64 sourceSize;
+		uint64 sourceHash;
+
+		// Hash of the settings used to bake the source.
+		uint64 settingsHash;
+	};
+
+	/// One mip level of one array slice.
+	struct Subresource {
+		const byte * data;
+
+		/// Bytes between the starts of consecutive rows.
+		size_t rowPitch;
+
+		/// Bytes of data in each row.
+		size_t rowBytes;
+
+		/// Rows of pixels, or of blocks for block compressed formats.
+		uint numRows;
+
+		uint width;
+		uint height;
+	};
+
+	/// Layout of mip level 'mipLevel' of a texture, with tightly packed rows and
+	/// 'data' left null.
+	Subresource subresourceLayout (
+		const Description & description,
+		uint mipLevel
+	);
+
+	/// Writes a texture to 'path', replacing any existing file.
+	/// @param subresources - description.arraySize * description.numMipLevels
+	/// subresources in D3D12 subresource order.  Each is written as its numRows rows of
+	/// rowBytes bytes, which must match subresourceLayout().
+	/// @param bakeInfo - recorded in the header if not null.
+	void write (
+		const char * path,
+		const Description & description,
+		const Subresource * subresources,
+		const BakeInfo * bakeInfo
+	);
+};
+
+
+/**
+* Read-only view of a DDS file.  Subresources point directly into the memory mapping,
+* so they can be copied to upload buffers without any intermediate copies.
+*/
+class MappedDds {
+public:
+	MappedDds();
+
+	/// Maps the DDS file at 'path' and parses its header.
+	/// @return false if the file could not be opened.  Throws std::runtime_error if
+	/// it is not a DDS file, is truncated or uses an unsupported layout.
+	bool open (
+		const char * path
+	);
+
+	void close();
+
+	bool isOpen() const { return m_file.isOpen(); }
+
+	const DdsFile::Description & description() const { return m_description; }
+
+	/// Information recorded by TextureBaker, or nullptr if the file has none.
+	const DdsFile::BakeInfo * bakeInfo() const {
+		return m_hasBakeInfo ? &m_bakeInfo : nullptr;
+	}
+
+	uint numSubresources() const {
+		return m_description.arraySize * m_description.numMipLevels;
+	}
+
+	/// Subresource 'mipLevel' + 'arraySlice' * numMipLevels, as D3D12 numbers them.
+	const DdsFile::Subresource & subresource (
+		uint mipLevel,
+		uint arraySlice = 0
+	) const;
+
+	/// Total bytes of subresource data.
+	size_t dataSize() const { return m_dataSize; }
+
+private:
+	MappedFile m_file;
+	DdsFile::Description m_description;
+	DdsFile::BakeInfo m_bakeInfo;
+	bool m_hasBakeInfo;
+	size_t m_dataSize;
+
+	// Indexed by D3D12 subresource index.
+	std::vector<DdsFile::Subresource> m_subresources;
+
+	void parse();
+};
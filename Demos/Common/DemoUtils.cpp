@@ -27,11 +27,15 @@ void QueryVideoMemoryInfo (
 
     LUID adapterLUID = device->GetAdapterLuid();
     
-    IDXGIAdapter3 * pDXGIAdapter3;
-    dxgiFactory->EnumAdapterByLuid(adapterLUID, IID_PPV_ARGS(&pDXGIAdapter3));
+    ComPtr<IDXGIAdapter3> dxgiAdapter3;
+    CHECK_D3D_RESULT(
+        dxgiFactory->EnumAdapterByLuid(adapterLUID, IID_PPV_ARGS(&dxgiAdapter3))
+    );
 
-    pDXGIAdapter3->QueryVideoMemoryInfo ( // Query GPU memory info
-        0, memoryGroup, &videoMemoryInfo
+    CHECK_D3D_RESULT(
+        dxgiAdapter3->QueryVideoMemoryInfo ( // Query GPU memory info
+            0, memoryGroup, &videoMemoryInfo
+        )
     );
 }
 
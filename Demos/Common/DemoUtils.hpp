@@ -161,7 +161,8 @@ void GetSolutionDir (
 );
 
 
-/// Query a D3D12Device to determine memory usage information.
+/// Query a D3D12Device to determine memory usage information.  Looks up the adapter on
+/// every call, use a DxgiMemoryAdapter to poll repeatedly.
 void QueryVideoMemoryInfo (
 	_In_ ID3D12Device * device,
 	_In_ DXGI_MEMORY_SEGMENT_GROUP memoryGroup,
@@ -0,0 +1,45 @@
+#include "pch.h"
+
+#include "DxgiMemoryAdapter.hpp"
+using Microsoft::WRL::ComPtr;
+
+
+//---------------------------------------------------------------------------------------
+DxgiMemoryAdapter::DxgiMemoryAdapter (
+	_In_ ID3D12Device * device
+) {
+	assert(device);
+
+	ComPtr<IDXGIFactory4> dxgiFactory;
+	CHECK_D3D_RESULT (
+		CreateDXGIFactory1(IID_PPV_ARGS(&dxgiFactory))
+	);
+
+	CHECK_D3D_RESULT (
+		dxgiFactory->EnumAdapterByLuid(device->GetAdapterLuid(), IID_PPV_ARGS(&m_adapter))
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void DxgiMemoryAdapter::queryMemoryInfo (
+	MemoryBudget::SegmentInfo info[uint(MemoryBudget::Segment::Count)]
+) {
+	const DXGI_MEMORY_SEGMENT_GROUP segmentGroups[] = {
+		DXGI_MEMORY_SEGMENT_GROUP_LOCAL,
+		DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL
+	};
+	static_assert(_countof(segmentGroups) == uint(MemoryBudget::Segment::Count),
+		"Segments must mirror DXGI_MEMORY_SEGMENT_GROUP");
+
+	for (uint segment = 0; segment < _countof(segmentGroups); ++segment) {
+		DXGI_QUERY_VIDEO_MEMORY_INFO videoMemoryInfo;
+		CHECK_D3D_RESULT (
+			m_adapter->QueryVideoMemoryInfo(0, segmentGroups[segment], &videoMemoryInfo)
+		);
+
+		info[segment].budget = videoMemoryInfo.Budget;
+		info[segment].currentUsage = videoMemoryInfo.CurrentUsage;
+		info[segment].availableForReservation = videoMemoryInfo.AvailableForReservation;
+		info[segment].currentReservation = videoMemoryInfo.CurrentReservation;
+	}
+}
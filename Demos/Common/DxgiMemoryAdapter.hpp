@@ -0,0 +1,29 @@
+//
+// DxgiMemoryAdapter.hpp
+//
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <dxgi1_4.h>
+
+#include "Common/MemoryBudget.hpp"
+
+
+/// MemoryBudget::Adapter querying the hardware adapter of a D3D12 device.  The
+/// IDXGIAdapter3 is looked up once, so that polling every frame is cheap.
+class DxgiMemoryAdapter : public MemoryBudget::Adapter {
+public:
+	explicit DxgiMemoryAdapter (
+		_In_ ID3D12Device * device
+	);
+
+	void queryMemoryInfo (
+		MemoryBudget::SegmentInfo info[uint(MemoryBudget::Segment::Count)]
+	) override;
+
+	IDXGIAdapter3 * getAdapter() const { return m_adapter.Get(); }
+
+private:
+	Microsoft::WRL::ComPtr<IDXGIAdapter3> m_adapter;
+};
@@ -0,0 +1,265 @@
+//
+// GpuProfiler.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+
+//---------------------------------------------------------------------------------------
+GpuProfiler::GpuProfiler (
+	const Settings & settings
+)
+	: m_settings(settings),
+	  m_frameSlots(settings.numFrameSlots),
+	  m_recordingSlot(settings.numFrameSlots),
+	  m_numResolvedFrames(0)
+{
+	if (settings.numFrameSlots == 0 || settings.maxZonesPerFrame == 0 ||
+		settings.historyLength == 0) {
+		throw std::runtime_error("GpuProfiler settings must be non-zero");
+	}
+
+	for (FrameSlot & frameSlot : m_frameSlots) {
+		frameSlot.numQueries = 0;
+		frameSlot.isPending = false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+GpuProfiler::ZoneId GpuProfiler::registerZone (
+	const char * name
+) {
+	for (ZoneId zone = 0; zone < m_zones.size(); ++zone) {
+		if (m_zones[zone].name == name) {
+			return zone;
+		}
+	}
+
+	Zone zone;
+	zone.name = name;
+	zone.historyMs.resize(m_settings.historyLength);
+	zone.nextSample = 0;
+	zone.numSamples = 0;
+	zone.frameMs = -1.0;
+	m_zones.push_back(zone);
+
+	return ZoneId(m_zones.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------
+const char * GpuProfiler::zoneName (
+	ZoneId zone
+) const {
+	assert(zone < m_zones.size());
+	return m_zones[zone].name.c_str();
+}
+
+//---------------------------------------------------------------------------------------
+void GpuProfiler::beginFrame (
+	uint frameSlot
+) {
+	assert(frameSlot < m_frameSlots.size());
+	assert(m_recordingSlot == m_frameSlots.size());
+
+	FrameSlot & slot = m_frameSlots[frameSlot];
+	slot.records.clear();
+	slot.numQueries = 0;
+	slot.isPending = false;
+
+	m_recordingSlot = frameSlot;
+	m_openRecords.clear();
+}
+
+//---------------------------------------------------------------------------------------
+uint GpuProfiler::beginZone (
+	ZoneId zone
+) {
+	assert(zone < m_zones.size());
+	assert(m_recordingSlot < m_frameSlots.size());
+
+	FrameSlot & slot = m_frameSlots[m_recordingSlot];
+
+	// Reserve the ending query too, so that every zone begun can be ended.
+	if (slot.numQueries + 2 > maxQueriesPerFrame()) {
+		return InvalidQuery;
+	}
+
+	ZoneRecord record;
+	record.zone = zone;
+	record.beginQuery = slot.numQueries;
+	record.endQuery = InvalidQuery;
+	slot.numQueries += 2;
+
+	m_openRecords.push_back(uint(slot.records.size()));
+	slot.records.push_back(record);
+
+	return m_recordingSlot * maxQueriesPerFrame() + record.beginQuery;
+}
+
+//---------------------------------------------------------------------------------------
+uint GpuProfiler::endZone (
+	ZoneId zone
+) {
+	assert(m_recordingSlot < m_frameSlots.size());
+
+	FrameSlot & slot = m_frameSlots[m_recordingSlot];
+
+	// Zones need not end in the order they began, e.g. when a zone spans command
+	// lists, so end the innermost open instance of this zone.
+	for (auto it = m_openRecords.rbegin(); it != m_openRecords.rend(); ++it) {
+		ZoneRecord & record = slot.records[*it];
+		if (record.zone != zone) {
+			continue;
+		}
+
+		// The ending query was reserved by beginZone().
+		record.endQuery = record.beginQuery + 1;
+		m_openRecords.erase(std::next(it).base());
+
+		return m_recordingSlot * maxQueriesPerFrame() + record.endQuery;
+	}
+
+	return InvalidQuery;
+}
+
+//---------------------------------------------------------------------------------------
+void GpuProfiler::endFrame (
+	uint * firstQuery,
+	uint * numQueries
+) {
+	assert(m_recordingSlot < m_frameSlots.size());
+
+	FrameSlot & slot = m_frameSlots[m_recordingSlot];
+
+	// Zones still open were never given an ending timestamp.
+	for (uint record : m_openRecords) {
+		slot.records[record].endQuery = InvalidQuery;
+	}
+	m_openRecords.clear();
+
+	slot.isPending = slot.numQueries > 0;
+
+	*firstQuery = m_recordingSlot * maxQueriesPerFrame();
+	*numQueries = slot.numQueries;
+
+	m_recordingSlot = uint(m_frameSlots.size());
+}
+
+//---------------------------------------------------------------------------------------
+bool GpuProfiler::isPending (
+	uint frameSlot
+) const {
+	assert(frameSlot < m_frameSlots.size());
+	return m_frameSlots[frameSlot].isPending;
+}
+
+//---------------------------------------------------------------------------------------
+void GpuProfiler::resolveFrame (
+	uint frameSlot,
+	const uint64 * timestamps,
+	uint64 frequency
+) {
+	assert(frameSlot < m_frameSlots.size() && frequency > 0);
+
+	FrameSlot & slot = m_frameSlots[frameSlot];
+	if (!slot.isPending) {
+		return;
+	}
+	slot.isPending = false;
+
+	const double msPerTick = 1000.0 / double(frequency);
+	for (const ZoneRecord & record : slot.records) {
+		// Skip zones never ended, and timestamps that went backwards, e.g. across a
+		// GPU clock change.
+		if (record.endQuery == InvalidQuery ||
+			timestamps[record.endQuery] < timestamps[record.beginQuery]) {
+			continue;
+		}
+
+		Zone & zone = m_zones[record.zone];
+		const double ms = double(timestamps[record.endQuery] - timestamps[record.beginQuery]) * msPerTick;
+		zone.frameMs = std::max(zone.frameMs, 0.0) + ms;
+	}
+
+	for (Zone & zone : m_zones) {
+		if (zone.frameMs < 0.0) {
+			continue;
+		}
+
+		zone.historyMs[zone.nextSample] = zone.frameMs;
+		zone.nextSample = (zone.nextSample + 1) % m_settings.historyLength;
+		zone.numSamples = std::min(zone.numSamples + 1, m_settings.historyLength);
+		zone.frameMs = -1.0;
+	}
+
+	++m_numResolvedFrames;
+}
+
+//---------------------------------------------------------------------------------------
+GpuProfiler::ZoneStatistics GpuProfiler::zoneStatistics (
+	ZoneId zone
+) const {
+	assert(zone < m_zones.size());
+
+	const Zone & zoneData = m_zones[zone];
+	ZoneStatistics statistics;
+	if (zoneData.numSamples == 0) {
+		return statistics;
+	}
+
+	statistics.minMs = zoneData.historyMs[0];
+	statistics.maxMs = zoneData.historyMs[0];
+	double sumMs = 0.0;
+	for (uint i = 0; i < zoneData.numSamples; ++i) {
+		statistics.minMs = std::min(statistics.minMs, zoneData.historyMs[i]);
+		statistics.maxMs = std::max(statistics.maxMs, zoneData.historyMs[i]);
+		sumMs += zoneData.historyMs[i];
+	}
+	statistics.avgMs = sumMs / zoneData.numSamples;
+	statistics.numSamples = zoneData.numSamples;
+
+	return statistics;
+}
+
+//---------------------------------------------------------------------------------------
+void GpuProfiler::formatStatistics (
+	std::string & text,
+	size_t maxLength
+) const {
+	bool isFirst = true;
+	for (ZoneId zone = 0; zone < m_zones.size(); ++zone) {
+		const ZoneStatistics statistics = zoneStatistics(zone);
+		if (statistics.numSamples == 0) {
+			continue;
+		}
+
+		// Zone names are unbounded, so only the times go through a fixed buffer.
+		char times[64];
+		std::snprintf(times, sizeof(times), " %.2f/%.2f/%.2f",
+			statistics.minMs, statistics.avgMs, statistics.maxMs);
+		const char * separator = isFirst ? "" : ", ";
+		const std::string & name = m_zones[zone].name;
+
+		const size_t length = strlen(separator) + name.size() + strlen(times);
+		if (text.size() + length > maxLength) {
+			const char * ellipsis = isFirst ? "..." : ", ...";
+			if (text.size() + strlen(ellipsis) <= maxLength) {
+				text += ellipsis;
+			}
+			return;
+		}
+
+		text += separator;
+		text += name;
+		text += times;
+		isFirst = false;
+	}
+}
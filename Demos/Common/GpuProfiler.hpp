@@ -0,0 +1,169 @@
+//
+// GpuProfiler.hpp
+//
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Measures the GPU time spent in named zones of each frame from pairs of timestamp
+* queries, keeping rolling statistics of the most recent frames.
+*
+* Each frame slot owns a fixed range of query indices within a single query heap.
+* While a frame is recorded, beginZone() and endZone() hand out the indices to write
+* timestamps to, and endFrame() returns the range to resolve into readback memory.
+* Once the GPU has completed the frame, typically when its frame slot is reused
+* Settings::numFrameSlots frames later, resolveFrame() consumes the timestamps
+* without stalling.  Zones may nest, and a zone entered several times in a frame
+* accumulates the time of each.
+*
+* The queries themselves are issued by D3D12GpuProfiler, this class only manages the
+* query ring and the statistics, which allows it to run on synthetic timestamps.
+*
+* Has no Windows dependencies.  Not thread-safe.
+*/
+class GpuProfiler {
+public:
+	typedef uint ZoneId;
+
+	/// Query index returned once a frame has run out of queries.
+	static const uint InvalidQuery = ~0u;
+
+	struct Settings {
+		/// Frames in flight, each with its own range of queries.
+		uint numFrameSlots = 3;
+
+		/// Zones that can be timed within a frame, each using two queries.
+		uint maxZonesPerFrame = 16;
+
+		/// Frames over which the statistics of each zone are kept.
+		uint historyLength = 64;
+	};
+
+	/// GPU time of a zone per frame, over the frames it was last entered in.
+	struct ZoneStatistics {
+		double minMs = 0.0;
+		double avgMs = 0.0;
+		double maxMs = 0.0;
+		uint numSamples = 0;
+	};
+
+	explicit GpuProfiler (
+		const Settings & settings
+	);
+
+	/// Registers a zone named 'name', returning its id.  A name registered before
+	/// returns the same id.
+	ZoneId registerZone (
+		const char * name
+	);
+
+	uint numZones() const { return uint(m_zones.size()); }
+
+	const char * zoneName (
+		ZoneId zone
+	) const;
+
+	/// Total number of queries, across all frame slots.
+	uint numQueries() const { return m_settings.numFrameSlots * maxQueriesPerFrame(); }
+
+	uint maxQueriesPerFrame() const { return 2 * m_settings.maxZonesPerFrame; }
+
+	/// Starts recording a frame into 'frameSlot', whose previous frame is discarded
+	/// unless it has been resolved.
+	void beginFrame (
+		uint frameSlot
+	);
+
+	/// Returns the query index to write the timestamp starting 'zone' to, or
+	/// InvalidQuery once the frame has run out of queries.
+	uint beginZone (
+		ZoneId zone
+	);
+
+	/// Returns the query index to write the timestamp ending the innermost entered
+	/// instance of 'zone' to, or InvalidQuery if its beginZone() was not given one.
+	uint endZone (
+		ZoneId zone
+	);
+
+	/// Ends recording the frame.  Outputs the range of queries it used, to resolve into
+	/// the readback memory of its frame slot.
+	void endFrame (
+		uint * firstQuery,
+		uint * numQueries
+	);
+
+	/// True if 'frameSlot' holds a recorded frame that has not been resolved yet.
+	bool isPending (
+		uint frameSlot
+	) const;
+
+	/// Consumes the timestamps of the frame recorded in 'frameSlot', once its GPU work
+	/// has completed.  'timestamps' holds the frame's range of queries, starting with
+	/// its first query, in ticks of 'frequency' per second.
+	void resolveFrame (
+		uint frameSlot,
+		const uint64 * timestamps,
+		uint64 frequency
+	);
+
+	/// Frames resolved so far.
+	uint64 numResolvedFrames() const { return m_numResolvedFrames; }
+
+	/// Statistics of 'zone' over the last Settings::historyLength resolved frames it
+	/// was entered in.
+	ZoneStatistics zoneStatistics (
+		ZoneId zone
+	) const;
+
+	/// Appends "name min/avg/max" in milliseconds, separated by commas, for every zone
+	/// sampled so far.  Zones that would take 'text' past 'maxLength' characters are
+	/// left out, and replaced by "..." where that fits.
+	void formatStatistics (
+		std::string & text,
+		size_t maxLength
+	) const;
+
+private:
+	struct Zone {
+		std::string name;
+
+		// Ring of the most recent per-frame times.
+		std::vector<double> historyMs;
+		uint nextSample;
+		uint numSamples;
+
+		// Time accumulated while resolving a frame, negative if not entered.
+		double frameMs;
+	};
+
+	// Zone entered within a frame, indices are relative to the frame's first query.
+	struct ZoneRecord {
+		ZoneId zone;
+		uint beginQuery;
+		uint endQuery;
+	};
+
+	struct FrameSlot {
+		std::vector<ZoneRecord> records;
+		uint numQueries;
+		bool isPending;
+	};
+
+	Settings m_settings;
+	std::vector<Zone> m_zones;
+	std::vector<FrameSlot> m_frameSlots;
+
+	// Slot of the frame being recorded, or m_frameSlots.size() in between frames.
+	uint m_recordingSlot;
+
+	// Records of zones begun but not yet ended within the recorded frame.
+	std::vector<uint> m_openRecords;
+
+	uint64 m_numResolvedFrames;
+};
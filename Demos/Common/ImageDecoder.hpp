@@ -4,29 +4,45 @@
 
 #pragma once
 
-#include <vector>
+#include <cstddef>
 
 #include "Common/BasicTypes.hpp"
+#include "Common/ImageTypes.hpp"
+#include "Common/JpegDecoder.hpp"
+#include "Common/PngDecoder.hpp"
+
+
+/**
+* Decodes PNG and JPEG images to 8-bit RGBA, see PngDecoder and JpegDecoder.  The
+* format is detected from the file contents rather than the extension.
+*
+* Loading is split in two so the destination can be allocated in between: readInfo()
+* parses only the image header, then decode() writes rows straight into caller owned
+* memory at the caller's row pitch, such as a mapped upload buffer laid out by
+* GetCopyableFootprints.  The per-format decoders and their working memory are kept
+* across calls, so decoding several images with one ImageDecoder stops allocating once
+* the largest has been seen.  Use one ImageDecoder per thread.
+*
+* Has no Windows dependencies, unsupported or malformed images throw
+* std::runtime_error.
+*/
+class ImageDecoder {
+public:
+	/// Dimensions of the image in 'fileData', from its header.
+	static ImageInfo readInfo (
+		const void * fileData,
+		size_t fileSize
+	);
 
-
-struct ImageData {
-	ImageData();
-
-	~ImageData();
-
-	int width;
-	int height;
-	size_t numBytes;
-	byte * data;
-};
-
-
-namespace ImageDecoder {
-
-	void decodeImage (
-		const std::string & path,
-		int rowAlignment,
-		ImageData * imageData
+	/// Decodes the image in 'fileData' into 'destination', which must be large enough
+	/// for the dimensions readInfo() reports.
+	void decode (
+		const void * fileData,
+		size_t fileSize,
+		const ImageDestination & destination
 	);
 
+private:
+	PngDecoder m_pngDecoder;
+	JpegDecoder m_jpegDecoder;
 };
@@ -1,28 +0,0 @@
-//
-// ImageIO.hpp
-//
-
-#pragma once
-
-#include <vector>
-
-#include "Common/BasicTypes.hpp"
-
-namespace ImageIO
-{
-	std::vector<byte> LoadImageFromFile (
-		const char * path,
-		const int rowAlignment,
-		int * width,
-		int * height
-	);
-
-	std::vector<byte> LoadImageFromMemory (
-		const void * imageData,
-		const std::size_t size,
-		const int rowAlignment,
-		int * width,
-		int * height
-	);
-
-}
\ No newline at end of file
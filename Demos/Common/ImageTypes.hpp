@@ -0,0 +1,53 @@
+//
+// ImageTypes.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+
+
+/// Dimensions of an encoded image, read from its header.
+struct ImageInfo {
+	uint width;
+	uint height;
+};
+
+
+/// Read-only 8-bit RGBA pixels, row y starting at data + y * rowPitch.
+struct ImageView {
+	const byte * data;
+	size_t rowPitch;
+	uint width;
+	uint height;
+};
+
+
+/**
+* Caller owned memory receiving 8-bit RGBA pixels.  Row y starts at
+* data + y * rowPitch, so rows can be padded to a GPU pitch alignment.
+*
+* The image decoders, MipGenerator and BlockCompression only write to a destination,
+* never read it back, so it may point into write-combined memory such as a mapped
+* upload heap.
+*/
+struct ImageDestination {
+	byte * data;
+
+	/// Bytes between the starts of consecutive rows, at least width * 4.
+	size_t rowPitch;
+
+	/// Bytes available from 'data'.
+	size_t size;
+
+	/// True if 'width' x 'height' RGBA pixels fit in the destination.
+	bool canHold (
+		uint width,
+		uint height
+	) const {
+		const size_t rowBytes = size_t(width) * 4;
+		return data != nullptr && height > 0 && rowPitch >= rowBytes && size >= rowBytes &&
+			(size - rowBytes) / rowPitch >= height - 1;
+	}
+};
@@ -0,0 +1,446 @@
+//
+// Inflate.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "Inflate.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+	const uint MaxCodeLength = 15;
+	const uint FastBits = 10;
+	const uint FastSize = 1 << FastBits;
+
+	const uint NumLiteralLengthSymbols = 288;
+	const uint NumDistanceSymbols = 32;
+	const uint NumCodeLengthSymbols = 19;
+	const uint EndOfBlock = 256;
+
+	// Base lengths and extra bits of length symbols 257 to 285.
+	const uint16 LengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+	const byte LengthExtraBits[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	// Base distances and extra bits of distance symbols 0 to 29.
+	const uint16 DistanceBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+	const byte DistanceExtraBits[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	// Order in which the code lengths of the code length alphabet are stored.
+	const byte CodeLengthOrder[NumCodeLengthSymbols] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+
+	/// Canonical Huffman code.
+	struct HuffmanTable {
+		// Indexed by the next FastBits of input: symbol << 4 | code length, or 0 for
+		// codes longer than FastBits.
+		uint16 fast[FastSize];
+
+		// Per code length: first code, its index into 'symbols', and the end of the
+		// range of codes left-aligned to 16 bits.
+		uint16 firstCode[MaxCodeLength + 1];
+		uint16 firstSymbol[MaxCodeLength + 1];
+		uint32 maxCode[MaxCodeLength + 2];
+
+		// Symbols sorted by code.
+		uint16 symbols[NumLiteralLengthSymbols];
+	};
+
+
+	/// Reads bits least significant first, as DEFLATE stores them.  Reading past the
+	/// end of the input yields zero bits, which isTruncated() detects afterwards.
+	class BitReader {
+	public:
+		BitReader (
+			const byte * src,
+			size_t srcSize
+		)
+			: m_src(src),
+			  m_srcSize(srcSize),
+			  m_position(0),
+			  m_bits(0),
+			  m_numBits(0)
+		{
+
+		}
+
+		void refill() {
+			while (m_numBits <= 56) {
+				const uint64 next = (m_position < m_srcSize) ? m_src[m_position] : 0;
+				m_bits |= next << m_numBits;
+				m_numBits += 8;
+				++m_position;
+			}
+		}
+
+		uint peek (
+			uint numBits
+		) {
+			if (m_numBits < numBits) {
+				refill();
+			}
+			return uint(m_bits & ((uint64(1) << numBits) - 1));
+		}
+
+		void consume (
+			uint numBits
+		) {
+			m_bits >>= numBits;
+			m_numBits -= numBits;
+		}
+
+		uint read (
+			uint numBits
+		) {
+			const uint value = peek(numBits);
+			consume(numBits);
+			return value;
+		}
+
+		void alignToByte() {
+			consume(m_numBits & 7);
+		}
+
+		// Copies whole bytes, used by stored blocks after alignToByte().
+		void readBytes (
+			byte * dst,
+			size_t numBytes
+		) {
+			for (; numBytes > 0 && m_numBits > 0; --numBytes) {
+				*dst++ = byte(read(8));
+			}
+			if (numBytes > 0) {
+				if (m_position + numBytes > m_srcSize) {
+					throw std::runtime_error("Truncated stored block");
+				}
+				memcpy(dst, m_src + m_position, numBytes);
+				m_position += numBytes;
+			}
+		}
+
+		bool isTruncated() const {
+			return m_position - m_numBits / 8 > m_srcSize;
+		}
+
+	private:
+		const byte * m_src;
+		size_t m_srcSize;
+		size_t m_position;
+		uint64 m_bits;
+		uint m_numBits;
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint reverseBits (
+	uint code,
+	uint length
+) {
+	uint reversed = 0;
+	for (uint i = 0; i < length; ++i) {
+		reversed = (reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+	return reversed;
+}
+
+//---------------------------------------------------------------------------------------
+static void buildHuffmanTable (
+	const byte * codeLengths,
+	uint numSymbols,
+	HuffmanTable & table
+) {
+	uint numCodes[MaxCodeLength + 1] = {};
+	for (uint i = 0; i < numSymbols; ++i) {
+		++numCodes[codeLengths[i]];
+	}
+	numCodes[0] = 0;
+
+	// Assign canonical codes, shorter codes first.
+	uint nextCode[MaxCodeLength + 1] = {};
+	uint code = 0;
+	uint symbolIndex = 0;
+	for (uint length = 1; length <= MaxCodeLength; ++length) {
+		nextCode[length] = code;
+		table.firstCode[length] = uint16(code);
+		table.firstSymbol[length] = uint16(symbolIndex);
+
+		code += numCodes[length];
+		if (code > (1u << length)) {
+			throw std::runtime_error("Over-subscribed Huffman code");
+		}
+		table.maxCode[length] = code << (MaxCodeLength + 1 - length);
+
+		code <<= 1;
+		symbolIndex += numCodes[length];
+	}
+	table.maxCode[MaxCodeLength + 1] = 0x10000;
+
+	memset(table.fast, 0, sizeof(table.fast));
+	for (uint symbol = 0; symbol < numSymbols; ++symbol) {
+		const uint length = codeLengths[symbol];
+		if (length == 0) {
+			continue;
+		}
+
+		const uint symbolCode = nextCode[length]++;
+		table.symbols[symbolCode - table.firstCode[length] + table.firstSymbol[length]] =
+			uint16(symbol);
+
+		// Short codes fill every fast entry whose low bits match the reversed code.
+		if (length <= FastBits) {
+			const uint16 entry = uint16((symbol << 4) | length);
+			for (uint i = reverseBits(symbolCode, length); i < FastSize; i += 1u << length) {
+				table.fast[i] = entry;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static uint decodeSymbolSlow (
+	BitReader & reader,
+	const HuffmanTable & table
+) {
+	// Canonical codes compare in bit-reversed (most significant first) order.
+	const uint code = reverseBits(reader.peek(MaxCodeLength + 1), MaxCodeLength + 1);
+
+	uint length = FastBits + 1;
+	while (length <= MaxCodeLength && code >= table.maxCode[length]) {
+		++length;
+	}
+	if (length > MaxCodeLength) {
+		throw std::runtime_error("Invalid Huffman code");
+	}
+
+	reader.consume(length);
+	const uint index = (code >> (MaxCodeLength + 1 - length)) -
+		table.firstCode[length] + table.firstSymbol[length];
+	return table.symbols[index];
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint decodeSymbol (
+	BitReader & reader,
+	const HuffmanTable & table
+) {
+	const uint entry = table.fast[reader.peek(FastBits)];
+	if (entry != 0) {
+		reader.consume(entry & 15);
+		return entry >> 4;
+	}
+	return decodeSymbolSlow(reader, table);
+}
+
+//---------------------------------------------------------------------------------------
+static void buildFixedTables (
+	HuffmanTable & literalTable,
+	HuffmanTable & distanceTable
+) {
+	byte codeLengths[NumLiteralLengthSymbols];
+	memset(codeLengths + 0, 8, 144);
+	memset(codeLengths + 144, 9, 112);
+	memset(codeLengths + 256, 7, 24);
+	memset(codeLengths + 280, 8, 8);
+	buildHuffmanTable(codeLengths, NumLiteralLengthSymbols, literalTable);
+
+	memset(codeLengths, 5, NumDistanceSymbols);
+	buildHuffmanTable(codeLengths, NumDistanceSymbols, distanceTable);
+}
+
+//---------------------------------------------------------------------------------------
+static void readDynamicTables (
+	BitReader & reader,
+	HuffmanTable & literalTable,
+	HuffmanTable & distanceTable
+) {
+	const uint numLiteralCodes = reader.read(5) + 257;
+	const uint numDistanceCodes = reader.read(5) + 1;
+	const uint numCodeLengthCodes = reader.read(4) + 4;
+
+	byte codeLengthLengths[NumCodeLengthSymbols] = {};
+	for (uint i = 0; i < numCodeLengthCodes; ++i) {
+		codeLengthLengths[CodeLengthOrder[i]] = byte(reader.read(3));
+	}
+
+	HuffmanTable codeLengthTable;
+	buildHuffmanTable(codeLengthLengths, NumCodeLengthSymbols, codeLengthTable);
+
+	// Literal and distance code lengths form one run-length coded sequence.
+	byte codeLengths[NumLiteralLengthSymbols + NumDistanceSymbols] = {};
+	const uint numCodes = numLiteralCodes + numDistanceCodes;
+	uint i = 0;
+	while (i < numCodes) {
+		const uint symbol = decodeSymbol(reader, codeLengthTable);
+		if (symbol < 16) {
+			codeLengths[i++] = byte(symbol);
+			continue;
+		}
+
+		byte repeatedLength = 0;
+		uint count;
+		if (symbol == 16) {
+			if (i == 0) {
+				throw std::runtime_error("Code length repeat without a previous length");
+			}
+			repeatedLength = codeLengths[i - 1];
+			count = 3 + reader.read(2);
+		} else if (symbol == 17) {
+			count = 3 + reader.read(3);
+		} else {
+			count = 11 + reader.read(7);
+		}
+
+		if (i + count > numCodes) {
+			throw std::runtime_error("Code lengths overflow");
+		}
+		memset(codeLengths + i, repeatedLength, count);
+		i += count;
+	}
+
+	if (codeLengths[EndOfBlock] == 0) {
+		throw std::runtime_error("Missing end of block code");
+	}
+
+	buildHuffmanTable(codeLengths, numLiteralCodes, literalTable);
+	buildHuffmanTable(codeLengths + numLiteralCodes, numDistanceCodes, distanceTable);
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes one Huffman compressed block, returning the new output position.
+static size_t inflateBlock (
+	BitReader & reader,
+	const HuffmanTable & literalTable,
+	const HuffmanTable & distanceTable,
+	byte * dst,
+	size_t dstPosition,
+	size_t dstCapacity
+) {
+	for (;;) {
+		const uint symbol = decodeSymbol(reader, literalTable);
+		if (symbol < 256) {
+			if (dstPosition >= dstCapacity) {
+				throw std::runtime_error("Output exceeds expected size");
+			}
+			dst[dstPosition++] = byte(symbol);
+			continue;
+		}
+		if (symbol == EndOfBlock) {
+			return dstPosition;
+		}
+
+		const uint lengthCode = symbol - 257;
+		if (lengthCode >= 29) {
+			throw std::runtime_error("Invalid length symbol");
+		}
+		const size_t length = LengthBase[lengthCode] + reader.read(LengthExtraBits[lengthCode]);
+
+		const uint distanceCode = decodeSymbol(reader, distanceTable);
+		if (distanceCode >= 30) {
+			throw std::runtime_error("Invalid distance symbol");
+		}
+		const size_t distance =
+			DistanceBase[distanceCode] + reader.read(DistanceExtraBits[distanceCode]);
+
+		if (distance > dstPosition) {
+			throw std::runtime_error("Distance reaches before start of output");
+		}
+		if (length > dstCapacity - dstPosition) {
+			throw std::runtime_error("Output exceeds expected size");
+		}
+
+		byte * out = dst + dstPosition;
+		const byte * match = out - distance;
+		if (distance >= length) {
+			memcpy(out, match, length);
+		} else if (distance == 1) {
+			memset(out, *match, length);
+		} else {
+			// Overlapping match repeats the last 'distance' bytes.
+			for (size_t i = 0; i < length; ++i) {
+				out[i] = match[i];
+			}
+		}
+		dstPosition += length;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+size_t Inflate::decompressZlib (
+	const byte * src,
+	size_t srcSize,
+	byte * dst,
+	size_t dstCapacity
+) {
+	if (srcSize < 2) {
+		throw std::runtime_error("Truncated zlib header");
+	}
+
+	const uint compressionMethod = src[0] & 15;
+	const uint header = (uint(src[0]) << 8) | src[1];
+	if (compressionMethod != 8 || header % 31 != 0) {
+		throw std::runtime_error("Invalid zlib header");
+	}
+	if (src[1] & 0x20) {
+		throw std::runtime_error("Preset zlib dictionaries are not supported");
+	}
+
+	BitReader reader(src + 2, srcSize - 2);
+	HuffmanTable literalTable;
+	HuffmanTable distanceTable;
+	size_t dstPosition = 0;
+
+	bool isFinalBlock = false;
+	while (!isFinalBlock) {
+		isFinalBlock = reader.read(1) != 0;
+		const uint blockType = reader.read(2);
+
+		if (blockType == 0) {
+			reader.alignToByte();
+			const uint length = reader.read(16);
+			const uint lengthComplement = reader.read(16);
+			if ((length ^ 0xffff) != lengthComplement) {
+				throw std::runtime_error("Corrupt stored block length");
+			}
+			if (length > dstCapacity - dstPosition) {
+				throw std::runtime_error("Output exceeds expected size");
+			}
+			reader.readBytes(dst + dstPosition, length);
+			dstPosition += length;
+		} else if (blockType == 1) {
+			buildFixedTables(literalTable, distanceTable);
+			dstPosition = inflateBlock (
+				reader, literalTable, distanceTable, dst, dstPosition, dstCapacity
+			);
+		} else if (blockType == 2) {
+			readDynamicTables(reader, literalTable, distanceTable);
+			dstPosition = inflateBlock (
+				reader, literalTable, distanceTable, dst, dstPosition, dstCapacity
+			);
+		} else {
+			throw std::runtime_error("Invalid block type");
+		}
+
+		if (reader.isTruncated()) {
+			throw std::runtime_error("Truncated deflate stream");
+		}
+	}
+
+	return dstPosition;
+}
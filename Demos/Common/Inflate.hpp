@@ -0,0 +1,33 @@
+//
+// Inflate.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Decompressor for DEFLATE streams (RFC 1951) wrapped in a zlib container (RFC 1950),
+* as stored in PNG IDAT chunks.
+*
+* Decompresses straight into a caller-owned buffer whose size is known up front, as it
+* is for PNG scanlines.  Huffman codes are resolved through a table indexed by the
+* next 10 bits, falling back to a canonical code search for longer codes.  The Adler-32
+* checksum is not verified.
+*
+* Has no Windows dependencies, malformed or truncated streams throw std::runtime_error.
+*/
+namespace Inflate {
+
+	/// Decompresses the zlib stream 'src' into 'dst'.  Throws if the output would
+	/// exceed 'dstCapacity'.
+	/// @return number of bytes written to 'dst'.
+	size_t decompressZlib (
+		const byte * src,
+		size_t srcSize,
+		byte * dst,
+		size_t dstCapacity
+	);
+};
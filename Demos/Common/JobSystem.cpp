@@ -0,0 +1,198 @@
+//
+// JobSystem.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "JobSystem.hpp"
+
+#include <cassert>
+
+
+namespace {
+
+	// Queue owned by the current thread, if it is a worker.
+	thread_local const JobSystem * t_ownerJobSystem = nullptr;
+	thread_local uint t_queueIndex = 0;
+}
+
+//---------------------------------------------------------------------------------------
+uint JobSystem::defaultNumWorkerThreads()
+{
+	const uint numHardwareThreads = std::thread::hardware_concurrency();
+	return numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+}
+
+//---------------------------------------------------------------------------------------
+JobSystem::JobSystem (
+	uint numWorkerThreads
+)
+	: m_numQueuedJobs(0),
+	  m_nextQueue(0),
+	  m_isShuttingDown(false)
+{
+	if (numWorkerThreads == 0) {
+		numWorkerThreads = defaultNumWorkerThreads();
+	}
+
+	for (uint i = 0; i < numWorkerThreads; ++i) {
+		m_queues.emplace_back(new WorkQueue());
+	}
+
+	// Queues must all exist before any worker starts stealing from them.
+	for (uint i = 0; i < numWorkerThreads; ++i) {
+		m_workerThreads.emplace_back(&JobSystem::workerMain, this, i);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_isShuttingDown = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread & thread : m_workerThreads) {
+		thread.join();
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void JobSystem::workerMain (
+	uint queueIndex
+) {
+	t_ownerJobSystem = this;
+	t_queueIndex = queueIndex;
+
+	for (;;) {
+		QueuedJob queuedJob;
+		if (tryTakeJob(queueIndex, queuedJob)) {
+			runJob(queuedJob);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.wait(lock, [this]() {
+			return m_isShuttingDown || m_numQueuedJobs.load(std::memory_order_acquire) > 0;
+		});
+		if (m_isShuttingDown && m_numQueuedJobs.load(std::memory_order_acquire) == 0) {
+			break;
+		}
+	}
+
+	t_ownerJobSystem = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+JobSystem::Handle JobSystem::submit (
+	Job job
+) {
+	Handle handle;
+	submit(std::move(job), handle);
+	return handle;
+}
+
+//---------------------------------------------------------------------------------------
+void JobSystem::submit (
+	Job job,
+	Handle & handle
+) {
+	// Once shutting down, only the jobs still being run may submit more.
+	assert(!m_isShuttingDown || t_ownerJobSystem == this);
+
+	if (!handle.m_numPendingJobs) {
+		handle.m_numPendingJobs = std::make_shared<std::atomic<uint32>>(0);
+	}
+	handle.m_numPendingJobs->fetch_add(1, std::memory_order_relaxed);
+
+	QueuedJob queuedJob;
+	queuedJob.job = std::move(job);
+	queuedJob.numPendingJobs = handle.m_numPendingJobs;
+	pushJob(std::move(queuedJob));
+}
+
+//---------------------------------------------------------------------------------------
+void JobSystem::pushJob (
+	QueuedJob && queuedJob
+) {
+	const uint numQueues = uint(m_queues.size());
+	const uint queueIndex = (t_ownerJobSystem == this) ?
+		t_queueIndex : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % numQueues;
+
+	{
+		WorkQueue & queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(queuedJob));
+	}
+	m_numQueuedJobs.fetch_add(1, std::memory_order_release);
+
+	// Taking the lock orders the notification after any worker that just found no
+	// work has started waiting, so the wake up cannot be lost.
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+
+//---------------------------------------------------------------------------------------
+bool JobSystem::tryTakeJob (
+	uint queueIndex,
+	QueuedJob & queuedJob
+) {
+	if (m_numQueuedJobs.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	const uint numQueues = uint(m_queues.size());
+
+	for (uint i = 0; i < numQueues; ++i) {
+		const uint index = (queueIndex + i) % numQueues;
+		WorkQueue & queue = *m_queues[index];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty()) {
+			continue;
+		}
+
+		if (i == 0) {
+			// Own queue, newest job first.
+			queuedJob = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		} else {
+			// Steal the oldest job.
+			queuedJob = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		m_numQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------------------
+void JobSystem::runJob (
+	QueuedJob & queuedJob
+) {
+	queuedJob.job();
+	queuedJob.numPendingJobs->fetch_sub(1, std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------------------
+void JobSystem::wait (
+	const Handle & handle
+) {
+	const uint queueIndex = (t_ownerJobSystem == this) ? t_queueIndex :
+		m_nextQueue.load(std::memory_order_relaxed) % uint(m_queues.size());
+
+	while (!handle.isComplete()) {
+		QueuedJob queuedJob;
+		if (tryTakeJob(queueIndex, queuedJob)) {
+			runJob(queuedJob);
+		} else {
+			// Remaining jobs are running on other threads.
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,126 @@
+//
+// JobSystem.hpp
+//
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Work-stealing job system backed by a fixed pool of worker threads.
+*
+* Each worker owns a queue.  Jobs submitted from a worker go to the back of its own
+* queue and are taken LIFO, for cache locality, while idle workers steal from the
+* front of other queues.  Jobs submitted from other threads are spread across the
+* worker queues round-robin.
+*
+* submit() returns a Handle which can track several jobs.  Threads waiting on a Handle
+* run queued jobs themselves until it completes, so waiting from within a job cannot
+* deadlock the pool.  Jobs must not throw.
+*
+* Has no Windows dependencies.
+*/
+class JobSystem {
+public:
+	typedef std::function<void()> Job;
+
+	/// Completion handle for one or more jobs.  Copies refer to the same jobs.
+	class Handle {
+	public:
+		/// True once every job submitted with this handle has finished.  A default
+		/// constructed Handle is always complete.
+		bool isComplete() const {
+			return !m_numPendingJobs || m_numPendingJobs->load(std::memory_order_acquire) == 0;
+		}
+
+	private:
+		friend class JobSystem;
+
+		std::shared_ptr<std::atomic<uint32>> m_numPendingJobs;
+	};
+
+	/// @param numWorkerThreads - 0 selects defaultNumWorkerThreads().
+	explicit JobSystem (
+		uint numWorkerThreads = 0
+	);
+
+	/// Runs all queued jobs to completion, along with any jobs they submit, then joins
+	/// the workers.
+	~JobSystem();
+
+	/// Queues 'job', returning a handle to wait on it with.
+	Handle submit (
+		Job job
+	);
+
+	/// Queues 'job' as part of the jobs tracked by 'handle'.
+	void submit (
+		Job job,
+		Handle & handle
+	);
+
+	/// Blocks until every job tracked by 'handle' has finished, running queued jobs on
+	/// the calling thread in the meantime.
+	void wait (
+		const Handle & handle
+	);
+
+	uint numWorkerThreads() const { return uint(m_workerThreads.size()); }
+
+	/// One worker per hardware thread, leaving one for the thread that submits jobs.
+	static uint defaultNumWorkerThreads();
+
+private:
+	struct QueuedJob {
+		Job job;
+		std::shared_ptr<std::atomic<uint32>> numPendingJobs;
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	// Non-copyable.
+	JobSystem(const JobSystem &) = delete;
+	JobSystem & operator = (const JobSystem &) = delete;
+
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::vector<std::thread> m_workerThreads;
+
+	// Jobs queued but not yet taken, used to put idle workers to sleep.
+	std::atomic<uint32> m_numQueuedJobs;
+	std::atomic<uint32> m_nextQueue;
+	std::atomic<bool> m_isShuttingDown;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+
+
+	void workerMain (
+		uint queueIndex
+	);
+
+	void pushJob (
+		QueuedJob && queuedJob
+	);
+
+	/// Takes a job from queue 'queueIndex', or steals one from another queue.
+	bool tryTakeJob (
+		uint queueIndex,
+		QueuedJob & queuedJob
+	);
+
+	void runJob (
+		QueuedJob & queuedJob
+	);
+};
@@ -0,0 +1,987 @@
+//
+// JpegDecoder.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "JpegDecoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "PixelConversion.hpp"
+
+
+namespace {
+
+	// Markers, following their 0xFF prefix.
+	const byte Marker_SOF0 = 0xC0;    // Baseline
+	const byte Marker_SOF1 = 0xC1;    // Extended sequential
+	const byte Marker_SOF2 = 0xC2;    // Progressive
+	const byte Marker_DHT = 0xC4;
+	const byte Marker_RST0 = 0xD0;
+	const byte Marker_RST7 = 0xD7;
+	const byte Marker_SOI = 0xD8;
+	const byte Marker_EOI = 0xD9;
+	const byte Marker_SOS = 0xDA;
+	const byte Marker_DQT = 0xDB;
+	const byte Marker_DRI = 0xDD;
+	const byte Marker_APP14 = 0xEE;
+
+	const uint MaxComponents = 3;
+	const uint MaxSamplingFactor = 4;
+
+	// Natural order index of each zig-zag position.  Corrupt runs can overshoot
+	// position 63, the padding sends them to the last coefficient.
+	const byte ZigZagToNatural[64 + 16] = {
+		0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+		63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63
+	};
+
+	const uint FastBits = 9;
+	const uint FastSize = 1 << FastBits;
+	const uint16 NoFastEntry = 0xffff;
+
+	/// Canonical Huffman code of a DHT segment.
+	struct HuffmanTable {
+		// Indexed by the next FastBits of input: index into 'symbols' of codes up to
+		// FastBits long, or NoFastEntry.
+		uint16 fast[FastSize];
+
+		byte symbols[256];
+		byte codeLengths[256];
+
+		// Per code length: end of the range of codes left-aligned to 16 bits, and the
+		// offset from a code to its index into 'symbols'.
+		uint32 maxCode[18];
+		int32 delta[17];
+
+		bool isDefined;
+	};
+
+	struct Component {
+		uint id;
+		uint samplingX;
+		uint samplingY;
+		uint quantTable;
+		uint dcTable;
+		uint acTable;
+		int dcPredictor;
+
+		// Samples covering whole MCUs, so blocks past the image edge have room.
+		byte * plane;
+		size_t planePitch;
+		uint numBlocksX;
+		uint numBlocksY;
+
+		// Size of the component without MCU padding, in samples.
+		uint width;
+		uint height;
+	};
+
+	struct Frame {
+		uint width;
+		uint height;
+		uint numComponents;
+		Component components[MaxComponents];
+
+		uint maxSamplingX;
+		uint maxSamplingY;
+		uint numMcusX;
+		uint numMcusY;
+	};
+
+
+	/// Reads bits most significant first from entropy coded data, removing stuffed
+	/// zero bytes.  A marker ends the data, after which zero bits are returned.
+	class EntropyReader {
+	public:
+		EntropyReader (
+			const byte * data,
+			size_t size,
+			size_t position
+		)
+			: m_data(data),
+			  m_size(size),
+			  m_position(position),
+			  m_bits(0),
+			  m_numBits(0),
+			  m_hasReachedMarker(false)
+		{
+
+		}
+
+		uint peek16() {
+			if (m_numBits < 16) {
+				refill();
+			}
+			return m_bits >> 16;
+		}
+
+		void consume (
+			uint numBits
+		) {
+			m_bits <<= numBits;
+			m_numBits -= numBits;
+		}
+
+		uint read (
+			uint numBits
+		) {
+			if (m_numBits < int(numBits)) {
+				refill();
+			}
+			const uint value = m_bits >> (32 - numBits);
+			consume(numBits);
+			return value;
+		}
+
+		/// Reads 'numBits' of a coefficient, sign extending it.
+		int receiveExtend (
+			uint numBits
+		) {
+			if (numBits == 0) {
+				return 0;
+			}
+			const int value = int(read(numBits));
+			return value < (1 << (numBits - 1)) ? value - (1 << numBits) + 1 : value;
+		}
+
+		/// Skips to the restart marker expected after a restart interval.
+		void restart() {
+			m_bits = 0;
+			m_numBits = 0;
+			m_hasReachedMarker = false;
+
+			m_position = findMarker(m_position);
+			if (m_position + 1 < m_size &&
+				m_data[m_position + 1] >= Marker_RST0 && m_data[m_position + 1] <= Marker_RST7) {
+				m_position += 2;
+			}
+		}
+
+		/// Position of the first marker at or after the data consumed so far.
+		size_t endPosition() const {
+			return findMarker(m_position);
+		}
+
+	private:
+		const byte * m_data;
+		size_t m_size;
+		size_t m_position;
+		uint32 m_bits;
+		int m_numBits;
+		bool m_hasReachedMarker;
+
+		void refill() {
+			while (m_numBits <= 24) {
+				uint next = 0;
+				if (!m_hasReachedMarker && m_position < m_size) {
+					next = m_data[m_position];
+					if (next != 0xFF) {
+						++m_position;
+					} else if (m_position + 1 < m_size && m_data[m_position + 1] == 0) {
+						m_position += 2;
+					} else {
+						m_hasReachedMarker = true;
+						next = 0;
+					}
+				}
+				m_bits |= uint32(next) << (24 - m_numBits);
+				m_numBits += 8;
+			}
+		}
+
+		size_t findMarker (
+			size_t position
+		) const {
+			while (position + 1 < m_size &&
+				!(m_data[position] == 0xFF && m_data[position + 1] != 0 && m_data[position + 1] != 0xFF)) {
+				++position;
+			}
+			return position;
+		}
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint readBigEndian16 (
+	const byte * p
+) {
+	return (uint(p[0]) << 8) | p[1];
+}
+
+//---------------------------------------------------------------------------------------
+static inline byte clampToByte (
+	int value
+) {
+	return byte(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+//---------------------------------------------------------------------------------------
+// Limits coefficients to 16 bits, as libjpeg stores them.  Only corrupt data exceeds it.
+static inline int clampCoefficient (
+	int64 value
+) {
+	return int(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+}
+
+//---------------------------------------------------------------------------------------
+// Builds 'table' from the 16 code counts and the symbols following them.
+static void buildHuffmanTable (
+	const byte counts[16],
+	const byte * symbols,
+	HuffmanTable & table
+) {
+	uint numSymbols = 0;
+	for (uint length = 1; length <= 16; ++length) {
+		for (uint i = 0; i < counts[length - 1]; ++i) {
+			table.codeLengths[numSymbols++] = byte(length);
+		}
+	}
+	memcpy(table.symbols, symbols, numSymbols);
+
+	// Assign canonical codes, shorter codes first.
+	uint16 codes[256];
+	uint code = 0;
+	uint index = 0;
+	for (uint length = 1; length <= 16; ++length) {
+		table.delta[length] = int32(index) - int32(code);
+		while (index < numSymbols && table.codeLengths[index] == length) {
+			codes[index++] = uint16(code++);
+		}
+		if (code > (1u << length)) {
+			throw std::runtime_error("Invalid Huffman table");
+		}
+		table.maxCode[length] = code << (16 - length);
+		code <<= 1;
+	}
+	table.maxCode[17] = 0xffffffff;
+
+	std::fill(table.fast, table.fast + FastSize, NoFastEntry);
+	for (uint i = 0; i < numSymbols; ++i) {
+		const uint length = table.codeLengths[i];
+		if (length <= FastBits) {
+			// Every entry that starts with the code.
+			const uint first = uint(codes[i]) << (FastBits - length);
+			std::fill(table.fast + first, table.fast + first + (1u << (FastBits - length)), uint16(i));
+		}
+	}
+
+	table.isDefined = true;
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint decodeSymbol (
+	EntropyReader & reader,
+	const HuffmanTable & table
+) {
+	const uint bits = reader.peek16();
+
+	const uint fastIndex = table.fast[bits >> (16 - FastBits)];
+	if (fastIndex != NoFastEntry) {
+		reader.consume(table.codeLengths[fastIndex]);
+		return table.symbols[fastIndex];
+	}
+
+	uint length = FastBits + 1;
+	while (bits >= table.maxCode[length]) {
+		++length;
+	}
+	if (length > 16) {
+		throw std::runtime_error("Invalid Huffman code");
+	}
+
+	reader.consume(length);
+	return table.symbols[(bits >> (16 - length)) + table.delta[length]];
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes the dequantized coefficients of one block in natural order.
+static void decodeBlock (
+	EntropyReader & reader,
+	const HuffmanTable & dcTable,
+	const HuffmanTable & acTable,
+	const uint16 quant[64],
+	int & dcPredictor,
+	int coefficients[64]
+) {
+	memset(coefficients, 0, 64 * sizeof(int));
+
+	const uint dcBits = decodeSymbol(reader, dcTable);
+	if (dcBits > 11) {
+		throw std::runtime_error("Invalid DC coefficient");
+	}
+	dcPredictor = clampCoefficient(dcPredictor + reader.receiveExtend(dcBits));
+	coefficients[0] = clampCoefficient(int64(dcPredictor) * quant[0]);
+
+	// Each AC symbol holds a run of zeros and the bit size of the next coefficient.
+	for (uint k = 1; k < 64;) {
+		const uint symbol = decodeSymbol(reader, acTable);
+		const uint run = symbol >> 4;
+		const uint size = symbol & 15;
+
+		if (size == 0) {
+			if (run != 15) {
+				break;
+			}
+			k += 16;
+			continue;
+		}
+
+		k += run;
+		if (k > 63) {
+			throw std::runtime_error("AC coefficients overflow block");
+		}
+		coefficients[ZigZagToNatural[k]] = clampCoefficient(int64(reader.receiveExtend(size)) * quant[k]);
+		++k;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Inverse DCT of a block, adapted from the accurate integer jidctint.c of the IJG.
+// Writes 8x8 level shifted samples to 'dst'.
+static void inverseDct (
+	const int coefficients[64],
+	byte * dst,
+	size_t dstPitch
+) {
+	const int ConstBits = 13;
+	const int Pass1Bits = 2;
+
+	const int Fix_0_298631336 = 2446;
+	const int Fix_0_390180644 = 3196;
+	const int Fix_0_541196100 = 4433;
+	const int Fix_0_765366865 = 6270;
+	const int Fix_0_899976223 = 7373;
+	const int Fix_1_175875602 = 9633;
+	const int Fix_1_501321110 = 12299;
+	const int Fix_1_847759065 = 15137;
+	const int Fix_1_961570560 = 16069;
+	const int Fix_2_053119869 = 16819;
+	const int Fix_2_562915447 = 20995;
+	const int Fix_3_072711026 = 25172;
+
+	int64 workspace[64];
+
+	// Shared butterfly of both passes, 'in' addresses coefficient 'i' at in[i * step].
+	// Accumulates in 64 bits, which is no slower and can't overflow on corrupt data.
+	auto transform = [&](const auto * in, int step, int64 out[8]) {
+		// Even part.
+		int64 z2 = in[2 * step];
+		int64 z3 = in[6 * step];
+		int64 z1 = (z2 + z3) * Fix_0_541196100;
+		int64 tmp2 = z1 - z3 * Fix_1_847759065;
+		int64 tmp3 = z1 + z2 * Fix_0_765366865;
+
+		int64 tmp0 = (in[0] + in[4 * step]) * (1 << ConstBits);
+		int64 tmp1 = (in[0] - in[4 * step]) * (1 << ConstBits);
+
+		const int64 tmp10 = tmp0 + tmp3;
+		const int64 tmp13 = tmp0 - tmp3;
+		const int64 tmp11 = tmp1 + tmp2;
+		const int64 tmp12 = tmp1 - tmp2;
+
+		// Odd part.
+		tmp0 = in[7 * step];
+		tmp1 = in[5 * step];
+		tmp2 = in[3 * step];
+		tmp3 = in[1 * step];
+
+		z1 = tmp0 + tmp3;
+		z2 = tmp1 + tmp2;
+		z3 = tmp0 + tmp2;
+		int64 z4 = tmp1 + tmp3;
+		const int64 z5 = (z3 + z4) * Fix_1_175875602;
+
+		tmp0 *= Fix_0_298631336;
+		tmp1 *= Fix_2_053119869;
+		tmp2 *= Fix_3_072711026;
+		tmp3 *= Fix_1_501321110;
+		z1 *= -Fix_0_899976223;
+		z2 *= -Fix_2_562915447;
+		z3 = z3 * -Fix_1_961570560 + z5;
+		z4 = z4 * -Fix_0_390180644 + z5;
+
+		tmp0 += z1 + z3;
+		tmp1 += z2 + z4;
+		tmp2 += z2 + z3;
+		tmp3 += z1 + z4;
+
+		out[0] = tmp10 + tmp3;
+		out[7] = tmp10 - tmp3;
+		out[1] = tmp11 + tmp2;
+		out[6] = tmp11 - tmp2;
+		out[2] = tmp12 + tmp1;
+		out[5] = tmp12 - tmp1;
+		out[3] = tmp13 + tmp0;
+		out[4] = tmp13 - tmp0;
+	};
+
+	// Columns, keeping Pass1Bits of extra precision.
+	for (int x = 0; x < 8; ++x) {
+		const int * in = coefficients + x;
+		int64 out[8];
+
+		if (!(in[8] | in[16] | in[24] | in[32] | in[40] | in[48] | in[56])) {
+			// Only DC, common after quantization.
+			const int64 dc = in[0] * (1 << Pass1Bits);
+			for (int y = 0; y < 8; ++y) {
+				workspace[y * 8 + x] = dc;
+			}
+			continue;
+		}
+
+		transform(in, 8, out);
+		const int shift = ConstBits - Pass1Bits;
+		const int round = 1 << (shift - 1);
+		for (int y = 0; y < 8; ++y) {
+			workspace[y * 8 + x] = (out[y] + round) >> shift;
+		}
+	}
+
+	// Rows, removing the scaling of both passes and the level shift.
+	const int shift = ConstBits + Pass1Bits + 3;
+	const int round = (1 << (shift - 1)) + (128 << shift);
+	for (int y = 0; y < 8; ++y) {
+		int64 out[8];
+		transform(workspace + y * 8, 1, out);
+
+		byte * dstRow = dst + y * dstPitch;
+		for (int x = 0; x < 8; ++x) {
+			dstRow[x] = clampToByte(int((out[x] + round) >> shift));
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Parses a SOF0 or SOF1 segment, allocating the component planes from 'planes'.
+static void parseFrame (
+	const byte * segment,
+	size_t length,
+	std::vector<byte> * planes,
+	Frame & frame
+) {
+	if (length < 6 || segment[0] != 8) {
+		throw std::runtime_error("Only 8-bit JPEG samples are supported");
+	}
+
+	frame.height = readBigEndian16(segment + 1);
+	frame.width = readBigEndian16(segment + 3);
+	frame.numComponents = segment[5];
+
+	if (frame.width == 0 || frame.height == 0) {
+		throw std::runtime_error("Unsupported JPEG dimensions");
+	}
+	if (frame.numComponents != 1 && frame.numComponents != 3) {
+		throw std::runtime_error("Only grayscale and YCbCr JPEG images are supported");
+	}
+	if (length < 6 + frame.numComponents * 3) {
+		throw std::runtime_error("Truncated JPEG frame header");
+	}
+
+	frame.maxSamplingX = 1;
+	frame.maxSamplingY = 1;
+	for (uint i = 0; i < frame.numComponents; ++i) {
+		const byte * p = segment + 6 + i * 3;
+		Component & component = frame.components[i];
+		component.id = p[0];
+		component.samplingX = p[1] >> 4;
+		component.samplingY = p[1] & 15;
+		component.quantTable = p[2];
+
+		if (component.samplingX == 0 || component.samplingX > MaxSamplingFactor ||
+			component.samplingY == 0 || component.samplingY > MaxSamplingFactor ||
+			component.quantTable > 3) {
+			throw std::runtime_error("Invalid JPEG component");
+		}
+		frame.maxSamplingX = std::max(frame.maxSamplingX, component.samplingX);
+		frame.maxSamplingY = std::max(frame.maxSamplingY, component.samplingY);
+	}
+
+	// Upsampling replicates samples by whole factors.
+	for (uint i = 0; i < frame.numComponents; ++i) {
+		if (frame.maxSamplingX % frame.components[i].samplingX != 0 ||
+			frame.maxSamplingY % frame.components[i].samplingY != 0) {
+			throw std::runtime_error("Unsupported JPEG chroma subsampling");
+		}
+	}
+
+	const uint mcuWidth = frame.maxSamplingX * 8;
+	const uint mcuHeight = frame.maxSamplingY * 8;
+	frame.numMcusX = (frame.width + mcuWidth - 1) / mcuWidth;
+	frame.numMcusY = (frame.height + mcuHeight - 1) / mcuHeight;
+
+	for (uint i = 0; i < frame.numComponents; ++i) {
+		Component & component = frame.components[i];
+		component.numBlocksX = frame.numMcusX * component.samplingX;
+		component.numBlocksY = frame.numMcusY * component.samplingY;
+		component.planePitch = size_t(component.numBlocksX) * 8;
+		// Zeroed, so components missing from the scans stay deterministic.
+		planes[i].assign(component.planePitch * component.numBlocksY * 8, 0);
+		component.plane = planes[i].data();
+
+		component.width =
+			(frame.width * component.samplingX + frame.maxSamplingX - 1) / frame.maxSamplingX;
+		component.height =
+			(frame.height * component.samplingY + frame.maxSamplingY - 1) / frame.maxSamplingY;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes the entropy coded data of a scan starting at 'position'.
+// @return position of the marker ending the scan.
+static size_t decodeScan (
+	const byte * fileData,
+	size_t fileSize,
+	size_t position,
+	const byte * scanHeader,
+	size_t headerLength,
+	Frame & frame,
+	const HuffmanTable dcTables[4],
+	const HuffmanTable acTables[4],
+	const uint16 quantTables[4][64],
+	uint restartInterval
+) {
+	const uint numScanComponents = scanHeader[0];
+	if (numScanComponents == 0 || numScanComponents > frame.numComponents ||
+		headerLength < 4 + numScanComponents * 2) {
+		throw std::runtime_error("Invalid JPEG scan header");
+	}
+
+	Component * scanComponents[MaxComponents];
+	for (uint i = 0; i < numScanComponents; ++i) {
+		const uint id = scanHeader[1 + i * 2];
+		const uint tables = scanHeader[2 + i * 2];
+
+		Component * component = nullptr;
+		for (uint c = 0; c < frame.numComponents; ++c) {
+			if (frame.components[c].id == id) {
+				component = &frame.components[c];
+			}
+		}
+		if (!component) {
+			throw std::runtime_error("JPEG scan references unknown component");
+		}
+
+		component->dcTable = tables >> 4;
+		component->acTable = tables & 15;
+		if (component->dcTable > 3 || component->acTable > 3 ||
+			!dcTables[component->dcTable].isDefined || !acTables[component->acTable].isDefined) {
+			throw std::runtime_error("JPEG scan references undefined Huffman table");
+		}
+		component->dcPredictor = 0;
+		scanComponents[i] = component;
+	}
+
+	EntropyReader reader(fileData, fileSize, position);
+	int coefficients[64];
+
+	auto decodeComponentBlock = [&](Component & component, uint blockX, uint blockY) {
+		decodeBlock (
+			reader, dcTables[component.dcTable], acTables[component.acTable],
+			quantTables[component.quantTable], component.dcPredictor, coefficients
+		);
+		inverseDct (
+			coefficients,
+			component.plane + blockY * 8 * component.planePitch + blockX * 8,
+			component.planePitch
+		);
+	};
+
+	// Resets the predictors and the reader after every 'restartInterval' MCUs.
+	uint numUntilRestart = restartInterval;
+	auto countMcu = [&]() {
+		if (restartInterval == 0 || --numUntilRestart > 0) {
+			return;
+		}
+		reader.restart();
+		for (uint i = 0; i < numScanComponents; ++i) {
+			scanComponents[i]->dcPredictor = 0;
+		}
+		numUntilRestart = restartInterval;
+	};
+
+	if (numScanComponents == 1) {
+		// Non-interleaved scans hold just the blocks covering the component, one per MCU.
+		Component & component = *scanComponents[0];
+		const uint numBlocksX = (component.width + 7) / 8;
+		const uint numBlocksY = (component.height + 7) / 8;
+		for (uint blockY = 0; blockY < numBlocksY; ++blockY) {
+			for (uint blockX = 0; blockX < numBlocksX; ++blockX) {
+				decodeComponentBlock(component, blockX, blockY);
+				countMcu();
+			}
+		}
+	} else {
+		for (uint mcuY = 0; mcuY < frame.numMcusY; ++mcuY) {
+			for (uint mcuX = 0; mcuX < frame.numMcusX; ++mcuX) {
+				for (uint i = 0; i < numScanComponents; ++i) {
+					Component & component = *scanComponents[i];
+					for (uint y = 0; y < component.samplingY; ++y) {
+						for (uint x = 0; x < component.samplingX; ++x) {
+							decodeComponentBlock (
+								component,
+								mcuX * component.samplingX + x,
+								mcuY * component.samplingY + y
+							);
+						}
+					}
+				}
+				countMcu();
+			}
+		}
+	}
+
+	return reader.endPosition();
+}
+
+//---------------------------------------------------------------------------------------
+// Row 'y' of 'component' at full image resolution, upsampled into 'scratch' if needed.
+// Halved dimensions use the triangle filter of libjpeg's fancy upsampling, weighting
+// the nearer sample 3:1, other factors replicate samples.  'scratch' and 'columnSums'
+// hold at least frame.width + 1 entries.
+static const byte * upsampleRow (
+	const Frame & frame,
+	const Component & component,
+	uint y,
+	byte * scratch,
+	int * columnSums
+) {
+	const uint factorX = frame.maxSamplingX / component.samplingX;
+	const uint factorY = frame.maxSamplingY / component.samplingY;
+	const uint sourceY = y / factorY;
+	const byte * row = component.plane + sourceY * component.planePitch;
+	const uint n = component.width;
+
+	if (factorY == 2) {
+		// Blend with the row above for even rows and below for odd rows, clamped to
+		// the component.
+		uint neighborY = sourceY;
+		if (y % 2 == 0 && sourceY > 0) {
+			neighborY = sourceY - 1;
+		} else if (y % 2 == 1 && sourceY + 1 < component.height) {
+			neighborY = sourceY + 1;
+		}
+		const byte * neighbor = component.plane + neighborY * component.planePitch;
+		for (uint x = 0; x < n; ++x) {
+			columnSums[x] = row[x] * 3 + neighbor[x];
+		}
+
+		if (factorX == 1) {
+			const int bias = (y % 2 == 0) ? 1 : 2;
+			for (uint x = 0; x < n; ++x) {
+				scratch[x] = byte((columnSums[x] + bias) >> 2);
+			}
+			return scratch;
+		}
+
+		if (factorX == 2) {
+			for (uint x = 0; x < n; ++x) {
+				const int sum = columnSums[x] * 3;
+				const int left = x > 0 ? columnSums[x - 1] : columnSums[x];
+				const int right = x + 1 < n ? columnSums[x + 1] : columnSums[x];
+				scratch[x * 2 + 0] = byte((sum + left + 8) >> 4);
+				scratch[x * 2 + 1] = byte((sum + right + 7) >> 4);
+			}
+			return scratch;
+		}
+	}
+
+	if (factorX == 1 && factorY == 1) {
+		return row;
+	}
+
+	if (factorX == 2 && factorY == 1) {
+		for (uint x = 0; x < n; ++x) {
+			const int sum = row[x] * 3;
+			const int left = x > 0 ? row[x - 1] : row[x];
+			const int right = x + 1 < n ? row[x + 1] : row[x];
+			scratch[x * 2 + 0] = byte((sum + left + 1) >> 2);
+			scratch[x * 2 + 1] = byte((sum + right + 2) >> 2);
+		}
+		return scratch;
+	}
+
+	for (uint x = 0; x < frame.width; ++x) {
+		scratch[x] = row[x / factorX];
+	}
+	return scratch;
+}
+
+//---------------------------------------------------------------------------------------
+bool JpegDecoder::isJpeg (
+	const byte * fileData,
+	size_t fileSize
+) {
+	return fileSize >= 3 && fileData[0] == 0xFF && fileData[1] == Marker_SOI && fileData[2] == 0xFF;
+}
+
+//---------------------------------------------------------------------------------------
+ImageInfo JpegDecoder::readInfo (
+	const byte * fileData,
+	size_t fileSize
+) {
+	if (!isJpeg(fileData, fileSize)) {
+		throw std::runtime_error("Not a JPEG file");
+	}
+
+	// Skip segments up to the frame header.
+	size_t position = 2;
+	for (;;) {
+		if (position + 4 > fileSize) {
+			throw std::runtime_error("Truncated JPEG file");
+		}
+		if (fileData[position] != 0xFF) {
+			throw std::runtime_error("Expected JPEG marker");
+		}
+
+		const byte marker = fileData[position + 1];
+		if (marker == 0xFF) {
+			++position;
+			continue;
+		}
+
+		const byte * segment = fileData + position + 4;
+		const size_t length = readBigEndian16(fileData + position + 2);
+		if (length < 2 || position + 2 + length > fileSize) {
+			throw std::runtime_error("Truncated JPEG segment");
+		}
+
+		switch (marker) {
+			case Marker_SOF0:
+			case Marker_SOF1: {
+				if (length < 2 + 6 || segment[0] != 8) {
+					throw std::runtime_error("Only 8-bit JPEG samples are supported");
+				}
+				ImageInfo info;
+				info.height = readBigEndian16(segment + 1);
+				info.width = readBigEndian16(segment + 3);
+				if (info.width == 0 || info.height == 0) {
+					throw std::runtime_error("Unsupported JPEG dimensions");
+				}
+				return info;
+			}
+
+			case Marker_SOF2:
+				throw std::runtime_error("Progressive JPEG images are not supported");
+
+			case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+			case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+				throw std::runtime_error("Lossless, hierarchical and arithmetic coded JPEG "
+					"images are not supported");
+
+			case Marker_SOS:
+			case Marker_EOI:
+				throw std::runtime_error("JPEG file has no frame header");
+
+			default:
+				position += 2 + length;
+				break;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void JpegDecoder::decode (
+	const byte * fileData,
+	size_t fileSize,
+	const ImageDestination & destination
+) {
+	if (!isJpeg(fileData, fileSize)) {
+		throw std::runtime_error("Not a JPEG file");
+	}
+
+	Frame frame = {};
+	bool hasFrame = false;
+	bool hasScan = false;
+	bool isRgb = false;
+
+	HuffmanTable dcTables[4] = {};
+	HuffmanTable acTables[4] = {};
+	uint16 quantTables[4][64] = {};
+	uint restartInterval = 0;
+
+	size_t position = 2;
+	for (;;) {
+		if (position + 1 >= fileSize) {
+			throw std::runtime_error("Truncated JPEG file");
+		}
+		if (fileData[position] != 0xFF) {
+			throw std::runtime_error("Expected JPEG marker");
+		}
+
+		const byte marker = fileData[position + 1];
+		if (marker == 0xFF) {
+			// Fill byte.
+			++position;
+			continue;
+		}
+		position += 2;
+
+		if (marker == Marker_EOI) {
+			break;
+		}
+		if (marker >= Marker_RST0 && marker <= Marker_RST7) {
+			continue;
+		}
+
+		if (position + 2 > fileSize) {
+			throw std::runtime_error("Truncated JPEG segment");
+		}
+		const size_t length = readBigEndian16(fileData + position);
+		if (length < 2 || position + length > fileSize) {
+			throw std::runtime_error("Truncated JPEG segment");
+		}
+		const byte * segment = fileData + position + 2;
+		const size_t segmentLength = length - 2;
+		position += length;
+
+		switch (marker) {
+			case Marker_SOF0:
+			case Marker_SOF1:
+				if (hasFrame) {
+					throw std::runtime_error("Multiple JPEG frames");
+				}
+				parseFrame(segment, segmentLength, m_planes, frame);
+				hasFrame = true;
+				break;
+
+			case Marker_SOF2:
+				throw std::runtime_error("Progressive JPEG images are not supported");
+
+			case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+			case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+				throw std::runtime_error("Lossless, hierarchical and arithmetic coded JPEG "
+					"images are not supported");
+
+			case Marker_DHT:
+				for (size_t offset = 0; offset < segmentLength;) {
+					if (segmentLength - offset < 17) {
+						throw std::runtime_error("Truncated Huffman table");
+					}
+					const uint tableClass = segment[offset] >> 4;
+					const uint tableIndex = segment[offset] & 15;
+					const byte * counts = segment + offset + 1;
+
+					uint numSymbols = 0;
+					for (uint i = 0; i < 16; ++i) {
+						numSymbols += counts[i];
+					}
+					if (tableClass > 1 || tableIndex > 3 || numSymbols > 256 ||
+						segmentLength - offset - 17 < numSymbols) {
+						throw std::runtime_error("Invalid Huffman table");
+					}
+
+					HuffmanTable & table = tableClass == 0 ? dcTables[tableIndex] : acTables[tableIndex];
+					buildHuffmanTable(counts, counts + 16, table);
+					offset += 17 + numSymbols;
+				}
+				break;
+
+			case Marker_DQT:
+				for (size_t offset = 0; offset < segmentLength;) {
+					const uint precision = segment[offset] >> 4;
+					const uint tableIndex = segment[offset] & 15;
+					const size_t tableBytes = precision ? 128 : 64;
+					if (precision > 1 || tableIndex > 3 || segmentLength - offset - 1 < tableBytes) {
+						throw std::runtime_error("Invalid quantization table");
+					}
+
+					// Values stay in zig-zag order, as coefficients are decoded.
+					const byte * values = segment + offset + 1;
+					for (uint i = 0; i < 64; ++i) {
+						quantTables[tableIndex][i] =
+							uint16(precision ? readBigEndian16(values + i * 2) : values[i]);
+					}
+					offset += 1 + tableBytes;
+				}
+				break;
+
+			case Marker_DRI:
+				if (segmentLength < 2) {
+					throw std::runtime_error("Invalid restart interval");
+				}
+				restartInterval = readBigEndian16(segment);
+				break;
+
+			case Marker_APP14:
+				// Adobe transform flag 0 marks 3 component images as RGB rather than YCbCr.
+				if (segmentLength >= 12 && memcmp(segment, "Adobe", 5) == 0) {
+					isRgb = segment[11] == 0;
+				}
+				break;
+
+			case Marker_SOS:
+				if (!hasFrame) {
+					throw std::runtime_error("JPEG scan before frame header");
+				}
+				position = decodeScan (
+					fileData, fileSize, position, segment, segmentLength,
+					frame, dcTables, acTables, quantTables, restartInterval
+				);
+
+				// Image data cut short reads as zero bits, only a following marker shows
+				// that none is missing.
+				if (position + 1 >= fileSize) {
+					throw std::runtime_error("Truncated JPEG image data");
+				}
+				hasScan = true;
+				break;
+
+			default:
+				// APPn, comments and other segments without image data.
+				break;
+		}
+	}
+
+	if (!hasScan) {
+		throw std::runtime_error("JPEG file has no image data");
+	}
+
+	if (!destination.canHold(frame.width, frame.height)) {
+		throw std::runtime_error("Image destination is too small");
+	}
+	const size_t outputPitch = destination.rowPitch;
+
+	if (frame.numComponents == 1) {
+		for (uint y = 0; y < frame.height; ++y) {
+			PixelConversion::grayToRgba (
+				frame.components[0].plane + y * frame.components[0].planePitch,
+				destination.data + y * outputPitch,
+				frame.width
+			);
+		}
+		return;
+	}
+
+	const size_t scratchSize = size_t(frame.width) + 1;
+	m_upsampledRows.resize(scratchSize * MaxComponents);
+	m_columnSums.resize(scratchSize);
+	for (uint y = 0; y < frame.height; ++y) {
+		const byte * rows[MaxComponents];
+		for (uint c = 0; c < MaxComponents; ++c) {
+			rows[c] = upsampleRow (
+				frame, frame.components[c], y, m_upsampledRows.data() + c * scratchSize,
+				m_columnSums.data()
+			);
+		}
+
+		byte * dst = destination.data + y * outputPitch;
+		if (!isRgb) {
+			PixelConversion::yCbCrToRgba(rows[0], rows[1], rows[2], dst, frame.width);
+			continue;
+		}
+
+		for (uint x = 0; x < frame.width; ++x) {
+			dst[x * 4 + 0] = rows[0][x];
+			dst[x * 4 + 1] = rows[1][x];
+			dst[x * 4 + 2] = rows[2][x];
+			dst[x * 4 + 3] = 255;
+		}
+	}
+}
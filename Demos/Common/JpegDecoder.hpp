@@ -0,0 +1,56 @@
+//
+// JpegDecoder.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/ImageTypes.hpp"
+
+
+/**
+* Decoder for sequential Huffman coded JPEG images (baseline and extended, 8-bit
+* samples), producing 8-bit RGBA.
+*
+* Supports grayscale and YCbCr images with any chroma subsampling, interleaved or
+* single component scans, and restart intervals.  Blocks are reconstructed with the
+* accurate integer IDCT of the IJG library, 2x subsampled chroma is upsampled with
+* libjpeg's triangle filter (other factors by replication), and color is converted
+* with PixelConversion::yCbCrToRgba().
+* Progressive, arithmetic coded, lossless and CMYK images are rejected.
+*
+* Working buffers are members, reused by later decodes.
+*
+* Has no Windows dependencies, unsupported or malformed images throw
+* std::runtime_error.
+*/
+class JpegDecoder {
+public:
+	/// True if 'fileData' starts with a JPEG start of image marker.
+	static bool isJpeg (
+		const byte * fileData,
+		size_t fileSize
+	);
+
+	/// Dimensions from the frame header, throws for unsupported frame types.
+	static ImageInfo readInfo (
+		const byte * fileData,
+		size_t fileSize
+	);
+
+	void decode (
+		const byte * fileData,
+		size_t fileSize,
+		const ImageDestination & destination
+	);
+
+private:
+	// Decoded samples of each component, covering whole MCUs.
+	std::vector<byte> m_planes[3];
+
+	// Upsampling temporaries, see upsampleRow() in the .cpp.
+	std::vector<byte> m_upsampledRows;
+	std::vector<int> m_columnSums;
+};
@@ -0,0 +1,152 @@
+//
+// MappedFile.cpp
+//
+// Compiled without the precompiled header, platform headers are included here only.
+//
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+	#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+//---------------------------------------------------------------------------------------
+MappedFile::MappedFile()
+	: m_data(nullptr),
+	  m_size(0),
+	  m_isOpen(false)
+#ifdef _WIN32
+	, m_fileHandle(INVALID_HANDLE_VALUE),
+	  m_mappingHandle(nullptr)
+#endif
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+//---------------------------------------------------------------------------------------
+bool MappedFile::open (
+	const char * path
+) {
+	close();
+
+	m_fileHandle = CreateFileA (
+		path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+	);
+	if (m_fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_fileHandle, &fileSize)) {
+		close();
+		return false;
+	}
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	m_isOpen = true;
+
+	if (m_size == 0) {
+		// Empty files cannot be mapped.
+		return true;
+	}
+
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mappingHandle == nullptr) {
+		close();
+		return false;
+	}
+
+	m_data = static_cast<const byte *>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+void MappedFile::close()
+{
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle) {
+		CloseHandle(m_mappingHandle);
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_fileHandle);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+	m_mappingHandle = nullptr;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+//---------------------------------------------------------------------------------------
+bool MappedFile::open (
+	const char * path
+) {
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0) {
+		::close(fd);
+		return false;
+	}
+	m_size = static_cast<size_t>(fileStat.st_size);
+	m_isOpen = true;
+
+	if (m_size > 0) {
+		void * mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			::close(fd);
+			close();
+			return false;
+		}
+		// Loaders read front to back.
+		madvise(mapping, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const byte *>(mapping);
+	}
+
+	// The mapping stays valid after the descriptor is closed.
+	::close(fd);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+void MappedFile::close()
+{
+	if (m_data) {
+		munmap(const_cast<byte *>(m_data), m_size);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+#endif
@@ -0,0 +1,47 @@
+//
+// MappedFile.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+
+/**
+* Read-only memory mapping of an entire file.  Uses file mapping objects on Windows
+* and mmap elsewhere, so loaders built on top of it stay portable.
+*/
+class MappedFile {
+public:
+	MappedFile();
+
+	~MappedFile();
+
+	/// Maps 'path' into memory, closing any previously opened file.
+	/// @return false if the file could not be opened or mapped.
+	bool open (
+		const char * path
+	);
+
+	void close();
+
+	bool isOpen() const { return m_isOpen; }
+
+	const byte * data() const { return m_data; }
+
+	size_t size() const { return m_size; }
+
+private:
+	// Non-copyable, the mapping is uniquely owned.
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator = (const MappedFile &) = delete;
+
+	const byte * m_data;
+	size_t m_size;
+	bool m_isOpen;
+
+#ifdef _WIN32
+	void * m_fileHandle;
+	void * m_mappingHandle;
+#endif
+};
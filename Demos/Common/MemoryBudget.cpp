@@ -0,0 +1,269 @@
+//
+// MemoryBudget.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "MemoryBudget.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+//---------------------------------------------------------------------------------------
+MemoryBudget::ScriptedAdapter::ScriptedAdapter (
+	const std::vector<Point> & localCurve,
+	const std::vector<Point> & nonLocalCurve
+)
+	: m_memoryBudget(nullptr),
+	  m_frame(0)
+{
+	m_curves[uint(Segment::Local)] = localCurve;
+	m_curves[uint(Segment::NonLocal)] = nonLocalCurve;
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::ScriptedAdapter::attach (
+	const MemoryBudget * memoryBudget
+) {
+	m_memoryBudget = memoryBudget;
+}
+
+//---------------------------------------------------------------------------------------
+static uint64 interpolate (
+	uint64 a,
+	uint64 b,
+	double t
+) {
+	return uint64(double(a) + (double(b) - double(a)) * t);
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::ScriptedAdapter::queryMemoryInfo (
+	SegmentInfo info[uint(Segment::Count)]
+) {
+	for (uint segment = 0; segment < uint(Segment::Count); ++segment) {
+		const std::vector<Point> & curve = m_curves[segment];
+		SegmentInfo & segmentInfo = info[segment];
+		segmentInfo = SegmentInfo();
+
+		if (curve.empty()) {
+			segmentInfo.budget = UINT64_MAX;
+		} else {
+			// First point after the current frame.
+			size_t next = 0;
+			while (next < curve.size() && curve[next].frame <= m_frame) {
+				++next;
+			}
+
+			if (next == 0 || next == curve.size()) {
+				const Point & point = curve[next == 0 ? 0 : next - 1];
+				segmentInfo.budget = point.budget;
+				segmentInfo.currentUsage = point.otherUsage;
+			} else {
+				const Point & a = curve[next - 1];
+				const Point & b = curve[next];
+				const double t = double(m_frame - a.frame) / double(b.frame - a.frame);
+				segmentInfo.budget = interpolate(a.budget, b.budget, t);
+				segmentInfo.currentUsage = interpolate(a.otherUsage, b.otherUsage, t);
+			}
+		}
+
+		if (m_memoryBudget) {
+			segmentInfo.currentUsage += m_memoryBudget->trackedBytes(Segment(segment));
+		}
+		segmentInfo.availableForReservation = segmentInfo.budget / 2;
+	}
+
+	++m_frame;
+}
+
+//---------------------------------------------------------------------------------------
+MemoryBudget::MemoryBudget (
+	Adapter * adapter,
+	const Settings & settings
+)
+	: m_adapter(adapter),
+	  m_settings(settings),
+	  m_trackedBytes(),
+	  m_evictingBytes(),
+	  m_polledTrackedBytes()
+{
+	assert(adapter);
+}
+
+//---------------------------------------------------------------------------------------
+MemoryBudget::AllocationId MemoryBudget::trackAllocation (
+	Segment segment,
+	uint64 bytes,
+	float priority,
+	Evictor * evictor,
+	uint64 context
+) {
+	AllocationId id;
+	if (m_freeAllocationIds.empty()) {
+		id = AllocationId(m_allocations.size());
+		m_allocations.emplace_back();
+	} else {
+		id = m_freeAllocationIds.back();
+		m_freeAllocationIds.pop_back();
+	}
+
+	Allocation & allocation = m_allocations[id];
+	allocation.segment = segment;
+	allocation.bytes = bytes;
+	allocation.priority = priority;
+	allocation.evictor = evictor;
+	allocation.context = context;
+	allocation.evictingBytes = 0;
+	allocation.isTracked = true;
+
+	m_trackedBytes[uint(segment)] += bytes;
+	return id;
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::resizeAllocation (
+	AllocationId id,
+	uint64 bytes
+) {
+	Allocation & allocation = m_allocations[id];
+	assert(allocation.isTracked);
+
+	const uint segment = uint(allocation.segment);
+	if (bytes < allocation.bytes) {
+		// Bytes freed settle what the evictor promised.
+		const uint64 freed = std::min(allocation.bytes - bytes, allocation.evictingBytes);
+		allocation.evictingBytes -= freed;
+		m_evictingBytes[segment] -= freed;
+	}
+
+	m_trackedBytes[segment] += bytes;
+	m_trackedBytes[segment] -= allocation.bytes;
+	allocation.bytes = bytes;
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::setPriority (
+	AllocationId id,
+	float priority
+) {
+	assert(m_allocations[id].isTracked);
+	m_allocations[id].priority = priority;
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::releaseAllocation (
+	AllocationId id
+) {
+	resizeAllocation(id, 0);
+
+	Allocation & allocation = m_allocations[id];
+	m_evictingBytes[uint(allocation.segment)] -= allocation.evictingBytes;
+	allocation.evictingBytes = 0;
+	allocation.isTracked = false;
+	m_freeAllocationIds.push_back(id);
+}
+
+//---------------------------------------------------------------------------------------
+const MemoryBudget::SegmentInfo & MemoryBudget::segmentInfo (
+	Segment segment
+) const {
+	return m_segmentInfo[uint(segment)];
+}
+
+//---------------------------------------------------------------------------------------
+uint64 MemoryBudget::trackedBytes (
+	Segment segment
+) const {
+	return m_trackedBytes[uint(segment)];
+}
+
+//---------------------------------------------------------------------------------------
+uint64 MemoryBudget::estimatedUsage (
+	Segment segment
+) const {
+	const uint index = uint(segment);
+	const int64 usage = int64(m_segmentInfo[index].currentUsage) +
+		int64(m_trackedBytes[index]) - int64(m_polledTrackedBytes[index]) -
+		int64(m_evictingBytes[index]);
+	return uint64(std::max(usage, int64(0)));
+}
+
+//---------------------------------------------------------------------------------------
+int64 MemoryBudget::headroom (
+	Segment segment
+) const {
+	const double target = double(m_segmentInfo[uint(segment)].budget) * m_settings.targetUsage;
+	return int64(std::min(target, double(INT64_MAX / 2))) - int64(estimatedUsage(segment));
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::evict (
+	Segment segment,
+	uint64 bytesNeeded
+) {
+	// Evictable allocations of the segment, lowest priority first.
+	m_candidates.clear();
+	for (AllocationId id = 0; id < m_allocations.size(); ++id) {
+		const Allocation & allocation = m_allocations[id];
+		if (allocation.isTracked && allocation.segment == segment && allocation.evictor &&
+			allocation.bytes > allocation.evictingBytes)
+		{
+			m_candidates.push_back(id);
+		}
+	}
+	std::stable_sort(m_candidates.begin(), m_candidates.end(),
+		[this](AllocationId a, AllocationId b) {
+			return m_allocations[a].priority < m_allocations[b].priority;
+		}
+	);
+
+	uint64 bytesEvicted = 0;
+	for (AllocationId id : m_candidates) {
+		if (bytesEvicted >= bytesNeeded) {
+			break;
+		}
+
+		Allocation & allocation = m_allocations[id];
+		const uint64 bytes = allocation.evictor->evict (
+			id, allocation.context, bytesNeeded - bytesEvicted
+		);
+		if (bytes > 0) {
+			// The evictor may have resized the allocation, so look it up again.
+			Allocation & evicted = m_allocations[id];
+			evicted.evictingBytes += bytes;
+			m_evictingBytes[uint(segment)] += bytes;
+			bytesEvicted += bytes;
+			++m_statistics.numEvictions;
+		}
+	}
+	m_statistics.evictedBytes += bytesEvicted;
+}
+
+//---------------------------------------------------------------------------------------
+void MemoryBudget::update()
+{
+	m_adapter->queryMemoryInfo(m_segmentInfo);
+	std::copy(m_trackedBytes, m_trackedBytes + uint(Segment::Count), m_polledTrackedBytes);
+
+	bool isOverBudget = false;
+	for (uint index = 0; index < uint(Segment::Count); ++index) {
+		const Segment segment = Segment(index);
+		const SegmentInfo & info = m_segmentInfo[index];
+
+		m_statistics.peakUsage[index] = std::max(m_statistics.peakUsage[index], info.currentUsage);
+		isOverBudget |= info.currentUsage > info.budget;
+
+		// Evict down to the target, so that usage hovering around the threshold
+		// doesn't evict a little every frame.
+		const uint64 usage = estimatedUsage(segment);
+		if (double(usage) > double(info.budget) * m_settings.evictionThreshold) {
+			const uint64 target = uint64(double(info.budget) * m_settings.targetUsage);
+			evict(segment, usage - target);
+		}
+	}
+
+	if (isOverBudget) {
+		++m_statistics.numUpdatesOverBudget;
+	}
+}
@@ -0,0 +1,223 @@
+//
+// MemoryBudget.hpp
+//
+#pragma once
+
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Keeps GPU memory usage within the budget the OS grants the process.
+*
+* Every update() polls an Adapter for the budget and current usage of each memory
+* segment, as reported by IDXGIAdapter3::QueryVideoMemoryInfo.  Allocations the
+* demos make, e.g. textures and upload buffers, are tracked with a priority, which
+* keeps the usage estimate current between polls.  Once the usage of a segment
+* crosses Settings::evictionThreshold of its budget, the Evictors of its lowest
+* priority allocations are asked to free memory, e.g. by demoting a texture to
+* coarser mips, until usage would fall to Settings::targetUsage.  Clients that grow
+* on their own, such as texture streaming, should stay within headroom().
+*
+* Adapters other than the hardware one can be substituted, e.g. a ScriptedAdapter
+* whose budget follows a fixed curve, which allows the policy to run without a GPU.
+*
+* Has no Windows dependencies.  Not thread-safe.
+*/
+class MemoryBudget {
+public:
+	/// Mirrors DXGI_MEMORY_SEGMENT_GROUP.
+	enum class Segment {
+		Local,    // Video memory of a discrete adapter, all memory of an integrated one.
+		NonLocal, // System memory visible to a discrete adapter, e.g. upload heaps.
+		Count
+	};
+
+	/// Mirrors DXGI_QUERY_VIDEO_MEMORY_INFO.
+	struct SegmentInfo {
+		uint64 budget = 0;
+		uint64 currentUsage = 0;
+		uint64 availableForReservation = 0;
+		uint64 currentReservation = 0;
+	};
+
+	/// Source of the budget and usage of each segment.
+	class Adapter {
+	public:
+		virtual ~Adapter() {}
+
+		/// Fills 'info' with the budget and usage of each Segment.  Called once per
+		/// update().
+		virtual void queryMemoryInfo (
+			SegmentInfo info[uint(Segment::Count)]
+		) = 0;
+	};
+
+	typedef uint AllocationId;
+
+	/// Frees memory of allocations on request.
+	class Evictor {
+	public:
+		virtual ~Evictor() {}
+
+		/// Starts freeing up to 'bytesNeeded' bytes of 'allocation', whose size
+		/// should shrink accordingly once freed.
+		/// @param context - value given to trackAllocation().
+		/// @return bytes that will be freed, 0 if none can be.
+		virtual uint64 evict (
+			AllocationId allocation,
+			uint64 context,
+			uint64 bytesNeeded
+		) = 0;
+	};
+
+	/// Adapter whose budgets, and usage by other processes, follow scripted curves.
+	/// Usage includes the tracked allocations of the MemoryBudget it is attached to.
+	class ScriptedAdapter : public Adapter {
+	public:
+		struct Point {
+			uint64 frame;
+			uint64 budget;
+			uint64 otherUsage;
+		};
+
+		/// Each curve interpolates linearly between points sorted by frame, and
+		/// holds its first and last values outside of them.  An empty curve has an
+		/// unlimited budget.
+		ScriptedAdapter (
+			const std::vector<Point> & localCurve,
+			const std::vector<Point> & nonLocalCurve
+		);
+
+		/// Adds the tracked allocations of 'memoryBudget' to the usage reported.
+		void attach (
+			const MemoryBudget * memoryBudget
+		);
+
+		void queryMemoryInfo (
+			SegmentInfo info[uint(Segment::Count)]
+		) override;
+
+	private:
+		std::vector<Point> m_curves[uint(Segment::Count)];
+		const MemoryBudget * m_memoryBudget;
+
+		// Frame of the next query.
+		uint64 m_frame;
+	};
+
+	struct Settings {
+		/// Fraction of the budget at which allocations are evicted.
+		float evictionThreshold = 0.95f;
+
+		/// Fraction of the budget usage is brought down to by evictions, and that
+		/// headroom() leaves room up to.
+		float targetUsage = 0.85f;
+	};
+
+	struct Statistics {
+		uint64 numEvictions = 0;
+		uint64 evictedBytes = 0;
+
+		/// Updates on which usage of any segment was above its budget.
+		uint64 numUpdatesOverBudget = 0;
+
+		uint64 peakUsage[uint(Segment::Count)] = {};
+	};
+
+	MemoryBudget (
+		Adapter * adapter,
+		const Settings & settings
+	);
+
+	/// Tracks an allocation of 'bytes' within 'segment'.
+	/// @param priority - allocations with lower priorities are evicted first.
+	/// @param evictor - frees the allocation under memory pressure, may be nullptr.
+	/// @param context - passed back to 'evictor'.
+	AllocationId trackAllocation (
+		Segment segment,
+		uint64 bytes,
+		float priority,
+		Evictor * evictor = nullptr,
+		uint64 context = 0
+	);
+
+	void resizeAllocation (
+		AllocationId allocation,
+		uint64 bytes
+	);
+
+	void setPriority (
+		AllocationId allocation,
+		float priority
+	);
+
+	void releaseAllocation (
+		AllocationId allocation
+	);
+
+	/// Polls the adapter, then evicts allocations of any segment over its eviction
+	/// threshold.  Call once per frame.
+	void update();
+
+	/// Budget and usage of 'segment' as of the last update().
+	const SegmentInfo & segmentInfo (
+		Segment segment
+	) const;
+
+	/// Usage of 'segment' as of the last update(), adjusted by allocations tracked
+	/// and released since, less bytes evictors have yet to free.
+	uint64 estimatedUsage (
+		Segment segment
+	) const;
+
+	/// Bytes that may still be allocated within 'segment' before reaching its
+	/// target usage, negative once above it.
+	int64 headroom (
+		Segment segment
+	) const;
+
+	/// Bytes of all tracked allocations within 'segment'.
+	uint64 trackedBytes (
+		Segment segment
+	) const;
+
+	const Statistics & statistics() const { return m_statistics; }
+
+private:
+	struct Allocation {
+		Segment segment;
+		uint64 bytes;
+		float priority;
+		Evictor * evictor;
+		uint64 context;
+
+		// Bytes the evictor has promised to free, until the allocation shrinks.
+		uint64 evictingBytes;
+		bool isTracked;
+	};
+
+	Adapter * m_adapter;
+	Settings m_settings;
+	Statistics m_statistics;
+
+	std::vector<Allocation> m_allocations;
+	std::vector<AllocationId> m_freeAllocationIds;
+
+	SegmentInfo m_segmentInfo[uint(Segment::Count)];
+
+	uint64 m_trackedBytes[uint(Segment::Count)];
+	uint64 m_evictingBytes[uint(Segment::Count)];
+
+	// Tracked bytes of each segment when the adapter was last polled.
+	uint64 m_polledTrackedBytes[uint(Segment::Count)];
+
+	// Scratch list of eviction candidates, reused across updates.
+	std::vector<AllocationId> m_candidates;
+
+	void evict (
+		Segment segment,
+		uint64 bytesNeeded
+	);
+};
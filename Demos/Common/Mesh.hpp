@@ -0,0 +1,85 @@
+//
+// Mesh.hpp
+//
+#pragma once
+
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+struct Mesh {
+	/// Per Mesh Vertex data
+	struct Vertex {
+		float position[3];
+		float normal[3];
+		float texCoord[2];
+	};
+
+	/// Range of indices drawn with its own base vertex, produced when a mesh is split
+	/// into chunks that are each addressable by 16-bit indices.
+	struct Submesh {
+		uint32 startIndex;
+		uint32 numIndices;
+		int32 baseVertex;
+	};
+
+	/// Cluster of at most a few dozen vertices and triangles whose indices are
+	/// contiguous, with bounds for culling it as a whole.  See Meshlets.
+	struct Meshlet {
+		uint32 startIndex;
+		uint32 numIndices;
+		int32 baseVertex;
+		uint32 numVertices;
+
+		/// Bounding sphere of the meshlet's vertices.
+		float center[3];
+		float radius;
+
+		/// Cone containing every triangle normal, see Meshlets::isBackFacing().
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	/// Level of detail, a simplified triangle list indexing the same vertices as the
+	/// full mesh.  See MeshSimplifier.
+	struct Lod {
+		uint32 startIndex;
+		uint32 numIndices;
+
+		/// Approximate deviation from the full mesh surface, in model space units.
+		float error;
+	};
+
+	/// Contiguous Vertex data.
+	std::vector<Vertex> vertices;
+
+	/// Contiguous Index data, only one of which is populated.  16-bit indices are
+	/// used whenever every vertex, or every vertex of a Submesh, is addressable by them.
+	std::vector<uint16> indices16;
+	std::vector<uint32> indices32;
+
+	/// Empty unless the mesh has been split into 16-bit chunks, in which case each
+	/// Submesh must be drawn separately.
+	std::vector<Submesh> submeshes;
+
+	/// Empty unless meshlets have been built, in which case they partition the
+	/// indices of the full detail mesh in order.
+	std::vector<Meshlet> meshlets;
+
+	/// Empty unless LODs have been generated, in which case lods[0] is the full mesh
+	/// and the coarser levels follow it in the index data.  Meshlets only cover
+	/// lods[0].
+	std::vector<Lod> lods;
+
+
+	size_t numIndices() const { return indices16.size() + indices32.size(); }
+
+	/// Size of a single index in bytes, either 2 or 4.
+	size_t indexSize() const { return indices32.empty() ? sizeof(uint16) : sizeof(uint32); }
+
+	size_t indexDataBytes() const { return numIndices() * indexSize(); }
+
+	const void * indexData() const {
+		return indices32.empty() ? static_cast<const void *>(indices16.data()) : indices32.data();
+	}
+};
@@ -0,0 +1,299 @@
+//
+// MeshCache.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#ifdef _WIN32
+	// Allow use of fopen() without SDL check errors, as pch.h does.
+	#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "MeshCache.hpp"
+
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+namespace {
+
+	const uint64 StreamAlignment = 16;
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint64 alignOffset (
+	uint64 offset
+) {
+	return (offset + (StreamAlignment - 1)) & ~(StreamAlignment - 1);
+}
+
+//---------------------------------------------------------------------------------------
+uint64 MeshCache::hashBytes (
+	const void * data,
+	size_t numBytes,
+	uint64 seed
+) {
+	const byte * p = static_cast<const byte *>(data);
+	uint64 hash = seed;
+	for (size_t i = 0; i < numBytes; ++i) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+//---------------------------------------------------------------------------------------
+bool MeshCache::queryFile (
+	const char * path,
+	uint64 & timestamp,
+	uint64 & size
+) {
+#ifdef _WIN32
+	struct _stat64 fileStat;
+	if (_stat64(path, &fileStat) != 0) {
+		return false;
+	}
+#else
+	struct stat fileStat;
+	if (stat(path, &fileStat) != 0) {
+		return false;
+	}
+#endif
+	timestamp = uint64(fileStat.st_mtime);
+	size = uint64(fileStat.st_size);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool MeshCache::isCurrent (
+	const Header & header,
+	const char * sourcePath,
+	const SourceInfo & source,
+	uint64 settingsHash,
+	MappedFile & sourceFile
+) {
+	if (header.settingsHash != settingsHash || header.sourceSize != source.size) {
+		return false;
+	}
+	if (header.sourceTimestamp == source.timestamp) {
+		return true;
+	}
+
+	// Source was touched, e.g. by a checkout, so compare its contents.
+	if (!sourceFile.isOpen() && !sourceFile.open(sourcePath)) {
+		return false;
+	}
+	return hashBytes(sourceFile.data(), sourceFile.size()) == header.sourceHash;
+}
+
+//---------------------------------------------------------------------------------------
+static void writeBytes (
+	FILE * file,
+	const void * data,
+	size_t numBytes
+) {
+	if (numBytes > 0 && fwrite(data, 1, numBytes, file) != numBytes) {
+		throw std::runtime_error("Failed writing mesh cache file.");
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Pads the file with zeroes up to 'offset'.
+static void writePadding (
+	FILE * file,
+	uint64 & fileOffset,
+	uint64 offset
+) {
+	static const byte zeroes[StreamAlignment] = {};
+	writeBytes(file, zeroes, size_t(offset - fileOffset));
+	fileOffset = offset;
+}
+
+//---------------------------------------------------------------------------------------
+void MeshCache::write (
+	const char * cachePath,
+	const Mesh & mesh,
+	const SourceInfo & source,
+	uint64 settingsHash
+) {
+	Header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = Magic;
+	header.version = Version;
+	header.sourceTimestamp = source.timestamp;
+	header.sourceSize = source.size;
+	header.sourceHash = source.hash;
+	header.settingsHash = settingsHash;
+	header.vertexStride = sizeof(Mesh::Vertex);
+	header.indexSize = uint32(mesh.indexSize());
+	header.numVertices = mesh.vertices.size();
+	header.numIndices = mesh.numIndices();
+	header.numSubmeshes = mesh.submeshes.size();
+	header.numMeshlets = mesh.meshlets.size();
+	header.numLods = mesh.lods.size();
+
+	header.vertexDataOffset = alignOffset(sizeof(Header));
+	header.indexDataOffset = alignOffset(header.vertexDataOffset +
+		header.numVertices * sizeof(Mesh::Vertex));
+	header.submeshDataOffset = alignOffset(header.indexDataOffset +
+		header.numIndices * header.indexSize);
+	header.meshletDataOffset = alignOffset(header.submeshDataOffset +
+		header.numSubmeshes * sizeof(Mesh::Submesh));
+	header.lodDataOffset = alignOffset(header.meshletDataOffset +
+		header.numMeshlets * sizeof(Mesh::Meshlet));
+
+	for (int i = 0; i < 3; ++i) {
+		header.boundsMin[i] = mesh.vertices.empty() ? 0.0f : FLT_MAX;
+		header.boundsMax[i] = mesh.vertices.empty() ? 0.0f : -FLT_MAX;
+	}
+	for (const Mesh::Vertex & vertex : mesh.vertices) {
+		for (int i = 0; i < 3; ++i) {
+			header.boundsMin[i] = (vertex.position[i] < header.boundsMin[i]) ?
+				vertex.position[i] : header.boundsMin[i];
+			header.boundsMax[i] = (vertex.position[i] > header.boundsMax[i]) ?
+				vertex.position[i] : header.boundsMax[i];
+		}
+	}
+
+	// Write to a temporary file first so that an interrupted write never leaves a
+	// truncated cache behind.
+	const std::string tempPath = std::string(cachePath) + ".tmp";
+	FILE * file = fopen(tempPath.c_str(), "wb");
+	if (!file) {
+		throw std::runtime_error("Unable to create mesh cache file: " + tempPath);
+	}
+
+	try {
+		uint64 fileOffset = 0;
+		writeBytes(file, &header, sizeof(header));
+		fileOffset += sizeof(header);
+
+		writePadding(file, fileOffset, header.vertexDataOffset);
+		writeBytes(file, mesh.vertices.data(), mesh.vertices.size() * sizeof(Mesh::Vertex));
+		fileOffset += mesh.vertices.size() * sizeof(Mesh::Vertex);
+
+		writePadding(file, fileOffset, header.indexDataOffset);
+		writeBytes(file, mesh.indexData(), mesh.indexDataBytes());
+		fileOffset += mesh.indexDataBytes();
+
+		writePadding(file, fileOffset, header.submeshDataOffset);
+		writeBytes(file, mesh.submeshes.data(), mesh.submeshes.size() * sizeof(Mesh::Submesh));
+		fileOffset += mesh.submeshes.size() * sizeof(Mesh::Submesh);
+
+		writePadding(file, fileOffset, header.meshletDataOffset);
+		writeBytes(file, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Mesh::Meshlet));
+		fileOffset += mesh.meshlets.size() * sizeof(Mesh::Meshlet);
+
+		writePadding(file, fileOffset, header.lodDataOffset);
+		writeBytes(file, mesh.lods.data(), mesh.lods.size() * sizeof(Mesh::Lod));
+	}
+	catch (...) {
+		fclose(file);
+		remove(tempPath.c_str());
+		throw;
+	}
+
+	if (fclose(file) != 0) {
+		remove(tempPath.c_str());
+		throw std::runtime_error("Failed writing mesh cache file.");
+	}
+
+	// rename() does not replace existing files on Windows.
+	remove(cachePath);
+	if (rename(tempPath.c_str(), cachePath) != 0) {
+		remove(tempPath.c_str());
+		throw std::runtime_error(std::string("Unable to replace mesh cache file: ") + cachePath);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+MappedMesh::MappedMesh()
+	: m_header(nullptr)
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+bool MappedMesh::open (
+	const char * cachePath
+) {
+	close();
+
+	if (!m_file.open(cachePath) || m_file.size() < sizeof(MeshCache::Header)) {
+		m_file.close();
+		return false;
+	}
+
+	const MeshCache::Header * header =
+		reinterpret_cast<const MeshCache::Header *>(m_file.data());
+
+	const uint64 submeshDataEnd = header->submeshDataOffset +
+		header->numSubmeshes * sizeof(Mesh::Submesh);
+	const uint64 meshletDataEnd = header->meshletDataOffset +
+		header->numMeshlets * sizeof(Mesh::Meshlet);
+	const uint64 lodDataEnd = header->lodDataOffset + header->numLods * sizeof(Mesh::Lod);
+
+	const bool isValid =
+		header->magic == MeshCache::Magic &&
+		header->version == MeshCache::Version &&
+		header->vertexDataOffset >= sizeof(MeshCache::Header) &&
+		header->vertexStride == sizeof(Mesh::Vertex) &&
+		(header->indexSize == sizeof(uint16) || header->indexSize == sizeof(uint32)) &&
+		header->indexDataOffset >=
+			header->vertexDataOffset + header->numVertices * sizeof(Mesh::Vertex) &&
+		header->submeshDataOffset >=
+			header->indexDataOffset + header->numIndices * header->indexSize &&
+		header->meshletDataOffset >= submeshDataEnd &&
+		header->lodDataOffset >= meshletDataEnd &&
+		lodDataEnd <= m_file.size();
+
+	if (!isValid) {
+		m_file.close();
+		return false;
+	}
+
+	m_header = header;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+void MappedMesh::close()
+{
+	m_header = nullptr;
+	m_file.close();
+}
+
+//---------------------------------------------------------------------------------------
+const Mesh::Vertex * MappedMesh::vertices() const
+{
+	return reinterpret_cast<const Mesh::Vertex *>(m_file.data() + m_header->vertexDataOffset);
+}
+
+//---------------------------------------------------------------------------------------
+const void * MappedMesh::indexData() const
+{
+	return m_file.data() + m_header->indexDataOffset;
+}
+
+//---------------------------------------------------------------------------------------
+const Mesh::Submesh * MappedMesh::submeshes() const
+{
+	return reinterpret_cast<const Mesh::Submesh *>(m_file.data() + m_header->submeshDataOffset);
+}
+
+//---------------------------------------------------------------------------------------
+const Mesh::Meshlet * MappedMesh::meshlets() const
+{
+	return reinterpret_cast<const Mesh::Meshlet *>(m_file.data() + m_header->meshletDataOffset);
+}
+
+//---------------------------------------------------------------------------------------
+const Mesh::Lod * MappedMesh::lods() const
+{
+	return reinterpret_cast<const Mesh::Lod *>(m_file.data() + m_header->lodDataOffset);
+}
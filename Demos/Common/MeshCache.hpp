@@ -0,0 +1,162 @@
+//
+// MeshCache.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/MappedFile.hpp"
+#include "Common/Mesh.hpp"
+
+
+/**
+* Versioned binary container for a processed Mesh, written next to its source asset
+* so that later loads can skip parsing entirely.
+*
+* Layout is a Header followed by the vertex, index, Submesh, Meshlet and Lod streams
+* at the offsets it records, each aligned to 16 bytes.  The file is consumed through
+* MappedMesh, which memory maps it and exposes the streams in place.
+*
+* A cache is stale when its version or load settings differ, or when the source
+* file's timestamp or size differ and a hash of its contents no longer matches.
+*
+* Has no Windows dependencies, write errors throw std::runtime_error.
+*/
+namespace MeshCache {
+
+	/// 'MSHC' in little-endian byte order.
+	const uint32 Magic = 0x4348534D;
+
+	/// Increment whenever the layout of the file, or of the Mesh structs it stores, changes.
+	const uint32 Version = 3;
+
+	struct Header {
+		uint32 magic;
+		uint32 version;
+
+		// Identifies the source asset the cache was built from.
+		uint64 sourceTimestamp;
+		uint64 sourceSize;
+		uint64 sourceHash;
+
+		// Hash of the load settings used to process the source.
+		uint64 settingsHash;
+
+		uint32 vertexStride;
+		uint32 indexSize;
+		uint64 numVertices;
+		uint64 numIndices;
+		uint64 numSubmeshes;
+		uint64 numMeshlets;
+		uint64 numLods;
+
+		// Byte offsets of each stream from the start of the file.
+		uint64 vertexDataOffset;
+		uint64 indexDataOffset;
+		uint64 submeshDataOffset;
+		uint64 meshletDataOffset;
+		uint64 lodDataOffset;
+
+		// Axis aligned bounds of all vertex positions.
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	/// Properties of a source asset, used to detect stale caches.
+	struct SourceInfo {
+		uint64 timestamp;
+		uint64 size;
+		uint64 hash;
+	};
+
+	/// 64-bit FNV-1a hash.
+	uint64 hashBytes (
+		const void * data,
+		size_t numBytes,
+		uint64 seed = 0xcbf29ce484222325ull
+	);
+
+	/// Retrieves the last modification time and size of the file at 'path'.
+	/// @return false if the file does not exist.
+	bool queryFile (
+		const char * path,
+		uint64 & timestamp,
+		uint64 & size
+	);
+
+	/// True if a cache with 'header' was built with 'settingsHash' from the current contents
+	/// of the source asset at 'sourcePath', whose timestamp and size are in 'source'.
+	/// The source is only hashed when its timestamp differs, in which case it is left
+	/// mapped in 'sourceFile' so that a stale cache can be rebuilt without remapping it.
+	bool isCurrent (
+		const Header & header,
+		const char * sourcePath,
+		const SourceInfo & source,
+		uint64 settingsHash,
+		MappedFile & sourceFile
+	);
+
+	/// Writes 'mesh' to 'cachePath', replacing any existing file.
+	void write (
+		const char * cachePath,
+		const Mesh & mesh,
+		const SourceInfo & source,
+		uint64 settingsHash
+	);
+};
+
+
+/**
+* Read-only view of a mesh cache file.  Vertex and index data point directly into the
+* memory mapping, so they can be handed to upload routines without being copied.
+*/
+class MappedMesh {
+public:
+	MappedMesh();
+
+	/// Maps the cache file at 'cachePath' and validates its header.
+	/// @return false if the file is missing, truncated or from another version.
+	bool open (
+		const char * cachePath
+	);
+
+	void close();
+
+	bool isOpen() const { return m_header != nullptr; }
+
+	const MeshCache::Header & header() const { return *m_header; }
+
+	const Mesh::Vertex * vertices() const;
+
+	size_t numVertices() const { return size_t(m_header->numVertices); }
+
+	size_t vertexDataBytes() const { return numVertices() * sizeof(Mesh::Vertex); }
+
+	const void * indexData() const;
+
+	size_t numIndices() const { return size_t(m_header->numIndices); }
+
+	size_t indexSize() const { return m_header->indexSize; }
+
+	size_t indexDataBytes() const { return numIndices() * indexSize(); }
+
+	const Mesh::Submesh * submeshes() const;
+
+	size_t numSubmeshes() const { return size_t(m_header->numSubmeshes); }
+
+	const Mesh::Meshlet * meshlets() const;
+
+	size_t numMeshlets() const { return size_t(m_header->numMeshlets); }
+
+	const Mesh::Lod * lods() const;
+
+	size_t numLods() const { return size_t(m_header->numLods); }
+
+	/// Size of the mapped file in bytes.
+	size_t fileSize() const { return m_file.size(); }
+
+private:
+	MappedFile m_file;
+	const MeshCache::Header * m_header;
+};
@@ -1,24 +1,575 @@
 //
-// ObjFileLoader.cpp
+// MeshFileLoader.cpp
 //
-#include "pch.h"
+// Portable, compiled without the precompiled header.
+//
+#include "MeshFileLoader.hpp"
 
-#include "Common/MeshFileLoader.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
 
-#include <fstream>
+#include "Common/MappedFile.hpp"
 
-void MeshFileLoader::loadObjAsset (
-	const char * objFilePath,
+
+namespace {
+
+	// Exact powers of 10 representable as doubles.
+	const double PowersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	struct Cursor {
+		const char * cur;
+		const char * end;
+	};
+
+	typedef MeshFileLoader::ObjFile ObjFile;
+	typedef ObjFile::Float3 Float3;
+	typedef ObjFile::Float2 Float2;
+
+	// Number of each attribute declared so far.
+	struct AttributeCounts {
+		size_t numPositions;
+		size_t numNormals;
+		size_t numTexCoords;
+	};
+
+	enum class LineType {
+		Position,
+		Normal,
+		TexCoord,
+		Face,
+		Shape,
+		Other
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static inline bool isSpace (
+	char c
+) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+//---------------------------------------------------------------------------------------
+static inline bool isDigit (
+	char c
+) {
+	return unsigned(c - '0') < 10u;
+}
+
+//---------------------------------------------------------------------------------------
+static inline void skipSpaces (
+	Cursor & cursor
+) {
+	while (cursor.cur < cursor.end && isSpace(*cursor.cur)) {
+		++cursor.cur;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Advances cursor to the first character of the next line.
+static inline void skipLine (
+	Cursor & cursor
+) {
+	const void * newline = memchr(cursor.cur, '\n', size_t(cursor.end - cursor.cur));
+	cursor.cur = newline ? static_cast<const char *>(newline) + 1 : cursor.end;
+}
+
+//---------------------------------------------------------------------------------------
+// Parses a decimal floating point number such as "-1.25e-3".  Up to 19 significant
+// digits are accumulated as an integer, then scaled by an exact power of 10 which is
+// exact for the short mantissas typical of OBJ files.
+static float parseFloat (
+	Cursor & cursor
+) {
+	skipSpaces(cursor);
+
+	const char * p = cursor.cur;
+	const char * end = cursor.end;
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
+	}
+
+	uint64 mantissa = 0;
+	int exponent = 0;
+	int numDigits = 0;
+
+	for (; p < end && isDigit(*p); ++p) {
+		if (numDigits < 19) {
+			mantissa = mantissa * 10 + uint64(*p - '0');
+			++numDigits;
+		} else {
+			++exponent;
+		}
+	}
+
+	if (p < end && *p == '.') {
+		++p;
+		for (; p < end && isDigit(*p); ++p) {
+			if (numDigits < 19) {
+				mantissa = mantissa * 10 + uint64(*p - '0');
+				++numDigits;
+				--exponent;
+			}
+		}
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negativeExponent = (*p == '-');
+			++p;
+		}
+		int explicitExponent = 0;
+		for (; p < end && isDigit(*p); ++p) {
+			if (explicitExponent < 10000) {
+				explicitExponent = explicitExponent * 10 + (*p - '0');
+			}
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	cursor.cur = p;
+
+	double value = double(mantissa);
+	while (exponent > 22) {
+		value *= 1e22;
+		exponent -= 22;
+	}
+	while (exponent < -22) {
+		value /= 1e22;
+		exponent += 22;
+	}
+	value = (exponent >= 0) ? value * PowersOf10[exponent] : value / PowersOf10[-exponent];
+
+	return static_cast<float>(negative ? -value : value);
+}
+
+//---------------------------------------------------------------------------------------
+// Parses a possibly negative integer.  Returns 0, which is never a valid OBJ index,
+// if no digits are present.
+static inline long parseInt (
+	Cursor & cursor
+) {
+	const char * p = cursor.cur;
+	bool negative = false;
+	if (p < cursor.end && *p == '-') {
+		negative = true;
+		++p;
+	}
+
+	long value = 0;
+	for (; p < cursor.end && isDigit(*p); ++p) {
+		value = value * 10 + (*p - '0');
+	}
+	cursor.cur = p;
+
+	return negative ? -value : value;
+}
+
+//---------------------------------------------------------------------------------------
+// Converts a 1-based, possibly relative, OBJ index into a 0-based index.  Relative
+// indices count back from the last of the 'numDeclared' elements declared so far.
+static inline size_t resolveIndex (
+	long objIndex,
+	size_t numDeclared,
+	size_t numElements
+) {
+	if (objIndex > 0 && size_t(objIndex) <= numElements) {
+		return size_t(objIndex - 1);
+	}
+	if (objIndex < 0 && size_t(-objIndex) <= numDeclared) {
+		return numDeclared - size_t(-objIndex);
+	}
+	throw std::runtime_error("OBJ face references an undefined element.");
+}
+
+//---------------------------------------------------------------------------------------
+// Counts the vertices of the face whose first vertex starts at 'cursor'.
+static size_t countFaceVertices (
+	Cursor cursor
+) {
+	size_t numFaceVertices = 0;
+	for (;;) {
+		skipSpaces(cursor);
+		if (cursor.cur >= cursor.end || *cursor.cur == '\n' || *cursor.cur == '#') {
+			break;
+		}
+		++numFaceVertices;
+		while (cursor.cur < cursor.end && !isSpace(*cursor.cur) &&
+			*cursor.cur != '\n' && *cursor.cur != '#')
+		{
+			++cursor.cur;
+		}
+	}
+	return numFaceVertices;
+}
+
+//---------------------------------------------------------------------------------------
+// Classifies the line at 'cursor', advancing past its keyword.
+static LineType classifyLine (
+	Cursor & cursor
+) {
+	const char * line = cursor.cur;
+	const size_t remaining = size_t(cursor.end - line);
+	if (remaining < 2) {
+		return LineType::Other;
+	}
+
+	if (line[0] == 'v') {
+		if (isSpace(line[1])) {
+			cursor.cur += 2;
+			return LineType::Position;
+		}
+		if (remaining >= 3 && isSpace(line[2])) {
+			if (line[1] == 'n') {
+				cursor.cur += 3;
+				return LineType::Normal;
+			}
+			if (line[1] == 't') {
+				cursor.cur += 3;
+				return LineType::TexCoord;
+			}
+		}
+	} else if (line[0] == 'f' && isSpace(line[1])) {
+		cursor.cur += 2;
+		return LineType::Face;
+	} else if ((line[0] == 'o' || line[0] == 'g') && isSpace(line[1])) {
+		cursor.cur += 2;
+		return LineType::Shape;
+	}
+
+	return LineType::Other;
+}
+
+//---------------------------------------------------------------------------------------
+// Returns the remainder of the current line, without trailing whitespace.
+static std::string readName (
+	Cursor cursor
+) {
+	skipSpaces(cursor);
+	if (cursor.cur >= cursor.end) {
+		return std::string();
+	}
+
+	const char * begin = cursor.cur;
+	const void * newline = memchr(begin, '\n', size_t(cursor.end - begin));
+	const char * end = newline ? static_cast<const char *>(newline) : cursor.end;
+	while (end > begin && isSpace(end[-1])) {
+		--end;
+	}
+	return std::string(begin, end);
+}
+
+//---------------------------------------------------------------------------------------
+// First pass, counting attributes and locating shapes so that storage for them can be
+// allocated up front.
+static void scanObj (
+	const char * text,
+	size_t numBytes,
+	ObjFile & objFile
+) {
+	AttributeCounts counts = { 0, 0, 0 };
+
+	ObjFile::Shape shape;
+	shape.begin = text;
+	shape.numCorners = 0;
+	shape.numPrecedingPositions = shape.numPrecedingNormals = shape.numPrecedingTexCoords = 0;
+
+	objFile.shapes.clear();
+
+	Cursor cursor = { text, text + numBytes };
+
+	while (cursor.cur < cursor.end) {
+		skipSpaces(cursor);
+		const char * line = cursor.cur;
+
+		switch (classifyLine(cursor)) {
+		case LineType::Position:
+			++counts.numPositions;
+			break;
+		case LineType::Normal:
+			++counts.numNormals;
+			break;
+		case LineType::TexCoord:
+			++counts.numTexCoords;
+			break;
+		case LineType::Face: {
+			const size_t numFaceVertices = countFaceVertices(cursor);
+			if (numFaceVertices >= 3) {
+				shape.numCorners += 3 * (numFaceVertices - 2);
+			}
+			break;
+		}
+		case LineType::Shape:
+			shape.end = line;
+			if (shape.numCorners > 0) {
+				objFile.shapes.push_back(shape);
+			}
+			shape.name = readName(cursor);
+			shape.begin = line;
+			shape.numCorners = 0;
+			shape.numPrecedingPositions = counts.numPositions;
+			shape.numPrecedingNormals = counts.numNormals;
+			shape.numPrecedingTexCoords = counts.numTexCoords;
+			break;
+		default:
+			break;
+		}
+
+		skipLine(cursor);
+	}
+
+	shape.end = cursor.end;
+	if (shape.numCorners > 0) {
+		objFile.shapes.push_back(shape);
+	}
+
+	objFile.positions.clear();
+	objFile.normals.clear();
+	objFile.texCoords.clear();
+	objFile.positions.reserve(counts.numPositions);
+	objFile.normals.reserve(counts.numNormals);
+	objFile.texCoords.reserve(counts.numTexCoords);
+}
+
+//---------------------------------------------------------------------------------------
+// Parses a single "p", "p/t", "p//n" or "p/t/n" face vertex.  The vertex must be
+// followed by whitespace, a comment or the end of the line, as countFaceVertices()
+// splits faces on whitespace alone.
+static void parseFaceVertex (
+	Cursor & cursor,
+	const ObjFile & objFile,
+	const AttributeCounts & counts,
+	Mesh::Vertex & vertex
+) {
+	long positionIndex = parseInt(cursor);
+	long texCoordIndex = 0;
+	long normalIndex = 0;
+
+	if (cursor.cur < cursor.end && *cursor.cur == '/') {
+		++cursor.cur;
+		if (cursor.cur < cursor.end && *cursor.cur != '/') {
+			texCoordIndex = parseInt(cursor);
+		}
+		if (cursor.cur < cursor.end && *cursor.cur == '/') {
+			++cursor.cur;
+			normalIndex = parseInt(cursor);
+		}
+	}
+
+	if (cursor.cur < cursor.end && !isSpace(*cursor.cur) &&
+		*cursor.cur != '\n' && *cursor.cur != '#')
+	{
+		throw std::runtime_error("OBJ face vertex is malformed.");
+	}
+
+	const Float3 & position = objFile.positions [
+		resolveIndex(positionIndex, counts.numPositions, objFile.positions.size())
+	];
+	vertex.position[0] = position.x;
+	vertex.position[1] = position.y;
+	vertex.position[2] = position.z;
+
+	if (normalIndex != 0) {
+		const Float3 & normal = objFile.normals [
+			resolveIndex(normalIndex, counts.numNormals, objFile.normals.size())
+		];
+		vertex.normal[0] = normal.x;
+		vertex.normal[1] = normal.y;
+		vertex.normal[2] = normal.z;
+	} else {
+		vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+	}
+
+	if (texCoordIndex != 0) {
+		const Float2 & texCoord = objFile.texCoords [
+			resolveIndex(texCoordIndex, counts.numTexCoords, objFile.texCoords.size())
+		];
+		vertex.texCoord[0] = texCoord.x;
+		vertex.texCoord[1] = texCoord.y;
+	} else {
+		vertex.texCoord[0] = vertex.texCoord[1] = 0.0f;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Parses the faces within 'shape' into 'mesh', emitting one vertex per corner.
+static void parseFaces (
+	const ObjFile & objFile,
+	const ObjFile::Shape & shape,
 	Mesh & mesh
 ) {
-	std::ifstream fileStream (objFilePath, std::ios::in);
-	if (!fileStream) {
-		ForceBreak ("Unable to open obj asset file: %s", objFilePath);
+	if (uint64(shape.numCorners) > uint64(~uint32(0))) {
+		throw std::runtime_error("OBJ mesh has too many vertices for 32-bit indices.");
 	}
 
-	char buffer[256];
+	// Indices start out 32-bit, the width actually needed is only known after welding.
+	mesh.vertices.resize(shape.numCorners);
+	mesh.indices32.resize(shape.numCorners);
+	mesh.indices16.clear();
+	mesh.submeshes.clear();
+	Mesh::Vertex * outVertex = mesh.vertices.data();
+	Mesh::Vertex * const outVertexEnd = outVertex + shape.numCorners;
+	uint32 * outIndex = mesh.indices32.data();
+	uint32 nextIndex = 0;
+
+	AttributeCounts counts = {
+		shape.numPrecedingPositions,
+		shape.numPrecedingNormals,
+		shape.numPrecedingTexCoords
+	};
+
+	Cursor cursor = { shape.begin, shape.end };
 
-	while (!fileStream.eof ()) {
-		fileStream.getline (buffer, 256);
+	while (cursor.cur < cursor.end) {
+		skipSpaces(cursor);
+
+		switch (classifyLine(cursor)) {
+		case LineType::Position:
+			++counts.numPositions;
+			break;
+		case LineType::Normal:
+			++counts.numNormals;
+			break;
+		case LineType::TexCoord:
+			++counts.numTexCoords;
+			break;
+		case LineType::Face: {
+			// Fan triangulate: (0, i-1, i) for each face vertex i >= 2.
+			Mesh::Vertex first, previous, current;
+			size_t numFaceVertices = 0;
+			for (;;) {
+				skipSpaces(cursor);
+				if (cursor.cur >= cursor.end || *cursor.cur == '\n' || *cursor.cur == '#') {
+					break;
+				}
+				parseFaceVertex(cursor, objFile, counts, current);
+
+				if (numFaceVertices == 0) {
+					first = current;
+				} else if (numFaceVertices >= 2) {
+					// Should the passes ever disagree, fail rather than overrun.
+					if (outVertexEnd - outVertex < 3) {
+						throw std::runtime_error("OBJ face has more vertices than counted.");
+					}
+					*outVertex++ = first;
+					*outVertex++ = previous;
+					*outVertex++ = current;
+					*outIndex++ = nextIndex++;
+					*outIndex++ = nextIndex++;
+					*outIndex++ = nextIndex++;
+				}
+				previous = current;
+				++numFaceVertices;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+
+		skipLine(cursor);
+	}
+
+	if (outVertex != outVertexEnd) {
+		throw std::runtime_error("OBJ face has fewer vertices than counted.");
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void MeshFileLoader::parseObjAttributes (
+	const char * objText,
+	size_t numBytes,
+	ObjFile & objFile
+) {
+	scanObj(objText, numBytes, objFile);
+
+	Cursor cursor = { objText, objText + numBytes };
+
+	while (cursor.cur < cursor.end) {
+		skipSpaces(cursor);
+
+		switch (classifyLine(cursor)) {
+		case LineType::Position: {
+			Float3 position;
+			position.x = parseFloat(cursor);
+			position.y = parseFloat(cursor);
+			position.z = parseFloat(cursor);
+			objFile.positions.push_back(position);
+			break;
+		}
+		case LineType::Normal: {
+			Float3 normal;
+			normal.x = parseFloat(cursor);
+			normal.y = parseFloat(cursor);
+			normal.z = parseFloat(cursor);
+			objFile.normals.push_back(normal);
+			break;
+		}
+		case LineType::TexCoord: {
+			Float2 texCoord;
+			texCoord.x = parseFloat(cursor);
+			texCoord.y = parseFloat(cursor);
+			objFile.texCoords.push_back(texCoord);
+			break;
+		}
+		default:
+			break;
+		}
+
+		skipLine(cursor);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void MeshFileLoader::parseObjShape (
+	const ObjFile & objFile,
+	size_t shapeIndex,
+	Mesh & mesh
+) {
+	parseFaces(objFile, objFile.shapes.at(shapeIndex), mesh);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshFileLoader::parseObj (
+	const char * objText,
+	size_t numBytes,
+	Mesh & mesh
+) {
+	ObjFile objFile;
+	parseObjAttributes(objText, numBytes, objFile);
+
+	// Treat the whole file as a single shape.
+	ObjFile::Shape allShapes;
+	allShapes.begin = objText;
+	allShapes.end = objText + numBytes;
+	allShapes.numCorners = 0;
+	allShapes.numPrecedingPositions = allShapes.numPrecedingNormals =
+		allShapes.numPrecedingTexCoords = 0;
+	for (const ObjFile::Shape & shape : objFile.shapes) {
+		allShapes.numCorners += shape.numCorners;
+	}
+
+	parseFaces(objFile, allShapes, mesh);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshFileLoader::loadObjAsset (
+	const char * objFilePath,
+	Mesh & mesh
+) {
+	MappedFile file;
+	if (!file.open(objFilePath)) {
+		throw std::runtime_error(std::string("Unable to open obj asset file: ") + objFilePath);
 	}
+
+	parseObj(reinterpret_cast<const char *>(file.data()), file.size(), mesh);
 }
@@ -1,30 +1,87 @@
 //
-// ObjFileLoader.hpp
+// MeshFileLoader.hpp
 //
 #pragma once
 
-#include "Common/BasicTypes.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
 
-struct Vertex {
-	float position[3];
-	float normal[3];
-	float uv_diffuse[2];
-};
+#include "Common/Mesh.hpp"
 
-/// Index into vertex list
-typedef ushort VertexIndex;
 
-struct Mesh {
-	Vertex * vertices;
-	uint32 numVertices;
-	VertexIndex * indices;
-	uint32 numIndices;
-};
+/**
+* Streaming Wavefront OBJ parser.
+*
+* The file is memory-mapped and parsed in place with no iostreams, no per-line strings
+* and a hand-written float parser.  A first pass counts elements so that the output
+* vertex and 32-bit index arrays are allocated once, up front, and filled directly
+* by the second pass.  Polygons are fan triangulated, and faces missing normals or
+* texture coordinates receive zeroes for them.
+*
+* Files containing several objects or groups can be split into one Mesh per shape.
+* parseObjAttributes() reads the shared vertex attributes, after which each shape can
+* be parsed by parseObjShape() independently, and concurrently.
+*
+* Has no Windows dependencies, errors are reported by throwing std::runtime_error.
+*/
+namespace MeshFileLoader {
 
+	/// Vertex attributes and shapes of an OBJ file.  References the file text, which
+	/// must outlive it.
+	struct ObjFile {
+		struct Float3 { float x, y, z; };
+		struct Float2 { float x, y; };
 
-namespace MeshFileLoader {
+		/// Faces following an "o" or "g" statement, up to the next one.
+		struct Shape {
+			std::string name;
+
+			// Range of file text holding the shape's faces.
+			const char * begin;
+			const char * end;
+
+			// Triangulated face corners, one output vertex and index each.
+			size_t numCorners;
+
+			// Attributes declared before the shape, for resolving relative indices.
+			size_t numPrecedingPositions;
+			size_t numPrecedingNormals;
+			size_t numPrecedingTexCoords;
+		};
+
+		std::vector<Float3> positions;
+		std::vector<Float3> normals;
+		std::vector<Float2> texCoords;
+
+		/// Shapes with at least one face, in file order.
+		std::vector<Shape> shapes;
+	};
+
+	/// Parses the .obj file at 'objFilePath' into 'mesh', merging all shapes.
 	void loadObjAsset (
 		const char * objFilePath,
 		Mesh & mesh
 	);
+
+	/// Parses .obj text held in memory into 'mesh', merging all shapes.
+	void parseObj (
+		const char * objText,
+		size_t numBytes,
+		Mesh & mesh
+	);
+
+	/// Parses the vertex attributes of .obj text and locates its shapes.
+	void parseObjAttributes (
+		const char * objText,
+		size_t numBytes,
+		ObjFile & objFile
+	);
+
+	/// Parses the faces of objFile.shapes[shapeIndex] into 'mesh'.  Thread-safe.
+	void parseObjShape (
+		const ObjFile & objFile,
+		size_t shapeIndex,
+		Mesh & mesh
+	);
 };
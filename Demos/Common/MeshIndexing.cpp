@@ -0,0 +1,140 @@
+//
+// MeshIndexing.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "MeshIndexing.hpp"
+
+#include <cassert>
+#include <vector>
+
+
+namespace {
+
+	const uint32 InvalidIndex = ~uint32(0);
+}
+
+//---------------------------------------------------------------------------------------
+// Returns the mesh indices widened to 32-bit, emptying both index arrays.
+static std::vector<uint32> takeIndices32 (
+	Mesh & mesh
+) {
+	std::vector<uint32> indices;
+	if (mesh.indices16.empty()) {
+		indices.swap(mesh.indices32);
+	} else {
+		indices.assign(mesh.indices16.begin(), mesh.indices16.end());
+		mesh.indices16.clear();
+		mesh.indices16.shrink_to_fit();
+	}
+	return indices;
+}
+
+//---------------------------------------------------------------------------------------
+size_t MeshIndexing::selectIndexSize (
+	Mesh & mesh
+) {
+	assert(mesh.submeshes.empty());
+
+	const bool fits16Bit = mesh.vertices.size() <= MaxVerticesPer16BitChunk;
+
+	if (fits16Bit && !mesh.indices32.empty()) {
+		mesh.indices16.assign(mesh.indices32.begin(), mesh.indices32.end());
+		mesh.indices32.clear();
+		mesh.indices32.shrink_to_fit();
+	} else if (!fits16Bit && !mesh.indices16.empty()) {
+		mesh.indices32 = takeIndices32(mesh);
+	}
+
+	return mesh.indexSize();
+}
+
+//---------------------------------------------------------------------------------------
+size_t MeshIndexing::splitInto16BitChunks (
+	Mesh & mesh,
+	size_t maxVerticesPerChunk
+) {
+	assert(maxVerticesPerChunk >= 3 && maxVerticesPerChunk <= MaxVerticesPer16BitChunk);
+	assert(mesh.submeshes.empty());
+	assert(mesh.numIndices() % 3 == 0);
+
+	if (mesh.vertices.size() <= maxVerticesPerChunk) {
+		selectIndexSize(mesh);
+		return 0;
+	}
+
+	// Coarser LODs would straddle chunks.
+	assert(mesh.lods.size() <= 1);
+
+	const std::vector<uint32> indices = takeIndices32(mesh);
+
+	std::vector<Mesh::Vertex> sourceVertices;
+	sourceVertices.swap(mesh.vertices);
+	mesh.vertices.reserve(sourceVertices.size());
+	mesh.indices16.resize(indices.size());
+
+	// Maps a source vertex to its index within the current chunk.  Only entries listed
+	// in chunkVertices are valid, and they are reset when the chunk is closed.
+	std::vector<uint32> chunkIndex(sourceVertices.size(), InvalidIndex);
+	std::vector<uint32> chunkVertices;
+	chunkVertices.reserve(maxVerticesPerChunk);
+
+	Mesh::Submesh chunk = { 0, 0, 0 };
+
+	// Meshlets must not straddle chunks, so when present they are assigned whole.
+	size_t nextMeshlet = 0;
+
+	// Appends the vertices of the current chunk after those of previous chunks.
+	auto closeChunk = [&]() {
+		for (uint32 sourceIndex : chunkVertices) {
+			mesh.vertices.push_back(sourceVertices[sourceIndex]);
+			chunkIndex[sourceIndex] = InvalidIndex;
+		}
+		chunkVertices.clear();
+	};
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		size_t numNewVertices = 0;
+		Mesh::Meshlet * meshlet = nullptr;
+
+		if (mesh.meshlets.empty()) {
+			for (size_t corner = 0; corner < 3; ++corner) {
+				numNewVertices += (chunkIndex[indices[i + corner]] == InvalidIndex) ? 1 : 0;
+			}
+		} else if (nextMeshlet < mesh.meshlets.size() &&
+			mesh.meshlets[nextMeshlet].startIndex == i)
+		{
+			// Reserve room for all of the meshlet's vertices up front.
+			meshlet = &mesh.meshlets[nextMeshlet++];
+			assert(meshlet->numVertices <= maxVerticesPerChunk);
+			numNewVertices = meshlet->numVertices;
+		}
+
+		if (chunkVertices.size() + numNewVertices > maxVerticesPerChunk) {
+			chunk.numIndices = uint32(i) - chunk.startIndex;
+			mesh.submeshes.push_back(chunk);
+			closeChunk();
+			chunk.startIndex = uint32(i);
+			chunk.baseVertex = int32(mesh.vertices.size());
+		}
+
+		if (meshlet) {
+			meshlet->baseVertex = chunk.baseVertex;
+		}
+
+		for (size_t corner = 0; corner < 3; ++corner) {
+			const uint32 sourceIndex = indices[i + corner];
+			if (chunkIndex[sourceIndex] == InvalidIndex) {
+				chunkIndex[sourceIndex] = uint32(chunkVertices.size());
+				chunkVertices.push_back(sourceIndex);
+			}
+			mesh.indices16[i + corner] = uint16(chunkIndex[sourceIndex]);
+		}
+	}
+
+	chunk.numIndices = uint32(indices.size()) - chunk.startIndex;
+	mesh.submeshes.push_back(chunk);
+	closeChunk();
+
+	return mesh.submeshes.size();
+}
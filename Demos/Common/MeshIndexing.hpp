@@ -0,0 +1,42 @@
+//
+// MeshIndexing.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/Mesh.hpp"
+
+
+/**
+* Chooses the index width of a Mesh.
+*
+* Meshes addressing at most 65535 vertices are given 16-bit indices, halving index
+* buffer size and bandwidth, while larger meshes either fall back to 32-bit indices or
+* are split into Submeshes that each address at most 65535 vertices.  Index 0xFFFF is
+* left unused, as it is the strip cut value of pipelines with primitive restart.
+*
+* Has no Windows dependencies.
+*/
+namespace MeshIndexing {
+
+	/// Number of vertices addressable by a 16-bit index other than the strip cut value.
+	const size_t MaxVerticesPer16BitChunk = 65535;
+
+	/// Stores the indices of 'mesh' as 16-bit if every vertex is addressable by them,
+	/// otherwise as 32-bit.  Does not change vertex data.
+	/// @return index size in bytes.
+	size_t selectIndexSize (
+		Mesh & mesh
+	);
+
+	/// Like selectIndexSize(), except that meshes too large for 16-bit indices are
+	/// split into Submeshes of at most 'maxVerticesPerChunk' vertices.  Triangles are
+	/// assigned to chunks in order, and vertices shared by several chunks are duplicated.
+	/// Meshlets are kept whole within a chunk and given its base vertex.
+	/// @return number of Submeshes created, 0 if the mesh already fit 16-bit indices.
+	size_t splitInto16BitChunks (
+		Mesh & mesh,
+		size_t maxVerticesPerChunk = MaxVerticesPer16BitChunk
+	);
+};
@@ -1,101 +1,323 @@
 #include "pch.h"
 using Microsoft::WRL::ComPtr;
 
-#include <iostream>
+#include <chrono>
+#include <stdexcept>
 
 #include "MeshLoader.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "MeshFileLoader.hpp"
+#include "MeshIndexing.hpp"
+#include "Meshlets.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshWelder.hpp"
+#include "JobSystem.hpp"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tinyobjloader\tiny_obj_loader.h>
 
+//---------------------------------------------------------------------------------------
+static const char * getFileName (
+	_In_ const char * assetPath
+) {
+	const char * fileName = strrchr(assetPath, '\\');
+	return fileName ? fileName + 1 : assetPath;
+}
 
 //---------------------------------------------------------------------------------------
-// Assemble interleaved data so all Mesh vertices are contiguous in memory.
-static void assembleVertexData (
-	_In_ const tinyobj::mesh_t & mesh,
-	_Inout_ std::vector<Mesh::Vertex> & vertexData
+// Hash of the settings that affect processed mesh data, stored in mesh caches.
+static uint64 hashLoadOptions (
+	_In_ const MeshLoader::LoadOptions & options
 ) {
-	const std::vector<uint> & indices = mesh.indices;
-	const std::vector<float> & positions = mesh.positions;
-	const std::vector<float> & normals = mesh.normals;
-	const std::vector<float> & texCoords = mesh.texcoords;
+	uint64 hash = MeshCache::hashBytes(&options.weldEpsilon, sizeof(options.weldEpsilon));
+	hash = MeshCache::hashBytes(&options.split16BitChunks, sizeof(options.split16BitChunks), hash);
+	hash = MeshCache::hashBytes(&options.optimizeIndices, sizeof(options.optimizeIndices), hash);
+	hash = MeshCache::hashBytes(&options.buildMeshlets, sizeof(options.buildMeshlets), hash);
+	return MeshCache::hashBytes(&options.numLods, sizeof(options.numLods), hash);
+}
+
+//---------------------------------------------------------------------------------------
+// Welds, optimizes, simplifies and indexes the freshly parsed 'mesh'.  Thread-safe.
+static void processMesh (
+	_In_ const char * meshName,
+	_Inout_ Mesh & mesh,
+	_In_ const MeshLoader::LoadOptions & options
+)
+{
+	auto timerStart = std::chrono::high_resolution_clock::now();
+
+	// The parser emits one vertex per face corner, merge the duplicates.
+	const size_t numCorners = mesh.vertices.size();
+	const size_t numUnique = MeshWelder::weldVertices(mesh, options.weldEpsilon);
+
+	auto weldEnd = std::chrono::high_resolution_clock::now();
+
+	MeshOptimizer::CacheStatistics before = {};
+	if (options.optimizeIndices) {
+		before = MeshOptimizer::analyzeVertexCache(mesh);
+
+		MeshOptimizer::optimizeVertexCache (
+			mesh.indices32.data(), mesh.indices32.size(), mesh.vertices.size()
+		);
+		MeshOptimizer::optimizeOverdraw (
+			mesh.indices32.data(), mesh.indices32.size(),
+			mesh.vertices.data(), mesh.vertices.size()
+		);
+	}
+
+	auto optimizeEnd = std::chrono::high_resolution_clock::now();
+
+	// Meshlets are grown from the optimized triangle order, and only reorder triangles,
+	// so vertex fetch order is still optimized afterwards.
+	if (options.buildMeshlets) {
+		Meshlets::buildMeshlets(mesh);
+
+		auto meshletEnd = std::chrono::high_resolution_clock::now();
+		double meshletSeconds = std::chrono::duration<double>(meshletEnd - optimizeEnd).count();
+
+		LOG_INFO("Built %zu meshlets for %s in %.2f ms (%.1f M triangles/s)",
+			mesh.meshlets.size(), meshName, meshletSeconds * 1000.0,
+			(mesh.indices32.size() / 3) / max(meshletSeconds, 1e-9) * 1e-6);
+	}
+
+	// Coarser levels are appended to the index buffer and reference the same vertices,
+	// so they can't be split into 16-bit chunks along with the full detail mesh.
+	const bool needsSplit = options.split16BitChunks &&
+		mesh.vertices.size() > MeshIndexing::MaxVerticesPer16BitChunk;
+	if (options.numLods > 1 && needsSplit) {
+		LOG_INFO("Skipped LOD generation for %s, it is split into 16-bit chunks", meshName);
+	} else if (options.numLods > 1) {
+		auto lodStart = std::chrono::high_resolution_clock::now();
 
-	vertexData.resize(indices.size());
+		MeshSimplifier::LodOptions lodOptions;
+		lodOptions.numLods = options.numLods;
+		MeshSimplifier::generateLods(mesh, lodOptions);
 
-	uint vertexIndex(0);
-	//-- Each index corresponds to 3 positions, 3 normals, and 2 texCoords:
-	for (uint index : indices) {
-		float * position = vertexData[vertexIndex].position;
-		position[0] = positions[3*index];
-		position[1] = positions[3*index+1];
-		position[2] = positions[3*index+2];
+		auto lodEnd = std::chrono::high_resolution_clock::now();
+		double lodSeconds = std::chrono::duration<double>(lodEnd - lodStart).count();
 
-		float * normal = vertexData[vertexIndex].normal;
-		normal[0] = normals[3*index];
-		normal[1] = normals[3*index+1];
-		normal[2] = normals[3*index+2];
+		LOG_INFO("Generated %zu LODs for %s in %.2f ms",
+			mesh.lods.size(), meshName, lodSeconds * 1000.0);
+		for (size_t i = 0; i < mesh.lods.size(); ++i) {
+			LOG_INFO("  LOD %zu: %u triangles, error %g",
+				i, mesh.lods[i].numIndices / 3, mesh.lods[i].error);
+		}
+	}
+
+	if (options.optimizeIndices) {
+		auto fetchStart = std::chrono::high_resolution_clock::now();
+		MeshOptimizer::optimizeVertexFetch(mesh);
+		auto fetchEnd = std::chrono::high_resolution_clock::now();
 
-		float * texCoord = vertexData[vertexIndex].texCoord;
-		texCoord[0] = texCoords[2*index];
-		texCoord[1] = texCoords[2*index+1];
+		double optimizeSeconds =
+			std::chrono::duration<double>((optimizeEnd - weldEnd) + (fetchEnd - fetchStart)).count();
 
-		++vertexIndex;
+		// Measured on the full detail mesh only, as 'before' was.
+		const size_t numIndices = mesh.lods.empty() ?
+			mesh.indices32.size() : mesh.lods[0].numIndices;
+		const MeshOptimizer::CacheStatistics after = MeshOptimizer::analyzeVertexCache (
+			mesh.indices32.data(), numIndices, mesh.vertices.size()
+		);
+		LOG_INFO("Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f in %.2f ms",
+			meshName, before.acmr, after.acmr, before.atvr, after.atvr,
+			optimizeSeconds * 1000.0);
 	}
+
+	// Keep 16-bit indices whenever the welded vertex count allows it.
+	if (options.split16BitChunks) {
+		MeshIndexing::splitInto16BitChunks(mesh);
+	} else {
+		MeshIndexing::selectIndexSize(mesh);
+	}
+
+	double weldSeconds = std::chrono::duration<double>(weldEnd - timerStart).count();
+
+	LOG_INFO("Welded %s: %zu -> %zu vertices (%.1f%% fewer) in %.2f ms",
+		meshName, numCorners, numUnique,
+		numCorners ? 100.0 * double(numCorners - numUnique) / numCorners : 0.0,
+		weldSeconds * 1000.0);
+	LOG_INFO("Indexed %s: %zu-bit indices, %zu submeshes",
+		meshName, mesh.indexSize() * 8, mesh.submeshes.size());
 }
 
 //---------------------------------------------------------------------------------------
-static void loadIndexData (
-	_In_ const tinyobj::mesh_t & mesh,
-	_Inout_ std::vector<Mesh::Index> & indexData
-) {
-	const auto & meshIndices = mesh.indices;
+// Parses and processes the memory mapped .obj file 'objFile' into 'mesh'.
+static void parseMesh (
+	_In_ const char * assetPath,
+	_In_ const MappedFile & objFile,
+	_Out_ Mesh & mesh,
+	_In_ const MeshLoader::LoadOptions & options
+)
+{
+	const char * fileName = getFileName(assetPath);
 
-	size_t numIndices = meshIndices.size();
-	indexData.resize(numIndices);
+	auto timerStart = std::chrono::high_resolution_clock::now();
 
-	for (size_t i(0); i < numIndices; ++i) {
-		// Convert index to appropriate type, then copy it.
-		indexData[i] = Mesh::Index(meshIndices[i]); 
+	try {
+		MeshFileLoader::parseObj (
+			reinterpret_cast<const char *>(objFile.data()), objFile.size(), mesh
+		);
 	}
+	catch (const std::runtime_error & error) {
+		ForceBreak("Error loading %s: %s", assetPath, error.what());
+	}
+
+	auto parseEnd = std::chrono::high_resolution_clock::now();
+	double parseSeconds = std::chrono::duration<double>(parseEnd - timerStart).count();
+
+	LOG_INFO("Loaded %s: %zu indices in %.2f ms (%.1f MB/s)",
+		fileName, mesh.indices32.size(), parseSeconds * 1000.0,
+		(objFile.size() / (1024.0 * 1024.0)) / max(parseSeconds, 1e-9));
 
+	processMesh(fileName, mesh, options);
 }
 
 //---------------------------------------------------------------------------------------
 void MeshLoader::loadMesh (
 	_In_ const char * assetPath,
-	_Out_ Mesh & mesh
+	_Out_ Mesh & mesh,
+	_In_ const LoadOptions & options
+)
+{
+	assert(assetPath);
+
+	MappedFile objFile;
+	if (!objFile.open(assetPath)) {
+		ForceBreak("Unable to open obj asset file: %s", assetPath);
+	}
+
+	parseMesh(assetPath, objFile, mesh, options);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshLoader::loadCachedMesh (
+	_In_ const char * assetPath,
+	_Out_ MappedMesh & mappedMesh,
+	_In_ const LoadOptions & options
+)
+{
+	assert(assetPath);
+
+	auto timerStart = std::chrono::high_resolution_clock::now();
+
+	const std::string cachePath = std::string(assetPath) + CacheFileExtension;
+	const uint64 settingsHash = hashLoadOptions(options);
+
+	MeshCache::SourceInfo source;
+	if (!MeshCache::queryFile(assetPath, source.timestamp, source.size)) {
+		ForceBreak("Unable to open obj asset file: %s", assetPath);
+	}
+
+	MappedFile objFile;
+
+	if (mappedMesh.open(cachePath.c_str())) {
+		const bool isCurrent = MeshCache::isCurrent (
+			mappedMesh.header(), assetPath, source, settingsHash, objFile
+		);
+
+		if (isCurrent) {
+			auto timerEnd = std::chrono::high_resolution_clock::now();
+			double seconds = std::chrono::duration<double>(timerEnd - timerStart).count();
+
+			LOG_INFO("Loaded cached %s: %zu vertices, %zu indices in %.2f ms",
+				getFileName(assetPath), mappedMesh.numVertices(), mappedMesh.numIndices(),
+				seconds * 1000.0);
+			return;
+		}
+
+		// Release the mapping so the stale cache file can be replaced.
+		mappedMesh.close();
+	}
+
+	if (!objFile.isOpen() && !objFile.open(assetPath)) {
+		ForceBreak("Unable to open obj asset file: %s", assetPath);
+	}
+	source.hash = MeshCache::hashBytes(objFile.data(), objFile.size());
+
+	Mesh mesh;
+	parseMesh(assetPath, objFile, mesh, options);
+
+	try {
+		MeshCache::write(cachePath.c_str(), mesh, source, settingsHash);
+	}
+	catch (const std::runtime_error & error) {
+		ForceBreak("Error writing mesh cache for %s: %s", assetPath, error.what());
+	}
+
+	if (!mappedMesh.open(cachePath.c_str())) {
+		ForceBreak("Unable to open mesh cache file: %s", cachePath.c_str());
+	}
+
+	auto timerEnd = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(timerEnd - timerStart).count();
+
+	LOG_INFO("Built mesh cache for %s in %.2f ms", getFileName(assetPath), seconds * 1000.0);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshLoader::loadMeshShapes (
+	_In_ const char * assetPath,
+	_Out_ std::vector<Mesh> & meshes,
+	_In_ JobSystem & jobSystem,
+	_In_ const LoadOptions & options
 )
 {
 	assert(assetPath);
 
-	std::string inputfile(assetPath);
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
+	auto timerStart = std::chrono::high_resolution_clock::now();
 
-	std::string err;
-	bool ret = tinyobj::LoadObj(shapes, materials, err, inputfile.c_str());
-	if (!err.empty()) { // `err` may contain warning messages.
-		std::cerr << err << std::endl;
+	MappedFile mappedFile;
+	if (!mappedFile.open(assetPath)) {
+		ForceBreak("Unable to open obj asset file: %s", assetPath);
 	}
-	if (!ret) {
-		// Problem loading .obj file.
-		throw;
+
+	// Attributes are shared by all shapes, so gather them up front.
+	MeshFileLoader::ObjFile objFile;
+	try {
+		MeshFileLoader::parseObjAttributes (
+			reinterpret_cast<const char *>(mappedFile.data()), mappedFile.size(), objFile
+		);
 	}
+	catch (const std::runtime_error & error) {
+		ForceBreak("Error loading %s: %s", assetPath, error.what());
+	}
+
+	const size_t numShapes = objFile.shapes.size();
+	meshes.clear();
+	meshes.resize(numShapes);
 
-	// Should only have a single shape with a single mesh.
-	assert(shapes.size() == 1);
-	tinyobj::mesh_t & tinyobjMesh = shapes[0].mesh;
+	// Jobs must not throw, so parse errors are reported once all shapes are done.
+	std::vector<std::string> errors(numShapes);
+
+	const char * fileName = getFileName(assetPath);
+
+	JobSystem::Handle handle;
+	for (size_t i = 0; i < numShapes; ++i) {
+		jobSystem.submit([&, i]() {
+			try {
+				MeshFileLoader::parseObjShape(objFile, i, meshes[i]);
+			}
+			catch (const std::runtime_error & error) {
+				errors[i] = error.what();
+				return;
+			}
+
+			const std::string meshName = std::string(fileName) + ":" + objFile.shapes[i].name;
+			processMesh(meshName.c_str(), meshes[i], options);
+		}, handle);
+	}
+	jobSystem.wait(handle);
 
-	std::vector<float> & normals = tinyobjMesh.normals;
-	std::vector<float> & texCoords = tinyobjMesh.texcoords;
-	size_t numPositions = tinyobjMesh.positions.size();
-	//--Insert dummy data so that positions, normals, and texCoords have the same size:
-	{
-		if (normals.size() == 0) { normals.resize(numPositions, 0.0f); }
-		if (texCoords.size() == 0) { texCoords.resize(numPositions, 0.0f); }
+	for (size_t i = 0; i < numShapes; ++i) {
+		if (!errors[i].empty()) {
+			ForceBreak("Error loading shape '%s' of %s: %s",
+				objFile.shapes[i].name.c_str(), assetPath, errors[i].c_str());
+		}
 	}
 
-	assembleVertexData(tinyobjMesh, mesh.vertices);
+	auto timerEnd = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(timerEnd - timerStart).count();
 
-	loadIndexData(tinyobjMesh, mesh.indices);
+	LOG_INFO("Loaded %s: %zu shapes on %u threads in %.2f ms",
+		fileName, numShapes, jobSystem.numWorkerThreads(), seconds * 1000.0);
 }
@@ -2,31 +2,64 @@
 
 #include <vector>
 
-struct Mesh {
-	/// Per Mesh Vertex data
-	struct Vertex {
-		float position[3];
-		float normal[3];
-		float texCoord[2];
-	};
-
-	/// Mesh Indices are in the range (0 - 65536].
-	typedef uint16 Index;
-
-	/// Contiguous Vertex data.
-	std::vector<Vertex> vertices;
+#include "Common/Mesh.hpp"
+#include "Common/MeshCache.hpp"
 
-	/// Contiguous Index data.
-	std::vector<Index> indices;
-};
+class JobSystem;
 
 
+/// Loads are thread-safe, so several different assets can be loaded at once by submitting
+/// each load as a JobSystem job.
 class MeshLoader {
 public:
-	/// Load data into Mesh object from a .obj asset file.
+	/// Suffix appended to an asset's path to form the path of its mesh cache.
+	static constexpr const char * CacheFileExtension = ".meshcache";
+
+	struct LoadOptions {
+		/// Vertices whose attributes differ by at most this much are welded together.
+		float weldEpsilon = 0.0f;
+
+		/// Split meshes with more than 65535 vertices into 16-bit indexed Submeshes
+		/// rather than falling back to 32-bit indices.
+		bool split16BitChunks = false;
+
+		/// Reorder triangles and vertices for post-transform cache, overdraw and
+		/// vertex fetch efficiency.
+		bool optimizeIndices = true;
+
+		/// Partition triangles into meshlets with bounds for CPU culling, see Meshlets.
+		bool buildMeshlets = true;
+
+		/// Maximum number of levels of detail, including the full detail mesh, see
+		/// MeshSimplifier.  Only the full detail mesh is kept when this is 1, or when
+		/// LODs would straddle 16-bit chunks.
+		uint numLods = 4;
+	};
+
+	/// Load data into Mesh object from a .obj asset file.  Duplicate vertices are
+	/// welded, after which 16-bit indices are used whenever the mesh allows it.
     static void loadMesh (
         _In_ const char * assetPath,
-		_Out_ Mesh & mesh
+		_Out_ Mesh & mesh,
+		_In_ const LoadOptions & options = LoadOptions()
     );
 
+	/// Like loadMesh(), but maps a binary cache of the processed mesh written next to
+	/// the .obj file.  The cache is built on first load, and rebuilt whenever the
+	/// source or the load options change.
+	static void loadCachedMesh (
+		_In_ const char * assetPath,
+		_Out_ MappedMesh & mappedMesh,
+		_In_ const LoadOptions & options = LoadOptions()
+	);
+
+	/// Loads each shape ('o' or 'g' group) of a .obj asset into its own Mesh.  Shapes
+	/// are parsed, welded, optimized and indexed in parallel, one job per shape on
+	/// 'jobSystem', and this call returns once all of them are done.
+	static void loadMeshShapes (
+		_In_ const char * assetPath,
+		_Out_ std::vector<Mesh> & meshes,
+		_In_ JobSystem & jobSystem,
+		_In_ const LoadOptions & options = LoadOptions()
+	);
 };
@@ -0,0 +1,413 @@
+//
+// MeshOptimizer.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+
+namespace {
+
+	const uint32 InvalidIndex = ~uint32(0);
+
+	// Forsyth's scoring parameters, tuned for a 32 entry LRU cache.
+	const uint MaxCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriangleScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	// Valence scores are tabulated up to this many remaining triangles.
+	const uint32 MaxTabulatedValence = 64;
+
+	struct ScoreTables {
+		float cache[MaxCacheSize];
+		float valence[MaxTabulatedValence + 1];
+
+		ScoreTables() {
+			for (uint i = 0; i < MaxCacheSize; ++i) {
+				if (i < 3) {
+					// Vertices of the last triangle get a fixed score, so that the next
+					// triangle does not simply reuse the same edge.
+					cache[i] = LastTriangleScore;
+				} else {
+					const float scale = 1.0f / float(MaxCacheSize - 3);
+					cache[i] = powf(1.0f - float(i - 3) * scale, CacheDecayPower);
+				}
+			}
+			valence[0] = 0.0f;
+			for (uint32 i = 1; i <= MaxTabulatedValence; ++i) {
+				valence[i] = ValenceBoostScale * powf(float(i), -ValenceBoostPower);
+			}
+		}
+	};
+
+	struct Float3 {
+		float x, y, z;
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static float vertexScore (
+	const ScoreTables & tables,
+	int cachePosition,
+	uint32 numActiveTriangles
+) {
+	if (numActiveTriangles == 0) {
+		// Vertex is not used by any remaining triangle.
+		return -1.0f;
+	}
+
+	float score = (cachePosition >= 0) ? tables.cache[cachePosition] : 0.0f;
+
+	if (numActiveTriangles <= MaxTabulatedValence) {
+		score += tables.valence[numActiveTriangles];
+	} else {
+		score += ValenceBoostScale * powf(float(numActiveTriangles), -ValenceBoostPower);
+	}
+	return score;
+}
+
+//---------------------------------------------------------------------------------------
+void MeshOptimizer::optimizeVertexCache (
+	uint32 * indices,
+	size_t numIndices,
+	size_t numVertices
+) {
+	assert(numIndices % 3 == 0);
+
+	static const ScoreTables tables;
+
+	const size_t numTriangles = numIndices / 3;
+	if (numTriangles == 0) {
+		return;
+	}
+
+	// Triangles adjacent to each vertex, stored contiguously.  The first
+	// numActiveTriangles[v] entries of a vertex are the triangles not yet emitted.
+	std::vector<uint32> numActiveTriangles(numVertices, 0);
+	for (size_t i = 0; i < numIndices; ++i) {
+		assert(indices[i] < numVertices);
+		++numActiveTriangles[indices[i]];
+	}
+
+	std::vector<uint32> adjacencyOffsets(numVertices);
+	uint32 offset = 0;
+	for (size_t v = 0; v < numVertices; ++v) {
+		adjacencyOffsets[v] = offset;
+		offset += numActiveTriangles[v];
+	}
+
+	std::vector<uint32> adjacency(numIndices);
+	{
+		std::vector<uint32> fill(adjacencyOffsets);
+		for (size_t i = 0; i < numIndices; ++i) {
+			adjacency[fill[indices[i]]++] = uint32(i / 3);
+		}
+	}
+
+	std::vector<int> cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (size_t v = 0; v < numVertices; ++v) {
+		vertexScores[v] = vertexScore(tables, -1, numActiveTriangles[v]);
+	}
+
+	std::vector<float> triangleScores(numTriangles);
+	uint32 bestTriangle = InvalidIndex;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < numTriangles; ++t) {
+		const uint32 * triangle = indices + t * 3;
+		triangleScores[t] = vertexScores[triangle[0]] + vertexScores[triangle[1]] +
+			vertexScores[triangle[2]];
+		if (triangleScores[t] > bestScore) {
+			bestScore = triangleScores[t];
+			bestTriangle = uint32(t);
+		}
+	}
+
+	std::vector<byte> isEmitted(numTriangles, 0);
+	std::vector<uint32> output(numIndices);
+
+	uint32 cache[MaxCacheSize + 3];
+	uint32 newCache[MaxCacheSize + 3];
+	uint cacheCount = 0;
+
+	size_t scanCursor = 0;
+
+	for (size_t outTriangle = 0; outTriangle < numTriangles; ++outTriangle) {
+		if (bestTriangle == InvalidIndex) {
+			// Nothing adjacent to the cache remains, continue from the next triangle
+			// in input order rather than searching the whole mesh.
+			while (isEmitted[scanCursor]) {
+				++scanCursor;
+			}
+			bestTriangle = uint32(scanCursor);
+		}
+
+		const uint32 * triangle = indices + size_t(bestTriangle) * 3;
+		output[outTriangle * 3 + 0] = triangle[0];
+		output[outTriangle * 3 + 1] = triangle[1];
+		output[outTriangle * 3 + 2] = triangle[2];
+		isEmitted[bestTriangle] = 1;
+
+		// Emitted triangle's vertices move to the front of the LRU cache.
+		uint newCacheCount = 0;
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32 v = triangle[corner];
+			newCache[newCacheCount++] = v;
+
+			// Remove the triangle from the vertex's active triangles.
+			uint32 * vertexTriangles = adjacency.data() + adjacencyOffsets[v];
+			const uint32 numActive = numActiveTriangles[v];
+			for (uint32 i = 0; i < numActive; ++i) {
+				if (vertexTriangles[i] == bestTriangle) {
+					vertexTriangles[i] = vertexTriangles[numActive - 1];
+					vertexTriangles[numActive - 1] = bestTriangle;
+					break;
+				}
+			}
+			--numActiveTriangles[v];
+		}
+		for (uint i = 0; i < cacheCount; ++i) {
+			const uint32 v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+				newCache[newCacheCount++] = v;
+			}
+		}
+
+		// Rescore every vertex whose cache position changed, including those just
+		// evicted, and propagate the change to their remaining triangles.
+		bestTriangle = InvalidIndex;
+		bestScore = -1.0f;
+		for (uint i = 0; i < newCacheCount; ++i) {
+			const uint32 v = newCache[i];
+			const int cachePosition = (i < MaxCacheSize) ? int(i) : -1;
+			cachePositions[v] = cachePosition;
+
+			const float score = vertexScore(tables, cachePosition, numActiveTriangles[v]);
+			const float delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			const uint32 * vertexTriangles = adjacency.data() + adjacencyOffsets[v];
+			for (uint32 j = 0; j < numActiveTriangles[v]; ++j) {
+				const uint32 t = vertexTriangles[j];
+				triangleScores[t] += delta;
+				if (cachePosition >= 0 && triangleScores[t] > bestScore) {
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCacheCount, MaxCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshOptimizer::optimizeOverdraw (
+	uint32 * indices,
+	size_t numIndices,
+	const Mesh::Vertex * vertices,
+	size_t numVertices
+) {
+	assert(numIndices % 3 == 0);
+
+	const size_t numTriangles = numIndices / 3;
+	if (numTriangles == 0) {
+		return;
+	}
+
+	// Split into clusters wherever a triangle misses the cache on all three vertices.
+	std::vector<size_t> clusterStarts;
+	{
+		std::vector<uint32> cacheTimestamps(numVertices, 0);
+		uint32 timestamp = DefaultCacheSize + 1;
+
+		for (size_t t = 0; t < numTriangles; ++t) {
+			uint numMisses = 0;
+			for (int corner = 0; corner < 3; ++corner) {
+				const uint32 v = indices[t * 3 + corner];
+				if (timestamp - cacheTimestamps[v] > DefaultCacheSize) {
+					cacheTimestamps[v] = timestamp++;
+					++numMisses;
+				}
+			}
+			if (t == 0 || numMisses == 3) {
+				clusterStarts.push_back(t);
+			}
+		}
+	}
+	const size_t numClusters = clusterStarts.size();
+	clusterStarts.push_back(numTriangles);
+
+	// Area weighted centroid and normal of each cluster, and of the whole mesh.
+	std::vector<Float3> clusterCentroids(numClusters);
+	std::vector<Float3> clusterNormals(numClusters);
+	Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < numClusters; ++c) {
+		Float3 centroid = { 0.0f, 0.0f, 0.0f };
+		Float3 normal = { 0.0f, 0.0f, 0.0f };
+		float clusterArea = 0.0f;
+
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+			const float * p0 = vertices[indices[t * 3 + 0]].position;
+			const float * p1 = vertices[indices[t * 3 + 1]].position;
+			const float * p2 = vertices[indices[t * 3 + 2]].position;
+
+			const Float3 e1 = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const Float3 e2 = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const Float3 n = {
+				e1.y * e2.z - e1.z * e2.y,
+				e1.z * e2.x - e1.x * e2.z,
+				e1.x * e2.y - e1.y * e2.x
+			};
+			const float area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+
+			centroid.x += (p0[0] + p1[0] + p2[0]) * area;
+			centroid.y += (p0[1] + p1[1] + p2[1]) * area;
+			centroid.z += (p0[2] + p1[2] + p2[2]) * area;
+			normal.x += n.x;
+			normal.y += n.y;
+			normal.z += n.z;
+			clusterArea += area;
+		}
+
+		meshCentroid.x += centroid.x;
+		meshCentroid.y += centroid.y;
+		meshCentroid.z += centroid.z;
+		meshArea += clusterArea;
+
+		const float invArea = (clusterArea > 0.0f) ? 1.0f / (3.0f * clusterArea) : 0.0f;
+		clusterCentroids[c] = { centroid.x * invArea, centroid.y * invArea, centroid.z * invArea };
+
+		const float normalLength = sqrtf(normal.x * normal.x + normal.y * normal.y +
+			normal.z * normal.z);
+		const float invLength = (normalLength > 0.0f) ? 1.0f / normalLength : 0.0f;
+		clusterNormals[c] = { normal.x * invLength, normal.y * invLength, normal.z * invLength };
+	}
+
+	const float invMeshArea = (meshArea > 0.0f) ? 1.0f / (3.0f * meshArea) : 0.0f;
+	meshCentroid = { meshCentroid.x * invMeshArea, meshCentroid.y * invMeshArea,
+		meshCentroid.z * invMeshArea };
+
+	// Clusters facing outwards, away from the center, are likely to occlude others.
+	std::vector<float> sortKeys(numClusters);
+	std::vector<uint32> clusterOrder(numClusters);
+	for (size_t c = 0; c < numClusters; ++c) {
+		sortKeys[c] =
+			(clusterCentroids[c].x - meshCentroid.x) * clusterNormals[c].x +
+			(clusterCentroids[c].y - meshCentroid.y) * clusterNormals[c].y +
+			(clusterCentroids[c].z - meshCentroid.z) * clusterNormals[c].z;
+		clusterOrder[c] = uint32(c);
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+		[&](uint32 a, uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32> output;
+	output.reserve(numIndices);
+	for (uint32 c : clusterOrder) {
+		output.insert(output.end(), indices + clusterStarts[c] * 3,
+			indices + clusterStarts[c + 1] * 3);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshOptimizer::optimizeVertexFetch (
+	Mesh & mesh
+) {
+	assert(mesh.indices16.empty());
+	assert(mesh.submeshes.empty());
+
+	std::vector<uint32> remap(mesh.vertices.size(), InvalidIndex);
+	std::vector<Mesh::Vertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for (uint32 & index : mesh.indices32) {
+		if (remap[index] == InvalidIndex) {
+			remap[index] = uint32(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	mesh.vertices.swap(vertices);
+}
+
+//---------------------------------------------------------------------------------------
+// Simulates a FIFO cache over the indices produced by 'getIndex'.
+template <typename GetIndex>
+static MeshOptimizer::CacheStatistics simulateFifoCache (
+	size_t numIndices,
+	size_t numVertices,
+	uint cacheSize,
+	GetIndex getIndex
+) {
+	// A vertex is in the cache if fewer than cacheSize misses have occurred since it
+	// was last inserted.
+	std::vector<uint32> cacheTimestamps(numVertices, 0);
+	uint32 timestamp = cacheSize + 1;
+
+	size_t numTransformed = 0;
+	for (size_t i = 0; i < numIndices; ++i) {
+		const uint32 v = getIndex(i);
+		assert(v < numVertices);
+		if (timestamp - cacheTimestamps[v] > cacheSize) {
+			cacheTimestamps[v] = timestamp++;
+			++numTransformed;
+		}
+	}
+
+	MeshOptimizer::CacheStatistics statistics;
+	statistics.numTransformed = numTransformed;
+	statistics.acmr = numIndices ? float(numTransformed) / float(numIndices / 3) : 0.0f;
+	statistics.atvr = numVertices ? float(numTransformed) / float(numVertices) : 0.0f;
+	return statistics;
+}
+
+//---------------------------------------------------------------------------------------
+MeshOptimizer::CacheStatistics MeshOptimizer::analyzeVertexCache (
+	const uint32 * indices,
+	size_t numIndices,
+	size_t numVertices,
+	uint cacheSize
+) {
+	return simulateFifoCache(numIndices, numVertices, cacheSize,
+		[indices](size_t i) { return indices[i]; });
+}
+
+//---------------------------------------------------------------------------------------
+MeshOptimizer::CacheStatistics MeshOptimizer::analyzeVertexCache (
+	const Mesh & mesh,
+	uint cacheSize
+) {
+	const size_t numIndices = mesh.numIndices();
+
+	// Base vertex of the Submesh containing each index, if any.
+	std::vector<int32> baseVertices;
+	if (!mesh.submeshes.empty()) {
+		baseVertices.resize(numIndices, 0);
+		for (const Mesh::Submesh & submesh : mesh.submeshes) {
+			std::fill_n(baseVertices.begin() + submesh.startIndex, submesh.numIndices,
+				submesh.baseVertex);
+		}
+	}
+
+	auto getIndex = [&](size_t i) {
+		const uint32 index = mesh.indices32.empty() ? mesh.indices16[i] : mesh.indices32[i];
+		return baseVertices.empty() ? index : uint32(int32(index) + baseVertices[i]);
+	};
+
+	return simulateFifoCache(numIndices, mesh.vertices.size(), cacheSize, getIndex);
+}
@@ -0,0 +1,80 @@
+//
+// MeshOptimizer.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/Mesh.hpp"
+
+
+/**
+* Index and vertex reordering passes that make indexed triangle lists cheaper to draw,
+* along with a CPU model of the post-transform vertex cache to measure them.
+*
+* The usual order of application is optimizeVertexCache(), then optimizeOverdraw(),
+* then optimizeVertexFetch(), each operating on triangle lists with 32-bit indices.
+*
+* Has no Windows dependencies.
+*/
+namespace MeshOptimizer {
+
+	/// Number of entries in the post-transform cache model used by analyzeVertexCache().
+	const uint DefaultCacheSize = 16;
+
+	struct CacheStatistics {
+		/// Vertices transformed, i.e. cache misses.
+		size_t numTransformed;
+
+		/// Average cache miss ratio: vertices transformed per triangle.  Ranges from
+		/// 0.5 for an ideal regular grid to 3.0 for no reuse at all.
+		float acmr;
+
+		/// Average transform to vertex ratio: vertices transformed per unique vertex.
+		/// 1.0 is ideal.
+		float atvr;
+	};
+
+	/// Reorders triangles using Tom Forsyth's linear-speed vertex cache optimization,
+	/// greedily emitting the triangle whose vertices score highest given a model LRU
+	/// cache and the number of triangles each vertex has yet to be used by.
+	void optimizeVertexCache (
+		uint32 * indices,
+		size_t numIndices,
+		size_t numVertices
+	);
+
+	/// Reorders clusters of cache-optimized triangles so that those facing away from
+	/// the mesh center, which tend to occlude the rest, are drawn first.  Clusters are
+	/// split at points where the vertex cache restarts, so ordering them costs little
+	/// cache efficiency.  Should follow optimizeVertexCache().
+	void optimizeOverdraw (
+		uint32 * indices,
+		size_t numIndices,
+		const Mesh::Vertex * vertices,
+		size_t numVertices
+	);
+
+	/// Reorders the vertices of 'mesh' by first use in its index stream so that vertex
+	/// fetches walk memory linearly, and rewrites the indices to match.  Unreferenced
+	/// vertices are dropped.  Requires 32-bit indices and no Submeshes.
+	void optimizeVertexFetch (
+		Mesh & mesh
+	);
+
+	/// Simulates a FIFO post-transform vertex cache of 'cacheSize' entries.
+	CacheStatistics analyzeVertexCache (
+		const uint32 * indices,
+		size_t numIndices,
+		size_t numVertices,
+		uint cacheSize = DefaultCacheSize
+	);
+
+	/// Simulates drawing every Submesh of 'mesh', or the whole mesh if it has none,
+	/// with either index width.
+	CacheStatistics analyzeVertexCache (
+		const Mesh & mesh,
+		uint cacheSize = DefaultCacheSize
+	);
+};
@@ -0,0 +1,776 @@
+//
+// MeshSimplifier.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#include "MeshOptimizer.hpp"
+#include "MeshWelder.hpp"
+
+
+namespace {
+
+	const uint32 InvalidIndex = ~uint32(0);
+
+	// Planes through open border edges are weighted heavily, so that borders keep
+	// their shape rather than merely staying in place.
+	const double BorderWeight = 10.0;
+
+	// Each pass makes the cheapest collapses up to this multiple of the cost that
+	// would reach the target, before re-evaluating costs around the changed positions.
+	const float PassCostSlack = 1.5f;
+
+	// Upper bound on the vertices sharing a position, beyond which it is locked.
+	const size_t MaxWedges = 16;
+
+	enum PositionKind : byte {
+		Interior,
+		Border,
+		Locked
+	};
+
+	/// Symmetric 4x4 error quadric, storing the upper triangle.
+	struct Quadric {
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+
+		// Total weight of the planes, used to report mean squared distances.
+		double weight;
+	};
+
+	struct Collapse {
+		float cost;
+		uint32 source;
+		uint32 target;
+	};
+
+	/// Edge collapse state of one triangle list.  Positions are identified by the
+	/// first vertex at each position, and triangles keep referring to vertices so that
+	/// seams survive.
+	class Simplifier {
+	public:
+		Simplifier (
+			const Mesh::Vertex * vertices,
+			size_t numVertices,
+			const uint32 * indices,
+			size_t numIndices
+		);
+
+		/// Continues collapsing edges until at most 'targetNumIndices' remain, or no
+		/// collapse within 'maxError' is possible.
+		void simplify (
+			size_t targetNumIndices,
+			float maxError
+		);
+
+		const std::vector<uint32> & indices() const { return m_indices; }
+
+		/// Largest collapse error so far, in model space units.
+		float error() const { return m_error; }
+
+	private:
+		const Mesh::Vertex * m_vertices;
+		size_t m_numVertices;
+
+		std::vector<uint32> m_positionIds;
+		std::vector<Quadric> m_quadrics;
+
+		std::vector<uint32> m_indices;
+		float m_error;
+
+		// Triangles around each position, rebuilt every pass.
+		std::vector<uint32> m_adjacencyOffsets;
+		std::vector<uint32> m_adjacentTriangles;
+
+		std::vector<PositionKind> m_kinds;
+		std::vector<bool> m_isDeleted;
+		std::vector<bool> m_isTouched;
+
+		// Positions whose best collapse was rejected, until their neighborhood changes.
+		std::vector<bool> m_isRejected;
+
+		// Scratch counts of triangles shared with each neighbor position.
+		std::vector<uint32> m_edgeCounts;
+		std::vector<uint32> m_neighbors;
+		std::vector<uint32> m_stamps;
+		uint32 m_stamp;
+
+
+		const float * position (
+			uint32 vertex
+		) const {
+			return m_vertices[vertex].position;
+		}
+
+		void buildAdjacency();
+
+		/// Collects the neighbors of position 'u' into m_neighbors, with the number
+		/// of triangles each edge belongs to in m_edgeCounts.
+		void gatherNeighbors (
+			uint32 u
+		);
+
+		void classifyPositions();
+
+		void addBorderQuadrics();
+
+		void collectCollapses (
+			std::vector<Collapse> & collapses
+		);
+
+		/// Collapses position 'u' onto its neighbor 'v' unless that would damage the
+		/// mesh.  @return number of triangles removed, 0 if the collapse was rejected.
+		size_t tryCollapse (
+			uint32 u,
+			uint32 v
+		);
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static Quadric planeQuadric (
+	const double normal[3],
+	double distance,
+	double weight
+) {
+	const double a = normal[0], b = normal[1], c = normal[2], d = distance;
+
+	Quadric q;
+	q.a00 = weight * a * a;  q.a01 = weight * a * b;  q.a02 = weight * a * c;  q.a03 = weight * a * d;
+	q.a11 = weight * b * b;  q.a12 = weight * b * c;  q.a13 = weight * b * d;
+	q.a22 = weight * c * c;  q.a23 = weight * c * d;
+	q.a33 = weight * d * d;
+	q.weight = weight;
+	return q;
+}
+
+//---------------------------------------------------------------------------------------
+static void addQuadric (
+	Quadric & q,
+	const Quadric & other
+) {
+	q.a00 += other.a00;  q.a01 += other.a01;  q.a02 += other.a02;  q.a03 += other.a03;
+	q.a11 += other.a11;  q.a12 += other.a12;  q.a13 += other.a13;
+	q.a22 += other.a22;  q.a23 += other.a23;
+	q.a33 += other.a33;
+	q.weight += other.weight;
+}
+
+//---------------------------------------------------------------------------------------
+// Mean squared distance of point 'p' from the planes accumulated in 'q'.
+static float evaluateQuadric (
+	const Quadric & q,
+	const float p[3]
+) {
+	const double x = p[0], y = p[1], z = p[2];
+
+	const double error =
+		q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x +
+		q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y +
+		q.a22 * z * z + 2.0 * q.a23 * z +
+		q.a33;
+
+	return q.weight > 0.0 ? float(std::max(error, 0.0) / q.weight) : 0.0f;
+}
+
+//---------------------------------------------------------------------------------------
+static void triangleNormal (
+	const float * p0,
+	const float * p1,
+	const float * p2,
+	double normal[3]
+) {
+	const double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+	const double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+	normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+//---------------------------------------------------------------------------------------
+Simplifier::Simplifier (
+	const Mesh::Vertex * vertices,
+	size_t numVertices,
+	const uint32 * indices,
+	size_t numIndices
+)
+	: m_vertices(vertices),
+	  m_numVertices(numVertices),
+	  m_error(0.0f),
+	  m_stamp(0)
+{
+	assert(numIndices % 3 == 0);
+
+	m_positionIds = MeshWelder::remapPositions(vertices, numVertices);
+
+	// Drop triangles that are degenerate by position, they can't be collapsed sensibly.
+	m_indices.reserve(numIndices);
+	for (size_t i = 0; i < numIndices; i += 3) {
+		const uint32 p0 = m_positionIds[indices[i]];
+		const uint32 p1 = m_positionIds[indices[i + 1]];
+		const uint32 p2 = m_positionIds[indices[i + 2]];
+		if (p0 != p1 && p1 != p2 && p2 != p0) {
+			m_indices.insert(m_indices.end(), indices + i, indices + i + 3);
+		}
+	}
+
+	m_quadrics.assign(numVertices, Quadric());
+	for (size_t i = 0; i < m_indices.size(); i += 3) {
+		const float * p0 = position(m_indices[i]);
+
+		double normal[3];
+		triangleNormal(p0, position(m_indices[i + 1]), position(m_indices[i + 2]), normal);
+
+		const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] +
+			normal[2] * normal[2]);
+		if (length == 0.0) {
+			continue;
+		}
+		for (int k = 0; k < 3; ++k) {
+			normal[k] /= length;
+		}
+
+		// Weight by area, so that small triangles don't dominate the error.
+		const double distance = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+		const Quadric q = planeQuadric(normal, distance, 0.5 * length);
+		for (int corner = 0; corner < 3; ++corner) {
+			addQuadric(m_quadrics[m_positionIds[m_indices[i + corner]]], q);
+		}
+	}
+
+	m_edgeCounts.assign(numVertices, 0);
+	m_stamps.assign(numVertices, 0);
+	m_isTouched.assign(numVertices, false);
+	m_isRejected.assign(numVertices, false);
+
+	buildAdjacency();
+	addBorderQuadrics();
+}
+
+//---------------------------------------------------------------------------------------
+void Simplifier::buildAdjacency()
+{
+	m_adjacencyOffsets.assign(m_numVertices + 1, 0);
+	for (uint32 index : m_indices) {
+		++m_adjacencyOffsets[m_positionIds[index] + 1];
+	}
+	for (size_t p = 0; p < m_numVertices; ++p) {
+		m_adjacencyOffsets[p + 1] += m_adjacencyOffsets[p];
+	}
+
+	m_adjacentTriangles.resize(m_indices.size());
+	std::vector<uint32> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < m_indices.size(); ++i) {
+		m_adjacentTriangles[fill[m_positionIds[m_indices[i]]]++] = uint32(i / 3);
+	}
+
+	m_isDeleted.assign(m_indices.size() / 3, false);
+}
+
+//---------------------------------------------------------------------------------------
+void Simplifier::gatherNeighbors (
+	uint32 u
+) {
+	for (uint32 neighbor : m_neighbors) {
+		m_edgeCounts[neighbor] = 0;
+	}
+	m_neighbors.clear();
+
+	for (uint32 a = m_adjacencyOffsets[u]; a < m_adjacencyOffsets[u + 1]; ++a) {
+		const uint32 triangle = m_adjacentTriangles[a];
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32 w = m_positionIds[m_indices[triangle * 3 + corner]];
+			if (w == u) {
+				continue;
+			}
+			if (m_edgeCounts[w]++ == 0) {
+				m_neighbors.push_back(w);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void Simplifier::classifyPositions()
+{
+	m_kinds.assign(m_numVertices, Locked);
+
+	for (uint32 u = 0; u < m_numVertices; ++u) {
+		if (m_positionIds[u] != u || m_adjacencyOffsets[u] == m_adjacencyOffsets[u + 1]) {
+			continue;
+		}
+
+		gatherNeighbors(u);
+
+		PositionKind kind = Interior;
+		for (uint32 w : m_neighbors) {
+			if (m_edgeCounts[w] > 2) {
+				// Non-manifold edge.
+				kind = Locked;
+				break;
+			}
+			if (m_edgeCounts[w] == 1) {
+				kind = Border;
+			}
+		}
+		m_kinds[u] = kind;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void Simplifier::addBorderQuadrics()
+{
+	for (size_t i = 0; i < m_indices.size(); i += 3) {
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32 a = m_indices[i + corner];
+			const uint32 b = m_indices[i + (corner + 1) % 3];
+			const uint32 pa = m_positionIds[a];
+			const uint32 pb = m_positionIds[b];
+
+			// An edge is on a border if no other triangle around 'pa' contains 'pb'.
+			uint32 count = 0;
+			for (uint32 t = m_adjacencyOffsets[pa]; t < m_adjacencyOffsets[pa + 1]; ++t) {
+				const uint32 * triangle = &m_indices[m_adjacentTriangles[t] * 3];
+				count += (m_positionIds[triangle[0]] == pb || m_positionIds[triangle[1]] == pb ||
+					m_positionIds[triangle[2]] == pb) ? 1 : 0;
+			}
+			if (count != 1) {
+				continue;
+			}
+
+			// Plane through the edge, perpendicular to the triangle.
+			double normal[3];
+			triangleNormal(position(m_indices[i]), position(m_indices[i + 1]),
+				position(m_indices[i + 2]), normal);
+
+			const float * p0 = position(a);
+			const float * p1 = position(b);
+			const double edge[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1],
+				double(p1[2]) - p0[2] };
+			double plane[3] = {
+				edge[1] * normal[2] - edge[2] * normal[1],
+				edge[2] * normal[0] - edge[0] * normal[2],
+				edge[0] * normal[1] - edge[1] * normal[0]
+			};
+			const double length = sqrt(plane[0] * plane[0] + plane[1] * plane[1] +
+				plane[2] * plane[2]);
+			if (length == 0.0) {
+				continue;
+			}
+			for (int k = 0; k < 3; ++k) {
+				plane[k] /= length;
+			}
+
+			const double edgeLength = sqrt(edge[0] * edge[0] + edge[1] * edge[1] +
+				edge[2] * edge[2]);
+			const double distance = -(plane[0] * p0[0] + plane[1] * p0[1] + plane[2] * p0[2]);
+
+			// Only the constraint, not the area, should count towards mean distances.
+			Quadric q = planeQuadric(plane, distance, BorderWeight * edgeLength * edgeLength);
+			q.weight = 0.0;
+			addQuadric(m_quadrics[pa], q);
+			addQuadric(m_quadrics[pb], q);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void Simplifier::collectCollapses (
+	std::vector<Collapse> & collapses
+) {
+	collapses.clear();
+
+	for (uint32 u = 0; u < m_numVertices; ++u) {
+		if (m_kinds[u] == Locked) {
+			continue;
+		}
+
+		gatherNeighbors(u);
+
+		// A rejected collapse may succeed once the previous pass changes its surroundings.
+		if (m_isRejected[u]) {
+			bool isChanged = m_isTouched[u];
+			for (size_t n = 0; n < m_neighbors.size() && !isChanged; ++n) {
+				isChanged = m_isTouched[m_neighbors[n]];
+			}
+			m_isRejected[u] = !isChanged;
+		}
+
+		Collapse best = { FLT_MAX, u, InvalidIndex };
+		for (uint32 v : m_neighbors) {
+			if (m_kinds[v] == Locked) {
+				continue;
+			}
+			// Borders may only slide along themselves.
+			if (m_kinds[u] == Border && (m_kinds[v] != Border || m_edgeCounts[v] != 1)) {
+				continue;
+			}
+
+			const float cost = evaluateQuadric(m_quadrics[u], position(v));
+			if (cost < best.cost) {
+				best.cost = cost;
+				best.target = v;
+			}
+		}
+
+		if (best.target != InvalidIndex) {
+			collapses.push_back(best);
+		}
+	}
+
+	std::sort(collapses.begin(), collapses.end(), [](const Collapse & a, const Collapse & b) {
+		return a.cost < b.cost;
+	});
+}
+
+//---------------------------------------------------------------------------------------
+size_t Simplifier::tryCollapse (
+	uint32 u,
+	uint32 v
+) {
+	const uint32 begin = m_adjacencyOffsets[u];
+	const uint32 end = m_adjacencyOffsets[u + 1];
+
+	// Each vertex at 'u' moves to the vertex at 'v' it shares a collapsing triangle
+	// with.  Vertices at 'u' without one, or with conflicting ones, lie across a seam
+	// from the edge, and collapsing it would smear their attributes.
+	uint32 wedgeFrom[MaxWedges];
+	uint32 wedgeTo[MaxWedges];
+	size_t numWedges = 0;
+
+	// Positions opposite the collapsing edge, the only neighbors 'u' and 'v' may share.
+	uint32 opposite[2] = { InvalidIndex, InvalidIndex };
+	size_t numOpposite = 0;
+
+	for (uint32 a = begin; a < end; ++a) {
+		const uint32 triangle = m_adjacentTriangles[a];
+		if (m_isDeleted[triangle]) {
+			continue;
+		}
+		const uint32 * corners = &m_indices[triangle * 3];
+
+		uint32 wu = InvalidIndex;
+		uint32 wv = InvalidIndex;
+		uint32 other = InvalidIndex;
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32 p = m_positionIds[corners[corner]];
+			if (p == u) {
+				wu = corners[corner];
+			} else if (p == v) {
+				wv = corners[corner];
+			} else {
+				other = p;
+			}
+		}
+		if (wv == InvalidIndex) {
+			continue;
+		}
+
+		if (numOpposite == 2) {
+			return 0;
+		}
+		opposite[numOpposite++] = other;
+
+		size_t w = 0;
+		while (w < numWedges && wedgeFrom[w] != wu) {
+			++w;
+		}
+		if (w == numWedges) {
+			if (numWedges == MaxWedges) {
+				return 0;
+			}
+			wedgeFrom[numWedges] = wu;
+			wedgeTo[numWedges] = wv;
+			++numWedges;
+		} else if (wedgeTo[w] != wv) {
+			return 0;
+		}
+	}
+
+	// Mark the neighbors of 'v' for the link condition.
+	++m_stamp;
+	for (uint32 a = m_adjacencyOffsets[v]; a < m_adjacencyOffsets[v + 1]; ++a) {
+		const uint32 triangle = m_adjacentTriangles[a];
+		if (m_isDeleted[triangle]) {
+			continue;
+		}
+		for (int corner = 0; corner < 3; ++corner) {
+			m_stamps[m_positionIds[m_indices[triangle * 3 + corner]]] = m_stamp;
+		}
+	}
+
+	const float * target = position(v);
+
+	for (uint32 a = begin; a < end; ++a) {
+		const uint32 triangle = m_adjacentTriangles[a];
+		if (m_isDeleted[triangle]) {
+			continue;
+		}
+		const uint32 * corners = &m_indices[triangle * 3];
+
+		int uCorner = -1;
+		bool hasV = false;
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32 p = m_positionIds[corners[corner]];
+			uCorner = (p == u) ? corner : uCorner;
+			hasV = hasV || (p == v);
+		}
+		if (hasV) {
+			continue;
+		}
+
+		size_t w = 0;
+		while (w < numWedges && wedgeFrom[w] != corners[uCorner]) {
+			++w;
+		}
+		if (w == numWedges) {
+			return 0;
+		}
+
+		// Shared neighbors other than the opposite positions would fold the surface.
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32 p = m_positionIds[corners[corner]];
+			if (p != u && m_stamps[p] == m_stamp && p != opposite[0] && p != opposite[1]) {
+				return 0;
+			}
+		}
+
+		// Reject collapses that flip, or nearly flip, the triangle.
+		const float * p[3] = {
+			position(corners[0]), position(corners[1]), position(corners[2])
+		};
+		double before[3];
+		triangleNormal(p[0], p[1], p[2], before);
+		p[uCorner] = target;
+		double after[3];
+		triangleNormal(p[0], p[1], p[2], after);
+
+		const double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+		const double lengths = sqrt(before[0] * before[0] + before[1] * before[1] +
+			before[2] * before[2]) * sqrt(after[0] * after[0] + after[1] * after[1] +
+			after[2] * after[2]);
+		if (dot <= 1e-2 * lengths) {
+			return 0;
+		}
+	}
+
+	size_t numRemoved = 0;
+
+	for (uint32 a = begin; a < end; ++a) {
+		const uint32 triangle = m_adjacentTriangles[a];
+		if (m_isDeleted[triangle]) {
+			continue;
+		}
+		uint32 * corners = &m_indices[triangle * 3];
+
+		for (int corner = 0; corner < 3; ++corner) {
+			if (m_positionIds[corners[corner]] == v) {
+				m_isDeleted[triangle] = true;
+			}
+		}
+		if (m_isDeleted[triangle]) {
+			++numRemoved;
+			continue;
+		}
+
+		for (int corner = 0; corner < 3; ++corner) {
+			for (size_t w = 0; w < numWedges; ++w) {
+				if (corners[corner] == wedgeFrom[w]) {
+					corners[corner] = wedgeTo[w];
+					break;
+				}
+			}
+		}
+	}
+
+	addQuadric(m_quadrics[v], m_quadrics[u]);
+	return numRemoved;
+}
+
+//---------------------------------------------------------------------------------------
+void Simplifier::simplify (
+	size_t targetNumIndices,
+	float maxError
+) {
+	const size_t targetNumTriangles = targetNumIndices / 3;
+	const float maxCost = maxError * maxError;
+
+	std::vector<Collapse> collapses;
+
+	while (m_indices.size() / 3 > targetNumTriangles) {
+		buildAdjacency();
+		classifyPositions();
+		collectCollapses(collapses);
+		if (collapses.empty()) {
+			break;
+		}
+
+		size_t numTriangles = m_indices.size() / 3;
+
+		// Each collapse removes about two triangles.  Collapses rejected before are
+		// left out of the goal, or they could hold every pass down to a single collapse.
+		const size_t goal = (numTriangles - targetNumTriangles + 1) / 2;
+		float passCost = collapses.back().cost;
+		for (size_t c = 0, numCounted = 0; c < collapses.size(); ++c) {
+			numCounted += m_isRejected[collapses[c].source] ? 0 : 1;
+			if (numCounted == goal) {
+				passCost = collapses[c].cost;
+				break;
+			}
+		}
+		passCost *= PassCostSlack;
+
+		std::fill(m_isTouched.begin(), m_isTouched.end(), false);
+		size_t numCollapsed = 0;
+
+		for (const Collapse & collapse : collapses) {
+			if (collapse.cost > maxCost || numTriangles <= targetNumTriangles) {
+				break;
+			}
+			if (collapse.cost > passCost && numCollapsed > 0) {
+				break;
+			}
+			if (m_isTouched[collapse.source] || m_isTouched[collapse.target]) {
+				continue;
+			}
+			const size_t numRemoved = tryCollapse(collapse.source, collapse.target);
+			if (numRemoved == 0) {
+				m_isRejected[collapse.source] = true;
+				continue;
+			}
+
+			m_isTouched[collapse.source] = true;
+			m_isTouched[collapse.target] = true;
+			m_error = std::max(m_error, sqrtf(collapse.cost));
+			numTriangles -= numRemoved;
+			++numCollapsed;
+		}
+
+		// Compact the surviving triangles.
+		size_t numKept = 0;
+		for (size_t t = 0; t < m_isDeleted.size(); ++t) {
+			if (!m_isDeleted[t]) {
+				std::copy(&m_indices[t * 3], &m_indices[t * 3] + 3, &m_indices[numKept * 3]);
+				++numKept;
+			}
+		}
+		m_indices.resize(numKept * 3);
+
+		if (numCollapsed == 0) {
+			break;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+float MeshSimplifier::simplify (
+	const Mesh::Vertex * vertices,
+	size_t numVertices,
+	const uint32 * indices,
+	size_t numIndices,
+	size_t targetNumIndices,
+	float maxError,
+	std::vector<uint32> & result
+) {
+	Simplifier simplifier(vertices, numVertices, indices, numIndices);
+	simplifier.simplify(targetNumIndices, maxError);
+
+	result = simplifier.indices();
+	return simplifier.error();
+}
+
+//---------------------------------------------------------------------------------------
+size_t MeshSimplifier::generateLods (
+	Mesh & mesh,
+	const LodOptions & options
+) {
+	assert(mesh.indices16.empty() && mesh.submeshes.empty());
+	assert(options.reduction > 0.0f && options.reduction < 1.0f);
+
+	const size_t numIndices = mesh.indices32.size();
+
+	mesh.lods.clear();
+	mesh.lods.push_back(Mesh::Lod{ 0, uint32(numIndices), 0.0f });
+
+	if (options.numLods <= 1 || numIndices == 0) {
+		return mesh.lods.size();
+	}
+
+	float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const Mesh::Vertex & vertex : mesh.vertices) {
+		for (int i = 0; i < 3; ++i) {
+			boundsMin[i] = std::min(boundsMin[i], vertex.position[i]);
+			boundsMax[i] = std::max(boundsMax[i], vertex.position[i]);
+		}
+	}
+	const float diagonal = sqrtf (
+		(boundsMax[0] - boundsMin[0]) * (boundsMax[0] - boundsMin[0]) +
+		(boundsMax[1] - boundsMin[1]) * (boundsMax[1] - boundsMin[1]) +
+		(boundsMax[2] - boundsMin[2]) * (boundsMax[2] - boundsMin[2])
+	);
+	const float maxError = options.maxRelativeError * diagonal;
+
+	// Every level continues from the previous one, while errors are still measured
+	// against the quadrics of the full detail surface.
+	Simplifier simplifier(mesh.vertices.data(), mesh.vertices.size(),
+		mesh.indices32.data(), numIndices);
+
+	size_t previousNumIndices = numIndices;
+
+	for (uint level = 1; level < options.numLods; ++level) {
+		const size_t targetNumIndices =
+			size_t(float(previousNumIndices / 3) * options.reduction) * 3;
+		simplifier.simplify(targetNumIndices, maxError);
+
+		// Stop once the error limit prevents at least half of the reduction.
+		const size_t lodNumIndices = simplifier.indices().size();
+		if (lodNumIndices == 0 ||
+			lodNumIndices > targetNumIndices + (previousNumIndices - targetNumIndices) / 2)
+		{
+			break;
+		}
+
+		const Mesh::Lod lod = {
+			uint32(mesh.indices32.size()), uint32(lodNumIndices), simplifier.error()
+		};
+		mesh.indices32.insert(mesh.indices32.end(), simplifier.indices().begin(),
+			simplifier.indices().end());
+		mesh.lods.push_back(lod);
+
+		MeshOptimizer::optimizeVertexCache (
+			mesh.indices32.data() + lod.startIndex, lod.numIndices, mesh.vertices.size()
+		);
+
+		previousNumIndices = lodNumIndices;
+	}
+
+	return mesh.lods.size();
+}
+
+//---------------------------------------------------------------------------------------
+size_t MeshSimplifier::selectLod (
+	const Mesh::Lod * lods,
+	size_t numLods,
+	float distance,
+	float pixelsPerUnit,
+	float maxPixelError
+) {
+	// Clamp so that viewers inside the bounds always get full detail.
+	const float pixelScale = pixelsPerUnit / std::max(distance, FLT_MIN);
+
+	// Errors grow with each level.
+	size_t selected = 0;
+	while (selected + 1 < numLods && lods[selected + 1].error * pixelScale <= maxPixelError) {
+		++selected;
+	}
+	return selected;
+}
@@ -0,0 +1,77 @@
+//
+// MeshSimplifier.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/Mesh.hpp"
+
+
+/**
+* Reduces the triangle count of meshes by quadric error metric edge collapses, and
+* selects between the resulting levels of detail by their projected screen space error.
+*
+* Collapses are half-edge collapses, moving one vertex onto a neighbor, so simplified
+* triangle lists index a subset of the original vertices and every LOD can share a
+* single vertex buffer.  Each position accumulates the plane quadrics of the triangles
+* around it, and a collapse costs the mean squared distance of the moved position from
+* those planes.
+*
+* Open borders only collapse along themselves, and normal or UV seams, where several
+* vertices share a position, only collapse along the seam so that the attributes on
+* either side stay intact.  Collapses that would flip a triangle are rejected.
+*
+* Has no Windows dependencies.
+*/
+namespace MeshSimplifier {
+
+	struct LodOptions {
+		/// Maximum number of levels, including the full detail mesh.
+		uint numLods = 4;
+
+		/// Target triangle count of each level, relative to the previous level.
+		float reduction = 0.5f;
+
+		/// Largest error allowed for any level, relative to the diagonal of the mesh
+		/// bounding box.
+		float maxRelativeError = 0.05f;
+	};
+
+	/// Simplifies the triangle list 'indices' until at most 'targetNumIndices' remain,
+	/// or until the next collapse would move the surface further than 'maxError'.
+	/// @return error of the simplified triangle list in 'result', in model space units.
+	float simplify (
+		const Mesh::Vertex * vertices,
+		size_t numVertices,
+		const uint32 * indices,
+		size_t numIndices,
+		size_t targetNumIndices,
+		float maxError,
+		std::vector<uint32> & result
+	);
+
+	/// Fills mesh.lods with successively simplified versions of the mesh, appending
+	/// their indices after those of the full detail mesh.  Levels stop once a
+	/// reduction can't be reached within the error limit.  Requires 32-bit indices and
+	/// no Submeshes.
+	/// @return number of levels, including the full detail mesh.
+	size_t generateLods (
+		Mesh & mesh,
+		const LodOptions & options = LodOptions()
+	);
+
+	/// Selects the coarsest level whose error, projected at 'distance' from the
+	/// viewer, covers at most 'maxPixelError' pixels.  'pixelsPerUnit' is the number of
+	/// pixels a unit length spans at a distance of one, i.e. the vertical projection
+	/// scale times half the viewport height.
+	size_t selectLod (
+		const Mesh::Lod * lods,
+		size_t numLods,
+		float distance,
+		float pixelsPerUnit,
+		float maxPixelError = 1.0f
+	);
+};
@@ -0,0 +1,232 @@
+//
+// MeshWelder.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "MeshWelder.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+
+	const uint32 InvalidIndex = ~uint32(0);
+
+	// Number of floats in a Mesh::Vertex.
+	const size_t NumVertexComponents = sizeof(Mesh::Vertex) / sizeof(float);
+
+	static_assert(sizeof(Mesh::Vertex) == NumVertexComponents * sizeof(float),
+		"Mesh::Vertex is expected to contain only floats.");
+}
+
+//---------------------------------------------------------------------------------------
+static inline const float * components (
+	const Mesh::Vertex & vertex
+) {
+	return vertex.position;
+}
+
+//---------------------------------------------------------------------------------------
+// Final mixing step of MurmurHash3.
+static inline uint32 mixHash (
+	uint32 h
+) {
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+//---------------------------------------------------------------------------------------
+static uint32 hashVertex (
+	const Mesh::Vertex & vertex
+) {
+	const float * v = components(vertex);
+
+	uint32 h = 0;
+	for (size_t i = 0; i < NumVertexComponents; ++i) {
+		// Map -0 onto +0 so that both hash, and compare, as equal.
+		const float f = (v[i] == 0.0f) ? 0.0f : v[i];
+		uint32 bits;
+		memcpy(&bits, &f, sizeof(bits));
+		h = mixHash(h ^ bits) + 0x9e3779b9;
+	}
+	return h;
+}
+
+//---------------------------------------------------------------------------------------
+static uint32 hashCell (
+	int64 x,
+	int64 y,
+	int64 z
+) {
+	return mixHash(uint32(x) * 73856093u ^ uint32(y) * 19349663u ^ uint32(z) * 83492791u);
+}
+
+//---------------------------------------------------------------------------------------
+static inline bool verticesEqual (
+	const Mesh::Vertex & a,
+	const Mesh::Vertex & b
+) {
+	const float * va = components(a);
+	const float * vb = components(b);
+	for (size_t i = 0; i < NumVertexComponents; ++i) {
+		if (va[i] != vb[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+static inline bool verticesWithinEpsilon (
+	const Mesh::Vertex & a,
+	const Mesh::Vertex & b,
+	float epsilon
+) {
+	const float * va = components(a);
+	const float * vb = components(b);
+	for (size_t i = 0; i < NumVertexComponents; ++i) {
+		if (std::fabs(va[i] - vb[i]) > epsilon) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+size_t MeshWelder::weldVertices (
+	Mesh & mesh,
+	float epsilon
+) {
+	assert(epsilon >= 0.0f);
+	assert(mesh.submeshes.empty());
+
+	std::vector<Mesh::Vertex> & vertices = mesh.vertices;
+	const size_t numVertices = vertices.size();
+	if (numVertices == 0) {
+		return 0;
+	}
+
+	size_t numBuckets = 1;
+	while (numBuckets < numVertices) {
+		numBuckets <<= 1;
+	}
+	const uint32 bucketMask = uint32(numBuckets - 1);
+
+	// Each bucket heads a chain of unique vertices, linked through nextInBucket.
+	std::vector<uint32> bucketHeads(numBuckets, InvalidIndex);
+	std::vector<uint32> nextInBucket(numVertices);
+	std::vector<uint32> remap(numVertices);
+
+	const float invCellSize = (epsilon > 0.0f) ? 1.0f / epsilon : 0.0f;
+
+	// Unique vertices are compacted to the front of the array as they are found.  Since
+	// numUnique <= i, vertex i is never overwritten before it is read.
+	uint32 numUnique = 0;
+
+	for (size_t i = 0; i < numVertices; ++i) {
+		const Mesh::Vertex vertex = vertices[i];
+		uint32 match = InvalidIndex;
+		uint32 bucket;
+
+		if (epsilon == 0.0f) {
+			bucket = hashVertex(vertex) & bucketMask;
+			for (uint32 j = bucketHeads[bucket]; j != InvalidIndex; j = nextInBucket[j]) {
+				if (verticesEqual(vertices[j], vertex)) {
+					match = j;
+					break;
+				}
+			}
+		} else {
+			// Bucket by position on a grid with cells 'epsilon' wide.  Any vertex within
+			// epsilon must then lie in this cell or one of its 26 neighbors.
+			const int64 cx = int64(std::floor(vertex.position[0] * invCellSize));
+			const int64 cy = int64(std::floor(vertex.position[1] * invCellSize));
+			const int64 cz = int64(std::floor(vertex.position[2] * invCellSize));
+			bucket = hashCell(cx, cy, cz) & bucketMask;
+
+			for (int dz = -1; dz <= 1 && match == InvalidIndex; ++dz) {
+			for (int dy = -1; dy <= 1 && match == InvalidIndex; ++dy) {
+			for (int dx = -1; dx <= 1 && match == InvalidIndex; ++dx) {
+				const uint32 neighbor = hashCell(cx + dx, cy + dy, cz + dz) & bucketMask;
+				for (uint32 j = bucketHeads[neighbor]; j != InvalidIndex; j = nextInBucket[j]) {
+					if (verticesWithinEpsilon(vertices[j], vertex, epsilon)) {
+						match = j;
+						break;
+					}
+				}
+			}
+			}
+			}
+		}
+
+		if (match == InvalidIndex) {
+			match = numUnique++;
+			vertices[match] = vertex;
+			nextInBucket[match] = bucketHeads[bucket];
+			bucketHeads[bucket] = match;
+		}
+		remap[i] = match;
+	}
+
+	for (uint16 & index : mesh.indices16) {
+		assert(index < numVertices);
+		index = uint16(remap[index]);
+	}
+	for (uint32 & index : mesh.indices32) {
+		assert(index < numVertices);
+		index = remap[index];
+	}
+
+	vertices.resize(numUnique);
+	vertices.shrink_to_fit();
+
+	return numUnique;
+}
+
+//---------------------------------------------------------------------------------------
+std::vector<uint32> MeshWelder::remapPositions (
+	const Mesh::Vertex * vertices,
+	size_t numVertices
+) {
+	size_t tableSize = 1;
+	while (tableSize < numVertices * 2) {
+		tableSize *= 2;
+	}
+	std::vector<uint32> table(tableSize, InvalidIndex);
+	std::vector<uint32> remap(numVertices);
+
+	for (size_t v = 0; v < numVertices; ++v) {
+		const float * position = vertices[v].position;
+
+		uint32 h = 0;
+		for (size_t i = 0; i < 3; ++i) {
+			const float f = (position[i] == 0.0f) ? 0.0f : position[i];
+			uint32 bits;
+			memcpy(&bits, &f, sizeof(bits));
+			h = mixHash(h ^ bits) + 0x9e3779b9;
+		}
+
+		// Open addressing with linear probing.
+		for (size_t slot = h & (tableSize - 1); ; slot = (slot + 1) & (tableSize - 1)) {
+			if (table[slot] == InvalidIndex) {
+				table[slot] = uint32(v);
+				remap[v] = uint32(v);
+				break;
+			}
+			const float * other = vertices[table[slot]].position;
+			if (other[0] == position[0] && other[1] == position[1] && other[2] == position[2]) {
+				remap[v] = table[slot];
+				break;
+			}
+		}
+	}
+
+	return remap;
+}
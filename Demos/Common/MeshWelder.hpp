@@ -0,0 +1,42 @@
+//
+// MeshWelder.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/Mesh.hpp"
+
+
+/**
+* Merges duplicate vertices of an indexed Mesh and rewrites its index list to refer
+* to the remaining unique vertices.
+*
+* Vertices are bucketed in a hash table that chains through the unique vertices found
+* so far, so welding runs in expected linear time with a handful of allocations.  With
+* an epsilon of zero only bitwise identical position/normal/texCoord tuples are merged
+* (treating -0 and +0 as equal).  With a positive epsilon vertices whose attributes all
+* differ by at most epsilon are merged, in which case the first vertex encountered is
+* kept.
+*
+* Has no Windows dependencies.
+*/
+namespace MeshWelder {
+
+	/// Welds the vertices of 'mesh' in place.  Unique vertices keep the relative order
+	/// of their first occurrence.  Must be called before the mesh is split into
+	/// Submeshes.
+	/// @return number of vertices remaining.
+	size_t weldVertices (
+		Mesh & mesh,
+		float epsilon = 0.0f
+	);
+
+	/// Maps each vertex to the first vertex sharing its exact position, identifying the
+	/// vertices that a welded mesh keeps apart only because of normal or UV seams.
+	std::vector<uint32> remapPositions (
+		const Mesh::Vertex * vertices,
+		size_t numVertices
+	);
+};
@@ -0,0 +1,406 @@
+//
+// Meshlets.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "Meshlets.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#include "MeshWelder.hpp"
+
+
+namespace {
+
+	const uint32 InvalidIndex = ~uint32(0);
+
+	// Normal cones wider than this (as the minimum dot product between the axis and a
+	// triangle normal) never cull anything, so they are disabled.
+	const float MinConeDot = 0.1f;
+}
+
+//---------------------------------------------------------------------------------------
+// Computes the bounding sphere and normal cone of 'meshlet' from its triangles.
+static void computeBounds (
+	Mesh::Meshlet & meshlet,
+	const uint32 * indices,
+	const Mesh::Vertex * vertices
+) {
+	float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	const uint32 * begin = indices + meshlet.startIndex;
+	const uint32 * end = begin + meshlet.numIndices;
+
+	for (const uint32 * index = begin; index != end; ++index) {
+		const float * position = vertices[*index].position;
+		for (int i = 0; i < 3; ++i) {
+			boundsMin[i] = std::min(boundsMin[i], position[i]);
+			boundsMax[i] = std::max(boundsMax[i], position[i]);
+		}
+	}
+
+	float radiusSquared = 0.0f;
+	for (int i = 0; i < 3; ++i) {
+		meshlet.center[i] = 0.5f * (boundsMin[i] + boundsMax[i]);
+	}
+	for (const uint32 * index = begin; index != end; ++index) {
+		const float * position = vertices[*index].position;
+		const float dx = position[0] - meshlet.center[0];
+		const float dy = position[1] - meshlet.center[1];
+		const float dz = position[2] - meshlet.center[2];
+		radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+	}
+	meshlet.radius = sqrtf(radiusSquared);
+
+	// Cone axis is the average of the unit face normals, its cutoff is derived from
+	// the normal furthest from the axis.
+	std::vector<float> normals;
+	normals.reserve(meshlet.numIndices);
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (const uint32 * index = begin; index != end; index += 3) {
+		const float * p0 = vertices[index[0]].position;
+		const float * p1 = vertices[index[1]].position;
+		const float * p2 = vertices[index[2]].position;
+
+		const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		float normal[3] = {
+			e1[1] * e2[2] - e1[2] * e2[1],
+			e1[2] * e2[0] - e1[0] * e2[2],
+			e1[0] * e2[1] - e1[1] * e2[0]
+		};
+
+		const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] +
+			normal[2] * normal[2]);
+		if (length == 0.0f) {
+			// Degenerate triangles are never rasterized.
+			continue;
+		}
+		for (int i = 0; i < 3; ++i) {
+			normal[i] /= length;
+			axis[i] += normal[i];
+			normals.push_back(normal[i]);
+		}
+	}
+
+	const float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	float minDot = -1.0f;
+	if (axisLength > 0.0f) {
+		for (int i = 0; i < 3; ++i) {
+			axis[i] /= axisLength;
+		}
+		minDot = 1.0f;
+		for (size_t n = 0; n < normals.size(); n += 3) {
+			const float dot = axis[0] * normals[n] + axis[1] * normals[n + 1] +
+				axis[2] * normals[n + 2];
+			minDot = std::min(minDot, dot);
+		}
+	}
+
+	if (minDot < MinConeDot) {
+		meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+		meshlet.coneCutoff = 1.0f;
+	} else {
+		meshlet.coneAxis[0] = axis[0];
+		meshlet.coneAxis[1] = axis[1];
+		meshlet.coneAxis[2] = axis[2];
+
+		// Sine of the cone's half angle, i.e. cosine of its complement.
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+size_t Meshlets::buildMeshlets (
+	Mesh & mesh,
+	size_t maxVertices,
+	size_t maxTriangles
+) {
+	assert(maxVertices >= 3 && maxTriangles >= 1);
+	assert(mesh.indices16.empty() && mesh.submeshes.empty() && mesh.lods.empty());
+	assert(mesh.indices32.size() % 3 == 0);
+
+	const std::vector<uint32> & indices = mesh.indices32;
+	const size_t numVertices = mesh.vertices.size();
+	const size_t numTriangles = indices.size() / 3;
+
+	mesh.meshlets.clear();
+	if (numTriangles == 0) {
+		return 0;
+	}
+
+	// Connectivity is by position, since vertices on normal or UV seams are distinct
+	// yet their triangles are still neighbors.
+	const std::vector<uint32> positionIds = MeshWelder::remapPositions (
+		mesh.vertices.data(), numVertices
+	);
+
+	// Triangles adjacent to each position, in compressed row form.
+	std::vector<uint32> adjacencyOffsets(numVertices + 1, 0);
+	for (uint32 index : indices) {
+		++adjacencyOffsets[positionIds[index] + 1];
+	}
+	for (size_t v = 0; v < numVertices; ++v) {
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<uint32> adjacentTriangles(indices.size());
+	{
+		std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i) {
+			adjacentTriangles[fill[positionIds[indices[i]]]++] = uint32(i / 3);
+		}
+	}
+
+	// Triangles not yet emitted that use each position.  Positions with few remaining
+	// triangles are preferred, so that meshlets finish off regions instead of leaving
+	// stragglers behind.
+	std::vector<uint32> liveTriangles(numVertices);
+	for (size_t v = 0; v < numVertices; ++v) {
+		liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+	}
+
+	std::vector<bool> isEmitted(numTriangles, false);
+
+	// Meshlet each vertex last joined, only vertices of the current meshlet match.
+	std::vector<uint32> vertexMeshlet(numVertices, InvalidIndex);
+	std::vector<uint32> meshletVertices;
+	meshletVertices.reserve(maxVertices);
+
+	std::vector<uint32> newIndices;
+	newIndices.reserve(indices.size());
+
+	size_t nextSeed = 0;
+
+	auto newVertexCount = [&](uint32 triangle, uint32 meshletIndex) {
+		uint32 count = 0;
+		for (size_t corner = 0; corner < 3; ++corner) {
+			count += (vertexMeshlet[indices[triangle * 3 + corner]] != meshletIndex) ? 1 : 0;
+		}
+		return count;
+	};
+
+	// Unemitted triangles touching the current meshlet, gathered as positions join it.
+	std::vector<uint32> candidates;
+	std::vector<uint32> positionMeshlet(numVertices, InvalidIndex);
+	std::vector<uint32> candidateMeshlet(numTriangles, InvalidIndex);
+
+	auto emitTriangle = [&](uint32 triangle, uint32 meshletIndex) {
+		isEmitted[triangle] = true;
+		for (size_t corner = 0; corner < 3; ++corner) {
+			const uint32 index = indices[triangle * 3 + corner];
+			if (vertexMeshlet[index] != meshletIndex) {
+				vertexMeshlet[index] = meshletIndex;
+				meshletVertices.push_back(index);
+			}
+
+			const uint32 position = positionIds[index];
+			--liveTriangles[position];
+			newIndices.push_back(index);
+
+			if (positionMeshlet[position] != meshletIndex) {
+				positionMeshlet[position] = meshletIndex;
+				for (uint32 a = adjacencyOffsets[position]; a < adjacencyOffsets[position + 1]; ++a) {
+					const uint32 neighbor = adjacentTriangles[a];
+					if (!isEmitted[neighbor] && candidateMeshlet[neighbor] != meshletIndex) {
+						candidateMeshlet[neighbor] = meshletIndex;
+						candidates.push_back(neighbor);
+					}
+				}
+			}
+		}
+	};
+
+	while (newIndices.size() < indices.size()) {
+		const uint32 meshletIndex = uint32(mesh.meshlets.size());
+
+		while (isEmitted[nextSeed]) {
+			++nextSeed;
+		}
+
+		Mesh::Meshlet meshlet = {};
+		meshlet.startIndex = uint32(newIndices.size());
+		meshletVertices.clear();
+		candidates.clear();
+
+		emitTriangle(uint32(nextSeed), meshletIndex);
+		size_t numMeshletTriangles = 1;
+
+		while (numMeshletTriangles < maxTriangles) {
+			uint32 bestTriangle = InvalidIndex;
+			uint32 bestNewVertices = 4;
+			uint32 bestLiveCount = ~uint32(0);
+
+			for (size_t c = 0; c < candidates.size(); ) {
+				const uint32 triangle = candidates[c];
+				if (isEmitted[triangle]) {
+					candidates[c] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+				++c;
+
+				const uint32 numNew = newVertexCount(triangle, meshletIndex);
+				if (meshletVertices.size() + numNew > maxVertices) {
+					continue;
+				}
+
+				uint32 liveCount = 0;
+				for (size_t corner = 0; corner < 3; ++corner) {
+					liveCount += liveTriangles[positionIds[indices[triangle * 3 + corner]]];
+				}
+
+				if (numNew < bestNewVertices ||
+					(numNew == bestNewVertices && liveCount < bestLiveCount))
+				{
+					bestTriangle = triangle;
+					bestNewVertices = numNew;
+					bestLiveCount = liveCount;
+				}
+			}
+
+			if (bestTriangle == InvalidIndex) {
+				// Neighborhood exhausted or full, start the next meshlet elsewhere.
+				break;
+			}
+
+			emitTriangle(bestTriangle, meshletIndex);
+			++numMeshletTriangles;
+		}
+
+		meshlet.numIndices = uint32(newIndices.size()) - meshlet.startIndex;
+		meshlet.numVertices = uint32(meshletVertices.size());
+		mesh.meshlets.push_back(meshlet);
+	}
+
+	mesh.indices32.swap(newIndices);
+
+	for (Mesh::Meshlet & meshlet : mesh.meshlets) {
+		computeBounds(meshlet, mesh.indices32.data(), mesh.vertices.data());
+	}
+
+	return mesh.meshlets.size();
+}
+
+//---------------------------------------------------------------------------------------
+Meshlets::Frustum Meshlets::extractFrustum (
+	const float modelViewProjection[16],
+	bool clipDepth
+) {
+	// Row vectors are transformed as clip = v * M, so each clip coordinate is the dot
+	// product of v with a column of M.
+	auto column = [&](int c, int row) {
+		return modelViewProjection[row * 4 + c];
+	};
+
+	Frustum frustum;
+	frustum.numPlanes = clipDepth ? 6 : 4;
+
+	for (int row = 0; row < 4; ++row) {
+		const float x = column(0, row);
+		const float y = column(1, row);
+		const float z = column(2, row);
+		const float w = column(3, row);
+
+		frustum.planes[0][row] = w + x;  // Left
+		frustum.planes[1][row] = w - x;  // Right
+		frustum.planes[2][row] = w + y;  // Bottom
+		frustum.planes[3][row] = w - y;  // Top
+		frustum.planes[4][row] = z;      // Near, D3D depth starts at 0.
+		frustum.planes[5][row] = w - z;  // Far
+	}
+
+	// Normalize so that plane distances are comparable with sphere radii.
+	for (uint p = 0; p < 6; ++p) {
+		float * plane = frustum.planes[p];
+		const float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] +
+			plane[2] * plane[2]);
+		if (length > 0.0f) {
+			for (int i = 0; i < 4; ++i) {
+				plane[i] /= length;
+			}
+		}
+	}
+
+	return frustum;
+}
+
+//---------------------------------------------------------------------------------------
+bool Meshlets::isOutsideFrustum (
+	const Mesh::Meshlet & meshlet,
+	const Frustum & frustum
+) {
+	for (uint p = 0; p < frustum.numPlanes; ++p) {
+		const float * plane = frustum.planes[p];
+		const float distance = plane[0] * meshlet.center[0] + plane[1] * meshlet.center[1] +
+			plane[2] * meshlet.center[2] + plane[3];
+		if (distance < -meshlet.radius) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------------------
+bool Meshlets::isBackFacing (
+	const Mesh::Meshlet & meshlet,
+	const float cameraPosition[3]
+) {
+	// Conservative cone test using the bounding sphere in place of the cone apex.
+	const float d[3] = {
+		meshlet.center[0] - cameraPosition[0],
+		meshlet.center[1] - cameraPosition[1],
+		meshlet.center[2] - cameraPosition[2]
+	};
+	const float distance = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	const float dot = d[0] * meshlet.coneAxis[0] + d[1] * meshlet.coneAxis[1] +
+		d[2] * meshlet.coneAxis[2];
+
+	return dot >= meshlet.coneCutoff * distance + meshlet.radius;
+}
+
+//---------------------------------------------------------------------------------------
+Meshlets::CullStatistics Meshlets::cullMeshlets (
+	const Mesh::Meshlet * meshlets,
+	size_t numMeshlets,
+	const Frustum & frustum,
+	const float cameraPosition[3],
+	std::vector<Mesh::Submesh> & drawRanges
+) {
+	CullStatistics stats = {};
+	drawRanges.clear();
+
+	for (size_t i = 0; i < numMeshlets; ++i) {
+		const Mesh::Meshlet & meshlet = meshlets[i];
+
+		if (isOutsideFrustum(meshlet, frustum)) {
+			++stats.numFrustumCulled;
+			continue;
+		}
+		if (isBackFacing(meshlet, cameraPosition)) {
+			++stats.numBackFacing;
+			continue;
+		}
+		++stats.numVisible;
+
+		if (!drawRanges.empty()) {
+			Mesh::Submesh & last = drawRanges.back();
+			if (last.startIndex + last.numIndices == meshlet.startIndex &&
+				last.baseVertex == meshlet.baseVertex)
+			{
+				last.numIndices += meshlet.numIndices;
+				continue;
+			}
+		}
+
+		drawRanges.push_back(Mesh::Submesh{ meshlet.startIndex, meshlet.numIndices,
+			meshlet.baseVertex });
+	}
+
+	stats.numDrawRanges = drawRanges.size();
+	return stats;
+}
@@ -0,0 +1,89 @@
+//
+// Meshlets.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/Mesh.hpp"
+
+
+/**
+* Splits meshes into meshlets, small clusters of triangles with a bounding sphere and
+* a normal cone each, and culls them on the CPU against a view.
+*
+* Meshlets are contiguous ranges of the index buffer, so the visible ones are drawn
+* with ordinary indexed draws.  Adjacent visible meshlets are merged into a single
+* draw range by cullMeshlets().
+*
+* Has no Windows dependencies.
+*/
+namespace Meshlets {
+
+	/// Default meshlet limits, matching common mesh shader output limits.
+	const size_t MaxVertices = 64;
+	const size_t MaxTriangles = 124;
+
+	/// Reorders the triangles of 'mesh' into meshlets of at most 'maxVertices' unique
+	/// vertices and 'maxTriangles' triangles, filling mesh.meshlets.  Each meshlet is
+	/// grown greedily from a seed triangle by adding the neighboring triangle that
+	/// introduces the fewest new vertices.  Triangles keep their relative order as
+	/// far as possible, so this is best run after MeshOptimizer::optimizeOverdraw().
+	/// Requires 32-bit indices, no Submeshes and no LODs.
+	/// @return number of meshlets built.
+	size_t buildMeshlets (
+		Mesh & mesh,
+		size_t maxVertices = MaxVertices,
+		size_t maxTriangles = MaxTriangles
+	);
+
+	/// Clip space planes of a view, pointing inwards.
+	struct Frustum {
+		float planes[6][4];
+		uint numPlanes;
+	};
+
+	/// Extracts the frustum planes of 'modelViewProjection', a row-major matrix that
+	/// transforms row vectors to D3D clip space, as stored by XMStoreFloat4x4().
+	/// Resulting planes are in model space.  Without 'clipDepth' only the side
+	/// planes are extracted, for pipelines that disable depth clipping.
+	Frustum extractFrustum (
+		const float modelViewProjection[16],
+		bool clipDepth = true
+	);
+
+	/// True if 'meshlet' lies entirely outside 'frustum'.
+	bool isOutsideFrustum (
+		const Mesh::Meshlet & meshlet,
+		const Frustum & frustum
+	);
+
+	/// True if every triangle of 'meshlet' faces away from a viewer at
+	/// 'cameraPosition', given in model space.
+	bool isBackFacing (
+		const Mesh::Meshlet & meshlet,
+		const float cameraPosition[3]
+	);
+
+	struct CullStatistics {
+		size_t numVisible;
+		size_t numFrustumCulled;
+		size_t numBackFacing;
+
+		/// Draws needed for the visible meshlets after merging adjacent ones.
+		size_t numDrawRanges;
+	};
+
+	/// Replaces the contents of 'drawRanges' with the index ranges of the meshlets that
+	/// are neither outside 'frustum' nor back facing, merging ranges that are adjacent
+	/// and share a base vertex.
+	CullStatistics cullMeshlets (
+		const Mesh::Meshlet * meshlets,
+		size_t numMeshlets,
+		const Frustum & frustum,
+		const float cameraPosition[3],
+		std::vector<Mesh::Submesh> & drawRanges
+	);
+};
@@ -0,0 +1,404 @@
+//
+// MipGenerator.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "MipGenerator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "JobSystem.hpp"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define MIP_GENERATOR_SSE2
+	#include <emmintrin.h>
+#endif
+
+#if defined(MIP_GENERATOR_SSE2) && defined(__AVX__)
+	#define MIP_GENERATOR_AVX
+	#include <immintrin.h>
+#endif
+
+
+namespace {
+
+	// Levels each band of rows is carried down before its last level is stored for
+	// the next pass.  16 rows of a 1024 wide level fit in 256 KB of floats.
+	const uint LevelsPerBand = 4;
+
+	// Filtered values are quantized to 16 bits to index the encoding table, which
+	// separates even the darkest adjacent sRGB values by about 20 steps.
+	const uint EncodeBits = 16;
+	const uint EncodeTableSize = 1 << EncodeBits;
+	const float EncodeScale = float(EncodeTableSize - 1);
+
+	/// Conversions between stored 8-bit values and filtered floats.
+	struct TransferTables {
+		explicit TransferTables (
+			bool isSrgb
+		);
+
+		float toLinear[256];
+		byte fromLinear[EncodeTableSize];
+	};
+
+	/// Parameters shared by every band of a chain.
+	struct Chain {
+		ImageView source;
+		const ImageDestination * levels;
+		const TransferTables * colorTables;
+		const TransferTables * alphaTables;
+	};
+}
+
+//---------------------------------------------------------------------------------------
+TransferTables::TransferTables (
+	bool isSrgb
+) {
+	for (uint i = 0; i < 256; ++i) {
+		const double value = i / 255.0;
+		if (!isSrgb) {
+			toLinear[i] = float(value);
+		} else if (value <= 0.04045) {
+			toLinear[i] = float(value / 12.92);
+		} else {
+			toLinear[i] = float(std::pow((value + 0.055) / 1.055, 2.4));
+		}
+	}
+
+	for (uint i = 0; i < EncodeTableSize; ++i) {
+		const double value = i / double(EncodeTableSize - 1);
+		double encoded = value;
+		if (isSrgb) {
+			encoded = value <= 0.0031308 ?
+				value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+		}
+		fromLinear[i] = byte(std::min(255.0, std::floor(encoded * 255.0 + 0.5)));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static const TransferTables & transferTables (
+	bool isSrgb
+) {
+	static const TransferTables linearTables(false);
+	static const TransferTables srgbTables(true);
+	return isSrgb ? srgbTables : linearTables;
+}
+
+//---------------------------------------------------------------------------------------
+// Converts 'width' stored pixels to filtered floats.
+static void expandRow (
+	const Chain & chain,
+	const byte * src,
+	uint width,
+	float * dst
+) {
+	const float * colorToLinear = chain.colorTables->toLinear;
+	const float * alphaToLinear = chain.alphaTables->toLinear;
+
+	for (uint x = 0; x < width; ++x) {
+		dst[x * 4 + 0] = colorToLinear[src[x * 4 + 0]];
+		dst[x * 4 + 1] = colorToLinear[src[x * 4 + 1]];
+		dst[x * 4 + 2] = colorToLinear[src[x * 4 + 2]];
+		dst[x * 4 + 3] = alphaToLinear[src[x * 4 + 3]];
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Averages 2x2 blocks of 'row0' and 'row1', 'srcWidth' pixels each, into 'dstWidth'
+// pixels.  Every path adds horizontal pairs first, then the two rows.
+static void downsampleRow (
+	const float * row0,
+	const float * row1,
+	uint srcWidth,
+	float * dst,
+	uint dstWidth
+) {
+	if (srcWidth == 1) {
+		for (uint c = 0; c < 4; ++c) {
+			dst[c] = ((row0[c] + row0[c]) + (row1[c] + row1[c])) * 0.25f;
+		}
+		return;
+	}
+
+	uint x = 0;
+
+#ifdef MIP_GENERATOR_AVX
+	// Two destination pixels per iteration, regrouping the four source pixels of each
+	// row as (p0, p2) and (p1, p3) so the pairs add vertically.
+	const __m256 quarter8 = _mm256_set1_ps(0.25f);
+	for (; x + 2 <= dstWidth; x += 2) {
+		const __m256 a0 = _mm256_loadu_ps(row0 + x * 8);
+		const __m256 a1 = _mm256_loadu_ps(row0 + x * 8 + 8);
+		const __m256 b0 = _mm256_loadu_ps(row1 + x * 8);
+		const __m256 b1 = _mm256_loadu_ps(row1 + x * 8 + 8);
+
+		const __m256 sumA = _mm256_add_ps (
+			_mm256_permute2f128_ps(a0, a1, 0x20), _mm256_permute2f128_ps(a0, a1, 0x31)
+		);
+		const __m256 sumB = _mm256_add_ps (
+			_mm256_permute2f128_ps(b0, b1, 0x20), _mm256_permute2f128_ps(b0, b1, 0x31)
+		);
+		_mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_add_ps(sumA, sumB), quarter8));
+	}
+#endif
+
+#ifdef MIP_GENERATOR_SSE2
+	// One RGBA pixel per register.
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	for (; x < dstWidth; ++x) {
+		const __m128 sumA = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+		const __m128 sumB = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+		_mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_add_ps(sumA, sumB), quarter));
+	}
+#endif
+
+	for (; x < dstWidth; ++x) {
+		for (uint c = 0; c < 4; ++c) {
+			const float sumA = row0[x * 8 + c] + row0[x * 8 + 4 + c];
+			const float sumB = row1[x * 8 + c] + row1[x * 8 + 4 + c];
+			dst[x * 4 + c] = (sumA + sumB) * 0.25f;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint32 packPixel (
+	const Chain & chain,
+	const int32 * indices
+) {
+	const byte * colorFromLinear = chain.colorTables->fromLinear;
+	return uint32(colorFromLinear[indices[0]]) |
+		(uint32(colorFromLinear[indices[1]]) << 8) |
+		(uint32(colorFromLinear[indices[2]]) << 16) |
+		(uint32(chain.alphaTables->fromLinear[indices[3]]) << 24);
+}
+
+//---------------------------------------------------------------------------------------
+// Converts 'width' filtered pixels back to stored 8-bit values.  'dst' is only
+// written, in whole pixels.
+static void compressRow (
+	const Chain & chain,
+	const float * src,
+	uint width,
+	byte * dst
+) {
+	uint x = 0;
+
+#ifdef MIP_GENERATOR_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(EncodeScale);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	// Four pixels per 16 byte store.
+	for (; x + 4 <= width; x += 4) {
+		alignas(16) int32 indices[16];
+		for (uint i = 0; i < 4; ++i) {
+			__m128 value = _mm_loadu_ps(src + (x + i) * 4);
+			value = _mm_min_ps(_mm_max_ps(value, zero), one);
+			const __m128i index = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			_mm_store_si128(reinterpret_cast<__m128i *>(indices + i * 4), index);
+		}
+
+		const __m128i pixels = _mm_setr_epi32 (
+			int32(packPixel(chain, indices + 0)), int32(packPixel(chain, indices + 4)),
+			int32(packPixel(chain, indices + 8)), int32(packPixel(chain, indices + 12))
+		);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), pixels);
+	}
+#endif
+
+	for (; x < width; ++x) {
+		int32 indices[4];
+		for (uint c = 0; c < 4; ++c) {
+			float value = src[x * 4 + c];
+			value = std::min(std::max(value, 0.0f), 1.0f);
+			indices[c] = int32(value * EncodeScale + 0.5f);
+		}
+
+		const uint32 pixel = packPixel(chain, indices);
+		memcpy(dst + x * 4, &pixel, 4);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Filters band 'bandIndex' of level 'sourceLevel' down 'numBandLevels' levels.  A band
+// at level l covers rows [bandIndex << k, (bandIndex + 1) << k) >> (l - sourceLevel),
+// with k = numBandLevels, so each band only reads its own rows.  Level 0 is read from
+// the chain's source, expanded to floats two rows at a time just before they are
+// filtered, other levels from the floats in 'carryIn'.  The floats of the last level
+// go to 'carryOut', if not null.
+static void filterBand (
+	const Chain & chain,
+	uint sourceLevel,
+	uint numBandLevels,
+	uint bandIndex,
+	const float * carryIn,
+	float * carryOut
+) {
+	const uint bandRows = 1u << numBandLevels;
+
+	uint width = MipGenerator::mipSize(chain.source.width, sourceLevel);
+	uint height = MipGenerator::mipSize(chain.source.height, sourceLevel);
+	uint rowBegin = bandIndex * bandRows;
+	const uint rowEnd = std::min(rowBegin + bandRows, height);
+
+	std::vector<float> current;
+	std::vector<float> next;
+	const float * currentRows = nullptr;
+
+	const bool isFromSource = sourceLevel == 0;
+	if (isFromSource) {
+		const ImageDestination & level0 = chain.levels[0];
+		for (uint y = rowBegin; y < rowEnd && level0.data != chain.source.data; ++y) {
+			memcpy (
+				level0.data + y * level0.rowPitch,
+				chain.source.data + y * chain.source.rowPitch,
+				size_t(width) * 4
+			);
+		}
+		current.resize(size_t(width) * 8);
+	} else {
+		currentRows = carryIn + size_t(rowBegin) * width * 4;
+	}
+
+	for (uint i = 1; i <= numBandLevels; ++i) {
+		const uint level = sourceLevel + i;
+		const uint levelWidth = MipGenerator::mipSize(chain.source.width, level);
+		const uint levelHeight = MipGenerator::mipSize(chain.source.height, level);
+		const uint levelRowBegin = (bandIndex * bandRows) >> i;
+		const uint levelRowEnd = std::min(((bandIndex + 1) * bandRows) >> i, levelHeight);
+		if (levelRowBegin >= levelRowEnd) {
+			break;
+		}
+
+		float * levelRows;
+		if (i == numBandLevels && carryOut) {
+			levelRows = carryOut + size_t(levelRowBegin) * levelWidth * 4;
+		} else {
+			next.resize(size_t(levelRowEnd - levelRowBegin) * levelWidth * 4);
+			levelRows = next.data();
+		}
+
+		const ImageDestination & destination = chain.levels[level];
+		for (uint y = levelRowBegin; y < levelRowEnd; ++y) {
+			const uint row0 = y * 2;
+			const uint row1 = std::min(y * 2 + 1, height - 1);
+			float * dstRow = levelRows + size_t(y - levelRowBegin) * levelWidth * 4;
+
+			const float * srcRow0;
+			const float * srcRow1;
+			if (isFromSource && i == 1) {
+				const byte * source = chain.source.data;
+				const size_t sourcePitch = chain.source.rowPitch;
+				srcRow0 = current.data();
+				srcRow1 = current.data() + size_t(width) * 4;
+				expandRow(chain, source + row0 * sourcePitch, width, current.data());
+				expandRow(chain, source + row1 * sourcePitch, width, current.data() + size_t(width) * 4);
+			} else {
+				srcRow0 = currentRows + size_t(row0 - rowBegin) * width * 4;
+				srcRow1 = currentRows + size_t(row1 - rowBegin) * width * 4;
+			}
+
+			downsampleRow(srcRow0, srcRow1, width, dstRow, levelWidth);
+			compressRow(chain, dstRow, levelWidth, destination.data + y * destination.rowPitch);
+		}
+
+		if (levelRows == next.data()) {
+			current.swap(next);
+		}
+		currentRows = levelRows;
+		width = levelWidth;
+		height = levelHeight;
+		rowBegin = levelRowBegin;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+uint MipGenerator::numMipLevels (
+	uint width,
+	uint height
+) {
+	uint numLevels = 1;
+	for (uint size = std::max(width, height); size > 1; size >>= 1) {
+		++numLevels;
+	}
+	return numLevels;
+}
+
+//---------------------------------------------------------------------------------------
+void MipGenerator::generateMipChain (
+	const ImageView & source,
+	const ImageDestination * levels,
+	uint numLevels,
+	bool isSrgb,
+	JobSystem * jobSystem
+) {
+	assert(source.data && levels);
+	assert(numLevels >= 1 && numLevels <= numMipLevels(source.width, source.height));
+	for (uint level = 0; level < numLevels; ++level) {
+		assert(levels[level].canHold (
+			mipSize(source.width, level), mipSize(source.height, level)
+		));
+	}
+
+	Chain chain;
+	chain.source = source;
+	chain.levels = levels;
+	chain.colorTables = &transferTables(isSrgb);
+	chain.alphaTables = &transferTables(false);
+
+	if (numLevels == 1) {
+		for (uint y = 0; y < source.height && levels[0].data != source.data; ++y) {
+			memcpy (
+				levels[0].data + y * levels[0].rowPitch,
+				source.data + y * source.rowPitch,
+				size_t(source.width) * 4
+			);
+		}
+		return;
+	}
+
+	// Each pass filters bands of its source level down up to LevelsPerBand levels, and
+	// hands the floats of its last level to the next pass.
+	std::vector<float> carryIn;
+	std::vector<float> carryOut;
+	for (uint sourceLevel = 0; sourceLevel + 1 < numLevels;) {
+		const uint numBandLevels = std::min(LevelsPerBand, numLevels - 1 - sourceLevel);
+		const uint lastLevel = sourceLevel + numBandLevels;
+		const bool hasNextPass = lastLevel + 1 < numLevels;
+		if (hasNextPass) {
+			carryOut.resize (
+				size_t(mipSize(source.width, lastLevel)) * mipSize(source.height, lastLevel) * 4
+			);
+		}
+
+		const uint bandRows = 1u << numBandLevels;
+		const uint numBands = (mipSize(source.height, sourceLevel) + bandRows - 1) / bandRows;
+		const float * bandCarryIn = carryIn.data();
+		float * bandCarryOut = hasNextPass ? carryOut.data() : nullptr;
+
+		if (jobSystem && numBands > 1) {
+			JobSystem::Handle handle;
+			for (uint band = 0; band < numBands; ++band) {
+				jobSystem->submit([&, band]() {
+					filterBand(chain, sourceLevel, numBandLevels, band, bandCarryIn, bandCarryOut);
+				}, handle);
+			}
+			jobSystem->wait(handle);
+		} else {
+			for (uint band = 0; band < numBands; ++band) {
+				filterBand(chain, sourceLevel, numBandLevels, band, bandCarryIn, bandCarryOut);
+			}
+		}
+
+		carryIn.swap(carryOut);
+		sourceLevel = lastLevel;
+	}
+}
@@ -0,0 +1,59 @@
+//
+// MipGenerator.hpp
+//
+#pragma once
+
+#include "Common/BasicTypes.hpp"
+#include "Common/ImageTypes.hpp"
+
+class JobSystem;
+
+
+/**
+* Builds mip chains for 8-bit RGBA textures on the CPU.
+*
+* Each level halves the previous one, rounding down to at least 1 pixel as D3D12
+* sizes mips, with a 2x2 box filter.  Dropping the last row or column of odd sized
+* levels keeps that footprint exact.  For sRGB textures the filter runs on linear
+* values, so darker texels do not dominate the averages.  Alpha is always linear and
+* color is not alpha weighted.
+*
+* Levels are filtered in 32-bit float, and each level is built from the float
+* results of the previous one, so rounding does not accumulate down the chain.
+* Work is split into bands of source rows, and each band goes down several levels
+* before it leaves the cache, with bands spread across JobSystem jobs.  Row filtering
+* uses SSE2, or AVX when compiled for it, and gives the same results as the scalar
+* path.
+*
+* Has no Windows dependencies.
+*/
+namespace MipGenerator {
+
+	/// Levels in a full chain down to 1x1.
+	uint numMipLevels (
+		uint width,
+		uint height
+	);
+
+	/// Size of 'level' along a dimension that is 'size' at level 0.
+	inline uint mipSize (
+		uint size,
+		uint level
+	) {
+		return (size >> level) > 0 ? (size >> level) : 1;
+	}
+
+	/// Copies 'source' to levels[0] and writes levels 1 to numLevels - 1 filtered
+	/// from it.  Each level must hold mipSize() of the source dimensions.  levels[0]
+	/// may be the source itself, with the same row pitch, which skips the copy.
+	/// @param isSrgb - true filters in linear space, for _SRGB formats.
+	/// @param jobSystem - runs the bands in parallel, nullptr runs them on the calling
+	/// thread.
+	void generateMipChain (
+		const ImageView & source,
+		const ImageDestination * levels,
+		uint numLevels,
+		bool isSrgb,
+		JobSystem * jobSystem
+	);
+};
@@ -0,0 +1,62 @@
+//
+// ParallelCommandRecorder.cpp
+//
+#include "pch.h"
+
+#include "ParallelCommandRecorder.hpp"
+
+
+//---------------------------------------------------------------------------------------
+ParallelCommandRecorder::ParallelCommandRecorder (
+	CommandListPool * commandListPool,
+	JobSystem * jobSystem
+)
+	: m_commandListPool(commandListPool),
+	  m_jobSystem(jobSystem)
+{
+	assert(commandListPool && jobSystem);
+}
+
+//---------------------------------------------------------------------------------------
+void ParallelCommandRecorder::record (
+	uint numChunks,
+	const RecordChunk & recordChunk
+) {
+	// Acquire every pair up front, as the pool is not thread-safe.  Acquired lists are
+	// already open for recording.
+	const size_t firstPair = m_recordedPairs.size();
+	for (uint chunk = 0; chunk < numChunks; ++chunk) {
+		m_recordedPairs.push_back(m_commandListPool->acquire(D3D12_COMMAND_LIST_TYPE_DIRECT));
+		m_commandLists.push_back(m_recordedPairs.back().cmdList.Get());
+	}
+
+	JobSystem::Handle handle;
+	for (uint chunk = 0; chunk < numChunks; ++chunk) {
+		ID3D12GraphicsCommandList * commandList = m_recordedPairs[firstPair + chunk].cmdList.Get();
+		m_jobSystem->submit (
+			[commandList, chunk, &recordChunk]() {
+				recordChunk(commandList, chunk);
+
+				CHECK_D3D_RESULT (
+					commandList->Close()
+				);
+			},
+			handle
+		);
+	}
+
+	// Records chunks on this thread too, until all have been closed.
+	m_jobSystem->wait(handle);
+}
+
+//---------------------------------------------------------------------------------------
+void ParallelCommandRecorder::endFrame (
+	Timeline & timeline,
+	Timeline::Value retireValue
+) {
+	for (CommandListPool::CommandList & pair : m_recordedPairs) {
+		m_commandListPool->release(std::move(pair), timeline, retireValue);
+	}
+	m_recordedPairs.clear();
+	m_commandLists.clear();
+}
@@ -0,0 +1,69 @@
+//
+// ParallelCommandRecorder.hpp
+//
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/CommandListPool.hpp"
+#include "Common/JobSystem.hpp"
+
+/**
+* Records a frame's draws into several direct command lists at once, on the workers
+* of a JobSystem.
+*
+* record() splits the work into chunks, records each on its own command allocator
+* and list pair taken from a CommandListPool, so that no two threads ever record into
+* the same allocator, and blocks until all are closed, running chunks on the calling
+* thread in the meantime.  The lists recorded during a frame are returned in chunk
+* order by commandLists(), to be submitted in a single ExecuteCommandLists call, then
+* handed back to the pool by endFrame().
+*/
+class ParallelCommandRecorder {
+public:
+	/// Records chunk 'chunkIndex' of the work into 'commandList', which has been reset
+	/// and has no state set.  Called concurrently for different chunks.
+	typedef std::function<void(ID3D12GraphicsCommandList * commandList, uint chunkIndex)>
+		RecordChunk;
+
+	ParallelCommandRecorder (
+		CommandListPool * commandListPool,
+		JobSystem * jobSystem
+	);
+
+	/// Records 'numChunks' chunks in parallel, each on its own command list, appending
+	/// the lists to those recorded so far this frame.
+	void record (
+		uint numChunks,
+		const RecordChunk & recordChunk
+	);
+
+	/// Lists recorded since the last endFrame(), in the order they were recorded.
+	ID3D12CommandList * const * commandLists() const { return m_commandLists.data(); }
+
+	uint numCommandLists() const { return uint(m_commandLists.size()); }
+
+	/// Returns the lists of the frame to the pool once they have been submitted, to be
+	/// recycled once 'timeline' reaches 'retireValue'.
+	void endFrame (
+		Timeline & timeline,
+		Timeline::Value retireValue
+	);
+
+	/// Number of chunks that can be recorded concurrently, one per worker thread plus
+	/// the calling thread.
+	uint maxConcurrentChunks() const { return m_jobSystem->numWorkerThreads() + 1; }
+
+private:
+	CommandListPool * m_commandListPool;
+	JobSystem * m_jobSystem;
+
+	// Pairs recorded this frame, and their lists in submission order.
+	std::vector<CommandListPool::CommandList> m_recordedPairs;
+	std::vector<ID3D12CommandList *> m_commandLists;
+};
@@ -0,0 +1,238 @@
+//
+// PixelConversion.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "PixelConversion.hpp"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PIXEL_CONVERSION_SSE2
+	#include <emmintrin.h>
+#endif
+
+#if defined(PIXEL_CONVERSION_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+	#define PIXEL_CONVERSION_SSSE3
+	#include <tmmintrin.h>
+#endif
+
+
+namespace {
+
+	// JFIF YCbCr to RGB coefficients in 14-bit fixed point.
+	const int FixedBits = 14;
+	const int FixedHalf = 1 << (FixedBits - 1);
+	const int CrToR = 22970;    // 1.402
+	const int CbToG = -5638;    // -0.344136
+	const int CrToG = -11700;   // -0.714136
+	const int CbToB = 29032;    // 1.772
+}
+
+//---------------------------------------------------------------------------------------
+static inline byte clampToByte (
+	int value
+) {
+	return byte(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+#ifdef PIXEL_CONVERSION_SSE2
+//---------------------------------------------------------------------------------------
+// Interleaves four 16 byte channels into 64 bytes of RGBA.
+static inline void storeRgba16 (
+	__m128i r,
+	__m128i g,
+	__m128i b,
+	__m128i a,
+	byte * rgba
+) {
+	const __m128i rgLow = _mm_unpacklo_epi8(r, g);
+	const __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+	const __m128i baLow = _mm_unpacklo_epi8(b, a);
+	const __m128i baHigh = _mm_unpackhi_epi8(b, a);
+
+	__m128i * dst = reinterpret_cast<__m128i *>(rgba);
+	_mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(rgLow, baLow));
+	_mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(rgLow, baLow));
+	_mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(rgHigh, baHigh));
+	_mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(rgHigh, baHigh));
+}
+
+//---------------------------------------------------------------------------------------
+// Computes (y << 14 + round + cb * cbWeight + cr * crWeight) >> 14 for 8 pixels, given
+// y as 32-bit lanes and cb, cr interleaved as 16-bit pairs.
+static inline __m128i yCbCrChannel8 (
+	__m128i yLow,
+	__m128i yHigh,
+	__m128i cbCrLow,
+	__m128i cbCrHigh,
+	__m128i weights
+) {
+	const __m128i low = _mm_srai_epi32 (
+		_mm_add_epi32(yLow, _mm_madd_epi16(cbCrLow, weights)), FixedBits
+	);
+	const __m128i high = _mm_srai_epi32 (
+		_mm_add_epi32(yHigh, _mm_madd_epi16(cbCrHigh, weights)), FixedBits
+	);
+	return _mm_packs_epi32(low, high);
+}
+
+//---------------------------------------------------------------------------------------
+// Converts 8 pixels, returning their channels as 16-bit lanes.
+static inline void yCbCrToRgb8 (
+	__m128i y8,
+	__m128i cb8,
+	__m128i cr8,
+	__m128i & r,
+	__m128i & g,
+	__m128i & b
+) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+
+	const __m128i y = _mm_unpacklo_epi8(y8, zero);
+	const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(cb8, zero), bias);
+	const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(cr8, zero), bias);
+
+	const __m128i round = _mm_set1_epi32(FixedHalf);
+	const __m128i yLow = _mm_add_epi32(_mm_slli_epi32(_mm_unpacklo_epi16(y, zero), FixedBits), round);
+	const __m128i yHigh = _mm_add_epi32(_mm_slli_epi32(_mm_unpackhi_epi16(y, zero), FixedBits), round);
+
+	const __m128i cbCrLow = _mm_unpacklo_epi16(cb, cr);
+	const __m128i cbCrHigh = _mm_unpackhi_epi16(cb, cr);
+
+	r = yCbCrChannel8(yLow, yHigh, cbCrLow, cbCrHigh, _mm_set1_epi32(CrToR << 16));
+	g = yCbCrChannel8(yLow, yHigh, cbCrLow, cbCrHigh,
+		_mm_set1_epi32(int((uint32(CrToG) << 16) | (uint32(CbToG) & 0xffff))));
+	b = yCbCrChannel8(yLow, yHigh, cbCrLow, cbCrHigh, _mm_set1_epi32(CbToB));
+}
+#endif // PIXEL_CONVERSION_SSE2
+
+//---------------------------------------------------------------------------------------
+void PixelConversion::grayToRgba (
+	const byte * gray,
+	byte * rgba,
+	size_t numPixels
+) {
+	size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+	const __m128i opaque = _mm_set1_epi8(-1);
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i *>(gray + i));
+		storeRgba16(g, g, g, opaque, rgba + i * 4);
+	}
+#endif
+
+	for (; i < numPixels; ++i) {
+		rgba[i * 4 + 0] = gray[i];
+		rgba[i * 4 + 1] = gray[i];
+		rgba[i * 4 + 2] = gray[i];
+		rgba[i * 4 + 3] = 255;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void PixelConversion::grayAlphaToRgba (
+	const byte * grayAlpha,
+	byte * rgba,
+	size_t numPixels
+) {
+	size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+	// Each 16-bit lane holds a (gray, alpha) pair, (gray, gray) is interleaved with it.
+	const __m128i grayMask = _mm_set1_epi16(0xff);
+	for (; i + 8 <= numPixels; i += 8) {
+		const __m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i *>(grayAlpha + i * 2));
+		const __m128i g = _mm_and_si128(ga, grayMask);
+		const __m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+
+		__m128i * dst = reinterpret_cast<__m128i *>(rgba + i * 4);
+		_mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(gg, ga));
+		_mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(gg, ga));
+	}
+#endif
+
+	for (; i < numPixels; ++i) {
+		rgba[i * 4 + 0] = grayAlpha[i * 2];
+		rgba[i * 4 + 1] = grayAlpha[i * 2];
+		rgba[i * 4 + 2] = grayAlpha[i * 2];
+		rgba[i * 4 + 3] = grayAlpha[i * 2 + 1];
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void PixelConversion::rgbToRgba (
+	const byte * rgb,
+	byte * rgba,
+	size_t numPixels
+) {
+	size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSSE3
+	// Spreads 4 RGB triples into 4 RGBA quads, alpha lanes are zeroed then set.
+	const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i opaque = _mm_set1_epi32(int(0xff000000));
+
+	// Loads 16 bytes to consume 12, so stop two pixels early.
+	for (; i + 6 <= numPixels; i += 4) {
+		const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + i * 3));
+		_mm_storeu_si128 (
+			reinterpret_cast<__m128i *>(rgba + i * 4),
+			_mm_or_si128(_mm_shuffle_epi8(src, spread), opaque)
+		);
+	}
+#endif
+
+	for (; i < numPixels; ++i) {
+		rgba[i * 4 + 0] = rgb[i * 3 + 0];
+		rgba[i * 4 + 1] = rgb[i * 3 + 1];
+		rgba[i * 4 + 2] = rgb[i * 3 + 2];
+		rgba[i * 4 + 3] = 255;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void PixelConversion::yCbCrToRgba (
+	const byte * y,
+	const byte * cb,
+	const byte * cr,
+	byte * rgba,
+	size_t numPixels
+) {
+	size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+	const __m128i opaque = _mm_set1_epi8(-1);
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m128i y16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+		const __m128i cb16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cb + i));
+		const __m128i cr16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cr + i));
+
+		__m128i rLow, gLow, bLow, rHigh, gHigh, bHigh;
+		yCbCrToRgb8(y16, cb16, cr16, rLow, gLow, bLow);
+		yCbCrToRgb8 (
+			_mm_srli_si128(y16, 8), _mm_srli_si128(cb16, 8), _mm_srli_si128(cr16, 8),
+			rHigh, gHigh, bHigh
+		);
+
+		storeRgba16 (
+			_mm_packus_epi16(rLow, rHigh),
+			_mm_packus_epi16(gLow, gHigh),
+			_mm_packus_epi16(bLow, bHigh),
+			opaque,
+			rgba + i * 4
+		);
+	}
+#endif
+
+	for (; i < numPixels; ++i) {
+		const int luma = (int(y[i]) << FixedBits) + FixedHalf;
+		const int blue = int(cb[i]) - 128;
+		const int red = int(cr[i]) - 128;
+
+		rgba[i * 4 + 0] = clampToByte((luma + CrToR * red) >> FixedBits);
+		rgba[i * 4 + 1] = clampToByte((luma + CbToG * blue + CrToG * red) >> FixedBits);
+		rgba[i * 4 + 2] = clampToByte((luma + CbToB * blue) >> FixedBits);
+		rgba[i * 4 + 3] = 255;
+	}
+}
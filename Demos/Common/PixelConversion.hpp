@@ -0,0 +1,51 @@
+//
+// PixelConversion.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Expands decoded scanlines of the various PNG and JPEG color layouts to 8-bit RGBA,
+* the layout of the R8G8B8A8 texture formats.  Source and destination must not
+* overlap.
+*
+* Conversions use SSE2 when available, and SSSE3 for RGB expansion.  Results are
+* identical to the scalar paths.  Has no Windows dependencies.
+*/
+namespace PixelConversion {
+
+	/// Gray to (g, g, g, 255).
+	void grayToRgba (
+		const byte * gray,
+		byte * rgba,
+		size_t numPixels
+	);
+
+	/// Interleaved gray and alpha pairs to (g, g, g, a).
+	void grayAlphaToRgba (
+		const byte * grayAlpha,
+		byte * rgba,
+		size_t numPixels
+	);
+
+	/// Interleaved RGB triples to (r, g, b, 255).
+	void rgbToRgba (
+		const byte * rgb,
+		byte * rgba,
+		size_t numPixels
+	);
+
+	/// Separate full resolution JFIF YCbCr planes to (r, g, b, 255), using 14-bit
+	/// fixed point BT.601 coefficients.
+	void yCbCrToRgba (
+		const byte * y,
+		const byte * cb,
+		const byte * cr,
+		byte * rgba,
+		size_t numPixels
+	);
+};
@@ -0,0 +1,618 @@
+//
+// PngDecoder.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "PngDecoder.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Inflate.hpp"
+#include "PixelConversion.hpp"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PNG_DECODER_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+	const byte Signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	// Largest width or height accepted, guarding against absurd allocations.
+	const uint MaxDimension = 1 << 16;
+
+	enum ColorType {
+		ColorType_Gray = 0,
+		ColorType_Rgb = 2,
+		ColorType_Palette = 3,
+		ColorType_GrayAlpha = 4,
+		ColorType_Rgba = 6
+	};
+
+	enum FilterType {
+		Filter_None = 0,
+		Filter_Sub = 1,
+		Filter_Up = 2,
+		Filter_Average = 3,
+		Filter_Paeth = 4
+	};
+
+	// Adam7 pass origins and strides.
+	const uint NumPasses = 7;
+	const uint PassStartX[NumPasses] = { 0, 4, 0, 2, 0, 1, 0 };
+	const uint PassStartY[NumPasses] = { 0, 0, 4, 0, 2, 0, 1 };
+	const uint PassStepX[NumPasses] = { 8, 8, 4, 4, 2, 2, 1 };
+	const uint PassStepY[NumPasses] = { 8, 8, 8, 4, 4, 2, 2 };
+
+	struct Header {
+		uint width;
+		uint height;
+		uint bitDepth;
+		uint colorType;
+		bool isInterlaced;
+
+		uint numChannels;
+		uint bitsPerPixel;
+	};
+
+	/// Contents of the PLTE and tRNS chunks.
+	struct ColorTable {
+		// RGBA entries, indices beyond the palette read as opaque black.
+		byte palette[256 * 4];
+
+		// Gray or RGB sample values that are fully transparent, for color types
+		// without alpha.
+		bool hasTransparentKey;
+		uint16 transparentKey[3];
+	};
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint32 readBigEndian32 (
+	const byte * p
+) {
+	return (uint32(p[0]) << 24) | (uint32(p[1]) << 16) | (uint32(p[2]) << 8) | p[3];
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint16 readBigEndian16 (
+	const byte * p
+) {
+	return uint16((p[0] << 8) | p[1]);
+}
+
+//---------------------------------------------------------------------------------------
+static void parseHeader (
+	const byte * chunkData,
+	uint32 chunkLength,
+	Header & header
+) {
+	if (chunkLength != 13) {
+		throw std::runtime_error("Invalid IHDR chunk");
+	}
+
+	header.width = readBigEndian32(chunkData);
+	header.height = readBigEndian32(chunkData + 4);
+	header.bitDepth = chunkData[8];
+	header.colorType = chunkData[9];
+	header.isInterlaced = chunkData[12] == 1;
+
+	if (header.width == 0 || header.height == 0 ||
+		header.width > MaxDimension || header.height > MaxDimension) {
+		throw std::runtime_error("Unsupported image dimensions");
+	}
+	if (chunkData[10] != 0 || chunkData[11] != 0 || chunkData[12] > 1) {
+		throw std::runtime_error("Unknown compression, filter or interlace method");
+	}
+
+	const uint bitDepth = header.bitDepth;
+	const bool isValidDepth = bitDepth == 1 || bitDepth == 2 || bitDepth == 4 ||
+		bitDepth == 8 || bitDepth == 16;
+
+	switch (header.colorType) {
+		case ColorType_Gray:
+			header.numChannels = 1;
+			break;
+		case ColorType_Palette:
+			header.numChannels = 1;
+			if (bitDepth == 16) {
+				throw std::runtime_error("Invalid bit depth for palette image");
+			}
+			break;
+		case ColorType_Rgb:
+			header.numChannels = 3;
+			break;
+		case ColorType_GrayAlpha:
+			header.numChannels = 2;
+			break;
+		case ColorType_Rgba:
+			header.numChannels = 4;
+			break;
+		default:
+			throw std::runtime_error("Invalid color type");
+	}
+
+	if (!isValidDepth || (header.numChannels > 1 && bitDepth < 8)) {
+		throw std::runtime_error("Invalid bit depth");
+	}
+
+	header.bitsPerPixel = header.numChannels * bitDepth;
+}
+
+//---------------------------------------------------------------------------------------
+static inline size_t rowBytes (
+	const Header & header,
+	uint width
+) {
+	return (size_t(width) * header.bitsPerPixel + 7) / 8;
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint passSize (
+	uint size,
+	uint start,
+	uint step
+) {
+	return size > start ? (size - start + step - 1) / step : 0;
+}
+
+//---------------------------------------------------------------------------------------
+static inline byte paethPredictor (
+	int a,
+	int b,
+	int c
+) {
+	const int pa = abs(b - c);
+	const int pb = abs(a - c);
+	const int pc = abs(a + b - 2 * c);
+
+	if (pa <= pb && pa <= pc) {
+		return byte(a);
+	}
+	return byte(pb <= pc ? b : c);
+}
+
+#ifdef PNG_DECODER_SSE2
+//---------------------------------------------------------------------------------------
+static inline __m128i load4 (
+	const byte * p
+) {
+	int32 value;
+	memcpy(&value, p, sizeof(value));
+	return _mm_cvtsi32_si128(value);
+}
+
+//---------------------------------------------------------------------------------------
+static inline void store4 (
+	byte * p,
+	__m128i value
+) {
+	const int32 low = _mm_cvtsi128_si32(value);
+	memcpy(p, &low, sizeof(low));
+}
+
+//---------------------------------------------------------------------------------------
+static inline __m128i abs16 (
+	__m128i value
+) {
+	return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+//---------------------------------------------------------------------------------------
+static inline __m128i select16 (
+	__m128i mask,
+	__m128i a,
+	__m128i b
+) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+//---------------------------------------------------------------------------------------
+// Sub, Average and Paeth filters for 4 byte pixels, undoing all channels of a pixel
+// at once.  Each pixel still depends on its left neighbor.
+static void unfilterRow4 (
+	uint filter,
+	byte * row,
+	const byte * prevRow,
+	size_t numBytes
+) {
+	const __m128i zero = _mm_setzero_si128();
+	const size_t numPixels = numBytes / 4;
+
+	if (filter == Filter_Sub) {
+		__m128i a = zero;
+		for (size_t i = 0; i < numPixels; ++i) {
+			a = _mm_add_epi8(load4(row + i * 4), a);
+			store4(row + i * 4, a);
+		}
+	} else if (filter == Filter_Average) {
+		// _mm_avg_epu8 rounds up, the filter rounds down.
+		const __m128i one = _mm_set1_epi8(1);
+		__m128i a = zero;
+		for (size_t i = 0; i < numPixels; ++i) {
+			const __m128i b = load4(prevRow + i * 4);
+			const __m128i average = _mm_sub_epi8 (
+				_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one)
+			);
+			a = _mm_add_epi8(load4(row + i * 4), average);
+			store4(row + i * 4, a);
+		}
+	} else {
+		// Paeth, predictors in 16-bit lanes.  Ties favor a, then b, then c.
+		const __m128i byteMask = _mm_set1_epi16(0xff);
+		__m128i a = zero;
+		__m128i c = zero;
+		for (size_t i = 0; i < numPixels; ++i) {
+			const __m128i b = _mm_unpacklo_epi8(load4(prevRow + i * 4), zero);
+			const __m128i x = _mm_unpacklo_epi8(load4(row + i * 4), zero);
+
+			const __m128i pa = abs16(_mm_sub_epi16(b, c));
+			const __m128i pb = abs16(_mm_sub_epi16(a, c));
+			const __m128i pc = abs16(_mm_sub_epi16(_mm_add_epi16(a, b), _mm_add_epi16(c, c)));
+			const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+			const __m128i predictor = select16 (
+				_mm_cmpeq_epi16(smallest, pa), a,
+				select16(_mm_cmpeq_epi16(smallest, pb), b, c)
+			);
+
+			a = _mm_and_si128(_mm_add_epi16(x, predictor), byteMask);
+			store4(row + i * 4, _mm_packus_epi16(a, a));
+			c = b;
+		}
+	}
+}
+#endif // PNG_DECODER_SSE2
+
+//---------------------------------------------------------------------------------------
+// Reverses the filter of 'row' in place, given the already unfiltered 'prevRow'.
+static void unfilterRow (
+	uint filter,
+	byte * row,
+	const byte * prevRow,
+	size_t numBytes,
+	size_t bytesPerPixel
+) {
+	switch (filter) {
+		case Filter_None:
+			return;
+
+		case Filter_Up:
+			for (size_t i = 0; i < numBytes; ++i) {
+				row[i] = byte(row[i] + prevRow[i]);
+			}
+			return;
+
+		case Filter_Sub:
+		case Filter_Average:
+		case Filter_Paeth:
+			break;
+
+		default:
+			throw std::runtime_error("Invalid scanline filter");
+	}
+
+#ifdef PNG_DECODER_SSE2
+	if (bytesPerPixel == 4) {
+		unfilterRow4(filter, row, prevRow, numBytes);
+		return;
+	}
+#endif
+
+	// The first pixel has no left neighbor.
+	const size_t n = bytesPerPixel;
+	if (filter == Filter_Sub) {
+		for (size_t i = n; i < numBytes; ++i) {
+			row[i] = byte(row[i] + row[i - n]);
+		}
+	} else if (filter == Filter_Average) {
+		for (size_t i = 0; i < n; ++i) {
+			row[i] = byte(row[i] + (prevRow[i] >> 1));
+		}
+		for (size_t i = n; i < numBytes; ++i) {
+			row[i] = byte(row[i] + ((row[i - n] + prevRow[i]) >> 1));
+		}
+	} else {
+		for (size_t i = 0; i < n; ++i) {
+			row[i] = byte(row[i] + prevRow[i]);
+		}
+		for (size_t i = n; i < numBytes; ++i) {
+			row[i] = byte(row[i] + paethPredictor(row[i - n], prevRow[i], prevRow[i - n]));
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Reads sample 'index' of an unfiltered row.
+static inline uint readSample (
+	const byte * row,
+	size_t index,
+	uint bitDepth
+) {
+	if (bitDepth == 8) {
+		return row[index];
+	}
+	if (bitDepth == 16) {
+		return readBigEndian16(row + index * 2);
+	}
+
+	// Sub-byte samples are packed from the most significant bit.
+	const size_t bitOffset = index * bitDepth;
+	const uint shift = 8 - bitDepth - uint(bitOffset & 7);
+	return (row[bitOffset >> 3] >> shift) & ((1u << bitDepth) - 1);
+}
+
+//---------------------------------------------------------------------------------------
+// Expands one unfiltered row of 'width' pixels to RGBA.  'scratch' holds at least
+// width * numChannels bytes.
+static void convertRow (
+	const Header & header,
+	const ColorTable & colorTable,
+	const byte * row,
+	uint width,
+	byte * scratch,
+	byte * rgba
+) {
+	const size_t numSamples = size_t(width) * header.numChannels;
+
+	// Reduce samples to one byte each.
+	const byte * samples = row;
+	if (header.bitDepth == 16) {
+		for (size_t i = 0; i < numSamples; ++i) {
+			scratch[i] = row[i * 2];
+		}
+		samples = scratch;
+	} else if (header.bitDepth < 8) {
+		// Gray levels are scaled to the full range, palette indices are kept.
+		const uint scale = (header.colorType == ColorType_Palette) ?
+			1 : 255 / ((1u << header.bitDepth) - 1);
+		for (size_t i = 0; i < numSamples; ++i) {
+			scratch[i] = byte(readSample(row, i, header.bitDepth) * scale);
+		}
+		samples = scratch;
+	}
+
+	switch (header.colorType) {
+		case ColorType_Gray:
+			PixelConversion::grayToRgba(samples, rgba, width);
+			break;
+		case ColorType_Rgb:
+			PixelConversion::rgbToRgba(samples, rgba, width);
+			break;
+		case ColorType_Palette:
+			for (uint x = 0; x < width; ++x) {
+				memcpy(rgba + x * 4, colorTable.palette + samples[x] * 4, 4);
+			}
+			break;
+		case ColorType_GrayAlpha:
+			PixelConversion::grayAlphaToRgba(samples, rgba, width);
+			break;
+		case ColorType_Rgba:
+			memcpy(rgba, samples, size_t(width) * 4);
+			break;
+	}
+
+	// Transparent keys compare against the full precision samples.
+	if (colorTable.hasTransparentKey) {
+		const uint numChannels = header.numChannels;
+		for (uint x = 0; x < width; ++x) {
+			bool isTransparent = true;
+			for (uint c = 0; c < numChannels; ++c) {
+				isTransparent &= readSample(row, size_t(x) * numChannels + c, header.bitDepth) ==
+					colorTable.transparentKey[c];
+			}
+			if (isTransparent) {
+				rgba[x * 4 + 3] = 0;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Unfilters and converts 'height' scanlines of 'width' pixels, writing pixel (x, y) to
+// dst + y * dstRowPitch + x * dstPixelStep.  'samples' holds width * numChannels bytes,
+// 'rgbaRow' width RGBA pixels and 'zeroRow' one zeroed scanline.
+// @return end of the consumed scanlines.
+static byte * decodeRows (
+	const Header & header,
+	const ColorTable & colorTable,
+	byte * scanlines,
+	uint width,
+	uint height,
+	byte * dst,
+	size_t dstRowPitch,
+	size_t dstPixelStep,
+	byte * samples,
+	byte * rgbaRow,
+	const byte * zeroRow
+) {
+	const size_t numRowBytes = rowBytes(header, width);
+	const size_t bytesPerPixel = (header.bitsPerPixel + 7) / 8;
+
+	// The row above the first one reads as zeros.
+	const byte * prevRow = zeroRow;
+
+	for (uint y = 0; y < height; ++y) {
+		byte * row = scanlines + y * (numRowBytes + 1);
+		unfilterRow(row[0], row + 1, prevRow, numRowBytes, bytesPerPixel);
+		prevRow = row + 1;
+
+		byte * dstRow = dst + y * dstRowPitch;
+		if (dstPixelStep == 4) {
+			convertRow(header, colorTable, row + 1, width, samples, dstRow);
+			continue;
+		}
+
+		// Interlaced passes scatter their pixels.
+		convertRow(header, colorTable, row + 1, width, samples, rgbaRow);
+		for (uint x = 0; x < width; ++x) {
+			memcpy(dstRow + x * dstPixelStep, &rgbaRow[x * 4], 4);
+		}
+	}
+
+	return scanlines + height * (numRowBytes + 1);
+}
+
+//---------------------------------------------------------------------------------------
+bool PngDecoder::isPng (
+	const byte * fileData,
+	size_t fileSize
+) {
+	return fileSize >= sizeof(Signature) && memcmp(fileData, Signature, sizeof(Signature)) == 0;
+}
+
+//---------------------------------------------------------------------------------------
+ImageInfo PngDecoder::readInfo (
+	const byte * fileData,
+	size_t fileSize
+) {
+	if (!isPng(fileData, fileSize)) {
+		throw std::runtime_error("Not a PNG file");
+	}
+
+	// IHDR must be the first chunk.
+	const size_t offset = sizeof(Signature);
+	if (fileSize - offset < 12 + 13 || memcmp(fileData + offset + 4, "IHDR", 4) != 0) {
+		throw std::runtime_error("Missing IHDR chunk");
+	}
+
+	Header header = {};
+	parseHeader(fileData + offset + 8, readBigEndian32(fileData + offset), header);
+
+	ImageInfo info;
+	info.width = header.width;
+	info.height = header.height;
+	return info;
+}
+
+//---------------------------------------------------------------------------------------
+void PngDecoder::decode (
+	const byte * fileData,
+	size_t fileSize,
+	const ImageDestination & destination
+) {
+	if (!isPng(fileData, fileSize)) {
+		throw std::runtime_error("Not a PNG file");
+	}
+
+	Header header = {};
+	bool hasHeader = false;
+
+	ColorTable colorTable = {};
+	for (uint i = 0; i < 256; ++i) {
+		colorTable.palette[i * 4 + 3] = 255;
+	}
+
+	// Image data may be split across any number of IDAT chunks.
+	m_compressedData.clear();
+
+	size_t offset = sizeof(Signature);
+	for (;;) {
+		if (fileSize - offset < 12) {
+			throw std::runtime_error("Truncated PNG chunk");
+		}
+
+		const uint32 length = readBigEndian32(fileData + offset);
+		const byte * type = fileData + offset + 4;
+		const byte * data = fileData + offset + 8;
+		if (length > fileSize - offset - 12) {
+			throw std::runtime_error("Truncated PNG chunk");
+		}
+		offset += 12 + size_t(length);
+
+		if (memcmp(type, "IHDR", 4) == 0) {
+			parseHeader(data, length, header);
+			hasHeader = true;
+		} else if (!hasHeader) {
+			throw std::runtime_error("Missing IHDR chunk");
+		} else if (memcmp(type, "PLTE", 4) == 0) {
+			if (length % 3 != 0 || length > 256 * 3) {
+				throw std::runtime_error("Invalid PLTE chunk");
+			}
+			for (uint i = 0; i < length / 3; ++i) {
+				memcpy(colorTable.palette + i * 4, data + i * 3, 3);
+			}
+		} else if (memcmp(type, "tRNS", 4) == 0) {
+			if (header.colorType == ColorType_Palette) {
+				for (uint i = 0; i < length && i < 256; ++i) {
+					colorTable.palette[i * 4 + 3] = data[i];
+				}
+			} else if (header.colorType == ColorType_Gray || header.colorType == ColorType_Rgb) {
+				if (length != header.numChannels * 2) {
+					throw std::runtime_error("Invalid tRNS chunk");
+				}
+				for (uint c = 0; c < header.numChannels; ++c) {
+					colorTable.transparentKey[c] = readBigEndian16(data + c * 2);
+				}
+				colorTable.hasTransparentKey = true;
+			}
+		} else if (memcmp(type, "IDAT", 4) == 0) {
+			m_compressedData.insert(m_compressedData.end(), data, data + length);
+		} else if (memcmp(type, "IEND", 4) == 0) {
+			break;
+		} else if ((type[0] & 0x20) == 0) {
+			// Lowercase first letter marks ancillary chunks, the rest are required.
+			throw std::runtime_error("Unknown critical PNG chunk");
+		}
+	}
+
+	// Each pass contributes its own filtered scanlines, one filter byte per row.
+	const uint numPasses = header.isInterlaced ? NumPasses : 1;
+	size_t numScanlineBytes = 0;
+	for (uint pass = 0; pass < numPasses; ++pass) {
+		const uint passWidth = header.isInterlaced ?
+			passSize(header.width, PassStartX[pass], PassStepX[pass]) : header.width;
+		const uint passHeight = header.isInterlaced ?
+			passSize(header.height, PassStartY[pass], PassStepY[pass]) : header.height;
+		if (passWidth > 0 && passHeight > 0) {
+			numScanlineBytes += size_t(passHeight) * (rowBytes(header, passWidth) + 1);
+		}
+	}
+
+	if (!destination.canHold(header.width, header.height)) {
+		throw std::runtime_error("Image destination is too small");
+	}
+
+	m_scanlines.resize(numScanlineBytes);
+	const size_t numInflated = Inflate::decompressZlib (
+		m_compressedData.data(), m_compressedData.size(), m_scanlines.data(), m_scanlines.size()
+	);
+	if (numInflated != numScanlineBytes) {
+		throw std::runtime_error("Truncated PNG image data");
+	}
+
+	m_samples.resize(size_t(header.width) * header.numChannels);
+	m_rgbaRow.resize(size_t(header.width) * 4);
+	m_zeroRow.assign(rowBytes(header, header.width), 0);
+
+	const size_t outputPitch = destination.rowPitch;
+	if (!header.isInterlaced) {
+		decodeRows (
+			header, colorTable, m_scanlines.data(), header.width, header.height,
+			destination.data, outputPitch, 4, m_samples.data(), m_rgbaRow.data(), m_zeroRow.data()
+		);
+		return;
+	}
+
+	byte * passScanlines = m_scanlines.data();
+	for (uint pass = 0; pass < NumPasses; ++pass) {
+		const uint passWidth = passSize(header.width, PassStartX[pass], PassStepX[pass]);
+		const uint passHeight = passSize(header.height, PassStartY[pass], PassStepY[pass]);
+		if (passWidth == 0 || passHeight == 0) {
+			continue;
+		}
+
+		byte * passOrigin = destination.data +
+			PassStartY[pass] * outputPitch + PassStartX[pass] * 4;
+		passScanlines = decodeRows (
+			header, colorTable, passScanlines, passWidth, passHeight,
+			passOrigin, PassStepY[pass] * outputPitch, PassStepX[pass] * 4,
+			m_samples.data(), m_rgbaRow.data(), m_zeroRow.data()
+		);
+	}
+}
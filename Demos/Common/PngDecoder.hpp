@@ -0,0 +1,56 @@
+//
+// PngDecoder.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/ImageTypes.hpp"
+
+
+/**
+* Decoder for PNG images, producing 8-bit RGBA.
+*
+* Supports every color type and bit depth, tRNS transparency and Adam7 interlacing.
+* 16-bit samples keep their most significant byte.  Scanlines are inflated in one go,
+* unfiltered in place, using SSE2 for 4 byte pixels, then expanded to RGBA with
+* PixelConversion.  Chunk CRCs are not verified.
+*
+* Working buffers are members, reused by later decodes.
+*
+* Has no Windows dependencies, malformed images throw std::runtime_error.
+*/
+class PngDecoder {
+public:
+	/// True if 'fileData' starts with the PNG signature.
+	static bool isPng (
+		const byte * fileData,
+		size_t fileSize
+	);
+
+	/// Dimensions from the IHDR chunk.
+	static ImageInfo readInfo (
+		const byte * fileData,
+		size_t fileSize
+	);
+
+	void decode (
+		const byte * fileData,
+		size_t fileSize,
+		const ImageDestination & destination
+	);
+
+private:
+	// Concatenated IDAT chunks.
+	std::vector<byte> m_compressedData;
+
+	// Inflated scanlines of all passes, each preceded by its filter byte.
+	std::vector<byte> m_scanlines;
+
+	// Row conversion temporaries, see decodeRows() in the .cpp.
+	std::vector<byte> m_samples;
+	std::vector<byte> m_rgbaRow;
+	std::vector<byte> m_zeroRow;
+};
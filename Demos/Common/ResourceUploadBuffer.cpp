@@ -1,9 +1,14 @@
 #include "pch.h"
 using Microsoft::WRL::ComPtr;
 
+#include <deque>
 #include <exception>
+#include <memory>
+#include <vector>
 
 #include "ResourceUploadBuffer.hpp"
+#include "AtomicLinearAllocator.hpp"
+#include "RingAllocator.hpp"
 
 //-- Minimum byte alignments for common D3D12 Resource types:
 // Note that index data alignment is equal to sizeof(index), so 2 for 16bit indices,
@@ -14,6 +19,9 @@ static const uint TextureData_Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGN
 static const uint BufferData_Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
 static const uint MSAAResourceData_Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
 
+// Size of the block each thread carves out of a Concurrent mode buffer.
+static const size_t ConcurrentUploadChunkSize = 16 * 1024;
+
 
 // Function Declaration
 template <typename T>
@@ -24,24 +32,97 @@ class ResourceUploadBufferImpl {
 private:
 	friend class ResourceUploadBuffer;
 
-	// The Resource backing the buffer storage.
-	ComPtr<ID3D12Resource> resourceBuffer;
-	
-	// Starting position of resource buffer.
-	byte * dataBegin = nullptr;  
+	// A single committed upload heap resource, persistently mapped.
+	struct Page {
+		// The Resource backing the page storage.
+		ComPtr<ID3D12Resource> resource;
+
+		// Starting position of page.
+		byte * dataBegin = nullptr;
+
+		// Ending position of page.
+		byte * dataEnd = nullptr;
+
+		// GPU virtual address to beginning of page.
+		D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress = 0;
+
+		// Bytes sub-allocated from page, including alignment padding.
+		uint64 bytesUsed = 0;
+
+		// Fence value that must complete before page can be reused.
+		uint64 retireFenceValue = 0;
+
+		// True if page was sized for a single oversized request.
+		bool isDedicated = false;
+
+		~Page() { if (resource) { resource->Unmap(0, nullptr); } }
+	};
+	typedef std::unique_ptr<Page> PagePtr;
+
+	ID3D12Device * device = nullptr;
 
-    // Current position within resource buffer for sub-allocations.
+	// Size of non-dedicated pages.
+	uint64 pageSize = 0;
+
+	// Page currently being sub-allocated from, owned by usedPages.
+	Page * currentPage = nullptr;
+
+	// Current position within currentPage for sub-allocations.
 	byte * dataCur = nullptr;
 
-    // Ending position of resource buffer.
-	byte * dataEnd = nullptr;
+	// Pages written to since the last call to retireUploads().
+	std::vector<PagePtr> usedPages;
+
+	// Pages waiting on their retireFenceValue, in increasing fence order.
+	std::deque<PagePtr> retiredPages;
+
+	// Pages ready for reuse.
+	std::vector<PagePtr> freePages;
+
+	ResourceUploadBuffer::AllocationMode allocationMode;
+
+	// Fence bookkeeping for AllocationMode::Ring, null otherwise.
+	RingAllocator * ringAllocator = nullptr;
+
+	// Fence value used to tag ring sub-allocations.
+	uint64 currentFenceValue = 0;
+
+	// Thread-safe sub-allocator for AllocationMode::Concurrent, null otherwise.
+	AtomicLinearAllocator * concurrentAllocator = nullptr;
 
-	// GPU virtual address to beginning of upload buffer
-	D3D12_GPU_VIRTUAL_ADDRESS uploadBufferGPUVirtualAddress;
+	// Set by retireUploads() in AllocationMode::Concurrent.
+	bool concurrentPageRetired = false;
 
+	ResourceUploadBuffer::Statistics stats = {};
+
+	~ResourceUploadBufferImpl() {
+		delete ringAllocator;
+		delete concurrentAllocator;
+	}
+
+
+	PagePtr createPage (
+		uint64 sizeInBytes
+	);
+
+	void acquireNewPage();
+
+	void updateStatistics();
 
 	void alignDataPointerForAllocation(size_t alignSize);
 
+	byte * allocateConcurrent (
+		_In_ size_t dataBytes,
+		_In_ size_t alignment,
+		_Out_ D3D12_GPU_VIRTUAL_ADDRESS & dataGPUVirtualAddress
+	);
+
+	byte * allocateFromPages (
+		_In_ size_t dataBytes,
+		_In_ size_t alignment,
+		_Out_ D3D12_GPU_VIRTUAL_ADDRESS & dataGPUVirtualAddress
+	);
+
 	void uploadData (
 		_In_ const void * data,
 		_In_ size_t dataBytes,
@@ -60,11 +141,10 @@ void ResourceUploadBufferImpl::alignDataPointerForAllocation (
 }
 
 //---------------------------------------------------------------------------------------
-ResourceUploadBuffer::ResourceUploadBuffer (
-	ID3D12Device * device,
+ResourceUploadBufferImpl::PagePtr ResourceUploadBufferImpl::createPage (
 	uint64 sizeInBytes
 ) {
-	impl = new ResourceUploadBufferImpl();
+	PagePtr page(new Page());
 
 	CHECK_D3D_RESULT (
 		device->CreateCommittedResource (
@@ -73,29 +153,159 @@ ResourceUploadBuffer::ResourceUploadBuffer (
 			&CD3DX12_RESOURCE_DESC::Buffer(sizeInBytes),
 			D3D12_RESOURCE_STATE_GENERIC_READ, 
 			nullptr,
-			IID_PPV_ARGS(&impl->resourceBuffer)
+			IID_PPV_ARGS(&page->resource)
 		)
 	);
-	D3D12_SET_NAME(impl->resourceBuffer, L"ResourceUploadBuffer");
-	impl->uploadBufferGPUVirtualAddress = impl->resourceBuffer->GetGPUVirtualAddress();
+	D3D12_SET_NAME(page->resource, L"ResourceUploadBuffer");
+	page->gpuVirtualAddress = page->resource->GetGPUVirtualAddress();
 
-	//-- Map the full buffer range, so CPU can write to it.
-	void * bufferStart;
+	//-- Map the full page range, so CPU can write to it.
+	void * pageStart;
 	CD3DX12_RANGE readRange(0,0); // No CPU reads will be done from the resource.
-	impl->resourceBuffer->Map(0, /*&readRange*/ nullptr, &bufferStart);
+	page->resource->Map(0, /*&readRange*/ nullptr, &pageStart);
+
+	page->dataBegin = reinterpret_cast<byte *>(pageStart);
+	page->dataEnd = page->dataBegin + sizeInBytes;
+
+	++stats.numPagesCreated;
+
+	return page;
+}
+
+//---------------------------------------------------------------------------------------
+// Makes a free page, or a newly created one, the current page for sub-allocations.
+void ResourceUploadBufferImpl::acquireNewPage()
+{
+	PagePtr page;
+	if (!freePages.empty()) {
+		page = std::move(freePages.back());
+		freePages.pop_back();
+	} else {
+		page = createPage(pageSize);
+	}
+
+	page->bytesUsed = 0;
+	currentPage = page.get();
+	dataCur = page->dataBegin;
+	usedPages.push_back(std::move(page));
+}
+
+//---------------------------------------------------------------------------------------
+void ResourceUploadBufferImpl::updateStatistics()
+{
+	stats.numPagesInUse = static_cast<uint>(usedPages.size() + retiredPages.size());
+	stats.numFreePages = static_cast<uint>(freePages.size());
+	stats.peakPagesInUse = max(stats.peakPagesInUse, stats.numPagesInUse);
+
+	if (ringAllocator) {
+		stats.bytesInUse = ringAllocator->usedBytes();
+	} else if (concurrentAllocator) {
+		stats.bytesInUse = concurrentAllocator->usedBytes();
+	}
+	stats.highWaterMarkBytes = max(stats.highWaterMarkBytes, stats.bytesInUse);
+}
+
+//---------------------------------------------------------------------------------------
+ResourceUploadBuffer::ResourceUploadBuffer (
+	ID3D12Device * device,
+	uint64 sizeInBytes,
+	AllocationMode allocationMode
+) {
+	impl = new ResourceUploadBufferImpl();
+	impl->device = device;
+	impl->pageSize = sizeInBytes;
+	impl->allocationMode = allocationMode;
+
+	// Start with a single page, which for AllocationMode::Ring is all the storage
+	// there will ever be.
+	impl->acquireNewPage();
+
+	if (allocationMode == AllocationMode::Ring) {
+		impl->ringAllocator = new RingAllocator(static_cast<size_t>(sizeInBytes));
+	} else if (allocationMode == AllocationMode::Concurrent) {
+		impl->concurrentAllocator =
+			new AtomicLinearAllocator(static_cast<size_t>(sizeInBytes));
+	}
 
-	impl->dataCur = impl->dataBegin = reinterpret_cast<byte *>(bufferStart);
-	impl->dataEnd = impl->dataBegin + sizeInBytes;
+	impl->updateStatistics();
 }
 
 
 //---------------------------------------------------------------------------------------
 ResourceUploadBuffer::~ResourceUploadBuffer()
 {
-	impl->resourceBuffer->Unmap(0, nullptr);
 	delete impl;
 }
 
+//---------------------------------------------------------------------------------------
+// Each thread caches a single chunk.  It is refilled whenever the thread switches
+// buffers or the buffer is reset, as the chunk records the allocator generation.
+static thread_local AtomicLinearAllocator::Chunk t_uploadChunk;
+
+//---------------------------------------------------------------------------------------
+byte * ResourceUploadBufferImpl::allocateConcurrent (
+	_In_ size_t dataBytes,
+	_In_ size_t alignment,
+	_Out_ D3D12_GPU_VIRTUAL_ADDRESS & dataGPUVirtualAddress
+) {
+	Assert(!concurrentPageRetired);
+
+	size_t offset = concurrentAllocator->allocate (
+		t_uploadChunk, ConcurrentUploadChunkSize, dataBytes, alignment
+	);
+	if (offset == AtomicLinearAllocator::InvalidOffset) {
+		ForceBreak("Insufficient memory.  Unable to upload data.");
+	}
+
+	dataGPUVirtualAddress = currentPage->gpuVirtualAddress + offset;
+	return currentPage->dataBegin + offset;
+}
+
+//---------------------------------------------------------------------------------------
+byte * ResourceUploadBufferImpl::allocateFromPages (
+	_In_ size_t dataBytes,
+	_In_ size_t alignment,
+	_Out_ D3D12_GPU_VIRTUAL_ADDRESS & dataGPUVirtualAddress
+) {
+	// Pages are at least 64KB aligned, so any smaller alignment of the allocation
+	// size also holds for its position in a fresh page.
+	const uint64 alignedBytes = align(uint64(dataBytes), uint64(alignment));
+
+	if (alignedBytes > pageSize) {
+		// Oversized request gets a dedicated page, leaving the current page intact.
+		PagePtr page = createPage(alignedBytes);
+		page->isDedicated = true;
+		page->bytesUsed = alignedBytes;
+		byte * pageData = page->dataBegin;
+		dataGPUVirtualAddress = page->gpuVirtualAddress;
+		usedPages.push_back(std::move(page));
+
+		stats.bytesInUse += alignedBytes;
+		return pageData;
+	}
+
+	if (currentPage) {
+		alignDataPointerForAllocation(alignment);
+	}
+	if (!currentPage || (dataCur + dataBytes) > currentPage->dataEnd) {
+		// Current page is full, chain on another.
+		acquireNewPage();
+	}
+
+	byte * dataPtr = dataCur;
+	dataCur += dataBytes;
+
+	const uint64 newBytesUsed = uint64(dataCur - currentPage->dataBegin);
+	stats.bytesInUse += newBytesUsed - currentPage->bytesUsed;
+	currentPage->bytesUsed = newBytesUsed;
+
+	// Compute GPU virtual address to start of data using its byte offset within page.
+	dataGPUVirtualAddress = currentPage->gpuVirtualAddress +
+		size_t(dataPtr - currentPage->dataBegin);
+
+	return dataPtr;
+}
+
 //---------------------------------------------------------------------------------------
 void ResourceUploadBufferImpl::uploadData (
 	_In_ const void * data,
@@ -104,23 +314,38 @@ void ResourceUploadBufferImpl::uploadData (
 	_Out_ size_t & dataGPUVirtualAddress,
 	_Out_opt_ void ** mappedDataPtr
 ) {
-	alignDataPointerForAllocation(alignment);
-
-	if ((dataCur + dataBytes) > dataEnd) {
-		ForceBreak("Insufficient memory.  Unable to upload data.");
+	byte * dataPtr;
+
+	if (ringAllocator) {
+		size_t offset = ringAllocator->allocate(dataBytes, alignment, currentFenceValue);
+		if (offset == RingAllocator::InvalidOffset) {
+			ForceBreak("Ring buffer full.  Uploads for fence value %llu are still in flight.",
+				currentFenceValue);
+		}
+		dataPtr = currentPage->dataBegin + offset;
+		dataGPUVirtualAddress = currentPage->gpuVirtualAddress + offset;
+
+	} else if (concurrentAllocator) {
+		D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress;
+		dataPtr = allocateConcurrent(dataBytes, alignment, gpuVirtualAddress);
+		dataGPUVirtualAddress = size_t(gpuVirtualAddress);
+
+	} else {
+		D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress;
+		dataPtr = allocateFromPages(dataBytes, alignment, gpuVirtualAddress);
+		dataGPUVirtualAddress = size_t(gpuVirtualAddress);
 	}
+
 	if (mappedDataPtr) {
-		*mappedDataPtr = dataCur;
+		*mappedDataPtr = dataPtr;
 	}
 
-	// Compute byte offset from start of upload buffer to beginning of copied data.
-	size_t byteOffsetToData = size_t(dataCur - dataBegin);
+	memcpy(dataPtr, data, dataBytes);
 
-	// Compute GPU virtual address to start of copied data.
-	dataGPUVirtualAddress = uploadBufferGPUVirtualAddress + byteOffsetToData;
-
-	memcpy(dataCur, data, dataBytes);
-	dataCur += dataBytes;
+	if (!concurrentAllocator) {
+		// Statistics are shared state, Concurrent mode gathers them on request instead.
+		updateStatistics();
+	}
 }
 
 //---------------------------------------------------------------------------------------
@@ -157,11 +382,9 @@ void ResourceUploadBuffer::uploadIndexData (
 	size_t dataGPUVirtualAddress(0);
 	size_t dataAlignment = sizeOfIndex;
 
-	DXGI_FORMAT dxgiIndexFormat;
+	// Direct3D 12 index buffers only support 16 and 32-bit indices.
+	DXGI_FORMAT dxgiIndexFormat = DXGI_FORMAT_UNKNOWN;
 	switch (sizeOfIndex) {
-	case 1:
-		dxgiIndexFormat = DXGI_FORMAT_R8_UINT;
-		break;
 	case 2:
 		dxgiIndexFormat = DXGI_FORMAT_R16_UINT;
 		break;
@@ -186,6 +409,21 @@ void ResourceUploadBuffer::uploadIndexData (
 	indexBufferView.Format = dxgiIndexFormat;
 }
 
+//---------------------------------------------------------------------------------------
+void ResourceUploadBuffer::uploadIndexData (
+	_In_ const Mesh & mesh,
+	_Out_ D3D12_INDEX_BUFFER_VIEW & indexBufferView,
+	_Out_opt_ void ** mappedDataPtr
+) {
+	uploadIndexData (
+		mesh.indexData(),
+		mesh.indexDataBytes(),
+		mesh.indexSize(),
+		indexBufferView,
+		mappedDataPtr
+	);
+}
+
 //---------------------------------------------------------------------------------------
 void ResourceUploadBuffer::uploadConstantBufferData (
 	_In_ const void * data,
@@ -210,7 +448,100 @@ void ResourceUploadBuffer::uploadConstantBufferData (
 //---------------------------------------------------------------------------------------
 D3D12_GPU_VIRTUAL_ADDRESS ResourceUploadBuffer::getGPUVirtualAddress() const
 {
-	return impl->resourceBuffer->GetGPUVirtualAddress();
+	return impl->currentPage ? impl->currentPage->gpuVirtualAddress : 0;
+}
+
+//---------------------------------------------------------------------------------------
+ID3D12Resource * ResourceUploadBuffer::getResource() const
+{
+	return impl->currentPage ? impl->currentPage->resource.Get() : nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+ResourceUploadBuffer::Statistics ResourceUploadBuffer::getStatistics() const
+{
+	Statistics stats = impl->stats;
+	if (impl->concurrentAllocator) {
+		stats.bytesInUse = impl->concurrentAllocator->usedBytes();
+		stats.highWaterMarkBytes = max(stats.highWaterMarkBytes, stats.bytesInUse);
+	}
+
+	return stats;
+}
+
+//---------------------------------------------------------------------------------------
+void ResourceUploadBuffer::setCurrentFenceValue (
+	uint64 fenceValue
+) {
+	Assert(impl->allocationMode == AllocationMode::Ring);
+	impl->currentFenceValue = fenceValue;
+}
+
+//---------------------------------------------------------------------------------------
+void ResourceUploadBuffer::retireUploads (
+	uint64 fenceValue
+) {
+	Assert(impl->allocationMode != AllocationMode::Ring);
+
+	if (impl->concurrentAllocator) {
+		// The single page is kept, its memory is reset once fenceValue completes.
+		impl->currentPage->retireFenceValue = fenceValue;
+		impl->concurrentPageRetired = true;
+		impl->updateStatistics();
+		return;
+	}
+
+	for (auto & page : impl->usedPages) {
+		page->retireFenceValue = fenceValue;
+		impl->retiredPages.push_back(std::move(page));
+	}
+	impl->usedPages.clear();
+
+	// Next upload will acquire a fresh page.
+	impl->currentPage = nullptr;
+	impl->dataCur = nullptr;
+
+	impl->updateStatistics();
+}
+
+//---------------------------------------------------------------------------------------
+void ResourceUploadBuffer::reclaimCompletedUploads (
+	uint64 completedFenceValue
+) {
+	if (impl->ringAllocator) {
+		impl->ringAllocator->reclaim(completedFenceValue);
+		impl->updateStatistics();
+		return;
+	}
+
+	if (impl->concurrentAllocator) {
+		if (impl->concurrentPageRetired &&
+			impl->currentPage->retireFenceValue <= completedFenceValue)
+		{
+			impl->updateStatistics();
+			impl->concurrentAllocator->reset();
+			impl->concurrentPageRetired = false;
+			impl->updateStatistics();
+		}
+		return;
+	}
+
+	auto & retiredPages = impl->retiredPages;
+	while (!retiredPages.empty() &&
+		retiredPages.front()->retireFenceValue <= completedFenceValue)
+	{
+		ResourceUploadBufferImpl::PagePtr page = std::move(retiredPages.front());
+		retiredPages.pop_front();
+
+		impl->stats.bytesInUse -= page->bytesUsed;
+
+		// Dedicated pages have one-off sizes, so release them rather than recycling.
+		if (!page->isDedicated) {
+			impl->freePages.push_back(std::move(page));
+		}
+	}
+
+	impl->updateStatistics();
 }
 
 //---------------------------------------------------------------------------------------
@@ -2,6 +2,7 @@
 
 #include <d3d12.h>
 #include "Common/BasicTypes.hpp"
+#include "Common/Mesh.hpp"
 
 // Forward Declaration
 class ResourceUploadBufferImpl;
@@ -9,13 +10,63 @@ class ResourceUploadBufferImpl;
 /**
 * Class for managing an upload heap buffer for uploading resources that are 
 * typically write-once, read-once GPU data.
+*
+* In AllocationMode::Linear storage is a list of fixed-size upload heap pages.  A new
+* page is chained on whenever the current one is full, and requests larger than a page
+* receive a dedicated page of their own.  Pages handed back through retireUploads()
+* are recycled via a free list once their fence completes.
+*
+* In AllocationMode::Ring the buffer instead acts as a persistently mapped ring for
+* per-frame dynamic data.  Each upload is tagged with the fence value set through
+* setCurrentFenceValue(), and its space is recycled once reclaimCompletedUploads()
+* is called with a completed fence value at least as large.
+*
+* AllocationMode::Concurrent uses a single fixed-size page that any number of threads
+* can upload into at once.  Sub-allocation is a lock-free atomic fetch-add, with each
+* thread caching a chunk of the page to serve small uploads from.
 */
 class ResourceUploadBuffer {
 public:
+	enum class AllocationMode {
+		// Sub-allocations only move forward, chaining new pages as needed.
+		Linear,
 
+		// Sub-allocations wrap around, reusing memory retired by the frame fence.
+		Ring,
+
+		// Thread-safe sub-allocations from one page, reused once retired.
+		Concurrent
+	};
+
+	/// Default page size for AllocationMode::Linear.
+	static const uint64 DefaultPageSize = 64 * 1024;
+
+	struct Statistics {
+		// Pages created over the lifetime of the buffer, including dedicated pages.
+		uint numPagesCreated;
+
+		// Pages currently being written to, or waiting on a fence to retire.
+		uint numPagesInUse;
+
+		// Pages ready to be reused.
+		uint numFreePages;
+
+		// Largest value numPagesInUse has reached.
+		uint peakPagesInUse;
+
+		// Bytes sub-allocated and not yet reclaimed, including alignment padding.
+		uint64 bytesInUse;
+
+		// Largest value bytesInUse has reached.
+		uint64 highWaterMarkBytes;
+	};
+
+	/// @param sizeInBytes - page size for AllocationMode::Linear, or the total buffer
+	/// size for AllocationMode::Ring and AllocationMode::Concurrent.
 	ResourceUploadBuffer (
 		ID3D12Device * device,
-		uint64 sizeInBytes
+		uint64 sizeInBytes = DefaultPageSize,
+		AllocationMode allocationMode = AllocationMode::Linear
 	);
 
 	~ResourceUploadBuffer();
@@ -28,6 +79,7 @@ public:
 		_Out_opt_ void ** mappedDataPtr = nullptr
 	);
 
+	/// @param sizeOfIndex - 2 or 4, selecting DXGI_FORMAT_R16_UINT or R32_UINT.
 	void uploadIndexData (
 		_In_ const void * data,
 		_In_ size_t dataBytes,
@@ -36,6 +88,13 @@ public:
 		_Out_opt_ void ** mappedDataPtr = nullptr
 	);
 
+	/// Uploads the indices of 'mesh' using the index width chosen for it.
+	void uploadIndexData (
+		_In_ const Mesh & mesh,
+		_Out_ D3D12_INDEX_BUFFER_VIEW & indexBufferView,
+		_Out_opt_ void ** mappedDataPtr = nullptr
+	);
+
 	void uploadConstantBufferData (
 		_In_ const void * data,
 		_In_ size_t dataBytes,
@@ -43,8 +102,38 @@ public:
 		_Out_opt_ void ** mappedDataPtr = nullptr
 	);
 
+	/// GPU virtual address of the page currently being sub-allocated from.
 	D3D12_GPU_VIRTUAL_ADDRESS getGPUVirtualAddress() const;
 
+	/// Resource backing the page currently being sub-allocated from, which in
+	/// AllocationMode::Ring and AllocationMode::Concurrent holds every upload.  The
+	/// offset of an upload is its address less getGPUVirtualAddress().
+	ID3D12Resource * getResource() const;
+
+	Statistics getStatistics() const;
+
+	/// Fence value that will be signaled once the GPU has consumed the uploads that
+	/// follow this call.  Only used in AllocationMode::Ring.
+	void setCurrentFenceValue (
+		uint64 fenceValue
+	);
+
+	/// Hands every page written so far back to the buffer, to be recycled once
+	/// 'fenceValue' completes.  Data uploaded before this call must not be accessed
+	/// after that point.  Not used in AllocationMode::Ring.
+	///
+	/// In AllocationMode::Concurrent no thread may be uploading during this call,
+	/// and uploads must not resume until the retired memory has been reclaimed.
+	void retireUploads (
+		uint64 fenceValue
+	);
+
+	/// Recycles memory of all uploads retired or tagged with a fence value less than
+	/// or equal to 'completedFenceValue'.
+	void reclaimCompletedUploads (
+		uint64 completedFenceValue
+	);
+
 
 private:
 	ResourceUploadBufferImpl * impl;
@@ -0,0 +1,105 @@
+//
+// RingAllocator.cpp
+//
+// Built without the precompiled header so that it stays free of Windows includes.
+//
+#include "RingAllocator.hpp"
+
+#include <cassert>
+
+
+//---------------------------------------------------------------------------------------
+static size_t alignOffset (
+	size_t offset,
+	size_t alignment
+) {
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	return (offset + (alignment - 1)) & ~(alignment - 1);
+}
+
+//---------------------------------------------------------------------------------------
+RingAllocator::RingAllocator (
+	size_t capacityInBytes
+)
+	: m_capacity(capacityInBytes),
+	  m_head(0),
+	  m_tail(0),
+	  m_usedBytes(0)
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+size_t RingAllocator::allocate (
+	size_t sizeInBytes,
+	size_t alignment,
+	uint64 fenceValue
+) {
+	assert(m_pendingFences.empty() || fenceValue >= m_pendingFences.back().fenceValue);
+
+	if (m_usedBytes == 0) {
+		// Ring is empty, so start over from the beginning to minimize wrap-around.
+		m_head = m_tail = 0;
+	}
+
+	size_t offset = alignOffset(m_head, alignment);
+	size_t newHead;
+
+	if (m_head >= m_tail && m_usedBytes < m_capacity) {
+		// Free space is [head, capacity) followed by [0, tail).
+		if (offset + sizeInBytes <= m_capacity) {
+			newHead = offset + sizeInBytes;
+		} else if (sizeInBytes <= m_tail) {
+			// Wrap around, wasting the remaining bytes at the end of the ring.
+			offset = 0;
+			newHead = sizeInBytes;
+		} else {
+			return InvalidOffset;
+		}
+	} else {
+		// Free space is [head, tail).
+		if (m_usedBytes < m_capacity && offset + sizeInBytes <= m_tail) {
+			newHead = offset + sizeInBytes;
+		} else {
+			return InvalidOffset;
+		}
+	}
+
+	// Bytes consumed, including padding and any bytes skipped at the end of the ring.
+	const size_t numBytes = (newHead >= m_head) && (offset >= m_head) ?
+		newHead - m_head : (m_capacity - m_head) + newHead;
+
+	m_head = newHead;
+	m_usedBytes += numBytes;
+
+	if (!m_pendingFences.empty() && m_pendingFences.back().fenceValue == fenceValue) {
+		m_pendingFences.back().endOffset = newHead;
+		m_pendingFences.back().numBytes += numBytes;
+	} else {
+		m_pendingFences.push_back(FenceRegion{fenceValue, newHead, numBytes});
+	}
+
+	return offset;
+}
+
+//---------------------------------------------------------------------------------------
+void RingAllocator::reclaim (
+	uint64 completedFenceValue
+) {
+	while (!m_pendingFences.empty() &&
+		m_pendingFences.front().fenceValue <= completedFenceValue)
+	{
+		const FenceRegion & region = m_pendingFences.front();
+		m_tail = region.endOffset;
+		m_usedBytes -= region.numBytes;
+		m_pendingFences.pop_front();
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void RingAllocator::reset()
+{
+	m_pendingFences.clear();
+	m_head = m_tail = 0;
+	m_usedBytes = 0;
+}
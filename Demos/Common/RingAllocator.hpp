@@ -0,0 +1,75 @@
+//
+// RingAllocator.hpp
+//
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+#include "Common/BasicTypes.hpp"
+
+/**
+* Offset based ring allocator whose sub-allocations are tagged with the fence value
+* of the frame that uses them.  Space is reclaimed in FIFO order once the GPU reports
+* that the tagging fence value has completed.
+*
+* The allocator only deals in byte offsets, and has no D3D12 dependencies, so the
+* reclamation logic can be driven by a fake fence on any platform.
+*/
+class RingAllocator {
+public:
+	/// Returned by allocate() when the ring does not have enough free space.
+	static const size_t InvalidOffset = ~size_t(0);
+
+	explicit RingAllocator (
+		size_t capacityInBytes
+	);
+
+	/// Sub-allocates 'sizeInBytes' aligned to 'alignment' (power of 2), tagging the
+	/// allocation with 'fenceValue'.  Fence values must be non-decreasing.
+	/// @return byte offset of allocation, or InvalidOffset if the ring is full.
+	size_t allocate (
+		size_t sizeInBytes,
+		size_t alignment,
+		uint64 fenceValue
+	);
+
+	/// Frees all allocations tagged with a fence value <= 'completedFenceValue'.
+	void reclaim (
+		uint64 completedFenceValue
+	);
+
+	/// Frees all allocations regardless of their fence value.
+	void reset();
+
+	size_t capacity() const { return m_capacity; }
+
+	/// Bytes currently held by in-flight allocations, including alignment padding.
+	size_t usedBytes() const { return m_usedBytes; }
+
+	/// Number of distinct fence values with live allocations.
+	size_t numPendingFences() const { return m_pendingFences.size(); }
+
+private:
+	struct FenceRegion {
+		uint64 fenceValue;
+
+		// Offset one past the last byte allocated for fenceValue.
+		size_t endOffset;
+
+		// Bytes consumed by fenceValue, including padding and wrap-around waste.
+		size_t numBytes;
+	};
+
+	size_t m_capacity;
+
+	// Offset of next allocation.
+	size_t m_head;
+
+	// Offset of oldest live allocation.
+	size_t m_tail;
+
+	size_t m_usedBytes;
+
+	std::deque<FenceRegion> m_pendingFences;
+};
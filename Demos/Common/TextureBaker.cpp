@@ -0,0 +1,122 @@
+//
+// TextureBaker.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "TextureBaker.hpp"
+
+#include <vector>
+
+#include "BlockCompression.hpp"
+#include "ImageDecoder.hpp"
+#include "MeshCache.hpp"
+#include "MipGenerator.hpp"
+
+
+//---------------------------------------------------------------------------------------
+uint64 TextureBaker::hashOptions (
+	const Options & options
+) {
+	uint64 hash = MeshCache::hashBytes(&options.compression, sizeof(options.compression));
+	hash = MeshCache::hashBytes(&options.isSrgb, sizeof(options.isSrgb), hash);
+	return MeshCache::hashBytes(&options.generateMips, sizeof(options.generateMips), hash);
+}
+
+//---------------------------------------------------------------------------------------
+static uint32 bakedFormat (
+	TextureBaker::Compression compression,
+	bool isSrgb
+) {
+	using namespace DdsFile;
+
+	switch (compression) {
+		case TextureBaker::Compression::BC1:
+			return isSrgb ? DxgiFormat::BC1_UNORM_SRGB : DxgiFormat::BC1_UNORM;
+		case TextureBaker::Compression::BC3:
+			return isSrgb ? DxgiFormat::BC3_UNORM_SRGB : DxgiFormat::BC3_UNORM;
+		case TextureBaker::Compression::BC7:
+			return isSrgb ? DxgiFormat::BC7_UNORM_SRGB : DxgiFormat::BC7_UNORM;
+		default:
+			return isSrgb ? DxgiFormat::R8G8B8A8_UNORM_SRGB : DxgiFormat::R8G8B8A8_UNORM;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void TextureBaker::bake (
+	const void * encoded,
+	size_t encodedSize,
+	const char * ddsPath,
+	const Options & options,
+	const DdsFile::BakeInfo & bakeInfo,
+	JobSystem * jobSystem
+) {
+	const ImageInfo imageInfo = ImageDecoder::readInfo(encoded, encodedSize);
+
+	// Block compressed textures must have whole blocks at level 0.
+	Compression compression = options.compression;
+	if (imageInfo.width % 4 != 0 || imageInfo.height % 4 != 0) {
+		compression = Compression::None;
+	}
+
+	DdsFile::Description description;
+	description.width = imageInfo.width;
+	description.height = imageInfo.height;
+	description.arraySize = 1;
+	description.numMipLevels = options.generateMips ?
+		MipGenerator::numMipLevels(imageInfo.width, imageInfo.height) : 1;
+	description.dxgiFormat = bakedFormat(compression, options.isSrgb);
+	description.isCubemap = false;
+
+	// Every level as RGBA8, tightly packed.
+	std::vector<std::vector<byte>> images(description.numMipLevels);
+	std::vector<ImageDestination> levels(description.numMipLevels);
+	for (uint level = 0; level < description.numMipLevels; ++level) {
+		const uint width = MipGenerator::mipSize(imageInfo.width, level);
+		const uint height = MipGenerator::mipSize(imageInfo.height, level);
+		images[level].resize(size_t(width) * height * 4);
+		levels[level] = { images[level].data(), size_t(width) * 4, images[level].size() };
+	}
+
+	ImageDecoder decoder;
+	decoder.decode(encoded, encodedSize, levels[0]);
+
+	const ImageView image = {
+		images[0].data(), levels[0].rowPitch, imageInfo.width, imageInfo.height
+	};
+	MipGenerator::generateMipChain (
+		image, levels.data(), description.numMipLevels, options.isSrgb, jobSystem
+	);
+
+	std::vector<DdsFile::Subresource> subresources(description.numMipLevels);
+	std::vector<std::vector<byte>> blocks;
+	if (compression == Compression::None) {
+		for (uint level = 0; level < description.numMipLevels; ++level) {
+			subresources[level] = DdsFile::subresourceLayout(description, level);
+			subresources[level].data = images[level].data();
+		}
+	} else {
+		const BlockCompression::Format format =
+			compression == Compression::BC1 ? BlockCompression::Format::BC1 :
+			compression == Compression::BC3 ? BlockCompression::Format::BC3 :
+			BlockCompression::Format::BC7;
+
+		blocks.resize(description.numMipLevels);
+		for (uint level = 0; level < description.numMipLevels; ++level) {
+			DdsFile::Subresource & subresource = subresources[level];
+			subresource = DdsFile::subresourceLayout(description, level);
+			blocks[level].resize(subresource.rowBytes * subresource.numRows);
+			subresource.data = blocks[level].data();
+
+			const ImageView levelImage = {
+				images[level].data(), levels[level].rowPitch, subresource.width,
+				subresource.height
+			};
+			const ImageDestination destination = {
+				blocks[level].data(), subresource.rowPitch, blocks[level].size()
+			};
+			BlockCompression::compress(levelImage, format, destination, jobSystem);
+		}
+	}
+
+	DdsFile::write(ddsPath, description, subresources.data(), &bakeInfo);
+}
@@ -0,0 +1,60 @@
+//
+// TextureBaker.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/DdsFile.hpp"
+
+class JobSystem;
+
+
+/**
+* Converts PNG and JPEG images into DDS files ready for upload, so that loading a
+* texture only maps a file and copies its subresources.
+*
+* Baking decodes the image, filters its mip chain with MipGenerator and encodes every
+* level with BlockCompression.  Images whose sides are not multiples of 4 cannot be
+* block compressed, and are stored as RGBA8 instead.
+*
+* Has no Windows dependencies, errors throw std::runtime_error.
+*/
+namespace TextureBaker {
+
+	enum class Compression {
+		None,
+		BC1,
+		BC3,
+		BC7
+	};
+
+	struct Options {
+		Compression compression = Compression::BC7;
+
+		/// Stores an _SRGB format, and filters mips in linear space.
+		bool isSrgb = true;
+
+		/// Builds a full mip chain rather than a single level.
+		bool generateMips = true;
+	};
+
+	/// Hash of the options that affect baked data, stored in BakeInfo::settingsHash.
+	uint64 hashOptions (
+		const Options & options
+	);
+
+	/// Bakes the PNG or JPEG file contents 'encoded' into a DDS file at 'ddsPath'.
+	/// @param bakeInfo - identifies the source, with settingsHash from hashOptions().
+	/// @param jobSystem - runs mip filtering and compression in parallel, nullptr runs
+	/// them on the calling thread.
+	void bake (
+		const void * encoded,
+		size_t encodedSize,
+		const char * ddsPath,
+		const Options & options,
+		const DdsFile::BakeInfo & bakeInfo,
+		JobSystem * jobSystem
+	);
+};
@@ -0,0 +1,224 @@
+#include "pch.h"
+using Microsoft::WRL::ComPtr;
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "TextureLoader.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+
+
+//---------------------------------------------------------------------------------------
+static const char * getFileName (
+	_In_ const char * assetPath
+) {
+	const char * fileName = strrchr(assetPath, '\\');
+	return fileName ? fileName + 1 : assetPath;
+}
+
+//---------------------------------------------------------------------------------------
+static bool hasDdsExtension (
+	_In_ const char * assetPath
+) {
+	const size_t length = strlen(assetPath);
+	return length >= 4 && _stricmp(assetPath + length - 4, ".dds") == 0;
+}
+
+//---------------------------------------------------------------------------------------
+// Maps 'path', treating files that fail to parse as stale.
+static bool openBakedTexture (
+	_In_ const char * path,
+	_Out_ MappedDds & texture
+) {
+	try {
+		return texture.open(path);
+	}
+	catch (const std::runtime_error & error) {
+		LOG_INFO("Rebuilding %s: %s", getFileName(path), error.what());
+		return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void TextureLoader::loadCachedTexture (
+	_In_ const char * assetPath,
+	_Out_ MappedDds & texture,
+	_In_ const TextureBaker::Options & options,
+	_In_opt_ JobSystem * jobSystem
+) {
+	assert(assetPath);
+
+	auto timerStart = std::chrono::high_resolution_clock::now();
+
+	if (hasDdsExtension(assetPath)) {
+		try {
+			if (!texture.open(assetPath)) {
+				ForceBreak("Unable to open texture file: %s", assetPath);
+			}
+		}
+		catch (const std::runtime_error & error) {
+			ForceBreak("Error loading %s: %s", assetPath, error.what());
+		}
+		return;
+	}
+
+	const std::string cachePath = std::string(assetPath) + CacheFileExtension;
+	const uint64 settingsHash = TextureBaker::hashOptions(options);
+
+	DdsFile::BakeInfo source;
+	if (!MeshCache::queryFile(assetPath, source.sourceTimestamp, source.sourceSize)) {
+		ForceBreak("Unable to open texture asset file: %s", assetPath);
+	}
+	source.settingsHash = settingsHash;
+
+	MappedFile imageFile;
+
+	if (openBakedTexture(cachePath.c_str(), texture)) {
+		const DdsFile::BakeInfo * bakeInfo = texture.bakeInfo();
+		bool isCurrent = bakeInfo && bakeInfo->settingsHash == settingsHash &&
+			bakeInfo->sourceSize == source.sourceSize;
+
+		if (isCurrent && bakeInfo->sourceTimestamp != source.sourceTimestamp) {
+			// Source was touched, e.g. by a checkout, so compare its contents.
+			if (!imageFile.open(assetPath)) {
+				ForceBreak("Unable to open texture asset file: %s", assetPath);
+			}
+			isCurrent = MeshCache::hashBytes(imageFile.data(), imageFile.size()) ==
+				bakeInfo->sourceHash;
+		}
+
+		if (isCurrent) {
+			auto timerEnd = std::chrono::high_resolution_clock::now();
+			double seconds = std::chrono::duration<double>(timerEnd - timerStart).count();
+
+			LOG_INFO("Loaded baked %s: %ux%u, %u mip levels in %.2f ms",
+				getFileName(assetPath), texture.description().width,
+				texture.description().height, texture.description().numMipLevels,
+				seconds * 1000.0);
+			return;
+		}
+
+		// Release the mapping so the stale file can be replaced.
+		texture.close();
+	}
+
+	if (!imageFile.isOpen() && !imageFile.open(assetPath)) {
+		ForceBreak("Unable to open texture asset file: %s", assetPath);
+	}
+	source.sourceHash = MeshCache::hashBytes(imageFile.data(), imageFile.size());
+
+	try {
+		TextureBaker::bake (
+			imageFile.data(), imageFile.size(), cachePath.c_str(), options, source, jobSystem
+		);
+	}
+	catch (const std::runtime_error & error) {
+		ForceBreak("Error baking texture for %s: %s", assetPath, error.what());
+	}
+
+	if (!openBakedTexture(cachePath.c_str(), texture)) {
+		ForceBreak("Unable to open baked texture file: %s", cachePath.c_str());
+	}
+
+	auto timerEnd = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(timerEnd - timerStart).count();
+
+	LOG_INFO("Baked texture for %s in %.2f ms", getFileName(assetPath), seconds * 1000.0);
+}
+
+//---------------------------------------------------------------------------------------
+void TextureLoader::createTexture (
+	_In_ ID3D12Device * device,
+	_In_ const MappedDds & texture,
+	_In_ D3D12_RESOURCE_STATES initialState,
+	_Out_ ComPtr<ID3D12Resource> & textureResource,
+	_In_ uint firstMip
+) {
+	const DdsFile::Description & description = texture.description();
+	assert(firstMip < description.numMipLevels);
+	const DdsFile::Subresource & topLevel = texture.subresource(firstMip);
+	const auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_DEFAULT);
+	const auto textureResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D (
+		DXGI_FORMAT(description.dxgiFormat), topLevel.width, topLevel.height,
+		uint16(description.arraySize), uint16(description.numMipLevels - firstMip)
+	);
+
+	CHECK_D3D_RESULT (
+		device->CreateCommittedResource (
+			&defaultHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&textureResourceDesc,
+			initialState,
+			nullptr,
+			IID_PPV_ARGS(&textureResource)
+		)
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void TextureLoader::uploadTexture (
+	_In_ ID3D12Device * device,
+	_In_ ID3D12GraphicsCommandList * cmdList,
+	_In_ const MappedDds & texture,
+	_In_ ID3D12Resource * textureResource,
+	_Out_ ComPtr<ID3D12Resource> & uploadBuffer,
+	_In_ uint firstMip
+) {
+	// Layout of every subresource in the upload buffer, with rows padded to
+	// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT.  Rows of block compressed formats are rows
+	// of blocks, as in the DDS file.
+	const auto textureResourceDesc = textureResource->GetDesc();
+	const uint numMipLevels = textureResourceDesc.MipLevels;
+	const uint numSubresources = numMipLevels * textureResourceDesc.DepthOrArraySize;
+	assert(firstMip + numMipLevels == texture.description().numMipLevels);
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(numSubresources);
+	uint64 uploadBufferSize;
+	device->GetCopyableFootprints (
+		&textureResourceDesc, 0, numSubresources, 0, footprints.data(), nullptr, nullptr,
+		&uploadBufferSize
+	);
+
+	const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
+	const auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (uploadBufferSize);
+	CHECK_D3D_RESULT (
+		device->CreateCommittedResource (
+			&uploadHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&uploadBufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&uploadBuffer)
+		)
+	);
+
+	void * mappedData;
+	D3D12_RANGE readRange = { 0, 0 };
+	CHECK_D3D_RESULT (
+		uploadBuffer->Map(0, &readRange, &mappedData)
+	);
+
+	for (uint index = 0; index < numSubresources; ++index) {
+		const DdsFile::Subresource & subresource =
+			texture.subresource(firstMip + index % numMipLevels, index / numMipLevels);
+		byte * dst = static_cast<byte *>(mappedData) + footprints[index].Offset;
+		const size_t dstRowPitch = footprints[index].Footprint.RowPitch;
+		for (uint row = 0; row < subresource.numRows; ++row) {
+			memcpy (
+				dst + row * dstRowPitch,
+				subresource.data + row * subresource.rowPitch,
+				subresource.rowBytes
+			);
+		}
+	}
+
+	D3D12_RANGE writtenRange = { 0, size_t(uploadBufferSize) };
+	uploadBuffer->Unmap(0, &writtenRange);
+
+	for (uint index = 0; index < numSubresources; ++index) {
+		const CD3DX12_TEXTURE_COPY_LOCATION copyDest (textureResource, index);
+		const CD3DX12_TEXTURE_COPY_LOCATION copySource (uploadBuffer.Get(), footprints[index]);
+		cmdList->CopyTextureRegion(&copyDest, 0, 0, 0, &copySource, nullptr);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/DdsFile.hpp"
+#include "Common/TextureBaker.hpp"
+
+class JobSystem;
+
+
+/// Loads textures from memory mapped DDS files, baking PNG and JPEG assets into DDS
+/// files on first load so that later loads skip decoding entirely.  Loads are
+/// thread-safe, so several textures can be loaded at once as JobSystem jobs.
+class TextureLoader {
+public:
+	/// Suffix appended to an image asset's path to form the path of its baked texture.
+	static constexpr const char * CacheFileExtension = ".baked.dds";
+
+	/// Maps the texture for 'assetPath'.  DDS assets are mapped as they are.  Other
+	/// assets map a DDS file baked next to them with 'options', which is baked on
+	/// first load, and rebuilt whenever the source or the options change.
+	/// @param jobSystem - used when baking, may be nullptr.
+	static void loadCachedTexture (
+		_In_ const char * assetPath,
+		_Out_ MappedDds & texture,
+		_In_ const TextureBaker::Options & options = TextureBaker::Options(),
+		_In_opt_ JobSystem * jobSystem = nullptr
+	);
+
+	/// Creates a committed texture within the default heap matching the dimensions,
+	/// format and mip levels of 'texture', without the levels finer than 'firstMip'.
+	static void createTexture (
+		_In_ ID3D12Device * device,
+		_In_ const MappedDds & texture,
+		_In_ D3D12_RESOURCE_STATES initialState,
+		_Out_ Microsoft::WRL::ComPtr<ID3D12Resource> & textureResource,
+		_In_ uint firstMip = 0
+	);
+
+	/// Creates 'uploadBuffer', copies every subresource of 'texture' from 'firstMip'
+	/// on into it straight from the mapping, and records their copies into
+	/// 'textureResource', created with the same 'firstMip', on 'cmdList'.
+	/// 'uploadBuffer' must be kept alive until the copies complete.
+	static void uploadTexture (
+		_In_ ID3D12Device * device,
+		_In_ ID3D12GraphicsCommandList * cmdList,
+		_In_ const MappedDds & texture,
+		_In_ ID3D12Resource * textureResource,
+		_Out_ Microsoft::WRL::ComPtr<ID3D12Resource> & uploadBuffer,
+		_In_ uint firstMip = 0
+	);
+};
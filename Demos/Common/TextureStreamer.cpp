@@ -0,0 +1,334 @@
+//
+// TextureStreamer.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "TextureStreamer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+//---------------------------------------------------------------------------------------
+TextureStreamer::TextureStreamer (
+	const Settings & settings,
+	Backend * backend,
+	MemoryBudget * memoryBudget
+)
+	: m_settings(settings),
+	  m_backend(backend),
+	  m_memoryBudget(memoryBudget),
+	  m_updateCount(0)
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+TextureStreamer::~TextureStreamer()
+{
+	if (m_memoryBudget) {
+		for (const Texture & texture : m_textures) {
+			if (texture.isTracked) {
+				m_memoryBudget->releaseAllocation(texture.allocation);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+TextureStreamer::TextureId TextureStreamer::addTexture (
+	const DdsFile::Description & description
+) {
+	Texture texture;
+	texture.description = description;
+	texture.residentMip = description.numMipLevels;
+	texture.targetMip = description.numMipLevels;
+	texture.priority = 0.0f;
+	texture.completionUpdate = 0;
+	texture.allocation = 0;
+	texture.isTracked = false;
+
+	// The finest level that fits within mipTailSize, or the coarsest level if none do.
+	texture.tailMip = description.numMipLevels - 1;
+	while (texture.tailMip > 0) {
+		const uint width = std::max(description.width >> (texture.tailMip - 1), 1u);
+		const uint height = std::max(description.height >> (texture.tailMip - 1), 1u);
+		if (width > m_settings.mipTailSize || height > m_settings.mipTailSize) {
+			break;
+		}
+		--texture.tailMip;
+	}
+
+	// Every change makes resident a range from some level down to the tail, and the
+	// first level of that range becomes the top level of a resource.  Block compressed
+	// resources need a top level whose sides are multiples of the block size, and
+	// levels with such sides are always a prefix of the chain, so keeping the tail
+	// within that prefix keeps every range valid.
+	DdsFile::FormatInfo formatInfo;
+	if (DdsFile::getFormatInfo(description.dxgiFormat, formatInfo) && formatInfo.blockSize > 1) {
+		while (texture.tailMip > 0 &&
+			((description.width >> texture.tailMip) % formatInfo.blockSize != 0 ||
+			 (description.height >> texture.tailMip) % formatInfo.blockSize != 0))
+		{
+			--texture.tailMip;
+		}
+	}
+	texture.requestedMip = texture.tailMip;
+
+	m_textures.push_back(texture);
+	return TextureId(m_textures.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamer::requestMip (
+	TextureId id,
+	uint mipLevel,
+	float priority
+) {
+	Texture & texture = m_textures[id];
+	texture.requestedMip = std::min(mipLevel, texture.tailMip);
+	texture.priority = priority;
+	if (texture.isTracked) {
+		m_memoryBudget->setPriority(texture.allocation, priority);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+uint TextureStreamer::residentMip (
+	TextureId id
+) const {
+	return m_textures[id].residentMip;
+}
+
+//---------------------------------------------------------------------------------------
+uint TextureStreamer::tailMip (
+	TextureId id
+) const {
+	return m_textures[id].tailMip;
+}
+
+//---------------------------------------------------------------------------------------
+uint64 TextureStreamer::residentBytes (
+	TextureId id,
+	uint firstMip
+) const {
+	const DdsFile::Description & description = m_textures[id].description;
+	uint64 bytes = 0;
+	for (uint level = firstMip; level < description.numMipLevels; ++level) {
+		const DdsFile::Subresource layout = DdsFile::subresourceLayout(description, level);
+		bytes += uint64(layout.rowBytes) * layout.numRows;
+	}
+	return bytes * description.arraySize;
+}
+
+//---------------------------------------------------------------------------------------
+uint TextureStreamer::requiredMipLevel (
+	uint width,
+	uint height,
+	float screenPixels
+) {
+	const float texels = float(std::max(width, height));
+	if (screenPixels >= texels) {
+		return 0;
+	}
+	if (screenPixels <= 1.0f) {
+		return UINT32_MAX;
+	}
+	return uint(std::floor(std::log2(texels / screenPixels)));
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamer::trackResidentBytes (
+	TextureId id,
+	uint64 bytes
+) {
+	if (!m_memoryBudget) {
+		return;
+	}
+
+	Texture & texture = m_textures[id];
+	if (texture.isTracked) {
+		m_memoryBudget->resizeAllocation(texture.allocation, bytes);
+	} else {
+		texture.allocation = m_memoryBudget->trackAllocation (
+			MemoryBudget::Segment::Local, bytes, texture.priority, this, id
+		);
+		texture.isTracked = true;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamer::beginChange (
+	TextureId id,
+	uint firstMip
+) {
+	Texture & texture = m_textures[id];
+	assert(!isPending(texture));
+
+	const uint64 bytes = residentBytes(id, firstMip);
+	const bool hasResidentLevels = texture.residentMip < texture.description.numMipLevels;
+	m_statistics.residentBytes += bytes;
+	m_statistics.uploadedBytes += bytes;
+	++m_statistics.numPendingChanges;
+	if (hasResidentLevels) {
+		if (firstMip < texture.residentMip) {
+			++m_statistics.numPromotions;
+		} else {
+			++m_statistics.numDemotions;
+		}
+	}
+
+	texture.targetMip = firstMip;
+	texture.completionUpdate = m_updateCount + m_settings.simulatedLatency;
+
+	trackResidentBytes (
+		id, bytes + (hasResidentLevels ? residentBytes(id, texture.residentMip) : 0)
+	);
+
+	if (m_backend) {
+		m_backend->beginChange(id, firstMip);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+bool TextureStreamer::demoteForBudget (
+	uint64 bytesNeeded,
+	float priority
+) {
+	// Idle textures above their tail with a lower priority, least important first.
+	std::vector<TextureId> candidates;
+	for (TextureId id = 0; id < m_textures.size(); ++id) {
+		const Texture & texture = m_textures[id];
+		if (!isPending(texture) && texture.residentMip < texture.tailMip &&
+			texture.priority < priority)
+		{
+			candidates.push_back(id);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](TextureId a, TextureId b) {
+		return m_textures[a].priority < m_textures[b].priority;
+	});
+
+	uint64 bytesFreed = 0;
+	size_t numDemotions = 0;
+	for (; numDemotions < candidates.size() && bytesFreed < bytesNeeded; ++numDemotions) {
+		const TextureId id = candidates[numDemotions];
+		const uint residentMip = m_textures[id].residentMip;
+		bytesFreed += residentBytes(id, residentMip) - residentBytes(id, residentMip + 1);
+	}
+	if (bytesFreed < bytesNeeded) {
+		return false;
+	}
+
+	for (size_t i = 0; i < numDemotions; ++i) {
+		beginChange(candidates[i], m_textures[candidates[i]].residentMip + 1);
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamer::update()
+{
+	++m_updateCount;
+
+	// Complete finished changes, releasing the levels they replace.
+	for (TextureId id = 0; id < m_textures.size(); ++id) {
+		Texture & texture = m_textures[id];
+		if (!isPending(texture)) {
+			continue;
+		}
+
+		const bool isComplete = m_backend ?
+			m_backend->isChangeComplete(id) : m_updateCount >= texture.completionUpdate;
+		if (isComplete) {
+			if (m_backend) {
+				m_backend->endChange(id);
+			}
+			if (texture.residentMip < texture.description.numMipLevels) {
+				m_statistics.residentBytes -= residentBytes(id, texture.residentMip);
+			}
+			texture.residentMip = texture.targetMip;
+			--m_statistics.numPendingChanges;
+			trackResidentBytes(id, residentBytes(id, texture.residentMip));
+		}
+	}
+
+	// Tails of new textures, and demotions of textures that need fewer levels, free
+	// memory or are required, so they bypass the budgets.
+	uint64 uploadedBytes = 0;
+	m_promotions.clear();
+	for (TextureId id = 0; id < m_textures.size(); ++id) {
+		const Texture & texture = m_textures[id];
+		if (isPending(texture)) {
+			continue;
+		}
+		if (texture.residentMip == texture.description.numMipLevels) {
+			beginChange(id, texture.tailMip);
+			uploadedBytes += residentBytes(id, texture.tailMip);
+		} else if (texture.requestedMip > texture.residentMip) {
+			beginChange(id, texture.requestedMip);
+		} else if (texture.requestedMip < texture.residentMip) {
+			m_promotions.push_back(id);
+		}
+	}
+
+	// Promote one level at a time, most important first, so that every visible
+	// texture sharpens before any one of them reaches full resolution.
+	std::sort(m_promotions.begin(), m_promotions.end(), [this](TextureId a, TextureId b) {
+		return m_textures[a].priority > m_textures[b].priority;
+	});
+	for (TextureId id : m_promotions) {
+		const Texture & texture = m_textures[id];
+		const uint firstMip = texture.residentMip - 1;
+		const uint64 bytes = residentBytes(id, firstMip);
+		if (uploadedBytes > 0 && uploadedBytes + bytes > m_settings.uploadBudgetPerUpdate) {
+			break;
+		}
+
+		// Until the promotion completes both copies are resident.
+		uint64 excess = 0;
+		if (m_statistics.residentBytes + bytes > m_settings.residentBudget) {
+			excess = m_statistics.residentBytes + bytes - m_settings.residentBudget;
+		}
+		if (m_memoryBudget) {
+			const int64 headroom = m_memoryBudget->headroom(MemoryBudget::Segment::Local);
+			if (int64(bytes) > headroom) {
+				excess = std::max(excess, uint64(int64(bytes) - headroom));
+			}
+		}
+		if (excess > 0) {
+			// Make room by demoting less important textures, and retry once they
+			// have released their levels.
+			demoteForBudget(excess, texture.priority);
+			break;
+		}
+
+		beginChange(id, firstMip);
+		uploadedBytes += bytes;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+uint64 TextureStreamer::evict (
+	MemoryBudget::AllocationId allocation,
+	uint64 context,
+	uint64 bytesNeeded
+) {
+	const TextureId id = TextureId(context);
+	const Texture & texture = m_textures[id];
+	assert(texture.isTracked && texture.allocation == allocation);
+	if (isPending(texture) || texture.residentMip >= texture.tailMip) {
+		return 0;
+	}
+
+	// Coarsest level short of the tail that frees enough.
+	const uint64 bytes = residentBytes(id, texture.residentMip);
+	uint firstMip = texture.residentMip + 1;
+	while (firstMip < texture.tailMip && bytes - residentBytes(id, firstMip) < bytesNeeded) {
+		++firstMip;
+	}
+
+	beginChange(id, firstMip);
+	return bytes - residentBytes(id, firstMip);
+}
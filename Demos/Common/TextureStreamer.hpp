@@ -0,0 +1,211 @@
+//
+// TextureStreamer.hpp
+//
+#pragma once
+
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/DdsFile.hpp"
+#include "Common/MemoryBudget.hpp"
+
+
+/**
+* Decides which mip levels of each texture are resident, streaming finer levels in
+* as they are needed and dropping them again under memory pressure.
+*
+* Each texture keeps a contiguous range of levels resident, from its finest resident
+* level down to 1x1.  The mip tail, the levels no larger than Settings::mipTailSize,
+* is made resident first and never evicted.  For block compressed formats the tail
+* instead starts at the coarsest level whose sides are multiples of 4, if that is
+* finer, as each resident range is created as a resource with its first level on top.  Every frame the caller requests the
+* finest level each texture needs, e.g. from its projected screen size, and update()
+* then moves textures towards those levels one at a time, most important first,
+* within a per-update upload budget and a cap on resident bytes.  When the cap is
+* reached, textures with a lower priority are demoted to make room.
+*
+* A Backend carries out each residency change.  Changes are asynchronous: a texture
+* keeps sampling its current levels until its change completes, so both are counted
+* as resident in the meantime.  Without a Backend, changes are simulated on the CPU
+* and complete a fixed number of updates after they begin, which allows the
+* streaming policy to run without a GPU.
+*
+* Given a MemoryBudget, each texture is tracked as an allocation within local
+* memory.  Promotions then also stay within its headroom, and the budget may evict
+* textures under memory pressure, which demotes them towards their tails.
+*
+* Has no Windows dependencies.  Not thread-safe.
+*/
+class TextureStreamer : public MemoryBudget::Evictor {
+public:
+	typedef uint TextureId;
+
+	struct Settings {
+		/// Bytes all textures may keep resident.  Mip tails stay resident even beyond it.
+		uint64 residentBudget = 64ull << 20;
+
+		/// Bytes of changes begun per update(), though a single change larger than
+		/// the budget still begins once nothing else has this update.
+		uint64 uploadBudgetPerUpdate = 8ull << 20;
+
+		/// Levels with both sides at most this many pixels form the mip tail.
+		uint mipTailSize = 128;
+
+		/// Updates a change takes to complete when simulated without a Backend.
+		uint simulatedLatency = 2;
+	};
+
+	/// Makes a new range of levels resident.  A texture has at most one change in
+	/// flight, which replaces its levels as a whole.
+	class Backend {
+	public:
+		virtual ~Backend() {}
+
+		/// Starts making levels firstMip to numMipLevels - 1 of 'texture' resident.
+		virtual void beginChange (
+			TextureId texture,
+			uint firstMip
+		) = 0;
+
+		/// True once the change begun for 'texture' can replace its current levels.
+		virtual bool isChangeComplete (
+			TextureId texture
+		) = 0;
+
+		/// Replaces the levels of 'texture' with those of its completed change.
+		virtual void endChange (
+			TextureId texture
+		) = 0;
+	};
+
+	struct Statistics {
+		/// Bytes of resident levels, plus those of changes in flight.
+		uint64 residentBytes = 0;
+
+		/// Bytes of all changes begun so far.
+		uint64 uploadedBytes = 0;
+
+		uint numPromotions = 0;
+		uint numDemotions = 0;
+		uint numPendingChanges = 0;
+	};
+
+	/// @param backend - carries out residency changes, nullptr simulates them.
+	/// @param memoryBudget - tracks resident levels, may be nullptr.
+	TextureStreamer (
+		const Settings & settings,
+		Backend * backend,
+		MemoryBudget * memoryBudget = nullptr
+	);
+
+	~TextureStreamer();
+
+	/// Adds a texture with no resident levels.  Its mip tail is made resident by the
+	/// next update(), regardless of budgets.
+	TextureId addTexture (
+		const DdsFile::Description & description
+	);
+
+	/// Sets the finest level 'texture' needs, until the next request.
+	/// @param priority - importance relative to other textures, e.g. screen coverage.
+	void requestMip (
+		TextureId texture,
+		uint mipLevel,
+		float priority
+	);
+
+	/// Completes finished changes, then begins new ones.  Call once per frame.
+	void update();
+
+	/// Finest level 'texture' can currently sample, numMipLevels before its tail is
+	/// resident.
+	uint residentMip (
+		TextureId texture
+	) const;
+
+	/// First level of the mip tail of 'texture'.
+	uint tailMip (
+		TextureId texture
+	) const;
+
+	/// Bytes of levels firstMip to numMipLevels - 1 of 'texture'.
+	uint64 residentBytes (
+		TextureId texture,
+		uint firstMip
+	) const;
+
+	const Statistics & statistics() const { return m_statistics; }
+
+	/// Finest level needed to draw a texture of size 'width' x 'height' across
+	/// 'screenPixels' pixels, at one texel per pixel.
+	static uint requiredMipLevel (
+		uint width,
+		uint height,
+		float screenPixels
+	);
+
+	/// Demotes the texture 'context' far enough to free 'bytesNeeded', though
+	/// never past its tail.  Called by the MemoryBudget.
+	uint64 evict (
+		MemoryBudget::AllocationId allocation,
+		uint64 context,
+		uint64 bytesNeeded
+	) override;
+
+private:
+	struct Texture {
+		DdsFile::Description description;
+		uint tailMip;
+
+		// Finest resident level, description.numMipLevels when none are.
+		uint residentMip;
+
+		// Level the change in flight makes resident, equal to residentMip when idle.
+		uint targetMip;
+
+		uint requestedMip;
+		float priority;
+
+		// Update on which a simulated change completes.
+		uint64 completionUpdate;
+
+		// Allocation tracking the texture within m_memoryBudget, once it has one.
+		MemoryBudget::AllocationId allocation;
+		bool isTracked;
+	};
+
+	Settings m_settings;
+	Backend * m_backend;
+	MemoryBudget * m_memoryBudget;
+	std::vector<Texture> m_textures;
+	Statistics m_statistics;
+	uint64 m_updateCount;
+
+	// Scratch list of textures to promote, reused across updates.
+	std::vector<TextureId> m_promotions;
+
+	bool isPending (
+		const Texture & texture
+	) const {
+		return texture.targetMip != texture.residentMip;
+	}
+
+	void beginChange (
+		TextureId id,
+		uint firstMip
+	);
+
+	/// Sets the bytes tracked for 'texture' in m_memoryBudget.
+	void trackResidentBytes (
+		TextureId id,
+		uint64 bytes
+	);
+
+	/// Demotes textures with a priority below 'priority' by a level each, until
+	/// 'bytesNeeded' would be freed once the demotions complete.
+	/// @return false if not enough can be freed.
+	bool demoteForBudget (
+		uint64 bytesNeeded,
+		float priority
+	);
+};
@@ -0,0 +1,169 @@
+#include "pch.h"
+
+#include "TextureStreamingBackend.hpp"
+#include "TextureLoader.hpp"
+
+#include <algorithm>
+
+
+// Ticket of a change whose upload has been recorded but not yet submitted.
+static const UploadQueue::Ticket UnsubmittedTicket = UINT64_MAX;
+
+
+//---------------------------------------------------------------------------------------
+TextureStreamingBackend::TextureStreamingBackend (
+	_In_ ID3D12Device * device,
+	_In_ UploadQueue * uploadQueue,
+	_In_ ID3D12DescriptorHeap * srvHeap,
+	_In_ uint firstDescriptor
+)
+	: m_device(device),
+	  m_uploadQueue(uploadQueue),
+	  m_srvHeap(srvHeap),
+	  m_firstDescriptor(firstDescriptor),
+	  m_lastSubmittedFence(0),
+	  m_completedFence(0),
+	  m_requiredUploadTicket(UploadQueue::NullTicket)
+{
+	m_descriptorSize = m_device->GetDescriptorHandleIncrementSize (
+		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamingBackend::addTexture (
+	_In_ TextureStreamer::TextureId id,
+	_In_ const MappedDds & texture
+) {
+	assert(id == m_textures.size());
+
+	Texture streamedTexture;
+	streamedTexture.source = &texture;
+	streamedTexture.pendingFirstMip = 0;
+	streamedTexture.pendingTicket = UploadQueue::NullTicket;
+	streamedTexture.currentDescriptor = 0;
+	streamedTexture.retireFence = 0;
+	m_textures.push_back(streamedTexture);
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamingBackend::beginFrame (
+	_In_ uint64 lastSubmittedFence,
+	_In_ uint64 completedFence
+) {
+	m_lastSubmittedFence = lastSubmittedFence;
+	m_completedFence = completedFence;
+
+	while (!m_retiredResources.empty() &&
+		m_retiredResources.front().retireFence <= m_completedFence)
+	{
+		m_retiredResources.pop_front();
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamingBackend::endFrame()
+{
+	if (m_unsubmittedChanges.empty()) {
+		return;
+	}
+
+	const UploadQueue::Ticket ticket = m_uploadQueue->submit();
+	for (TextureStreamer::TextureId id : m_unsubmittedChanges) {
+		m_textures[id].pendingTicket = ticket;
+	}
+	m_unsubmittedChanges.clear();
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamingBackend::beginChange (
+	TextureStreamer::TextureId id,
+	uint firstMip
+) {
+	Texture & texture = m_textures[id];
+	assert(!texture.pendingResource);
+
+	// Created in COMMON, as required by the copy queue, which decays back to COMMON
+	// once the upload completes.
+	TextureLoader::createTexture (
+		m_device, *texture.source, D3D12_RESOURCE_STATE_COMMON, texture.pendingResource,
+		firstMip
+	);
+	SET_D3D12_DEBUG_NAME(texture.pendingResource);
+
+	ComPtr<ID3D12Resource> uploadBuffer;
+	TextureLoader::uploadTexture (
+		m_device, m_uploadQueue->getCommandList(), *texture.source,
+		texture.pendingResource.Get(), uploadBuffer, firstMip
+	);
+	m_uploadQueue->keepAlive(uploadBuffer.Get());
+
+	texture.pendingFirstMip = firstMip;
+	texture.pendingTicket = UnsubmittedTicket;
+	m_unsubmittedChanges.push_back(id);
+}
+
+//---------------------------------------------------------------------------------------
+bool TextureStreamingBackend::isChangeComplete (
+	TextureStreamer::TextureId id
+) {
+	const Texture & texture = m_textures[id];
+	if (texture.pendingTicket == UnsubmittedTicket) {
+		return false;
+	}
+
+	// Nothing samples a texture without resident levels, so the first change
+	// completes at once and the direct queue waits on its upload instead.
+	if (!texture.resource) {
+		return true;
+	}
+
+	// The other descriptor is rewritten, so wait for frames that sample it too.
+	return texture.retireFence <= m_completedFence &&
+		m_uploadQueue->isComplete(texture.pendingTicket);
+}
+
+//---------------------------------------------------------------------------------------
+void TextureStreamingBackend::endChange (
+	TextureStreamer::TextureId id
+) {
+	Texture & texture = m_textures[id];
+	assert(texture.pendingResource);
+
+	if (texture.resource) {
+		// Frames submitted so far may still sample the replaced texture.
+		m_retiredResources.push_back({ texture.resource, m_lastSubmittedFence });
+		texture.currentDescriptor ^= 1;
+	}
+	texture.resource = std::move(texture.pendingResource);
+	texture.retireFence = m_lastSubmittedFence;
+	m_requiredUploadTicket = std::max(m_requiredUploadTicket, texture.pendingTicket);
+
+	const DdsFile::Description & description = texture.source->description();
+	D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc = {};
+	shaderResourceViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	shaderResourceViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	shaderResourceViewDesc.Format = DXGI_FORMAT(description.dxgiFormat);
+	shaderResourceViewDesc.Texture2D.MipLevels =
+		description.numMipLevels - texture.pendingFirstMip;
+	shaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
+	shaderResourceViewDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE descriptor (
+		m_srvHeap->GetCPUDescriptorHandleForHeapStart(),
+		int(m_firstDescriptor + 2 * id + texture.currentDescriptor), m_descriptorSize
+	);
+	m_device->CreateShaderResourceView (
+		texture.resource.Get(), &shaderResourceViewDesc, descriptor
+	);
+}
+
+//---------------------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE TextureStreamingBackend::srvHandle (
+	_In_ TextureStreamer::TextureId id
+) const {
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE (
+		m_srvHeap->GetGPUDescriptorHandleForHeapStart(),
+		int(m_firstDescriptor + 2 * id + m_textures[id].currentDescriptor), m_descriptorSize
+	);
+}
@@ -0,0 +1,123 @@
+//
+// TextureStreamingBackend.hpp
+//
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/TextureStreamer.hpp"
+#include "Common/UploadQueue.hpp"
+
+
+/**
+* Carries out the residency changes of a TextureStreamer on the GPU.
+*
+* Each change creates a new committed texture holding only the levels to be made
+* resident, and uploads them through an UploadQueue straight from the texture's
+* mapped DDS file, which must stay mapped while the texture is streamed.  Once the
+* copy queue has completed the upload, the new texture replaces the old one.
+*
+* Every texture has two SRV descriptors within a shader visible heap, which are
+* written in turn, so that replacing a texture never overwrites the descriptor used
+* by frames still in flight.  The replaced texture is released once those frames
+* complete.
+*/
+class TextureStreamingBackend : public TextureStreamer::Backend {
+public:
+	/// @param srvHeap - shader visible heap with two descriptors per texture from
+	/// 'firstDescriptor' on.
+	TextureStreamingBackend (
+		_In_ ID3D12Device * device,
+		_In_ UploadQueue * uploadQueue,
+		_In_ ID3D12DescriptorHeap * srvHeap,
+		_In_ uint firstDescriptor
+	);
+
+	/// Streams 'texture' as 'id', which must be the id returned for it by
+	/// TextureStreamer::addTexture().
+	void addTexture (
+		_In_ TextureStreamer::TextureId id,
+		_In_ const MappedDds & texture
+	);
+
+	/// Call before TextureStreamer::update(), once the direct queue has completed
+	/// 'completedFence' and frames up to 'lastSubmittedFence' have been submitted.
+	/// Releases textures replaced before frames that have since completed.
+	void beginFrame (
+		_In_ uint64 lastSubmittedFence,
+		_In_ uint64 completedFence
+	);
+
+	/// Call after TextureStreamer::update(), submits the uploads it began.
+	void endFrame();
+
+	/// Descriptor of the resident levels of 'id', once TextureStreamer::residentMip()
+	/// reports any.
+	D3D12_GPU_DESCRIPTOR_HANDLE srvHandle (
+		_In_ TextureStreamer::TextureId id
+	) const;
+
+	/// Upload the direct queue must wait on before sampling the textures, see
+	/// D3D12DemoBase::RequireUploadCompletion().
+	UploadQueue::Ticket requiredUploadTicket() const { return m_requiredUploadTicket; }
+
+	void beginChange (
+		TextureStreamer::TextureId id,
+		uint firstMip
+	) override;
+
+	bool isChangeComplete (
+		TextureStreamer::TextureId id
+	) override;
+
+	void endChange (
+		TextureStreamer::TextureId id
+	) override;
+
+private:
+	template <typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	struct Texture {
+		const MappedDds * source;
+
+		// Texture being sampled, and the one replacing it once its upload completes.
+		ComPtr<ID3D12Resource> resource;
+		ComPtr<ID3D12Resource> pendingResource;
+		uint pendingFirstMip;
+		UploadQueue::Ticket pendingTicket;
+
+		// Which of the texture's two descriptors refers to 'resource'.
+		uint currentDescriptor;
+
+		// Last frame fence of frames that may sample the other descriptor.
+		uint64 retireFence;
+	};
+
+	struct RetiredResource {
+		ComPtr<ID3D12Resource> resource;
+		uint64 retireFence;
+	};
+
+	ID3D12Device * m_device;
+	UploadQueue * m_uploadQueue;
+	ID3D12DescriptorHeap * m_srvHeap;
+	uint m_firstDescriptor;
+	uint m_descriptorSize;
+
+	std::vector<Texture> m_textures;
+
+	// Replaced textures, in the order they were replaced.
+	std::deque<RetiredResource> m_retiredResources;
+
+	uint64 m_lastSubmittedFence;
+	uint64 m_completedFence;
+	UploadQueue::Ticket m_requiredUploadTicket;
+
+	// Textures with uploads recorded since the last submit.
+	std::vector<TextureStreamer::TextureId> m_unsubmittedChanges;
+};
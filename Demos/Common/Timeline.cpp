@@ -0,0 +1,246 @@
+//
+// Timeline.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "Timeline.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+
+//---------------------------------------------------------------------------------------
+Timeline::Timeline (
+	std::unique_ptr<Fence> fence,
+	Scheduler * scheduler
+)
+	: m_fence(std::move(fence)),
+	  m_scheduler(scheduler),
+	  m_lastSignaledValue(NullValue),
+	  m_completedValue(NullValue)
+{
+	assert(m_fence && m_scheduler);
+}
+
+//---------------------------------------------------------------------------------------
+Timeline::Value Timeline::signal()
+{
+	++m_lastSignaledValue;
+	m_fence->signal(m_lastSignaledValue);
+	return m_lastSignaledValue;
+}
+
+//---------------------------------------------------------------------------------------
+Timeline::Value Timeline::refreshCompletedValue()
+{
+	++m_statistics.numQueries;
+	m_completedValue = std::max(m_completedValue, m_fence->queryCompletedValue());
+	return m_completedValue;
+}
+
+//---------------------------------------------------------------------------------------
+bool Timeline::isComplete (
+	Value value
+) {
+	assert(value <= m_lastSignaledValue);
+
+	if (value <= m_completedValue) {
+		++m_statistics.numCachedQueries;
+		return true;
+	}
+	return value <= refreshCompletedValue();
+}
+
+//---------------------------------------------------------------------------------------
+void Timeline::waitOnCpu (
+	Value value
+) {
+	if (isComplete(value)) {
+		return;
+	}
+
+	++m_statistics.numCpuWaits;
+	Fence * fence = m_fence.get();
+	do {
+		m_scheduler->waitForAny(&fence, &value, 1);
+	} while (refreshCompletedValue() < value);
+}
+
+//---------------------------------------------------------------------------------------
+void Timeline::waitOnGpu (
+	Timeline & consumer,
+	Value value
+) {
+	if (!isComplete(value)) {
+		consumer.m_fence->queueWait(m_fence.get(), value);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+uint Timeline::waitForAny (
+	Timeline * const * timelines,
+	const Value * values,
+	uint count
+) {
+	assert(count > 0);
+
+	// Answer from cached values before querying any fence.
+	for (uint i = 0; i < count; ++i) {
+		if (values[i] <= timelines[i]->m_completedValue) {
+			++timelines[i]->m_statistics.numCachedQueries;
+			return i;
+		}
+	}
+
+	Scheduler * scheduler = timelines[0]->m_scheduler;
+	std::vector<Fence *> fences(count);
+	for (uint i = 0; i < count; ++i) {
+		assert(timelines[i]->m_scheduler == scheduler);
+		fences[i] = timelines[i]->m_fence.get();
+	}
+
+	bool isWaiting = false;
+	for (;;) {
+		for (uint i = 0; i < count; ++i) {
+			if (values[i] <= timelines[i]->refreshCompletedValue()) {
+				return i;
+			}
+		}
+
+		if (!isWaiting) {
+			++timelines[0]->m_statistics.numCpuWaits;
+			isWaiting = true;
+		}
+		scheduler->waitForAny(fences.data(), values, count);
+	}
+}
+
+
+//---------------------------------------------------------------------------------------
+// Queue of a SimulatedGpu.  Its fence executes signals and waits in order.
+class Timeline::SimulatedGpu::Queue : public Timeline::Fence {
+public:
+	Queue (
+		SimulatedGpu * gpu,
+		uint stepsPerSignal
+	)
+		: m_gpu(gpu),
+		  m_stepsPerSignal(stepsPerSignal),
+		  m_completedValue(NullValue)
+	{
+
+	}
+
+	~Queue()
+	{
+		std::vector<Queue *> & queues = m_gpu->m_queues;
+		queues.erase(std::find(queues.begin(), queues.end(), this));
+	}
+
+	void signal (
+		Value value
+	) override {
+		m_operations.push_back({ nullptr, value, m_stepsPerSignal });
+	}
+
+	void queueWait (
+		Fence * fence,
+		Value value
+	) override {
+		m_operations.push_back({ static_cast<Queue *>(fence), value, 0 });
+	}
+
+	Value queryCompletedValue() override { return m_completedValue; }
+
+	/// Executes waits that are satisfied, then advances the signal that follows.
+	/// @return false if the queue is blocked or idle.
+	bool step()
+	{
+		while (!m_operations.empty()) {
+			Operation & operation = m_operations.front();
+			if (operation.waitQueue) {
+				if (operation.waitQueue->m_completedValue < operation.value) {
+					return false;
+				}
+				m_operations.pop_front();
+				continue;
+			}
+
+			if (operation.remainingSteps > 0) {
+				--operation.remainingSteps;
+			}
+			if (operation.remainingSteps == 0) {
+				m_completedValue = operation.value;
+				m_operations.pop_front();
+			}
+			return true;
+		}
+		return false;
+	}
+
+private:
+	struct Operation {
+		// Queue waited on, or nullptr for a signal.
+		Queue * waitQueue;
+		Value value;
+		uint remainingSteps;
+	};
+
+	SimulatedGpu * m_gpu;
+	uint m_stepsPerSignal;
+	Value m_completedValue;
+	std::deque<Operation> m_operations;
+};
+
+//---------------------------------------------------------------------------------------
+Timeline::SimulatedGpu::SimulatedGpu()
+	: m_numSteps(0)
+{
+
+}
+
+//---------------------------------------------------------------------------------------
+Timeline::SimulatedGpu::~SimulatedGpu()
+{
+	assert(m_queues.empty());
+}
+
+//---------------------------------------------------------------------------------------
+std::unique_ptr<Timeline::Fence> Timeline::SimulatedGpu::createQueue (
+	uint stepsPerSignal
+) {
+	std::unique_ptr<Queue> queue(new Queue(this, stepsPerSignal));
+	m_queues.push_back(queue.get());
+	return queue;
+}
+
+//---------------------------------------------------------------------------------------
+bool Timeline::SimulatedGpu::step()
+{
+	++m_numSteps;
+	bool hasProgressed = false;
+	for (Queue * queue : m_queues) {
+		hasProgressed |= queue->step();
+	}
+	return hasProgressed;
+}
+
+//---------------------------------------------------------------------------------------
+void Timeline::SimulatedGpu::waitForAny (
+	Fence * const * fences,
+	const Value * values,
+	uint count
+) {
+	for (;;) {
+		for (uint i = 0; i < count; ++i) {
+			if (fences[i]->queryCompletedValue() >= values[i]) {
+				return;
+			}
+		}
+
+		if (!step()) {
+			throw std::runtime_error("Simulated wait can never complete");
+		}
+	}
+}
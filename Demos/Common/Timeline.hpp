@@ -0,0 +1,181 @@
+//
+// Timeline.hpp
+//
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Monotonically increasing fence values signaled by a single GPU queue, used to
+* track when work submitted to the queue completes.
+*
+* Work is submitted, then signal() returns the value that completes with it.  The
+* largest value known to have completed is cached, so that isComplete() only
+* queries the fence when the cached value is insufficient, and CPU waits only
+* block when the value has not yet been reached.  Timelines of different queues
+* share a Scheduler, which lets the CPU block until any of several values
+* completes, and lets one queue wait on another's timeline on the GPU.
+*
+* Fences and their Scheduler are implemented with ID3D12Fence (see
+* D3D12Timeline.hpp), or by a SimulatedGpu that completes signals on the CPU,
+* which allows scheduling logic to run without a GPU.
+*
+* Has no Windows dependencies.  Not thread-safe.
+*/
+class Timeline {
+public:
+	typedef uint64 Value;
+
+	/// Value that is always complete.
+	static const Value NullValue = 0;
+
+	/// GPU fence signaled by a single queue.
+	class Fence {
+	public:
+		virtual ~Fence() {}
+
+		/// Has the queue set the fence to 'value' once prior work completes.
+		virtual void signal (
+			Value value
+		) = 0;
+
+		/// Has the queue wait for 'fence' to reach 'value' before any later work.
+		virtual void queueWait (
+			Fence * fence,
+			Value value
+		) = 0;
+
+		/// Queries the value the fence has currently reached.
+		virtual Value queryCompletedValue() = 0;
+	};
+
+	/// Blocks the CPU on fences.
+	class Scheduler {
+	public:
+		virtual ~Scheduler() {}
+
+		/// Blocks until at least one of 'fences' reaches the respective value in
+		/// 'values'.  May return early, callers recheck their fences.
+		virtual void waitForAny (
+			Fence * const * fences,
+			const Value * values,
+			uint count
+		) = 0;
+	};
+
+	/// Simulates GPU queues on the CPU.  Each queue executes its signals and waits
+	/// in submission order, completing one signal every 'stepsPerSignal' steps.
+	/// Waiting on the CPU steps the simulation until a wait is satisfied.
+	class SimulatedGpu : public Scheduler {
+	public:
+		SimulatedGpu();
+
+		~SimulatedGpu();
+
+		/// Creates the fence of a new queue, which must be destroyed before the
+		/// SimulatedGpu.
+		std::unique_ptr<Fence> createQueue (
+			uint stepsPerSignal
+		);
+
+		/// Advances every queue by one step.
+		/// @return false if every queue is idle or blocked.
+		bool step();
+
+		/// Steps taken so far.
+		uint64 numSteps() const { return m_numSteps; }
+
+		/// Steps until one of 'fences' reaches its value.
+		/// @throws std::runtime_error if no queue can make progress towards any.
+		void waitForAny (
+			Fence * const * fences,
+			const Value * values,
+			uint count
+		) override;
+
+	private:
+		class Queue;
+
+		std::vector<Queue *> m_queues;
+		uint64 m_numSteps;
+	};
+
+	struct Statistics {
+		/// Calls to Fence::queryCompletedValue().
+		uint64 numQueries = 0;
+
+		/// Calls to isComplete() answered from the cached completed value.
+		uint64 numCachedQueries = 0;
+
+		/// Waits that blocked the CPU.
+		uint64 numCpuWaits = 0;
+	};
+
+	Timeline (
+		std::unique_ptr<Fence> fence,
+		Scheduler * scheduler
+	);
+
+	/// Signals the next value on the queue, which completes with all work submitted
+	/// so far, and returns it.
+	Value signal();
+
+	/// Last value returned by signal(), NullValue before the first.
+	Value lastSignaledValue() const { return m_lastSignaledValue; }
+
+	/// Value the next signal() will return, which completes with all work submitted
+	/// so far.
+	Value nextSignaledValue() const { return m_lastSignaledValue + 1; }
+
+	/// Largest value known to have completed, without querying the fence.
+	Value completedValue() const { return m_completedValue; }
+
+	/// True once 'value' has completed.  Only queries the fence when the cached
+	/// completed value is smaller than 'value'.
+	bool isComplete (
+		Value value
+	);
+
+	/// Queries the fence, updating the cached completed value.
+	Value refreshCompletedValue();
+
+	/// Blocks the calling thread until 'value' completes.
+	void waitOnCpu (
+		Value value
+	);
+
+	/// Has the queue of 'consumer' wait for 'value' of this timeline on the GPU,
+	/// without blocking the CPU.  Skipped if 'value' has already completed.
+	void waitOnGpu (
+		Timeline & consumer,
+		Value value
+	);
+
+	/// Blocks until any of 'timelines' reaches the respective value in 'values',
+	/// which must share a Scheduler, and returns the index of the first complete.
+	static uint waitForAny (
+		Timeline * const * timelines,
+		const Value * values,
+		uint count
+	);
+
+	Fence * getFence() const { return m_fence.get(); }
+
+	const Statistics & statistics() const { return m_statistics; }
+
+private:
+	std::unique_ptr<Fence> m_fence;
+	Scheduler * m_scheduler;
+
+	Value m_lastSignaledValue;
+
+	// Cached value of m_fence->queryCompletedValue().
+	Value m_completedValue;
+
+	Statistics m_statistics;
+};
@@ -0,0 +1,134 @@
+//
+// TimelinePool.hpp
+//
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/Timeline.hpp"
+
+
+/**
+* Holds released items of several kinds until the GPU is done with them, then hands
+* them out again.
+*
+* Each item is released along with the Timeline value its last use retires on.
+* tryAcquire() returns the oldest item of the requested kind released on any timeline
+* whose value has completed, without blocking.  Items released on one timeline
+* retire in release order, so only the oldest of each timeline is checked, and
+* completed values are cached by the Timeline.  When none has retired, tryAcquire()
+* fails and the caller creates a new item.
+*
+* This is the bookkeeping of CommandListPool, kept free of D3D12 so it can be tested
+* with Timeline::SimulatedGpu.
+*
+* Timelines given to release() must outlive any later call to tryAcquire().
+* Has no Windows dependencies.  Not thread-safe.
+*/
+template <typename T>
+class TimelinePool {
+public:
+	struct Statistics {
+		/// Calls to tryAcquire() that returned a released item.
+		uint64 numHits = 0;
+
+		/// Calls to tryAcquire() that found none retired.
+		uint64 numMisses = 0;
+	};
+
+	explicit TimelinePool (
+		uint numKinds
+	)
+		: m_kinds(numKinds)
+	{
+	}
+
+	/// Moves the oldest retired item of 'kind' into 'item'.
+	/// @return false if no item of 'kind' has retired.
+	bool tryAcquire (
+		uint kind,
+		T & item
+	) {
+		assert(kind < m_kinds.size());
+
+		for (TimelineItems & timelineItems : m_kinds[kind]) {
+			std::deque<ReleasedItem> & releasedItems = timelineItems.releasedItems;
+			if (releasedItems.empty() ||
+				!timelineItems.timeline->isComplete(releasedItems.front().retireValue)) {
+				continue;
+			}
+
+			item = std::move(releasedItems.front().item);
+			releasedItems.pop_front();
+			++m_statistics.numHits;
+			return true;
+		}
+
+		++m_statistics.numMisses;
+		return false;
+	}
+
+	/// Returns 'item' to the pool once 'timeline' reaches 'retireValue'.  Values
+	/// released on a timeline must not decrease.
+	void release (
+		uint kind,
+		T && item,
+		Timeline & timeline,
+		Timeline::Value retireValue
+	) {
+		assert(kind < m_kinds.size());
+
+		std::vector<TimelineItems> & timelineItems = m_kinds[kind];
+		auto it = std::find_if (timelineItems.begin(), timelineItems.end(),
+			[&timeline](const TimelineItems & items) { return items.timeline == &timeline; }
+		);
+		if (it == timelineItems.end()) {
+			timelineItems.push_back(TimelineItems());
+			it = timelineItems.end() - 1;
+			it->timeline = &timeline;
+		}
+		assert(it->releasedItems.empty() || it->releasedItems.back().retireValue <= retireValue);
+
+		ReleasedItem releasedItem;
+		releasedItem.item = std::move(item);
+		releasedItem.retireValue = retireValue;
+		it->releasedItems.push_back(std::move(releasedItem));
+	}
+
+	/// Items of 'kind' released and not yet acquired again, retired or not.
+	size_t numReleased (
+		uint kind
+	) const {
+		assert(kind < m_kinds.size());
+
+		size_t count = 0;
+		for (const TimelineItems & timelineItems : m_kinds[kind]) {
+			count += timelineItems.releasedItems.size();
+		}
+		return count;
+	}
+
+	const Statistics & statistics() const { return m_statistics; }
+
+private:
+	struct ReleasedItem {
+		T item;
+		Timeline::Value retireValue;
+	};
+
+	// Items released on a single timeline, which retire in release order.
+	struct TimelineItems {
+		Timeline * timeline;
+		std::deque<ReleasedItem> releasedItems;
+	};
+
+	// Released items of each kind, grouped by timeline.
+	std::vector<std::vector<TimelineItems>> m_kinds;
+
+	Statistics m_statistics;
+};
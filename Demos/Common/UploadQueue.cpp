@@ -0,0 +1,144 @@
+//
+// UploadQueue.cpp
+//
+#include "pch.h"
+
+#include "UploadQueue.hpp"
+
+#include "Common/D3D12DemoBase.hpp"
+#include "Common/D3D12Timeline.hpp"
+
+
+//---------------------------------------------------------------------------------------
+UploadQueue::UploadQueue (
+	ID3D12Device * device,
+	CommandListPool * commandListPool,
+	Timeline::Scheduler * scheduler,
+	MemoryBudget * memoryBudget
+)
+	: m_device(device),
+	  m_commandListPool(commandListPool),
+	  m_memoryBudget(memoryBudget),
+	  m_batchHasCommands(false)
+{
+	assert(device && commandListPool);
+
+	// Describe and create the copy command queue.
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	CHECK_D3D_RESULT (
+		m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_copyCmdQueue))
+	);
+	SET_D3D12_DEBUG_NAME(m_copyCmdQueue);
+
+	m_timeline.reset (
+		new Timeline(std::make_unique<D3D12Fence>(m_device, m_copyCmdQueue.Get()), scheduler)
+	);
+}
+
+//---------------------------------------------------------------------------------------
+UploadQueue::~UploadQueue()
+{
+	// Resources referenced by in-flight batches must outlive the copies.
+	waitForIdle();
+
+	if (m_batchHasCommands) {
+		m_copyCmdList.cmdList->Close();
+	}
+}
+
+//---------------------------------------------------------------------------------------
+ID3D12GraphicsCommandList * UploadQueue::getCommandList()
+{
+	// Assume caller is about to record copies.
+	if (!m_batchHasCommands) {
+		m_copyCmdList = m_commandListPool->acquire(D3D12_COMMAND_LIST_TYPE_COPY);
+		m_batchHasCommands = true;
+	}
+	return m_copyCmdList.cmdList.Get();
+}
+
+//---------------------------------------------------------------------------------------
+void UploadQueue::keepAlive (
+	ID3D12Resource * resource
+) {
+	m_currentBatch.keepAliveResources.push_back(resource);
+
+	if (m_memoryBudget) {
+		const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+		const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo =
+			m_device->GetResourceAllocationInfo(0, 1, &desc);
+
+		// Upload heaps are in system memory, except on adapters with unified memory.
+		m_currentBatch.allocations.push_back (
+			m_memoryBudget->trackAllocation (
+				MemoryBudget::Segment::NonLocal, allocationInfo.SizeInBytes, 0.0f
+			)
+		);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+UploadQueue::Ticket UploadQueue::submit()
+{
+	if (!m_batchHasCommands) {
+		return m_timeline->lastSignaledValue();
+	}
+
+	CHECK_D3D_RESULT (
+		m_copyCmdList.cmdList->Close()
+	);
+	ID3D12CommandList * commandLists[] = { m_copyCmdList.cmdList.Get() };
+	m_copyCmdQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+	const Ticket ticket = m_timeline->signal();
+	m_commandListPool->release(std::move(m_copyCmdList), *m_timeline, ticket);
+	m_batchHasCommands = false;
+
+	m_currentBatch.ticket = ticket;
+	m_pendingBatches.push_back(std::move(m_currentBatch));
+	m_currentBatch = Batch();
+
+	return ticket;
+}
+
+//---------------------------------------------------------------------------------------
+bool UploadQueue::isComplete (
+	Ticket ticket
+) {
+	return m_timeline->isComplete(ticket);
+}
+
+//---------------------------------------------------------------------------------------
+void UploadQueue::waitOnGpu (
+	Timeline & consumer,
+	Ticket ticket
+) {
+	m_timeline->waitOnGpu(consumer, ticket);
+}
+
+//---------------------------------------------------------------------------------------
+void UploadQueue::waitOnCpu (
+	Ticket ticket
+) {
+	m_timeline->waitOnCpu(ticket);
+	retireCompletedBatches();
+}
+
+//---------------------------------------------------------------------------------------
+void UploadQueue::waitForIdle()
+{
+	waitOnCpu(m_timeline->lastSignaledValue());
+}
+
+//---------------------------------------------------------------------------------------
+void UploadQueue::retireCompletedBatches()
+{
+	while (!m_pendingBatches.empty() && isComplete(m_pendingBatches.front().ticket)) {
+		for (MemoryBudget::AllocationId allocation : m_pendingBatches.front().allocations) {
+			m_memoryBudget->releaseAllocation(allocation);
+		}
+		m_pendingBatches.pop_front();
+	}
+}
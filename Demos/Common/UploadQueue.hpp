@@ -0,0 +1,125 @@
+//
+// UploadQueue.hpp
+//
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/CommandListPool.hpp"
+#include "Common/MemoryBudget.hpp"
+#include "Common/Timeline.hpp"
+
+/**
+* Batches resource upload copies onto a dedicated COPY command queue with its own
+* Timeline, so that asset uploads can run alongside rendering on the direct queue.
+*
+* Copies are recorded into getCommandList() and submitted as a batch by submit(),
+* which returns a Ticket.  Rather than blocking the CPU, a consuming queue is made to
+* wait on the ticket through waitOnGpu(), typically right before the first frame that
+* uses the uploaded resources.
+*
+* Destination resources should be created in D3D12_RESOURCE_STATE_COMMON.  They are
+* implicitly promoted to COPY_DEST on the copy queue, decay back to COMMON once the
+* batch completes, and are then implicitly promoted on first use by the direct queue,
+* so no resource barriers are required.
+*
+* Command lists are taken from a CommandListPool when the first copy of a batch is
+* recorded, and returned to it once submitted.
+*
+* Given a MemoryBudget, resources kept alive for a batch, typically upload buffers,
+* are tracked as non-local allocations until the batch completes.
+*/
+class UploadQueue {
+public:
+	/// Value of the copy queue's timeline signaled once a batch completes.
+	typedef Timeline::Value Ticket;
+
+	/// Ticket that is always complete.
+	static const Ticket NullTicket = Timeline::NullValue;
+
+	/// @param commandListPool - provides the command list of each batch.
+	/// @param scheduler - shared with the timelines of the queues that wait on
+	/// uploads.
+	/// @param memoryBudget - tracks kept-alive resources, may be nullptr.
+	UploadQueue (
+		ID3D12Device * device,
+		CommandListPool * commandListPool,
+		Timeline::Scheduler * scheduler,
+		MemoryBudget * memoryBudget = nullptr
+	);
+
+	~UploadQueue();
+
+	/// Command list recording the current batch.  Valid until the next submit().
+	ID3D12GraphicsCommandList * getCommandList();
+
+	/// Holds a reference to 'resource' (e.g. an intermediate upload buffer) until the
+	/// current batch has completed on the GPU.
+	void keepAlive (
+		ID3D12Resource * resource
+	);
+
+	/// Closes and executes the current batch, returning the ticket that will be
+	/// signaled on its completion.  Returns the previous ticket if batch is empty.
+	Ticket submit();
+
+	/// True once the GPU has completed the batch associated with 'ticket'.
+	bool isComplete (
+		Ticket ticket
+	);
+
+	/// Inserts a GPU-side wait for 'ticket' on the queue of 'consumer', without
+	/// blocking the CPU.  Skipped if the ticket has already completed.
+	void waitOnGpu (
+		Timeline & consumer,
+		Ticket ticket
+	);
+
+	/// Blocks the calling thread until 'ticket' completes.
+	void waitOnCpu (
+		Ticket ticket
+	);
+
+	/// Blocks the calling thread until every submitted batch completes.
+	void waitForIdle();
+
+	/// Releases kept-alive resources of all batches that have completed.
+	void retireCompletedBatches();
+
+	ID3D12CommandQueue * getCommandQueue() const { return m_copyCmdQueue.Get(); }
+
+	Timeline & getTimeline() const { return *m_timeline; }
+
+private:
+	template <typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	struct Batch {
+		Ticket ticket;
+		std::vector<ComPtr<ID3D12Resource>> keepAliveResources;
+		std::vector<MemoryBudget::AllocationId> allocations;
+	};
+
+	ID3D12Device * m_device;
+	CommandListPool * m_commandListPool;
+	MemoryBudget * m_memoryBudget;
+
+	ComPtr<ID3D12CommandQueue> m_copyCmdQueue;
+
+	// Signaled by the copy queue after each batch.
+	std::unique_ptr<Timeline> m_timeline;
+
+	// Batch currently being recorded, into m_copyCmdList once it has commands.
+	Batch m_currentBatch;
+	CommandListPool::CommandList m_copyCmdList;
+	bool m_batchHasCommands;
+
+	// Submitted batches in ticket order.
+	std::deque<Batch> m_pendingBatches;
+};
@@ -0,0 +1,392 @@
+//
+// VertexQuantization.cpp
+//
+// Portable, compiled without the precompiled header.
+//
+#include "VertexQuantization.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define VERTEX_QUANTIZATION_SSE2
+	#include <emmintrin.h>
+#endif
+
+using namespace VertexQuantization;
+
+
+namespace {
+
+	const float UnormScale = 65535.0f;
+	const float SnormScale = 32767.0f;
+
+	// Bit patterns used by the float to half conversions.
+	const uint32 HalfOverflowBits = (127 + 16) << 23;        // 65536.0f
+	const uint32 HalfMinNormalBits = (127 - 14) << 23;       // Smallest normal half.
+	const uint32 HalfSubnormalMagicBits = (127 - 1) << 23;   // 0.5f
+	const uint32 HalfNormalBias = 0xfff - ((127 - 15) << 23);
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint32 floatBits (
+	float value
+) {
+	uint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+//---------------------------------------------------------------------------------------
+static inline float bitsToFloat (
+	uint32 bits
+) {
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+//---------------------------------------------------------------------------------------
+static inline float clamp (
+	float value,
+	float low,
+	float high
+) {
+	return value < low ? low : (value > high ? high : value);
+}
+
+//---------------------------------------------------------------------------------------
+static inline float signNotZero (
+	float value
+) {
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+//---------------------------------------------------------------------------------------
+// Rounds half to even, matching _mm_cvtps_epi32 under the default rounding mode.
+static inline int32 roundToInt (
+	float value
+) {
+	return int32(lrintf(value));
+}
+
+//---------------------------------------------------------------------------------------
+// Conversion rounds to nearest even.  Values too large for a half become infinity, and
+// NaNs stay NaNs.
+uint16 VertexQuantization::floatToHalf (
+	float value
+) {
+	const uint32 bits = floatBits(value);
+	const uint32 sign = (bits >> 16) & 0x8000;
+	const uint32 absBits = bits & 0x7fffffff;
+
+	uint32 result;
+	if (absBits >= HalfOverflowBits) {
+		result = (absBits > 0x7f800000) ? 0x7e00 : 0x7c00;
+	} else if (absBits < HalfMinNormalBits) {
+		// Adding 0.5 shifts the mantissa into place, letting the FPU do the rounding.
+		const float shifted = bitsToFloat(absBits) + bitsToFloat(HalfSubnormalMagicBits);
+		result = floatBits(shifted) - HalfSubnormalMagicBits;
+	} else {
+		const uint32 mantissaOdd = (absBits >> 13) & 1;
+		result = (absBits + HalfNormalBias + mantissaOdd) >> 13;
+	}
+
+	return uint16(result | sign);
+}
+
+//---------------------------------------------------------------------------------------
+float VertexQuantization::halfToFloat (
+	uint16 value
+) {
+	const uint32 sign = uint32(value & 0x8000) << 16;
+	const uint32 exponent = (value >> 10) & 0x1f;
+	const uint32 mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		const float magnitude = float(mantissa) * (1.0f / 16777216.0f);
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 31) {
+		return bitsToFloat(sign | 0x7f800000 | (mantissa << 13));
+	}
+	return bitsToFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+//---------------------------------------------------------------------------------------
+PositionTransform VertexQuantization::computePositionTransform (
+	const float boundsMin[3],
+	const float boundsMax[3]
+) {
+	PositionTransform transform;
+	for (int i = 0; i < 3; ++i) {
+		transform.offset[i] = boundsMin[i];
+		transform.scale[i] = boundsMax[i] - boundsMin[i];
+	}
+	return transform;
+}
+
+//---------------------------------------------------------------------------------------
+PositionTransform VertexQuantization::computePositionTransform (
+	const Mesh::Vertex * vertices,
+	size_t numVertices
+) {
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+	if (numVertices > 0) {
+		for (int i = 0; i < 3; ++i) {
+			boundsMin[i] = FLT_MAX;
+			boundsMax[i] = -FLT_MAX;
+		}
+	}
+	for (size_t v = 0; v < numVertices; ++v) {
+		for (int i = 0; i < 3; ++i) {
+			const float p = vertices[v].position[i];
+			boundsMin[i] = p < boundsMin[i] ? p : boundsMin[i];
+			boundsMax[i] = p > boundsMax[i] ? p : boundsMax[i];
+		}
+	}
+
+	return computePositionTransform(boundsMin, boundsMax);
+}
+
+//---------------------------------------------------------------------------------------
+static void encodeVertex (
+	const Mesh::Vertex & vertex,
+	const float invScale[3],
+	const PositionTransform & transform,
+	PackedVertex & packedVertex
+) {
+	for (int i = 0; i < 3; ++i) {
+		const float unorm = (vertex.position[i] - transform.offset[i]) * invScale[i];
+		packedVertex.position[i] = uint16(roundToInt(clamp(unorm, 0.0f, 1.0f) * UnormScale));
+	}
+	packedVertex.position[3] = 0xffff;
+
+	// Project onto the octahedron |x| + |y| + |z| = 1, folding the lower half outwards.
+	const float * n = vertex.normal;
+	const float absSum = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+	const float invAbsSum = 1.0f / (absSum > FLT_MIN ? absSum : FLT_MIN);
+	float x = n[0] * invAbsSum;
+	float y = n[1] * invAbsSum;
+	if (n[2] < 0.0f) {
+		const float foldedX = (1.0f - fabsf(y)) * signNotZero(x);
+		const float foldedY = (1.0f - fabsf(x)) * signNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+	packedVertex.normal[0] = int16(roundToInt(clamp(x, -1.0f, 1.0f) * SnormScale));
+	packedVertex.normal[1] = int16(roundToInt(clamp(y, -1.0f, 1.0f) * SnormScale));
+
+	packedVertex.texCoord[0] = floatToHalf(vertex.texCoord[0]);
+	packedVertex.texCoord[1] = floatToHalf(vertex.texCoord[1]);
+}
+
+#ifdef VERTEX_QUANTIZATION_SSE2
+//---------------------------------------------------------------------------------------
+// Four wide version of floatToHalf(), results are in the low 16 bits of each lane.
+static inline __m128i floatToHalf4 (
+	__m128 value
+) {
+	const __m128i bits = _mm_castps_si128(value);
+	const __m128i absBits = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+	const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+
+	// Infinity or NaN, for values too large to represent.
+	const __m128i isNaN = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(0x7f800000));
+	const __m128i special = _mm_or_si128 (
+		_mm_set1_epi32(0x7c00), _mm_and_si128(isNaN, _mm_set1_epi32(0x0200))
+	);
+
+	// Subnormal halves.
+	const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(HalfSubnormalMagicBits));
+	const __m128i subnormal = _mm_sub_epi32 (
+		_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(absBits), magic)),
+		_mm_set1_epi32(HalfSubnormalMagicBits)
+	);
+
+	// Normal halves, rounding to nearest even.
+	const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+	const __m128i normal = _mm_srli_epi32 (
+		_mm_add_epi32(_mm_add_epi32(absBits, _mm_set1_epi32(int(HalfNormalBias))), mantissaOdd),
+		13
+	);
+
+	const __m128i isSubnormal = _mm_cmplt_epi32(absBits, _mm_set1_epi32(HalfMinNormalBits));
+	const __m128i isRegular = _mm_cmplt_epi32(absBits, _mm_set1_epi32(HalfOverflowBits));
+
+	__m128i result = _mm_or_si128 (
+		_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal)
+	);
+	result = _mm_or_si128 (
+		_mm_and_si128(isRegular, result), _mm_andnot_si128(isRegular, special)
+	);
+	return _mm_or_si128(result, sign);
+}
+
+//---------------------------------------------------------------------------------------
+static inline __m128 select (
+	__m128 mask,
+	__m128 a,
+	__m128 b
+) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//---------------------------------------------------------------------------------------
+// Encodes 4 vertices at a time, transposing them so each SIMD lane holds one vertex.
+static void encodeVertices4 (
+	const Mesh::Vertex * vertices,
+	const __m128 offset[3],
+	const __m128 invScale[3],
+	PackedVertex * packedVertices
+) {
+	static_assert(sizeof(Mesh::Vertex) == 8 * sizeof(float), "Unexpected Mesh::Vertex layout.");
+	static_assert(sizeof(PackedVertex) == 16, "Unexpected PackedVertex layout.");
+
+	const float * v0 = vertices[0].position;
+	const float * v1 = vertices[1].position;
+	const float * v2 = vertices[2].position;
+	const float * v3 = vertices[3].position;
+
+	// px, py, pz, nx
+	__m128 a0 = _mm_loadu_ps(v0);
+	__m128 a1 = _mm_loadu_ps(v1);
+	__m128 a2 = _mm_loadu_ps(v2);
+	__m128 a3 = _mm_loadu_ps(v3);
+	_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+
+	// ny, nz, u, v
+	__m128 b0 = _mm_loadu_ps(v0 + 4);
+	__m128 b1 = _mm_loadu_ps(v1 + 4);
+	__m128 b2 = _mm_loadu_ps(v2 + 4);
+	__m128 b3 = _mm_loadu_ps(v3 + 4);
+	_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	// Positions
+	__m128i position[3];
+	const __m128 positionIn[3] = { a0, a1, a2 };
+	for (int i = 0; i < 3; ++i) {
+		__m128 unorm = _mm_mul_ps(_mm_sub_ps(positionIn[i], offset[i]), invScale[i]);
+		unorm = _mm_min_ps(_mm_max_ps(unorm, zero), one);
+		position[i] = _mm_cvtps_epi32(_mm_mul_ps(unorm, _mm_set1_ps(UnormScale)));
+	}
+
+	// Octahedral normals
+	const __m128 nx = a3;
+	const __m128 ny = b0;
+	const __m128 nz = b1;
+	const __m128 absX = _mm_andnot_ps(signMask, nx);
+	const __m128 absY = _mm_andnot_ps(signMask, ny);
+	const __m128 absZ = _mm_andnot_ps(signMask, nz);
+	const __m128 absSum = _mm_max_ps(_mm_add_ps(_mm_add_ps(absX, absY), absZ), _mm_set1_ps(FLT_MIN));
+	const __m128 invAbsSum = _mm_div_ps(one, absSum);
+
+	__m128 x = _mm_mul_ps(nx, invAbsSum);
+	__m128 y = _mm_mul_ps(ny, invAbsSum);
+
+	const __m128 signX = select(_mm_cmpge_ps(x, zero), one, minusOne);
+	const __m128 signY = select(_mm_cmpge_ps(y, zero), one, minusOne);
+	const __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, y)), signX);
+	const __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), signY);
+	const __m128 isLowerHalf = _mm_cmplt_ps(nz, zero);
+	x = select(isLowerHalf, foldedX, x);
+	y = select(isLowerHalf, foldedY, y);
+
+	x = _mm_min_ps(_mm_max_ps(x, minusOne), one);
+	y = _mm_min_ps(_mm_max_ps(y, minusOne), one);
+	const __m128i normalX = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(SnormScale)));
+	const __m128i normalY = _mm_cvtps_epi32(_mm_mul_ps(y, _mm_set1_ps(SnormScale)));
+
+	// Texture coordinates
+	const __m128i texCoordU = floatToHalf4(b2);
+	const __m128i texCoordV = floatToHalf4(b3);
+
+	// Pair 16-bit values into dwords, then transpose back to one vertex per register.
+	const __m128i lowMask = _mm_set1_epi32(0xffff);
+	__m128 d0 = _mm_castsi128_ps(_mm_or_si128(position[0], _mm_slli_epi32(position[1], 16)));
+	__m128 d1 = _mm_castsi128_ps(_mm_or_si128(position[2], _mm_set1_epi32(int(0xffff0000))));
+	__m128 d2 = _mm_castsi128_ps(_mm_or_si128 (
+		_mm_and_si128(normalX, lowMask), _mm_slli_epi32(normalY, 16)
+	));
+	__m128 d3 = _mm_castsi128_ps(_mm_or_si128(texCoordU, _mm_slli_epi32(texCoordV, 16)));
+	_MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+
+	_mm_storeu_ps(reinterpret_cast<float *>(packedVertices + 0), d0);
+	_mm_storeu_ps(reinterpret_cast<float *>(packedVertices + 1), d1);
+	_mm_storeu_ps(reinterpret_cast<float *>(packedVertices + 2), d2);
+	_mm_storeu_ps(reinterpret_cast<float *>(packedVertices + 3), d3);
+}
+#endif // VERTEX_QUANTIZATION_SSE2
+
+//---------------------------------------------------------------------------------------
+void VertexQuantization::encodeVertices (
+	const Mesh::Vertex * vertices,
+	size_t numVertices,
+	const PositionTransform & transform,
+	PackedVertex * packedVertices
+) {
+	float invScale[3];
+	for (int i = 0; i < 3; ++i) {
+		invScale[i] = (transform.scale[i] > 0.0f) ? 1.0f / transform.scale[i] : 0.0f;
+	}
+
+	size_t v = 0;
+
+#ifdef VERTEX_QUANTIZATION_SSE2
+	const __m128 offset4[3] = {
+		_mm_set1_ps(transform.offset[0]),
+		_mm_set1_ps(transform.offset[1]),
+		_mm_set1_ps(transform.offset[2])
+	};
+	const __m128 invScale4[3] = {
+		_mm_set1_ps(invScale[0]),
+		_mm_set1_ps(invScale[1]),
+		_mm_set1_ps(invScale[2])
+	};
+	for (; v + 4 <= numVertices; v += 4) {
+		encodeVertices4(vertices + v, offset4, invScale4, packedVertices + v);
+	}
+#endif
+
+	for (; v < numVertices; ++v) {
+		encodeVertex(vertices[v], invScale, transform, packedVertices[v]);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+Mesh::Vertex VertexQuantization::decodeVertex (
+	const PackedVertex & packedVertex,
+	const PositionTransform & transform
+) {
+	Mesh::Vertex vertex;
+
+	for (int i = 0; i < 3; ++i) {
+		vertex.position[i] = transform.offset[i] +
+			(float(packedVertex.position[i]) / UnormScale) * transform.scale[i];
+	}
+
+	// SNORM decoding maps -32768 to -1 as well.
+	float x = fmaxf(float(packedVertex.normal[0]) / SnormScale, -1.0f);
+	float y = fmaxf(float(packedVertex.normal[1]) / SnormScale, -1.0f);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	const float fold = fmaxf(-z, 0.0f);
+	x += (x >= 0.0f) ? -fold : fold;
+	y += (y >= 0.0f) ? -fold : fold;
+	const float invLength = 1.0f / sqrtf(x * x + y * y + z * z);
+	vertex.normal[0] = x * invLength;
+	vertex.normal[1] = y * invLength;
+	vertex.normal[2] = z * invLength;
+
+	vertex.texCoord[0] = halfToFloat(packedVertex.texCoord[0]);
+	vertex.texCoord[1] = halfToFloat(packedVertex.texCoord[1]);
+
+	return vertex;
+}
@@ -0,0 +1,71 @@
+//
+// VertexQuantization.hpp
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Common/BasicTypes.hpp"
+#include "Common/Mesh.hpp"
+
+
+/**
+* Compact 16 byte alternative to the 32 byte Mesh::Vertex.
+*
+* - Positions are quantized to 16-bit UNORM relative to the mesh bounds, read as
+*   DXGI_FORMAT_R16G16B16A16_UNORM and decoded as offset + position * scale.  The 4th
+*   component is always 1.
+* - Normals are octahedral encoded into two 16-bit SNORM values, read as
+*   DXGI_FORMAT_R16G16_SNORM.
+* - Texture coordinates are stored as half floats, read as DXGI_FORMAT_R16G16_FLOAT.
+*
+* Encoding uses SSE2 when available.  Has no Windows dependencies.
+*/
+namespace VertexQuantization {
+
+	struct PackedVertex {
+		uint16 position[4];
+		int16 normal[2];
+		uint16 texCoord[2];
+	};
+
+	/// Maps UNORM positions back to object space: position = offset + unorm * scale.
+	struct PositionTransform {
+		float offset[3];
+		float scale[3];
+	};
+
+	/// Computes the transform quantizing positions within [boundsMin, boundsMax].
+	PositionTransform computePositionTransform (
+		const float boundsMin[3],
+		const float boundsMax[3]
+	);
+
+	/// Computes the transform quantizing the positions of 'vertices'.
+	PositionTransform computePositionTransform (
+		const Mesh::Vertex * vertices,
+		size_t numVertices
+	);
+
+	/// Packs 'numVertices' vertices into 'packedVertices'.  Normals should be unit length.
+	void encodeVertices (
+		const Mesh::Vertex * vertices,
+		size_t numVertices,
+		const PositionTransform & transform,
+		PackedVertex * packedVertices
+	);
+
+	/// Reference decoder matching the vertex shader, used to measure encoding error.
+	Mesh::Vertex decodeVertex (
+		const PackedVertex & packedVertex,
+		const PositionTransform & transform
+	);
+
+	uint16 floatToHalf (
+		float value
+	);
+
+	float halfToFloat (
+		uint16 value
+	);
+};
@@ -2,7 +2,9 @@
 
 #include <cassert>
 #include <chrono>
+#include <cstring>
 #include <cwchar>
+#include <string>
 
 #include "Win32Application.hpp"
 #include "D3D12DemoBase.hpp"
@@ -14,6 +16,31 @@
 HWND Win32Application::m_hwnd = nullptr;
 
 
+// Applies command line options to the demo:
+//   -lowlatency | -throughput   Latency mode, see LatencyMode.
+//   -frames <count>             Number of frames in flight, defaults to the mode's.
+static void ParseCommandLine (
+	D3D12DemoBase * demo
+) {
+	LatencyMode latencyMode = LatencyMode::Throughput;
+	uint numBufferedFrames = 0;
+
+	for (int i = 1; i < __argc; ++i) {
+		if (_stricmp(__argv[i], "-lowlatency") == 0) {
+			latencyMode = LatencyMode::LowLatency;
+		}
+		else if (_stricmp(__argv[i], "-throughput") == 0) {
+			latencyMode = LatencyMode::Throughput;
+		}
+		else if (_stricmp(__argv[i], "-frames") == 0 && i + 1 < __argc) {
+			numBufferedFrames = uint(atoi(__argv[++i]));
+		}
+	}
+
+	demo->SetLatencyMode(latencyMode, numBufferedFrames);
+}
+
+
 int Win32Application::Run (
     D3D12DemoBase * demo,
     HINSTANCE hInstance,
@@ -59,6 +86,7 @@ int Win32Application::Run (
     );
 
 	// Run setup code common to all demos
+	ParseCommandLine(demo);
 	demo->Initialize();
 
 	ShowWindow(m_hwnd, nCmdShow);
@@ -73,8 +101,12 @@ int Win32Application::Run (
 	{
         // Start frame timer.
         auto timerStart = std::chrono::high_resolution_clock::now();
-        // Process any messages in the queue.
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+
+        // Wait before processing input, so that the frame is built from the latest.
+        demo->WaitForNextFrame();
+
+        // Process all messages in the queue.
+        while (msg.message != WM_QUIT && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
             // Translate virtual-key codes into character messages.
             TranslateMessage(&msg);
@@ -97,10 +129,11 @@ int Win32Application::Run (
         if (fpsTimer > 400.0f) {
 			float msPerFrame = fpsTimer / float (frameCount);
 			float fps = float (frameCount) / fpsTimer * 1000.0f;
-			char buffer[256];
-			sprintf (buffer, "%s - %.1f fps (%.2f ms)",
-				demo->GetWindowTitle (), fps, msPerFrame);
-			::SetWindowText (m_hwnd, buffer);
+			// The title is unbounded, so only the frame rate goes through a buffer.
+			char frameRate[64];
+			sprintf_s (frameRate, " - %.1f fps (%.2f ms)", fps, msPerFrame);
+			const std::string windowText = std::string (demo->GetWindowTitle ()) + frameRate;
+			::SetWindowText (m_hwnd, windowText.c_str ());
 
 			// Reset timing info.
 			fpsTimer = 0.0f;
@@ -24,27 +24,9 @@ ConstantBufferDemo::ConstantBufferDemo (
 void ConstantBufferDemo::InitializeDemo (
 	ID3D12GraphicsCommandList * uploadCmdList
 ) {
-	LoadPipelineDependencies();
-
 	LoadAssets();
 }
 
-//---------------------------------------------------------------------------------------
-// Loads the rendering pipeline dependencies.
-void ConstantBufferDemo::LoadPipelineDependencies()
-{
-	//-- Describe and create the CBV Descriptor Heap.
-	{
-		D3D12_DESCRIPTOR_HEAP_DESC cbvDescHeapDescriptor = {};
-		cbvDescHeapDescriptor.NumDescriptors = 2 * NUM_BUFFERED_FRAMES;
-		cbvDescHeapDescriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-		cbvDescHeapDescriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		CHECK_D3D_RESULT (
-			m_device->CreateDescriptorHeap(&cbvDescHeapDescriptor, IID_PPV_ARGS(&m_cbvDescHeap))
-		);
-	}
-}
-
 //---------------------------------------------------------------------------------------
 void ConstantBufferDemo::LoadAssets ()
 {
@@ -95,11 +77,9 @@ void ConstantBufferDemo::LoadAssets ()
 	// Create the pipeline state object.
 	CreatePipelineState(m_vertexShader, m_pixelShader);
 
-	// Create upload buffer to hold graphics resources
-	m_uploadBuffer = std::make_shared<ResourceUploadBuffer>(
-		m_device.Get(),
-		128 * 1024 // 128 KB
-	);
+	// Create upload buffer to hold graphics resources.  Pages are chained on as
+	// needed, so no up front size estimate is required.
+	m_uploadBuffer = std::make_shared<ResourceUploadBuffer>(m_device);
 
 	// Cube vertex data.
 	m_vertexArray = {
@@ -183,48 +163,18 @@ void ConstantBufferDemo::LoadAssets ()
 		);
 	}
 
-	// Create SceneConstants ConstantBuffer storage within upload heap, duplicating
-	// storage space for each buffered frame.
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
-		ZeroMemory(&m_sceneConstData[i], sizeof(SceneConstants));
-		m_uploadBuffer->uploadConstantBufferData(
-			reinterpret_cast<const void *>(&m_sceneConstData[i]),
-			sizeof(SceneConstants),
-			m_cbvDesc_SceneConstants[i],
-			&m_cbv_SceneConstants_dataPtr[i]
-		);
-	}
-
-	// Create PointLight ConstantBuffer storage within upload heap, duplicating
-	// storage space for each buffered frame.
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
-		ZeroMemory(&m_pointLightConstData[i], sizeof(PointLight));
-		m_uploadBuffer->uploadConstantBufferData (
-			reinterpret_cast<const void *>(&m_pointLightConstData[i]),
-			sizeof(PointLight),
-			m_cbvDesc_PointLight[i],
-			&m_cbv_PointLight_dataPtr[i]
-		);
-	}
-
-
-	//-- Create CBV on the CBV-Heap that references our ConstantBuffer data.
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
-		CD3DX12_CPU_DESCRIPTOR_HANDLE cbvDescHeapHandle(
-			m_cbvDescHeap->GetCPUDescriptorHandleForHeapStart()
-		);
-
-		m_device->CreateConstantBufferView(&m_cbvDesc_SceneConstants[i], cbvDescHeapHandle);
-
-		// Increment cbvDescHandle to point to next descriptor in cbvHeap.
-		uint descriptorIncrementSize =
-			m_device->GetDescriptorHandleIncrementSize(
-				D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
-			);
-		cbvDescHeapHandle.Offset(1, descriptorIncrementSize);
+	// Constants are rewritten every frame, so rather than keeping a copy per buffered
+	// frame they are streamed through a ring that holds a few frames worth.
+	const uint64 constantsPerFrameBytes =
+		2 * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	m_constantsRingBuffer = std::make_unique<ResourceUploadBuffer> (
+		m_device,
+		4 * MAX_BUFFERED_FRAMES * constantsPerFrameBytes,
+		ResourceUploadBuffer::AllocationMode::Ring
+	);
 
-		m_device->CreateConstantBufferView(&m_cbvDesc_PointLight[i], cbvDescHeapHandle);
-	}
+	ZeroMemory(&m_sceneConstData, sizeof(SceneConstants));
+	ZeroMemory(&m_pointLightConstData, sizeof(PointLight));
 }
 
 
@@ -344,30 +294,37 @@ void ConstantBufferDemo::UpdateConstantBuffers()
 		XMMATRIX invMatrix = XMMatrixInverse(nullptr, modelViewMatrix);
 		XMMATRIX normalMatrix = XMMatrixTranspose(invMatrix);
 
-		XMStoreFloat4x4(&m_sceneConstData[m_frameIndex].modelViewMatrix, XMMatrixTranspose(modelViewMatrix));
-		XMStoreFloat4x4(&m_sceneConstData[m_frameIndex].MVPMatrix, XMMatrixTranspose(MVPMatrix));
-		XMStoreFloat4x4(&m_sceneConstData[m_frameIndex].normalMatrix, XMMatrixTranspose(normalMatrix));
+		XMStoreFloat4x4(&m_sceneConstData.modelViewMatrix, XMMatrixTranspose(modelViewMatrix));
+		XMStoreFloat4x4(&m_sceneConstData.MVPMatrix, XMMatrixTranspose(MVPMatrix));
+		XMStoreFloat4x4(&m_sceneConstData.normalMatrix, XMMatrixTranspose(normalMatrix));
 
 
 		XMVECTOR lightPosition{ -5.0f, 5.0f,  5.0f, 1.0f };
 
 		// Transform lightPosition into View Space
 		lightPosition = XMVector4Transform(lightPosition, viewMatrix);
-		XMStoreFloat4(&m_pointLightConstData[m_frameIndex].position_eyeSpace, lightPosition);
+		XMStoreFloat4(&m_pointLightConstData.position_eyeSpace, lightPosition);
 
 		// White light
-		m_pointLightConstData[m_frameIndex].color = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
+		m_pointLightConstData.color = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
 
 
-		// Update SceneConstants ConstantBuffer data:
-		memcpy (m_cbv_SceneConstants_dataPtr[m_frameIndex], 
-				&m_sceneConstData[m_frameIndex],
-				sizeof(SceneConstants));
+		// Space written by frames the GPU has finished with can be reused, and this
+		// frame's constants are retired by the fence value its submission signals.
+		m_constantsRingBuffer->reclaimCompletedUploads(GetCompletedFenceValue());
+		m_constantsRingBuffer->setCurrentFenceValue(GetLastSubmittedFenceValue() + 1);
 
-		// Update PointLight ConstantBuffer data:
-		memcpy (m_cbv_PointLight_dataPtr[m_frameIndex], 
-				&m_pointLightConstData[m_frameIndex],
-				sizeof(PointLight) );
+		m_constantsRingBuffer->uploadConstantBufferData (
+			&m_sceneConstData,
+			sizeof(SceneConstants),
+			m_cbvDesc_SceneConstants
+		);
+
+		m_constantsRingBuffer->uploadConstantBufferData (
+			&m_pointLightConstData,
+			sizeof(PointLight),
+			m_cbvDesc_PointLight
+		);
 	}
 }
 
@@ -384,13 +341,11 @@ void ConstantBufferDemo::Render (
 	drawCmdList->SetPipelineState(m_pipelineState.Get());
 	drawCmdList->SetGraphicsRootSignature(m_rootSignature.Get());
 
-	ID3D12DescriptorHeap * ppHeaps[] = {m_cbvDescHeap.Get()};
-	drawCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 	drawCmdList->SetGraphicsRootConstantBufferView (
-		0, m_cbvDesc_SceneConstants[m_frameIndex].BufferLocation
+		0, m_cbvDesc_SceneConstants.BufferLocation
 	);
 	drawCmdList->SetGraphicsRootConstantBufferView (
-		1, m_cbvDesc_PointLight[m_frameIndex].BufferLocation
+		1, m_cbvDesc_PointLight.BufferLocation
 	);
 
 	drawCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
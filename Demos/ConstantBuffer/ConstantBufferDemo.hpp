@@ -38,15 +38,12 @@ private:
 	typedef ushort Index;
 
 	// Constant Buffer specific
-	ComPtr<ID3D12DescriptorHeap> m_cbvDescHeap;
-	SceneConstants m_sceneConstData[NUM_BUFFERED_FRAMES];
-	PointLight m_pointLightConstData[NUM_BUFFERED_FRAMES];
+	SceneConstants m_sceneConstData;
+	PointLight m_pointLightConstData;
 
-	D3D12_CONSTANT_BUFFER_VIEW_DESC m_cbvDesc_PointLight[NUM_BUFFERED_FRAMES];
-	void * m_cbv_PointLight_dataPtr[NUM_BUFFERED_FRAMES];
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC m_cbvDesc_SceneConstants[NUM_BUFFERED_FRAMES];
-	void * m_cbv_SceneConstants_dataPtr[NUM_BUFFERED_FRAMES];
+	// Constants are written into the ring each frame, and bound from these.
+	D3D12_CONSTANT_BUFFER_VIEW_DESC m_cbvDesc_SceneConstants;
+	D3D12_CONSTANT_BUFFER_VIEW_DESC m_cbvDesc_PointLight;
 
 	// Pipeline objects.
 	ComPtr<ID3D12RootSignature> m_rootSignature;
@@ -58,6 +55,9 @@ private:
 	D3D12_INPUT_LAYOUT_DESC m_inputLayoutDesc;
 	std::shared_ptr<ResourceUploadBuffer> m_uploadBuffer;
 
+	// Per-frame constants, recycled once the frame that read them completes.
+	std::unique_ptr<ResourceUploadBuffer> m_constantsRingBuffer;
+
 	ComPtr<ID3D12Resource> m_vertexBuffer;
 	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
 	ComPtr<ID3D12Resource> m_indexBuffer;
@@ -67,8 +67,6 @@ private:
 	ShaderSource m_vertexShader;
 	ShaderSource m_pixelShader;
 
-	void LoadPipelineDependencies();
-
 	void LoadAssets ();
 
 	void PopulateCommandList();
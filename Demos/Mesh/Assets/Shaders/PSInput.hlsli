@@ -5,6 +5,7 @@
 struct PSInput {
     float4 position_clipSpace : SV_POSITION;
     float2 texCoord : TEXCOORD;
+    float3 normal_viewSpace : NORMAL;
 };
 
 
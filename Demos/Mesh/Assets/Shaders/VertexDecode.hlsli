@@ -0,0 +1,27 @@
+#ifndef _VERTEXDECODE_HLSLI_
+#define _VERTEXDECODE_HLSLI_
+
+// Decoders for VertexQuantization::PackedVertex attributes.
+
+
+// Maps a UNORM position, relative to the mesh bounds, back to object space.
+float3 decodePosition (
+    float3 position_unorm,
+    float3 offset,
+    float3 scale
+) {
+    return offset + position_unorm * scale;
+}
+
+// Unfolds an octahedral encoded unit normal.
+float3 decodeOctahedralNormal (
+    float2 octNormal
+) {
+    float3 normal = float3(octNormal, 1.0 - abs(octNormal.x) - abs(octNormal.y));
+    float fold = saturate(-normal.z);
+    normal.xy += (normal.xy >= 0.0) ? -fold : fold;
+    return normalize(normal);
+}
+
+
+#endif // _VERTEXDECODE_HLSLI_
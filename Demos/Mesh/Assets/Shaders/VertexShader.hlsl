@@ -1,16 +1,26 @@
 #include "PSInput.hlsli"
+#include "VertexDecode.hlsli"
 #include "../../ConstantBufferDefines.hpp"
 
 ConstantBuffer<SceneConstants> sceneConstants : register(b0, space0);
 
 
+// Inputs are VertexQuantization::PackedVertex attributes.
 PSInput VSMain (
-    float3 position : POSITION,
-    float3 normal   : NORMAL,
-    float2 texCoord : TEXCOORD
+    float4 position_unorm : POSITION,
+    float2 octNormal      : NORMAL,
+    float2 texCoord       : TEXCOORD
 ) {
+    float3 position = decodePosition (
+        position_unorm.xyz,
+        sceneConstants.positionOffset.xyz,
+        sceneConstants.positionScale.xyz
+    );
+    float3 normal = decodeOctahedralNormal(octNormal);
+
 	PSInput psInput;
     psInput.texCoord = texCoord;
+    psInput.normal_viewSpace = mul(float4(normal, 0.0), sceneConstants.normalMatrix).xyz;
     psInput.position_clipSpace = mul(float4(position, 1.0), sceneConstants.MVPMatrix);
 
 	return psInput;
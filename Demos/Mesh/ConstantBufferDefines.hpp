@@ -8,6 +8,11 @@ struct SceneConstants
     mat4 modelViewMatrix;
     mat4 MVPMatrix;
     mat4 normalMatrix;
+
+	// Decodes quantized vertex positions, see VertexQuantization::PositionTransform.
+	float4 positionOffset;
+	float4 positionScale;
+
 	float inv_aspectRatio;
 };
 
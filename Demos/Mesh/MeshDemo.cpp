@@ -8,10 +8,13 @@ using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
 #include <iostream>
+#include <stdexcept>
 using namespace std;
 
-#include "Common/ImageIO.hpp"
-#include "Common/MeshFileLoader.hpp"
+#include "Common/MeshLoader.hpp"
+#include "Common/MeshSimplifier.hpp"
+#include "Common/ResourceUploadBuffer.hpp"
+#include "Common/TextureLoader.hpp"
 
 
 //---------------------------------------------------------------------------------------
@@ -20,7 +23,12 @@ MeshDemo::MeshDemo (
     uint windowHeight,
     std::string windowTitle
 )   
-    :   D3D12DemoBase(windowWidth, windowHeight, windowTitle)
+    :   D3D12DemoBase(windowWidth, windowHeight, windowTitle),
+        m_cullStats(),
+        m_lodIndex(0),
+        m_modelDistance(10.0f),
+        m_textureId(0),
+        m_meshUploadTicket(UploadQueue::NullTicket)
 {
 
 }
@@ -36,28 +44,45 @@ MeshDemo::~MeshDemo()
 void MeshDemo::InitializeDemo (
 	ID3D12GraphicsCommandList * uploadCmdList
 ) {
+	// Load the mesh and its texture in parallel with the rest of the setup.
+	const std::string meshPath = GetAssetPath("Meshes\\low_poly_ship.obj");
+	const std::string texturePath = GetAssetPath("Textures\\low_poly_ship_albedo.png");
+
+	JobSystem::Handle meshLoaded = m_jobSystem->submit([&]() {
+		MeshLoader::loadCachedMesh(meshPath.c_str(), m_mesh);
+	});
+
+	// The albedo has alpha, so it is baked to BC7, a quarter of the RGBA size, on
+	// first run.  Later runs only map the baked file.
+	JobSystem::Handle textureLoaded = m_jobSystem->submit([&]() {
+		TextureBaker::Options bakeOptions;
+		bakeOptions.compression = TextureBaker::Compression::BC7;
+		TextureLoader::loadCachedTexture (
+			texturePath.c_str(), m_texture, bakeOptions, m_jobSystem.get()
+		);
+	});
+
 	CreateRootSignature();
 
 	CreateConstantBuffers();
 
 	CreateDescriptorHeap();
 
-	/////////////////////////////////////////////////////////////////////////////
-	//TODO Dustin - Finish this section:
-	//Mesh mesh;
-	//MeshFileLoader::loadObjAsset (GetAssetPath (MESH, "low_poly_ship.obj"), mesh);
-	/////////////////////////////////////////////////////////////////////////////
-
-	UploadVertexDataToGpu(uploadCmdList);
-
-	CreateTexture(uploadCmdList);
-
 	//-- Load shader byte code:
 	LoadCompiledShaderFromFile (GetAssetPath ("VertexShader.cso").c_str (), m_vertexShader);
 	LoadCompiledShaderFromFile (GetAssetPath ("PixelShader.cso").c_str (), m_pixelShader);
 
 	CreatePipelineState(m_vertexShader, m_pixelShader);
 
+	// Record each upload as soon as its data is ready.  Mesh data is copied on the
+	// copy queue, overlapping the rest of initialization and the first frames.
+	m_jobSystem->wait(meshLoaded);
+	UploadVertexDataToGpu(m_uploadQueue->getCommandList());
+	m_meshUploadTicket = m_uploadQueue->submit();
+
+	m_jobSystem->wait(textureLoaded);
+	CreateTextureStreamer();
+
 	m_rotationMatrix = XMMatrixIdentity();
 }
 
@@ -75,6 +100,18 @@ void MeshDemo::OnMouseMove(
 	}
 }
 
+//---------------------------------------------------------------------------------------
+void MeshDemo::OnKeyDown (
+	uint8 key
+) {
+	// Move the model away to step through its coarser LODs.
+	if (key == VK_UP) {
+		m_modelDistance = max(m_modelDistance * 0.9f, 4.0f);
+	} else if (key == VK_DOWN) {
+		m_modelDistance = min(m_modelDistance * 1.1f, 150.0f);
+	}
+}
+
 //---------------------------------------------------------------------------------------
 void MeshDemo::CreateRootSignature()
 {
@@ -107,7 +144,7 @@ void MeshDemo::CreateRootSignature()
 	// We don't use another descriptor heap for the sampler, instead we use a
 	// static sampler
 	CD3DX12_STATIC_SAMPLER_DESC samplers[1];
-	samplers[0].Init (0, D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT);
+	samplers[0].Init (0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
 
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
 	rootSignatureDesc.Init (_countof(rootParameters), rootParameters, 1, samplers,
@@ -131,10 +168,10 @@ void MeshDemo::CreateRootSignature()
 //---------------------------------------------------------------------------------------
 void MeshDemo::CreateDescriptorHeap()
 {
-	// Create a descriptor heap to hold the texture SRV, which cannot go directly 
-	// into the root signature.
+	// Create a descriptor heap to hold the texture SRVs, which cannot go directly 
+	// into the root signature.  The streamed texture alternates between two.
 	D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
-	descriptorHeapDesc.NumDescriptors = 1;
+	descriptorHeapDesc.NumDescriptors = 2;
 	descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
@@ -149,8 +186,13 @@ void MeshDemo::CreateDescriptorHeap()
 //---------------------------------------------------------------------------------------
 void MeshDemo::CreateConstantBuffers()
 {
+	m_sceneConstData.resize(m_numBufferedFrames);
+	m_constantBuffer_sceneConstant.resize(m_numBufferedFrames);
+	m_pointLightConstData.resize(m_numBufferedFrames);
+	m_constantBuffer_pointLight.resize(m_numBufferedFrames);
+
 	//-- Create SceneConstant constant buffers within upload heap:
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
+	for (uint i(0); i < m_numBufferedFrames; ++i) {
 		const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
 		const auto constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (sizeof(SceneConstants));
 
@@ -166,7 +208,7 @@ void MeshDemo::CreateConstantBuffers()
 	}
 
 	//-- Create PointLight constant buffers within upload heap:
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
+	for (uint i(0); i < m_numBufferedFrames; ++i) {
 		const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
 		const auto constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (
 			sizeof (DirectionalLight)
@@ -190,63 +232,83 @@ void MeshDemo::CreateConstantBuffers()
 void MeshDemo::UploadVertexDataToGpu (
 	ID3D12GraphicsCommandList * uploadCmdList
 ) {
-	// Create upload buffer for uploading vertex/index data to default heap.
-    static ComPtr<ID3D12Resource> uploadBuffer_vertexData;
-
-	const float inv_aspectRatio = static_cast<float>(m_windowHeight) / m_windowWidth;
+	// Quantize vertices to half their size, relative to the mesh bounds stored in the
+	// cache.  Index data is read straight out of the mapped mesh cache.
+	const MeshCache::Header & meshHeader = m_mesh.header();
+	m_positionTransform = VertexQuantization::computePositionTransform (
+		meshHeader.boundsMin, meshHeader.boundsMax
+	);
 
-	// Quad vertex data.
-	Vertex vertexArray[] = {
-		// Positions             Normals               TexCords
-		{ -0.5f, -0.5f,  0.0f,   0.0f,  1.0f,  0.0f,   0.0f, 1.0f}, // 0
-		{  0.5f, -0.5f,  0.0f,   0.0f,  1.0f,  0.0f,   1.0f, 1.0f}, // 1
-		{  0.5f,  0.5f,  0.0f,   0.0f,  1.0f,  0.0f,   1.0f, 0.0f}, // 2
-		{ -0.5f,  0.5f,  0.0f,   0.0f,  1.0f,  0.0f,   0.0f, 0.0f}  // 3
-	};
-
-	// Create index data
-	Index indexArray[] = {
-		0,1,2, 0,2,3,
-	};
-	m_numIndices = std::extent<decltype(indexArray)>::value;
-
-
-	const int uploadBufferSize = sizeof(vertexArray) + sizeof(indexArray);
-	const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
-	const auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (uploadBufferSize);
-
-	// Create upload buffer.
-	m_device->CreateCommittedResource (
-		&uploadHeapProperties,
-		D3D12_HEAP_FLAG_NONE,
-		&uploadBufferDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS (&uploadBuffer_vertexData)
+	const size_t numVertices = m_mesh.numVertices();
+	const size_t vertexDataBytes = numVertices * sizeof(VertexQuantization::PackedVertex);
+	const size_t indexDataBytes = m_mesh.indexDataBytes();
+
+	// Workers quantize slices of the vertices and write them, along with the indices,
+	// into one upload buffer at the same time.  Leave room for the partly used chunk
+	// each thread may hold.
+	const size_t verticesPerSlice = 16 * 1024;
+	const size_t numSlices = (numVertices + verticesPerSlice - 1) / verticesPerSlice;
+	const uint64 uploadBufferSize = vertexDataBytes + indexDataBytes +
+		(m_jobSystem->numWorkerThreads() + 1) * ResourceUploadBuffer::DefaultPageSize;
+
+	// Kept alive by m_uploadQueue until the copies complete.
+	ResourceUploadBuffer meshUploadBuffer (
+		m_device, uploadBufferSize, ResourceUploadBuffer::AllocationMode::Concurrent
 	);
-	SET_D3D12_DEBUG_NAME(uploadBuffer_vertexData);
+
+	std::vector<D3D12_VERTEX_BUFFER_VIEW> vertexSlices(numSlices);
+	D3D12_INDEX_BUFFER_VIEW indexUpload;
+	JobSystem::Handle uploaded;
+
+	for (size_t i = 0; i < numSlices; ++i) {
+		m_jobSystem->submit([&, i]() {
+			const size_t firstVertex = i * verticesPerSlice;
+			const size_t sliceVertices = min(verticesPerSlice, numVertices - firstVertex);
+
+			std::vector<VertexQuantization::PackedVertex> packedVertices(sliceVertices);
+			VertexQuantization::encodeVertices (
+				m_mesh.vertices() + firstVertex, sliceVertices, m_positionTransform,
+				packedVertices.data()
+			);
+			meshUploadBuffer.uploadVertexData (
+				packedVertices.data(),
+				sliceVertices * sizeof(VertexQuantization::PackedVertex),
+				sizeof(VertexQuantization::PackedVertex),
+				vertexSlices[i]
+			);
+		}, uploaded);
+	}
+
+	m_jobSystem->submit([&]() {
+		meshUploadBuffer.uploadIndexData (
+			m_mesh.indexData(), indexDataBytes, m_mesh.indexSize(), indexUpload
+		);
+	}, uploaded);
 
 	// Allocate vertex and index buffers within the default heap
 	{
 		const auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_DEFAULT);
 
-		const auto vertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (sizeof(vertexArray));
+		// Buffers start in the COMMON state so they can be implicitly promoted to
+		// COPY_DEST on the copy queue, and later to their read states on the direct
+		// queue.
+		const auto vertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (vertexDataBytes);
 		m_device->CreateCommittedResource (
 			&defaultHeapProperties,
 			D3D12_HEAP_FLAG_NONE,
 			&vertexBufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_COMMON,
 			nullptr,
 			IID_PPV_ARGS (&m_vertexBuffer)
 		);
 		SET_D3D12_DEBUG_NAME(m_vertexBuffer);
 
-		const auto indexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (sizeof(indexArray));
+		const auto indexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (indexDataBytes);
 		m_device->CreateCommittedResource (
 			&defaultHeapProperties,
 			D3D12_HEAP_FLAG_NONE,
 			&indexBufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_COMMON,
 			nullptr,
 			IID_PPV_ARGS (&m_indexBuffer)
 		);
@@ -255,74 +317,47 @@ void MeshDemo::UploadVertexDataToGpu (
 
 	// Initialize vertex buffer view
 	m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-	m_vertexBufferView.SizeInBytes = sizeof(vertexArray);
-	m_vertexBufferView.StrideInBytes = sizeof(Vertex);
+	m_vertexBufferView.SizeInBytes = static_cast<uint>(vertexDataBytes);
+	m_vertexBufferView.StrideInBytes = sizeof(VertexQuantization::PackedVertex);
 
 	// Initialize index buffer view
 	m_indexBufferView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
-	m_indexBufferView.SizeInBytes = sizeof(indexArray);
-	m_indexBufferView.Format = DXGI_FORMAT_R16_UINT;
+	m_indexBufferView.SizeInBytes = static_cast<uint>(indexDataBytes);
+	m_indexBufferView.Format =
+		(m_mesh.indexSize() == sizeof(uint16)) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 	
 
-	// Copy vertex data in CPU memory to upload buffer
-	{
-		void * p;
-		// Set read range to zero, since we are only going to upload data to upload buffer
-		// rather than read data from it.
-		D3D12_RANGE readRange = {0, 0};
-		uploadBuffer_vertexData->Map(0, &readRange, &p);
-		::memcpy(p, vertexArray, sizeof(vertexArray));
-		::memcpy(static_cast<byte *>(p) + sizeof(vertexArray), indexArray, sizeof(indexArray));
-
-		// Finished uploading data to uploadBuffer, so unmap it.
-		D3D12_RANGE writtenRange = {0, sizeof(vertexArray) + sizeof(indexArray)};
-		uploadBuffer_vertexData->Unmap(0, &writtenRange);
-	}
+	m_jobSystem->wait(uploaded);
 
-	// Copy data from upload buffer on CPU into the index/vertex buffer on 
-	// the GPU.
+	// Copy each slice from the upload buffer into the index/vertex buffer on the GPU.
 	{
-		uint64 dstOffset = 0;
-		uint64 srcOffset = 0;
-		uploadCmdList->CopyBufferRegion (
-			m_vertexBuffer.Get(),
-			dstOffset,
-			uploadBuffer_vertexData.Get(),
-			srcOffset,
-			sizeof(vertexArray)
-		);
+		ID3D12Resource * uploadResource = meshUploadBuffer.getResource();
+		const D3D12_GPU_VIRTUAL_ADDRESS uploadAddress =
+			meshUploadBuffer.getGPUVirtualAddress();
+
+		for (size_t i = 0; i < numSlices; ++i) {
+			uploadCmdList->CopyBufferRegion (
+				m_vertexBuffer.Get(),
+				i * verticesPerSlice * sizeof(VertexQuantization::PackedVertex),
+				uploadResource,
+				vertexSlices[i].BufferLocation - uploadAddress,
+				vertexSlices[i].SizeInBytes
+			);
+		}
 
-		dstOffset = 0;
-		srcOffset = sizeof(vertexArray);
 		uploadCmdList->CopyBufferRegion (
 			m_indexBuffer.Get(),
-			dstOffset,
-			uploadBuffer_vertexData.Get(),
-			srcOffset,
-			sizeof(indexArray)
+			0,
+			uploadResource,
+			indexUpload.BufferLocation - uploadAddress,
+			indexDataBytes
 		);
 	}
 
+	m_uploadQueue->keepAlive(meshUploadBuffer.getResource());
 
-	// Batch resource barriers marking state transitions.
-	{
-		const CD3DX12_RESOURCE_BARRIER barriers[2] = {
-
-			CD3DX12_RESOURCE_BARRIER::Transition (
-				m_vertexBuffer.Get(),
-				D3D12_RESOURCE_STATE_COPY_DEST,
-				D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
-			),
-
-			CD3DX12_RESOURCE_BARRIER::Transition (
-				m_indexBuffer.Get(),
-				D3D12_RESOURCE_STATE_COPY_DEST,
-				D3D12_RESOURCE_STATE_INDEX_BUFFER
-			)
-		};
-
-		uploadCmdList->ResourceBarrier(2, barriers);
-	}
+	// No resource barriers needed.  Buffers decay back to the COMMON state once the
+	// copy queue finishes, and are promoted again when first read by the direct queue.
 }
 
 //---------------------------------------------------------------------------------------
@@ -330,33 +365,36 @@ void MeshDemo::CreatePipelineState(
     const ShaderSource & vertexShader,
     const ShaderSource & pixelShader
 ) {
-    // Define the vertex input layout.
+    // Define the vertex input layout, matching VertexQuantization::PackedVertex.
     D3D12_INPUT_ELEMENT_DESC inputElementDescriptor[3];
 
     // Positions
     inputElementDescriptor[0].SemanticName = "POSITION";
     inputElementDescriptor[0].SemanticIndex = 0;
-    inputElementDescriptor[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+    inputElementDescriptor[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
     inputElementDescriptor[0].InputSlot = 0;
-    inputElementDescriptor[0].AlignedByteOffset = 0;
+    inputElementDescriptor[0].AlignedByteOffset =
+		offsetof(VertexQuantization::PackedVertex, position);
     inputElementDescriptor[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
     inputElementDescriptor[0].InstanceDataStepRate = 0;
 
     // Normals
     inputElementDescriptor[1].SemanticName = "NORMAL";
     inputElementDescriptor[1].SemanticIndex = 0;
-    inputElementDescriptor[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+    inputElementDescriptor[1].Format = DXGI_FORMAT_R16G16_SNORM;
     inputElementDescriptor[1].InputSlot = 0;
-    inputElementDescriptor[1].AlignedByteOffset = sizeof(float) * 3;
+    inputElementDescriptor[1].AlignedByteOffset =
+		offsetof(VertexQuantization::PackedVertex, normal);
     inputElementDescriptor[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
     inputElementDescriptor[1].InstanceDataStepRate = 0;
 
-    // Normals
+    // Texture coordinates
     inputElementDescriptor[2].SemanticName = "TEXCOORD";
     inputElementDescriptor[2].SemanticIndex = 0;
-    inputElementDescriptor[2].Format = DXGI_FORMAT_R32G32_FLOAT;
+    inputElementDescriptor[2].Format = DXGI_FORMAT_R16G16_FLOAT;
     inputElementDescriptor[2].InputSlot = 0;
-    inputElementDescriptor[2].AlignedByteOffset = sizeof(float) * 6;
+    inputElementDescriptor[2].AlignedByteOffset =
+		offsetof(VertexQuantization::PackedVertex, texCoord);
     inputElementDescriptor[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
     inputElementDescriptor[2].InstanceDataStepRate = 0;
 
@@ -396,83 +434,23 @@ void MeshDemo::CreatePipelineState(
 }
 
 //---------------------------------------------------------------------------------------
-void MeshDemo::CreateTexture (
-	ID3D12GraphicsCommandList * uploadCmdList
-) {
-	ImageDecoder::decodeImage(GetAssetPath("Textures\\uvgrid.jpg"), 1, &m_imageData);
-
-	const auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_DEFAULT);
-	const auto textureResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D (
-		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, m_imageData.width, m_imageData.height, 1, 1
-	);
-
-	// Create a texture resource within Default Heap that will hold the image data.
-	// The texture resource's state will begin as a Copy Destination.
-	CHECK_D3D_RESULT (
-		m_device->CreateCommittedResource (
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&textureResourceDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&m_imageTexture2d)
-		)
+void MeshDemo::CreateTextureStreamer()
+{
+	m_textureBackend = std::make_unique<TextureStreamingBackend> (
+		m_device, m_uploadQueue.get(), m_srvDescriptorHeap.Get(), 0
 	);
-
-	const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
-	const auto uploadBufferSize = ::GetRequiredIntermediateSize (m_imageTexture2d.Get(), 0, 1);
-	const auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (uploadBufferSize);
-
-	// Create upload buffer for uploading image data to texture resource on GPU.
-	CHECK_D3D_RESULT (
-		m_device->CreateCommittedResource (
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&uploadBufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_uploadBuffer)
-		)
+	m_textureStreamer = std::make_unique<TextureStreamer> (
+		TextureStreamer::Settings(), m_textureBackend.get(), m_memoryBudget.get()
 	);
 
-	const int bytesPerPixel(4);
-
-	D3D12_SUBRESOURCE_DATA sourceData;
-	sourceData.pData = m_imageData.data;
-	sourceData.RowPitch = m_imageData.width * bytesPerPixel;
-	sourceData.SlicePitch = m_imageData.width * m_imageData.height * bytesPerPixel;
+	m_textureId = m_textureStreamer->addTexture(m_texture.description());
+	m_textureBackend->addTexture(m_textureId, m_texture);
 
-	// Transfer source image data to upload buffer using CPU, then schedule a copy
-	// on GPU using upload command list to transfer data to texture resource in the
-	// default heap.
-	::UpdateSubresources<1> (
-		uploadCmdList, m_imageTexture2d.Get(), 
-		m_uploadBuffer.Get(), 0, 0, 1, &sourceData
-	);
-
-	// Issue resource barrier to transition image texture from copy state to 
-	// pixel shader resource.
-	const auto resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition (
-		m_imageTexture2d.Get(),
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-	);
-	uploadCmdList->ResourceBarrier(1, &resourceBarrier);
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc = {};
-	shaderResourceViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	shaderResourceViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	shaderResourceViewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-	shaderResourceViewDesc.Texture2D.MipLevels = 1;
-	shaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
-	shaderResourceViewDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-
-	// Create SRV for texture and place it in the SRV descriptor heap.
-	m_device->CreateShaderResourceView (
-		m_imageTexture2d.Get(),
-		&shaderResourceViewDesc,
-		m_srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart()
-	);
+	// Begin uploading the mip tail, so that it is resident for the first frame.
+	// Finer levels follow once the first frames have measured the model on screen.
+	m_textureBackend->beginFrame(GetLastSubmittedFenceValue(), GetCompletedFenceValue());
+	m_textureStreamer->update();
+	m_textureBackend->endFrame();
 }
 
 //---------------------------------------------------------------------------------------
@@ -481,7 +459,17 @@ void MeshDemo::UpdateConstantBuffers()
 	const float inv_aspectRatio = static_cast<float>(m_windowHeight) / m_windowWidth;
 	m_sceneConstData[m_frameIndex].inv_aspectRatio = inv_aspectRatio;
 
-	XMMATRIX translationMatrix = XMMatrixTranslation(0.0f, 0.0f, -1.0f);
+	m_sceneConstData[m_frameIndex].positionOffset = XMFLOAT4 (
+		m_positionTransform.offset[0], m_positionTransform.offset[1],
+		m_positionTransform.offset[2], 0.0f
+	);
+	m_sceneConstData[m_frameIndex].positionScale = XMFLOAT4 (
+		m_positionTransform.scale[0], m_positionTransform.scale[1],
+		m_positionTransform.scale[2], 0.0f
+	);
+
+	// Place the ship far enough from the camera to fit within the view.
+	XMMATRIX translationMatrix = XMMatrixTranslation(0.0f, -0.9f, -m_modelDistance);
 	XMMATRIX modelMatrix = XMMatrixMultiply(m_rotationMatrix, translationMatrix);
 
 	XMMATRIX viewMatrix = XMMatrixLookAtRH (
@@ -528,6 +516,24 @@ void MeshDemo::UpdateConstantBuffers()
 	XMStoreFloat4x4(&m_sceneConstData[m_frameIndex].MVPMatrix, XMMatrixTranspose(MVPMatrix));
 	XMStoreFloat4x4(&m_sceneConstData[m_frameIndex].normalMatrix, XMMatrixTranspose(normalMatrix));
 
+	const size_t lodIndex = m_lodIndex;
+	const size_t numVisible = m_cullStats.numVisible;
+
+	SelectLod(modelViewMatrix, projectMatrix);
+	RequestTextureMips(modelViewMatrix, projectMatrix);
+	if (m_lodIndex == 0) {
+		CullMeshlets(MVPMatrix, modelViewMatrix);
+	} else {
+		// Coarser LODs have no meshlets, draw their whole index range.
+		const Mesh::Lod & lod = m_mesh.lods()[m_lodIndex];
+		m_visibleRanges.assign(1, Mesh::Submesh{ lod.startIndex, lod.numIndices, 0 });
+		m_cullStats = Meshlets::CullStatistics();
+	}
+
+	if (m_lodIndex != lodIndex || m_cullStats.numVisible != numVisible) {
+		UpdateWindowText();
+	}
+
 	XMVECTOR lightDirection{ -5.0f, 5.0f,  5.0f, 1.0f };
 
 	// Transform lightPosition into View Space
@@ -556,15 +562,169 @@ void MeshDemo::UpdateConstantBuffers()
 	}
 }
 
+//---------------------------------------------------------------------------------------
+void MeshDemo::CullMeshlets (
+	const XMMATRIX & MVPMatrix,
+	const XMMATRIX & modelViewMatrix
+) {
+	if (m_mesh.numMeshlets() == 0) {
+		return;
+	}
+
+	XMFLOAT4X4 mvp;
+	XMStoreFloat4x4(&mvp, MVPMatrix);
+
+	// Meshlet bounds are in model space, as is the camera at the view space origin.
+	XMFLOAT3 cameraPosition;
+	XMStoreFloat3(&cameraPosition, XMMatrixInverse(nullptr, modelViewMatrix).r[3]);
+
+	// The pipeline disables depth clipping, so only the side planes can cull.
+	const Meshlets::Frustum frustum = Meshlets::extractFrustum(&mvp.m[0][0], false);
+
+	m_cullStats = Meshlets::cullMeshlets (
+		m_mesh.meshlets(), m_mesh.numMeshlets(), frustum, &cameraPosition.x, m_visibleRanges
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshDemo::SelectLod (
+	const XMMATRIX & modelViewMatrix,
+	const XMMATRIX & projectMatrix
+) {
+	if (m_mesh.numLods() <= 1) {
+		m_lodIndex = 0;
+		return;
+	}
+
+	// Bounding sphere of the model in view space, LOD errors are in model space units
+	// and the model matrix doesn't scale.
+	const MeshCache::Header & header = m_mesh.header();
+	const XMVECTOR boundsMin = XMLoadFloat3(reinterpret_cast<const XMFLOAT3 *>(header.boundsMin));
+	const XMVECTOR boundsMax = XMLoadFloat3(reinterpret_cast<const XMFLOAT3 *>(header.boundsMax));
+	const XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+	const float radius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(boundsMax, boundsMin)));
+
+	const XMVECTOR viewCenter = XMVector3Transform(center, modelViewMatrix);
+	const float distance = XMVectorGetX(XMVector3Length(viewCenter)) - radius;
+
+	// Pixels spanned by a unit length at a distance of one.
+	const float pixelsPerUnit = XMVectorGetY(projectMatrix.r[1]) * 0.5f * m_windowHeight;
+
+	m_lodIndex = MeshSimplifier::selectLod (
+		m_mesh.lods(), m_mesh.numLods(), distance, pixelsPerUnit
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshDemo::RequestTextureMips (
+	const XMMATRIX & modelViewMatrix,
+	const XMMATRIX & projectMatrix
+) {
+	// The texture is unwrapped across the whole model, so take it to span the
+	// projected diameter of the model's bounding sphere.
+	const MeshCache::Header & header = m_mesh.header();
+	const XMVECTOR boundsMin = XMLoadFloat3(reinterpret_cast<const XMFLOAT3 *>(header.boundsMin));
+	const XMVECTOR boundsMax = XMLoadFloat3(reinterpret_cast<const XMFLOAT3 *>(header.boundsMax));
+	const XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+	const float radius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(boundsMax, boundsMin)));
+
+	const XMVECTOR viewCenter = XMVector3Transform(center, modelViewMatrix);
+	const float distance = max(XMVectorGetX(XMVector3Length(viewCenter)), radius);
+	const float pixelsPerUnit = XMVectorGetY(projectMatrix.r[1]) * 0.5f * m_windowHeight;
+	const float screenPixels = 2.0f * radius * pixelsPerUnit / distance;
+
+	const DdsFile::Description & description = m_texture.description();
+	m_textureStreamer->requestMip (
+		m_textureId,
+		TextureStreamer::requiredMipLevel(description.width, description.height, screenPixels),
+		screenPixels
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshDemo::UpdateWindowText()
+{
+	char text[128];
+	const uint textureMip = m_textureStreamer->residentMip(m_textureId);
+	if (m_lodIndex == 0) {
+		sprintf_s(text, "LOD 0, %zu / %zu meshlets visible, %zu draws, texture mip %u",
+			m_cullStats.numVisible, m_mesh.numMeshlets(), m_cullStats.numDrawRanges,
+			textureMip);
+	} else {
+		sprintf_s(text, "LOD %zu, %u triangles, texture mip %u",
+			m_lodIndex, m_mesh.lods()[m_lodIndex].numIndices / 3, textureMip);
+	}
+	SetCustomWindowText(text);
+}
+
 //---------------------------------------------------------------------------------------
 void MeshDemo::Update()
 {
 	this->UpdateConstantBuffers();
+
+	// Stream texture levels towards those requested by UpdateConstantBuffers().
+	const uint textureMip = m_textureStreamer->residentMip(m_textureId);
+	m_textureBackend->beginFrame(GetLastSubmittedFenceValue(), GetCompletedFenceValue());
+	m_textureStreamer->update();
+	m_textureBackend->endFrame();
+
+	if (m_textureStreamer->residentMip(m_textureId) != textureMip) {
+		UpdateWindowText();
+	}
 }
 
 //---------------------------------------------------------------------------------------
 void MeshDemo::Render (
 	ID3D12GraphicsCommandList * drawCmdList
+) {
+	// Have the GPU wait for the uploads of the mesh and the texture's mip tail, which
+	// only stalls the first frames.  Finer levels are swapped in once their uploads complete.
+	RequireUploadCompletion(m_textureBackend->requiredUploadTicket());
+	RequireUploadCompletion(m_meshUploadTicket);
+
+	// Index ranges to draw, either the meshlets that survived culling, a coarser
+	// LOD, or the whole mesh.
+	const Mesh::Submesh * ranges;
+	size_t numRanges;
+	Mesh::Submesh wholeMesh;
+	if (m_mesh.numMeshlets() > 0 || m_lodIndex > 0) {
+		ranges = m_visibleRanges.data();
+		numRanges = m_visibleRanges.size();
+	} else if (m_mesh.numSubmeshes() == 0) {
+		wholeMesh.startIndex = 0;
+		wholeMesh.numIndices = static_cast<uint32>(m_mesh.numIndices());
+		wholeMesh.baseVertex = 0;
+		ranges = &wholeMesh;
+		numRanges = 1;
+	} else {
+		// Mesh was split into chunks addressable by 16-bit indices.
+		ranges = m_mesh.submeshes();
+		numRanges = m_mesh.numSubmeshes();
+	}
+
+	// Only split draws across threads once there are enough to outweigh the cost of
+	// setting up each command list.
+	const size_t minDrawsPerChunk = 256;
+	const uint numChunks = uint(min(size_t(GetMaxParallelChunks()), numRanges / minDrawsPerChunk));
+	if (numChunks <= 1) {
+		SetDrawState(drawCmdList);
+		RecordDraws(drawCmdList, ranges, numRanges);
+		return;
+	}
+
+	RecordParallel (numChunks,
+		[=](ID3D12GraphicsCommandList * commandList, uint chunkIndex) {
+			const size_t begin = numRanges * chunkIndex / numChunks;
+			const size_t end = numRanges * (chunkIndex + 1) / numChunks;
+			SetDrawState(commandList);
+			RecordDraws(commandList, ranges + begin, end - begin);
+		}
+	);
+}
+
+//---------------------------------------------------------------------------------------
+void MeshDemo::SetDrawState (
+	ID3D12GraphicsCommandList * drawCmdList
 ) {
 	// Set the descriptor heap containing the texture srv
 	ID3D12DescriptorHeap* heaps[] = {m_srvDescriptorHeap.Get ()};
@@ -587,7 +747,7 @@ void MeshDemo::Render (
 
 		// Root Param 2
 		drawCmdList->SetGraphicsRootDescriptorTable (
-			2, m_srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart()
+			2, m_textureBackend->srvHandle(m_textureId)
 		);
 	}
 
@@ -596,6 +756,17 @@ void MeshDemo::Render (
 	const uint inputSlot0 = 0;
 	drawCmdList->IASetVertexBuffers(inputSlot0, 1, &m_vertexBufferView);
 	drawCmdList->IASetIndexBuffer(&m_indexBufferView);
+}
 
-	drawCmdList->DrawIndexedInstanced(m_numIndices, 1, 0, 0, 0);
+//---------------------------------------------------------------------------------------
+void MeshDemo::RecordDraws (
+	ID3D12GraphicsCommandList * drawCmdList,
+	const Mesh::Submesh * ranges,
+	size_t numRanges
+) {
+	for (size_t i = 0; i < numRanges; ++i) {
+		drawCmdList->DrawIndexedInstanced (
+			ranges[i].numIndices, 1, ranges[i].startIndex, ranges[i].baseVertex, 0
+		);
+	}
 }
@@ -8,7 +8,12 @@
 #include <DirectXMath.h>
 
 #include "Common/D3D12DemoBase.hpp"
-#include "Common/ImageDecoder.hpp"
+#include "Common/DdsFile.hpp"
+#include "Common/MeshCache.hpp"
+#include "Common/Meshlets.hpp"
+#include "Common/TextureStreamer.hpp"
+#include "Common/TextureStreamingBackend.hpp"
+#include "Common/VertexQuantization.hpp"
 #include "Common/ShaderUtils.hpp"
 
 #include "ConstantBufferDefines.hpp"
@@ -33,6 +38,10 @@ public:
 		int dy
 	) override;
 
+	void OnKeyDown (
+		uint8 key
+	) override;
+
 	void Update() override;
 
 	void Render (
@@ -41,25 +50,34 @@ public:
 
 
 private:
-	struct Vertex {
-		float position[3];
-		float normal[3];
-		float texCoord[2];
-	};
-	typedef ushort Index;
+	MappedMesh m_mesh;
+	VertexQuantization::PositionTransform m_positionTransform;
+
+	// Index ranges drawn this frame, either the meshlets of the full detail mesh that
+	// survived culling or the whole range of a coarser LOD.
+	std::vector<Mesh::Submesh> m_visibleRanges;
+	Meshlets::CullStatistics m_cullStats;
+
+	// Level of detail drawn this frame, selected by its projected error.
+	size_t m_lodIndex;
+
+	// Distance of the model from the camera, adjusted with the arrow keys.
+	float m_modelDistance;
 
-	ImageData m_imageData;
-	ComPtr<ID3D12Resource> m_imageTexture2d;
-	ComPtr<ID3D12Resource> m_uploadBuffer;
+	// Albedo texture, kept mapped so that its levels can be streamed in on demand.
+	MappedDds m_texture;
+	std::unique_ptr<TextureStreamingBackend> m_textureBackend;
+	std::unique_ptr<TextureStreamer> m_textureStreamer;
+	TextureStreamer::TextureId m_textureId;
 
 	ComPtr<ID3D12DescriptorHeap> m_srvDescriptorHeap;
 
 
 	// Constant Buffer specific
-	SceneConstants m_sceneConstData[NUM_BUFFERED_FRAMES];
-	ComPtr<ID3D12Resource> m_constantBuffer_sceneConstant[NUM_BUFFERED_FRAMES];
-	DirectionalLight m_pointLightConstData[NUM_BUFFERED_FRAMES];
-	ComPtr<ID3D12Resource> m_constantBuffer_pointLight[NUM_BUFFERED_FRAMES];
+	std::vector<SceneConstants> m_sceneConstData;
+	std::vector<ComPtr<ID3D12Resource>> m_constantBuffer_sceneConstant;
+	std::vector<DirectionalLight> m_pointLightConstData;
+	std::vector<ComPtr<ID3D12Resource>> m_constantBuffer_pointLight;
 	DirectX::XMMATRIX m_rotationMatrix;
 
 	// Pipeline objects.
@@ -67,11 +85,13 @@ private:
 	ComPtr<ID3D12PipelineState> m_pipelineState;
 
 	// App resources.
-	uint m_numIndices;
 	D3D12_INPUT_LAYOUT_DESC m_inputLayoutDesc;
 	ComPtr<ID3D12Resource> m_vertexBuffer;
 	ComPtr<ID3D12Resource> m_indexBuffer;
 
+	// Completion ticket for the copy of the buffers above on the copy queue.
+	UploadQueue::Ticket m_meshUploadTicket;
+
 	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
 	D3D12_INDEX_BUFFER_VIEW m_indexBufferView;
     uint m_indexCount;
@@ -89,14 +109,42 @@ private:
 
 	void UpdateConstantBuffers();
 
+	void SelectLod (
+		const DirectX::XMMATRIX & modelViewMatrix,
+		const DirectX::XMMATRIX & projectMatrix
+	);
+
+	void CullMeshlets (
+		const DirectX::XMMATRIX & MVPMatrix,
+		const DirectX::XMMATRIX & modelViewMatrix
+	);
+
+	// Requests the texture levels needed to draw the model at its projected size.
+	void RequestTextureMips (
+		const DirectX::XMMATRIX & modelViewMatrix,
+		const DirectX::XMMATRIX & projectMatrix
+	);
+
+	void UpdateWindowText();
+
+	// Sets the pipeline, root parameters and buffers drawn with on 'drawCmdList'.
+	void SetDrawState (
+		ID3D12GraphicsCommandList * drawCmdList
+	);
+
+	void RecordDraws (
+		ID3D12GraphicsCommandList * drawCmdList,
+		const Mesh::Submesh * ranges,
+		size_t numRanges
+	);
+
 	void CreatePipelineState (
 		const ShaderSource & vertexShader,
 		const ShaderSource & pixelShader
 	);
 
-	void CreateTexture (
-		ID3D12GraphicsCommandList * uploadCmdList
-	);
+	// Starts streaming m_texture, beginning with the upload of its mip tail.
+	void CreateTextureStreamer();
 
 	void CreateDescriptorHeap();
 };
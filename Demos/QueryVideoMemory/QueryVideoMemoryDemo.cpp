@@ -25,6 +25,8 @@ QueryVideoMemoryDemo::QueryVideoMemoryDemo (
 void QueryVideoMemoryDemo::InitializeDemo (
 	ID3D12GraphicsCommandList * uploadCmdList
 ) {
+	// Budgets are otherwise first polled before the first Update().
+	m_memoryBudget->update();
 	OutputMemoryBudgets();
 }
 
@@ -32,23 +34,23 @@ void QueryVideoMemoryDemo::InitializeDemo (
 //---------------------------------------------------------------------------------------
 void QueryVideoMemoryDemo::OutputMemoryBudgets()
 {
-    DXGI_QUERY_VIDEO_MEMORY_INFO videoMemoryInfo;
-
-    // Query video memory
-	QueryVideoMemoryInfo(m_device.Get(), DXGI_MEMORY_SEGMENT_GROUP_LOCAL, videoMemoryInfo);
+    // Video memory, as polled by m_memoryBudget.
+    const MemoryBudget::SegmentInfo & videoMemoryInfo =
+        m_memoryBudget->segmentInfo(MemoryBudget::Segment::Local);
 	std::stringstream stream;
     stream << "Video Memory:\n"
-         << "Budget: " << videoMemoryInfo.Budget << " bytes" << endl
-         << "AvailableForReservation: " << videoMemoryInfo.AvailableForReservation << " bytes" << endl
-         << "CurrantUsage: " << videoMemoryInfo.CurrentUsage << " bytes" << endl;
+         << "Budget: " << videoMemoryInfo.budget << " bytes" << endl
+         << "AvailableForReservation: " << videoMemoryInfo.availableForReservation << " bytes" << endl
+         << "CurrentUsage: " << videoMemoryInfo.currentUsage << " bytes" << endl;
     stream << endl;
 
-    // Query system memory
-	QueryVideoMemoryInfo(m_device.Get(), DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, videoMemoryInfo);
+    // System memory
+    const MemoryBudget::SegmentInfo & systemMemoryInfo =
+        m_memoryBudget->segmentInfo(MemoryBudget::Segment::NonLocal);
     stream << "System Memory:\n"
-         << "Budget: " << videoMemoryInfo.Budget << " bytes" << endl
-         << "AvailableForReservation: " << videoMemoryInfo.AvailableForReservation << " bytes" << endl
-         << "CurrantUsage: " << videoMemoryInfo.CurrentUsage << " bytes" << endl;
+         << "Budget: " << systemMemoryInfo.budget << " bytes" << endl
+         << "AvailableForReservation: " << systemMemoryInfo.availableForReservation << " bytes" << endl
+         << "CurrentUsage: " << systemMemoryInfo.currentUsage << " bytes" << endl;
     stream << endl;
 
 	LOG_INFO ("Query Video Memory\n%s", stream.str ().c_str ());
@@ -58,7 +60,18 @@ void QueryVideoMemoryDemo::OutputMemoryBudgets()
 //---------------------------------------------------------------------------------------
 void QueryVideoMemoryDemo::Update()
 {
-
+	// The budget is polled every frame, and changes as other processes allocate.
+	const MemoryBudget::SegmentInfo & videoMemoryInfo =
+		m_memoryBudget->segmentInfo(MemoryBudget::Segment::Local);
+
+	char text[128];
+	sprintf_s(text, "Video memory %.1f / %.1f MB",
+		videoMemoryInfo.currentUsage / (1024.0 * 1024.0),
+		videoMemoryInfo.budget / (1024.0 * 1024.0));
+	if (m_memoryText != text) {
+		m_memoryText = text;
+		SetCustomWindowText(text);
+	}
 }
 
 //---------------------------------------------------------------------------------------
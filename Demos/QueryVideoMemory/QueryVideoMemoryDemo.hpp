@@ -26,4 +26,7 @@ public:
 
 	void OutputMemoryBudgets();
 
+private:
+	// Memory usage last shown in the window title.
+	std::string m_memoryText;
 };
@@ -0,0 +1,224 @@
+//
+// AtomicLinearAllocatorTest.cpp
+//
+#include "Common/AtomicLinearAllocator.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+const uint NumThreads = 8;
+const size_t ChunkSize = 4096;
+
+struct Allocation {
+	size_t offset;
+	size_t size;
+	size_t alignment;
+};
+
+// Blocks threads until all of them have arrived, then releases them together.
+class Barrier {
+public:
+	explicit Barrier (
+		uint numThreads
+	)
+		: m_numThreads(numThreads),
+		  m_numWaiting(0),
+		  m_phase(0)
+	{
+
+	}
+
+	void arriveAndWait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		const uint64 phase = m_phase;
+		if (++m_numWaiting == m_numThreads) {
+			m_numWaiting = 0;
+			++m_phase;
+			m_condition.notify_all();
+		} else {
+			m_condition.wait(lock, [&] { return m_phase != phase; });
+		}
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	uint m_numThreads;
+	uint m_numWaiting;
+	uint64 m_phase;
+};
+
+// Chunk cached per thread across allocators and resets, as ResourceUploadBuffer does.
+thread_local AtomicLinearAllocator::Chunk t_chunk;
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+// Randomly sized and aligned allocations, alternating between the thread's chunk and
+// the shared offset, until 'numAllocations' are made or the allocator is full.
+static void allocateRandomly (
+	AtomicLinearAllocator & allocator,
+	AtomicLinearAllocator::Chunk & chunk,
+	uint seed,
+	uint numAllocations,
+	std::vector<Allocation> & allocations
+) {
+	uint random = seed * 7919 + 1;
+	for (uint i = 0; i < numAllocations; ++i) {
+		random = random * 1103515245 + 12345;
+		const size_t size = 1 + (random >> 8) % 3000;
+		const size_t alignment = size_t(1) << ((random >> 20) % 9);
+
+		const size_t offset = (i & 1) ?
+			allocator.allocate(chunk, ChunkSize, size, alignment) :
+			allocator.allocate(size, alignment);
+		if (offset == AtomicLinearAllocator::InvalidOffset) {
+			break;
+		}
+		allocations.push_back(Allocation{offset, size, alignment});
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static void checkDisjoint (
+	std::vector<Allocation> allocations,
+	size_t capacity
+) {
+	std::sort(allocations.begin(), allocations.end(),
+		[](const Allocation & a, const Allocation & b) { return a.offset < b.offset; });
+
+	for (size_t i = 0; i < allocations.size(); ++i) {
+		CHECK(allocations[i].offset % allocations[i].alignment == 0);
+		CHECK(allocations[i].offset + allocations[i].size <= capacity);
+		if (i > 0) {
+			CHECK(allocations[i - 1].offset + allocations[i - 1].size <= allocations[i].offset);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+static void testConcurrentAllocations()
+{
+	AtomicLinearAllocator allocator(64 << 20);
+
+	std::vector<std::vector<Allocation>> allocations(NumThreads);
+	std::vector<std::thread> threads;
+	for (uint thread = 0; thread < NumThreads; ++thread) {
+		threads.emplace_back([&, thread] {
+			AtomicLinearAllocator::Chunk chunk;
+			allocateRandomly(allocator, chunk, thread, 20000, allocations[thread]);
+		});
+	}
+	for (std::thread & thread : threads) {
+		thread.join();
+	}
+
+	std::vector<Allocation> all;
+	for (const auto & threadAllocations : allocations) {
+		all.insert(all.end(), threadAllocations.begin(), threadAllocations.end());
+	}
+
+	// The allocator must have run out, so that the out of space path was hit.
+	CHECK(all.size() < NumThreads * 20000);
+	checkDisjoint(all, allocator.capacity());
+}
+
+//---------------------------------------------------------------------------------------
+// Threads keep their thread_local chunk while the allocator is reset, or destroyed and
+// recreated at the same address.  A stale chunk would hand out space overlapping the
+// new generation's allocations.
+static void testChunksAcrossGenerations()
+{
+	const uint numGenerations = 64;
+	const size_t capacity = 1 << 20;
+
+	std::aligned_storage<sizeof(AtomicLinearAllocator), alignof(AtomicLinearAllocator)>::type storage;
+	AtomicLinearAllocator * allocator = new (&storage) AtomicLinearAllocator(capacity);
+
+	std::vector<std::vector<Allocation>> allocations(NumThreads);
+	Barrier barrier(NumThreads + 1);
+
+	std::vector<std::thread> threads;
+	for (uint thread = 0; thread < NumThreads; ++thread) {
+		threads.emplace_back([&, thread] {
+			for (uint generation = 0; generation < numGenerations; ++generation) {
+				barrier.arriveAndWait();
+				allocateRandomly (
+					*allocator, t_chunk, generation * NumThreads + thread, 64, allocations[thread]
+				);
+				barrier.arriveAndWait();
+			}
+		});
+	}
+
+	for (uint generation = 0; generation < numGenerations; ++generation) {
+		barrier.arriveAndWait();
+		barrier.arriveAndWait();
+
+		std::vector<Allocation> all;
+		for (auto & threadAllocations : allocations) {
+			all.insert(all.end(), threadAllocations.begin(), threadAllocations.end());
+			threadAllocations.clear();
+		}
+		CHECK(!all.empty());
+		checkDisjoint(all, capacity);
+
+		// Recreate twice in a row too, as a fresh allocator then follows another.
+		if (generation % 3 == 0) {
+			allocator->reset();
+		} else {
+			allocator->~AtomicLinearAllocator();
+			allocator = new (&storage) AtomicLinearAllocator(capacity);
+		}
+		CHECK(allocator->usedBytes() == 0);
+	}
+
+	for (std::thread & thread : threads) {
+		thread.join();
+	}
+	allocator->~AtomicLinearAllocator();
+}
+
+//---------------------------------------------------------------------------------------
+static void testGenerations()
+{
+	AtomicLinearAllocator a(1024);
+	AtomicLinearAllocator b(1024);
+	CHECK(a.generation() != b.generation());
+	CHECK(a.generation() != AtomicLinearAllocator::Chunk().generation);
+
+	// A chunk filled by 'a' is not used by 'b'.
+	AtomicLinearAllocator::Chunk chunk;
+	CHECK(a.allocate(chunk, 256, 16, 1) == 0);
+	CHECK(b.allocate(16, 1) == 0);
+	CHECK(b.allocate(chunk, 256, 16, 1) == 16);
+	CHECK(b.usedBytes() == 16 + 256);
+
+	const uint64 generation = b.generation();
+	b.reset();
+	CHECK(b.generation() != generation);
+	CHECK(b.allocate(chunk, 256, 16, 1) == 0);
+	CHECK(b.allocate(chunk, 256, 16, 1) == 16);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testGenerations);
+	RUN_TEST(testConcurrentAllocations);
+	RUN_TEST(testChunksAcrossGenerations);
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+//
+// BlockCompressionBenchmark.cpp
+//
+// Times BlockCompression on a 1024x1024 image for every format, single threaded and
+// across a JobSystem.
+//
+#include "Common/BlockCompression.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Common/JobSystem.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	const uint width = 1024;
+	const uint height = 1024;
+	const double megapixels = width * double(height) * 1.0e-6;
+
+	// Gradients with noise, so that blocks are neither flat nor random.
+	std::mt19937 random(1);
+	std::vector<byte> pixels(size_t(width) * height * 4);
+	for (uint y = 0; y < height; ++y) {
+		for (uint x = 0; x < width; ++x) {
+			byte * pixel = &pixels[(size_t(y) * width + x) * 4];
+			pixel[0] = byte(x * 200 / width + random() % 16);
+			pixel[1] = byte(y * 200 / height + random() % 16);
+			pixel[2] = byte(128 + 100 * std::sin((x + y) * 0.02));
+			pixel[3] = byte(255 - (x + y) * 255 / (width + height));
+		}
+	}
+	const ImageView source = { pixels.data(), size_t(width) * 4, width, height };
+
+	JobSystem jobSystem;
+	std::printf("%ux%u, throughput in megapixels per second\n", width, height);
+
+	const struct {
+		BlockCompression::Format format;
+		const char * name;
+	} formats[] = {
+		{ BlockCompression::Format::BC1, "BC1" },
+		{ BlockCompression::Format::BC3, "BC3" },
+		{ BlockCompression::Format::BC7, "BC7" }
+	};
+	for (const auto & format : formats) {
+		const size_t rowPitch = size_t(BlockCompression::numBlocks(width)) *
+			BlockCompression::blockBytes(format.format);
+		std::vector<byte> blocks(rowPitch * BlockCompression::numBlocks(height));
+		const ImageDestination destination = { blocks.data(), rowPitch, blocks.size() };
+
+		const double singleSeconds = timeFastest(3, [&] {
+			BlockCompression::compress(source, format.format, destination, nullptr);
+		});
+		const double parallelSeconds = timeFastest(3, [&] {
+			BlockCompression::compress(source, format.format, destination, &jobSystem);
+		});
+
+		std::printf("  %s  1 thread %7.1f MP/s, %2u workers %7.1f MP/s\n", format.name,
+			megapixels / singleSeconds, jobSystem.numWorkerThreads(), megapixels / parallelSeconds);
+	}
+
+	return 0;
+}
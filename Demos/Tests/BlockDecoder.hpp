@@ -0,0 +1,157 @@
+//
+// BlockDecoder.hpp
+//
+#pragma once
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Decoders for the block formats written by BlockCompression, used to measure its
+* quality.  Each decodes one block into 16 RGBA pixels in row-major order.  BC7 only
+* supports mode 6, the single mode the encoder uses.
+*/
+namespace BlockDecoder {
+
+	/// Expands a 5 or 6-bit channel to 8 bits by replicating its high bits.
+	inline uint expandBits (
+		uint value,
+		uint numBits
+	) {
+		return (value << (8 - numBits)) | (value >> (2 * numBits - 8));
+	}
+
+	/// @param isOpaqueOnly - true for the color block of BC3, which always uses the 4
+	/// color mode.
+	inline void decodeBc1 (
+		const byte * block,
+		bool isOpaqueOnly,
+		byte pixels[16][4]
+	) {
+		const uint color0 = block[0] | (block[1] << 8);
+		const uint color1 = block[2] | (block[3] << 8);
+		const uint32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32(block[7]) << 24);
+
+		uint palette[4][4];
+		const uint colors[2] = { color0, color1 };
+		for (uint i = 0; i < 2; ++i) {
+			palette[i][0] = expandBits((colors[i] >> 11) & 0x1f, 5);
+			palette[i][1] = expandBits((colors[i] >> 5) & 0x3f, 6);
+			palette[i][2] = expandBits(colors[i] & 0x1f, 5);
+			palette[i][3] = 255;
+		}
+		for (uint c = 0; c < 3; ++c) {
+			if (color0 > color1 || isOpaqueOnly) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			} else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = (color0 > color1 || isOpaqueOnly) ? 255 : 0;
+
+		for (uint i = 0; i < 16; ++i) {
+			const uint index = (indices >> (i * 2)) & 3;
+			for (uint c = 0; c < 4; ++c) {
+				pixels[i][c] = byte(palette[index][c]);
+			}
+		}
+	}
+
+	inline void decodeBc3 (
+		const byte * block,
+		byte pixels[16][4]
+	) {
+		decodeBc1(block + 8, true, pixels);
+
+		const uint alpha0 = block[0];
+		const uint alpha1 = block[1];
+		uint palette[8] = { alpha0, alpha1 };
+		if (alpha0 > alpha1) {
+			for (uint i = 1; i < 7; ++i) {
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+		} else {
+			for (uint i = 1; i < 5; ++i) {
+				palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64 indices = 0;
+		for (uint i = 0; i < 6; ++i) {
+			indices |= uint64(block[2 + i]) << (i * 8);
+		}
+		for (uint i = 0; i < 16; ++i) {
+			pixels[i][3] = byte(palette[(indices >> (i * 3)) & 7]);
+		}
+	}
+
+	/// Reads fields of a 128-bit block from its least significant bit upwards.
+	class BitReader {
+	public:
+		explicit BitReader (
+			const byte * block
+		)
+			: m_block(block),
+			  m_position(0)
+		{
+
+		}
+
+		uint read (
+			uint numBits
+		) {
+			uint value = 0;
+			for (uint i = 0; i < numBits; ++i, ++m_position) {
+				value |= ((m_block[m_position / 8] >> (m_position % 8)) & 1) << i;
+			}
+			return value;
+		}
+
+	private:
+		const byte * m_block;
+		uint m_position;
+	};
+
+	/// @return false if the block is not mode 6.
+	inline bool decodeBc7 (
+		const byte * block,
+		byte pixels[16][4]
+	) {
+		static const uint weights[16] = {
+			0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+		};
+
+		BitReader reader(block);
+		if (reader.read(7) != 0x40) {
+			return false;
+		}
+
+		uint endpoints[2][4];
+		for (uint c = 0; c < 4; ++c) {
+			endpoints[0][c] = reader.read(7) << 1;
+			endpoints[1][c] = reader.read(7) << 1;
+		}
+		for (uint e = 0; e < 2; ++e) {
+			const uint pBit = reader.read(1);
+			for (uint c = 0; c < 4; ++c) {
+				endpoints[e][c] |= pBit;
+			}
+		}
+
+		// The anchor index has its implicit high bit dropped.
+		for (uint i = 0; i < 16; ++i) {
+			const uint index = reader.read(i == 0 ? 3 : 4);
+			for (uint c = 0; c < 4; ++c) {
+				pixels[i][c] = byte(((64 - weights[index]) * endpoints[0][c] +
+					weights[index] * endpoints[1][c] + 32) >> 6);
+			}
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,381 @@
+//
+// DdsFileTest.cpp
+//
+#include "Common/DdsFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Common/BlockCompression.hpp"
+#include "Common/ImageDecoder.hpp"
+#include "Common/JobSystem.hpp"
+#include "Common/MappedFile.hpp"
+#include "Common/MipGenerator.hpp"
+#include "Common/TextureBaker.hpp"
+#include "PngWriter.hpp"
+#include "TestUtils.hpp"
+
+
+namespace {
+
+const char * const DdsPath = "DdsFileTest.dds";
+
+// Offsets into a file written with the DX10 header, after the 4 byte magic.
+const size_t HeaderSizeOffset = 4;
+const size_t HeightOffset = 12;
+const size_t WidthOffset = 16;
+const size_t MipMapCountOffset = 28;
+const size_t PixelFormatSizeOffset = 76;
+const size_t FourCCOffset = 84;
+const size_t Caps2Offset = 112;
+const size_t DxgiFormatOffset = 128;
+const size_t ResourceDimensionOffset = 132;
+const size_t MiscFlagOffset = 136;
+const size_t ArraySizeOffset = 140;
+const size_t DataOffset = 148;
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static void writeFile (
+	const char * path,
+	const void * data,
+	size_t numBytes
+) {
+	FILE * file = std::fopen(path, "wb");
+	CHECK(file);
+	CHECK(std::fwrite(data, 1, numBytes, file) == numBytes);
+	CHECK(std::fclose(file) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+static std::vector<byte> readFile (
+	const char * path
+) {
+	MappedFile file;
+	CHECK(file.open(path));
+	return std::vector<byte>(file.data(), file.data() + file.size());
+}
+
+//---------------------------------------------------------------------------------------
+static void writeUint32 (
+	std::vector<byte> & file,
+	size_t offset,
+	uint32 value
+) {
+	std::memcpy(&file[offset], &value, sizeof(value));
+}
+
+//---------------------------------------------------------------------------------------
+// PNG of a 'width' x 'height' RGBA gradient with varying alpha.
+static std::vector<byte> createPng (
+	uint width,
+	uint height
+) {
+	PngWriter::Image image = {};
+	image.width = width;
+	image.height = height;
+	image.bitDepth = 8;
+	image.colorType = PngWriter::ColorType_Rgba;
+	for (uint y = 0; y < height; ++y) {
+		for (uint x = 0; x < width; ++x) {
+			const byte pixel[4] = {
+				byte(x * 255 / width), byte(y * 255 / height), byte((x ^ y) * 4), byte(255 - x * 2)
+			};
+			image.scanlines.insert(image.scanlines.end(), pixel, pixel + 4);
+		}
+	}
+	return PngWriter::write(image, PngWriter::Filter_EachRow);
+}
+
+//---------------------------------------------------------------------------------------
+// Returns false if opening 'file' as a DDS file throws.
+static bool tryOpen (
+	const std::vector<byte> & file
+) {
+	writeFile(DdsPath, file.data(), file.size());
+	MappedDds dds;
+	try {
+		CHECK(dds.open(DdsPath));
+		return true;
+	} catch (const std::runtime_error &) {
+		CHECK(!dds.isOpen());
+		return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Checks that the subresources of 'dds' follow each other in D3D12 subresource order,
+// laid out as subresourceLayout() describes.
+static void checkSubresourceLayout (
+	const MappedDds & dds
+) {
+	const DdsFile::Description & description = dds.description();
+	CHECK(dds.numSubresources() == description.arraySize * description.numMipLevels);
+
+	const byte * next = dds.subresource(0, 0).data;
+	for (uint slice = 0; slice < description.arraySize; ++slice) {
+		for (uint level = 0; level < description.numMipLevels; ++level) {
+			const DdsFile::Subresource & subresource = dds.subresource(level, slice);
+			const DdsFile::Subresource layout = DdsFile::subresourceLayout(description, level);
+			CHECK(subresource.data == next);
+			CHECK(subresource.rowPitch == layout.rowPitch);
+			CHECK(subresource.rowBytes == layout.rowBytes);
+			CHECK(subresource.numRows == layout.numRows);
+			CHECK(subresource.width == layout.width && subresource.height == layout.height);
+			next += subresource.rowBytes * subresource.numRows;
+		}
+	}
+	CHECK(next == dds.subresource(0, 0).data + dds.dataSize());
+}
+
+//---------------------------------------------------------------------------------------
+// Baking a generated image and reading it back gives the formats, layouts and data
+// that decoding, filtering and compressing it directly does, for every compression,
+// and sides that can't be block compressed.
+static void testBakeRoundTrip()
+{
+	struct Case {
+		uint width;
+		uint height;
+		TextureBaker::Compression compression;
+		bool isSrgb;
+		bool generateMips;
+		uint32 dxgiFormat;
+	};
+	const Case cases[] = {
+		{ 64, 48, TextureBaker::Compression::BC7, true, true, DdsFile::DxgiFormat::BC7_UNORM_SRGB },
+		{ 64, 48, TextureBaker::Compression::BC7, false, true, DdsFile::DxgiFormat::BC7_UNORM },
+		{ 64, 48, TextureBaker::Compression::BC3, true, true, DdsFile::DxgiFormat::BC3_UNORM_SRGB },
+		{ 64, 48, TextureBaker::Compression::BC1, false, false, DdsFile::DxgiFormat::BC1_UNORM },
+		{ 64, 48, TextureBaker::Compression::None, true, true, DdsFile::DxgiFormat::R8G8B8A8_UNORM_SRGB },
+		{ 30, 18, TextureBaker::Compression::BC7, true, true, DdsFile::DxgiFormat::R8G8B8A8_UNORM_SRGB }
+	};
+
+	JobSystem jobSystem(2);
+	for (const Case & c : cases) {
+		const std::vector<byte> png = createPng(c.width, c.height);
+
+		TextureBaker::Options options;
+		options.compression = c.compression;
+		options.isSrgb = c.isSrgb;
+		options.generateMips = c.generateMips;
+		const DdsFile::BakeInfo bakeInfo = { 11, png.size(), 33, TextureBaker::hashOptions(options) };
+		TextureBaker::bake(png.data(), png.size(), DdsPath, options, bakeInfo, &jobSystem);
+
+		MappedDds dds;
+		CHECK(dds.open(DdsPath));
+		const DdsFile::Description & description = dds.description();
+		CHECK(description.width == c.width && description.height == c.height);
+		CHECK(description.arraySize == 1 && !description.isCubemap);
+		CHECK(description.dxgiFormat == c.dxgiFormat);
+		const uint numLevels = c.generateMips ? MipGenerator::numMipLevels(c.width, c.height) : 1;
+		CHECK(description.numMipLevels == numLevels);
+
+		CHECK(dds.bakeInfo() != nullptr);
+		CHECK(std::memcmp(dds.bakeInfo(), &bakeInfo, sizeof(bakeInfo)) == 0);
+
+		checkSubresourceLayout(dds);
+		DdsFile::FormatInfo formatInfo;
+		CHECK(DdsFile::getFormatInfo(description.dxgiFormat, formatInfo));
+		const DdsFile::Subresource & top = dds.subresource(0);
+		CHECK(top.rowBytes == size_t(c.width + formatInfo.blockSize - 1) / formatInfo.blockSize * formatInfo.blockBytes);
+
+		// The same steps without the baker, on the calling thread.
+		std::vector<std::vector<byte>> images(numLevels);
+		std::vector<ImageDestination> levels(numLevels);
+		for (uint level = 0; level < numLevels; ++level) {
+			const uint width = MipGenerator::mipSize(c.width, level);
+			const uint height = MipGenerator::mipSize(c.height, level);
+			images[level].resize(size_t(width) * height * 4);
+			levels[level] = { images[level].data(), size_t(width) * 4, images[level].size() };
+		}
+		ImageDecoder decoder;
+		decoder.decode(png.data(), png.size(), levels[0]);
+		const ImageView image = { images[0].data(), levels[0].rowPitch, c.width, c.height };
+		MipGenerator::generateMipChain(image, levels.data(), numLevels, c.isSrgb, nullptr);
+
+		for (uint level = 0; level < numLevels; ++level) {
+			const DdsFile::Subresource & subresource = dds.subresource(level);
+			std::vector<byte> expected = images[level];
+			if (formatInfo.blockSize > 1) {
+				const BlockCompression::Format format =
+					c.compression == TextureBaker::Compression::BC1 ? BlockCompression::Format::BC1 :
+					c.compression == TextureBaker::Compression::BC3 ? BlockCompression::Format::BC3 :
+					BlockCompression::Format::BC7;
+				expected.assign(subresource.rowBytes * subresource.numRows, 0);
+				const ImageView levelImage = {
+					images[level].data(), levels[level].rowPitch, subresource.width, subresource.height
+				};
+				const ImageDestination destination = {
+					expected.data(), subresource.rowPitch, expected.size()
+				};
+				BlockCompression::compress(levelImage, format, destination, nullptr);
+			}
+			CHECK(expected.size() == subresource.rowBytes * subresource.numRows);
+			CHECK(std::memcmp(subresource.data, expected.data(), expected.size()) == 0);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Arrays and cubemaps are written and read back in subresource order, and legacy
+// headers without the DX10 extension are read.
+static void testArraysAndLegacyHeaders()
+{
+	for (bool isCubemap : { false, true }) {
+		DdsFile::Description description = {};
+		description.width = 12;
+		description.height = isCubemap ? 12 : 6;
+		description.arraySize = isCubemap ? 12 : 3;
+		description.numMipLevels = 3;
+		description.dxgiFormat = DdsFile::DxgiFormat::BC1_UNORM;
+		description.isCubemap = isCubemap;
+
+		// Each subresource filled with its index.
+		std::vector<std::vector<byte>> contents;
+		std::vector<DdsFile::Subresource> subresources;
+		for (uint slice = 0; slice < description.arraySize; ++slice) {
+			for (uint level = 0; level < description.numMipLevels; ++level) {
+				DdsFile::Subresource subresource = DdsFile::subresourceLayout(description, level);
+				contents.emplace_back(subresource.rowBytes * subresource.numRows, byte(contents.size()));
+				subresource.data = contents.back().data();
+				subresources.push_back(subresource);
+			}
+		}
+		DdsFile::write(DdsPath, description, subresources.data(), nullptr);
+
+		MappedDds dds;
+		CHECK(dds.open(DdsPath));
+		CHECK(dds.bakeInfo() == nullptr);
+		CHECK(dds.description().isCubemap == isCubemap);
+		CHECK(dds.description().arraySize == description.arraySize);
+		checkSubresourceLayout(dds);
+		for (uint slice = 0; slice < description.arraySize; ++slice) {
+			for (uint level = 0; level < description.numMipLevels; ++level) {
+				const uint index = slice * description.numMipLevels + level;
+				const DdsFile::Subresource & subresource = dds.subresource(level, slice);
+				CHECK(std::memcmp(subresource.data, contents[index].data(), contents[index].size()) == 0);
+			}
+		}
+	}
+
+	// Cube faces must be square, even where the data would fit.
+	const std::vector<byte> file = readFile(DdsPath);
+	std::vector<byte> patched = file;
+	writeUint32(patched, HeightOffset, 6);
+	CHECK(!tryOpen(patched));
+
+	// The first cube of the last file as a legacy DXT1 cubemap, whose faces each hold
+	// 3x3, 2x2 and 1x1 blocks.
+	const size_t faceBytes = (9 + 4 + 1) * 8;
+	std::vector<byte> legacy(file.begin(), file.begin() + DxgiFormatOffset);
+	legacy.insert(legacy.end(), file.begin() + DataOffset, file.begin() + DataOffset + 6 * faceBytes);
+	std::memcpy(&legacy[FourCCOffset], "DXT1", 4);
+	writeFile(DdsPath, legacy.data(), legacy.size());
+
+	MappedDds dds;
+	CHECK(dds.open(DdsPath));
+	CHECK(dds.description().dxgiFormat == DdsFile::DxgiFormat::BC1_UNORM);
+	CHECK(dds.description().isCubemap && dds.description().arraySize == 6);
+	CHECK(dds.description().numMipLevels == 3);
+	checkSubresourceLayout(dds);
+	CHECK(std::memcmp(dds.subresource(0, 0).data, &file[DataOffset], legacy.size() - DxgiFormatOffset) == 0);
+
+	// Missing faces, and volume textures.
+	patched = legacy;
+	writeUint32(patched, Caps2Offset, 0x200 | 0x400);
+	CHECK(!tryOpen(patched));
+	patched = legacy;
+	writeUint32(patched, Caps2Offset, 0x200000);
+	CHECK(!tryOpen(patched));
+}
+
+//---------------------------------------------------------------------------------------
+// Malformed headers and truncated files throw, leaving the MappedDds closed.
+static void testMalformedHeaders()
+{
+	const std::vector<byte> png = createPng(16, 16);
+	TextureBaker::Options options;
+	options.compression = TextureBaker::Compression::BC1;
+	TextureBaker::bake(png.data(), png.size(), DdsPath, options, DdsFile::BakeInfo(), nullptr);
+	const std::vector<byte> file = readFile(DdsPath);
+	CHECK(file.size() == DataOffset + 8 * (16 + 4 + 1 + 1 + 1));
+	CHECK(tryOpen(file));
+
+	struct Patch {
+		size_t offset;
+		uint32 value;
+	};
+	const Patch patches[] = {
+		{ 0, 0x20534445 },                       // Magic
+		{ HeaderSizeOffset, 128 },
+		{ PixelFormatSizeOffset, 0 },
+		{ WidthOffset, 0 },
+		{ HeightOffset, 0 },
+		{ WidthOffset, 16385 },                  // Beyond D3D12 limits
+		{ MipMapCountOffset, 6 },                // More levels than halvings
+		{ MipMapCountOffset, 0xffffffff },
+		{ DxgiFormatOffset, 0 },                 // Unknown formats
+		{ DxgiFormatOffset, 95 },
+		{ ResourceDimensionOffset, 4 },          // Volume
+		{ ResourceDimensionOffset, 1 },          // Buffer
+		{ ResourceDimensionOffset, 0 },
+		{ ArraySizeOffset, 0 },
+		{ ArraySizeOffset, 2049 },
+		{ ArraySizeOffset, 2 }                   // Slices missing
+	};
+	for (const Patch & patch : patches) {
+		std::vector<byte> patched = file;
+		writeUint32(patched, patch.offset, patch.value);
+		CHECK(!tryOpen(patched));
+	}
+
+	// Cube counts that wrap around once multiplied by 6.
+	std::vector<byte> patched = file;
+	writeUint32(patched, MiscFlagOffset, 0x4);
+	writeUint32(patched, ArraySizeOffset, 0x2aaaaaab);
+	CHECK(!tryOpen(patched));
+
+	for (size_t length = 0; length < file.size(); ++length) {
+		CHECK(!tryOpen(std::vector<byte>(file.begin(), file.begin() + length)));
+	}
+
+	// Writing rejects what reading would.
+	DdsFile::Description description = {};
+	description.width = 16;
+	description.height = 8;
+	description.arraySize = 6;
+	description.numMipLevels = 1;
+	description.dxgiFormat = DdsFile::DxgiFormat::R8G8B8A8_UNORM;
+	description.isCubemap = true;
+	std::vector<byte> pixels(16 * 8 * 4);
+	std::vector<DdsFile::Subresource> subresources(6, DdsFile::subresourceLayout(description, 0));
+	for (DdsFile::Subresource & subresource : subresources) {
+		subresource.data = pixels.data();
+	}
+	bool hasThrown = false;
+	try {
+		DdsFile::write(DdsPath, description, subresources.data(), nullptr);
+	} catch (const std::runtime_error &) {
+		hasThrown = true;
+	}
+	CHECK(hasThrown);
+
+	MappedDds dds;
+	CHECK(!dds.open("DdsFileTest.missing.dds"));
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testBakeRoundTrip);
+	RUN_TEST(testArraysAndLegacyHeaders);
+	RUN_TEST(testMalformedHeaders);
+
+	std::remove(DdsPath);
+	return 0;
+}
@@ -0,0 +1,231 @@
+//
+// GpuProfilerTest.cpp
+//
+#include "Common/GpuProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+// Ticks per second of the synthetic timestamps, one per microsecond.
+const uint64 Frequency = 1000000;
+
+// Stands in for the query heap and the readback buffer it is resolved into, with a
+// clock that only advances when told to.
+class SyntheticGpu {
+public:
+	explicit SyntheticGpu (
+		const GpuProfiler & profiler
+	)
+		: m_queryHeap(profiler.numQueries()),
+		  m_readback(profiler.numQueries()),
+		  m_time(0)
+	{
+
+	}
+
+	/// Advances the clock by 'ticks', then writes it to 'query' unless it is invalid.
+	void timestamp (
+		uint query,
+		uint64 ticks
+	) {
+		m_time += ticks;
+		if (query != GpuProfiler::InvalidQuery) {
+			CHECK(query < m_queryHeap.size());
+			m_queryHeap[query] = m_time;
+		}
+	}
+
+	void resolve (
+		uint firstQuery,
+		uint numQueries
+	) {
+		for (uint i = firstQuery; i < firstQuery + numQueries; ++i) {
+			m_readback[i] = m_queryHeap[i];
+		}
+	}
+
+	const uint64 * readback (
+		uint firstQuery
+	) const {
+		return &m_readback[firstQuery];
+	}
+
+private:
+	std::vector<uint64> m_queryHeap;
+	std::vector<uint64> m_readback;
+	uint64 m_time;
+};
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static bool isNear (
+	double a,
+	double b
+) {
+	return std::fabs(a - b) < 1.0e-9;
+}
+
+//---------------------------------------------------------------------------------------
+static void testZones()
+{
+	GpuProfiler::Settings settings;
+	settings.maxZonesPerFrame = 4;
+	GpuProfiler profiler(settings);
+
+	const GpuProfiler::ZoneId frame = profiler.registerZone("Frame");
+	const GpuProfiler::ZoneId shadows = profiler.registerZone("Shadows");
+	CHECK(profiler.registerZone("Frame") == frame);
+	CHECK(profiler.numZones() == 2);
+	CHECK(std::string(profiler.zoneName(shadows)) == "Shadows");
+	CHECK(profiler.numQueries() == 3 * 8);
+	CHECK(profiler.zoneStatistics(frame).numSamples == 0);
+
+	// Pairs of queries are handed out from the slot's range, until it runs out.
+	profiler.beginFrame(1);
+	CHECK(profiler.beginZone(frame) == 8);
+	for (uint i = 0; i < 3; ++i) {
+		CHECK(profiler.beginZone(shadows) == 10 + 2 * i);
+		CHECK(profiler.endZone(shadows) == 11 + 2 * i);
+	}
+	CHECK(profiler.beginZone(shadows) == GpuProfiler::InvalidQuery);
+	CHECK(profiler.endZone(shadows) == GpuProfiler::InvalidQuery);
+	CHECK(profiler.endZone(frame) == 9);
+
+	uint firstQuery;
+	uint numQueries;
+	profiler.endFrame(&firstQuery, &numQueries);
+	CHECK(firstQuery == 8 && numQueries == 8);
+	CHECK(profiler.isPending(1));
+	CHECK(!profiler.isPending(0));
+}
+
+//---------------------------------------------------------------------------------------
+// Frames recorded into a ring of slots and resolved when their slot is reused, with
+// nested zones and a zone entered twice per frame.
+static void testResolve()
+{
+	GpuProfiler::Settings settings;
+	settings.numFrameSlots = 3;
+	settings.maxZonesPerFrame = 4;
+	settings.historyLength = 8;
+	GpuProfiler profiler(settings);
+	SyntheticGpu gpu(profiler);
+
+	const GpuProfiler::ZoneId frame = profiler.registerZone("Frame");
+	const GpuProfiler::ZoneId prepare = profiler.registerZone("Prepare");
+	const GpuProfiler::ZoneId render = profiler.registerZone("Render");
+	const GpuProfiler::ZoneId unused = profiler.registerZone("Unused");
+
+	const uint numFrames = 20;
+	for (uint frameIndex = 0; frameIndex < numFrames; ++frameIndex) {
+		const uint slot = frameIndex % settings.numFrameSlots;
+		if (profiler.isPending(slot)) {
+			profiler.resolveFrame(slot, gpu.readback(slot * profiler.maxQueriesPerFrame()), Frequency);
+		}
+
+		profiler.beginFrame(slot);
+		gpu.timestamp(profiler.beginZone(frame), 0);
+		gpu.timestamp(profiler.beginZone(prepare), 0);
+		gpu.timestamp(profiler.endZone(prepare), 100);
+		gpu.timestamp(profiler.beginZone(render), 0);
+		gpu.timestamp(profiler.endZone(render), 1000 + frameIndex * 10);
+		gpu.timestamp(profiler.beginZone(render), 0);
+		gpu.timestamp(profiler.endZone(render), 500);
+		gpu.timestamp(profiler.endZone(frame), 50);
+
+		uint firstQuery;
+		uint numQueries;
+		profiler.endFrame(&firstQuery, &numQueries);
+		CHECK(firstQuery == slot * profiler.maxQueriesPerFrame() && numQueries == 8);
+		gpu.resolve(firstQuery, numQueries);
+	}
+
+	// Frames 0 to 16 are resolved, and the history keeps 9 to 16, during which
+	// Render takes 1.5 ms plus 10 us per frame.
+	CHECK(profiler.numResolvedFrames() == numFrames - settings.numFrameSlots);
+	const GpuProfiler::ZoneStatistics renderStatistics = profiler.zoneStatistics(render);
+	CHECK(renderStatistics.numSamples == 8);
+	CHECK(isNear(renderStatistics.minMs, 1.59));
+	CHECK(isNear(renderStatistics.maxMs, 1.66));
+	CHECK(isNear(renderStatistics.avgMs, 1.625));
+
+	const GpuProfiler::ZoneStatistics prepareStatistics = profiler.zoneStatistics(prepare);
+	CHECK(isNear(prepareStatistics.minMs, 0.1) && isNear(prepareStatistics.maxMs, 0.1));
+	CHECK(isNear(profiler.zoneStatistics(frame).avgMs, 0.1 + renderStatistics.avgMs + 0.05));
+	CHECK(profiler.zoneStatistics(unused).numSamples == 0);
+
+	// Beginning a slot whose frame was never resolved discards it.
+	profiler.beginFrame(numFrames % settings.numFrameSlots);
+	uint firstQuery;
+	uint numQueries;
+	profiler.endFrame(&firstQuery, &numQueries);
+	CHECK(numQueries == 0);
+	CHECK(profiler.numResolvedFrames() == numFrames - settings.numFrameSlots);
+}
+
+//---------------------------------------------------------------------------------------
+// Formatted statistics stay within their length, however many zones there are.
+static void testFormatStatistics()
+{
+	GpuProfiler::Settings settings;
+	settings.numFrameSlots = 1;
+	settings.maxZonesPerFrame = 8;
+	GpuProfiler profiler(settings);
+	SyntheticGpu gpu(profiler);
+
+	std::vector<GpuProfiler::ZoneId> zones;
+	zones.push_back(profiler.registerZone("Shadows"));
+	zones.push_back(profiler.registerZone("Opaque"));
+	zones.push_back(profiler.registerZone(std::string(300, 'x').c_str()));
+	zones.push_back(profiler.registerZone("Post"));
+
+	std::string text = "GPU: ";
+	profiler.formatStatistics(text, 100);
+	CHECK(text == "GPU: ");
+
+	profiler.beginFrame(0);
+	for (GpuProfiler::ZoneId zone : zones) {
+		gpu.timestamp(profiler.beginZone(zone), 0);
+		gpu.timestamp(profiler.endZone(zone), 1250);
+	}
+	uint firstQuery;
+	uint numQueries;
+	profiler.endFrame(&firstQuery, &numQueries);
+	gpu.resolve(firstQuery, numQueries);
+	profiler.resolveFrame(0, gpu.readback(firstQuery), Frequency);
+
+	text = "GPU: ";
+	profiler.formatStatistics(text, 1000);
+	CHECK(text.compare(0, 44, "GPU: Shadows 1.25/1.25/1.25, Opaque 1.25/1.2") == 0);
+	CHECK(text.size() == 5 + 22 + 23 + 317 + 21);
+
+	// The long name doesn't fit, so it and the zones after it are left out.
+	text = "GPU: ";
+	profiler.formatStatistics(text, 100);
+	CHECK(text == "GPU: Shadows 1.25/1.25/1.25, Opaque 1.25/1.25/1.25, ...");
+
+	for (size_t maxLength = 0; maxLength < 400; ++maxLength) {
+		text = "GPU: ";
+		profiler.formatStatistics(text, maxLength);
+		CHECK(text.size() <= std::max(maxLength, size_t(5)));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testZones);
+	RUN_TEST(testResolve);
+	RUN_TEST(testFormatStatistics);
+
+	return 0;
+}
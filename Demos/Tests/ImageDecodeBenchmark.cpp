@@ -0,0 +1,126 @@
+//
+// ImageDecodeBenchmark.cpp
+//
+// Times ImageDecoder on the PNG and JPEG files given on the command line, or else on
+// the textures in Assets/Textures, decoding into rows padded to the D3D12 texture
+// pitch alignment as TextureLoader does.  Also times each PixelConversion function
+// on its own.
+//
+#include "Common/ImageDecoder.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Common/MappedFile.hpp"
+#include "Common/PixelConversion.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes the image at 'path' several times with 'decoder', printing the fastest.
+static void benchmarkDecode (
+	const std::string & path,
+	ImageDecoder & decoder
+) {
+	MappedFile file;
+	if (!file.open(path.c_str())) {
+		std::fprintf(stderr, "Unable to open %s\n", path.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+
+	const ImageInfo info = ImageDecoder::readInfo(file.data(), file.size());
+
+	// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT.
+	const size_t rowPitch = (size_t(info.width) * 4 + 255) & ~size_t(255);
+	std::vector<byte> pixels(rowPitch * info.height);
+	ImageDestination destination;
+	destination.data = pixels.data();
+	destination.rowPitch = rowPitch;
+	destination.size = pixels.size();
+
+	const double seconds = timeFastest(5, [&] {
+		decoder.decode(file.data(), file.size(), destination);
+	});
+
+	const size_t slash = path.find_last_of("/\\");
+	const std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+	std::printf("  %-28s %5u x %-5u %8.2f ms, %7.1f MB/s in, %7.1f M pixels/s\n",
+		name.c_str(), info.width, info.height, seconds * 1000.0,
+		file.size() * 1.0e-6 / seconds, double(info.width) * info.height * 1.0e-6 / seconds);
+}
+
+//---------------------------------------------------------------------------------------
+int main (
+	int argc,
+	char ** argv
+) {
+	std::vector<std::string> paths(argv + 1, argv + argc);
+	if (paths.empty()) {
+		paths.push_back(std::string(TEXTURE_ASSETS_DIR) + "/uvgrid.jpg");
+		paths.push_back(std::string(TEXTURE_ASSETS_DIR) + "/low_poly_ship_albedo.png");
+	}
+
+	std::printf("Decoding, single threaded\n");
+	ImageDecoder decoder;
+	for (const std::string & path : paths) {
+		benchmarkDecode(path, decoder);
+	}
+
+	// Sources of 4 bytes per pixel, enough for any of the layouts.
+	const size_t numPixels = 1 << 22;
+	std::vector<byte> source(numPixels * 4);
+	for (size_t i = 0; i < source.size(); ++i) {
+		source[i] = byte(i * 7 + (i >> 9));
+	}
+	std::vector<byte> rgba(numPixels * 4);
+
+	struct Conversion {
+		const char * name;
+		std::function<void()> run;
+	};
+	const Conversion conversions[] = {
+		{ "grayToRgba", [&] {
+			PixelConversion::grayToRgba(source.data(), rgba.data(), numPixels);
+		} },
+		{ "grayAlphaToRgba", [&] {
+			PixelConversion::grayAlphaToRgba(source.data(), rgba.data(), numPixels);
+		} },
+		{ "rgbToRgba", [&] {
+			PixelConversion::rgbToRgba(source.data(), rgba.data(), numPixels);
+		} },
+		{ "yCbCrToRgba", [&] {
+			PixelConversion::yCbCrToRgba (
+				source.data(), source.data() + numPixels, source.data() + numPixels * 2,
+				rgba.data(), numPixels
+			);
+		} }
+	};
+
+	std::printf("Color conversion of %zu pixels\n", numPixels);
+	for (const Conversion & conversion : conversions) {
+		const double seconds = timeFastest(10, conversion.run);
+		std::printf("  %-28s %8.2f ms, %7.1f M pixels/s\n",
+			conversion.name, seconds * 1000.0, numPixels * 1.0e-6 / seconds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,310 @@
+//
+// InflateTest.cpp
+//
+#include "Common/Inflate.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "PngWriter.hpp"
+#include "TestUtils.hpp"
+
+
+namespace {
+
+	// zlib.compress(b"Hello, hello, hello inflate!", 9), a single fixed Huffman block.
+	const byte FixedStream[] = {
+		0x78, 0xda, 0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0xd7, 0x51, 0xc8, 0x40, 0xa2, 0x14, 0x32, 0xf3, 0xd2,
+		0x72, 0x12, 0x4b, 0x52, 0x15, 0x01, 0x8d, 0xda, 0x09, 0xd9
+	};
+
+	// zlib.compress(wordText(1500), 9), a single dynamic Huffman block.
+	const byte DynamicStream[] = {
+		0x78, 0xda, 0x7d, 0x54, 0xd1, 0x0e, 0x83, 0x20, 0x0c, 0xfc, 0x15, 0x7e, 0xcd, 0x4c, 0xdc, 0x58,
+		0xd4, 0x99, 0x45, 0x13, 0x3f, 0x7f, 0xa1, 0x50, 0xb9, 0x9e, 0x65, 0x0f, 0x1b, 0xa1, 0xd0, 0xeb,
+		0x71, 0xbd, 0x9a, 0xd6, 0x69, 0x1e, 0xf6, 0x18, 0x52, 0x5d, 0xb7, 0xf5, 0x19, 0xc6, 0xf8, 0xf8,
+		0x8c, 0x31, 0x2c, 0x69, 0x93, 0x2d, 0x84, 0xea, 0x92, 0x23, 0x9a, 0xf0, 0x3a, 0xa6, 0x69, 0x19,
+		0xd6, 0xf0, 0xde, 0xe2, 0x53, 0x52, 0x34, 0xb0, 0xa5, 0x33, 0xce, 0x61, 0x8f, 0xe7, 0x7e, 0x7c,
+		0x2d, 0x7e, 0x39, 0xc9, 0x77, 0xf5, 0x54, 0x4a, 0x49, 0x14, 0xa1, 0x53, 0x9f, 0x9b, 0xa9, 0x5a,
+		0x32, 0x35, 0x64, 0xa9, 0x66, 0xe4, 0xfc, 0xbb, 0xe8, 0x59, 0x5a, 0xba, 0xca, 0xb1, 0x6e, 0x2c,
+		0x5e, 0xe3, 0x85, 0xdc, 0x18, 0x00, 0x5f, 0x22, 0x60, 0xf2, 0x57, 0x49, 0x5c, 0xc5, 0x39, 0x5b,
+		0x51, 0xb5, 0xd6, 0xf5, 0x52, 0xa9, 0x59, 0xb3, 0x59, 0x42, 0x56, 0x1e, 0x8b, 0xdc, 0xba, 0xe0,
+		0x74, 0x0c, 0xe5, 0x74, 0xdf, 0xdf, 0x64, 0xba, 0x11, 0xe7, 0x35, 0x9f, 0x61, 0x7d, 0xac, 0x63,
+		0x95, 0xae, 0xb7, 0x58, 0x81, 0xc6, 0xda, 0xaa, 0x6e, 0x1a, 0xac, 0x49, 0x77, 0x17, 0xa2, 0x78,
+		0xba, 0xaa, 0x6f, 0xed, 0x6d, 0x4d, 0x42, 0x65, 0x05, 0xdc, 0xd7, 0xbe, 0xf1, 0x32, 0x4c, 0x58,
+		0xd6, 0xe2, 0x8d, 0xe6, 0x10, 0xc7, 0x39, 0x20, 0x91, 0xff, 0x0e, 0x5b, 0x18, 0x9b, 0xe7, 0xa8,
+		0xec, 0x3a, 0xc4, 0x53, 0xa1, 0xd1, 0x41, 0x14, 0x6a, 0x2b, 0x2a, 0xe9, 0xce, 0x85, 0x69, 0x13,
+		0x42, 0x3b, 0xfe, 0xba, 0xac, 0xdf, 0xf1, 0x2d, 0x74, 0x19, 0x67, 0xbf, 0x67, 0x6b, 0x3b, 0x92,
+		0xe0, 0xd5, 0x8e, 0x93, 0x48, 0x5c, 0xda, 0xda, 0xd9, 0xc6, 0x11, 0x20, 0xbb, 0x18, 0x61, 0xf5,
+		0x8c, 0x1b, 0xd2, 0xa1, 0x82, 0x02, 0xd1, 0x07, 0xc7, 0xa0, 0xf3, 0x93, 0xff, 0x8e, 0xae, 0x0b,
+		0xca, 0xdd, 0x26, 0x22, 0xe5, 0xab, 0xf7, 0x03, 0xb2, 0xac, 0x2b, 0xec
+	};
+
+	/// Writes bits least significant first, as DEFLATE reads them.
+	class BitWriter {
+	public:
+		void write (
+			uint value,
+			uint numBits
+		) {
+			for (uint i = 0; i < numBits; ++i) {
+				if (m_numBits % 8 == 0) {
+					m_bytes.push_back(0);
+				}
+				m_bytes.back() |= byte(((value >> i) & 1) << (m_numBits % 8));
+				++m_numBits;
+			}
+		}
+
+		/// Huffman codes are stored most significant bit first.
+		void writeCode (
+			uint code,
+			uint length
+		) {
+			for (uint i = length; i > 0; --i) {
+				write((code >> (i - 1)) & 1, 1);
+			}
+		}
+
+		/// Symbol of the fixed literal/length code.
+		void writeFixedSymbol (
+			uint symbol
+		) {
+			if (symbol < 144) {
+				writeCode(0x30 + symbol, 8);
+			} else if (symbol < 256) {
+				writeCode(0x190 + symbol - 144, 9);
+			} else if (symbol < 280) {
+				writeCode(symbol - 256, 7);
+			} else {
+				writeCode(0xc0 + symbol - 280, 8);
+			}
+		}
+
+		/// The stream so far behind a zlib header, followed by a zero checksum, which
+		/// is not verified.
+		std::vector<byte> zlibStream() const {
+			std::vector<byte> stream(2 + m_bytes.size() + 4, 0);
+			stream[0] = 0x78;
+			stream[1] = 0x01;
+			std::copy(m_bytes.begin(), m_bytes.end(), stream.begin() + 2);
+			return stream;
+		}
+
+	private:
+		std::vector<byte> m_bytes;
+		uint m_numBits = 0;
+	};
+} // end namespace
+
+//---------------------------------------------------------------------------------------
+// 'numBytes' of words picked by a linear congruential generator, as DynamicStream was
+// compressed from.
+static std::string wordText (
+	size_t numBytes
+) {
+	const char * words[] = {
+		"pixel", "texture", "decode", "huffman", "inflate", "png", "jpeg", "mip"
+	};
+	uint32 state = 12345;
+	std::string text;
+	while (text.size() < numBytes) {
+		state = state * 1103515245 + 12345;
+		text += words[((state >> 16) & 0x7fff) % 8];
+		text += ' ';
+	}
+	text.resize(numBytes);
+	return text;
+}
+
+//---------------------------------------------------------------------------------------
+// Decompresses 'src' into 'dst', sized to its capacity, returning false if it throws.
+static bool tryDecompress (
+	const byte * src,
+	size_t srcSize,
+	std::vector<byte> & dst
+) {
+	try {
+		dst.resize(Inflate::decompressZlib(src, srcSize, dst.data(), dst.size()));
+		return true;
+	} catch (const std::runtime_error &) {
+		return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Every prefix of 'stream' that cuts into its compressed data fails.  The Adler-32
+// checksum after it is not read.
+static void checkTruncationFails (
+	const byte * stream,
+	size_t size,
+	size_t capacity
+) {
+	std::vector<byte> dst;
+	for (size_t length = 0; length + 4 < size; ++length) {
+		dst.resize(capacity);
+		CHECK(!tryDecompress(stream, length, dst));
+	}
+	dst.resize(capacity);
+	CHECK(tryDecompress(stream, size - 4, dst));
+}
+
+//---------------------------------------------------------------------------------------
+// Stored blocks are copied through, across block boundaries and at every length.
+static void testStoredBlocks()
+{
+	std::vector<byte> data(150000);
+	uint32 state = 1;
+	for (byte & value : data) {
+		state = state * 1664525 + 1013904223;
+		value = byte(state >> 24);
+	}
+
+	for (size_t size : { size_t(0), size_t(1), size_t(65535), size_t(65536), data.size() }) {
+		const std::vector<byte> stream = PngWriter::storeZlib(data.data(), size);
+		std::vector<byte> dst(size + 16);
+		CHECK(tryDecompress(stream.data(), stream.size(), dst));
+		CHECK(dst.size() == size);
+		CHECK(std::memcmp(dst.data(), data.data(), size) == 0);
+	}
+
+	// Many small blocks.
+	const std::vector<byte> stream = PngWriter::storeZlib(data.data(), 1000, 7);
+	std::vector<byte> dst(1000);
+	CHECK(tryDecompress(stream.data(), stream.size(), dst));
+	CHECK(std::memcmp(dst.data(), data.data(), 1000) == 0);
+	checkTruncationFails(stream.data(), stream.size(), 1000);
+
+	// A corrupt length complement.
+	std::vector<byte> corrupt = PngWriter::storeZlib(data.data(), 100);
+	corrupt[5] ^= 1;
+	CHECK(!tryDecompress(corrupt.data(), corrupt.size(), dst));
+}
+
+//---------------------------------------------------------------------------------------
+// A fixed Huffman block, and hand written ones covering matches that overlap their
+// own output.
+static void testFixedHuffman()
+{
+	CHECK(((FixedStream[2] >> 1) & 3) == 1);
+
+	const std::string expected = "Hello, hello, hello inflate!";
+	std::vector<byte> dst(expected.size());
+	CHECK(tryDecompress(FixedStream, sizeof(FixedStream), dst));
+	CHECK(std::string(dst.begin(), dst.end()) == expected);
+	checkTruncationFails(FixedStream, sizeof(FixedStream), expected.size());
+
+	// "ab", then length 7 at distance 2, and the longest match at distance 1.
+	BitWriter writer;
+	writer.write(1, 1);
+	writer.write(1, 2);
+	writer.writeFixedSymbol('a');
+	writer.writeFixedSymbol('b');
+	writer.writeFixedSymbol(261);
+	writer.writeCode(1, 5);
+	writer.writeFixedSymbol(285);
+	writer.writeCode(0, 5);
+	writer.writeFixedSymbol(256);
+	const std::vector<byte> stream = writer.zlibStream();
+
+	dst.resize(2 + 7 + 258);
+	CHECK(tryDecompress(stream.data(), stream.size(), dst));
+	CHECK(std::string(dst.begin(), dst.begin() + 9) == "ababababa");
+	for (size_t i = 9; i < dst.size(); ++i) {
+		CHECK(dst[i] == 'a');
+	}
+
+	// One byte short of room for the match.
+	dst.resize(2 + 7 + 257);
+	CHECK(!tryDecompress(stream.data(), stream.size(), dst));
+}
+
+//---------------------------------------------------------------------------------------
+// A dynamic Huffman block decodes to the text it was compressed from.
+static void testDynamicHuffman()
+{
+	CHECK(((DynamicStream[2] >> 1) & 3) == 2);
+
+	const std::string expected = wordText(1500);
+	std::vector<byte> dst(expected.size());
+	CHECK(tryDecompress(DynamicStream, sizeof(DynamicStream), dst));
+	CHECK(std::string(dst.begin(), dst.end()) == expected);
+
+	dst.resize(expected.size() - 1);
+	CHECK(!tryDecompress(DynamicStream, sizeof(DynamicStream), dst));
+
+	checkTruncationFails(DynamicStream, sizeof(DynamicStream), expected.size());
+}
+
+//---------------------------------------------------------------------------------------
+// Malformed headers and blocks fail, and corrupt streams either fail or stay within
+// the output.
+static void testMalformedStreams()
+{
+	std::vector<byte> dst(64);
+
+	const byte badMethod[] = { 0x77, 0x01, 0x03, 0x00 };
+	const byte badCheck[] = { 0x78, 0x02, 0x03, 0x00 };
+	const byte presetDictionary[] = { 0x78, 0x20, 0, 0, 0, 0, 0x03, 0x00 };
+	CHECK(!tryDecompress(badMethod, sizeof(badMethod), dst));
+	CHECK(!tryDecompress(badCheck, sizeof(badCheck), dst));
+	CHECK(!tryDecompress(presetDictionary, sizeof(presetDictionary), dst));
+
+	// Block type 3.
+	BitWriter reserved;
+	reserved.write(1, 1);
+	reserved.write(3, 2);
+	std::vector<byte> stream = reserved.zlibStream();
+	CHECK(!tryDecompress(stream.data(), stream.size(), dst));
+
+	// A match before the start of the output.
+	BitWriter tooFar;
+	tooFar.write(1, 1);
+	tooFar.write(1, 2);
+	tooFar.writeFixedSymbol('a');
+	tooFar.writeFixedSymbol(257);
+	tooFar.writeCode(1, 5);
+	tooFar.writeFixedSymbol(256);
+	stream = tooFar.zlibStream();
+	CHECK(!tryDecompress(stream.data(), stream.size(), dst));
+
+	// Length symbol 286 is never valid.
+	BitWriter badLength;
+	badLength.write(1, 1);
+	badLength.write(1, 2);
+	badLength.writeFixedSymbol('a');
+	badLength.writeFixedSymbol(286);
+	badLength.writeCode(0, 5);
+	badLength.writeFixedSymbol(256);
+	stream = badLength.zlibStream();
+	CHECK(!tryDecompress(stream.data(), stream.size(), dst));
+
+	// Flipped bits anywhere in the compressed data.
+	const size_t capacity = 1500;
+	std::vector<byte> corrupt(DynamicStream, DynamicStream + sizeof(DynamicStream));
+	for (size_t i = 2; i < corrupt.size(); ++i) {
+		for (byte mask : { byte(0x01), byte(0x20), byte(0xff) }) {
+			corrupt[i] ^= mask;
+			dst.resize(capacity);
+			if (tryDecompress(corrupt.data(), corrupt.size(), dst)) {
+				CHECK(dst.size() <= capacity);
+			}
+			corrupt[i] ^= mask;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testStoredBlocks);
+	RUN_TEST(testFixedHuffman);
+	RUN_TEST(testDynamicHuffman);
+	RUN_TEST(testMalformedStreams);
+
+	return 0;
+}
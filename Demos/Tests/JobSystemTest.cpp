@@ -0,0 +1,169 @@
+//
+// JobSystemTest.cpp
+//
+#include "Common/JobSystem.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Sums the integers in [begin, end) by splitting the range into two jobs until it is
+// small, each job waiting on the two it submitted.
+static uint64 sumRange (
+	JobSystem & jobSystem,
+	uint64 begin,
+	uint64 end
+) {
+	if (end - begin <= 16) {
+		uint64 sum = 0;
+		for (uint64 i = begin; i < end; ++i) {
+			sum += i;
+		}
+		return sum;
+	}
+
+	const uint64 middle = begin + (end - begin) / 2;
+	uint64 sums[2] = {};
+	JobSystem::Handle halves;
+	jobSystem.submit([&] { sums[0] = sumRange(jobSystem, begin, middle); }, halves);
+	jobSystem.submit([&] { sums[1] = sumRange(jobSystem, middle, end); }, halves);
+	jobSystem.wait(halves);
+	CHECK(halves.isComplete());
+	return sums[0] + sums[1];
+}
+
+//---------------------------------------------------------------------------------------
+// Jobs that submit and wait on jobs of their own finish, on any number of workers,
+// since waiting runs queued jobs rather than blocking a worker.
+static void testNestedSubmitAndWait()
+{
+	const uint64 count = 20000;
+	const uint numWorkers[] = { 1, 2, 4, 8 };
+	for (uint numWorkerThreads : numWorkers) {
+		JobSystem jobSystem(numWorkerThreads);
+		CHECK(jobSystem.numWorkerThreads() == numWorkerThreads);
+
+		uint64 sum = 0;
+		JobSystem::Handle handle = jobSystem.submit([&] {
+			sum = sumRange(jobSystem, 0, count);
+		});
+		jobSystem.wait(handle);
+		CHECK(sum == count * (count - 1) / 2);
+
+		// Waiting from the submitting thread alone works too.
+		CHECK(sumRange(jobSystem, 0, count) == count * (count - 1) / 2);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// A Handle tracks every job submitted with it, and can be reused once they finish.
+static void testHandleReuse()
+{
+	JobSystem jobSystem(3);
+
+	JobSystem::Handle handle;
+	CHECK(handle.isComplete());
+	jobSystem.wait(handle);
+
+	std::atomic<uint32> numRun(0);
+	for (uint batch = 1; batch <= 10; ++batch) {
+		for (uint i = 0; i < 100; ++i) {
+			jobSystem.submit([&] { numRun.fetch_add(1); }, handle);
+		}
+		jobSystem.wait(handle);
+		CHECK(handle.isComplete());
+		CHECK(numRun.load() == batch * 100);
+	}
+
+	// Copies share the jobs of the original.
+	std::atomic<bool> release(false);
+	jobSystem.submit([&] {
+		while (!release.load()) {
+			std::this_thread::yield();
+		}
+	}, handle);
+	const JobSystem::Handle copy = handle;
+	CHECK(!copy.isComplete());
+	release = true;
+	jobSystem.wait(copy);
+	CHECK(handle.isComplete());
+
+	// Separate handles complete independently.  Waiting runs queued jobs, so the
+	// blocking job must have been taken by a worker first.
+	release = false;
+	std::atomic<bool> started(false);
+	JobSystem::Handle blocked = jobSystem.submit([&] {
+		started = true;
+		while (!release.load()) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started.load()) {
+		std::this_thread::yield();
+	}
+	JobSystem::Handle other = jobSystem.submit([&] { numRun.fetch_add(1); });
+	jobSystem.wait(other);
+	CHECK(!blocked.isComplete());
+	release = true;
+	jobSystem.wait(blocked);
+}
+
+//---------------------------------------------------------------------------------------
+// Destroying the JobSystem runs every job still queued, including those the queued
+// jobs submit as they run.
+static void testShutdownWithQueuedJobs()
+{
+	const uint numJobs = 200;
+	std::atomic<uint32> numRun(0);
+	std::atomic<bool> release(false);
+	{
+		JobSystem jobSystem(1);
+
+		// Hold the only worker, so that every other job stays queued.
+		jobSystem.submit([&] {
+			while (!release.load()) {
+				std::this_thread::yield();
+			}
+		});
+		for (uint i = 0; i < numJobs; ++i) {
+			jobSystem.submit([&] {
+				numRun.fetch_add(1);
+				jobSystem.submit([&] { numRun.fetch_add(1); });
+			});
+		}
+		release = true;
+	}
+	CHECK(numRun.load() == 2 * numJobs);
+
+	// And without a worker being held, from several submitting threads.
+	numRun = 0;
+	{
+		JobSystem jobSystem(4);
+		std::vector<std::thread> threads;
+		for (uint t = 0; t < 4; ++t) {
+			threads.emplace_back([&] {
+				for (uint i = 0; i < numJobs; ++i) {
+					jobSystem.submit([&] { numRun.fetch_add(1); });
+				}
+			});
+		}
+		for (std::thread & thread : threads) {
+			thread.join();
+		}
+	}
+	CHECK(numRun.load() == 4 * numJobs);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testNestedSubmitAndWait);
+	RUN_TEST(testHandleReuse);
+	RUN_TEST(testShutdownWithQueuedJobs);
+
+	return 0;
+}
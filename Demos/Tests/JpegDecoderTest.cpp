@@ -0,0 +1,296 @@
+//
+// JpegDecoderTest.cpp
+//
+#include "Common/JpegDecoder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+	const byte PaddingByte = 0xcd;
+
+	// 16 x 16 grayscale baseline JPEG of grayLevel(), written by libjpeg at quality 90
+	// with optimized Huffman tables.
+	const byte GrayJpeg[] = {
+		0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+		0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x03, 0x02, 0x02, 0x03, 0x02, 0x02, 0x03,
+		0x03, 0x03, 0x03, 0x04, 0x03, 0x03, 0x04, 0x05, 0x08, 0x05, 0x05, 0x04, 0x04, 0x05, 0x0a, 0x07,
+		0x07, 0x06, 0x08, 0x0c, 0x0a, 0x0c, 0x0c, 0x0b, 0x0a, 0x0b, 0x0b, 0x0d, 0x0e, 0x12, 0x10, 0x0d,
+		0x0e, 0x11, 0x0e, 0x0b, 0x0b, 0x10, 0x16, 0x10, 0x11, 0x13, 0x14, 0x15, 0x15, 0x15, 0x0c, 0x0f,
+		0x17, 0x18, 0x16, 0x14, 0x18, 0x12, 0x14, 0x15, 0x14, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00, 0x10,
+		0x00, 0x10, 0x01, 0x01, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x15, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x09, 0xff, 0xc4, 0x00,
+		0x19, 0x10, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x05, 0x07, 0x22, 0x34, 0x51, 0xff, 0xda, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00,
+		0x3f, 0x00, 0x1b, 0x32, 0x48, 0x95, 0xe3, 0x85, 0x00, 0x64, 0x91, 0x2b, 0xc7, 0x01, 0xfb, 0x24,
+		0x89, 0x5e, 0x38, 0x50, 0x06, 0x49, 0x12, 0xbc, 0x70, 0xff, 0xd9
+	};
+
+	// 32 x 16 YCbCr baseline JPEG of colorPixel() with 4:2:0 chroma subsampling and a
+	// restart interval of 2 MCUs, written as GrayJpeg.
+	const byte ColorJpeg[] = {
+		0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+		0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x03, 0x02, 0x02, 0x03, 0x02, 0x02, 0x03,
+		0x03, 0x03, 0x03, 0x04, 0x03, 0x03, 0x04, 0x05, 0x08, 0x05, 0x05, 0x04, 0x04, 0x05, 0x0a, 0x07,
+		0x07, 0x06, 0x08, 0x0c, 0x0a, 0x0c, 0x0c, 0x0b, 0x0a, 0x0b, 0x0b, 0x0d, 0x0e, 0x12, 0x10, 0x0d,
+		0x0e, 0x11, 0x0e, 0x0b, 0x0b, 0x10, 0x16, 0x10, 0x11, 0x13, 0x14, 0x15, 0x15, 0x15, 0x0c, 0x0f,
+		0x17, 0x18, 0x16, 0x14, 0x18, 0x12, 0x14, 0x15, 0x14, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x03, 0x04,
+		0x04, 0x05, 0x04, 0x05, 0x09, 0x05, 0x05, 0x09, 0x14, 0x0d, 0x0b, 0x0d, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0xff, 0xc0,
+		0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x20, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+		0x01, 0xff, 0xc4, 0x00, 0x15, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x06, 0xff, 0xc4, 0x00, 0x17, 0x10, 0x00, 0x03, 0x01,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x04,
+		0x61, 0xff, 0xc4, 0x00, 0x16, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x05, 0x07, 0xff, 0xc4, 0x00, 0x1b, 0x11, 0x00, 0x02,
+		0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06,
+		0x04, 0x05, 0x21, 0x22, 0x31, 0x32, 0xff, 0xdd, 0x00, 0x04, 0x00, 0x02, 0xff, 0xda, 0x00, 0x0c,
+		0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xbf, 0x57, 0xe8, 0x95, 0xfa, 0x4c,
+		0xab, 0xf4, 0x4a, 0xfd, 0x25, 0x40, 0x58, 0xd6, 0x21, 0xad, 0x4a, 0x8f, 0xcd, 0x8a, 0x55, 0x7e,
+		0x89, 0x5f, 0xa4, 0xd2, 0xbf, 0x44, 0xaf, 0xd3, 0x46, 0x80, 0xb1, 0xac, 0x46, 0x9a, 0x95, 0x1f,
+		0x9b, 0x1f, 0xff, 0xd9
+	};
+} // end namespace
+
+//---------------------------------------------------------------------------------------
+static byte grayLevel (
+	uint x,
+	uint y
+) {
+	return byte(x * 12 + y * 3);
+}
+
+//---------------------------------------------------------------------------------------
+static void colorPixel (
+	uint x,
+	uint y,
+	byte rgb[3]
+) {
+	rgb[0] = byte(x * 7 + y * 2);
+	rgb[1] = byte(255 - x * 4 - y * 5);
+	rgb[2] = byte(64 + x * 3 + y * 6);
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes 'file' into rows padded with PaddingByte, checks the padding is untouched,
+// and returns the tightly packed pixels.
+static std::vector<byte> decode (
+	JpegDecoder & decoder,
+	const std::vector<byte> & file
+) {
+	const ImageInfo info = JpegDecoder::readInfo(file.data(), file.size());
+	const size_t rowBytes = size_t(info.width) * 4;
+	const size_t rowPitch = rowBytes + 12;
+
+	std::vector<byte> padded(rowPitch * info.height, PaddingByte);
+	ImageDestination destination;
+	destination.data = padded.data();
+	destination.rowPitch = rowPitch;
+	destination.size = padded.size();
+	decoder.decode(file.data(), file.size(), destination);
+
+	std::vector<byte> rgba;
+	for (uint y = 0; y < info.height; ++y) {
+		const byte * row = &padded[y * rowPitch];
+		rgba.insert(rgba.end(), row, row + rowBytes);
+		for (size_t i = rowBytes; i < rowPitch; ++i) {
+			CHECK(row[i] == PaddingByte);
+		}
+	}
+	return rgba;
+}
+
+//---------------------------------------------------------------------------------------
+// Returns false if reading the header or decoding 'file' throws.
+static bool tryDecode (
+	const std::vector<byte> & file
+) {
+	try {
+		JpegDecoder decoder;
+		decode(decoder, file);
+		return true;
+	} catch (const std::runtime_error &) {
+		return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Offset of the first 'marker' segment before the image data, following the segment
+// lengths.
+static size_t findSegment (
+	const std::vector<byte> & file,
+	byte marker
+) {
+	size_t offset = 2;
+	while (offset + 4 <= file.size() && file[offset] == 0xFF) {
+		if (file[offset + 1] == marker) {
+			return offset;
+		}
+		offset += 2 + ((size_t(file[offset + 2]) << 8) | file[offset + 3]);
+	}
+	std::fprintf(stderr, "Missing JPEG marker 0x%02x\n", marker);
+	std::exit(EXIT_FAILURE);
+}
+
+//---------------------------------------------------------------------------------------
+// Largest difference between the color channels of 'rgba' and 'expected', which must
+// be opaque.
+static int maxDifference (
+	const std::vector<byte> & rgba,
+	const std::vector<byte> & expected
+) {
+	CHECK(rgba.size() == expected.size());
+	int maxDifference = 0;
+	for (size_t i = 0; i < rgba.size(); ++i) {
+		if (i % 4 == 3) {
+			CHECK(rgba[i] == 255);
+			continue;
+		}
+		const int difference = std::abs(int(rgba[i]) - int(expected[i]));
+		maxDifference = difference > maxDifference ? difference : maxDifference;
+	}
+	return maxDifference;
+}
+
+//---------------------------------------------------------------------------------------
+// Baseline grayscale and subsampled color images decode close to the pixels they were
+// encoded from, with one decoder reused across both.
+static void testBaseline()
+{
+	const std::vector<byte> gray(GrayJpeg, GrayJpeg + sizeof(GrayJpeg));
+	const std::vector<byte> color(ColorJpeg, ColorJpeg + sizeof(ColorJpeg));
+	CHECK(JpegDecoder::isJpeg(gray.data(), gray.size()));
+
+	const ImageInfo grayInfo = JpegDecoder::readInfo(gray.data(), gray.size());
+	CHECK(grayInfo.width == 16 && grayInfo.height == 16);
+	const ImageInfo colorInfo = JpegDecoder::readInfo(color.data(), color.size());
+	CHECK(colorInfo.width == 32 && colorInfo.height == 16);
+
+	std::vector<byte> expectedGray;
+	for (uint y = 0; y < 16; ++y) {
+		for (uint x = 0; x < 16; ++x) {
+			const byte level = grayLevel(x, y);
+			const byte pixel[4] = { level, level, level, 255 };
+			expectedGray.insert(expectedGray.end(), pixel, pixel + 4);
+		}
+	}
+	std::vector<byte> expectedColor;
+	for (uint y = 0; y < 16; ++y) {
+		for (uint x = 0; x < 32; ++x) {
+			byte pixel[4] = { 0, 0, 0, 255 };
+			colorPixel(x, y, pixel);
+			expectedColor.insert(expectedColor.end(), pixel, pixel + 4);
+		}
+	}
+
+	JpegDecoder decoder;
+	const std::vector<byte> colorRgba = decode(decoder, color);
+	const std::vector<byte> grayRgba = decode(decoder, gray);
+	CHECK(maxDifference(grayRgba, expectedGray) <= 2);
+	CHECK(maxDifference(colorRgba, expectedColor) <= 10);
+	CHECK(decode(decoder, color) == colorRgba);
+
+	// Extended sequential frames decode as baseline ones.
+	std::vector<byte> extended = color;
+	extended[findSegment(color, 0xC0) + 1] = 0xC1;
+	CHECK(decode(decoder, extended) == colorRgba);
+}
+
+//---------------------------------------------------------------------------------------
+// Progressive, lossless, arithmetic coded and 12-bit frames are rejected by both
+// readInfo() and decode().
+static void testUnsupportedFrames()
+{
+	const std::vector<byte> color(ColorJpeg, ColorJpeg + sizeof(ColorJpeg));
+	const size_t frame = findSegment(color, 0xC0);
+
+	std::vector<std::vector<byte>> unsupported;
+	for (byte marker : { byte(0xC2), byte(0xC3), byte(0xC9), byte(0xCA) }) {
+		unsupported.push_back(color);
+		unsupported.back()[frame + 1] = marker;
+	}
+	unsupported.push_back(color);
+	unsupported.back()[frame + 4] = 12;
+
+	for (const std::vector<byte> & file : unsupported) {
+		bool hasThrown = false;
+		try {
+			JpegDecoder::readInfo(file.data(), file.size());
+		} catch (const std::runtime_error &) {
+			hasThrown = true;
+		}
+		CHECK(hasThrown);
+		CHECK(!tryDecode(file));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Truncated and corrupt files fail with std::runtime_error, or decode within bounds.
+static void testMalformedFiles()
+{
+	for (const std::vector<byte> & file : {
+		std::vector<byte>(GrayJpeg, GrayJpeg + sizeof(GrayJpeg)),
+		std::vector<byte>(ColorJpeg, ColorJpeg + sizeof(ColorJpeg))
+	}) {
+		CHECK(tryDecode(file));
+
+		// Including files cut anywhere in their image data.
+		for (size_t length = 0; length < file.size(); ++length) {
+			CHECK(!tryDecode(std::vector<byte>(file.begin(), file.begin() + length)));
+		}
+
+		std::vector<byte> corrupt = file;
+		for (size_t i = 2; i < corrupt.size(); ++i) {
+			for (byte mask : { byte(0x01), byte(0x80), byte(0xff) }) {
+				corrupt[i] ^= mask;
+				tryDecode(corrupt);
+				corrupt[i] ^= mask;
+			}
+		}
+	}
+
+	const std::vector<byte> gray(GrayJpeg, GrayJpeg + sizeof(GrayJpeg));
+	std::vector<byte> notJpeg = gray;
+	notJpeg[1] = 0xD9;
+	CHECK(!JpegDecoder::isJpeg(notJpeg.data(), notJpeg.size()));
+	CHECK(!tryDecode(notJpeg));
+
+	// No image data.
+	std::vector<byte> noScan(gray.begin(), gray.begin() + findSegment(gray, 0xDA));
+	noScan.push_back(0xFF);
+	noScan.push_back(0xD9);
+	CHECK(!tryDecode(noScan));
+
+	// A destination too small for the image.
+	std::vector<byte> pixels(16 * 16 * 4);
+	ImageDestination destination;
+	destination.data = pixels.data();
+	destination.rowPitch = 16 * 4;
+	destination.size = pixels.size() - 1;
+	JpegDecoder decoder;
+	bool hasThrown = false;
+	try {
+		decoder.decode(gray.data(), gray.size(), destination);
+	} catch (const std::runtime_error &) {
+		hasThrown = true;
+	}
+	CHECK(hasThrown);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testBaseline);
+	RUN_TEST(testUnsupportedFrames);
+	RUN_TEST(testMalformedFiles);
+
+	return 0;
+}
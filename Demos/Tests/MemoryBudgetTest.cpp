@@ -0,0 +1,276 @@
+//
+// MemoryBudgetTest.cpp
+//
+#include "Common/MemoryBudget.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+#include "Common/TextureStreamer.hpp"
+#include "TestUtils.hpp"
+
+using Segment = MemoryBudget::Segment;
+
+
+namespace {
+
+const uint64 MB = 1ull << 20;
+
+// Frees whatever it is asked to, recording the order of its calls.  The allocation
+// shrinks once complete() is called, as if the memory were released a frame later.
+class RecordingEvictor : public MemoryBudget::Evictor {
+public:
+	explicit RecordingEvictor (
+		MemoryBudget & memoryBudget
+	)
+		: m_memoryBudget(memoryBudget)
+	{
+
+	}
+
+	uint64 evict (
+		MemoryBudget::AllocationId allocation,
+		uint64 context,
+		uint64 bytesNeeded
+	) override {
+		CHECK(context < sizes.size());
+		const uint64 bytes = bytesNeeded < sizes[context] ? bytesNeeded : sizes[context];
+		evictions.push_back(Eviction { allocation, context, bytes });
+		return bytes;
+	}
+
+	/// Shrinks every allocation by the bytes evicted from it.
+	void complete()
+	{
+		for (const Eviction & eviction : evictions) {
+			sizes[eviction.context] -= eviction.bytes;
+			m_memoryBudget.resizeAllocation(eviction.allocation, sizes[eviction.context]);
+		}
+		evictions.clear();
+	}
+
+	struct Eviction {
+		MemoryBudget::AllocationId allocation;
+		uint64 context;
+		uint64 bytes;
+	};
+
+	/// Bytes of each allocation, indexed by context.
+	std::vector<uint64> sizes;
+
+	/// Evictions since the last complete().
+	std::vector<Eviction> evictions;
+
+private:
+	MemoryBudget & m_memoryBudget;
+};
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+// Budget fractions are floats, so targets derived from them are off by a few bytes.
+static bool isNear (
+	int64 bytes,
+	uint64 expected
+) {
+	return std::llabs(bytes - int64(expected)) < 1024;
+}
+
+//---------------------------------------------------------------------------------------
+static void testScriptedCurves()
+{
+	MemoryBudget::ScriptedAdapter adapter (
+		{ { 10, 100 * MB, 10 * MB }, { 20, 200 * MB, 30 * MB } },
+		{}
+	);
+
+	MemoryBudget::SegmentInfo info[uint(Segment::Count)];
+	std::vector<MemoryBudget::SegmentInfo> local;
+	for (uint frame = 0; frame < 25; ++frame) {
+		adapter.queryMemoryInfo(info);
+		local.push_back(info[uint(Segment::Local)]);
+		CHECK(info[uint(Segment::NonLocal)].budget == UINT64_MAX);
+		CHECK(info[uint(Segment::NonLocal)].currentUsage == 0);
+	}
+
+	// Held before the first point and after the last, linear in between.
+	CHECK(local[0].budget == 100 * MB && local[0].currentUsage == 10 * MB);
+	CHECK(local[10].budget == 100 * MB && local[10].currentUsage == 10 * MB);
+	CHECK(local[15].budget == 150 * MB && local[15].currentUsage == 20 * MB);
+	CHECK(local[20].budget == 200 * MB && local[20].currentUsage == 30 * MB);
+	CHECK(local[24].budget == 200 * MB && local[24].currentUsage == 30 * MB);
+	CHECK(local[24].availableForReservation == 100 * MB);
+
+	// Once attached, allocations tracked by the MemoryBudget count as usage.
+	MemoryBudget memoryBudget(&adapter, MemoryBudget::Settings());
+	adapter.attach(&memoryBudget);
+	memoryBudget.trackAllocation(Segment::Local, 5 * MB, 1.0f);
+	memoryBudget.trackAllocation(Segment::NonLocal, 3 * MB, 1.0f);
+	memoryBudget.update();
+	CHECK(memoryBudget.segmentInfo(Segment::Local).currentUsage == 35 * MB);
+	CHECK(memoryBudget.segmentInfo(Segment::NonLocal).currentUsage == 3 * MB);
+}
+
+//---------------------------------------------------------------------------------------
+// Usage is estimated between polls from allocations tracked since.
+static void testTracking()
+{
+	MemoryBudget::ScriptedAdapter adapter({ { 0, 100 * MB, 20 * MB } }, {});
+	MemoryBudget memoryBudget(&adapter, MemoryBudget::Settings());
+	adapter.attach(&memoryBudget);
+	memoryBudget.update();
+
+	CHECK(memoryBudget.estimatedUsage(Segment::Local) == 20 * MB);
+	CHECK(isNear(memoryBudget.headroom(Segment::Local), 65 * MB));
+
+	const MemoryBudget::AllocationId a = memoryBudget.trackAllocation(Segment::Local, 10 * MB, 1.0f);
+	const MemoryBudget::AllocationId b = memoryBudget.trackAllocation(Segment::Local, 4 * MB, 1.0f);
+	CHECK(memoryBudget.trackedBytes(Segment::Local) == 14 * MB);
+	CHECK(memoryBudget.estimatedUsage(Segment::Local) == 34 * MB);
+
+	memoryBudget.resizeAllocation(a, 6 * MB);
+	CHECK(memoryBudget.estimatedUsage(Segment::Local) == 30 * MB);
+
+	// The next poll sees the allocations in the reported usage, and the estimate
+	// doesn't count them twice.
+	memoryBudget.update();
+	CHECK(memoryBudget.segmentInfo(Segment::Local).currentUsage == 30 * MB);
+	CHECK(memoryBudget.estimatedUsage(Segment::Local) == 30 * MB);
+
+	memoryBudget.releaseAllocation(b);
+	CHECK(memoryBudget.trackedBytes(Segment::Local) == 6 * MB);
+	CHECK(memoryBudget.estimatedUsage(Segment::Local) == 26 * MB);
+	CHECK(isNear(memoryBudget.headroom(Segment::Local), 59 * MB));
+
+	// Released ids are reused.
+	CHECK(memoryBudget.trackAllocation(Segment::NonLocal, MB, 1.0f) == b);
+	CHECK(memoryBudget.trackedBytes(Segment::Local) == 6 * MB);
+}
+
+//---------------------------------------------------------------------------------------
+// Crossing the eviction threshold evicts the lowest priorities down to the target.
+static void testEviction()
+{
+	MemoryBudget::ScriptedAdapter adapter (
+		{ { 0, 100 * MB, 0 }, { 1, 100 * MB, 0 }, { 2, 80 * MB, 0 } },
+		{}
+	);
+	MemoryBudget memoryBudget(&adapter, MemoryBudget::Settings());
+	adapter.attach(&memoryBudget);
+	RecordingEvictor evictor(memoryBudget);
+
+	const float priorities[] = { 3.0f, 1.0f, 4.0f, 2.0f };
+	for (uint i = 0; i < 4; ++i) {
+		evictor.sizes.push_back(22 * MB);
+		memoryBudget.trackAllocation(Segment::Local, 22 * MB, priorities[i], &evictor, i);
+	}
+	memoryBudget.trackAllocation(Segment::Local, MB, 0.0f);
+
+	// 89 MB is within the threshold of 95 MB.
+	memoryBudget.update();
+	CHECK(evictor.evictions.empty());
+	memoryBudget.update();
+	CHECK(evictor.evictions.empty());
+
+	// The budget falls to 80 MB, whose target is 68 MB, so 21 MB are evicted from
+	// the lowest priority allocation, skipping the one without an evictor.
+	memoryBudget.update();
+	CHECK(evictor.evictions.size() == 1);
+	CHECK(evictor.evictions[0].context == 1 && isNear(evictor.evictions[0].bytes, 21 * MB));
+	CHECK(isNear(memoryBudget.estimatedUsage(Segment::Local), 68 * MB));
+	CHECK(memoryBudget.statistics().numUpdatesOverBudget == 1);
+
+	// Bytes promised but not yet freed aren't asked for again.
+	memoryBudget.update();
+	CHECK(evictor.evictions.size() == 1);
+	evictor.complete();
+	CHECK(isNear(memoryBudget.estimatedUsage(Segment::Local), 68 * MB));
+	memoryBudget.update();
+	CHECK(evictor.evictions.empty());
+	CHECK(isNear(memoryBudget.segmentInfo(Segment::Local).currentUsage, 68 * MB));
+
+	// A larger drop spans allocations, in order of priority.
+	memoryBudget.trackAllocation(Segment::Local, 20 * MB, 0.0f);
+	memoryBudget.update();
+	CHECK(evictor.evictions.size() == 2);
+	CHECK(evictor.evictions[0].context == 1 && isNear(evictor.evictions[0].bytes, MB));
+	CHECK(evictor.evictions[1].context == 3 && isNear(evictor.evictions[1].bytes, 19 * MB));
+	CHECK(memoryBudget.statistics().numEvictions == 3);
+	CHECK(isNear(memoryBudget.statistics().evictedBytes, 41 * MB));
+	CHECK(memoryBudget.statistics().peakUsage[uint(Segment::Local)] == 89 * MB);
+}
+
+//---------------------------------------------------------------------------------------
+// Texture streaming while the budget halves and recovers: usage stays within the
+// budget once it settles, the most important texture keeps its full resolution, and
+// the others sharpen again afterwards.
+static void testStreamingUnderPressure()
+{
+	MemoryBudget::ScriptedAdapter adapter (
+		{
+			{ 0, 40 * MB, 4 * MB }, { 50, 40 * MB, 4 * MB }, { 70, 20 * MB, 4 * MB },
+			{ 150, 20 * MB, 4 * MB }, { 170, 40 * MB, 4 * MB }
+		},
+		{}
+	);
+	MemoryBudget memoryBudget(&adapter, MemoryBudget::Settings());
+	adapter.attach(&memoryBudget);
+
+	// Only the memory budget limits the streamer.
+	TextureStreamer::Settings settings;
+	settings.residentBudget = 1ull << 40;
+	TextureStreamer streamer(settings, nullptr, &memoryBudget);
+
+	const DdsFile::Description description = {
+		2048, 2048, 1, 12, DdsFile::DxgiFormat::BC7_UNORM_SRGB, false
+	};
+	const uint numTextures = 8;
+	for (uint i = 0; i < numTextures; ++i) {
+		streamer.addTexture(description);
+	}
+
+	uint sumMipsUnderPressure = 0;
+	for (uint frame = 0; frame < 260; ++frame) {
+		memoryBudget.update();
+		for (uint i = 0; i < numTextures; ++i) {
+			streamer.requestMip(i, 0, float(i + 1));
+		}
+		streamer.update();
+
+		const MemoryBudget::SegmentInfo & info = memoryBudget.segmentInfo(Segment::Local);
+		if (frame >= 80 && frame < 150) {
+			CHECK(info.currentUsage <= info.budget);
+		}
+		if (frame == 149) {
+			CHECK(streamer.residentMip(numTextures - 1) == 0);
+			for (uint i = 0; i < numTextures; ++i) {
+				sumMipsUnderPressure += streamer.residentMip(i);
+			}
+		}
+	}
+
+	uint sumMips = 0;
+	for (uint i = 0; i < numTextures; ++i) {
+		sumMips += streamer.residentMip(i);
+	}
+	const MemoryBudget::Statistics & statistics = memoryBudget.statistics();
+	std::printf("  %llu evictions, %llu updates over budget, summed mips %u under pressure, %u after\n",
+		(unsigned long long)statistics.numEvictions,
+		(unsigned long long)statistics.numUpdatesOverBudget, sumMipsUnderPressure, sumMips);
+
+	CHECK(statistics.numEvictions > 0);
+	CHECK(statistics.numUpdatesOverBudget <= 5);
+	CHECK(sumMips < sumMipsUnderPressure);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testScriptedCurves);
+	RUN_TEST(testTracking);
+	RUN_TEST(testEviction);
+	RUN_TEST(testStreamingUnderPressure);
+
+	return 0;
+}
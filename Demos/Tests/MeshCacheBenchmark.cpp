@@ -0,0 +1,154 @@
+//
+// MeshCacheBenchmark.cpp
+//
+// Times mesh startup the way MeshLoader::loadCachedMesh() performs it: a cold load that
+// parses and processes the OBJ file then writes its cache, against a warm load that
+// maps the cache and checks it is current.  The warm load also touches every vertex
+// and index, as an upload would.
+//
+// Loads the OBJ files given on the command line, e.g. Assets/Meshes/*.obj, or else a
+// generated grid.  Cache files are written next to each OBJ file.
+//
+#include "Common/MeshCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Common/MeshFileLoader.hpp"
+
+#include "MeshPipeline.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+// Writes a wavy grid of 'size' x 'size' vertices drawn with quads to 'path'.
+static void writeGridObj (
+	const char * path,
+	uint size
+) {
+	FILE * file = std::fopen(path, "wb");
+	if (!file) {
+		std::fprintf(stderr, "Unable to create %s\n", path);
+		std::exit(EXIT_FAILURE);
+	}
+	for (uint y = 0; y < size; ++y) {
+		for (uint x = 0; x < size; ++x) {
+			std::fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0 0 1\n",
+				x * 0.01f, y * 0.01f, ((x * 7 + y * 13) % 100) * 0.001f,
+				float(x) / size, float(y) / size);
+		}
+	}
+	for (uint y = 0; y + 1 < size; ++y) {
+		for (uint x = 0; x + 1 < size; ++x) {
+			const uint a = y * size + x + 1;
+			const uint c = a + size;
+			std::fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n",
+				a, a, a + 1, a + 1, c + 1, c + 1, c, c);
+		}
+	}
+	std::fclose(file);
+}
+
+//---------------------------------------------------------------------------------------
+// Parses and processes 'objPath', and writes its cache to 'cachePath'.
+static void loadCold (
+	const char * objPath,
+	const char * cachePath
+) {
+	MeshCache::SourceInfo source;
+	MappedFile objFile;
+	if (!MeshCache::queryFile(objPath, source.timestamp, source.size) || !objFile.open(objPath)) {
+		std::fprintf(stderr, "Unable to open %s\n", objPath);
+		std::exit(EXIT_FAILURE);
+	}
+	source.hash = MeshCache::hashBytes(objFile.data(), objFile.size());
+
+	Mesh mesh;
+	MeshFileLoader::parseObj(reinterpret_cast<const char *>(objFile.data()), objFile.size(), mesh);
+	MeshPipeline::processMesh(mesh);
+
+	MeshCache::write(cachePath, mesh, source, 0);
+}
+
+//---------------------------------------------------------------------------------------
+// Maps the cache of 'objPath', failing if it isn't current.
+static uint64 loadCached (
+	const char * objPath,
+	const char * cachePath
+) {
+	MeshCache::SourceInfo source;
+	MappedFile objFile;
+	MappedMesh mappedMesh;
+	if (!MeshCache::queryFile(objPath, source.timestamp, source.size) ||
+		!mappedMesh.open(cachePath) ||
+		!MeshCache::isCurrent(mappedMesh.header(), objPath, source, 0, objFile))
+	{
+		std::fprintf(stderr, "Mesh cache of %s is not current\n", objPath);
+		std::exit(EXIT_FAILURE);
+	}
+
+	// Read every vertex and index, so that the mapping is paged in.
+	const byte * vertexData = reinterpret_cast<const byte *>(mappedMesh.vertices());
+	const byte * indexData = static_cast<const byte *>(mappedMesh.indexData());
+	uint64 sum = 0;
+	for (size_t i = 0; i < mappedMesh.vertexDataBytes(); i += 4) {
+		sum += vertexData[i];
+	}
+	for (size_t i = 0; i < mappedMesh.indexDataBytes(); i += 2) {
+		sum += indexData[i];
+	}
+	return sum;
+}
+
+//---------------------------------------------------------------------------------------
+int main (
+	int argc,
+	char ** argv
+) {
+	std::vector<std::string> objPaths(argv + 1, argv + argc);
+	if (objPaths.empty()) {
+		objPaths.push_back("MeshCacheBenchmark.obj");
+		writeGridObj(objPaths[0].c_str(), 300);
+	}
+
+	std::printf("Startup time in milliseconds, cold parse against cached load\n");
+	for (const std::string & objPath : objPaths) {
+		const std::string cachePath = objPath + ".meshcache";
+
+		const double coldSeconds = timeFastest(3, [&] {
+			loadCold(objPath.c_str(), cachePath.c_str());
+		});
+
+		// Volatile, so that reading the mapping isn't optimized away.
+		volatile uint64 checksum = 0;
+		const double cachedSeconds = timeFastest(20, [&] {
+			checksum = loadCached(objPath.c_str(), cachePath.c_str());
+		});
+
+		MappedMesh mappedMesh;
+		mappedMesh.open(cachePath.c_str());
+		std::printf("  %s: %zu vertices, %zu LODs, cold %8.2f ms, cached %6.3f ms, %.0fx\n",
+			objPath.c_str(), mappedMesh.numVertices(), mappedMesh.numLods(),
+			coldSeconds * 1000.0, cachedSeconds * 1000.0, coldSeconds / cachedSeconds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,241 @@
+//
+// MeshCacheTest.cpp
+//
+#include "Common/MeshCache.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+// Written to the working directory, which is the build directory under ctest.
+const char * const SourcePath = "MeshCacheTest.obj";
+const char * const CachePath = "MeshCacheTest.obj.meshcache";
+
+const uint64 SettingsHash = 0x1234;
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static void writeFile (
+	const char * path,
+	const void * data,
+	size_t numBytes
+) {
+	FILE * file = std::fopen(path, "wb");
+	CHECK(file);
+	CHECK(std::fwrite(data, 1, numBytes, file) == numBytes);
+	CHECK(std::fclose(file) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+static std::vector<byte> readFile (
+	const char * path
+) {
+	MappedFile file;
+	CHECK(file.open(path));
+	return std::vector<byte>(file.data(), file.data() + file.size());
+}
+
+//---------------------------------------------------------------------------------------
+// Quad of two triangles, with a Submesh, a Meshlet and a Lod so that every stream of
+// the cache is written.
+static Mesh createQuad()
+{
+	Mesh mesh;
+	for (uint v = 0; v < 4; ++v) {
+		Mesh::Vertex vertex = {};
+		vertex.position[0] = float(v & 1);
+		vertex.position[1] = float(v >> 1);
+		vertex.normal[2] = 1.0f;
+		vertex.texCoord[0] = vertex.position[0];
+		vertex.texCoord[1] = vertex.position[1];
+		mesh.vertices.push_back(vertex);
+	}
+	mesh.indices16 = { 0, 1, 2, 1, 3, 2 };
+
+	Mesh::Submesh submesh = {};
+	submesh.numIndices = 6;
+	mesh.submeshes.push_back(submesh);
+
+	Mesh::Meshlet meshlet = {};
+	meshlet.numIndices = 6;
+	meshlet.numVertices = 4;
+	mesh.meshlets.push_back(meshlet);
+
+	Mesh::Lod lod = {};
+	lod.numIndices = 6;
+	mesh.lods.push_back(lod);
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Writes the source asset and a cache built from it, returning the source's properties.
+static MeshCache::SourceInfo writeSourceAndCache (
+	const std::string & sourceText
+) {
+	writeFile(SourcePath, sourceText.data(), sourceText.size());
+
+	MeshCache::SourceInfo source;
+	CHECK(MeshCache::queryFile(SourcePath, source.timestamp, source.size));
+	CHECK(source.size == sourceText.size());
+	source.hash = MeshCache::hashBytes(sourceText.data(), sourceText.size());
+
+	MeshCache::write(CachePath, createQuad(), source, SettingsHash);
+	return source;
+}
+
+//---------------------------------------------------------------------------------------
+// A written cache maps back with its streams and header intact.
+static void testRoundTrip()
+{
+	const MeshCache::SourceInfo source = writeSourceAndCache("v 0 0 0\n");
+	const Mesh quad = createQuad();
+
+	MappedMesh mappedMesh;
+	CHECK(mappedMesh.open(CachePath));
+	CHECK(mappedMesh.numVertices() == 4);
+	CHECK(mappedMesh.indexSize() == 2);
+	CHECK(std::memcmp(mappedMesh.vertices(), quad.vertices.data(), mappedMesh.vertexDataBytes()) == 0);
+	CHECK(std::memcmp(mappedMesh.indexData(), quad.indexData(), mappedMesh.indexDataBytes()) == 0);
+	CHECK(mappedMesh.numSubmeshes() == 1 && mappedMesh.submeshes()[0].numIndices == 6);
+	CHECK(mappedMesh.numMeshlets() == 1 && mappedMesh.meshlets()[0].numVertices == 4);
+	CHECK(mappedMesh.numLods() == 1 && mappedMesh.lods()[0].numIndices == 6);
+
+	const MeshCache::Header & header = mappedMesh.header();
+	CHECK(header.sourceTimestamp == source.timestamp);
+	CHECK(header.sourceSize == source.size);
+	CHECK(header.sourceHash == source.hash);
+	CHECK(header.settingsHash == SettingsHash);
+	CHECK(header.boundsMin[0] == 0.0f && header.boundsMax[1] == 1.0f);
+
+	MappedMesh missing;
+	CHECK(!missing.open("MeshCacheTest.missing"));
+	CHECK(!missing.isOpen());
+}
+
+//---------------------------------------------------------------------------------------
+// An untouched source is current without being read, and a touched one is current only
+// while its contents hash the same.
+static void testSourceChanges()
+{
+	const std::string sourceText = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+	const MeshCache::SourceInfo source = writeSourceAndCache(sourceText);
+
+	MappedMesh mappedMesh;
+	CHECK(mappedMesh.open(CachePath));
+	const MeshCache::Header & header = mappedMesh.header();
+
+	MappedFile sourceFile;
+	CHECK(MeshCache::isCurrent(header, SourcePath, source, SettingsHash, sourceFile));
+	CHECK(!sourceFile.isOpen());
+
+	// Same contents with a new timestamp, as after a checkout, are hashed and kept.
+	MeshCache::SourceInfo touched = source;
+	touched.timestamp += 10;
+	CHECK(MeshCache::isCurrent(header, SourcePath, touched, SettingsHash, sourceFile));
+	CHECK(sourceFile.isOpen() && sourceFile.size() == sourceText.size());
+	sourceFile.close();
+
+	// An edit of the same size changes the hash.
+	std::string edited = sourceText;
+	edited[2] = '5';
+	writeFile(SourcePath, edited.data(), edited.size());
+	CHECK(!MeshCache::isCurrent(header, SourcePath, touched, SettingsHash, sourceFile));
+	CHECK(sourceFile.isOpen());
+	sourceFile.close();
+
+	// A size change is stale without reading the source.
+	MeshCache::SourceInfo resized = source;
+	resized.size += 1;
+	CHECK(!MeshCache::isCurrent(header, SourcePath, resized, SettingsHash, sourceFile));
+	CHECK(!sourceFile.isOpen());
+
+	// So is a source that can no longer be read.
+	CHECK(!MeshCache::isCurrent(header, "MeshCacheTest.missing", touched, SettingsHash, sourceFile));
+}
+
+//---------------------------------------------------------------------------------------
+// Caches built with other load settings are stale.
+static void testSettingsMismatch()
+{
+	const MeshCache::SourceInfo source = writeSourceAndCache("v 0 0 0\n");
+
+	MappedMesh mappedMesh;
+	CHECK(mappedMesh.open(CachePath));
+
+	MappedFile sourceFile;
+	CHECK(!MeshCache::isCurrent(mappedMesh.header(), SourcePath, source, SettingsHash + 1, sourceFile));
+	CHECK(!sourceFile.isOpen());
+}
+
+//---------------------------------------------------------------------------------------
+// Caches from another version, or that aren't caches at all, fail to open.
+static void testVersionMismatch()
+{
+	writeSourceAndCache("v 0 0 0\n");
+	const std::vector<byte> cache = readFile(CachePath);
+
+	std::vector<byte> patched = cache;
+	const uint32 version = MeshCache::Version + 1;
+	std::memcpy(&patched[offsetof(MeshCache::Header, version)], &version, sizeof(version));
+	writeFile(CachePath, patched.data(), patched.size());
+
+	MappedMesh mappedMesh;
+	CHECK(!mappedMesh.open(CachePath));
+	CHECK(!mappedMesh.isOpen());
+
+	patched = cache;
+	patched[0] ^= 0xFF;
+	writeFile(CachePath, patched.data(), patched.size());
+	CHECK(!mappedMesh.open(CachePath));
+
+	writeFile(CachePath, cache.data(), cache.size());
+	CHECK(mappedMesh.open(CachePath));
+}
+
+//---------------------------------------------------------------------------------------
+// A cache cut short anywhere, within the header or its streams, fails to open.
+static void testTruncatedCache()
+{
+	writeSourceAndCache("v 0 0 0\n");
+	const std::vector<byte> cache = readFile(CachePath);
+
+	const size_t lengths[] = {
+		0, 4, sizeof(MeshCache::Header) - 1, sizeof(MeshCache::Header),
+		cache.size() / 2, cache.size() - 1
+	};
+	MappedMesh mappedMesh;
+	for (size_t length : lengths) {
+		writeFile(CachePath, cache.data(), length);
+		CHECK(!mappedMesh.open(CachePath));
+	}
+
+	// Offsets pointing past the end of the file are caught the same way.
+	std::vector<byte> patched = cache;
+	const uint64 lodDataOffset = cache.size();
+	std::memcpy(&patched[offsetof(MeshCache::Header, lodDataOffset)], &lodDataOffset, sizeof(lodDataOffset));
+	writeFile(CachePath, patched.data(), patched.size());
+	CHECK(!mappedMesh.open(CachePath));
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRoundTrip);
+	RUN_TEST(testSourceChanges);
+	RUN_TEST(testSettingsMismatch);
+	RUN_TEST(testVersionMismatch);
+	RUN_TEST(testTruncatedCache);
+
+	std::remove(SourcePath);
+	std::remove(CachePath);
+	return 0;
+}
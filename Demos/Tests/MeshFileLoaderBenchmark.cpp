@@ -0,0 +1,137 @@
+//
+// MeshFileLoaderBenchmark.cpp
+//
+// Times MeshFileLoader on a generated OBJ grid with positions, texture coordinates and
+// normals, merged into one mesh and split into shapes parsed across a JobSystem.
+//
+// Configured with TINYOBJLOADER_INCLUDE_DIR, tinyobjloader, which the parser replaced,
+// is timed on the same text for comparison.  As a baseline, a single core Linux
+// container measured about 240 MB/s merged and 250 MB/s split into 16 shapes.
+//
+#include "Common/MeshFileLoader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Common/JobSystem.hpp"
+
+#ifdef HAVE_TINYOBJLOADER
+#include <sstream>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+#endif
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+// Wavy grid of 'size' x 'size' vertices drawn with quads, split into 'numShapes' shapes
+// of whole rows.
+static std::string createObjText (
+	uint size,
+	uint numShapes
+) {
+	std::string text;
+	char line[128];
+	for (uint y = 0; y < size; ++y) {
+		for (uint x = 0; x < size; ++x) {
+			std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+				x * 0.01f, y * 0.01f, ((x * 7 + y * 13) % 100) * 0.001f,
+				float(x) / size, float(y) / size,
+				0.0f, 0.0f, 1.0f);
+			text += line;
+		}
+	}
+
+	const uint rowsPerShape = (size - 1 + numShapes - 1) / numShapes;
+	for (uint y = 0; y + 1 < size; ++y) {
+		if (y % rowsPerShape == 0) {
+			std::snprintf(line, sizeof(line), "o rows_%u\n", y);
+			text += line;
+		}
+		for (uint x = 0; x + 1 < size; ++x) {
+			const uint a = y * size + x + 1;
+			const uint b = a + 1;
+			const uint c = a + size;
+			const uint d = c + 1;
+			std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n",
+				a, a, a, b, b, b, d, d, d, c, c, c);
+			text += line;
+		}
+	}
+
+	return text;
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	const std::string text = createObjText(400, 16);
+	const double megabytes = text.size() * 1.0e-6;
+	std::printf("%.1f MB of OBJ text, throughput in megabytes per second\n", megabytes);
+
+	Mesh mesh;
+	const double mergedSeconds = timeFastest(5, [&] {
+		MeshFileLoader::parseObj(text.data(), text.size(), mesh);
+	});
+	std::printf("  MeshFileLoader merged          %7.1f MB/s, %zu vertices\n",
+		megabytes / mergedSeconds, mesh.vertices.size());
+
+	// Attributes are read on one thread, then the shapes' faces on all of them.
+	JobSystem jobSystem;
+	std::vector<Mesh> shapeMeshes;
+	const double shapesSeconds = timeFastest(5, [&] {
+		MeshFileLoader::ObjFile objFile;
+		MeshFileLoader::parseObjAttributes(text.data(), text.size(), objFile);
+		shapeMeshes.resize(objFile.shapes.size());
+
+		JobSystem::Handle parsed;
+		for (size_t i = 0; i < objFile.shapes.size(); ++i) {
+			jobSystem.submit([&, i] {
+				MeshFileLoader::parseObjShape(objFile, i, shapeMeshes[i]);
+			}, parsed);
+		}
+		jobSystem.wait(parsed);
+	});
+	std::printf("  MeshFileLoader %2zu shapes, %2u workers %7.1f MB/s\n",
+		shapeMeshes.size(), jobSystem.numWorkerThreads(), megabytes / shapesSeconds);
+
+#ifdef HAVE_TINYOBJLOADER
+	size_t numTinyObjIndices = 0;
+	const double tinyObjSeconds = timeFastest(2, [&] {
+		std::istringstream stream(text);
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning;
+		std::string error;
+		tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, &stream);
+
+		numTinyObjIndices = 0;
+		for (const tinyobj::shape_t & shape : shapes) {
+			numTinyObjIndices += shape.mesh.indices.size();
+		}
+	});
+	std::printf("  tinyobjloader                  %7.1f MB/s, %zu vertices\n",
+		megabytes / tinyObjSeconds, numTinyObjIndices);
+#endif
+
+	return 0;
+}
@@ -0,0 +1,233 @@
+//
+// MeshFileLoaderTest.cpp
+//
+#include "Common/MeshFileLoader.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+// Attributes shared by the face tests, a unit quad in the z = 0 plane.
+const char * const QuadAttributes =
+	"v 0 0 0\n"
+	"v 1 0 0\n"
+	"v 1 1 0\n"
+	"v 0 1 0\n"
+	"vt 0 0\n"
+	"vt 1 0\n"
+	"vt 1 1\n"
+	"vt 0 1\n"
+	"vn 0 0 1\n"
+	"vn 0 0 -1\n";
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static void parse (
+	const std::string & text,
+	Mesh & mesh
+) {
+	MeshFileLoader::parseObj(text.data(), text.size(), mesh);
+}
+
+//---------------------------------------------------------------------------------------
+// True if parsing 'text' throws, rather than returning or writing out of bounds.
+static bool parseThrows (
+	const std::string & text
+) {
+	Mesh mesh;
+	try {
+		parse(text, mesh);
+	} catch (const std::runtime_error &) {
+		return true;
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------------------
+static bool hasAttributes (
+	const Mesh::Vertex & vertex,
+	float x, float y,
+	float u, float v,
+	float nz
+) {
+	return vertex.position[0] == x && vertex.position[1] == y && vertex.position[2] == 0.0f &&
+		vertex.texCoord[0] == u && vertex.texCoord[1] == v &&
+		vertex.normal[0] == 0.0f && vertex.normal[1] == 0.0f && vertex.normal[2] == nz;
+}
+
+//---------------------------------------------------------------------------------------
+// Each face vertex form reads the attributes it names, and zeroes the others.
+static void testFaceVertexForms()
+{
+	Mesh mesh;
+	parse(std::string(QuadAttributes) +
+		"f 1 2 3\n"
+		"f 1/1 2/2 3/3\n"
+		"f 1//2 2//2 3//2\n"
+		"f 1/4/1 2/3/1 3/2/1\n", mesh);
+
+	CHECK(mesh.vertices.size() == 12);
+	CHECK(mesh.indices32.size() == 12);
+	CHECK(mesh.indices16.empty());
+	for (uint32 i = 0; i < 12; ++i) {
+		CHECK(mesh.indices32[i] == i);
+	}
+
+	CHECK(hasAttributes(mesh.vertices[0], 0, 0, 0, 0, 0));
+	CHECK(hasAttributes(mesh.vertices[2], 1, 1, 0, 0, 0));
+	CHECK(hasAttributes(mesh.vertices[4], 1, 0, 1, 0, 0));
+	CHECK(hasAttributes(mesh.vertices[5], 1, 1, 1, 1, 0));
+	CHECK(hasAttributes(mesh.vertices[6], 0, 0, 0, 0, -1));
+	CHECK(hasAttributes(mesh.vertices[8], 1, 1, 0, 0, -1));
+	CHECK(hasAttributes(mesh.vertices[9], 0, 0, 0, 1, 1));
+	CHECK(hasAttributes(mesh.vertices[11], 1, 1, 1, 0, 1));
+}
+
+//---------------------------------------------------------------------------------------
+// Negative indices count back from the last element declared before the face.
+static void testNegativeIndices()
+{
+	Mesh mesh;
+	parse(std::string(QuadAttributes) +
+		"f -4/-4/-2 -3/-3/-2 -2/-2/-2\n"
+		"v 5 5 0\n"
+		"f -5 -4 -1\n", mesh);
+
+	CHECK(mesh.vertices.size() == 6);
+	CHECK(hasAttributes(mesh.vertices[0], 0, 0, 0, 0, 1));
+	CHECK(hasAttributes(mesh.vertices[1], 1, 0, 1, 0, 1));
+	CHECK(hasAttributes(mesh.vertices[2], 1, 1, 1, 1, 1));
+	CHECK(hasAttributes(mesh.vertices[3], 0, 0, 0, 0, 0));
+	CHECK(hasAttributes(mesh.vertices[4], 1, 0, 0, 0, 0));
+	CHECK(hasAttributes(mesh.vertices[5], 5, 5, 0, 0, 0));
+
+	// Reaching back past the first element is undefined.
+	CHECK(parseThrows(std::string(QuadAttributes) + "f -5 -1 -2\n"));
+}
+
+//---------------------------------------------------------------------------------------
+// Polygons are fan triangulated around their first vertex.
+static void testPolygonFans()
+{
+	Mesh mesh;
+	parse(std::string(QuadAttributes) +
+		"v 0.5 2 0\n"
+		"f 1 2 3 4\n"
+		"f 1 2 3 5 4\n", mesh);
+
+	CHECK(mesh.vertices.size() == 3 * (2 + 3));
+	const float expected[][2] = {
+		{ 0, 0 }, { 1, 0 }, { 1, 1 },
+		{ 0, 0 }, { 1, 1 }, { 0, 1 },
+		{ 0, 0 }, { 1, 0 }, { 1, 1 },
+		{ 0, 0 }, { 1, 1 }, { 0.5f, 2 },
+		{ 0, 0 }, { 0.5f, 2 }, { 0, 1 }
+	};
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+		CHECK(mesh.vertices[i].position[0] == expected[i][0]);
+		CHECK(mesh.vertices[i].position[1] == expected[i][1]);
+	}
+
+	// Degenerate faces with fewer than 3 vertices add nothing.
+	parse(std::string(QuadAttributes) + "f 1 2\nf 1\nf\n", mesh);
+	CHECK(mesh.vertices.empty() && mesh.indices32.empty());
+}
+
+//---------------------------------------------------------------------------------------
+// Whitespace, comments and line endings that are allowed around faces.
+static void testWhitespaceAndComments()
+{
+	Mesh mesh;
+	parse(std::string(QuadAttributes) +
+		"# comment\n"
+		"  f\t1 2 3 \r\n"
+		"f 1 2 3# trailing comment\n"
+		"f 1 2 3 # 4\n"
+		"f 1 3 4", mesh);
+
+	CHECK(mesh.vertices.size() == 12);
+	CHECK(hasAttributes(mesh.vertices[11], 0, 1, 0, 0, 0));
+}
+
+//---------------------------------------------------------------------------------------
+// Malformed faces are rejected instead of being read as more vertices than were counted
+// for them, which used to overrun the vertex array.
+static void testMalformedFaces()
+{
+	const std::string attributes = QuadAttributes;
+
+	CHECK(parseThrows(attributes + "f 1 2 3-1\n"));
+	CHECK(parseThrows(attributes + "f 1 2-3 4\n"));
+	CHECK(parseThrows(attributes + "f 1 2 3-1-2-3-4\nf 1 2 3\n"));
+	CHECK(parseThrows(attributes + "f 1/1/1/1 2 3\n"));
+	CHECK(parseThrows(attributes + "f 1 2 3x\n"));
+	CHECK(parseThrows(attributes + "f 1 2 3.5\n"));
+	CHECK(parseThrows(attributes + "f 1 2 3-"));
+
+	// Undefined and missing elements.
+	CHECK(parseThrows(attributes + "f 1 2 5\n"));
+	CHECK(parseThrows(attributes + "f 0 1 2\n"));
+	CHECK(parseThrows(attributes + "f 1 2 -5\n"));
+	CHECK(parseThrows(attributes + "f 1/5 2 3\n"));
+	CHECK(parseThrows(attributes + "f 1//3 2 3\n"));
+	CHECK(parseThrows(attributes + "f /1 2 3\n"));
+	CHECK(parseThrows("f 1 2 3\n"));
+}
+
+//---------------------------------------------------------------------------------------
+// Shapes are located by their "o" and "g" statements and parsed separately.
+static void testShapes()
+{
+	const std::string text = std::string(QuadAttributes) +
+		"o first \n"
+		"f 1 2 3\n"
+		"g empty\n"
+		"o second\n"
+		"v 2 2 0\n"
+		"f 1 3 -1 4\n"
+		"o ";
+
+	MeshFileLoader::ObjFile objFile;
+	MeshFileLoader::parseObjAttributes(text.data(), text.size(), objFile);
+	CHECK(objFile.positions.size() == 5);
+	CHECK(objFile.texCoords.size() == 4);
+	CHECK(objFile.normals.size() == 2);
+
+	CHECK(objFile.shapes.size() == 2);
+	CHECK(objFile.shapes[0].name == "first");
+	CHECK(objFile.shapes[0].numCorners == 3);
+	CHECK(objFile.shapes[1].name == "second");
+	CHECK(objFile.shapes[1].numCorners == 6);
+	CHECK(objFile.shapes[1].numPrecedingPositions == 4);
+
+	Mesh mesh;
+	MeshFileLoader::parseObjShape(objFile, 1, mesh);
+	CHECK(mesh.vertices.size() == 6);
+	CHECK(hasAttributes(mesh.vertices[2], 2, 2, 0, 0, 0));
+	CHECK(hasAttributes(mesh.vertices[5], 0, 1, 0, 0, 0));
+
+	// Merged, the shapes are parsed in file order.
+	parse(text, mesh);
+	CHECK(mesh.vertices.size() == 9);
+	CHECK(hasAttributes(mesh.vertices[5], 2, 2, 0, 0, 0));
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testFaceVertexForms);
+	RUN_TEST(testNegativeIndices);
+	RUN_TEST(testPolygonFans);
+	RUN_TEST(testWhitespaceAndComments);
+	RUN_TEST(testMalformedFaces);
+	RUN_TEST(testShapes);
+
+	return 0;
+}
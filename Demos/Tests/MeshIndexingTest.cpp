@@ -0,0 +1,189 @@
+//
+// MeshIndexingTest.cpp
+//
+#include "Common/MeshIndexing.hpp"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Mesh of 'numVertices' vertices, each identified by its position.x, with triangles
+// fanning out from vertex 0 so that the last vertex is always referenced.
+static Mesh createFan (
+	size_t numVertices
+) {
+	Mesh mesh;
+	mesh.vertices.resize(numVertices);
+	for (size_t v = 0; v < numVertices; ++v) {
+		Mesh::Vertex vertex = {};
+		vertex.position[0] = float(v);
+		mesh.vertices[v] = vertex;
+	}
+	for (uint32 v = 1; v + 1 < numVertices; ++v) {
+		const uint32 triangle[] = { 0, v, v + 1 };
+		mesh.indices32.insert(mesh.indices32.end(), triangle, triangle + 3);
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Regular grid of 'size' x 'size' vertices, identified by their position.x, with
+// triangles in row order.
+static Mesh createGrid (
+	uint32 size
+) {
+	Mesh mesh;
+	for (uint32 v = 0; v < size * size; ++v) {
+		Mesh::Vertex vertex = {};
+		vertex.position[0] = float(v);
+		mesh.vertices.push_back(vertex);
+	}
+	for (uint32 y = 0; y + 1 < size; ++y) {
+		for (uint32 x = 0; x + 1 < size; ++x) {
+			const uint32 a = y * size + x;
+			const uint32 b = a + 1;
+			const uint32 c = a + size;
+			const uint32 d = c + 1;
+			const uint32 quad[] = { a, b, c, b, d, c };
+			mesh.indices32.insert(mesh.indices32.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// 65535 vertices fit 16-bit indices, leaving 0xFFFF unused, and 65536 need 32-bit.
+static void testSelectIndexSize()
+{
+	Mesh mesh = createFan(65535);
+	const std::vector<uint32> indices = mesh.indices32;
+	CHECK(MeshIndexing::selectIndexSize(mesh) == 2);
+	CHECK(mesh.indices32.empty());
+	CHECK(mesh.indices16.size() == indices.size());
+	CHECK(*std::max_element(mesh.indices16.begin(), mesh.indices16.end()) == 65534);
+	CHECK(std::equal(indices.begin(), indices.end(), mesh.indices16.begin()));
+
+	mesh = createFan(65536);
+	CHECK(MeshIndexing::selectIndexSize(mesh) == 4);
+	CHECK(mesh.indices16.empty());
+	CHECK(mesh.indices32.back() == 65535);
+
+	// A mesh holding 16-bit indices widens them once it outgrows them.
+	mesh = createFan(65535);
+	MeshIndexing::selectIndexSize(mesh);
+	Mesh::Vertex vertex = {};
+	mesh.vertices.push_back(vertex);
+	CHECK(MeshIndexing::selectIndexSize(mesh) == 4);
+	CHECK(std::equal(indices.begin(), indices.end(), mesh.indices32.begin()));
+}
+
+//---------------------------------------------------------------------------------------
+// Every chunk addresses at most 'maxVerticesPerChunk' vertices through 16-bit indices
+// offset by its base vertex, which resolve to the original triangles' vertices.
+static void checkChunks (
+	const Mesh & original,
+	const Mesh & mesh,
+	size_t maxVerticesPerChunk
+) {
+	CHECK(mesh.indices32.empty());
+	CHECK(mesh.indices16.size() == original.indices32.size());
+
+	uint32 nextIndex = 0;
+	int32 nextBaseVertex = 0;
+	for (const Mesh::Submesh & chunk : mesh.submeshes) {
+		CHECK(chunk.startIndex == nextIndex);
+		CHECK(chunk.numIndices > 0 && chunk.numIndices % 3 == 0);
+		CHECK(chunk.baseVertex == nextBaseVertex);
+
+		std::set<uint16> chunkVertices;
+		for (uint32 i = chunk.startIndex; i < chunk.startIndex + chunk.numIndices; ++i) {
+			const size_t vertex = size_t(chunk.baseVertex) + mesh.indices16[i];
+			CHECK(vertex < mesh.vertices.size());
+			CHECK(mesh.vertices[vertex].position[0] == float(original.indices32[i]));
+			chunkVertices.insert(mesh.indices16[i]);
+		}
+
+		// Chunk vertices are packed, each one referenced.
+		CHECK(chunkVertices.size() <= maxVerticesPerChunk);
+		CHECK(*chunkVertices.rbegin() == chunkVertices.size() - 1);
+
+		nextIndex += chunk.numIndices;
+		nextBaseVertex += int32(chunkVertices.size());
+	}
+	CHECK(nextIndex == original.indices32.size());
+	CHECK(size_t(nextBaseVertex) == mesh.vertices.size());
+}
+
+//---------------------------------------------------------------------------------------
+static void testSplitInto16BitChunks()
+{
+	// Too large for 16-bit indices, 90000 vertices split into two chunks.
+	const Mesh grid = createGrid(300);
+	Mesh mesh = grid;
+	CHECK(MeshIndexing::splitInto16BitChunks(mesh) == 2);
+	CHECK(mesh.indexSize() == 2);
+	checkChunks(grid, mesh, MeshIndexing::MaxVerticesPer16BitChunk);
+	CHECK(mesh.submeshes[0].numIndices / 3 > 100000);
+
+	// Smaller chunks duplicate the vertices shared along their boundaries.
+	mesh = grid;
+	const size_t numChunks = MeshIndexing::splitInto16BitChunks(mesh, 1000);
+	CHECK(numChunks > 90);
+	checkChunks(grid, mesh, 1000);
+	CHECK(mesh.vertices.size() > grid.vertices.size());
+
+	// A mesh that already fits is given 16-bit indices, without Submeshes.
+	mesh = createFan(65535);
+	CHECK(MeshIndexing::splitInto16BitChunks(mesh) == 0);
+	CHECK(mesh.submeshes.empty() && mesh.indexSize() == 2);
+}
+
+//---------------------------------------------------------------------------------------
+// Meshlets are kept whole within a chunk, and take on its base vertex.
+static void testSplitKeepsMeshletsWhole()
+{
+	const Mesh grid = createGrid(40);
+	Mesh mesh = grid;
+
+	// One meshlet per row of quads.
+	const uint32 indicesPerRow = 39 * 6;
+	for (uint32 row = 0; row < 39; ++row) {
+		Mesh::Meshlet meshlet = {};
+		meshlet.startIndex = row * indicesPerRow;
+		meshlet.numIndices = indicesPerRow;
+		meshlet.numVertices = 80;
+		mesh.meshlets.push_back(meshlet);
+	}
+
+	// Rows share half their vertices with the previous one, so three rows fit each chunk.
+	const size_t maxVerticesPerChunk = 200;
+	CHECK(MeshIndexing::splitInto16BitChunks(mesh, maxVerticesPerChunk) == 13);
+	checkChunks(grid, mesh, maxVerticesPerChunk);
+
+	for (const Mesh::Meshlet & meshlet : mesh.meshlets) {
+		size_t numContaining = 0;
+		for (const Mesh::Submesh & chunk : mesh.submeshes) {
+			if (meshlet.startIndex >= chunk.startIndex &&
+				meshlet.startIndex + meshlet.numIndices <= chunk.startIndex + chunk.numIndices)
+			{
+				CHECK(meshlet.baseVertex == chunk.baseVertex);
+				++numContaining;
+			}
+		}
+		CHECK(numContaining == 1);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testSelectIndexSize);
+	RUN_TEST(testSplitInto16BitChunks);
+	RUN_TEST(testSplitKeepsMeshletsWhole);
+
+	return 0;
+}
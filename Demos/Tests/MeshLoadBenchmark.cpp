@@ -0,0 +1,218 @@
+//
+// MeshLoadBenchmark.cpp
+//
+// Times loading a directory of OBJ files as MeshLoader does, one job per file and one
+// per shape, parsed and processed on a JobSystem of 1 to N workers, where N is the
+// number of hardware threads.
+//
+// Loads the OBJ files given on the command line, or else those in Assets/Meshes along
+// with a generated grid of 16 shapes, large enough for the sweep to show scaling.
+//
+#include "Common/JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <dirent.h>
+#endif
+
+#include "Common/MappedFile.hpp"
+#include "Common/MeshFileLoader.hpp"
+
+#include "MeshPipeline.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+// Paths of the .obj files in 'directory', sorted.
+static std::vector<std::string> listObjFiles (
+	const std::string & directory
+) {
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA((directory + "\\*.obj").c_str(), &findData);
+	if (find != INVALID_HANDLE_VALUE) {
+		do {
+			names.push_back(findData.cFileName);
+		} while (FindNextFileA(find, &findData));
+		FindClose(find);
+	}
+#else
+	if (DIR * dir = opendir(directory.c_str())) {
+		while (const dirent * entry = readdir(dir)) {
+			const std::string name = entry->d_name;
+			if (name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0) {
+				names.push_back(name);
+			}
+		}
+		closedir(dir);
+	}
+#endif
+	std::sort(names.begin(), names.end());
+
+	std::vector<std::string> paths;
+	for (const std::string & name : names) {
+		paths.push_back(directory + "/" + name);
+	}
+	return paths;
+}
+
+//---------------------------------------------------------------------------------------
+// Writes a wavy grid of 'size' x 'size' vertices drawn with quads to 'path', split
+// into 'numShapes' shapes of whole rows.
+static void writeGridObj (
+	const char * path,
+	uint size,
+	uint numShapes
+) {
+	FILE * file = std::fopen(path, "wb");
+	if (!file) {
+		std::fprintf(stderr, "Unable to create %s\n", path);
+		std::exit(EXIT_FAILURE);
+	}
+	for (uint y = 0; y < size; ++y) {
+		for (uint x = 0; x < size; ++x) {
+			std::fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0 0 1\n",
+				x * 0.01f, y * 0.01f, ((x * 7 + y * 13) % 100) * 0.001f,
+				float(x) / size, float(y) / size);
+		}
+	}
+	const uint rowsPerShape = (size - 1 + numShapes - 1) / numShapes;
+	for (uint y = 0; y + 1 < size; ++y) {
+		if (y % rowsPerShape == 0) {
+			std::fprintf(file, "o rows_%u\n", y);
+		}
+		for (uint x = 0; x + 1 < size; ++x) {
+			const uint a = y * size + x + 1;
+			const uint c = a + size;
+			std::fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n",
+				a, a, a + 1, a + 1, c + 1, c + 1, c, c);
+		}
+	}
+	std::fclose(file);
+}
+
+//---------------------------------------------------------------------------------------
+// Loads every shape of every file in 'objPaths' into 'meshes', returning the number of
+// bytes read.
+static size_t loadMeshes (
+	const std::vector<std::string> & objPaths,
+	JobSystem & jobSystem,
+	std::vector<std::vector<Mesh>> & meshes
+) {
+	meshes.clear();
+	meshes.resize(objPaths.size());
+	std::vector<size_t> fileSizes(objPaths.size());
+
+	JobSystem::Handle loaded;
+	for (size_t f = 0; f < objPaths.size(); ++f) {
+		jobSystem.submit([&, f] {
+			MappedFile mappedFile;
+			if (!mappedFile.open(objPaths[f].c_str())) {
+				std::fprintf(stderr, "Unable to open %s\n", objPaths[f].c_str());
+				std::exit(EXIT_FAILURE);
+			}
+			fileSizes[f] = mappedFile.size();
+
+			MeshFileLoader::ObjFile objFile;
+			MeshFileLoader::parseObjAttributes (
+				reinterpret_cast<const char *>(mappedFile.data()), mappedFile.size(), objFile
+			);
+
+			std::vector<Mesh> & shapeMeshes = meshes[f];
+			shapeMeshes.resize(objFile.shapes.size());
+
+			JobSystem::Handle shapes;
+			for (size_t s = 0; s < objFile.shapes.size(); ++s) {
+				jobSystem.submit([&, s] {
+					MeshFileLoader::parseObjShape(objFile, s, shapeMeshes[s]);
+					MeshPipeline::processMesh(shapeMeshes[s]);
+				}, shapes);
+			}
+			jobSystem.wait(shapes);
+		}, loaded);
+	}
+	jobSystem.wait(loaded);
+
+	size_t numBytes = 0;
+	for (size_t fileSize : fileSizes) {
+		numBytes += fileSize;
+	}
+	return numBytes;
+}
+
+//---------------------------------------------------------------------------------------
+int main (
+	int argc,
+	char ** argv
+) {
+	std::vector<std::string> objPaths(argv + 1, argv + argc);
+	if (objPaths.empty()) {
+		objPaths = listObjFiles(MESH_ASSETS_DIR);
+		objPaths.push_back("MeshLoadBenchmark.obj");
+		writeGridObj(objPaths.back().c_str(), 300, 16);
+	}
+
+	const uint numHardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<uint> workerCounts;
+	for (uint n = 1; n < numHardwareThreads; n *= 2) {
+		workerCounts.push_back(n);
+	}
+	workerCounts.push_back(numHardwareThreads);
+
+	std::printf("Loading %zu OBJ files on %u hardware threads\n",
+		objPaths.size(), numHardwareThreads);
+
+	double singleWorkerSeconds = 0.0;
+	for (uint numWorkerThreads : workerCounts) {
+		JobSystem jobSystem(numWorkerThreads);
+		std::vector<std::vector<Mesh>> meshes;
+		size_t numBytes = 0;
+		const double seconds = timeFastest(3, [&] {
+			numBytes = loadMeshes(objPaths, jobSystem, meshes);
+		});
+		singleWorkerSeconds = (numWorkerThreads == 1) ? seconds : singleWorkerSeconds;
+
+		size_t numShapes = 0;
+		size_t numTriangles = 0;
+		for (const std::vector<Mesh> & shapeMeshes : meshes) {
+			numShapes += shapeMeshes.size();
+			for (const Mesh & mesh : shapeMeshes) {
+				numTriangles += mesh.lods.empty() ? mesh.numIndices() / 3 : mesh.lods[0].numIndices / 3;
+			}
+		}
+
+		std::printf("  %2u workers: %zu shapes, %zu triangles in %8.2f ms, %6.1f MB/s, %.2fx\n",
+			numWorkerThreads, numShapes, numTriangles, seconds * 1000.0,
+			numBytes * 1.0e-6 / seconds, singleWorkerSeconds / seconds);
+	}
+
+	return 0;
+}
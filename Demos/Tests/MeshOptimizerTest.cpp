@@ -0,0 +1,169 @@
+//
+// MeshOptimizerTest.cpp
+//
+#include "Common/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+typedef std::array<uint32, 3> Triangle;
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+// Regular grid of 'size' x 'size' vertices, with triangles in row order.
+static Mesh createGrid (
+	uint size
+) {
+	Mesh mesh;
+	for (uint y = 0; y < size; ++y) {
+		for (uint x = 0; x < size; ++x) {
+			Mesh::Vertex vertex = {};
+			vertex.position[0] = float(x);
+			vertex.position[1] = float(y);
+			vertex.normal[2] = 1.0f;
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	for (uint y = 0; y + 1 < size; ++y) {
+		for (uint x = 0; x + 1 < size; ++x) {
+			const uint32 a = y * size + x;
+			const uint32 b = a + 1;
+			const uint32 c = a + size;
+			const uint32 d = c + 1;
+			const uint32 quad[] = {a, b, c, b, d, c};
+			mesh.indices32.insert(mesh.indices32.end(), quad, quad + 6);
+		}
+	}
+
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Triangles of 'mesh' by vertex position, independent of triangle, vertex and winding
+// order, so that reordering passes can be checked to preserve them.
+static std::vector<Triangle> sortedTriangles (
+	const Mesh & mesh
+) {
+	std::vector<Triangle> triangles;
+	for (size_t i = 0; i < mesh.indices32.size(); i += 3) {
+		Triangle triangle;
+		for (uint corner = 0; corner < 3; ++corner) {
+			const Mesh::Vertex & vertex = mesh.vertices[mesh.indices32[i + corner]];
+			triangle[corner] = uint32(vertex.position[1]) * 65536 + uint32(vertex.position[0]);
+		}
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()),
+			triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+
+	return triangles;
+}
+
+//---------------------------------------------------------------------------------------
+static void testAnalyzeVertexCache()
+{
+	// Two triangles sharing an edge.
+	const uint32 quad[] = {0, 1, 2, 1, 3, 2};
+	MeshOptimizer::CacheStatistics statistics =
+		MeshOptimizer::analyzeVertexCache(quad, 6, 4);
+	CHECK(statistics.numTransformed == 4);
+	CHECK(statistics.acmr == 2.0f);
+	CHECK(statistics.atvr == 1.0f);
+
+	// A cache of 3 entries evicts vertex 0 before it is used again.
+	const uint32 fan[] = {0, 1, 2, 3, 4, 5, 0, 5, 1};
+	statistics = MeshOptimizer::analyzeVertexCache(fan, 9, 6, 3);
+	CHECK(statistics.numTransformed == 8);
+	statistics = MeshOptimizer::analyzeVertexCache(fan, 9, 6, 16);
+	CHECK(statistics.numTransformed == 6);
+}
+
+//---------------------------------------------------------------------------------------
+// ACMR of a fixed grid must not regress.  The bounds are the values reached when this
+// test was written, 0.5 being the limit for an infinitely large grid.
+static void testGridAcmr()
+{
+	const Mesh rowOrderGrid = createGrid(64);
+	const MeshOptimizer::CacheStatistics rowOrder =
+		MeshOptimizer::analyzeVertexCache(rowOrderGrid);
+
+	// Shuffled, so the optimizer cannot lean on the input order.
+	Mesh grid = rowOrderGrid;
+	std::vector<Triangle> triangles;
+	for (size_t i = 0; i < grid.indices32.size(); i += 3) {
+		triangles.push_back(Triangle{{
+			grid.indices32[i], grid.indices32[i + 1], grid.indices32[i + 2]
+		}});
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+	grid.indices32.clear();
+	for (const Triangle & triangle : triangles) {
+		grid.indices32.insert(grid.indices32.end(), triangle.begin(), triangle.end());
+	}
+
+	const std::vector<Triangle> expectedTriangles = sortedTriangles(grid);
+	const MeshOptimizer::CacheStatistics shuffled = MeshOptimizer::analyzeVertexCache(grid);
+	CHECK(shuffled.acmr > 2.5f);
+
+	MeshOptimizer::optimizeVertexCache (
+		grid.indices32.data(), grid.indices32.size(), grid.vertices.size()
+	);
+	const MeshOptimizer::CacheStatistics optimized = MeshOptimizer::analyzeVertexCache(grid);
+	std::printf("  row order ACMR %.3f, shuffled %.3f, optimized %.3f\n",
+		rowOrder.acmr, shuffled.acmr, optimized.acmr);
+	CHECK(optimized.acmr < 0.70f);
+	CHECK(optimized.acmr < rowOrder.acmr);
+	CHECK(optimized.atvr < 1.40f);
+
+	// The later passes trade little cache efficiency.
+	MeshOptimizer::optimizeOverdraw (
+		grid.indices32.data(), grid.indices32.size(), grid.vertices.data(), grid.vertices.size()
+	);
+	const MeshOptimizer::CacheStatistics overdraw = MeshOptimizer::analyzeVertexCache(grid);
+	CHECK(overdraw.acmr < 0.75f);
+
+	MeshOptimizer::optimizeVertexFetch(grid);
+	const MeshOptimizer::CacheStatistics fetch = MeshOptimizer::analyzeVertexCache(grid);
+	CHECK(fetch.acmr == overdraw.acmr);
+	CHECK(grid.vertices.size() == rowOrderGrid.vertices.size());
+
+	// No pass may drop, add or change triangles.
+	CHECK(sortedTriangles(grid) == expectedTriangles);
+}
+
+//---------------------------------------------------------------------------------------
+static void testVertexFetchOrder()
+{
+	Mesh mesh = createGrid(4);
+
+	// Reference the vertices backwards, leaving vertex 15 unused.
+	mesh.indices32 = {14, 13, 10, 13, 9, 10};
+	MeshOptimizer::optimizeVertexFetch(mesh);
+
+	CHECK(mesh.vertices.size() == 4);
+	const uint32 expectedIndices[] = {0, 1, 2, 1, 3, 2};
+	CHECK(std::equal(mesh.indices32.begin(), mesh.indices32.end(), expectedIndices));
+	CHECK(mesh.vertices[0].position[0] == 2.0f && mesh.vertices[0].position[1] == 3.0f);
+	CHECK(mesh.vertices[3].position[0] == 1.0f && mesh.vertices[3].position[1] == 2.0f);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testAnalyzeVertexCache);
+	RUN_TEST(testGridAcmr);
+	RUN_TEST(testVertexFetchOrder);
+
+	return 0;
+}
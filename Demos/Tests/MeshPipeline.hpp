@@ -0,0 +1,37 @@
+//
+// MeshPipeline.hpp
+//
+#pragma once
+
+#include "Common/Mesh.hpp"
+#include "Common/MeshIndexing.hpp"
+#include "Common/Meshlets.hpp"
+#include "Common/MeshOptimizer.hpp"
+#include "Common/MeshSimplifier.hpp"
+#include "Common/MeshWelder.hpp"
+
+
+/**
+* The processing MeshLoader applies to a freshly parsed mesh with its default
+* LoadOptions, for benchmarks that time loads without D3D12.
+*/
+namespace MeshPipeline {
+
+	/// Welds, optimizes, builds meshlets and LODs for, and indexes 'mesh'.
+	inline void processMesh (
+		Mesh & mesh
+	) {
+		MeshWelder::weldVertices(mesh);
+		MeshOptimizer::optimizeVertexCache (
+			mesh.indices32.data(), mesh.indices32.size(), mesh.vertices.size()
+		);
+		MeshOptimizer::optimizeOverdraw (
+			mesh.indices32.data(), mesh.indices32.size(),
+			mesh.vertices.data(), mesh.vertices.size()
+		);
+		Meshlets::buildMeshlets(mesh);
+		MeshSimplifier::generateLods(mesh);
+		MeshOptimizer::optimizeVertexFetch(mesh);
+		MeshIndexing::selectIndexSize(mesh);
+	}
+};
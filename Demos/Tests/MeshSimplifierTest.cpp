@@ -0,0 +1,304 @@
+//
+// MeshSimplifierTest.cpp
+//
+#include "Common/MeshSimplifier.hpp"
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Unit sphere of 'numRings' x 'numSegments' quads, with a UV seam where its segments
+// wrap around.
+static Mesh createSphere (
+	uint32 numRings,
+	uint32 numSegments
+) {
+	const float pi = 3.14159265f;
+
+	Mesh mesh;
+	for (uint32 ring = 0; ring <= numRings; ++ring) {
+		const float theta = pi * ring / numRings;
+		for (uint32 segment = 0; segment <= numSegments; ++segment) {
+			const float phi = 2.0f * pi * segment / numSegments;
+			Mesh::Vertex vertex = {};
+			vertex.position[0] = std::sin(theta) * std::cos(phi);
+			vertex.position[1] = std::cos(theta);
+			vertex.position[2] = std::sin(theta) * std::sin(phi);
+			for (int i = 0; i < 3; ++i) {
+				vertex.normal[i] = vertex.position[i];
+			}
+			vertex.texCoord[0] = float(segment) / numSegments;
+			vertex.texCoord[1] = float(ring) / numRings;
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	for (uint32 ring = 0; ring < numRings; ++ring) {
+		for (uint32 segment = 0; segment < numSegments; ++segment) {
+			const uint32 a = ring * (numSegments + 1) + segment;
+			const uint32 b = a + 1;
+			const uint32 c = a + numSegments + 1;
+			const uint32 d = c + 1;
+			const uint32 quad[] = { a, b, c, b, d, c };
+			mesh.indices32.insert(mesh.indices32.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Gently curved 'size' x 'size' grid with a seam down its middle column.  Triangles to
+// the right of the seam use copies of the seam vertices, appended after the grid, whose
+// UVs or, without 'isUvSeam', normals differ from the originals.
+static Mesh createSeamedGrid (
+	uint32 size,
+	bool isUvSeam
+) {
+	const uint32 seam = size / 2;
+
+	Mesh mesh;
+	for (uint32 y = 0; y < size; ++y) {
+		for (uint32 x = 0; x < size; ++x) {
+			Mesh::Vertex vertex = {};
+			vertex.position[0] = float(x) / (size - 1);
+			vertex.position[1] = float(y) / (size - 1);
+			vertex.position[2] = 0.05f * std::sin(3.0f * vertex.position[0]) *
+				std::cos(2.0f * vertex.position[1]);
+			vertex.normal[2] = 1.0f;
+			vertex.texCoord[0] = vertex.position[0];
+			vertex.texCoord[1] = vertex.position[1];
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	for (uint32 y = 0; y < size; ++y) {
+		Mesh::Vertex vertex = mesh.vertices[y * size + seam];
+		if (isUvSeam) {
+			vertex.texCoord[0] += 1.0f;
+		} else {
+			vertex.normal[0] = 1.0f;
+			vertex.normal[2] = 0.0f;
+		}
+		mesh.vertices.push_back(vertex);
+	}
+
+	// Vertex at 'x, y', as seen from a triangle on the 'isRight' side of the seam.
+	auto vertexAt = [&](uint32 x, uint32 y, bool isRight) {
+		return (x == seam && isRight) ? size * size + y : y * size + x;
+	};
+
+	for (uint32 y = 0; y + 1 < size; ++y) {
+		for (uint32 x = 0; x + 1 < size; ++x) {
+			const bool isRight = x >= seam;
+			const uint32 a = vertexAt(x, y, isRight);
+			const uint32 b = vertexAt(x + 1, y, isRight);
+			const uint32 c = vertexAt(x, y + 1, isRight);
+			const uint32 d = vertexAt(x + 1, y + 1, isRight);
+			const uint32 quad[] = { a, b, c, b, d, c };
+			mesh.indices32.insert(mesh.indices32.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Every LOD reaches its share of the previous level's triangles, and errors grow with
+// each level while staying within the limit.
+static void testLodTargets()
+{
+	Mesh mesh = createSphere(48, 96);
+	const size_t numTriangles = mesh.indices32.size() / 3;
+
+	MeshSimplifier::LodOptions options;
+	options.numLods = 5;
+	options.reduction = 0.5f;
+	options.maxRelativeError = 0.1f;
+	CHECK(MeshSimplifier::generateLods(mesh, options) == 5);
+	CHECK(mesh.lods.size() == 5);
+
+	CHECK(mesh.lods[0].startIndex == 0);
+	CHECK(mesh.lods[0].numIndices == numTriangles * 3);
+	CHECK(mesh.lods[0].error == 0.0f);
+
+	// Diagonal of the sphere's bounds.
+	const float maxError = options.maxRelativeError * 2.0f * std::sqrt(3.0f);
+
+	for (size_t i = 1; i < mesh.lods.size(); ++i) {
+		const Mesh::Lod & previous = mesh.lods[i - 1];
+		const Mesh::Lod & lod = mesh.lods[i];
+
+		const size_t target = size_t((previous.numIndices / 3) * options.reduction);
+		CHECK(lod.numIndices / 3 <= target);
+		CHECK(lod.numIndices / 3 >= target * 3 / 4);
+
+		CHECK(lod.error > previous.error);
+		CHECK(lod.error <= maxError);
+
+		// Appended after the previous level, and indexing the shared vertices.
+		CHECK(lod.startIndex == previous.startIndex + previous.numIndices);
+		for (uint32 index = lod.startIndex; index < lod.startIndex + lod.numIndices; ++index) {
+			CHECK(mesh.indices32[index] < mesh.vertices.size());
+		}
+	}
+	CHECK(mesh.indices32.size() == mesh.lods.back().startIndex + mesh.lods.back().numIndices);
+
+	// The coarsest level still looks like a sphere: its vertices are original ones, and
+	// its triangle centers lie within its error of the surface.
+	const Mesh::Lod & coarsest = mesh.lods.back();
+	for (uint32 i = coarsest.startIndex; i < coarsest.startIndex + coarsest.numIndices; i += 3) {
+		float center[3] = {};
+		for (uint32 corner = 0; corner < 3; ++corner) {
+			for (int a = 0; a < 3; ++a) {
+				center[a] += mesh.vertices[mesh.indices32[i + corner]].position[a] / 3.0f;
+			}
+		}
+		const float radius = std::sqrt(center[0] * center[0] + center[1] * center[1] +
+			center[2] * center[2]);
+		CHECK(1.0f - radius <= 4.0f * coarsest.error);
+	}
+
+	// A tight error limit stops the levels early.
+	Mesh limited = createSphere(48, 96);
+	options.maxRelativeError = 0.001f;
+	CHECK(MeshSimplifier::generateLods(limited, options) < 5);
+
+	// A single level leaves the mesh as it was.
+	Mesh single = createSphere(8, 16);
+	const std::vector<uint32> indices = single.indices32;
+	options.numLods = 1;
+	CHECK(MeshSimplifier::generateLods(single, options) == 1);
+	CHECK(single.indices32 == indices);
+}
+
+//---------------------------------------------------------------------------------------
+// simplify() stops at its target, or at the error limit when that comes first.
+static void testSimplifyTargets()
+{
+	const Mesh mesh = createSphere(32, 64);
+	const size_t numIndices = mesh.indices32.size();
+
+	std::vector<uint32> result;
+	float previousError = 0.0f;
+	for (size_t divisor : { 2, 4, 8, 16 }) {
+		const size_t target = (numIndices / 3 / divisor) * 3;
+		const float error = MeshSimplifier::simplify (
+			mesh.vertices.data(), mesh.vertices.size(), mesh.indices32.data(), numIndices,
+			target, 1.0f, result
+		);
+		CHECK(result.size() <= target && result.size() >= target * 3 / 4);
+		CHECK(result.size() % 3 == 0);
+		CHECK(error > previousError);
+		previousError = error;
+	}
+
+	const float error = MeshSimplifier::simplify (
+		mesh.vertices.data(), mesh.vertices.size(), mesh.indices32.data(), numIndices,
+		0, 0.01f, result
+	);
+	CHECK(error <= 0.01f);
+	CHECK(!result.empty() && result.size() < numIndices);
+}
+
+//---------------------------------------------------------------------------------------
+// Vertices on either side of a UV or normal seam are never collapsed across it: each
+// triangle keeps to one side, and both sides keep the same seam positions, so the seam
+// neither smears attributes nor opens cracks.
+static void testSeams()
+{
+	const uint32 size = 33;
+	const uint32 seam = size / 2;
+
+	for (bool isUvSeam : { true, false }) {
+		const Mesh mesh = createSeamedGrid(size, isUvSeam);
+		const size_t numIndices = mesh.indices32.size();
+
+		std::vector<uint32> result;
+		MeshSimplifier::simplify (
+			mesh.vertices.data(), mesh.vertices.size(), mesh.indices32.data(), numIndices,
+			numIndices / 10, 1.0f, result
+		);
+		CHECK(result.size() < numIndices / 4);
+
+		std::set<uint32> leftSeamRows;
+		std::set<uint32> rightSeamRows;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			bool hasLeft = false;
+			bool hasRight = false;
+			for (size_t corner = 0; corner < 3; ++corner) {
+				const uint32 vertex = result[i + corner];
+				if (vertex >= size * size) {
+					// Right hand copy of a seam vertex.
+					hasRight = true;
+					rightSeamRows.insert(vertex - size * size);
+				} else if (vertex % size == seam) {
+					hasLeft = true;
+					leftSeamRows.insert(vertex / size);
+				} else {
+					hasLeft = hasLeft || vertex % size < seam;
+					hasRight = hasRight || vertex % size > seam;
+				}
+			}
+			CHECK(!(hasLeft && hasRight));
+		}
+
+		CHECK(leftSeamRows == rightSeamRows);
+
+		// Seam corners stay put, the seam is simplified along its length.
+		CHECK(leftSeamRows.count(0) == 1 && leftSeamRows.count(size - 1) == 1);
+		CHECK(leftSeamRows.size() < size);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Coarser levels are selected as the viewer moves away, once their error projects to
+// no more than the allowed pixels.
+static void testSelectLod()
+{
+	const Mesh::Lod lods[] = {
+		{ 0, 300, 0.0f }, { 300, 150, 0.01f }, { 450, 75, 0.04f }, { 525, 36, 0.2f }
+	};
+	const float pixelsPerUnit = 1000.0f;
+
+	// Level 1 projects to 1 pixel at distance 10, level 2 at 40 and level 3 at 200.
+	CHECK(MeshSimplifier::selectLod(lods, 4, 0.0f, pixelsPerUnit) == 0);
+	CHECK(MeshSimplifier::selectLod(lods, 4, 5.0f, pixelsPerUnit) == 0);
+	CHECK(MeshSimplifier::selectLod(lods, 4, 10.0f, pixelsPerUnit) == 1);
+	CHECK(MeshSimplifier::selectLod(lods, 4, 39.0f, pixelsPerUnit) == 1);
+	CHECK(MeshSimplifier::selectLod(lods, 4, 40.0f, pixelsPerUnit) == 2);
+	CHECK(MeshSimplifier::selectLod(lods, 4, 200.0f, pixelsPerUnit) == 3);
+	CHECK(MeshSimplifier::selectLod(lods, 4, 1.0e6f, pixelsPerUnit) == 3);
+
+	// A larger pixel budget reaches coarser levels sooner.
+	CHECK(MeshSimplifier::selectLod(lods, 4, 10.0f, pixelsPerUnit, 4.0f) == 2);
+	CHECK(MeshSimplifier::selectLod(lods, 1, 1.0e6f, pixelsPerUnit) == 0);
+
+	// Generated levels are never selected in reverse as the distance grows.
+	Mesh mesh = createSphere(48, 96);
+	MeshSimplifier::generateLods(mesh);
+	CHECK(mesh.lods.size() > 2);
+	size_t previous = 0;
+	size_t numChanges = 0;
+	for (float distance = 0.5f; distance < 1.0e4f; distance *= 1.1f) {
+		const size_t selected = MeshSimplifier::selectLod (
+			mesh.lods.data(), mesh.lods.size(), distance, pixelsPerUnit
+		);
+		CHECK(selected >= previous);
+		numChanges += (selected != previous) ? 1 : 0;
+		previous = selected;
+	}
+	CHECK(previous == mesh.lods.size() - 1);
+	CHECK(numChanges == mesh.lods.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testLodTargets);
+	RUN_TEST(testSimplifyTargets);
+	RUN_TEST(testSeams);
+	RUN_TEST(testSelectLod);
+
+	return 0;
+}
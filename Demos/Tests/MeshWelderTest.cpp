@@ -0,0 +1,201 @@
+//
+// MeshWelderTest.cpp
+//
+#include "Common/MeshWelder.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+//---------------------------------------------------------------------------------------
+static Mesh::Vertex makeVertex (
+	float x, float y, float z,
+	float nx, float ny, float nz,
+	float u, float v
+) {
+	const Mesh::Vertex vertex = { { x, y, z }, { nx, ny, nz }, { u, v } };
+	return vertex;
+}
+
+//---------------------------------------------------------------------------------------
+// Unit cube as a triangle soup of 36 vertices, one per corner, as loaded from an OBJ.
+// Each face has its own normal and UVs, so its 4 corners only weld within the face.
+static Mesh createCubeSoup()
+{
+	// Per face: normal, then two axes spanning the face from its corner at -normal.
+	const float faces[6][3][3] = {
+		{ {  1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+		{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+		{ { 0,  1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+		{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+		{ { 0, 0,  1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+		{ { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } }
+	};
+	const float cornerUvs[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+	const uint quadCorners[6] = { 0, 1, 2, 0, 2, 3 };
+
+	Mesh mesh;
+	for (const auto & face : faces) {
+		for (uint corner : quadCorners) {
+			const float u = cornerUvs[corner][0];
+			const float v = cornerUvs[corner][1];
+			float position[3];
+			for (uint i = 0; i < 3; ++i) {
+				const float base = (face[0][i] > 0.0f) ? 1.0f : 0.0f;
+				position[i] = base + u * face[1][i] + v * face[2][i];
+			}
+			mesh.vertices.push_back(makeVertex (
+				position[0], position[1], position[2],
+				face[0][0], face[0][1], face[0][2], u, v
+			));
+			mesh.indices32.push_back(uint32(mesh.indices32.size()));
+		}
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+static bool verticesNear (
+	const Mesh::Vertex & a,
+	const Mesh::Vertex & b,
+	float epsilon
+) {
+	const float * va = a.position;
+	const float * vb = b.position;
+	for (size_t i = 0; i < sizeof(Mesh::Vertex) / sizeof(float); ++i) {
+		if (std::fabs(va[i] - vb[i]) > epsilon) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+// Indices of 'welded' must pick out the vertices of 'original', to within 'epsilon'.
+static void checkRemap (
+	const Mesh & original,
+	const Mesh & welded,
+	float epsilon
+) {
+	CHECK(welded.indices32.size() == original.indices32.size());
+	for (size_t i = 0; i < original.indices32.size(); ++i) {
+		CHECK(welded.indices32[i] < welded.vertices.size());
+		CHECK(verticesNear (
+			welded.vertices[welded.indices32[i]], original.vertices[original.indices32[i]], epsilon
+		));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// A cube welds to 4 vertices per face, whose normal and UV seams keep them apart, and
+// those share 8 positions.
+static void testCubeWithSeams()
+{
+	const Mesh original = createCubeSoup();
+	Mesh mesh = original;
+
+	CHECK(MeshWelder::weldVertices(mesh) == 24);
+	CHECK(mesh.vertices.size() == 24);
+	checkRemap(original, mesh, 0.0f);
+
+	// Welding again finds nothing more to merge.
+	CHECK(MeshWelder::weldVertices(mesh) == 24);
+
+	const std::vector<uint32> positionRemap =
+		MeshWelder::remapPositions(mesh.vertices.data(), mesh.vertices.size());
+	size_t numPositions = 0;
+	for (size_t v = 0; v < positionRemap.size(); ++v) {
+		CHECK(positionRemap[v] <= v);
+		const float * a = mesh.vertices[v].position;
+		const float * b = mesh.vertices[positionRemap[v]].position;
+		CHECK(a[0] == b[0] && a[1] == b[1] && a[2] == b[2]);
+		numPositions += (positionRemap[v] == v) ? 1 : 0;
+	}
+	CHECK(numPositions == 8);
+}
+
+//---------------------------------------------------------------------------------------
+// Unique vertices keep the order of their first occurrence, for 16 and 32-bit indices.
+static void testRemapOrder()
+{
+	const Mesh::Vertex a = makeVertex(0, 0, 0, 0, 0, 1, 0, 0);
+	const Mesh::Vertex b = makeVertex(1, 0, 0, 0, 0, 1, 1, 0);
+	const Mesh::Vertex c = makeVertex(0, 1, 0, 0, 0, 1, 0, 1);
+
+	Mesh mesh;
+	mesh.vertices = { a, b, a, c, b, c };
+	mesh.indices16 = { 5, 4, 3, 2, 1, 0 };
+	CHECK(MeshWelder::weldVertices(mesh) == 3);
+
+	CHECK(verticesNear(mesh.vertices[0], a, 0.0f));
+	CHECK(verticesNear(mesh.vertices[1], b, 0.0f));
+	CHECK(verticesNear(mesh.vertices[2], c, 0.0f));
+	const uint16 expected[] = { 2, 1, 2, 0, 1, 0 };
+	for (size_t i = 0; i < 6; ++i) {
+		CHECK(mesh.indices16[i] == expected[i]);
+	}
+
+	// -0 and +0 compare, and hash, as equal.
+	Mesh signedZero;
+	signedZero.vertices = { makeVertex(0, 0, 0, 0, 0, 1, 0, 0), makeVertex(-0.0f, 0, 0, 0, 0, 1, 0, -0.0f) };
+	signedZero.indices32 = { 0, 1, 1 };
+	CHECK(MeshWelder::weldVertices(signedZero) == 1);
+	CHECK(signedZero.indices32[1] == 0 && signedZero.indices32[2] == 0);
+
+	Mesh empty;
+	CHECK(MeshWelder::weldVertices(empty) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+// With an epsilon, vertices within it of one another weld even when they straddle a
+// grid cell, and the first one encountered is kept.
+static void testEpsilon()
+{
+	const float epsilon = 1.0e-3f;
+
+	Mesh mesh;
+	mesh.vertices = {
+		makeVertex(0.0995f, 0, 0, 0, 0, 1, 0, 0),
+		makeVertex(0.1004f, 0, 0, 0, 0, 1, 0, 0),
+		makeVertex(0.1020f, 0, 0, 0, 0, 1, 0, 0),
+		makeVertex(0.0995f, 0, 0, 0, 0.002f, 1, 0, 0),
+		makeVertex(0.0995f, 0, 0, 0, 0, 1, 0.0005f, 0)
+	};
+	mesh.indices32 = { 0, 1, 2, 3, 4, 1 };
+
+	Mesh exact = mesh;
+	CHECK(MeshWelder::weldVertices(exact) == 5);
+
+	CHECK(MeshWelder::weldVertices(mesh, epsilon) == 3);
+	CHECK(mesh.vertices[0].position[0] == 0.0995f);
+	const uint32 expected[] = { 0, 0, 1, 2, 0, 0 };
+	for (size_t i = 0; i < 6; ++i) {
+		CHECK(mesh.indices32[i] == expected[i]);
+	}
+
+	// Jitter every corner of the cube by less than half of epsilon.
+	const Mesh original = createCubeSoup();
+	Mesh jittered = original;
+	for (size_t v = 0; v < jittered.vertices.size(); ++v) {
+		float * components = jittered.vertices[v].position;
+		for (size_t i = 0; i < sizeof(Mesh::Vertex) / sizeof(float); ++i) {
+			components[i] += epsilon * 0.4f * std::sin(float(v * 8 + i));
+		}
+	}
+	Mesh welded = jittered;
+	CHECK(MeshWelder::weldVertices(welded, epsilon) == 24);
+	checkRemap(original, welded, epsilon);
+	checkRemap(jittered, welded, epsilon);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testCubeWithSeams);
+	RUN_TEST(testRemapOrder);
+	RUN_TEST(testEpsilon);
+
+	return 0;
+}
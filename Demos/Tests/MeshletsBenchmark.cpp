@@ -0,0 +1,208 @@
+//
+// MeshletsBenchmark.cpp
+//
+// Times Meshlets::buildMeshlets() on a generated sphere, in its optimized triangle
+// order as MeshLoader builds it, and cullMeshlets() for cameras orbiting the sphere
+// from afar and up close, reporting the share of meshlets each test culls.
+//
+#include "Common/Meshlets.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "Common/MeshOptimizer.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+// Unit sphere of 'numRings' x 'numSegments' quads, wound to face outwards.
+static Mesh createSphere (
+	uint32 numRings,
+	uint32 numSegments
+) {
+	const float pi = 3.14159265f;
+
+	Mesh mesh;
+	for (uint32 ring = 0; ring <= numRings; ++ring) {
+		const float theta = pi * ring / numRings;
+		for (uint32 segment = 0; segment <= numSegments; ++segment) {
+			const float phi = 2.0f * pi * segment / numSegments;
+			Mesh::Vertex vertex = {};
+			vertex.position[0] = std::sin(theta) * std::cos(phi);
+			vertex.position[1] = std::cos(theta);
+			vertex.position[2] = std::sin(theta) * std::sin(phi);
+			for (int i = 0; i < 3; ++i) {
+				vertex.normal[i] = vertex.position[i];
+			}
+			vertex.texCoord[0] = float(segment) / numSegments;
+			vertex.texCoord[1] = float(ring) / numRings;
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	for (uint32 ring = 0; ring < numRings; ++ring) {
+		for (uint32 segment = 0; segment < numSegments; ++segment) {
+			const uint32 a = ring * (numSegments + 1) + segment;
+			const uint32 b = a + 1;
+			const uint32 c = a + numSegments + 1;
+			const uint32 d = c + 1;
+			const uint32 quad[] = { a, b, c, b, d, c };
+			mesh.indices32.insert(mesh.indices32.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Row-major, row vector view projection of a camera at 'eye' looking at the origin, as
+// XMMatrixLookAtLH() * XMMatrixPerspectiveFovLH() builds it, with a 60 degree field of
+// view.
+static void lookAtOrigin (
+	const float eye[3],
+	float matrix[16]
+) {
+	const float length = std::sqrt(eye[0] * eye[0] + eye[1] * eye[1] + eye[2] * eye[2]);
+	const float forward[3] = { -eye[0] / length, -eye[1] / length, -eye[2] / length };
+
+	// right = up x forward, with +y up.
+	float right[3] = { forward[2], 0.0f, -forward[0] };
+	const float rightLength = std::sqrt(right[0] * right[0] + right[2] * right[2]);
+	right[0] /= rightLength;
+	right[2] /= rightLength;
+	const float up[3] = {
+		forward[1] * right[2] - forward[2] * right[1],
+		forward[2] * right[0] - forward[0] * right[2],
+		forward[0] * right[1] - forward[1] * right[0]
+	};
+
+	const float view[16] = {
+		right[0], up[0], forward[0], 0.0f,
+		right[1], up[1], forward[1], 0.0f,
+		right[2], up[2], forward[2], 0.0f,
+		-(right[0] * eye[0] + right[1] * eye[1] + right[2] * eye[2]),
+		-(up[0] * eye[0] + up[1] * eye[1] + up[2] * eye[2]),
+		-(forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2]),
+		1.0f
+	};
+
+	const float nearZ = 0.01f;
+	const float farZ = 100.0f;
+	const float scale = 1.0f / std::tan(3.14159265f / 6.0f);
+	const float range = farZ / (farZ - nearZ);
+	const float projection[16] = {
+		scale, 0.0f, 0.0f, 0.0f,
+		0.0f, scale, 0.0f, 0.0f,
+		0.0f, 0.0f, range, 1.0f,
+		0.0f, 0.0f, -range * nearZ, 0.0f
+	};
+
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; ++k) {
+				sum += view[row * 4 + k] * projection[k * 4 + column];
+			}
+			matrix[row * 4 + column] = sum;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Culls 'mesh' for 'numViews' cameras circling the origin at 'distance', at varying
+// heights, and prints the rate and share of meshlets culled.
+static void benchmarkCulling (
+	const char * name,
+	const Mesh & mesh,
+	float distance,
+	uint numViews
+) {
+	std::vector<Meshlets::Frustum> frustums(numViews);
+	std::vector<std::vector<float>> cameras(numViews);
+	for (uint v = 0; v < numViews; ++v) {
+		const float angle = 6.2831853f * v / numViews;
+		cameras[v] = {
+			distance * std::cos(angle), distance * 0.5f * std::sin(angle * 3.0f),
+			distance * std::sin(angle)
+		};
+		float viewProjection[16];
+		lookAtOrigin(cameras[v].data(), viewProjection);
+		frustums[v] = Meshlets::extractFrustum(viewProjection, false);
+	}
+
+	std::vector<Mesh::Submesh> drawRanges;
+	Meshlets::CullStatistics total = {};
+	const double seconds = timeFastest(5, [&] {
+		total = Meshlets::CullStatistics();
+		for (uint v = 0; v < numViews; ++v) {
+			const Meshlets::CullStatistics stats = Meshlets::cullMeshlets (
+				mesh.meshlets.data(), mesh.meshlets.size(), frustums[v], cameras[v].data(), drawRanges
+			);
+			total.numVisible += stats.numVisible;
+			total.numFrustumCulled += stats.numFrustumCulled;
+			total.numBackFacing += stats.numBackFacing;
+			total.numDrawRanges += stats.numDrawRanges;
+		}
+	});
+
+	const double numTested = double(mesh.meshlets.size()) * numViews;
+	std::printf("  %-22s %7.1f M meshlets/s, %4.1f%% frustum culled, %4.1f%% back facing, "
+		"%.1f draws per view\n",
+		name, numTested / seconds * 1.0e-6,
+		100.0 * total.numFrustumCulled / numTested, 100.0 * total.numBackFacing / numTested,
+		double(total.numDrawRanges) / numViews);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	Mesh sphere = createSphere(500, 1000);
+	MeshOptimizer::optimizeVertexCache (
+		sphere.indices32.data(), sphere.indices32.size(), sphere.vertices.size()
+	);
+	MeshOptimizer::optimizeOverdraw (
+		sphere.indices32.data(), sphere.indices32.size(),
+		sphere.vertices.data(), sphere.vertices.size()
+	);
+	const size_t numTriangles = sphere.indices32.size() / 3;
+
+	Mesh mesh;
+	const double buildSeconds = timeFastest(3, [&] {
+		mesh = sphere;
+		Meshlets::buildMeshlets(mesh);
+	});
+
+	size_t numMeshletTriangles = 0;
+	size_t numMeshletVertices = 0;
+	for (const Mesh::Meshlet & meshlet : mesh.meshlets) {
+		numMeshletTriangles += meshlet.numIndices / 3;
+		numMeshletVertices += meshlet.numVertices;
+	}
+	std::printf("Built %zu meshlets from %zu triangles: %.1f M triangles/s, "
+		"%.1f triangles and %.1f vertices per meshlet\n",
+		mesh.meshlets.size(), numTriangles, numTriangles / buildSeconds * 1.0e-6,
+		double(numMeshletTriangles) / mesh.meshlets.size(),
+		double(numMeshletVertices) / mesh.meshlets.size());
+
+	std::printf("Culling, against side planes as MeshDemo does\n");
+	benchmarkCulling("orbiting sphere", mesh, 4.0f, 64);
+	benchmarkCulling("close to sphere", mesh, 1.5f, 64);
+
+	return 0;
+}
@@ -0,0 +1,503 @@
+//
+// MeshletsTest.cpp
+//
+#include "Common/Meshlets.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+typedef std::array<uint32, 3> Triangle;
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+// Regular grid of 'size' x 'size' vertices in the z = 0 plane, 'spacing' apart, whose
+// triangles face +z.
+static Mesh createGrid (
+	uint32 size,
+	float spacing
+) {
+	Mesh mesh;
+	for (uint32 y = 0; y < size; ++y) {
+		for (uint32 x = 0; x < size; ++x) {
+			Mesh::Vertex vertex = {};
+			vertex.position[0] = x * spacing;
+			vertex.position[1] = y * spacing;
+			vertex.normal[2] = 1.0f;
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	for (uint32 y = 0; y + 1 < size; ++y) {
+		for (uint32 x = 0; x + 1 < size; ++x) {
+			const uint32 a = y * size + x;
+			const uint32 b = a + 1;
+			const uint32 c = a + size;
+			const uint32 d = c + 1;
+			const uint32 quad[] = { a, b, c, b, d, c };
+			mesh.indices32.insert(mesh.indices32.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+// Unit sphere of 'numRings' x 'numSegments' quads, with its triangles shuffled so that
+// meshlets can't simply follow the input order.  Each ring has its own UV seam vertex.
+static Mesh createShuffledSphere (
+	uint32 numRings,
+	uint32 numSegments
+) {
+	const float pi = 3.14159265f;
+
+	Mesh mesh;
+	for (uint32 ring = 0; ring <= numRings; ++ring) {
+		const float theta = pi * ring / numRings;
+		for (uint32 segment = 0; segment <= numSegments; ++segment) {
+			const float phi = 2.0f * pi * segment / numSegments;
+			Mesh::Vertex vertex = {};
+			vertex.position[0] = std::sin(theta) * std::cos(phi);
+			vertex.position[1] = std::cos(theta);
+			vertex.position[2] = std::sin(theta) * std::sin(phi);
+			for (int i = 0; i < 3; ++i) {
+				vertex.normal[i] = vertex.position[i];
+			}
+			vertex.texCoord[0] = float(segment) / numSegments;
+			vertex.texCoord[1] = float(ring) / numRings;
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	std::vector<Triangle> triangles;
+	for (uint32 ring = 0; ring < numRings; ++ring) {
+		for (uint32 segment = 0; segment < numSegments; ++segment) {
+			const uint32 a = ring * (numSegments + 1) + segment;
+			const uint32 b = a + 1;
+			const uint32 c = a + numSegments + 1;
+			const uint32 d = c + 1;
+			if (ring > 0) {
+				triangles.push_back(Triangle{ { a, b, c } });
+			}
+			if (ring + 1 < numRings) {
+				triangles.push_back(Triangle{ { b, d, c } });
+			}
+		}
+	}
+
+	std::mt19937 random(7);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+	for (const Triangle & triangle : triangles) {
+		mesh.indices32.insert(mesh.indices32.end(), triangle.begin(), triangle.end());
+	}
+	return mesh;
+}
+
+//---------------------------------------------------------------------------------------
+static std::multiset<Triangle> gatherTriangles (
+	const std::vector<uint32> & indices,
+	size_t begin,
+	size_t end
+) {
+	std::multiset<Triangle> triangles;
+	for (size_t i = begin; i < end; i += 3) {
+		triangles.insert(Triangle{ { indices[i], indices[i + 1], indices[i + 2] } });
+	}
+	return triangles;
+}
+
+//---------------------------------------------------------------------------------------
+static float dot (
+	const float a[3],
+	const float b[3]
+) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//---------------------------------------------------------------------------------------
+// Unit face normal of the triangle starting at 'index', false if it is degenerate.
+static bool faceNormal (
+	const Mesh & mesh,
+	const uint32 * index,
+	float normal[3]
+) {
+	const float * p0 = mesh.vertices[index[0]].position;
+	const float * p1 = mesh.vertices[index[1]].position;
+	const float * p2 = mesh.vertices[index[2]].position;
+	const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	const float length = std::sqrt(dot(normal, normal));
+	if (length == 0.0f) {
+		return false;
+	}
+	for (int i = 0; i < 3; ++i) {
+		normal[i] /= length;
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------
+// Meshlets partition the index buffer in order, respect the limits, and together hold
+// every original triangle exactly once, with its winding intact.
+static void checkMeshlets (
+	const Mesh & original,
+	const Mesh & mesh,
+	size_t maxVertices,
+	size_t maxTriangles
+) {
+	CHECK(mesh.indices32.size() == original.indices32.size());
+	CHECK(!mesh.meshlets.empty());
+
+	uint32 nextIndex = 0;
+	for (const Mesh::Meshlet & meshlet : mesh.meshlets) {
+		CHECK(meshlet.startIndex == nextIndex);
+		CHECK(meshlet.numIndices > 0 && meshlet.numIndices % 3 == 0);
+		CHECK(meshlet.numIndices / 3 <= maxTriangles);
+		CHECK(meshlet.baseVertex == 0);
+
+		const std::set<uint32> vertices (
+			mesh.indices32.begin() + meshlet.startIndex,
+			mesh.indices32.begin() + meshlet.startIndex + meshlet.numIndices
+		);
+		CHECK(meshlet.numVertices == vertices.size());
+		CHECK(meshlet.numVertices <= maxVertices);
+
+		nextIndex += meshlet.numIndices;
+	}
+	CHECK(nextIndex == mesh.indices32.size());
+
+	CHECK(gatherTriangles(mesh.indices32, 0, mesh.indices32.size()) ==
+		gatherTriangles(original.indices32, 0, original.indices32.size()));
+}
+
+//---------------------------------------------------------------------------------------
+static void testLimitsAndCoverage()
+{
+	const Mesh meshes[] = { createGrid(40, 0.1f), createShuffledSphere(24, 48) };
+	const size_t limits[][2] = {
+		{ Meshlets::MaxVertices, Meshlets::MaxTriangles }, { 32, 16 }, { 3, 1 }, { 128, 500 }
+	};
+
+	for (const Mesh & original : meshes) {
+		for (const auto & limit : limits) {
+			Mesh mesh = original;
+			const size_t numMeshlets = Meshlets::buildMeshlets(mesh, limit[0], limit[1]);
+			CHECK(numMeshlets == mesh.meshlets.size());
+			checkMeshlets(original, mesh, limit[0], limit[1]);
+		}
+
+		// Default limits fill meshlets well, rather than scattering small ones.
+		Mesh mesh = original;
+		Meshlets::buildMeshlets(mesh);
+		const size_t numTriangles = mesh.indices32.size() / 3;
+		CHECK(mesh.meshlets.size() * Meshlets::MaxTriangles < numTriangles * 2);
+	}
+
+	// A single triangle, and no triangles at all.
+	Mesh mesh = createGrid(2, 1.0f);
+	mesh.indices32.resize(3);
+	CHECK(Meshlets::buildMeshlets(mesh) == 1);
+	CHECK(mesh.meshlets[0].numVertices == 3);
+	mesh.indices32.clear();
+	CHECK(Meshlets::buildMeshlets(mesh) == 0 && mesh.meshlets.empty());
+}
+
+//---------------------------------------------------------------------------------------
+// Bounding spheres hold their meshlet's vertices, and normal cones hold the normals of
+// their meshlet's triangles.
+static void testBounds()
+{
+	const Mesh meshes[] = { createGrid(40, 0.1f), createShuffledSphere(24, 48) };
+	for (Mesh mesh : meshes) {
+		Meshlets::buildMeshlets(mesh);
+
+		size_t numCones = 0;
+		for (const Mesh::Meshlet & meshlet : mesh.meshlets) {
+			const uint32 * begin = mesh.indices32.data() + meshlet.startIndex;
+			const uint32 * end = begin + meshlet.numIndices;
+
+			for (const uint32 * index = begin; index != end; ++index) {
+				const float * position = mesh.vertices[*index].position;
+				const float d[3] = {
+					position[0] - meshlet.center[0],
+					position[1] - meshlet.center[1],
+					position[2] - meshlet.center[2]
+				};
+				CHECK(std::sqrt(dot(d, d)) <= meshlet.radius * 1.0001f + 1.0e-6f);
+			}
+
+			if (meshlet.coneCutoff >= 1.0f) {
+				// Disabled cone.
+				CHECK(dot(meshlet.coneAxis, meshlet.coneAxis) == 0.0f);
+				continue;
+			}
+			++numCones;
+			CHECK(std::fabs(std::sqrt(dot(meshlet.coneAxis, meshlet.coneAxis)) - 1.0f) < 1.0e-4f);
+
+			// Cosine of the half angle, from the sine stored as the cutoff.
+			const float minDot = std::sqrt(1.0f - meshlet.coneCutoff * meshlet.coneCutoff);
+			for (const uint32 * index = begin; index != end; index += 3) {
+				float normal[3];
+				if (faceNormal(mesh, index, normal)) {
+					CHECK(dot(normal, meshlet.coneAxis) >= minDot - 1.0e-4f);
+				}
+			}
+		}
+
+		// Flat and gently curved meshlets all get cones.
+		CHECK(numCones == mesh.meshlets.size());
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Row-major, row vector perspective projection looking down +z from the origin, as
+// XMMatrixPerspectiveFovLH() builds it.
+static void perspective (
+	float nearZ,
+	float farZ,
+	float matrix[16]
+) {
+	const float scale = 1.0f;  // 90 degree field of view.
+	const float range = farZ / (farZ - nearZ);
+	const float values[16] = {
+		scale, 0.0f, 0.0f, 0.0f,
+		0.0f, scale, 0.0f, 0.0f,
+		0.0f, 0.0f, range, 1.0f,
+		0.0f, 0.0f, -range * nearZ, 0.0f
+	};
+	std::copy(values, values + 16, matrix);
+}
+
+//---------------------------------------------------------------------------------------
+// Meshlet of radius 'radius' centered on 'x, y, z', with its cone disabled.
+static Mesh::Meshlet sphereMeshlet (
+	float x, float y, float z,
+	float radius
+) {
+	Mesh::Meshlet meshlet = {};
+	meshlet.center[0] = x;
+	meshlet.center[1] = y;
+	meshlet.center[2] = z;
+	meshlet.radius = radius;
+	meshlet.coneCutoff = 1.0f;
+	return meshlet;
+}
+
+//---------------------------------------------------------------------------------------
+// Meshlets behind the camera, beside the view or past the far plane are culled, and
+// those the view touches are kept.
+static void testFrustumCulling()
+{
+	float projection[16];
+	perspective(0.1f, 100.0f, projection);
+
+	for (bool clipDepth : { true, false }) {
+		const Meshlets::Frustum frustum = Meshlets::extractFrustum(projection, clipDepth);
+		CHECK(frustum.numPlanes == (clipDepth ? 6u : 4u));
+
+		CHECK(!Meshlets::isOutsideFrustum(sphereMeshlet(0, 0, 10, 1), frustum));
+		CHECK(!Meshlets::isOutsideFrustum(sphereMeshlet(0, 0, 0, 1), frustum));
+
+		// Behind the camera.
+		CHECK(Meshlets::isOutsideFrustum(sphereMeshlet(0, 0, -5, 1), frustum));
+		CHECK(Meshlets::isOutsideFrustum(sphereMeshlet(3, -2, -50, 10), frustum));
+
+		// Beside the 90 degree view, and straddling its edge.
+		CHECK(Meshlets::isOutsideFrustum(sphereMeshlet(20, 0, 10, 1), frustum));
+		CHECK(Meshlets::isOutsideFrustum(sphereMeshlet(0, -20, 10, 1), frustum));
+		CHECK(!Meshlets::isOutsideFrustum(sphereMeshlet(10.5f, 0, 10, 1), frustum));
+
+		// Past the far plane, which only depth clipping culls.
+		CHECK(Meshlets::isOutsideFrustum(sphereMeshlet(0, 0, 150, 1), frustum) == clipDepth);
+	}
+
+	// Culling is conservative: every culled meshlet of a sphere moved around the view
+	// has all of its vertices outside a single plane.
+	const Meshlets::Frustum frustum = Meshlets::extractFrustum(projection);
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> offset(-8.0f, 8.0f);
+	size_t numCulled = 0;
+	for (int i = 0; i < 20; ++i) {
+		Mesh mesh = createShuffledSphere(16, 32);
+		const float translation[3] = { offset(random), offset(random), offset(random) };
+		for (Mesh::Vertex & vertex : mesh.vertices) {
+			for (int a = 0; a < 3; ++a) {
+				vertex.position[a] = vertex.position[a] * 3.0f + translation[a];
+			}
+		}
+		Meshlets::buildMeshlets(mesh, 16, 16);
+
+		for (const Mesh::Meshlet & meshlet : mesh.meshlets) {
+			if (!Meshlets::isOutsideFrustum(meshlet, frustum)) {
+				continue;
+			}
+			++numCulled;
+
+			bool isSeparated = false;
+			for (uint p = 0; p < frustum.numPlanes && !isSeparated; ++p) {
+				const float * plane = frustum.planes[p];
+				isSeparated = true;
+				for (uint32 i = meshlet.startIndex; i < meshlet.startIndex + meshlet.numIndices; ++i) {
+					const float * position = mesh.vertices[mesh.indices32[i]].position;
+					isSeparated = isSeparated && dot(plane, position) + plane[3] < 0.0f;
+				}
+			}
+			CHECK(isSeparated);
+		}
+	}
+	CHECK(numCulled > 0);
+}
+
+//---------------------------------------------------------------------------------------
+// A grid seen from behind is culled entirely, seen from the front not at all, and no
+// meshlet with a triangle facing the camera is ever culled.
+static void testBackFaceCulling()
+{
+	Mesh grid = createGrid(41, 0.05f);
+	Meshlets::buildMeshlets(grid);
+
+	const float behind[3] = { 1.0f, 1.0f, -10.0f };
+	const float front[3] = { 1.0f, 1.0f, 10.0f };
+	for (const Mesh::Meshlet & meshlet : grid.meshlets) {
+		CHECK(Meshlets::isBackFacing(meshlet, behind));
+		CHECK(!Meshlets::isBackFacing(meshlet, front));
+	}
+
+	// Grazing views, from within the grid's plane, see the triangles edge on.
+	const float edgeOn[3] = { -5.0f, 1.0f, 0.0f };
+	for (const Mesh::Meshlet & meshlet : grid.meshlets) {
+		CHECK(!Meshlets::isBackFacing(meshlet, edgeOn));
+	}
+
+	Mesh sphere = createShuffledSphere(32, 64);
+	Meshlets::buildMeshlets(sphere);
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+	size_t numBackFacing = 0;
+	size_t numTested = 0;
+	for (int i = 0; i < 50; ++i) {
+		float camera[3] = { coordinate(random), coordinate(random), coordinate(random) };
+		if (dot(camera, camera) < 4.0f) {
+			continue;
+		}
+
+		for (const Mesh::Meshlet & meshlet : sphere.meshlets) {
+			++numTested;
+			if (!Meshlets::isBackFacing(meshlet, camera)) {
+				continue;
+			}
+			++numBackFacing;
+
+			for (uint32 i = meshlet.startIndex; i < meshlet.startIndex + meshlet.numIndices; i += 3) {
+				const uint32 * index = sphere.indices32.data() + i;
+				float normal[3];
+				if (!faceNormal(sphere, index, normal)) {
+					continue;
+				}
+				const float * position = sphere.vertices[index[0]].position;
+				const float toTriangle[3] = {
+					position[0] - camera[0], position[1] - camera[1], position[2] - camera[2]
+				};
+				CHECK(dot(normal, toTriangle) >= 0.0f);
+			}
+		}
+	}
+
+	// From outside a sphere somewhat less than half of it faces away, and a good share
+	// of that is culled.
+	CHECK(numBackFacing > numTested / 5);
+	CHECK(numBackFacing < numTested / 2);
+}
+
+//---------------------------------------------------------------------------------------
+// Culled meshlets are dropped from the draw ranges, and adjacent visible ones merged.
+static void testCullMeshlets()
+{
+	Mesh grid = createGrid(41, 0.05f);
+	Meshlets::buildMeshlets(grid);
+	const size_t numMeshlets = grid.meshlets.size();
+
+	float projection[16];
+	perspective(0.1f, 100.0f, projection);
+	// Move the grid 5 units in front of the camera, whose +z view sees its back.
+	projection[14] += 5.0f * projection[10];
+	projection[15] += 5.0f * projection[11];
+	const Meshlets::Frustum frustum = Meshlets::extractFrustum(projection);
+	const float camera[3] = { 0.0f, 0.0f, -5.0f };
+
+	std::vector<Mesh::Submesh> drawRanges(3);
+	Meshlets::CullStatistics stats = Meshlets::cullMeshlets (
+		grid.meshlets.data(), numMeshlets, frustum, camera, drawRanges
+	);
+	CHECK(stats.numVisible == 0 && stats.numFrustumCulled == 0);
+	CHECK(stats.numBackFacing == numMeshlets);
+	CHECK(drawRanges.empty() && stats.numDrawRanges == 0);
+
+	// Flipping the winding makes the grid face the camera, drawn in a single range.
+	Mesh flipped = createGrid(41, 0.05f);
+	for (size_t i = 0; i < flipped.indices32.size(); i += 3) {
+		std::swap(flipped.indices32[i + 1], flipped.indices32[i + 2]);
+	}
+	Meshlets::buildMeshlets(flipped);
+
+	stats = Meshlets::cullMeshlets (
+		flipped.meshlets.data(), flipped.meshlets.size(), frustum, camera, drawRanges
+	);
+	CHECK(stats.numVisible == flipped.meshlets.size());
+	CHECK(stats.numDrawRanges == 1 && drawRanges.size() == 1);
+	CHECK(drawRanges[0].startIndex == 0);
+	CHECK(drawRanges[0].numIndices == flipped.indices32.size());
+
+	// Moving the grid across the left edge of the view culls the meshlets left
+	// outside, and splits the visible ones into separate ranges.
+	const float sideCamera[3] = { 6.0f, 0.0f, -5.0f };
+	float sideProjection[16];
+	std::copy(projection, projection + 16, sideProjection);
+	sideProjection[12] -= 6.0f * projection[0];
+	const Meshlets::Frustum sideFrustum = Meshlets::extractFrustum(sideProjection);
+	stats = Meshlets::cullMeshlets (
+		flipped.meshlets.data(), flipped.meshlets.size(), sideFrustum, sideCamera, drawRanges
+	);
+	CHECK(stats.numVisible + stats.numFrustumCulled + stats.numBackFacing == flipped.meshlets.size());
+	CHECK(stats.numFrustumCulled > 0 && stats.numVisible > 0);
+	CHECK(stats.numDrawRanges == drawRanges.size() && !drawRanges.empty());
+
+	size_t numVisibleIndices = 0;
+	for (const Mesh::Meshlet & meshlet : flipped.meshlets) {
+		if (!Meshlets::isOutsideFrustum(meshlet, sideFrustum)) {
+			numVisibleIndices += meshlet.numIndices;
+		}
+	}
+	size_t numDrawnIndices = 0;
+	for (size_t r = 0; r < drawRanges.size(); ++r) {
+		numDrawnIndices += drawRanges[r].numIndices;
+		if (r > 0) {
+			CHECK(drawRanges[r].startIndex > drawRanges[r - 1].startIndex + drawRanges[r - 1].numIndices);
+		}
+	}
+	CHECK(numDrawnIndices == numVisibleIndices);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testLimitsAndCoverage);
+	RUN_TEST(testBounds);
+	RUN_TEST(testFrustumCulling);
+	RUN_TEST(testBackFaceCulling);
+	RUN_TEST(testCullMeshlets);
+
+	return 0;
+}
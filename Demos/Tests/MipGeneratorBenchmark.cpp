@@ -0,0 +1,79 @@
+//
+// MipGeneratorBenchmark.cpp
+//
+// Times MipGenerator against the scalar MipReference on a 2048x2048 sRGB image,
+// single threaded and across a JobSystem.
+//
+#include "Common/MipGenerator.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Common/JobSystem.hpp"
+#include "MipReference.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	const uint width = 2048;
+	const uint height = 2048;
+	const double megapixels = width * double(height) * 1.0e-6;
+
+	std::mt19937 random(1);
+	std::vector<byte> pixels(size_t(width) * height * 4);
+	for (byte & value : pixels) {
+		value = byte(random());
+	}
+	const ImageView source = { pixels.data(), size_t(width) * 4, width, height };
+
+	const uint numLevels = MipGenerator::numMipLevels(width, height);
+	std::vector<std::vector<byte>> storage(numLevels);
+	std::vector<ImageDestination> levels(numLevels);
+	for (uint level = 0; level < numLevels; ++level) {
+		const size_t rowPitch = size_t(MipGenerator::mipSize(width, level)) * 4;
+		storage[level].resize(rowPitch * MipGenerator::mipSize(height, level));
+		levels[level] = ImageDestination { storage[level].data(), rowPitch, storage[level].size() };
+	}
+
+	const double referenceSeconds = timeFastest(1, [&] {
+		MipReference::generateMipChain(pixels.data(), width, height, true);
+	});
+	const double singleSeconds = timeFastest(5, [&] {
+		MipGenerator::generateMipChain(source, levels.data(), numLevels, true, nullptr);
+	});
+
+	JobSystem jobSystem;
+	const double parallelSeconds = timeFastest(5, [&] {
+		MipGenerator::generateMipChain(source, levels.data(), numLevels, true, &jobSystem);
+	});
+
+	std::printf("%ux%u sRGB, %u levels, throughput in source megapixels per second\n",
+		width, height, numLevels);
+	std::printf("  scalar reference  %8.1f MP/s\n", megapixels / referenceSeconds);
+	std::printf("  1 thread          %8.1f MP/s  %5.1fx\n",
+		megapixels / singleSeconds, referenceSeconds / singleSeconds);
+	std::printf("  %2u workers        %8.1f MP/s  %5.1fx\n", jobSystem.numWorkerThreads(),
+		megapixels / parallelSeconds, referenceSeconds / parallelSeconds);
+
+	return 0;
+}
@@ -0,0 +1,176 @@
+//
+// MipGeneratorTest.cpp
+//
+#include "Common/MipGenerator.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Common/JobSystem.hpp"
+#include "MipReference.hpp"
+#include "TestUtils.hpp"
+
+
+namespace {
+
+const byte PaddingByte = 0xcd;
+
+// Levels written into padded rows, as in an upload buffer.
+struct PaddedChain {
+	std::vector<std::vector<byte>> storage;
+	std::vector<ImageDestination> levels;
+};
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+// Smooth gradients with noise, so that both flat and busy regions are filtered.
+static std::vector<byte> createImage (
+	uint width,
+	uint height
+) {
+	std::mt19937 random(width * 7919 + height);
+	std::vector<byte> pixels(size_t(width) * height * 4);
+	for (uint y = 0; y < height; ++y) {
+		for (uint x = 0; x < width; ++x) {
+			byte * pixel = &pixels[(size_t(y) * width + x) * 4];
+			pixel[0] = byte(x * 255 / width);
+			pixel[1] = byte(y * 255 / height);
+			pixel[2] = byte(random());
+			pixel[3] = byte(128 + random() % 128);
+		}
+	}
+	return pixels;
+}
+
+//---------------------------------------------------------------------------------------
+static PaddedChain createPaddedChain (
+	uint width,
+	uint height
+) {
+	PaddedChain chain;
+	const uint numLevels = MipGenerator::numMipLevels(width, height);
+	for (uint level = 0; level < numLevels; ++level) {
+		const uint levelWidth = MipGenerator::mipSize(width, level);
+		const uint levelHeight = MipGenerator::mipSize(height, level);
+		const size_t rowPitch = (size_t(levelWidth) * 4 + 255) & ~size_t(255);
+
+		chain.storage.emplace_back(rowPitch * levelHeight, PaddingByte);
+		chain.levels.push_back(ImageDestination {
+			chain.storage.back().data(), rowPitch, chain.storage.back().size()
+		});
+	}
+	return chain;
+}
+
+//---------------------------------------------------------------------------------------
+// Compares against the double precision reference, which the encoding tables may round
+// differently by one step.
+static void checkChain (
+	uint width,
+	uint height,
+	bool isSrgb,
+	JobSystem * jobSystem
+) {
+	std::printf("  %ux%u %s%s\n", width, height, isSrgb ? "sRGB" : "linear",
+		jobSystem ? " with jobs" : "");
+
+	const std::vector<byte> pixels = createImage(width, height);
+	const ImageView source = { pixels.data(), size_t(width) * 4, width, height };
+
+	PaddedChain chain = createPaddedChain(width, height);
+	MipGenerator::generateMipChain (
+		source, chain.levels.data(), uint(chain.levels.size()), isSrgb, jobSystem
+	);
+
+	const std::vector<MipReference::Level> expected =
+		MipReference::generateMipChain(pixels.data(), width, height, isSrgb);
+	CHECK(expected.size() == chain.levels.size());
+
+	size_t numDifferent = 0;
+	size_t numBytes = 0;
+	for (uint level = 0; level < chain.levels.size(); ++level) {
+		const uint levelWidth = MipGenerator::mipSize(width, level);
+		const uint levelHeight = MipGenerator::mipSize(height, level);
+		const ImageDestination & destination = chain.levels[level];
+
+		for (uint y = 0; y < levelHeight; ++y) {
+			const byte * row = destination.data + y * destination.rowPitch;
+			for (uint i = 0; i < levelWidth * 4; ++i) {
+				const int difference =
+					std::abs(int(row[i]) - int(expected[level][size_t(y) * levelWidth * 4 + i]));
+				CHECK(difference <= (level == 0 ? 0 : 1));
+				numDifferent += difference != 0;
+				++numBytes;
+			}
+
+			// Row padding is never written.
+			for (size_t i = levelWidth * 4; i < destination.rowPitch; ++i) {
+				CHECK(row[i] == PaddingByte);
+			}
+		}
+	}
+
+	// Off by one steps come from filtering in float and quantizing to the 16-bit
+	// encoding table, and stay rare.
+	std::printf("    %zu of %zu bytes off by one\n", numDifferent, numBytes);
+	CHECK(numDifferent * 20 < numBytes);
+}
+
+//---------------------------------------------------------------------------------------
+static void testMipSizes()
+{
+	CHECK(MipGenerator::numMipLevels(1, 1) == 1);
+	CHECK(MipGenerator::numMipLevels(1024, 1024) == 11);
+	CHECK(MipGenerator::numMipLevels(300, 7) == 9);
+	CHECK(MipGenerator::mipSize(300, 3) == 37);
+	CHECK(MipGenerator::mipSize(7, 3) == 1);
+}
+
+//---------------------------------------------------------------------------------------
+static void testMatchesReference()
+{
+	checkChain(64, 64, false, nullptr);
+	checkChain(37, 23, true, nullptr);
+	checkChain(300, 7, false, nullptr);
+	checkChain(1, 13, true, nullptr);
+	checkChain(256, 256, true, nullptr);
+
+	JobSystem jobSystem(3);
+	checkChain(513, 257, true, &jobSystem);
+	checkChain(1024, 48, false, &jobSystem);
+}
+
+//---------------------------------------------------------------------------------------
+// levels[0] may alias the source, in which case it is left as is.
+static void testInPlaceLevel0()
+{
+	const uint width = 40;
+	const uint height = 24;
+	std::vector<byte> pixels = createImage(width, height);
+	const std::vector<byte> original = pixels;
+
+	PaddedChain chain = createPaddedChain(width, height);
+	chain.levels[0] = ImageDestination { pixels.data(), size_t(width) * 4, pixels.size() };
+	const ImageView source = { pixels.data(), size_t(width) * 4, width, height };
+	MipGenerator::generateMipChain (
+		source, chain.levels.data(), uint(chain.levels.size()), true, nullptr
+	);
+
+	CHECK(pixels == original);
+	const std::vector<MipReference::Level> expected =
+		MipReference::generateMipChain(original.data(), width, height, true);
+	CHECK(std::abs(int(chain.levels[1].data[0]) - int(expected[1][0])) <= 1);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testMipSizes);
+	RUN_TEST(testMatchesReference);
+	RUN_TEST(testInPlaceLevel0);
+
+	return 0;
+}
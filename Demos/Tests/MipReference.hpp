@@ -0,0 +1,87 @@
+//
+// MipReference.hpp
+//
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Straightforward scalar mip chain generator that MipGenerator is checked and timed
+* against.  Filters one whole level at a time in double precision, converting with
+* the exact sRGB transfer functions rather than tables.
+*/
+namespace MipReference {
+
+	typedef std::vector<byte> Level;
+
+	inline double srgbToLinear (
+		double value
+	) {
+		return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	inline double linearToSrgb (
+		double value
+	) {
+		return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+	}
+
+	/// Returns every level of the chain for 'pixels', 'width' x 'height' tightly packed
+	/// RGBA, each level tightly packed too.  levels[0] is a copy of the source.
+	inline std::vector<Level> generateMipChain (
+		const byte * pixels,
+		uint width,
+		uint height,
+		bool isSrgb
+	) {
+		std::vector<Level> levels(1, Level(pixels, pixels + size_t(width) * height * 4));
+
+		std::vector<double> current(levels[0].size());
+		for (size_t i = 0; i < current.size(); ++i) {
+			const double value = pixels[i] / 255.0;
+			current[i] = (isSrgb && i % 4 != 3) ? srgbToLinear(value) : value;
+		}
+
+		while (width > 1 || height > 1) {
+			const uint nextWidth = std::max(width / 2, 1u);
+			const uint nextHeight = std::max(height / 2, 1u);
+
+			std::vector<double> next(size_t(nextWidth) * nextHeight * 4);
+			Level level(next.size());
+			for (uint y = 0; y < nextHeight; ++y) {
+				// A dimension of 1 repeats its only pixel.
+				const uint y0 = std::min(y * 2, height - 1);
+				const uint y1 = std::min(y * 2 + 1, height - 1);
+				for (uint x = 0; x < nextWidth; ++x) {
+					const uint x0 = std::min(x * 2, width - 1);
+					const uint x1 = std::min(x * 2 + 1, width - 1);
+					for (uint c = 0; c < 4; ++c) {
+						const size_t i = (size_t(y) * nextWidth + x) * 4 + c;
+						next[i] = (current[(size_t(y0) * width + x0) * 4 + c] +
+							current[(size_t(y0) * width + x1) * 4 + c] +
+							current[(size_t(y1) * width + x0) * 4 + c] +
+							current[(size_t(y1) * width + x1) * 4 + c]) * 0.25;
+
+						double encoded = std::min(std::max(next[i], 0.0), 1.0);
+						if (isSrgb && c != 3) {
+							encoded = linearToSrgb(encoded);
+						}
+						level[i] = byte(std::floor(encoded * 255.0 + 0.5));
+					}
+				}
+			}
+
+			levels.push_back(std::move(level));
+			current.swap(next);
+			width = nextWidth;
+			height = nextHeight;
+		}
+
+		return levels;
+	}
+};
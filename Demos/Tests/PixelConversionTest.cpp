@@ -0,0 +1,165 @@
+//
+// PixelConversionTest.cpp
+//
+#include "Common/PixelConversion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+const byte PaddingByte = 0xcd;
+
+//---------------------------------------------------------------------------------------
+// 'numBytes' from a linear congruential generator.
+static std::vector<byte> randomBytes (
+	size_t numBytes,
+	uint32 seed
+) {
+	std::vector<byte> bytes(numBytes);
+	for (byte & value : bytes) {
+		seed = seed * 1664525 + 1013904223;
+		value = byte(seed >> 24);
+	}
+	return bytes;
+}
+
+//---------------------------------------------------------------------------------------
+// Runs 'convert' for every pixel count up to 70, from source and destination offsets
+// of 0 to 3 bytes, checking it writes exactly 'reference' and nothing past it.
+// 'convert' reads 'numSourceBytes' per pixel from each source.
+static void checkConversion (
+	uint numSources,
+	size_t numSourceBytes,
+	const std::function<void(const byte * const *, byte *, size_t)> & convert,
+	const std::function<void(const byte * const *, size_t, byte *)> & reference
+) {
+	for (size_t numPixels = 0; numPixels <= 70; ++numPixels) {
+		for (size_t offset = 0; offset < 4; ++offset) {
+			// Sources end exactly at the last pixel, so that reading past it is caught
+			// by address sanitizer builds.
+			std::vector<std::vector<byte>> sources;
+			const byte * sourcePointers[3];
+			for (uint s = 0; s < numSources; ++s) {
+				sources.push_back(randomBytes(offset + numPixels * numSourceBytes, uint32(numPixels * 7 + s)));
+				sourcePointers[s] = sources.back().data() + offset;
+			}
+
+			std::vector<byte> rgba(offset + numPixels * 4 + 16, PaddingByte);
+			convert(sourcePointers, rgba.data() + offset, numPixels);
+
+			for (size_t i = 0; i < offset; ++i) {
+				CHECK(rgba[i] == PaddingByte);
+			}
+			for (size_t i = 0; i < numPixels; ++i) {
+				byte expected[4];
+				reference(sourcePointers, i, expected);
+				for (int c = 0; c < 4; ++c) {
+					CHECK(rgba[offset + i * 4 + c] == expected[c]);
+				}
+			}
+			for (size_t i = offset + numPixels * 4; i < rgba.size(); ++i) {
+				CHECK(rgba[i] == PaddingByte);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Gray, gray and alpha, and RGB expansions match a per-pixel reference at every
+// length and alignment, covering both the SIMD loops and the scalar tails.
+static void testExpansions()
+{
+	checkConversion (
+		1, 1,
+		[](const byte * const * src, byte * rgba, size_t n) { PixelConversion::grayToRgba(src[0], rgba, n); },
+		[](const byte * const * src, size_t i, byte * pixel) {
+			pixel[0] = pixel[1] = pixel[2] = src[0][i];
+			pixel[3] = 255;
+		}
+	);
+	checkConversion (
+		1, 2,
+		[](const byte * const * src, byte * rgba, size_t n) { PixelConversion::grayAlphaToRgba(src[0], rgba, n); },
+		[](const byte * const * src, size_t i, byte * pixel) {
+			pixel[0] = pixel[1] = pixel[2] = src[0][i * 2];
+			pixel[3] = src[0][i * 2 + 1];
+		}
+	);
+	checkConversion (
+		1, 3,
+		[](const byte * const * src, byte * rgba, size_t n) { PixelConversion::rgbToRgba(src[0], rgba, n); },
+		[](const byte * const * src, size_t i, byte * pixel) {
+			pixel[0] = src[0][i * 3];
+			pixel[1] = src[0][i * 3 + 1];
+			pixel[2] = src[0][i * 3 + 2];
+			pixel[3] = 255;
+		}
+	);
+}
+
+//---------------------------------------------------------------------------------------
+// YCbCr conversion in batches, taking the SIMD path, matches converting one pixel at a
+// time, which takes the scalar one, for every possible input.  Both stay within one of
+// the exact JFIF conversion.
+static void testYCbCrToRgba()
+{
+	checkConversion (
+		3, 1,
+		[](const byte * const * src, byte * rgba, size_t n) {
+			PixelConversion::yCbCrToRgba(src[0], src[1], src[2], rgba, n);
+		},
+		[](const byte * const * src, size_t i, byte * pixel) {
+			PixelConversion::yCbCrToRgba(src[0] + i, src[1] + i, src[2] + i, pixel, 1);
+		}
+	);
+
+	// Every luma and blue difference for each red difference.
+	const size_t numPixels = 256 * 256;
+	std::vector<byte> y(numPixels);
+	std::vector<byte> cb(numPixels);
+	std::vector<byte> cr(numPixels);
+	std::vector<byte> rgba(numPixels * 4);
+	for (size_t i = 0; i < numPixels; ++i) {
+		y[i] = byte(i);
+		cb[i] = byte(i >> 8);
+	}
+
+	for (uint red = 0; red < 256; ++red) {
+		std::fill(cr.begin(), cr.end(), byte(red));
+		PixelConversion::yCbCrToRgba(y.data(), cb.data(), cr.data(), rgba.data(), numPixels);
+
+		for (size_t i = 0; i < numPixels; ++i) {
+			byte pixel[4];
+			PixelConversion::yCbCrToRgba(&y[i], &cb[i], &cr[i], pixel, 1);
+			CHECK(std::equal(pixel, pixel + 4, &rgba[i * 4]));
+
+			const double luma = y[i];
+			const double blue = cb[i] - 128.0;
+			const double redDifference = cr[i] - 128.0;
+			const double exact[3] = {
+				luma + 1.402 * redDifference,
+				luma - 0.344136 * blue - 0.714136 * redDifference,
+				luma + 1.772 * blue
+			};
+			for (int c = 0; c < 3; ++c) {
+				const double clamped = exact[c] < 0.0 ? 0.0 : (exact[c] > 255.0 ? 255.0 : exact[c]);
+				CHECK(std::fabs(pixel[c] - clamped) <= 1.0);
+			}
+			CHECK(pixel[3] == 255);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testExpansions);
+	RUN_TEST(testYCbCrToRgba);
+
+	return 0;
+}
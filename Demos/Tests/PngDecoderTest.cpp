@@ -0,0 +1,375 @@
+//
+// PngDecoderTest.cpp
+//
+#include "Common/PngDecoder.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "PngWriter.hpp"
+#include "TestUtils.hpp"
+
+
+const byte PaddingByte = 0xcd;
+
+//---------------------------------------------------------------------------------------
+// 'numBytes' from a linear congruential generator.
+static std::vector<byte> randomBytes (
+	size_t numBytes,
+	uint32 seed
+) {
+	std::vector<byte> bytes(numBytes);
+	for (byte & value : bytes) {
+		seed = seed * 1664525 + 1013904223;
+		value = byte(seed >> 24);
+	}
+	return bytes;
+}
+
+//---------------------------------------------------------------------------------------
+// Image of random samples.
+static PngWriter::Image randomImage (
+	uint width,
+	uint height,
+	uint bitDepth,
+	uint colorType,
+	uint32 seed
+) {
+	PngWriter::Image image = {};
+	image.width = width;
+	image.height = height;
+	image.bitDepth = bitDepth;
+	image.colorType = colorType;
+	image.scanlines = randomBytes(PngWriter::rowBytes(image) * height, seed);
+	return image;
+}
+
+//---------------------------------------------------------------------------------------
+// Sample 'index' of row 'y', at full precision.
+static uint readSample (
+	const PngWriter::Image & image,
+	uint y,
+	size_t index
+) {
+	const byte * row = &image.scanlines[y * PngWriter::rowBytes(image)];
+	if (image.bitDepth == 16) {
+		return (uint(row[index * 2]) << 8) | row[index * 2 + 1];
+	}
+	const size_t bitOffset = index * image.bitDepth;
+	const uint shift = 8 - image.bitDepth - uint(bitOffset % 8);
+	return (row[bitOffset / 8] >> shift) & ((1u << image.bitDepth) - 1);
+}
+
+//---------------------------------------------------------------------------------------
+// RGBA the decoder should produce for 'image', worked out one sample at a time.
+static std::vector<byte> expectedRgba (
+	const PngWriter::Image & image
+) {
+	const uint numChannels = PngWriter::numChannels(image.colorType);
+	const uint maxValue = (1u << image.bitDepth) - 1;
+
+	// Samples scale to 8 bits, palette indices stay as they are.
+	auto toByte = [&](uint value) {
+		return byte(image.bitDepth == 16 ? value >> 8 : value * 255 / maxValue);
+	};
+
+	std::vector<byte> rgba(size_t(image.width) * image.height * 4);
+	for (uint y = 0; y < image.height; ++y) {
+		for (uint x = 0; x < image.width; ++x) {
+			uint samples[4];
+			for (uint c = 0; c < numChannels; ++c) {
+				samples[c] = readSample(image, y, size_t(x) * numChannels + c);
+			}
+
+			byte * pixel = &rgba[(size_t(y) * image.width + x) * 4];
+			switch (image.colorType) {
+				case PngWriter::ColorType_Gray:
+				case PngWriter::ColorType_GrayAlpha:
+					pixel[0] = pixel[1] = pixel[2] = toByte(samples[0]);
+					pixel[3] = numChannels == 2 ? toByte(samples[1]) : 255;
+					break;
+
+				case PngWriter::ColorType_Rgb:
+				case PngWriter::ColorType_Rgba:
+					for (uint c = 0; c < 3; ++c) {
+						pixel[c] = toByte(samples[c]);
+					}
+					pixel[3] = numChannels == 4 ? toByte(samples[3]) : 255;
+					break;
+
+				case PngWriter::ColorType_Palette: {
+					// Indices beyond the palette read as opaque black.
+					const size_t index = samples[0];
+					for (uint c = 0; c < 3; ++c) {
+						pixel[c] = (index * 3 < image.palette.size()) ? image.palette[index * 3 + c] : 0;
+					}
+					pixel[3] = (index < image.transparency.size()) ? image.transparency[index] : 255;
+					break;
+				}
+			}
+
+			// Gray and RGB keys match full precision samples.
+			if (!image.transparency.empty() && image.colorType != PngWriter::ColorType_Palette) {
+				bool isKey = true;
+				for (uint c = 0; c < numChannels; ++c) {
+					const uint key = (uint(image.transparency[c * 2]) << 8) | image.transparency[c * 2 + 1];
+					isKey = isKey && samples[c] == key;
+				}
+				pixel[3] = isKey ? 0 : pixel[3];
+			}
+		}
+	}
+	return rgba;
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes 'file' into rows padded with PaddingByte, checks the padding is untouched,
+// and returns the tightly packed pixels.
+static std::vector<byte> decode (
+	PngDecoder & decoder,
+	const std::vector<byte> & file
+) {
+	const ImageInfo info = PngDecoder::readInfo(file.data(), file.size());
+	const size_t rowBytes = size_t(info.width) * 4;
+	const size_t rowPitch = rowBytes + 12;
+
+	std::vector<byte> padded(rowPitch * info.height, PaddingByte);
+	ImageDestination destination;
+	destination.data = padded.data();
+	destination.rowPitch = rowPitch;
+	destination.size = padded.size();
+	decoder.decode(file.data(), file.size(), destination);
+
+	std::vector<byte> rgba;
+	for (uint y = 0; y < info.height; ++y) {
+		const byte * row = &padded[y * rowPitch];
+		rgba.insert(rgba.end(), row, row + rowBytes);
+		for (size_t i = rowBytes; i < rowPitch; ++i) {
+			CHECK(row[i] == PaddingByte);
+		}
+	}
+	return rgba;
+}
+
+//---------------------------------------------------------------------------------------
+// Returns false if decoding 'file' throws.
+static bool tryDecode (
+	const std::vector<byte> & file
+) {
+	try {
+		PngDecoder decoder;
+		decode(decoder, file);
+		return true;
+	} catch (const std::runtime_error &) {
+		return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Every filter type is reversed, both by the SSE2 path for 4 byte pixels and the
+// scalar one for other sizes.  One decoder is reused throughout.
+static void testFilters()
+{
+	struct Format {
+		uint bitDepth;
+		uint colorType;
+	};
+	const Format formats[] = {
+		{ 8, PngWriter::ColorType_Rgba },
+		{ 8, PngWriter::ColorType_Rgb },
+		{ 8, PngWriter::ColorType_GrayAlpha },
+		{ 8, PngWriter::ColorType_Gray },
+		{ 16, PngWriter::ColorType_Rgba },
+		{ 2, PngWriter::ColorType_Gray }
+	};
+
+	PngDecoder decoder;
+	uint32 seed = 1;
+	for (const Format & format : formats) {
+		for (uint width : { 1u, 2u, 37u }) {
+			const PngWriter::Image image = randomImage(width, 13, format.bitDepth, format.colorType, seed++);
+			const std::vector<byte> expected = expectedRgba(image);
+			for (uint filter = 0; filter <= PngWriter::Filter_EachRow; ++filter) {
+				const std::vector<byte> file = PngWriter::write(image, filter);
+				CHECK(decode(decoder, file) == expected);
+			}
+
+			// Data split across many IDAT chunks.
+			const std::vector<byte> file = PngWriter::write(image, PngWriter::Filter_EachRow, 7);
+			CHECK(decode(decoder, file) == expected);
+		}
+	}
+
+	// A smooth image, where the filters predict well.
+	PngWriter::Image image = randomImage(64, 64, 8, PngWriter::ColorType_Rgba, 0);
+	for (size_t i = 0; i < image.scanlines.size(); ++i) {
+		image.scanlines[i] = byte((i / 4) % 64 + (i / 256) + (i % 4) * 40);
+	}
+	for (uint filter = 0; filter <= PngWriter::Filter_EachRow; ++filter) {
+		CHECK(decode(decoder, PngWriter::write(image, filter)) == expectedRgba(image));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Palette images of every bit depth, with tRNS alpha for some entries and indices
+// beyond the palette.
+static void testPalette()
+{
+	PngDecoder decoder;
+	for (uint bitDepth : { 1u, 2u, 4u, 8u }) {
+		PngWriter::Image image = randomImage(29, 11, bitDepth, PngWriter::ColorType_Palette, bitDepth);
+
+		const uint numEntries = (bitDepth == 8) ? 200 : (1u << bitDepth);
+		image.palette = randomBytes(numEntries * 3, 100 + bitDepth);
+		image.transparency = randomBytes(numEntries / 2 + 1, 200 + bitDepth);
+
+		const std::vector<byte> expected = expectedRgba(image);
+		CHECK(decode(decoder, PngWriter::write(image, PngWriter::Filter_EachRow)) == expected);
+
+		// Without tRNS every entry is opaque.
+		image.transparency.clear();
+		const std::vector<byte> opaque = decode(decoder, PngWriter::write(image, 0));
+		CHECK(opaque == expectedRgba(image));
+		for (size_t i = 3; i < opaque.size(); i += 4) {
+			CHECK(opaque[i] == 255);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// 16-bit samples keep their high byte, while transparent keys compare all 16 bits.
+// Gray levels below 8 bits are scaled to the full range.
+static void testBitDepths()
+{
+	PngDecoder decoder;
+	for (uint colorType : { PngWriter::ColorType_Gray, PngWriter::ColorType_Rgb }) {
+		PngWriter::Image image = randomImage(17, 9, 16, colorType, colorType);
+		const uint numChannels = PngWriter::numChannels(colorType);
+		const size_t pixelBytes = numChannels * 2;
+
+		// The key matches the first pixel, the second differs only in a low byte.
+		image.transparency.assign(image.scanlines.begin(), image.scanlines.begin() + pixelBytes);
+		std::memcpy(&image.scanlines[pixelBytes], &image.scanlines[0], pixelBytes);
+		image.scanlines[pixelBytes * 2 - 1] ^= 1;
+
+		const std::vector<byte> rgba = decode(decoder, PngWriter::write(image, PngWriter::Filter_EachRow));
+		CHECK(rgba == expectedRgba(image));
+		CHECK(rgba[3] == 0);
+		CHECK(rgba[7] == 255);
+		CHECK(std::memcmp(&rgba[0], &rgba[4], 3) == 0);
+	}
+
+	const PngWriter::Image grayAlpha = randomImage(17, 9, 16, PngWriter::ColorType_GrayAlpha, 3);
+	CHECK(decode(decoder, PngWriter::write(grayAlpha, 4)) == expectedRgba(grayAlpha));
+
+	for (uint bitDepth : { 1u, 2u, 4u }) {
+		PngWriter::Image image = randomImage(23, 5, bitDepth, PngWriter::ColorType_Gray, bitDepth);
+		const std::vector<byte> rgba = decode(decoder, PngWriter::write(image, 0));
+		CHECK(rgba == expectedRgba(image));
+
+		image.transparency = { 0, 1 };
+		CHECK(decode(decoder, PngWriter::write(image, 1)) == expectedRgba(image));
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// Truncated, corrupt and unsupported files fail with std::runtime_error.
+static void testMalformedFiles()
+{
+	const PngWriter::Image image = randomImage(8, 4, 8, PngWriter::ColorType_Rgb, 7);
+	const std::vector<byte> file = PngWriter::write(image, PngWriter::Filter_EachRow);
+	CHECK(tryDecode(file));
+
+	const ImageInfo info = PngDecoder::readInfo(file.data(), file.size());
+	CHECK(info.width == 8 && info.height == 4);
+	CHECK(PngDecoder::isPng(file.data(), file.size()));
+	CHECK(!PngDecoder::isPng(file.data(), 7));
+
+	for (size_t length = 0; length < file.size(); ++length) {
+		CHECK(!tryDecode(std::vector<byte>(file.begin(), file.begin() + length)));
+	}
+
+	// Header fields, with IHDR data at offset 16: width, height, bit depth, color
+	// type, compression, filter and interlace method.
+	auto patched = [&](size_t offset, byte value) {
+		std::vector<byte> copy = file;
+		copy[offset] = value;
+		return copy;
+	};
+	const std::vector<byte> badHeaders[] = {
+		patched(0, 'X'),
+		patched(19, 0),      // Zero width
+		patched(17, 2),      // Width beyond the limit
+		patched(24, 3),      // Bit depth
+		patched(25, 1),      // Color type
+		patched(25, 5),
+		patched(26, 1),
+		patched(27, 1),
+		patched(28, 2)
+	};
+	for (const std::vector<byte> & badHeader : badHeaders) {
+		bool hasThrown = false;
+		try {
+			PngDecoder::readInfo(badHeader.data(), badHeader.size());
+		} catch (const std::runtime_error &) {
+			hasThrown = true;
+		}
+		CHECK(hasThrown);
+		CHECK(!tryDecode(badHeader));
+	}
+
+	// More rows than the image data holds.
+	CHECK(!tryDecode(patched(23, 5)));
+
+	// A filter type beyond Paeth, in the first scanline behind the zlib and stored
+	// block headers of the IDAT chunk.
+	const size_t firstFilter = 8 + 25 + 8 + 2 + 5;
+	CHECK(file[firstFilter] == 0);
+	CHECK(!tryDecode(patched(firstFilter, 5)));
+
+	// Unknown chunks fail only if critical.
+	for (const char * type : { "ABCD", "abCD" }) {
+		std::vector<byte> chunk;
+		PngWriter::appendChunk(chunk, type, nullptr, 0);
+		std::vector<byte> withChunk = file;
+		withChunk.insert(withChunk.begin() + 33, chunk.begin(), chunk.end());
+		CHECK(tryDecode(withChunk) == (type[0] == 'a'));
+	}
+
+	// A destination too small for the image.
+	std::vector<byte> pixels(8 * 4 * 4);
+	ImageDestination destination;
+	destination.data = pixels.data();
+	destination.rowPitch = 8 * 4;
+	destination.size = pixels.size() - 1;
+	PngDecoder decoder;
+	bool hasThrown = false;
+	try {
+		decoder.decode(file.data(), file.size(), destination);
+	} catch (const std::runtime_error &) {
+		hasThrown = true;
+	}
+	CHECK(hasThrown);
+
+	// Flipped bits anywhere either fail or decode.
+	std::vector<byte> corrupt = file;
+	for (size_t i = 8; i < corrupt.size(); ++i) {
+		for (byte mask : { byte(0x01), byte(0x80), byte(0xff) }) {
+			corrupt[i] ^= mask;
+			tryDecode(corrupt);
+			corrupt[i] ^= mask;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testFilters);
+	RUN_TEST(testPalette);
+	RUN_TEST(testBitDepths);
+	RUN_TEST(testMalformedFiles);
+
+	return 0;
+}
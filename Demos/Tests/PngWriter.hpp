@@ -0,0 +1,215 @@
+//
+// PngWriter.hpp
+//
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Common/BasicTypes.hpp"
+
+
+/**
+* Minimal PNG encoder that PngDecoder and Inflate are checked against.  Image data is
+* stored uncompressed in zlib stored blocks, with every scanline filtered as asked, so
+* tests control exactly which filters and chunks the decoder sees.
+*/
+namespace PngWriter {
+
+	enum ColorType {
+		ColorType_Gray = 0,
+		ColorType_Rgb = 2,
+		ColorType_Palette = 3,
+		ColorType_GrayAlpha = 4,
+		ColorType_Rgba = 6
+	};
+
+	/// Filter argument of write() that cycles through the five filters by row.
+	const uint Filter_EachRow = 5;
+
+	struct Image {
+		uint width;
+		uint height;
+		uint bitDepth;
+		uint colorType;
+
+		/// Unfiltered scanlines, each rowBytes() long.
+		std::vector<byte> scanlines;
+
+		/// Contents of the PLTE and tRNS chunks, left out when empty.
+		std::vector<byte> palette;
+		std::vector<byte> transparency;
+	};
+
+	inline uint numChannels (
+		uint colorType
+	) {
+		switch (colorType) {
+			case ColorType_Rgb: return 3;
+			case ColorType_GrayAlpha: return 2;
+			case ColorType_Rgba: return 4;
+			default: return 1;
+		}
+	}
+
+	inline size_t rowBytes (
+		const Image & image
+	) {
+		return (size_t(image.width) * numChannels(image.colorType) * image.bitDepth + 7) / 8;
+	}
+
+	inline uint32 crc32 (
+		const byte * data,
+		size_t size,
+		uint32 crc = 0
+	) {
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit) {
+				crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+			}
+		}
+		return ~crc;
+	}
+
+	inline void appendBigEndian32 (
+		std::vector<byte> & out,
+		uint32 value
+	) {
+		const byte bytes[4] = {
+			byte(value >> 24), byte(value >> 16), byte(value >> 8), byte(value)
+		};
+		out.insert(out.end(), bytes, bytes + 4);
+	}
+
+	/// Wraps 'data' in a zlib stream of stored blocks, each at most 'maxBlockSize'.
+	inline std::vector<byte> storeZlib (
+		const byte * data,
+		size_t size,
+		size_t maxBlockSize = 0xffff
+	) {
+		std::vector<byte> out = { 0x78, 0x01 };
+		size_t offset = 0;
+		do {
+			const size_t length = (size - offset < maxBlockSize) ? size - offset : maxBlockSize;
+			const bool isFinal = offset + length == size;
+			const byte header[5] = {
+				byte(isFinal ? 1 : 0), byte(length), byte(length >> 8),
+				byte(~length), byte(~length >> 8)
+			};
+			out.insert(out.end(), header, header + 5);
+			out.insert(out.end(), data + offset, data + offset + length);
+			offset += length;
+		} while (offset < size);
+
+		uint32 a = 1;
+		uint32 b = 0;
+		for (size_t i = 0; i < size; ++i) {
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		appendBigEndian32(out, (b << 16) | a);
+		return out;
+	}
+
+	inline byte paethPredictor (
+		int left,
+		int up,
+		int upLeft
+	) {
+		const int estimate = left + up - upLeft;
+		const int toLeft = std::abs(estimate - left);
+		const int toUp = std::abs(estimate - up);
+		const int toUpLeft = std::abs(estimate - upLeft);
+		if (toLeft <= toUp && toLeft <= toUpLeft) {
+			return byte(left);
+		}
+		return byte(toUp <= toUpLeft ? up : upLeft);
+	}
+
+	/// Appends 'row' filtered with 'filter' against 'prevRow', preceded by its filter
+	/// byte.
+	inline void appendFilteredRow (
+		std::vector<byte> & out,
+		uint filter,
+		const byte * row,
+		const byte * prevRow,
+		size_t numBytes,
+		size_t bytesPerPixel
+	) {
+		out.push_back(byte(filter));
+		for (size_t i = 0; i < numBytes; ++i) {
+			const int left = (i >= bytesPerPixel) ? row[i - bytesPerPixel] : 0;
+			const int up = prevRow[i];
+			const int upLeft = (i >= bytesPerPixel) ? prevRow[i - bytesPerPixel] : 0;
+			int predictor = 0;
+			switch (filter) {
+				case 1: predictor = left; break;
+				case 2: predictor = up; break;
+				case 3: predictor = (left + up) / 2; break;
+				case 4: predictor = paethPredictor(left, up, upLeft); break;
+			}
+			out.push_back(byte(row[i] - predictor));
+		}
+	}
+
+	inline void appendChunk (
+		std::vector<byte> & out,
+		const char * type,
+		const byte * data,
+		size_t size
+	) {
+		appendBigEndian32(out, uint32(size));
+		const size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+		appendBigEndian32(out, crc32(&out[start], out.size() - start));
+	}
+
+	/// Encodes 'image' with every row filtered by 'filter', 0 to 4 or Filter_EachRow,
+	/// splitting its data into IDAT chunks of at most 'maxIdatSize' bytes.
+	inline std::vector<byte> write (
+		const Image & image,
+		uint filter,
+		size_t maxIdatSize = 1 << 20
+	) {
+		const size_t numRowBytes = rowBytes(image);
+		const size_t bytesPerPixel =
+			(numChannels(image.colorType) * image.bitDepth + 7) / 8;
+
+		std::vector<byte> filtered;
+		const std::vector<byte> zeroRow(numRowBytes, 0);
+		for (uint y = 0; y < image.height; ++y) {
+			const byte * row = &image.scanlines[y * numRowBytes];
+			const byte * prevRow = (y > 0) ? row - numRowBytes : zeroRow.data();
+			const uint rowFilter = (filter == Filter_EachRow) ? y % 5 : filter;
+			appendFilteredRow(filtered, rowFilter, row, prevRow, numRowBytes, bytesPerPixel);
+		}
+		const std::vector<byte> compressed = storeZlib(filtered.data(), filtered.size());
+
+		std::vector<byte> out = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+		std::vector<byte> header;
+		appendBigEndian32(header, image.width);
+		appendBigEndian32(header, image.height);
+		const byte fields[5] = { byte(image.bitDepth), byte(image.colorType), 0, 0, 0 };
+		header.insert(header.end(), fields, fields + 5);
+		appendChunk(out, "IHDR", header.data(), header.size());
+
+		if (!image.palette.empty()) {
+			appendChunk(out, "PLTE", image.palette.data(), image.palette.size());
+		}
+		if (!image.transparency.empty()) {
+			appendChunk(out, "tRNS", image.transparency.data(), image.transparency.size());
+		}
+		for (size_t offset = 0; offset < compressed.size(); offset += maxIdatSize) {
+			const size_t size = (compressed.size() - offset < maxIdatSize) ?
+				compressed.size() - offset : maxIdatSize;
+			appendChunk(out, "IDAT", &compressed[offset], size);
+		}
+		appendChunk(out, "IEND", nullptr, 0);
+		return out;
+	}
+};
@@ -0,0 +1,233 @@
+//
+// RingAllocatorTest.cpp
+//
+#include "Common/RingAllocator.hpp"
+
+#include <random>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+// Stands in for the GPU frame fence, completing values only when told to.
+class FakeFence {
+public:
+	FakeFence() : m_nextValue(1), m_completedValue(0) { }
+
+	/// Value tagging the work of the frame being recorded.
+	uint64 currentValue() const { return m_nextValue; }
+
+	/// Ends the frame being recorded.
+	void signal() { ++m_nextValue; }
+
+	/// Completes every value up to 'value', which must have been signaled.
+	void complete (
+		uint64 value
+	) {
+		CHECK(value < m_nextValue);
+		m_completedValue = value;
+	}
+
+	uint64 completedValue() const { return m_completedValue; }
+
+private:
+	uint64 m_nextValue;
+	uint64 m_completedValue;
+};
+
+struct Allocation {
+	size_t offset;
+	size_t size;
+	uint64 fenceValue;
+};
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static void testReclaimOnFenceAdvance()
+{
+	FakeFence fence;
+	RingAllocator ring(1024);
+
+	CHECK(ring.allocate(256, 1, fence.currentValue()) == 0);
+	CHECK(ring.allocate(256, 1, fence.currentValue()) == 256);
+	fence.signal();
+	CHECK(ring.allocate(256, 1, fence.currentValue()) == 512);
+	fence.signal();
+	CHECK(ring.usedBytes() == 768);
+	CHECK(ring.numPendingFences() == 2);
+
+	// Nothing is freed until the fence advances.
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.usedBytes() == 768);
+
+	fence.complete(1);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.usedBytes() == 256);
+	CHECK(ring.numPendingFences() == 1);
+
+	fence.complete(2);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.usedBytes() == 0);
+	CHECK(ring.numPendingFences() == 0);
+
+	// An empty ring starts over from the beginning.
+	CHECK(ring.allocate(16, 1, fence.currentValue()) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+static void testWrapAround()
+{
+	FakeFence fence;
+	RingAllocator ring(1024);
+
+	CHECK(ring.allocate(400, 1, fence.currentValue()) == 0);
+	fence.signal();
+	CHECK(ring.allocate(400, 1, fence.currentValue()) == 400);
+	fence.signal();
+
+	fence.complete(1);
+	ring.reclaim(fence.completedValue());
+
+	// Does not fit in the 224 bytes left at the end, so wraps to the freed front.
+	CHECK(ring.allocate(300, 1, fence.currentValue()) == 0);
+	CHECK(ring.usedBytes() == 400 + 224 + 300);
+
+	// Free space is now [300, 400), bounded by the frame still in flight.
+	CHECK(ring.allocate(64, 1, fence.currentValue()) == 300);
+	CHECK(ring.allocate(64, 1, fence.currentValue()) == RingAllocator::InvalidOffset);
+	fence.signal();
+
+	// The bytes skipped at the end belong to the frame that wrapped.
+	fence.complete(2);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.usedBytes() == 224 + 300 + 64);
+
+	fence.complete(3);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.usedBytes() == 0);
+}
+
+//---------------------------------------------------------------------------------------
+static void testFullRing()
+{
+	FakeFence fence;
+	RingAllocator ring(1024);
+
+	// Larger than the ring, never satisfiable.
+	CHECK(ring.allocate(1025, 1, fence.currentValue()) == RingAllocator::InvalidOffset);
+
+	for (uint i = 0; i < 4; ++i) {
+		CHECK(ring.allocate(256, 1, fence.currentValue()) == i * 256);
+		fence.signal();
+	}
+	CHECK(ring.usedBytes() == ring.capacity());
+	CHECK(ring.allocate(1, 1, fence.currentValue()) == RingAllocator::InvalidOffset);
+
+	// A full ring recovers once the oldest frame completes, and only that much.
+	fence.complete(1);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.allocate(256, 1, fence.currentValue()) == 0);
+	CHECK(ring.allocate(1, 1, fence.currentValue()) == RingAllocator::InvalidOffset);
+	fence.signal();
+
+	// Space freed at the front is too small for a request wrapping around.
+	fence.complete(2);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.allocate(512, 1, fence.currentValue()) == RingAllocator::InvalidOffset);
+	CHECK(ring.allocate(256, 1, fence.currentValue()) == 256);
+
+	ring.reset();
+	CHECK(ring.usedBytes() == 0);
+	CHECK(ring.numPendingFences() == 0);
+	CHECK(ring.allocate(1024, 1, fence.currentValue()) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+static void testAlignment()
+{
+	FakeFence fence;
+	RingAllocator ring(1024);
+
+	CHECK(ring.allocate(3, 1, fence.currentValue()) == 0);
+	CHECK(ring.allocate(16, 256, fence.currentValue()) == 256);
+
+	// Padding counts towards the bytes in use.
+	CHECK(ring.usedBytes() == 272);
+}
+
+//---------------------------------------------------------------------------------------
+// Streams randomly sized allocations through the ring with the GPU lagging a few
+// frames behind, checking that live allocations never overlap.
+static void testRandomFrames()
+{
+	const size_t capacity = 4096;
+	const uint64 maxFramesInFlight = 3;
+
+	FakeFence fence;
+	RingAllocator ring(capacity);
+	std::vector<Allocation> liveAllocations;
+	std::mt19937 random(1);
+
+	uint numFailed = 0;
+	for (uint i = 0; i < 100000; ++i) {
+		if (random() % 16 == 0) {
+			fence.signal();
+
+			const uint64 lastSignaled = fence.currentValue() - 1;
+			if (lastSignaled > maxFramesInFlight) {
+				fence.complete(lastSignaled - random() % maxFramesInFlight);
+			}
+			ring.reclaim(fence.completedValue());
+
+			std::vector<Allocation> stillLive;
+			for (const Allocation & allocation : liveAllocations) {
+				if (allocation.fenceValue > fence.completedValue()) {
+					stillLive.push_back(allocation);
+				}
+			}
+			liveAllocations.swap(stillLive);
+		}
+
+		const size_t size = 1 + random() % 512;
+		const size_t alignment = size_t(1) << (random() % 9);
+		const size_t offset = ring.allocate(size, alignment, fence.currentValue());
+		if (offset == RingAllocator::InvalidOffset) {
+			++numFailed;
+			continue;
+		}
+
+		CHECK(offset % alignment == 0);
+		CHECK(offset + size <= capacity);
+		for (const Allocation & allocation : liveAllocations) {
+			CHECK(offset + size <= allocation.offset ||
+				allocation.offset + allocation.size <= offset);
+		}
+		liveAllocations.push_back(Allocation{offset, size, fence.currentValue()});
+		CHECK(ring.usedBytes() <= capacity);
+	}
+
+	// The ring must have filled up, or the full-ring path went untested.
+	CHECK(numFailed > 0);
+
+	fence.signal();
+	fence.complete(fence.currentValue() - 1);
+	ring.reclaim(fence.completedValue());
+	CHECK(ring.usedBytes() == 0);
+	CHECK(ring.numPendingFences() == 0);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testReclaimOnFenceAdvance);
+	RUN_TEST(testWrapAround);
+	RUN_TEST(testFullRing);
+	RUN_TEST(testAlignment);
+	RUN_TEST(testRandomFrames);
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+//
+// TestUtils.hpp
+//
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+
+/// Fails the test, exiting with a non-zero status, unless 'condition' holds.  Unlike
+/// assert() it is never compiled out.
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+			std::exit(EXIT_FAILURE); \
+		} \
+	} while (false)
+
+/// Runs the test function 'test', printing its name.
+#define RUN_TEST(test) \
+	do { \
+		std::printf("%s\n", #test); \
+		test(); \
+	} while (false)
@@ -0,0 +1,195 @@
+//
+// TextureStartupBenchmark.cpp
+//
+// Times texture startup with and without baking, for the PNG and JPEG files given on
+// the command line, or else the textures in Assets/Textures:
+//
+// - decoding the image and generating its mip chain, as every startup did before
+//   textures were baked;
+// - baking it into a BC7 DDS file with TextureBaker, as the first startup does;
+// - mapping the baked file and copying every subresource into rows padded to the
+//   D3D12 pitch alignment, as TextureLoader::uploadTexture() does on later startups.
+//
+// Baked files are written to the working directory and removed afterwards.
+//
+#include "Common/TextureBaker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/DdsFile.hpp"
+#include "Common/ImageDecoder.hpp"
+#include "Common/JobSystem.hpp"
+#include "Common/MappedFile.hpp"
+#include "Common/MipGenerator.hpp"
+
+
+namespace {
+
+	// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+	const size_t PitchAlignment = 256;
+	const size_t PlacementAlignment = 512;
+}
+
+//---------------------------------------------------------------------------------------
+// Returns the fastest of 'numRuns' runs of 'run', in seconds.
+static double timeFastest (
+	uint numRuns,
+	const std::function<void()> & run
+) {
+	double fastest = 1.0e30;
+	for (uint i = 0; i < numRuns; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fastest = elapsed.count() < fastest ? elapsed.count() : fastest;
+	}
+	return fastest;
+}
+
+//---------------------------------------------------------------------------------------
+static inline size_t alignUp (
+	size_t value,
+	size_t alignment
+) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+//---------------------------------------------------------------------------------------
+// Decodes 'file' and filters its mip chain into 'uploadBuffer', each level placed and
+// padded as an upload buffer footprint.
+static void decodeWithMips (
+	const MappedFile & file,
+	ImageDecoder & decoder,
+	JobSystem & jobSystem,
+	std::vector<byte> & uploadBuffer
+) {
+	const ImageInfo info = ImageDecoder::readInfo(file.data(), file.size());
+	const uint numLevels = MipGenerator::numMipLevels(info.width, info.height);
+
+	std::vector<size_t> offsets(numLevels);
+	std::vector<ImageDestination> levels(numLevels);
+	size_t size = 0;
+	for (uint level = 0; level < numLevels; ++level) {
+		const size_t rowPitch = alignUp(size_t(MipGenerator::mipSize(info.width, level)) * 4, PitchAlignment);
+		offsets[level] = alignUp(size, PlacementAlignment);
+		levels[level].rowPitch = rowPitch;
+		levels[level].size = rowPitch * MipGenerator::mipSize(info.height, level);
+		size = offsets[level] + levels[level].size;
+	}
+	uploadBuffer.resize(size);
+	for (uint level = 0; level < numLevels; ++level) {
+		levels[level].data = uploadBuffer.data() + offsets[level];
+	}
+
+	decoder.decode(file.data(), file.size(), levels[0]);
+	const ImageView image = { levels[0].data, levels[0].rowPitch, info.width, info.height };
+	MipGenerator::generateMipChain(image, levels.data(), numLevels, true, &jobSystem);
+}
+
+//---------------------------------------------------------------------------------------
+// Maps the DDS file at 'path' and copies every subresource into 'uploadBuffer'.
+// @return bytes of subresource data.
+static size_t loadBaked (
+	const char * path,
+	std::vector<byte> & uploadBuffer
+) {
+	MappedDds dds;
+	if (!dds.open(path)) {
+		std::fprintf(stderr, "Unable to open %s\n", path);
+		std::exit(EXIT_FAILURE);
+	}
+
+	size_t size = 0;
+	for (uint i = 0; i < dds.numSubresources(); ++i) {
+		const DdsFile::Subresource & subresource =
+			dds.subresource(i % dds.description().numMipLevels, i / dds.description().numMipLevels);
+		size = alignUp(size, PlacementAlignment) +
+			alignUp(subresource.rowBytes, PitchAlignment) * subresource.numRows;
+	}
+	uploadBuffer.resize(size);
+
+	size_t offset = 0;
+	for (uint i = 0; i < dds.numSubresources(); ++i) {
+		const DdsFile::Subresource & subresource =
+			dds.subresource(i % dds.description().numMipLevels, i / dds.description().numMipLevels);
+		const size_t rowPitch = alignUp(subresource.rowBytes, PitchAlignment);
+		offset = alignUp(offset, PlacementAlignment);
+		for (uint row = 0; row < subresource.numRows; ++row) {
+			std::memcpy (
+				&uploadBuffer[offset + row * rowPitch],
+				subresource.data + row * subresource.rowPitch, subresource.rowBytes
+			);
+		}
+		offset += rowPitch * subresource.numRows;
+	}
+	return dds.dataSize();
+}
+
+//---------------------------------------------------------------------------------------
+int main (
+	int argc,
+	char ** argv
+) {
+	std::vector<std::string> paths(argv + 1, argv + argc);
+	if (paths.empty()) {
+		paths.push_back(std::string(TEXTURE_ASSETS_DIR) + "/uvgrid.jpg");
+		paths.push_back(std::string(TEXTURE_ASSETS_DIR) + "/low_poly_ship_albedo.png");
+	}
+
+	const uint numWorkerThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	JobSystem jobSystem(numWorkerThreads);
+	ImageDecoder decoder;
+	std::vector<byte> uploadBuffer;
+
+	std::printf("Texture startup, %u worker threads for mips and baking\n", numWorkerThreads);
+	double totalDecodeSeconds = 0.0;
+	double totalBakedSeconds = 0.0;
+	for (const std::string & path : paths) {
+		MappedFile file;
+		if (!file.open(path.c_str())) {
+			std::fprintf(stderr, "Unable to open %s\n", path.c_str());
+			std::exit(EXIT_FAILURE);
+		}
+
+		const size_t slash = path.find_last_of("/\\");
+		const std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+		const std::string bakedPath = name + ".baked.dds";
+
+		const double decodeSeconds = timeFastest(5, [&] {
+			decodeWithMips(file, decoder, jobSystem, uploadBuffer);
+		});
+
+		TextureBaker::Options options;
+		const DdsFile::BakeInfo bakeInfo = { 0, file.size(), 0, TextureBaker::hashOptions(options) };
+		const double bakeSeconds = timeFastest(1, [&] {
+			TextureBaker::bake(file.data(), file.size(), bakedPath.c_str(), options, bakeInfo, &jobSystem);
+		});
+
+		size_t numBakedBytes = 0;
+		const double bakedSeconds = timeFastest(10, [&] {
+			numBakedBytes = loadBaked(bakedPath.c_str(), uploadBuffer);
+		});
+		std::remove(bakedPath.c_str());
+
+		std::printf("  %s\n", name.c_str());
+		std::printf("    decode + mips %8.2f ms\n", decodeSeconds * 1000.0);
+		std::printf("    bake          %8.2f ms, once\n", bakeSeconds * 1000.0);
+		std::printf("    map + copy    %8.2f ms, %.1f MB at %.0f MB/s, %.1fx faster\n",
+			bakedSeconds * 1000.0, numBakedBytes * 1.0e-6, numBakedBytes * 1.0e-6 / bakedSeconds,
+			decodeSeconds / bakedSeconds);
+		totalDecodeSeconds += decodeSeconds;
+		totalBakedSeconds += bakedSeconds;
+	}
+
+	std::printf("Total: %.2f ms decoding, %.2f ms from baked files\n",
+		totalDecodeSeconds * 1000.0, totalBakedSeconds * 1000.0);
+	return 0;
+}
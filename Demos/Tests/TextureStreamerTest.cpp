@@ -0,0 +1,277 @@
+//
+// TextureStreamerTest.cpp
+//
+#include "Common/TextureStreamer.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+using DdsFile::DxgiFormat::BC1_UNORM;
+using DdsFile::DxgiFormat::BC7_UNORM_SRGB;
+using DdsFile::DxgiFormat::R8G8B8A8_UNORM;
+
+
+namespace {
+
+// Completes every change on the update after it begins, checking that each range
+// would make a valid resource.
+class RecordingBackend : public TextureStreamer::Backend {
+public:
+	explicit RecordingBackend (
+		const std::vector<DdsFile::Description> & descriptions
+	)
+		: m_descriptions(descriptions),
+		  m_pending(descriptions.size(), false),
+		  m_numChanges(0)
+	{
+
+	}
+
+	void beginChange (
+		TextureStreamer::TextureId texture,
+		uint firstMip
+	) override {
+		CHECK(!m_pending[texture]);
+		const DdsFile::Description & description = m_descriptions[texture];
+		CHECK(firstMip < description.numMipLevels);
+		if (firstMip > 0) {
+			CHECK((description.width >> firstMip) % 4 == 0);
+			CHECK((description.height >> firstMip) % 4 == 0);
+		}
+		m_pending[texture] = true;
+		++m_numChanges;
+	}
+
+	bool isChangeComplete (
+		TextureStreamer::TextureId texture
+	) override {
+		CHECK(m_pending[texture]);
+		return true;
+	}
+
+	void endChange (
+		TextureStreamer::TextureId texture
+	) override {
+		CHECK(m_pending[texture]);
+		m_pending[texture] = false;
+	}
+
+	uint numChanges() const { return m_numChanges; }
+
+private:
+	std::vector<DdsFile::Description> m_descriptions;
+	std::vector<bool> m_pending;
+	uint m_numChanges;
+};
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static DdsFile::Description describe (
+	uint width,
+	uint height,
+	uint32 dxgiFormat
+) {
+	uint numMipLevels = 1;
+	while ((width | height) >> numMipLevels) {
+		++numMipLevels;
+	}
+	return DdsFile::Description { width, height, 1, numMipLevels, dxgiFormat, false };
+}
+
+//---------------------------------------------------------------------------------------
+// Bytes of the levels each texture can sample, leaving out changes in flight.
+static uint64 sampledBytes (
+	const TextureStreamer & streamer,
+	const std::vector<TextureStreamer::TextureId> & ids,
+	const std::vector<DdsFile::Description> & descriptions
+) {
+	uint64 bytes = 0;
+	for (size_t i = 0; i < ids.size(); ++i) {
+		const uint residentMip = streamer.residentMip(ids[i]);
+		if (residentMip < descriptions[i].numMipLevels) {
+			bytes += streamer.residentBytes(ids[i], residentMip);
+		}
+	}
+	return bytes;
+}
+
+//---------------------------------------------------------------------------------------
+static void testRequiredMipLevel()
+{
+	CHECK(TextureStreamer::requiredMipLevel(2048, 2048, 4096.0f) == 0);
+	CHECK(TextureStreamer::requiredMipLevel(2048, 2048, 2048.0f) == 0);
+	CHECK(TextureStreamer::requiredMipLevel(2048, 2048, 1000.0f) == 1);
+	CHECK(TextureStreamer::requiredMipLevel(2048, 512, 64.0f) == 5);
+	CHECK(TextureStreamer::requiredMipLevel(2048, 2048, 1.0f) == UINT32_MAX);
+}
+
+//---------------------------------------------------------------------------------------
+// Block compressed tails start no coarser than the last level with sides that are
+// multiples of 4.
+static void testTailMip()
+{
+	TextureStreamer::Settings settings;
+	settings.mipTailSize = 128;
+	TextureStreamer streamer(settings, nullptr);
+
+	CHECK(streamer.tailMip(streamer.addTexture(describe(2048, 2048, BC7_UNORM_SRGB))) == 4);
+	CHECK(streamer.tailMip(streamer.addTexture(describe(2048, 2048, R8G8B8A8_UNORM))) == 4);
+
+	// 1024x16 fits at 128x2, but the last whole blocks are at 256x4.
+	CHECK(streamer.tailMip(streamer.addTexture(describe(1024, 16, R8G8B8A8_UNORM))) == 3);
+	CHECK(streamer.tailMip(streamer.addTexture(describe(1024, 16, BC1_UNORM))) == 2);
+
+	// 300x300 would fit at 75x75, but only level 0 is whole blocks, so it is all tail.
+	CHECK(streamer.tailMip(streamer.addTexture(describe(300, 300, R8G8B8A8_UNORM))) == 2);
+	CHECK(streamer.tailMip(streamer.addTexture(describe(300, 300, BC7_UNORM_SRGB))) == 0);
+	CHECK(streamer.tailMip(streamer.addTexture(describe(600, 1200, BC1_UNORM))) == 1);
+
+	// Smaller than the tail size, so fully resident from the start.
+	CHECK(streamer.tailMip(streamer.addTexture(describe(64, 64, BC1_UNORM))) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+// Simulated changes take simulatedLatency updates, then textures sharpen a level at a
+// time up to the level they request.
+static void testSimulatedPromotion()
+{
+	TextureStreamer::Settings settings;
+	settings.simulatedLatency = 3;
+	TextureStreamer streamer(settings, nullptr);
+
+	const DdsFile::Description description = describe(1024, 1024, BC7_UNORM_SRGB);
+	const TextureStreamer::TextureId id = streamer.addTexture(description);
+	CHECK(streamer.residentMip(id) == description.numMipLevels);
+
+	const uint tailMip = streamer.tailMip(id);
+	const uint64 tailBytes = streamer.residentBytes(id, tailMip);
+	streamer.update();
+	CHECK(streamer.statistics().numPendingChanges == 1);
+	CHECK(streamer.statistics().residentBytes == tailBytes);
+	streamer.update();
+	streamer.update();
+	CHECK(streamer.residentMip(id) == description.numMipLevels);
+	streamer.update();
+	CHECK(streamer.residentMip(id) == tailMip);
+	CHECK(streamer.statistics().numPendingChanges == 0);
+
+	streamer.requestMip(id, 0, 1.0f);
+	uint previousMip = tailMip;
+	for (uint i = 0; i < 100 && streamer.residentMip(id) > 0; ++i) {
+		streamer.requestMip(id, 0, 1.0f);
+		streamer.update();
+		CHECK(streamer.residentMip(id) + 1 >= previousMip);
+		previousMip = streamer.residentMip(id);
+	}
+	CHECK(streamer.residentMip(id) == 0);
+	CHECK(streamer.statistics().numPromotions == tailMip);
+	CHECK(streamer.statistics().numDemotions == 0);
+
+	// Needing fewer levels drops them straight away.
+	streamer.requestMip(id, 3, 1.0f);
+	for (uint i = 0; i < 4; ++i) {
+		streamer.update();
+	}
+	CHECK(streamer.residentMip(id) == 3);
+	CHECK(streamer.statistics().numDemotions == 1);
+	CHECK(streamer.statistics().residentBytes == streamer.residentBytes(id, 3));
+}
+
+//---------------------------------------------------------------------------------------
+// A camera moving among textures of mixed sizes and formats: the levels textures can
+// sample never exceed the resident budget, and every change begun is a valid resource.
+static void testResidentCap()
+{
+	TextureStreamer::Settings settings;
+	settings.residentBudget = 12ull << 20;
+	settings.uploadBudgetPerUpdate = 2ull << 20;
+	settings.simulatedLatency = 2;
+
+	const DdsFile::Description shapes[] = {
+		describe(2048, 2048, BC7_UNORM_SRGB),
+		describe(1024, 1024, BC1_UNORM),
+		describe(2048, 512, BC7_UNORM_SRGB),
+		describe(1024, 16, BC1_UNORM),
+		describe(1200, 600, BC1_UNORM),
+		describe(512, 512, R8G8B8A8_UNORM)
+	};
+	std::vector<DdsFile::Description> descriptions;
+	for (uint i = 0; i < 12; ++i) {
+		descriptions.push_back(shapes[i % (sizeof(shapes) / sizeof(shapes[0]))]);
+	}
+
+	for (bool isSimulated : { true, false }) {
+		std::printf("  %s\n", isSimulated ? "simulated" : "with backend");
+		RecordingBackend backend(descriptions);
+		TextureStreamer streamer(settings, isSimulated ? nullptr : &backend);
+
+		std::vector<TextureStreamer::TextureId> ids;
+		uint64 tailBytes = 0;
+		for (const DdsFile::Description & description : descriptions) {
+			ids.push_back(streamer.addTexture(description));
+			tailBytes += streamer.residentBytes(ids.back(), streamer.tailMip(ids.back()));
+		}
+		CHECK(tailBytes < settings.residentBudget);
+
+		std::mt19937 random(7);
+		std::vector<float> distances(ids.size());
+		uint64 peakSampledBytes = 0;
+		for (uint frame = 0; frame < 600; ++frame) {
+			// Jump to a new viewpoint every 60 frames, drifting in between.
+			for (float & distance : distances) {
+				if (frame % 60 == 0) {
+					distance = 1.0f + float(random() % 400) * 0.1f;
+				}
+				distance = std::max(distance + (float(random() % 21) - 10.0f) * 0.01f, 0.5f);
+			}
+
+			for (size_t i = 0; i < ids.size(); ++i) {
+				const float screenPixels = 4000.0f / distances[i];
+				streamer.requestMip (
+					ids[i],
+					TextureStreamer::requiredMipLevel(descriptions[i].width, descriptions[i].height, screenPixels),
+					screenPixels
+				);
+			}
+			streamer.update();
+
+			const uint64 bytes = sampledBytes(streamer, ids, descriptions);
+			CHECK(bytes <= settings.residentBudget);
+			CHECK(bytes <= streamer.statistics().residentBytes);
+			peakSampledBytes = std::max(peakSampledBytes, bytes);
+
+			for (size_t i = 0; i < ids.size(); ++i) {
+				const uint residentMip = streamer.residentMip(ids[i]);
+				if (frame > settings.simulatedLatency) {
+					CHECK(residentMip <= streamer.tailMip(ids[i]));
+				}
+			}
+		}
+
+		const TextureStreamer::Statistics & statistics = streamer.statistics();
+		std::printf("    peak %.2f of %.2f MB, %u promotions, %u demotions\n",
+			peakSampledBytes / 1048576.0, settings.residentBudget / 1048576.0,
+			statistics.numPromotions, statistics.numDemotions);
+
+		// The budget is both used and contended.
+		CHECK(peakSampledBytes > settings.residentBudget / 2);
+		CHECK(statistics.numPromotions > 0 && statistics.numDemotions > 0);
+		CHECK(isSimulated || backend.numChanges() > 0);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRequiredMipLevel);
+	RUN_TEST(testTailMip);
+	RUN_TEST(testSimulatedPromotion);
+	RUN_TEST(testResidentCap);
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+//
+// TimelinePoolTest.cpp
+//
+#include "Common/TimelinePool.hpp"
+
+#include <vector>
+
+#include "TestUtils.hpp"
+
+
+namespace {
+
+const uint DirectKind = 0;
+const uint CopyKind = 1;
+
+// Pool of item ids used as CommandListPool uses its pool, creating an id on a miss
+// and remembering where each was last released.
+struct IdPool {
+	TimelinePool<uint> pool;
+	std::vector<Timeline *> timelines;
+	std::vector<Timeline::Value> retireValues;
+	std::vector<uint> kinds;
+
+	IdPool()
+		: pool(2)
+	{
+	}
+
+	// Acquires an id of 'kind', checking a recycled one has retired.
+	uint acquire (
+		uint kind
+	) {
+		uint id = 0;
+		if (!pool.tryAcquire(kind, id)) {
+			id = uint(kinds.size());
+			timelines.push_back(nullptr);
+			retireValues.push_back(Timeline::Value(Timeline::NullValue));
+			kinds.push_back(kind);
+			return id;
+		}
+
+		// Asks the fence itself rather than the Timeline's cached value.
+		CHECK(id < kinds.size());
+		CHECK(kinds[id] == kind);
+		CHECK(timelines[id] != nullptr);
+		CHECK(timelines[id]->getFence()->queryCompletedValue() >= retireValues[id]);
+		timelines[id] = nullptr;
+		return id;
+	}
+
+	void release (
+		uint id,
+		Timeline & timeline,
+		Timeline::Value retireValue
+	) {
+		CHECK(timelines[id] == nullptr);
+		timelines[id] = &timeline;
+		retireValues[id] = retireValue;
+		pool.release(kinds[id], uint(id), timeline, retireValue);
+	}
+};
+
+} // end namespace
+
+//---------------------------------------------------------------------------------------
+// Items released at value N are not handed out at any step before the timeline
+// reaches N, and come back oldest first.
+static void testRetireValues()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline direct(gpu.createQueue(3), &gpu);
+	TimelinePool<uint> pool(1);
+
+	uint item = 0;
+	CHECK(!pool.tryAcquire(0, item));
+	CHECK(pool.statistics().numMisses == 1);
+
+	const Timeline::Value first = direct.signal();
+	pool.release(0, 10, direct, first);
+	const Timeline::Value second = direct.signal();
+	pool.release(0, 11, direct, second);
+	pool.release(0, 12, direct, second);
+	CHECK(pool.numReleased(0) == 3);
+
+	uint numAcquired = 0;
+	const uint expected[] = { 10, 11, 12 };
+	while (numAcquired < 3) {
+		const bool isAcquired = pool.tryAcquire(0, item);
+		const Timeline::Value nextValue = numAcquired == 0 ? first : second;
+		CHECK(isAcquired == (direct.getFence()->queryCompletedValue() >= nextValue));
+		if (isAcquired) {
+			CHECK(item == expected[numAcquired]);
+			++numAcquired;
+		}
+		else {
+			CHECK(gpu.step());
+		}
+	}
+	CHECK(gpu.numSteps() == 6);
+	CHECK(pool.numReleased(0) == 0);
+	CHECK(pool.statistics().numHits == 3);
+	CHECK(pool.statistics().numMisses == 1 + 6);
+}
+
+//---------------------------------------------------------------------------------------
+// A retired item of one timeline is handed out while an older one of a slower
+// timeline is still in flight, and kinds never mix.
+static void testTimelinesAndKinds()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline copy(gpu.createQueue(10), &gpu);
+	Timeline direct(gpu.createQueue(2), &gpu);
+	TimelinePool<uint> pool(2);
+
+	pool.release(DirectKind, 1, copy, copy.signal());
+	pool.release(DirectKind, 2, direct, direct.signal());
+	pool.release(CopyKind, 3, direct, direct.signal());
+
+	direct.waitOnCpu(direct.lastSignaledValue());
+	CHECK(!copy.isComplete(copy.lastSignaledValue()));
+
+	uint item = 0;
+	CHECK(pool.tryAcquire(DirectKind, item) && item == 2);
+	CHECK(!pool.tryAcquire(DirectKind, item));
+	CHECK(pool.tryAcquire(CopyKind, item) && item == 3);
+	CHECK(!pool.tryAcquire(CopyKind, item));
+
+	copy.waitOnCpu(copy.lastSignaledValue());
+	CHECK(!pool.tryAcquire(CopyKind, item));
+	CHECK(pool.tryAcquire(DirectKind, item) && item == 1);
+	CHECK(pool.numReleased(DirectKind) == 0 && pool.numReleased(CopyKind) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+// A frame loop with three frames in flight, recording two direct lists per frame and
+// uploading on a copy queue the direct queue waits on, stops creating items after
+// the first frames.  From then on every acquire is a hit.
+static void testSteadyState()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline direct(gpu.createQueue(3), &gpu);
+	Timeline copy(gpu.createQueue(4), &gpu);
+	IdPool ids;
+
+	const uint numListsPerFrame = 2;
+	const uint numWarmupFrames = 3;
+	const uint numFrames = 200;
+	Timeline::Value frameValues[3] = {};
+	uint64 numAcquires = 0;
+	for (uint frame = 0; frame < numFrames; ++frame) {
+		if (frame == numWarmupFrames) {
+			CHECK(ids.pool.statistics().numHits == 0);
+			CHECK(ids.pool.statistics().numMisses == numAcquires);
+		}
+
+		direct.waitOnCpu(frameValues[frame % 3]);
+
+		const uint upload = ids.acquire(CopyKind);
+		const Timeline::Value uploadValue = copy.signal();
+		ids.release(upload, copy, uploadValue);
+		copy.waitOnGpu(direct, uploadValue);
+
+		uint lists[numListsPerFrame];
+		for (uint i = 0; i < numListsPerFrame; ++i) {
+			lists[i] = ids.acquire(DirectKind);
+		}
+		frameValues[frame % 3] = direct.signal();
+		for (uint i = 0; i < numListsPerFrame; ++i) {
+			ids.release(lists[i], direct, frameValues[frame % 3]);
+		}
+		numAcquires += numListsPerFrame + 1;
+	}
+
+	// Only the warmup frames created items, one frame's worth for each in flight.
+	CHECK(ids.kinds.size() == numWarmupFrames * (numListsPerFrame + 1));
+	CHECK(ids.pool.statistics().numMisses == numWarmupFrames * (numListsPerFrame + 1));
+	CHECK(ids.pool.statistics().numHits == numAcquires - ids.pool.statistics().numMisses);
+	CHECK(ids.pool.numReleased(DirectKind) == 3 * numListsPerFrame);
+	CHECK(ids.pool.numReleased(CopyKind) == 3);
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRetireValues);
+	RUN_TEST(testTimelinesAndKinds);
+	RUN_TEST(testSteadyState);
+
+	return 0;
+}
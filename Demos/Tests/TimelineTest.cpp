@@ -0,0 +1,169 @@
+//
+// TimelineTest.cpp
+//
+#include "Common/Timeline.hpp"
+
+#include <stdexcept>
+
+#include "TestUtils.hpp"
+
+
+//---------------------------------------------------------------------------------------
+// Signals complete after their queue's steps, and completed values are cached.
+static void testSignals()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline timeline(gpu.createQueue(3), &gpu);
+
+	CHECK(timeline.lastSignaledValue() == Timeline::NullValue);
+	CHECK(timeline.nextSignaledValue() == 1);
+	CHECK(timeline.isComplete(Timeline::NullValue));
+	CHECK(timeline.statistics().numQueries == 0);
+	CHECK(timeline.statistics().numCachedQueries == 1);
+
+	const Timeline::Value first = timeline.signal();
+	const Timeline::Value second = timeline.signal();
+	CHECK(first == 1 && second == 2);
+	CHECK(timeline.lastSignaledValue() == 2);
+
+	CHECK(!timeline.isComplete(first));
+	CHECK(gpu.step() && gpu.step());
+	CHECK(!timeline.isComplete(first));
+	CHECK(gpu.step());
+	CHECK(timeline.isComplete(first));
+	CHECK(!timeline.isComplete(second));
+	CHECK(timeline.completedValue() == first);
+	CHECK(timeline.statistics().numQueries == 4);
+
+	// Answered from the cache, without querying the fence.
+	CHECK(timeline.isComplete(first));
+	CHECK(timeline.statistics().numQueries == 4);
+	CHECK(timeline.statistics().numCachedQueries == 2);
+
+	CHECK(gpu.step() && gpu.step() && gpu.step());
+	CHECK(timeline.completedValue() == first);
+	CHECK(timeline.refreshCompletedValue() == second);
+
+	// Idle queues make no progress.
+	CHECK(!gpu.step());
+	CHECK(gpu.numSteps() == 7);
+	CHECK(timeline.statistics().numCpuWaits == 0);
+}
+
+//---------------------------------------------------------------------------------------
+// A frame loop with three frames in flight only blocks once the queue falls behind,
+// and each wait steps the GPU just far enough.
+static void testFrameLoop()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline direct(gpu.createQueue(3), &gpu);
+
+	const uint numFrames = 30;
+	Timeline::Value frameValues[3] = {};
+	for (uint frame = 0; frame < numFrames; ++frame) {
+		direct.waitOnCpu(frameValues[frame % 3]);
+		CHECK(direct.lastSignaledValue() - direct.completedValue() < 3);
+		CHECK(gpu.numSteps() == (frame < 3 ? 0 : 3 * (frame - 2)));
+		frameValues[frame % 3] = direct.signal();
+	}
+	direct.waitOnCpu(direct.lastSignaledValue());
+
+	CHECK(direct.completedValue() == numFrames);
+	CHECK(gpu.numSteps() == 3 * numFrames);
+	CHECK(direct.statistics().numCpuWaits == numFrames - 2);
+
+	// Already complete, so neither blocks nor steps.
+	direct.waitOnCpu(numFrames);
+	CHECK(direct.statistics().numCpuWaits == numFrames - 2);
+	CHECK(gpu.numSteps() == 3 * numFrames);
+}
+
+//---------------------------------------------------------------------------------------
+static void testWaitForAny()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline copy(gpu.createQueue(10), &gpu);
+	Timeline compute(gpu.createQueue(5), &gpu);
+
+	Timeline * timelines[] = { &copy, &compute };
+	const Timeline::Value values[] = { copy.signal(), compute.signal() };
+	CHECK(Timeline::waitForAny(timelines, values, 2) == 1);
+	CHECK(gpu.numSteps() == 5);
+	CHECK(!copy.isComplete(values[0]));
+	CHECK(copy.statistics().numCpuWaits == 1);
+
+	// Answered from the cached value of compute, without stepping.
+	const uint64 numCachedQueries = compute.statistics().numCachedQueries;
+	CHECK(Timeline::waitForAny(timelines, values, 2) == 1);
+	CHECK(compute.statistics().numCachedQueries == numCachedQueries + 1);
+	CHECK(gpu.numSteps() == 5);
+
+	CHECK(Timeline::waitForAny(timelines, values, 1) == 0);
+	CHECK(gpu.numSteps() == 10);
+}
+
+//---------------------------------------------------------------------------------------
+// A queue waiting on another's timeline only runs its later work once the value
+// completes, and waits on completed values are skipped.
+static void testWaitOnGpu()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline copy(gpu.createQueue(10), &gpu);
+	Timeline compute(gpu.createQueue(2), &gpu);
+
+	const Timeline::Value upload = copy.signal();
+	copy.waitOnGpu(compute, upload);
+	const Timeline::Value dispatch = compute.signal();
+
+	// On its own compute would complete after 2 steps.
+	for (uint i = 0; i < 9; ++i) {
+		CHECK(gpu.step());
+	}
+	CHECK(!compute.isComplete(dispatch));
+
+	compute.waitOnCpu(dispatch);
+	CHECK(copy.isComplete(upload));
+	CHECK(gpu.numSteps() >= 11);
+
+	const uint64 numSteps = gpu.numSteps();
+	const uint64 numQueries = copy.statistics().numQueries;
+	copy.waitOnGpu(compute, upload);
+	compute.waitOnCpu(compute.signal());
+	CHECK(gpu.numSteps() == numSteps + 2);
+	CHECK(copy.statistics().numQueries == numQueries);
+}
+
+//---------------------------------------------------------------------------------------
+// Waiting on a value no queue will ever reach throws rather than hanging.
+static void testDeadlock()
+{
+	Timeline::SimulatedGpu gpu;
+	Timeline copy(gpu.createQueue(4), &gpu);
+	Timeline compute(gpu.createQueue(4), &gpu);
+
+	const Timeline::Value upload = copy.signal();
+	compute.getFence()->queueWait(copy.getFence(), upload + 1);
+	const Timeline::Value dispatch = compute.signal();
+
+	bool hasThrown = false;
+	try {
+		compute.waitOnCpu(dispatch);
+	} catch (const std::runtime_error &) {
+		hasThrown = true;
+	}
+	CHECK(hasThrown);
+	CHECK(copy.isComplete(upload));
+	CHECK(!compute.isComplete(dispatch));
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testSignals);
+	RUN_TEST(testFrameLoop);
+	RUN_TEST(testWaitForAny);
+	RUN_TEST(testWaitOnGpu);
+	RUN_TEST(testDeadlock);
+
+	return 0;
+}
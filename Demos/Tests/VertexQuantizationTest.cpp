@@ -0,0 +1,185 @@
+//
+// VertexQuantizationTest.cpp
+//
+#include "Common/VertexQuantization.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+using namespace VertexQuantization;
+
+
+namespace {
+
+// Largest angle between a unit normal and its octahedral encoded round trip.
+const double MaxNormalErrorDegrees = 0.05;
+
+// Relative error of rounding to a normal half float, half its 10-bit mantissa ulp.
+const double HalfRelativeError = 1.0 / 2048.0;
+
+} // end namespace
+
+
+//---------------------------------------------------------------------------------------
+static std::vector<Mesh::Vertex> createRandomVertices (
+	size_t numVertices
+) {
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	std::vector<Mesh::Vertex> vertices(numVertices);
+	for (Mesh::Vertex & vertex : vertices) {
+		for (int i = 0; i < 3; ++i) {
+			vertex.position[i] = distribution(random) * 10.0f + 5.0f;
+		}
+
+		float length;
+		do {
+			for (int i = 0; i < 3; ++i) {
+				vertex.normal[i] = distribution(random);
+			}
+			length = sqrtf(vertex.normal[0] * vertex.normal[0] +
+				vertex.normal[1] * vertex.normal[1] + vertex.normal[2] * vertex.normal[2]);
+		} while (length < 0.01f);
+		for (int i = 0; i < 3; ++i) {
+			vertex.normal[i] /= length;
+		}
+
+		vertex.texCoord[0] = distribution(random) * 4.0f;
+		vertex.texCoord[1] = distribution(random);
+	}
+
+	// Poles and edges of the octahedron, where folding is most delicate.
+	const float axes[][3] = {
+		{0, 0, 1}, {0, 0, -1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0},
+		{0.70710678f, 0, -0.70710678f}, {0, -0.70710678f, -0.70710678f}
+	};
+	for (size_t i = 0; i < sizeof(axes) / sizeof(axes[0]); ++i) {
+		memcpy(vertices[i].normal, axes[i], sizeof(axes[i]));
+	}
+
+	return vertices;
+}
+
+//---------------------------------------------------------------------------------------
+static void testRoundTripError()
+{
+	const std::vector<Mesh::Vertex> vertices = createRandomVertices(100003);
+	const PositionTransform transform =
+		computePositionTransform(vertices.data(), vertices.size());
+
+	std::vector<PackedVertex> packedVertices(vertices.size());
+	encodeVertices(vertices.data(), vertices.size(), transform, packedVertices.data());
+
+	double maxPositionError = 0.0;
+	double maxNormalError = 0.0;
+	double maxTexCoordError = 0.0;
+	for (size_t v = 0; v < vertices.size(); ++v) {
+		const Mesh::Vertex & vertex = vertices[v];
+		const Mesh::Vertex decoded = decodeVertex(packedVertices[v], transform);
+		CHECK(packedVertices[v].position[3] == 0xffff);
+
+		// Within half a quantization step of the extent, plus float rounding.
+		for (int i = 0; i < 3; ++i) {
+			const double step = transform.scale[i] / 65535.0;
+			const double error = fabs(double(decoded.position[i]) - vertex.position[i]) / step;
+			maxPositionError = fmax(maxPositionError, error);
+		}
+
+		const double cosAngle = double(decoded.normal[0]) * vertex.normal[0] +
+			double(decoded.normal[1]) * vertex.normal[1] +
+			double(decoded.normal[2]) * vertex.normal[2];
+		const double angle = acos(fmin(cosAngle, 1.0)) * 180.0 / 3.14159265358979;
+		maxNormalError = fmax(maxNormalError, angle);
+
+		for (int i = 0; i < 2; ++i) {
+			const double error = fabs(double(decoded.texCoord[i]) - vertex.texCoord[i]);
+			const double bound = fmax(fabs(vertex.texCoord[i]) * HalfRelativeError, ldexp(1.0, -25));
+			maxTexCoordError = fmax(maxTexCoordError, error / bound);
+		}
+	}
+
+	std::printf("  max error: position %.3f steps, normal %.4f degrees, texCoord %.3f of bound\n",
+		maxPositionError, maxNormalError, maxTexCoordError);
+	CHECK(maxPositionError <= 0.5 + 0.02);
+	CHECK(maxNormalError <= MaxNormalErrorDegrees);
+	CHECK(maxTexCoordError <= 1.0);
+}
+
+//---------------------------------------------------------------------------------------
+// Batches of four take the SIMD path where available, single vertices never do.
+static void testBatchMatchesSingleVertices()
+{
+	const std::vector<Mesh::Vertex> vertices = createRandomVertices(4099);
+	const PositionTransform transform =
+		computePositionTransform(vertices.data(), vertices.size());
+
+	std::vector<PackedVertex> batch(vertices.size());
+	encodeVertices(vertices.data(), vertices.size(), transform, batch.data());
+
+	std::vector<PackedVertex> single(vertices.size());
+	for (size_t v = 0; v < vertices.size(); ++v) {
+		encodeVertices(&vertices[v], 1, transform, &single[v]);
+	}
+
+	CHECK(memcmp(batch.data(), single.data(), batch.size() * sizeof(PackedVertex)) == 0);
+}
+
+//---------------------------------------------------------------------------------------
+static void testDegenerateBounds()
+{
+	// A flat mesh has zero extent along one axis, which must not produce NaNs.
+	Mesh::Vertex vertices[2] = {};
+	vertices[1].position[0] = 2.0f;
+	vertices[0].normal[2] = vertices[1].normal[2] = 1.0f;
+	const PositionTransform transform = computePositionTransform(vertices, 2);
+	CHECK(transform.scale[1] == 0.0f && transform.scale[2] == 0.0f);
+
+	PackedVertex packedVertices[2];
+	encodeVertices(vertices, 2, transform, packedVertices);
+	const Mesh::Vertex decoded = decodeVertex(packedVertices[1], transform);
+	CHECK(decoded.position[0] == 2.0f);
+	CHECK(decoded.position[1] == 0.0f && decoded.position[2] == 0.0f);
+}
+
+//---------------------------------------------------------------------------------------
+static void testHalfConversions()
+{
+	CHECK(floatToHalf(0.0f) == 0x0000);
+	CHECK(floatToHalf(-0.0f) == 0x8000);
+	CHECK(floatToHalf(1.0f) == 0x3c00);
+	CHECK(floatToHalf(-2.0f) == 0xc000);
+	CHECK(floatToHalf(65504.0f) == 0x7bff);
+	CHECK(floatToHalf(1.0e6f) == 0x7c00);
+	CHECK(floatToHalf(-INFINITY) == 0xfc00);
+	CHECK((floatToHalf(NAN) & 0x7c00) == 0x7c00 && (floatToHalf(NAN) & 0x03ff) != 0);
+
+	// Smallest subnormal, and halfway cases rounding to even.
+	CHECK(floatToHalf(ldexpf(1.0f, -24)) == 0x0001);
+	CHECK(floatToHalf(1.0f + ldexpf(1.0f, -11)) == 0x3c00);
+	CHECK(floatToHalf(1.0f + 3.0f * ldexpf(1.0f, -11)) == 0x3c02);
+
+	// Every half other than NaN survives a round trip through float.
+	for (uint32 bits = 0; bits < 0x10000; ++bits) {
+		const uint16 half = uint16(bits);
+		if ((half & 0x7c00) == 0x7c00 && (half & 0x03ff) != 0) {
+			continue;
+		}
+		CHECK(floatToHalf(halfToFloat(half)) == half);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRoundTripError);
+	RUN_TEST(testBatchMatchesSingleVertices);
+	RUN_TEST(testDegenerateBounds);
+	RUN_TEST(testHalfConversions);
+
+	return 0;
+}
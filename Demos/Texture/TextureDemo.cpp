@@ -5,9 +5,10 @@ using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
 #include <iostream>
+#include <stdexcept>
 using namespace std;
 
-#include "Common/ImageIO.hpp"
+#include "Common/TextureLoader.hpp"
 
 
 //---------------------------------------------------------------------------------------
@@ -38,9 +39,15 @@ void TextureDemo::InitializeDemo (
 
 	CreateDescriptorHeap();
 
-	UploadVertexDataToGpu(uploadCmdList);
+	// Record resource uploads on the copy queue, so they overlap with rendering
+	// rather than stalling initialization.
+	ID3D12GraphicsCommandList * copyCmdList = m_uploadQueue->getCommandList();
 
-	CreateTexture(uploadCmdList);
+	UploadVertexDataToGpu(copyCmdList);
+
+	CreateTexture(copyCmdList);
+
+	m_uploadTicket = m_uploadQueue->submit();
 
 	//-- Load shader byte code:
 	LoadCompiledShaderFromFile (GetAssetPath ("VertexShader.cso").c_str (), m_vertexShader);
@@ -87,7 +94,7 @@ void TextureDemo::CreateRootSignature()
 	// We don't use another descriptor heap for the sampler, instead we use a
 	// static sampler
 	CD3DX12_STATIC_SAMPLER_DESC samplers[1];
-	samplers[0].Init (0, D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT);
+	samplers[0].Init (0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
 
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
 	rootSignatureDesc.Init (_countof(rootParameters), rootParameters, 1, samplers,
@@ -129,8 +136,13 @@ void TextureDemo::CreateDescriptorHeap()
 //---------------------------------------------------------------------------------------
 void TextureDemo::CreateConstantBuffers()
 {
+	m_sceneConstData.resize(m_numBufferedFrames);
+	m_constantBuffer_sceneConstant.resize(m_numBufferedFrames);
+	m_pointLightConstData.resize(m_numBufferedFrames);
+	m_constantBuffer_pointLight.resize(m_numBufferedFrames);
+
 	//-- Create SceneConstant constant buffers within upload heap:
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
+	for (uint i(0); i < m_numBufferedFrames; ++i) {
 		const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
 		const auto constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (sizeof(SceneConstants));
 
@@ -146,7 +158,7 @@ void TextureDemo::CreateConstantBuffers()
 	}
 
 	//-- Create PointLight constant buffers within upload heap:
-	for (int i(0); i < NUM_BUFFERED_FRAMES; ++i) {
+	for (uint i(0); i < m_numBufferedFrames; ++i) {
 		const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
 		const auto constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (
 			sizeof (DirectionalLight)
@@ -170,8 +182,9 @@ void TextureDemo::CreateConstantBuffers()
 void TextureDemo::UploadVertexDataToGpu (
 	ID3D12GraphicsCommandList * uploadCmdList
 ) {
-	// Create upload buffer for uploading vertex/index data to default heap.
-    static ComPtr<ID3D12Resource> uploadBuffer_vertexData;
+	// Create upload buffer for uploading vertex/index data to default heap.  Kept
+	// alive by m_uploadQueue until the copies complete.
+	ComPtr<ID3D12Resource> uploadBuffer_vertexData;
 
 	const float inv_aspectRatio = static_cast<float>(m_windowHeight) / m_windowWidth;
 
@@ -210,12 +223,15 @@ void TextureDemo::UploadVertexDataToGpu (
 	{
 		const auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_DEFAULT);
 
+		// Buffers start in the COMMON state so they can be implicitly promoted to
+		// COPY_DEST on the copy queue, and later to their read states on the direct
+		// queue.
 		const auto vertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (sizeof(vertexArray));
 		m_device->CreateCommittedResource (
 			&defaultHeapProperties,
 			D3D12_HEAP_FLAG_NONE,
 			&vertexBufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_COMMON,
 			nullptr,
 			IID_PPV_ARGS (&m_vertexBuffer)
 		);
@@ -226,7 +242,7 @@ void TextureDemo::UploadVertexDataToGpu (
 			&defaultHeapProperties,
 			D3D12_HEAP_FLAG_NONE,
 			&indexBufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_COMMON,
 			nullptr,
 			IID_PPV_ARGS (&m_indexBuffer)
 		);
@@ -283,26 +299,10 @@ void TextureDemo::UploadVertexDataToGpu (
 		);
 	}
 
+	m_uploadQueue->keepAlive(uploadBuffer_vertexData.Get());
 
-	// Batch resource barriers marking state transitions.
-	{
-		const CD3DX12_RESOURCE_BARRIER barriers[2] = {
-
-			CD3DX12_RESOURCE_BARRIER::Transition (
-				m_vertexBuffer.Get(),
-				D3D12_RESOURCE_STATE_COPY_DEST,
-				D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
-			),
-
-			CD3DX12_RESOURCE_BARRIER::Transition (
-				m_indexBuffer.Get(),
-				D3D12_RESOURCE_STATE_COPY_DEST,
-				D3D12_RESOURCE_STATE_INDEX_BUFFER
-			)
-		};
-
-		uploadCmdList->ResourceBarrier(2, barriers);
-	}
+	// No resource barriers needed.  Buffers decay back to the COMMON state once the
+	// copy queue finishes, and are promoted again when first read by the direct queue.
 }
 
 //---------------------------------------------------------------------------------------
@@ -385,71 +385,38 @@ void TextureDemo::CreatePipelineState(
 void TextureDemo::CreateTexture (
 	ID3D12GraphicsCommandList * uploadCmdList
 ) {
-	ImageDecoder::decodeImage(GetAssetPath("Textures\\uvgrid.jpg"), 1, &m_imageData);
-
-	const auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_DEFAULT);
-	const auto textureResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D (
-		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, m_imageData.width, m_imageData.height, 1, 1
+	// The image is baked to BC1 with its mip chain on first run, after which loading
+	// only maps the baked file.  BC1 stores a 4x4 block in 8 bytes, an eighth of the
+	// RGBA size.
+	const std::string texturePath = GetAssetPath("Textures\\uvgrid.jpg");
+	TextureBaker::Options bakeOptions;
+	bakeOptions.compression = TextureBaker::Compression::BC1;
+
+	MappedDds texture;
+	TextureLoader::loadCachedTexture (
+		texturePath.c_str(), texture, bakeOptions, m_jobSystem.get()
 	);
 
-	// Create a texture resource within Default Heap that will hold the image data.
-	// The texture resource's state will begin as a Copy Destination.
-	CHECK_D3D_RESULT (
-		m_device->CreateCommittedResource (
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&textureResourceDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&m_imageTexture2d)
-		)
+	// The texture resource's state will begin as COMMON, which the copy queue
+	// implicitly promotes to a Copy Destination.
+	TextureLoader::createTexture (
+		m_device, texture, D3D12_RESOURCE_STATE_COMMON, m_imageTexture2d
 	);
 
-	const auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES (D3D12_HEAP_TYPE_UPLOAD);
-	const auto uploadBufferSize = ::GetRequiredIntermediateSize (m_imageTexture2d.Get(), 0, 1);
-	const auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer (uploadBufferSize);
-
-	// Create upload buffer for uploading image data to texture resource on GPU.
-	CHECK_D3D_RESULT (
-		m_device->CreateCommittedResource (
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&uploadBufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_uploadBuffer)
-		)
+	// Schedule a copy of each level on GPU using upload command list to transfer data
+	// to texture resource in the default heap.
+	TextureLoader::uploadTexture (
+		m_device, uploadCmdList, texture, m_imageTexture2d.Get(), m_uploadBuffer
 	);
 
-	const int bytesPerPixel(4);
-
-	D3D12_SUBRESOURCE_DATA sourceData;
-	sourceData.pData = m_imageData.data;
-	sourceData.RowPitch = m_imageData.width * bytesPerPixel;
-	sourceData.SlicePitch = m_imageData.width * m_imageData.height * bytesPerPixel;
-
-	// Transfer source image data to upload buffer using CPU, then schedule a copy
-	// on GPU using upload command list to transfer data to texture resource in the
-	// default heap.
-	::UpdateSubresources<1> (
-		uploadCmdList, m_imageTexture2d.Get(), 
-		m_uploadBuffer.Get(), 0, 0, 1, &sourceData
-	);
-
-	// Issue resource barrier to transition image texture from copy state to 
-	// pixel shader resource.
-	const auto resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition (
-		m_imageTexture2d.Get(),
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-	);
-	uploadCmdList->ResourceBarrier(1, &resourceBarrier);
+	// Copy queues cannot transition to PIXEL_SHADER_RESOURCE.  Instead the texture
+	// decays to COMMON after the copy, and is implicitly promoted when first sampled.
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc = {};
 	shaderResourceViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	shaderResourceViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	shaderResourceViewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-	shaderResourceViewDesc.Texture2D.MipLevels = 1;
+	shaderResourceViewDesc.Format = DXGI_FORMAT(texture.description().dxgiFormat);
+	shaderResourceViewDesc.Texture2D.MipLevels = texture.description().numMipLevels;
 	shaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
 	shaderResourceViewDesc.Texture2D.ResourceMinLODClamp = 0.0f;
 
@@ -552,6 +519,10 @@ void TextureDemo::Update()
 void TextureDemo::Render (
 	ID3D12GraphicsCommandList * drawCmdList
 ) {
+	// Have the GPU wait for the vertex, index and texture uploads, which only
+	// stalls the first frames rendered before they complete.
+	RequireUploadCompletion(m_uploadTicket);
+
 	// Set the descriptor heap containing the texture srv
 	ID3D12DescriptorHeap* heaps[] = {m_srvDescriptorHeap.Get ()};
 	drawCmdList->SetDescriptorHeaps (1, heaps);
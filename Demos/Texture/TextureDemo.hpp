@@ -5,7 +5,6 @@
 #include <DirectXMath.h>
 
 #include "Common/D3D12DemoBase.hpp"
-#include "Common/ImageDecoder.hpp"
 #include "Common/ShaderUtils.hpp"
 
 #include "ConstantBufferDefines.hpp"
@@ -45,7 +44,6 @@ private:
 	};
 	typedef ushort Index;
 
-	ImageData m_imageData;
 	ComPtr<ID3D12Resource> m_imageTexture2d;
 	ComPtr<ID3D12Resource> m_uploadBuffer;
 
@@ -53,10 +51,10 @@ private:
 
 
 	// Constant Buffer specific
-	SceneConstants m_sceneConstData[NUM_BUFFERED_FRAMES];
-	ComPtr<ID3D12Resource> m_constantBuffer_sceneConstant[NUM_BUFFERED_FRAMES];
-	DirectionalLight m_pointLightConstData[NUM_BUFFERED_FRAMES];
-	ComPtr<ID3D12Resource> m_constantBuffer_pointLight[NUM_BUFFERED_FRAMES];
+	std::vector<SceneConstants> m_sceneConstData;
+	std::vector<ComPtr<ID3D12Resource>> m_constantBuffer_sceneConstant;
+	std::vector<DirectionalLight> m_pointLightConstData;
+	std::vector<ComPtr<ID3D12Resource>> m_constantBuffer_pointLight;
 	DirectX::XMMATRIX m_rotationMatrix;
 
 	// Pipeline objects.
@@ -69,6 +67,9 @@ private:
 	ComPtr<ID3D12Resource> m_vertexBuffer;
 	ComPtr<ID3D12Resource> m_indexBuffer;
 
+	// Completion ticket for resources uploaded on the copy queue.
+	UploadQueue::Ticket m_uploadTicket;
+
 	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
 	D3D12_INDEX_BUFFER_VIEW m_indexBufferView;
     uint m_indexCount;